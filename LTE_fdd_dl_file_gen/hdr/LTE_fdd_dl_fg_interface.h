@@ -59,15 +59,15 @@ public:
     void start_ctrl_port();
     void stop_ctrl_port();
     void send_ctrl_msg(std::string msg);
-    void handle_ctrl_msg(const std::string msg, const int32 sock_fd);
+    void handle_ctrl_msg(std::string_view msg, const int32 sock_fd);
     void handle_ctrl_connect(const int32 sock_fd);
     void handle_ctrl_disconnect(const int32 sock_fd);
     void handle_ctrl_error(const LIBTOOLS_SERVER_SOCKET_ERROR_ENUM err);
     bool get_shutdown();
 
 private:
-    void handle_read(std::string msg);
-    void handle_write(std::string msg);
+    void handle_read(std::string_view msg);
+    void handle_write(std::string_view msg);
     std::string bandwidth_to_string();
     void write_bandwidth(std::string bw);
     void write_mcc(std::string mcc_value);
@@ -243,8 +243,8 @@ void LTE_fdd_dl_fg_interface::send_ctrl_msg(std::string msg)
     ctrl_socket->send(msg + "\n", ctrl_sock_fd);
 }
 
-void LTE_fdd_dl_fg_interface::handle_ctrl_msg(const std::string msg,
-                                              const int32       sock_fd)
+void LTE_fdd_dl_fg_interface::handle_ctrl_msg(std::string_view msg,
+                                              const int32      sock_fd)
 {
     if(0 == msg.find("shutdown"))
     {
@@ -289,11 +289,11 @@ void LTE_fdd_dl_fg_interface::handle_ctrl_error(const LIBTOOLS_SERVER_SOCKET_ERR
     assert(0);
 }
 
-void LTE_fdd_dl_fg_interface::handle_read(std::string msg)
+void LTE_fdd_dl_fg_interface::handle_read(std::string_view msg)
 {
     if(0 != msg.find("read "))
         return send_ctrl_msg("fail invalid read command");
-    std::string param = msg.substr(5);
+    std::string_view param = msg.substr(5);
     if(0 == param.find(file_name_token))
         return send_ctrl_msg("ok " + file_name);
     if(0 == param.find(output_type_token))
@@ -351,11 +351,11 @@ void LTE_fdd_dl_fg_interface::handle_read(std::string msg)
     send_ctrl_msg("fail invalid read parameter");
 }
 
-void LTE_fdd_dl_fg_interface::handle_write(std::string msg)
+void LTE_fdd_dl_fg_interface::handle_write(std::string_view msg)
 {
     if(0 != msg.find("write "))
         return send_ctrl_msg("fail invalid write command");
-    std::string param = msg.substr(6);
+    std::string param(msg.substr(6));
     int64 value;
     if(0 == param.find(file_name_token + " "))
     {
@@ -89,7 +89,7 @@ public:
     void send_channel_not_found_msg();
     void open_pcap_fd();
     void send_pcap_msg(uint32 rnti, uint32 current_tti, LIBLTE_BIT_MSG_STRUCT &msg);
-    void handle_ctrl_msg(const std::string msg, const int32 sock_fd);
+    void handle_ctrl_msg(std::string_view msg, const int32 sock_fd);
     void handle_ctrl_connect(const int32 sock_fd);
     void handle_ctrl_disconnect(const int32 sock_fd);
     void handle_ctrl_error(const LIBTOOLS_SERVER_SOCKET_ERROR_ENUM err);
@@ -97,8 +97,8 @@ public:
     int32 switch_to_next_freq();
 
 private:
-    void handle_read(std::string msg);
-    void handle_write(std::string msg);
+    void handle_read(std::string_view msg);
+    void handle_write(std::string_view msg);
     void write_band(std::string band_str);
     void read_dl_earfcn_list();
     void write_dl_earfcn_list(std::string dl_earfcn_list_str);
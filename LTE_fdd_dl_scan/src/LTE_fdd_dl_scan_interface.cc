@@ -341,8 +341,8 @@ void LTE_fdd_dl_scan_interface::send_pcap_msg(uint32                 rnti,
     fwrite(pcap_msg,      sizeof(uint8),  idx, pcap_fd);
 }
 
-void LTE_fdd_dl_scan_interface::handle_ctrl_msg(const std::string msg,
-                                                const int32       sock_fd)
+void LTE_fdd_dl_scan_interface::handle_ctrl_msg(std::string_view msg,
+                                                const int32      sock_fd)
 {
     if(0 == msg.find("shutdown"))
     {
@@ -387,11 +387,11 @@ void LTE_fdd_dl_scan_interface::handle_ctrl_error(const LIBTOOLS_SERVER_SOCKET_E
     assert(0);
 }
 
-void LTE_fdd_dl_scan_interface::handle_read(std::string msg)
+void LTE_fdd_dl_scan_interface::handle_read(std::string_view msg)
 {
     if(0 != msg.find("read "))
         return send_ctrl_msg("fail invalid read command");
-    std::string param = msg.substr(5);
+    std::string_view param = msg.substr(5);
     if(0 == param.find(band_token))
         return send_ctrl_msg("ok " + (std::string)liblte_interface_band_text[band]);
     if(0 == param.find(dl_earfcn_list_token))
@@ -403,11 +403,11 @@ void LTE_fdd_dl_scan_interface::handle_read(std::string msg)
     send_ctrl_msg("fail invalid read parameter");
 }
 
-void LTE_fdd_dl_scan_interface::handle_write(std::string msg)
+void LTE_fdd_dl_scan_interface::handle_write(std::string_view msg)
 {
     if(0 != msg.find("write "))
         return send_ctrl_msg("fail invalid write command");
-    std::string param = msg.substr(6);
+    std::string param(msg.substr(6));
     if(0 == param.find(band_token + " "))
         return write_band(param.substr(band_token.length()+1));
     if(0 == param.find(dl_earfcn_list_token + " "))
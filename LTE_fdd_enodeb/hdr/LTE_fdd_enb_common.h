@@ -75,6 +75,7 @@ typedef enum{
     LTE_FDD_ENB_ERROR_DUPLICATE_ENTRY,
     LTE_FDD_ENB_ERROR_READ_ONLY,
     LTE_FDD_ENB_ERROR_HARQ_INFO_NOT_FOUND,
+    LTE_FDD_ENB_ERROR_NO_FREE_HARQ_PROCESS,
     LTE_FDD_ENB_ERROR_N_ITEMS,
 }LTE_FDD_ENB_ERROR_ENUM;
 static const char LTE_fdd_enb_error_text[LTE_FDD_ENB_ERROR_N_ITEMS][100] = {"none",
@@ -100,7 +101,8 @@ static const char LTE_fdd_enb_error_text[LTE_FDD_ENB_ERROR_N_ITEMS][100] = {"non
                                                                             "cant reassemble SDU",
                                                                             "duplicate entry",
                                                                             "read only",
-                                                                            "HARQ info not found"};
+                                                                            "HARQ info not found",
+                                                                            "no free HARQ process"};
 
 /*******************************************************************************
                               CLASS DECLARATIONS
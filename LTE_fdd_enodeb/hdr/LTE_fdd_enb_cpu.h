@@ -0,0 +1,132 @@
+/*******************************************************************************
+
+    Copyright 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************
+
+    File: LTE_fdd_enb_cpu.h
+
+    Description: Contains all the definitions for the LTE FDD eNodeB
+                 CPU placement.  Each thread role has a core set and a
+                 scheduler policy, large buffers are allocated from huge
+                 pages on the NUMA node of their role's cores.
+
+    Revision History
+    ----------    -------------    --------------------------------------------
+    10/18/2026    agent            Created file.
+
+*******************************************************************************/
+
+#ifndef __LTE_FDD_ENB_CPU_H__
+#define __LTE_FDD_ENB_CPU_H__
+
+/*******************************************************************************
+                              INCLUDES
+*******************************************************************************/
+
+#include "LTE_fdd_enb_common.h"
+#include "typedefs.h"
+#include <sched.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*******************************************************************************
+                              DEFINES
+*******************************************************************************/
+
+// Passed to place_thread to use every core of the role's set
+#define LTE_FDD_ENB_CPU_ALL_CORES 0xFFFFFFFF
+
+#define LTE_FDD_ENB_CPU_HUGE_PAGE_SIZE (2*1024*1024)
+
+/*******************************************************************************
+                              FORWARD DECLARATIONS
+*******************************************************************************/
+
+
+/*******************************************************************************
+                              TYPEDEFS
+*******************************************************************************/
+
+typedef enum{
+    LTE_FDD_ENB_THREAD_ROLE_RADIO = 0,
+    LTE_FDD_ENB_THREAD_ROLE_MAC,
+    LTE_FDD_ENB_THREAD_ROLE_MSGQ,
+    LTE_FDD_ENB_THREAD_ROLE_GW,
+    LTE_FDD_ENB_THREAD_ROLE_N_ITEMS,
+}LTE_FDD_ENB_THREAD_ROLE_ENUM;
+static const char LTE_fdd_enb_thread_role_text[LTE_FDD_ENB_THREAD_ROLE_N_ITEMS][20] = {"radio",
+                                                                                       "mac",
+                                                                                       "msgq",
+                                                                                       "gw"};
+
+typedef enum{
+    LTE_FDD_ENB_THREAD_POLICY_OTHER = 0,
+    LTE_FDD_ENB_THREAD_POLICY_FIFO,
+    LTE_FDD_ENB_THREAD_POLICY_RR,
+    LTE_FDD_ENB_THREAD_POLICY_N_ITEMS,
+}LTE_FDD_ENB_THREAD_POLICY_ENUM;
+static const char LTE_fdd_enb_thread_policy_text[LTE_FDD_ENB_THREAD_POLICY_N_ITEMS][20] = {"other",
+                                                                                           "fifo",
+                                                                                           "rr"};
+
+// An empty core set leaves the affinity alone
+typedef struct{
+    cpu_set_t                      cores;
+    LTE_FDD_ENB_THREAD_POLICY_ENUM policy;
+    uint32                         prio;
+}LTE_FDD_ENB_THREAD_CNFG_STRUCT;
+
+/*******************************************************************************
+                              CLASS DECLARATIONS
+*******************************************************************************/
+
+class LTE_fdd_enb_cpu
+{
+public:
+    LTE_fdd_enb_cpu();
+    ~LTE_fdd_enb_cpu();
+
+    // Topology
+    std::string get_topology_string();
+
+    // Threads
+    std::string get_thread_cnfg_string(LTE_FDD_ENB_THREAD_ROLE_ENUM role);
+    LTE_FDD_ENB_ERROR_ENUM set_thread_cnfg(LTE_FDD_ENB_THREAD_ROLE_ENUM role, std::string cnfg);
+    void place_thread(LTE_FDD_ENB_THREAD_ROLE_ENUM role, uint32 idx);
+
+    // Memory
+    void* alloc_buf(LTE_FDD_ENB_THREAD_ROLE_ENUM role, size_t size, bool hugetlb);
+    void free_buf(void *buf, size_t size);
+    void place_buf(LTE_FDD_ENB_THREAD_ROLE_ENUM role, void *buf, size_t size);
+
+private:
+    // Topology
+    int32 get_node(LTE_FDD_ENB_THREAD_ROLE_ENUM role);
+    void bind_to_node(void *buf, size_t size, int32 node, bool move);
+    std::string cores_to_string(const cpu_set_t *cores);
+    bool string_to_cores(std::string str, cpu_set_t *cores);
+    std::vector<int32> cpu_node;
+    uint32             N_cpus;
+    uint32             N_nodes;
+
+    // Threads
+    std::mutex                     cnfg_mutex;
+    LTE_FDD_ENB_THREAD_CNFG_STRUCT thread_cnfg[LTE_FDD_ENB_THREAD_ROLE_N_ITEMS];
+};
+
+#endif /* __LTE_FDD_ENB_CPU_H__ */
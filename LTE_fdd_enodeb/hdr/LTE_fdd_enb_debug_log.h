@@ -0,0 +1,177 @@
+/*******************************************************************************
+
+    Copyright 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************
+
+    File: LTE_fdd_enb_debug_log.h
+
+    Description: Contains all the definitions for the LTE FDD eNodeB
+                 debug log.  Callers write binary records into a per
+                 thread lock-free ring, a background thread formats
+                 and sends them.
+
+    Revision History
+    ----------    -------------    --------------------------------------------
+    10/18/2026    agent            Created file.
+
+*******************************************************************************/
+
+#ifndef __LTE_FDD_ENB_DEBUG_LOG_H__
+#define __LTE_FDD_ENB_DEBUG_LOG_H__
+
+/*******************************************************************************
+                              INCLUDES
+*******************************************************************************/
+
+#include "LTE_fdd_enb_ring.h"
+#include "typedefs.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <string>
+#include <time.h>
+
+/*******************************************************************************
+                              DEFINES
+*******************************************************************************/
+
+// Per thread ring size in bytes, must be a power of 2 and hold the
+// largest record, records that don't fit are dropped
+#define LTE_FDD_ENB_DEBUG_LOG_RING_SIZE (256*1024)
+
+#define LTE_FDD_ENB_DEBUG_LOG_MAX_N_ARGS 32
+
+// Background thread poll period when all rings are empty
+#define LTE_FDD_ENB_DEBUG_LOG_IDLE_SLEEP_US 1000
+
+/*******************************************************************************
+                              FORWARD DECLARATIONS
+*******************************************************************************/
+
+class LTE_fdd_enb_interface;
+
+/*******************************************************************************
+                              TYPEDEFS
+*******************************************************************************/
+
+typedef enum{
+    LTE_FDD_ENB_DEBUG_LOG_ARG_INT = 0,
+    LTE_FDD_ENB_DEBUG_LOG_ARG_UINT,
+    LTE_FDD_ENB_DEBUG_LOG_ARG_DOUBLE,
+    LTE_FDD_ENB_DEBUG_LOG_ARG_STRING,
+    LTE_FDD_ENB_DEBUG_LOG_ARG_POINTER,
+}LTE_FDD_ENB_DEBUG_LOG_ARG_ENUM;
+
+typedef enum{
+    LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_NONE = 0,
+    LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_BITS,
+    LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_BYTES,
+    LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_SIZE,
+}LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_ENUM;
+
+// Message attached to a record, BITS is one bit per byte and is
+// printed as hex, BYTES is printed as size and hex, SIZE only as size
+typedef struct{
+    LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_ENUM  type;
+    const uint8                        *data;
+    uint32                              len;
+}LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_STRUCT;
+
+// Raw argument, strings are copied into the record after the
+// argument list
+typedef struct{
+    union{
+        int64       i;
+        uint64      u;
+        double      d;
+        const char *s;
+        const void *p;
+    };
+    uint32 len;
+    uint8  type;
+}LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT;
+
+typedef struct{
+    const char      *fmt;
+    const char      *file_name;
+    struct timespec  ts;
+    int32            line;
+    uint32           payload_len;
+    uint8            type;
+    uint8            level;
+    uint8            payload_type;
+    uint8            N_args;
+}LTE_FDD_ENB_DEBUG_LOG_RECORD_STRUCT;
+
+typedef LTE_fdd_enb_ring<LTE_FDD_ENB_DEBUG_LOG_RING_SIZE> LTE_fdd_enb_debug_log_ring;
+
+/*******************************************************************************
+                              CLASS DECLARATIONS
+*******************************************************************************/
+
+class LTE_fdd_enb_debug_log
+{
+public:
+    LTE_fdd_enb_debug_log(LTE_fdd_enb_interface *iface);
+    ~LTE_fdd_enb_debug_log();
+
+    // Logging
+    template<typename... Args>
+    void write(uint8 type, uint8 level, const char *file_name, int32 line, LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_STRUCT payload, const char *fmt, Args... args)
+    {
+        static_assert(sizeof...(Args) <= LTE_FDD_ENB_DEBUG_LOG_MAX_N_ARGS, "Too many debug log arguments");
+        LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT arg[sizeof...(Args) + 1] = {make_arg(args)...};
+        write_record(type, level, file_name, line, &payload, fmt, arg, sizeof...(Args));
+    }
+    void write_record(uint8 type, uint8 level, const char *file_name, int32 line, LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_STRUCT *payload, const char *fmt, LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT *arg, uint32 N_args);
+
+    // Arguments
+    static LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT make_arg(int64 arg) {LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT a; a.i = arg; a.type = LTE_FDD_ENB_DEBUG_LOG_ARG_INT; return a;}
+    static LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT make_arg(uint64 arg) {LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT a; a.u = arg; a.type = LTE_FDD_ENB_DEBUG_LOG_ARG_UINT; return a;}
+    static LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT make_arg(long arg) {return make_arg((int64)arg);}
+    static LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT make_arg(unsigned long arg) {return make_arg((uint64)arg);}
+    static LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT make_arg(int32 arg) {return make_arg((int64)arg);}
+    static LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT make_arg(uint32 arg) {return make_arg((uint64)arg);}
+    static LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT make_arg(int16 arg) {return make_arg((int64)arg);}
+    static LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT make_arg(uint16 arg) {return make_arg((uint64)arg);}
+    static LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT make_arg(int8 arg) {return make_arg((int64)arg);}
+    static LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT make_arg(signed char arg) {return make_arg((int64)arg);}
+    static LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT make_arg(uint8 arg) {return make_arg((uint64)arg);}
+    static LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT make_arg(bool arg) {return make_arg((uint64)arg);}
+    static LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT make_arg(double arg) {LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT a; a.d = arg; a.type = LTE_FDD_ENB_DEBUG_LOG_ARG_DOUBLE; return a;}
+    static LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT make_arg(const char *arg) {LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT a; a.s = arg; a.type = LTE_FDD_ENB_DEBUG_LOG_ARG_STRING; return a;}
+    static LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT make_arg(const void *arg) {LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT a; a.p = arg; a.type = LTE_FDD_ENB_DEBUG_LOG_ARG_POINTER; return a;}
+
+    // Formatting
+    static void format_record(LTE_FDD_ENB_DEBUG_LOG_RECORD_STRUCT *rec, std::string &line);
+
+private:
+    // Rings
+    LTE_fdd_enb_debug_log_ring* get_thread_ring();
+    std::mutex                                ring_mutex;
+    std::vector<LTE_fdd_enb_debug_log_ring *> rings;
+
+    // Background Thread
+    static void log_thread(LTE_fdd_enb_debug_log *log);
+    bool drain();
+    LTE_fdd_enb_interface *interface;
+    std::thread           *thread;
+    std::atomic<bool>      thread_run;
+};
+
+#endif /* __LTE_FDD_ENB_DEBUG_LOG_H__ */
@@ -48,16 +48,31 @@
                               DEFINES
 *******************************************************************************/
 
+// TUN queues, each read by its own thread
+#define LTE_FDD_ENB_GW_N_TUN_QUEUES 2
+
+// Packets read per wakeup of a TUN queue thread
+#define LTE_FDD_ENB_GW_RX_BATCH 32
+
+// Bounds how long stop waits for the TUN queue threads
+#define LTE_FDD_ENB_GW_RX_POLL_TIMEOUT_MS 100
 
 /*******************************************************************************
                               FORWARD DECLARATIONS
 *******************************************************************************/
 
+class LTE_fdd_enb_gw;
 
 /*******************************************************************************
                               TYPEDEFS
 *******************************************************************************/
 
+typedef struct{
+    LTE_fdd_enb_gw *gw;
+    pthread_t       rx_thread;
+    int32           fd;
+    uint32          idx;
+}LTE_FDD_ENB_GW_TUN_QUEUE_STRUCT;
 
 /*******************************************************************************
                               CLASS DECLARATIONS
@@ -92,10 +107,12 @@ private:
 
     // GW Receive
     static void* receive_thread(void *inputs);
-    pthread_t rx_thread;
+    void handle_ip_pkt_batch(LIBLTE_BYTE_MSG_STRUCT *pkt, uint32 N_pkts);
 
     // TUN device
-    int32 tun_fd;
+    void close_tun_queues();
+    LTE_FDD_ENB_GW_TUN_QUEUE_STRUCT tun_queue[LTE_FDD_ENB_GW_N_TUN_QUEUES];
+    uint32                          N_tun_queues;
 };
 
 #endif /* __LTE_FDD_ENB_GW_H__ */
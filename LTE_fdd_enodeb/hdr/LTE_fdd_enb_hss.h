@@ -45,8 +45,12 @@
 
 #include "LTE_fdd_enb_interface.h"
 #include "LTE_fdd_enb_user.h"
-#include <list>
+#include "liblte_security.h"
+#include <deque>
 #include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <unordered_map>
 
 /*******************************************************************************
                               DEFINES
@@ -57,6 +61,18 @@
 #define LTE_FDD_ENB_IND_HE_MAX_VALUE 31
 #define LTE_FDD_ENB_SEQ_HE_MAX_VALUE 0x7FFFFFFFFFFFUL
 
+// Authentication tuples generated ahead of attach
+#define LTE_FDD_ENB_HSS_AV_BATCH_SIZE        4
+#define LTE_FDD_ENB_HSS_AV_REFILL_THRESHOLD  1
+
+// User journal
+#define LTE_FDD_ENB_HSS_JOURNAL_FILE         "/tmp/LTE_fdd_enodeb.user_journal"
+#define LTE_FDD_ENB_HSS_LEGACY_USER_FILE     "/tmp/LTE_fdd_enodeb.user_db"
+#define LTE_FDD_ENB_HSS_JOURNAL_MAGIC        "LTEHSSJ1"
+#define LTE_FDD_ENB_HSS_JOURNAL_MAGIC_SIZE   8
+#define LTE_FDD_ENB_HSS_JOURNAL_RECORD_SIZE  33
+#define LTE_FDD_ENB_HSS_JOURNAL_MIN_COMPACT  1024
+
 /*******************************************************************************
                               FORWARD DECLARATIONS
 *******************************************************************************/
@@ -66,10 +82,27 @@
                               TYPEDEFS
 *******************************************************************************/
 
+typedef enum{
+    LTE_FDD_ENB_HSS_JOURNAL_OP_ADD = 0,
+    LTE_FDD_ENB_HSS_JOURNAL_OP_DEL,
+}LTE_FDD_ENB_HSS_JOURNAL_OP_ENUM;
+
 typedef struct{
-    uint8 k[16];
+    LIBLTE_SECURITY_MILENAGE_KEY_STRUCT milenage_key;
+    uint8                               k[16];
 }LTE_FDD_ENB_STORED_DATA_STRUCT;
 
+typedef struct{
+    uint64 sqn_he;
+    uint8  rand[16];
+    uint8  res[8];
+    uint8  ck[16];
+    uint8  ik[16];
+    uint8  ak[6];
+    uint8  mac[8];
+    uint8  autn[16];
+}LTE_FDD_ENB_AUTH_TUPLE_STRUCT;
+
 typedef struct{
     LTE_FDD_ENB_AUTHENTICATION_VECTOR_STRUCT auth_vec;
     uint64                                   sqn_he;
@@ -77,9 +110,6 @@ typedef struct{
     uint8                                    ak[6];
     uint8                                    mac[8];
     uint8                                    k_asme[32];
-    uint8                                    k_enb[32];
-    uint8                                    k_up_enc[32];
-    uint8                                    k_up_int[32];
     uint8                                    ind_he;
 }LTE_FDD_ENB_GENERATED_DATA_STRUCT;
 
@@ -87,6 +117,10 @@ typedef struct{
     LTE_FDD_ENB_USER_ID_STRUCT        id;
     LTE_FDD_ENB_STORED_DATA_STRUCT    stored_data;
     LTE_FDD_ENB_GENERATED_DATA_STRUCT generated_data;
+    LTE_FDD_ENB_AUTH_TUPLE_STRUCT     av_batch[LTE_FDD_ENB_HSS_AV_BATCH_SIZE];
+    uint32                            N_av_batch;
+    uint32                            av_epoch;
+    bool                              av_refill_pending;
 }LTE_FDD_ENB_HSS_USER_STRUCT;
 
 /*******************************************************************************
@@ -96,12 +130,13 @@ typedef struct{
 class LTE_fdd_enb_hss
 {
 public:
-    LTE_fdd_enb_hss();
+    LTE_fdd_enb_hss(std::string _journal_name=LTE_FDD_ENB_HSS_JOURNAL_FILE);
     ~LTE_fdd_enb_hss();
 
     // External interface
     LTE_FDD_ENB_ERROR_ENUM add_user(std::string imsi, std::string imei, std::string k);
     LTE_FDD_ENB_ERROR_ENUM del_user(std::string imsi);
+    LTE_FDD_ENB_ERROR_ENUM import_users(std::string file_name, uint32 *N_users);
     std::string print_all_users();
     bool is_imsi_allowed(uint64 imsi);
     bool is_imei_allowed(uint64 imei);
@@ -117,14 +152,37 @@ public:
     void read_user_file(LTE_fdd_enb_interface *interface);
 
 private:
-    // Allowed users
-    std::mutex                               user_mutex;
-    std::list<LTE_FDD_ENB_HSS_USER_STRUCT *> user_list;
+    // Allowed users, user_mutex also orders the journal writes
+    std::mutex                                                       user_mutex;
+    std::unordered_map<uint64, LTE_FDD_ENB_HSS_USER_STRUCT *>        imsi_map;
+    std::unordered_multimap<uint64, LTE_FDD_ENB_HSS_USER_STRUCT *>   imei_map;
+    uint32                                                           next_av_epoch;
+    LTE_FDD_ENB_HSS_USER_STRUCT* new_user(uint64 imsi, uint64 imei, uint8 *k);
+    LTE_FDD_ENB_ERROR_ENUM insert_user(LTE_FDD_ENB_HSS_USER_STRUCT *user);
+    LTE_FDD_ENB_HSS_USER_STRUCT* find_user(LTE_FDD_ENB_USER_ID_STRUCT *id);
+    void erase_user(LTE_FDD_ENB_HSS_USER_STRUCT *user);
+
+    // Authentication Tuples
+    static void av_thread(LTE_fdd_enb_hss *hss);
+    static void generate_auth_tuple(LIBLTE_SECURITY_MILENAGE_KEY_STRUCT *key, uint64 *seq_he, uint8 *ind_he, LTE_FDD_ENB_AUTH_TUPLE_STRUCT *tuple);
+    void queue_av_refill(LTE_FDD_ENB_HSS_USER_STRUCT *user);
+    void refill_auth_tuples(uint64 imsi);
+    std::mutex                av_mutex;
+    std::condition_variable   av_cv;
+    std::deque<uint64>        av_refill_queue;
+    std::thread              *av_gen_thread;
+    bool                      av_thread_run;
 
     // User File
-    void write_user_file();
+    void write_journal_records(uint8 *records, uint32 N_records);
+    void pack_journal_record(LTE_FDD_ENB_HSS_JOURNAL_OP_ENUM op, LTE_FDD_ENB_HSS_USER_STRUCT *user, uint8 *record);
+    bool replay_journal();
+    void compact_journal();
     void delete_user_file();
-    bool use_user_file;
+    std::string  journal_name;
+    FILE        *journal_file;
+    uint32       N_journal_records;
+    bool         use_user_file;
 };
 
 #endif /* __LTE_FDD_ENB_HSS_H__ */
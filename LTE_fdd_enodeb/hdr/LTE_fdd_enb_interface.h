@@ -64,10 +64,16 @@
 
 #include "LTE_fdd_enb_common.h"
 #include "LTE_fdd_enb_msgq.h"
+#include "LTE_fdd_enb_debug_log.h"
+#include "LTE_fdd_enb_pcap.h"
+#include "LTE_fdd_enb_cpu.h"
+#include "LTE_fdd_enb_metrics.h"
 #include "liblte_common.h"
+#include "liblte_mac.h"
 #include "libtools_server_socket.h"
 #include <string>
 #include <mutex>
+#include <atomic>
 
 /*******************************************************************************
                               DEFINES
@@ -76,6 +82,21 @@
 #define LTE_FDD_ENB_CTRL_PORT     30000
 #define LTE_FDD_ENB_MAX_LINE_SIZE 512
 
+// Users the UL H-ARQ soft buffer pool is sized for
+#define LTE_FDD_ENB_DEFAULT_MAX_USERS 16
+#define LTE_FDD_ENB_MAX_MAX_USERS     256
+
+// Pending output a debug client may have before lines are dropped
+#define LTE_FDD_ENB_DEBUG_HIGH_WATER_MARK (4*1024*1024)
+
+// Debug types and levels that are compiled in, one bit per enum value
+#ifndef LTE_FDD_ENB_DEBUG_TYPE_COMPILE_MASK
+#define LTE_FDD_ENB_DEBUG_TYPE_COMPILE_MASK 0xFFFFFFFF
+#endif
+#ifndef LTE_FDD_ENB_DEBUG_LEVEL_COMPILE_MASK
+#define LTE_FDD_ENB_DEBUG_LEVEL_COMPILE_MASK 0xFFFFFFFF
+#endif
+
 /*******************************************************************************
                               FORWARD DECLARATIONS
 *******************************************************************************/
@@ -174,24 +195,65 @@ public:
     void stop_ports();
     void send_ctrl_msg(std::string msg);
     void send_ctrl_info_msg(std::string msg, ...);
-    void send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ENUM type, LTE_FDD_ENB_DEBUG_LEVEL_ENUM level, std::string file_name, int32 line, std::string msg, ...);
-    void send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ENUM type, LTE_FDD_ENB_DEBUG_LEVEL_ENUM level, std::string file_name, int32 line, LIBLTE_BIT_MSG_STRUCT *lte_msg, std::string msg, ...);
-    void send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ENUM type, LTE_FDD_ENB_DEBUG_LEVEL_ENUM level, std::string file_name, int32 line, std::vector<bool> &lte_msg, std::string msg, ...);
-    void send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ENUM type, LTE_FDD_ENB_DEBUG_LEVEL_ENUM level, std::string file_name, int32 line, LIBLTE_BYTE_MSG_STRUCT *lte_msg, std::string msg, ...);
-    void send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ENUM type, LTE_FDD_ENB_DEBUG_LEVEL_ENUM level, std::string file_name, int32 line, const std::vector<uint8_t> &lte_msg, std::string msg, ...);
-    void open_lte_pcap_fd();
-    void open_ip_pcap_fd();
+    bool debug_enabled(LTE_FDD_ENB_DEBUG_TYPE_ENUM type, LTE_FDD_ENB_DEBUG_LEVEL_ENUM level)
+    {
+        return(((LTE_FDD_ENB_DEBUG_TYPE_COMPILE_MASK >> type) & (LTE_FDD_ENB_DEBUG_LEVEL_COMPILE_MASK >> level) & 1) &&
+               (debug_enabled_mask.load(std::memory_order_relaxed) & (1ULL << (type*LTE_FDD_ENB_DEBUG_LEVEL_N_ITEMS + level))));
+    }
+    template<typename... Args>
+    void send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ENUM type, LTE_FDD_ENB_DEBUG_LEVEL_ENUM level, const char *file_name, int32 line, const char *msg, Args... args)
+    {
+        if(!debug_enabled(type, level))
+            return;
+        debug_log->write(type, level, file_name, line, {LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_NONE, NULL, 0}, msg, args...);
+    }
+    template<typename... Args>
+    void send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ENUM type, LTE_FDD_ENB_DEBUG_LEVEL_ENUM level, const char *file_name, int32 line, LIBLTE_BIT_MSG_STRUCT *lte_msg, const char *msg, Args... args)
+    {
+        if(!debug_enabled(type, level))
+            return;
+        debug_log->write(type, level, file_name, line, {LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_BITS, lte_msg->msg, lte_msg->N_bits}, msg, args...);
+    }
+    template<typename... Args>
+    void send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ENUM type, LTE_FDD_ENB_DEBUG_LEVEL_ENUM level, const char *file_name, int32 line, std::vector<bool> &lte_msg, const char *msg, Args... args)
+    {
+        if(!debug_enabled(type, level))
+            return;
+        std::vector<uint8> bits(lte_msg.begin(), lte_msg.end());
+        debug_log->write(type, level, file_name, line, {LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_BITS, bits.data(), (uint32)bits.size()}, msg, args...);
+    }
+    template<typename... Args>
+    void send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ENUM type, LTE_FDD_ENB_DEBUG_LEVEL_ENUM level, const char *file_name, int32 line, LIBLTE_BYTE_MSG_STRUCT *lte_msg, const char *msg, Args... args)
+    {
+        if(!debug_enabled(type, level))
+            return;
+        debug_log->write(type, level, file_name, line, {LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_BYTES, lte_msg->msg, lte_msg->N_bytes}, msg, args...);
+    }
+    template<typename... Args>
+    void send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ENUM type, LTE_FDD_ENB_DEBUG_LEVEL_ENUM level, const char *file_name, int32 line, const std::vector<uint8_t> &lte_msg, const char *msg, Args... args)
+    {
+        if(!debug_enabled(type, level))
+            return;
+        debug_log->write(type, level, file_name, line, {LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_SIZE, NULL, (uint32)lte_msg.size()}, msg, args...);
+    }
+    void send_debug_log(const std::string &msg);
     void send_lte_pcap_msg(LTE_FDD_ENB_PCAP_DIRECTION_ENUM dir, uint32 rnti, uint32 current_tti, uint8 *msg, uint32 N_bits);
     void send_ip_pcap_msg(uint8 *msg, uint32 N_bytes);
-    void handle_ctrl_msg(const std::string msg, const int32 sock_fd);
+    void handle_ctrl_msg(std::string_view msg, const int32 sock_fd);
     void handle_ctrl_connect(const int32 sock_fd);
     void handle_ctrl_disconnect(const int32 sock_fd);
     void handle_ctrl_error(const LIBTOOLS_SERVER_SOCKET_ERROR_ENUM err);
-    void handle_debug_msg(const std::string msg, const int32 sock_fd);
+    void handle_debug_msg(std::string_view msg, const int32 sock_fd);
     void handle_debug_connect(const int32 sock_fd);
     void handle_debug_disconnect(const int32 sock_fd);
     void handle_debug_error(const LIBTOOLS_SERVER_SOCKET_ERROR_ENUM err);
 
+    // CPU placement
+    LTE_fdd_enb_cpu* get_cpu();
+
+    // Metrics
+    LTE_fdd_enb_metrics* get_metrics();
+
     // Handlers
     MasterInformationBlock::dl_Bandwidth_Enum get_bandwidth();
     uint32 get_band();
@@ -204,6 +266,7 @@ public:
     uint32 get_n_sc_rb_dl();
     uint32 get_n_sc_rb_ul();
     uint8 get_n_ant();
+    uint32 get_max_users();
     uint16 get_n_id_cell();
     uint8 get_n_id_1();
     uint8 get_n_id_2();
@@ -228,13 +291,15 @@ public:
     bool get_phy_direct_to_ue();
     uint32 get_debug_type();
     uint32 get_debug_level();
+    LIBLTE_MAC_DL_SCHED_POLICY_ENUM get_dl_scheduler();
+    LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_ENUM get_dl_ra_type();
     bool get_enable_pcap();
     uint32 get_ip_addr_start();
     uint32 get_dns_addr();
     bool get_use_cnfg_file();
     bool get_use_user_file();
     int set_use_user_file(std::string _use_user_file);
-    void handle_add_user(std::string msg);
+    void handle_add_user(std::string_view msg);
     void read_cnfg_file();
     bool get_shutdown();
     bool app_is_started();
@@ -250,23 +315,32 @@ private:
     void stop_debug_port();
     std::mutex              ctrl_mutex;
     std::mutex              debug_mutex;
-    FILE                   *lte_pcap_fd;
-    FILE                   *ip_pcap_fd;
+    LTE_fdd_enb_pcap       *lte_pcap;
+    LTE_fdd_enb_pcap       *ip_pcap;
     libtools_server_socket *ctrl_socket;
     libtools_server_socket *debug_socket;
     int32                   ctrl_sock_fd;
-    int32                   debug_sock_fd;
     bool                    ctrl_connected;
-    bool                    debug_connected;
+    uint32                  N_debug_clients;
+    LTE_fdd_enb_debug_log  *debug_log;
+    std::atomic<uint64>     debug_enabled_mask;
+    void update_debug_enabled_mask();
+
+    // CPU placement
+    LTE_fdd_enb_cpu *cpu;
+
+    // Metrics
+    LTE_fdd_enb_metrics *metrics;
 
     // Handlers
-    void handle_read(std::string msg);
-    void handle_write(std::string msg);
+    void handle_read(std::string_view msg);
+    void handle_write(std::string_view msg);
     std::string get_bandwidth_string();
     int set_bandwidth(std::string bandwidth);
     int set_band(std::string band);
     int set_dl_earfcn(std::string _dl_earfcn);
     int set_n_ant(std::string _N_ant);
+    int set_max_users(std::string _max_users);
     int set_n_id_cell(std::string _N_id_cell);
     std::string get_mcc_string();
     int set_mcc(std::string mcc);
@@ -303,8 +377,14 @@ private:
     int set_debug_type(std::string _debug_type);
     std::string get_debug_level_string();
     int set_debug_level(std::string _debug_level);
+    std::string get_dl_scheduler_string();
+    int set_dl_scheduler(std::string _dl_scheduler);
+    std::string get_dl_ra_type_string();
+    int set_dl_ra_type(std::string _dl_ra_type);
     std::string get_enable_pcap_string();
     int set_enable_pcap(std::string _enable_pcap);
+    std::string get_enable_metrics_string();
+    int set_enable_metrics(std::string _enable_metrics);
     std::string get_ip_addr_start_string();
     int set_ip_addr_start(std::string _ip_addr_start);
     std::string get_dns_addr_string();
@@ -317,9 +397,11 @@ private:
     void handle_start();
     void handle_stop();
     void handle_help();
-    void handle_delete_user(std::string msg);
+    void handle_delete_user(std::string_view msg);
+    void handle_import_users(std::string_view msg);
     void handle_print_users();
     void handle_print_registered_users();
+    void handle_print_metrics();
     void write_cnfg_file();
     void delete_cnfg_file();
 
@@ -332,6 +414,8 @@ private:
     const std::string            delete_user_token;
     const std::string            print_users_token;
     const std::string            print_registered_users_token;
+    const std::string            import_users_token;
+    const std::string            print_metrics_token;
     const std::string            read_token;
     const std::string            write_token;
     const std::string            help_token;
@@ -339,6 +423,7 @@ private:
     const std::string            band_token;
     const std::string            dl_earfcn_token;
     const std::string            n_ant_token;
+    const std::string            max_users_token;
     const std::string            n_id_cell_token;
     const std::string            mcc_token;
     const std::string            mnc_token;
@@ -360,7 +445,10 @@ private:
     const std::string            phy_direct_to_ue_token;
     const std::string            debug_type_token;
     const std::string            debug_level_token;
+    const std::string            dl_scheduler_token;
+    const std::string            dl_ra_type_token;
     const std::string            enable_pcap_token;
+    const std::string            enable_metrics_token;
     const std::string            ip_addr_start_token;
     const std::string            dns_addr_token;
     const std::string            use_cnfg_file_token;
@@ -371,9 +459,19 @@ private:
     const std::string            clock_source_token;
     const std::string            tx_gain_token;
     const std::string            rx_gain_token;
+    const std::string            sim_ul_file_token;
+    const std::string            sim_dl_file_token;
+    const std::string            sim_pace_token;
+    const std::string            sim_loopback_token;
+    const std::string            radio_thread_token;
+    const std::string            mac_thread_token;
+    const std::string            msgq_thread_token;
+    const std::string            gw_thread_token;
+    const std::string            cpu_topology_token;
     const std::string            imsi_token;
     const std::string            imei_token;
     const std::string            k_token;
+    const std::string            file_token;
     LTE_fdd_enb_timer_mgr       *timer_mgr;
     LTE_fdd_enb_user_mgr        *user_mgr;
     LTE_fdd_enb_hss             *hss;
@@ -387,6 +485,8 @@ private:
     LTE_fdd_enb_radio           *radio;
     LTE_FDD_ENB_SYS_INFO_STRUCT  sys_info;
     std::mutex                   start_mutex;
+    LIBLTE_MAC_DL_SCHED_POLICY_ENUM          dl_scheduler;
+    LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_ENUM dl_ra_type;
     uint32                       N_rb_dl;
     uint32                       N_rb_ul;
     uint32                       dl_center_freq;
@@ -397,6 +497,7 @@ private:
     uint32                       debug_level;
     uint32                       ip_addr_start;
     uint32                       dns_addr;
+    uint32                       max_users;
     uint16                       N_id_cell;
     uint16                       dl_earfcn;
     uint16                       ul_earfcn;
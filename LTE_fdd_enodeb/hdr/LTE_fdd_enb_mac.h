@@ -64,6 +64,17 @@
 
 #define LTE_FDD_ENB_MAX_HARQ_RETX 5
 
+// UL H-ARQ transmissions, must match maxHARQ-Tx and maxHARQ-Msg3Tx
+#define LTE_FDD_ENB_MAX_UL_HARQ_TX 4
+
+// Pending DL H-ARQ retransmissions
+#define LTE_FDD_ENB_MAC_DL_HARQ_RETX_QUEUE_SIZE 64
+
+// Timing advance commands keep the UE time alignment timer
+// (sf10240) running
+#define LTE_FDD_ENB_MAC_TA_COMMAND_PERIOD    5120
+#define LTE_FDD_ENB_MAC_TA_COMMAND_NO_CHANGE 31
+
 /*******************************************************************************
                               FORWARD DECLARATIONS
 *******************************************************************************/
@@ -82,14 +93,14 @@ typedef struct{
 
 typedef struct{
     LIBLTE_PHY_ALLOCATION_STRUCT alloc;
-    LIBLTE_MAC_PDU_STRUCT        mac_pdu;
     uint32                       current_tti;
 }LTE_FDD_ENB_DL_SCHED_QUEUE_STRUCT;
 
 typedef struct{
-    LIBLTE_PHY_ALLOCATION_STRUCT alloc;
-    uint32                       current_tti;
-}LTE_FDD_ENB_UL_SCHED_QUEUE_STRUCT;
+    uint32 current_tti;
+    uint16 rnti;
+    uint8  harq_process;
+}LTE_FDD_ENB_DL_HARQ_RETX_STRUCT;
 
 typedef struct{
     uint32 i_sr;
@@ -97,6 +108,12 @@ typedef struct{
     uint16 rnti;
 }LTE_FDD_ENB_UL_SR_SCHED_QUEUE_STRUCT;
 
+typedef struct{
+    LTE_fdd_enb_user *user;
+    uint32            N_bytes;
+    uint32            N_min_bytes;
+}LTE_FDD_ENB_DL_SCHED_CANDIDATE_STRUCT;
+
 typedef struct{
     LIBLTE_PHY_ALLOCATION_STRUCT alloc;
     uint32                       next_tti;
@@ -171,26 +188,34 @@ private:
     void construct_random_access_response(uint8 preamble, uint16 timing_adv, uint32 current_tti);
 
     // Scheduler
-    void sched_ul(LTE_fdd_enb_user *user, uint32 requested_tbs);
+    void sched_ul(LTE_fdd_enb_user *user);
     void persistent_dl(LTE_FDD_ENB_PERSISTENT_DL_STRUCT *persistent_dl);
     void handle_persistent_dl_timer_expiry(uint32 timer_id);
     void rar_scheduler();
     void dl_scheduler();
+    void dl_harq_scheduler();
+    void dl_mux_scheduler();
     void ul_scheduler();
     void ul_sr_scheduler();
     LTE_FDD_ENB_ERROR_ENUM add_to_rar_sched_queue(uint32 current_tti, LIBLTE_PHY_ALLOCATION_STRUCT *dl_alloc, LIBLTE_PHY_ALLOCATION_STRUCT *ul_alloc, LIBLTE_MAC_RAR_STRUCT *rar);
-    LTE_FDD_ENB_ERROR_ENUM add_to_dl_sched_queue(uint32 current_tti, LIBLTE_MAC_PDU_STRUCT *mac_pdu, LIBLTE_PHY_ALLOCATION_STRUCT *alloc);
-    LTE_FDD_ENB_ERROR_ENUM add_to_ul_sched_queue(uint32 current_tti, LIBLTE_PHY_ALLOCATION_STRUCT *alloc);
+    LTE_FDD_ENB_ERROR_ENUM add_to_dl_sched_queue(uint32 current_tti, LIBLTE_PHY_ALLOCATION_STRUCT *alloc);
+    LTE_FDD_ENB_ERROR_ENUM add_to_dl_harq_retx_queue(uint32 current_tti, uint16 rnti, uint8 harq_process);
     std::mutex                                       rar_sched_queue_mutex;
     std::mutex                                       dl_sched_queue_mutex;
+    std::mutex                                       dl_harq_retx_queue_mutex;
     std::mutex                                       persistent_dl_queue_mutex;
-    std::mutex                                       ul_sched_queue_mutex;
     std::mutex                                       ul_sr_sched_queue_mutex;
+    std::mutex                                       dl_pending_mutex;
+    std::mutex                                       ul_pending_mutex;
     std::list<LTE_FDD_ENB_RAR_SCHED_QUEUE_STRUCT*>   rar_sched_queue;
     std::list<LTE_FDD_ENB_DL_SCHED_QUEUE_STRUCT*>    dl_sched_queue;
     std::list<LTE_FDD_ENB_PERSISTENT_DL_STRUCT*>     persistent_dl_queue;
-    std::list<LTE_FDD_ENB_UL_SCHED_QUEUE_STRUCT*>    ul_sched_queue;
     std::list<LTE_FDD_ENB_UL_SR_SCHED_QUEUE_STRUCT*> ul_sr_sched_queue;
+    std::list<uint16>                                dl_pending_rntis;
+    std::list<uint16>                                ul_pending_rntis;
+    LTE_FDD_ENB_DL_HARQ_RETX_STRUCT                  dl_harq_retx_queue[LTE_FDD_ENB_MAC_DL_HARQ_RETX_QUEUE_SIZE];
+    uint32                                           dl_harq_retx_queue_head;
+    uint32                                           N_dl_harq_retx;
     LTE_FDD_ENB_DL_SCHEDULE_MSG_STRUCT               sched_dl_subfr[10];
     LTE_FDD_ENB_UL_SCHEDULE_MSG_STRUCT               sched_ul_subfr[10];
     uint8                                            sched_cur_dl_subfn;
@@ -205,11 +230,31 @@ private:
     std::mutex                   sys_info_mutex;
     LTE_FDD_ENB_SYS_INFO_STRUCT  sys_info;
 
+    // DL Multiplexing
+    void fill_dl_alloc(LTE_fdd_enb_user *user, LIBLTE_PHY_ALLOCATION_STRUCT *alloc);
+    LTE_FDD_ENB_ERROR_ENUM get_dl_rb(LTE_fdd_enb_user *user, uint32 rb_id, LTE_fdd_enb_rb **rb);
+    uint32 get_dl_buffer_status(LTE_fdd_enb_user *user, uint32 current_tti, uint32 *N_min_bytes);
+    void build_dl_mac_pdu(LTE_fdd_enb_user *user, uint32 current_tti, uint32 N_bytes, LIBLTE_MAC_PDU_STRUCT *mac_pdu);
+    uint32 schedule_dl_user(LTE_FDD_ENB_DL_SCHEDULE_MSG_STRUCT *dl_subfr, LTE_FDD_ENB_DL_SCHED_CANDIDATE_STRUCT *cand, LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_ENUM ra_type, bool *prb_used);
+    void release_dl_prbs(LIBLTE_PHY_ALLOCATION_STRUCT *alloc, bool *prb_used);
+    void send_dl_alloc(LTE_FDD_ENB_DL_SCHEDULE_MSG_STRUCT *dl_subfr, LIBLTE_PHY_ALLOCATION_STRUCT *alloc);
+
+    // UL Multiplexing
+    uint32 schedule_ul_user(LTE_FDD_ENB_DL_SCHEDULE_MSG_STRUCT *dl_subfr, LTE_FDD_ENB_UL_SCHEDULE_MSG_STRUCT *ul_subfr, LTE_fdd_enb_user *user);
+    void send_ul_alloc(LTE_FDD_ENB_DL_SCHEDULE_MSG_STRUCT *dl_subfr, LTE_FDD_ENB_UL_SCHEDULE_MSG_STRUCT *ul_subfr, LIBLTE_PHY_ALLOCATION_STRUCT *alloc);
+
+    // UL H-ARQ
+    LIBLTE_PHY_SOFT_BUFFER_STRUCT* start_ul_harq(uint32 current_tti, LIBLTE_PHY_ALLOCATION_STRUCT *alloc);
+    void handle_ul_harq(LTE_fdd_enb_user *user, uint32 current_tti, bool crc_pass);
+    void stop_ul_harq(LTE_FDD_ENB_UL_HARQ_PROC_STRUCT *proc);
+
     // Helpers
     void advance_tti_and_clear_subframe();
     uint32 get_n_reserved_prbs(uint32 current_tti);
+    uint32 get_n_pucch_prbs();
     bool scheduling_headroom(LTE_FDD_ENB_DL_SCHEDULE_MSG_STRUCT *dl_subfr, LTE_FDD_ENB_UL_SCHEDULE_MSG_STRUCT *ul_subfr, uint32 N_dl_prbs, uint32 N_ul_prbs);
     LIBLTE_PHY_MODULATION_TYPE_ENUM get_modulation_type(uint8 mcs);
+    LIBLTE_PHY_MODULATION_TYPE_ENUM get_ul_modulation_type(uint8 mcs);
 };
 
 #endif /* __LTE_FDD_ENB_MAC_H__ */
@@ -0,0 +1,184 @@
+/*******************************************************************************
+
+    Copyright 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************
+
+    File: LTE_fdd_enb_metrics.h
+
+    Description: Contains all the definitions for the LTE FDD eNodeB
+                 pipeline stage latency metrics.
+
+    Revision History
+    ----------    -------------    --------------------------------------------
+    10/18/2026    agent            Created file.
+
+*******************************************************************************/
+
+#ifndef __LTE_FDD_ENB_METRICS_H__
+#define __LTE_FDD_ENB_METRICS_H__
+
+/*******************************************************************************
+                              INCLUDES
+*******************************************************************************/
+
+#include "typedefs.h"
+#include <atomic>
+#include <thread>
+#include <string>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+/*******************************************************************************
+                              DEFINES
+*******************************************************************************/
+
+// Histograms are log-linear, every power of 2 is split into
+// 2^SUB_BUCKET_BITS buckets (about 3% resolution) up to 2^32 ns
+#define LTE_FDD_ENB_METRICS_SUB_BUCKET_BITS 5
+#define LTE_FDD_ENB_METRICS_MAX_NS_BITS     32
+#define LTE_FDD_ENB_METRICS_N_BUCKETS       ((LTE_FDD_ENB_METRICS_MAX_NS_BITS - LTE_FDD_ENB_METRICS_SUB_BUCKET_BITS + 1) << LTE_FDD_ENB_METRICS_SUB_BUCKET_BITS)
+
+// Snapshot file, rewritten every period while metrics are enabled
+#define LTE_FDD_ENB_METRICS_FILE_NAME         "/tmp/LTE_fdd_enodeb.metrics"
+#define LTE_FDD_ENB_METRICS_FILE_MAGIC        0x4D45544C // "LTEM"
+#define LTE_FDD_ENB_METRICS_FILE_VERSION      1
+#define LTE_FDD_ENB_METRICS_SNAPSHOT_PERIOD_S 1
+
+/*******************************************************************************
+                              FORWARD DECLARATIONS
+*******************************************************************************/
+
+
+/*******************************************************************************
+                              TYPEDEFS
+*******************************************************************************/
+
+typedef enum{
+    LTE_FDD_ENB_METRICS_STAGE_PHY_TTI = 0,
+    LTE_FDD_ENB_METRICS_STAGE_PHY_UL,
+    LTE_FDD_ENB_METRICS_STAGE_PHY_DL,
+    LTE_FDD_ENB_METRICS_STAGE_TURBO_DECODE_CB,
+    LTE_FDD_ENB_METRICS_STAGE_MAC_READY_TO_SEND,
+    LTE_FDD_ENB_METRICS_STAGE_MSGQ_WAIT,
+    LTE_FDD_ENB_METRICS_STAGE_N_ITEMS,
+}LTE_FDD_ENB_METRICS_STAGE_ENUM;
+static const char LTE_fdd_enb_metrics_stage_text[LTE_FDD_ENB_METRICS_STAGE_N_ITEMS][20] = {"phy_tti",
+                                                                                           "phy_ul",
+                                                                                           "phy_dl",
+                                                                                           "turbo_decode_cb",
+                                                                                           "mac_ready_to_send",
+                                                                                           "msgq_wait"};
+
+// Any number of threads can record into a stage, the sample count is
+// the sum of the buckets
+typedef struct{
+    std::atomic<uint64> sum_ns;
+    std::atomic<uint64> max_ns;
+    std::atomic<uint64> N_misses;
+    std::atomic<uint64> bucket[LTE_FDD_ENB_METRICS_N_BUCKETS];
+}LTE_FDD_ENB_METRICS_HIST_STRUCT;
+
+// Snapshot file layout, in host byte order, a header followed by
+// N_stages stage records
+typedef struct{
+    uint32 magic;
+    uint32 version;
+    uint64 ts_us;
+    uint32 N_stages;
+    uint32 N_buckets;
+    uint32 sub_bucket_bits;
+    uint32 reserved;
+}LTE_FDD_ENB_METRICS_FILE_HDR_STRUCT;
+typedef struct{
+    char   name[24];
+    uint64 deadline_ns;
+    uint64 N_samples;
+    uint64 N_misses;
+    uint64 sum_ns;
+    uint64 max_ns;
+    uint64 bucket[LTE_FDD_ENB_METRICS_N_BUCKETS];
+}LTE_FDD_ENB_METRICS_FILE_STAGE_STRUCT;
+
+/*******************************************************************************
+                              CLASS DECLARATIONS
+*******************************************************************************/
+
+class LTE_fdd_enb_metrics
+{
+public:
+    LTE_fdd_enb_metrics();
+    ~LTE_fdd_enb_metrics();
+
+    // Enable
+    bool get_enabled();
+    void set_enabled(bool enable);
+
+    // Recording, start returns 0 when disabled and a 0 start is not
+    // recorded, record returns the end so stages can be chained
+    uint64 start()
+    {
+        if(!enabled.load(std::memory_order_relaxed))
+            return 0;
+        return get_ticks();
+    }
+    uint64 record(LTE_FDD_ENB_METRICS_STAGE_ENUM stage, uint64 start_ticks)
+    {
+        if(0 == start_ticks)
+            return 0;
+        uint64 end_ticks = get_ticks();
+        record_ns(stage, (uint64)((end_ticks - start_ticks)*ns_per_tick));
+        return end_ticks;
+    }
+
+    // Reports
+    std::string get_report_string();
+
+    // Histogram buckets
+    static uint32 ns_to_bucket(uint64 ns);
+    static uint64 bucket_to_ns(uint32 bucket);
+
+private:
+    // Recording
+    static uint64 get_ticks()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64)ts.tv_sec*1000000000 + ts.tv_nsec;
+#endif
+    }
+    void calibrate_ticks();
+    void record_ns(LTE_FDD_ENB_METRICS_STAGE_ENUM stage, uint64 ns);
+    void reset();
+    LTE_FDD_ENB_METRICS_HIST_STRUCT hist[LTE_FDD_ENB_METRICS_STAGE_N_ITEMS];
+    float                           ns_per_tick;
+    std::atomic<bool>               enabled;
+
+    // Snapshot Thread
+    static void snapshot_thread(LTE_fdd_enb_metrics *metrics);
+    void write_snapshot();
+    void copy_stage(uint32 stage, LTE_FDD_ENB_METRICS_FILE_STAGE_STRUCT *copy);
+    std::thread       *thread;
+    std::atomic<bool>  thread_run;
+};
+
+#endif /* __LTE_FDD_ENB_METRICS_H__ */
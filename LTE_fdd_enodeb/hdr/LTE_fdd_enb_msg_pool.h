@@ -0,0 +1,226 @@
+/*******************************************************************************
+
+    Copyright 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************
+
+    File: LTE_fdd_enb_msg_pool.h
+
+    Description: Contains all the definitions for the LTE FDD eNodeB
+                 message pool and the intrusive message queue that
+                 carries pooled messages between layers.
+
+    Revision History
+    ----------    -------------    --------------------------------------------
+    10/18/2026    agent            Created file.
+
+*******************************************************************************/
+
+#ifndef __LTE_FDD_ENB_MSG_POOL_H__
+#define __LTE_FDD_ENB_MSG_POOL_H__
+
+/*******************************************************************************
+                              INCLUDES
+*******************************************************************************/
+
+#include "typedefs.h"
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <stdlib.h>
+
+/*******************************************************************************
+                              DEFINES
+*******************************************************************************/
+
+// Blocks move between a thread's cache and the shared free list, and
+// are carved out of malloc'd slabs, this many at a time
+#define LTE_FDD_ENB_MSG_POOL_BATCH         16
+#define LTE_FDD_ENB_MSG_POOL_MAX_N_CACHED  (2*LTE_FDD_ENB_MSG_POOL_BATCH)
+
+/*******************************************************************************
+                              FORWARD DECLARATIONS
+*******************************************************************************/
+
+template<class T> class LTE_fdd_enb_msg_queue;
+
+/*******************************************************************************
+                              TYPEDEFS
+*******************************************************************************/
+
+
+/*******************************************************************************
+                              CLASS DECLARATIONS
+*******************************************************************************/
+
+// Fixed size blocks of one message type.  Slabs are never returned to
+// the system, the pool grows to the high water mark of messages in
+// flight and stays there.
+template<class T>
+class LTE_fdd_enb_msg_pool
+{
+public:
+    static T* alloc()
+    {
+        CACHE *c = &cache;
+
+        if(NULL == c->head)
+            refill(c);
+        BLOCK *block = c->head;
+        c->head = block->next;
+        c->N_blocks--;
+        block->next = NULL;
+        return &block->msg;
+    }
+    static void free(T *msg)
+    {
+        CACHE *c     = &cache;
+        BLOCK *block = to_block(msg);
+
+        block->next = c->head;
+        c->head     = block;
+        c->N_blocks++;
+        if(LTE_FDD_ENB_MSG_POOL_MAX_N_CACHED < c->N_blocks)
+            drain(c, LTE_FDD_ENB_MSG_POOL_BATCH);
+    }
+
+private:
+    friend class LTE_fdd_enb_msg_queue<T>;
+
+    typedef struct BLOCK_STRUCT{
+        struct BLOCK_STRUCT *next;
+        T                    msg;
+    }BLOCK;
+
+    // Blocks freed by one thread and allocated by another pass through
+    // the shared list, everything else stays thread local
+    struct CACHE{
+        BLOCK  *head;
+        uint32  N_blocks;
+        ~CACHE() {drain(this, N_blocks);}
+    };
+
+    static BLOCK* to_block(T *msg)
+    {
+        return (BLOCK *)((uint8 *)msg - offsetof(BLOCK, msg));
+    }
+    static void refill(CACHE *c)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if(NULL == free_head)
+        {
+            BLOCK *slab = (BLOCK *)malloc(LTE_FDD_ENB_MSG_POOL_BATCH*sizeof(BLOCK));
+            if(NULL == slab)
+                throw std::bad_alloc();
+            for(uint32 i=0; i<LTE_FDD_ENB_MSG_POOL_BATCH; i++)
+            {
+                slab[i].next = free_head;
+                free_head    = &slab[i];
+            }
+        }
+        for(uint32 i=0; i<LTE_FDD_ENB_MSG_POOL_BATCH && NULL != free_head; i++)
+        {
+            BLOCK *block = free_head;
+            free_head    = block->next;
+            block->next  = c->head;
+            c->head      = block;
+            c->N_blocks++;
+        }
+    }
+    static void drain(CACHE *c, uint32 N_blocks)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for(uint32 i=0; i<N_blocks && NULL != c->head; i++)
+        {
+            BLOCK *block = c->head;
+            c->head      = block->next;
+            block->next  = free_head;
+            free_head    = block;
+            c->N_blocks--;
+        }
+    }
+
+    static inline thread_local CACHE  cache     = {NULL, 0};
+    static inline std::mutex          mutex;
+    static inline BLOCK              *free_head = NULL;
+};
+
+// FIFO of pooled messages linked through the pool block, so queueing
+// never allocates.  Not thread safe, callers hold their queue mutex.
+template<class T>
+class LTE_fdd_enb_msg_queue
+{
+public:
+    LTE_fdd_enb_msg_queue() : head{NULL}, tail{NULL}, N_msgs{0} {};
+    ~LTE_fdd_enb_msg_queue() {clear();};
+
+    void push_back(T *msg)
+    {
+        BLOCK *block = LTE_fdd_enb_msg_pool<T>::to_block(msg);
+
+        block->next = NULL;
+        if(NULL == tail)
+            head = block;
+        else
+            tail->next = block;
+        tail = block;
+        N_msgs++;
+    }
+    T* front()
+    {
+        return (NULL == head) ? NULL : &head->msg;
+    }
+    T* next(T *msg)
+    {
+        BLOCK *block = LTE_fdd_enb_msg_pool<T>::to_block(msg)->next;
+
+        return (NULL == block) ? NULL : &block->msg;
+    }
+    T* pop_front()
+    {
+        BLOCK *block = head;
+
+        if(NULL == block)
+            return NULL;
+        head = block->next;
+        if(NULL == head)
+            tail = NULL;
+        N_msgs--;
+        return &block->msg;
+    }
+    uint32 size()
+    {
+        return N_msgs;
+    }
+    void clear()
+    {
+        T *msg;
+
+        while(NULL != (msg = pop_front()))
+            LTE_fdd_enb_msg_pool<T>::free(msg);
+    }
+
+private:
+    typedef typename LTE_fdd_enb_msg_pool<T>::BLOCK BLOCK;
+
+    BLOCK  *head;
+    BLOCK  *tail;
+    uint32  N_msgs;
+};
+
+#endif /* __LTE_FDD_ENB_MSG_POOL_H__ */
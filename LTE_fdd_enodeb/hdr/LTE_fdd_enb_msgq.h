@@ -58,7 +58,6 @@
 
 #include "LTE_fdd_enb_user.h"
 #include "liblte_phy.h"
-#include <boost/circular_buffer.hpp>
 #include <string>
 #include "semaphore.h"
 
@@ -68,6 +67,7 @@
 
 #define LTE_FDD_ENB_N_SIB_ALLOCS      7
 #define LTE_FDD_ENB_N_PUCCH_PER_SUBFR 12
+#define LTE_FDD_ENB_MSGQ_N_SLOTS      100
 
 /*******************************************************************************
                               FORWARD DECLARATIONS
@@ -195,13 +195,14 @@ typedef struct{
     bool                        decode;
 }LTE_FDD_ENB_PUCCH_STRUCT;
 typedef struct{
-    LIBLTE_PHY_PDCCH_STRUCT  decodes;
-    LTE_FDD_ENB_PUCCH_STRUCT pucch[LTE_FDD_ENB_N_PUCCH_PER_SUBFR];
-    uint32                   N_avail_prbs;
-    uint32                   N_sched_prbs;
-    uint32                   current_tti;
-    uint32                   N_pucch;
-    uint8                    next_prb;
+    LIBLTE_PHY_PDCCH_STRUCT        decodes;
+    LIBLTE_PHY_SOFT_BUFFER_STRUCT *soft_buffer[LIBLTE_PHY_PDCCH_MAX_ALLOC];
+    LTE_FDD_ENB_PUCCH_STRUCT       pucch[LTE_FDD_ENB_N_PUCCH_PER_SUBFR];
+    uint32                         N_avail_prbs;
+    uint32                         N_sched_prbs;
+    uint32                         current_tti;
+    uint32                         N_pucch;
+    uint8                          next_prb;
 }LTE_FDD_ENB_UL_SCHEDULE_MSG_STRUCT;
 typedef struct{
     LTE_FDD_ENB_DL_SCHEDULE_MSG_STRUCT dl_sched;
@@ -229,7 +230,9 @@ typedef struct{
 typedef struct{
     LIBLTE_BIT_MSG_STRUCT msg;
     uint32                current_tti;
+    float                 sinr_db;
     uint16                rnti;
+    bool                  crc_pass;
 }LTE_FDD_ENB_PUSCH_DECODE_MSG_STRUCT;
 
 // RLC -> MAC Messages
@@ -265,6 +268,7 @@ typedef struct{
 typedef struct{
     LTE_fdd_enb_user *user;
     LTE_fdd_enb_rb   *rb;
+    bool              activate_security;
 }LTE_FDD_ENB_PDCP_SDU_READY_MSG_STRUCT;
 
 // PDCP -> RRC Messages
@@ -421,18 +425,23 @@ public:
 
 private:
     // Send/Receive
+    LTE_FDD_ENB_MESSAGE_STRUCT* get_free_slot();
     static void* receive_thread(void *inputs);
 
     // Variables
-    LTE_fdd_enb_interface                              *interface;
-    LTE_fdd_enb_msgq_cb                                 callback;
-    sem_t                                               sync_sem;
-    sem_t                                               msg_sem;
-    boost::circular_buffer<LTE_FDD_ENB_MESSAGE_STRUCT> *circ_buf;
-    const std::string                                   msgq_name;
-    pthread_t                                           rx_thread;
-    uint32                                              prio;
-    bool                                                rx_setup;
+    LTE_fdd_enb_interface      *interface;
+    LTE_fdd_enb_msgq_cb         callback;
+    sem_t                       sync_sem;
+    sem_t                       msg_sem;
+    LTE_FDD_ENB_MESSAGE_STRUCT *slots;
+    bool                        slots_mapped;
+    uint64                      slot_start[LTE_FDD_ENB_MSGQ_N_SLOTS];
+    uint32                      slot_head;
+    uint32                      N_msgs;
+    const std::string           msgq_name;
+    pthread_t                   rx_thread;
+    uint32                      prio;
+    bool                        rx_setup;
 };
 
 #endif /* __LTE_FDD_ENB_MSGQ_H__ */
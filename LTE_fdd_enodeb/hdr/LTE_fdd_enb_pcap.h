@@ -0,0 +1,128 @@
+/*******************************************************************************
+
+    Copyright 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************
+
+    File: LTE_fdd_enb_pcap.h
+
+    Description: Contains all the definitions for the LTE FDD eNodeB
+                 pcap writer.  Callers build pcap records in a per
+                 thread lock-free ring, a background thread writes
+                 them to the file in batches.
+
+    Revision History
+    ----------    -------------    --------------------------------------------
+    10/18/2026    agent            Created file.
+
+*******************************************************************************/
+
+#ifndef __LTE_FDD_ENB_PCAP_H__
+#define __LTE_FDD_ENB_PCAP_H__
+
+/*******************************************************************************
+                              INCLUDES
+*******************************************************************************/
+
+#include "LTE_fdd_enb_ring.h"
+#include "typedefs.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <string>
+
+/*******************************************************************************
+                              DEFINES
+*******************************************************************************/
+
+// Per thread ring size in bytes, must be a power of 2, records that
+// don't fit are dropped
+#define LTE_FDD_ENB_PCAP_RING_SIZE (1024*1024)
+
+// Size of the pcap record header in front of every packet
+#define LTE_FDD_ENB_PCAP_RECORD_HDR_SIZE 16
+
+// Records per writev
+#define LTE_FDD_ENB_PCAP_MAX_BATCH 256
+
+// Background thread poll period when all rings are empty
+#define LTE_FDD_ENB_PCAP_IDLE_SLEEP_US 1000
+
+// File rotation, the current file is renamed to <name>.1, <name>.1
+// to <name>.2 and so on, keeping N_OLD_FILES
+#define LTE_FDD_ENB_PCAP_MAX_FILE_SIZE     (256*1024*1024)
+#define LTE_FDD_ENB_PCAP_MAX_FILE_DURATION (60*60)
+#define LTE_FDD_ENB_PCAP_N_OLD_FILES       4
+
+/*******************************************************************************
+                              FORWARD DECLARATIONS
+*******************************************************************************/
+
+class LTE_fdd_enb_interface;
+
+/*******************************************************************************
+                              TYPEDEFS
+*******************************************************************************/
+
+// Ring entry in front of the pcap record header, the timestamp orders
+// records from different threads
+typedef struct{
+    uint64 ts_us;
+    uint32 len;
+}LTE_FDD_ENB_PCAP_RECORD_STRUCT;
+
+typedef LTE_fdd_enb_ring<LTE_FDD_ENB_PCAP_RING_SIZE> LTE_fdd_enb_pcap_ring;
+
+/*******************************************************************************
+                              CLASS DECLARATIONS
+*******************************************************************************/
+
+class LTE_fdd_enb_pcap
+{
+public:
+    LTE_fdd_enb_pcap(LTE_fdd_enb_interface *iface, std::string _file_name, uint32 _dlt);
+    ~LTE_fdd_enb_pcap();
+
+    // Records
+    uint8* start_record(uint32 N_bytes);
+    void end_record();
+
+private:
+    // Rings
+    LTE_fdd_enb_pcap_ring* get_thread_ring();
+    std::mutex                           ring_mutex;
+    std::vector<LTE_fdd_enb_pcap_ring *> rings;
+    uint32                               id;
+
+    // File
+    void open_file();
+    void rotate_file();
+    std::string file_name;
+    uint64      file_size;
+    int64       file_open_time;
+    uint32      dlt;
+    int32       fd;
+
+    // Background Thread
+    static void write_thread(LTE_fdd_enb_pcap *pcap);
+    bool drain();
+    LTE_fdd_enb_interface *interface;
+    std::thread           *thread;
+    std::atomic<bool>      thread_run;
+};
+
+#endif /* __LTE_FDD_ENB_PCAP_H__ */
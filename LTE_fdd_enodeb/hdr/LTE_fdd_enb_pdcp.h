@@ -45,12 +45,15 @@
 
 #include "LTE_fdd_enb_interface.h"
 #include "LTE_fdd_enb_msgq.h"
+#include "liblte_pdcp.h"
 #include <mutex>
 
 /*******************************************************************************
                               DEFINES
 *******************************************************************************/
 
+// Data PDUs ciphered together when draining a DRB
+#define LTE_FDD_ENB_PDCP_MAX_CIPHER_BATCH 16
 
 /*******************************************************************************
                               FORWARD DECLARATIONS
@@ -107,6 +110,13 @@ private:
 
     // GW Message Handlers
     void handle_data_sdu_ready(LTE_FDD_ENB_PDCP_DATA_SDU_READY_MSG_STRUCT *data_sdu_ready);
+    LIBLTE_BYTE_MSG_STRUCT            cipher_batch_pdu[LTE_FDD_ENB_PDCP_MAX_CIPHER_BATCH];
+    LIBLTE_SECURITY_CIPHER_JOB_STRUCT cipher_batch_job[LTE_FDD_ENB_PDCP_MAX_CIPHER_BATCH];
+
+    // Security
+    void get_security_config(LTE_fdd_enb_user *user, LTE_fdd_enb_rb *rb, bool ciphering, LIBLTE_PDCP_SECURITY_CONFIG_STRUCT *sec);
+    uint8 get_bearer(LTE_fdd_enb_rb *rb);
+    uint32 get_rx_count(LTE_fdd_enb_rb *rb, uint32 sn, uint32 sn_len);
 
     // Parameters
     std::mutex                  sys_info_mutex;
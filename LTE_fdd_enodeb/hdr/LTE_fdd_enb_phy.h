@@ -133,10 +133,12 @@ private:
     void process_pucch();
     void process_pusch();
     void process_ul(LTE_FDD_ENB_RADIO_RX_BUF_STRUCT *rx_buf);
+    static void turbo_decode_hook(void *obj, bool done);
     LTE_FDD_ENB_PRACH_DECODE_MSG_STRUCT prach_decode;
     LTE_FDD_ENB_PUCCH_DECODE_MSG_STRUCT pucch_decode;
     LTE_FDD_ENB_PUSCH_DECODE_MSG_STRUCT pusch_decode;
     LIBLTE_PHY_SUBFRAME_STRUCT          ul_subframe;
+    uint64                              turbo_decode_start;
     uint32                              ul_current_tti;
     uint32                              prach_sfn_mod;
     uint32                              prach_subfn_mod;
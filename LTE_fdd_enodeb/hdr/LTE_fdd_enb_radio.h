@@ -55,11 +55,17 @@
 #include <gnuradio/gr_complex.h>
 #include <uhd/usrp/multi_usrp.hpp>
 #include <libbladeRF.h>
+#include <stdio.h>
 
 /*******************************************************************************
                               DEFINES
 *******************************************************************************/
 
+// No-RF simulation, DL subframes kept for the loopback, noise table
+// size and how late a TTI can be before the deadline is reset
+#define LTE_FDD_ENB_RADIO_SIM_N_DL_SUBFRS     4
+#define LTE_FDD_ENB_RADIO_SIM_NOISE_TABLE_LEN 65536
+#define LTE_FDD_ENB_RADIO_SIM_MAX_LATE_NS     10000000
 
 /*******************************************************************************
                               FORWARD DECLARATIONS
@@ -86,6 +92,18 @@ typedef struct{
     uint32                   num_radios;
 }LTE_FDD_ENB_AVAILABLE_RADIOS_STRUCT;
 
+// No-RF simulation, the files are raw complex float samples of
+// antenna 0, empty names for zeros and discard
+typedef struct{
+    std::string ul_file_name;
+    std::string dl_file_name;
+    int32       loop_cfo;
+    int32       loop_snr;
+    uint32      loop_delay;
+    bool        fast_pace;
+    bool        loopback;
+}LTE_FDD_ENB_RADIO_SIM_CNFG_STRUCT;
+
 typedef LIBTOOLS_IPC_MSGQ_PHY_SAMPS_MSG_STRUCT LTE_FDD_ENB_RADIO_TX_BUF_STRUCT;
 typedef LIBTOOLS_IPC_MSGQ_PHY_SAMPS_MSG_STRUCT LTE_FDD_ENB_RADIO_RX_BUF_STRUCT;
 
@@ -94,8 +112,8 @@ class LTE_fdd_enb_radio;
 typedef struct{
     LTE_fdd_enb_interface           *interface;
     LTE_fdd_enb_phy                 *phy;
-    LTE_FDD_ENB_RADIO_TX_BUF_STRUCT  tx_radio_buf[2];
-    LTE_FDD_ENB_RADIO_RX_BUF_STRUCT  rx_radio_buf[2];
+    LTE_FDD_ENB_RADIO_TX_BUF_STRUCT *tx_radio_buf; // 2 buffers
+    LTE_FDD_ENB_RADIO_RX_BUF_STRUCT *rx_radio_buf; // 2 buffers
     uint32                           samp_rate;
     uint32                           buf_idx;
     uint32                           samp_idx;
@@ -119,15 +137,33 @@ public:
     ~LTE_fdd_enb_radio_no_rf();
 
     // Radio functions
-    LTE_FDD_ENB_ERROR_ENUM setup();
-    void teardown();
-    void send();
+    LTE_FDD_ENB_ERROR_ENUM setup(LTE_FDD_ENB_RADIO_SIM_CNFG_STRUCT *_cnfg, uint32 _N_samps_per_subfr);
+    void teardown(LTE_fdd_enb_interface *interface);
+    void send(LTE_FDD_ENB_RADIO_TX_BUF_STRUCT *buf);
     void init(LTE_FDD_ENB_RADIO_PARAMS_STRUCT *radio_params);
     void receive(LTE_FDD_ENB_RADIO_PARAMS_STRUCT *radio_params);
 
 private:
+    // Radio functions
+    void read_ul_file(complex *samps);
+    void apply_loopback(complex *samps, uint16 current_tti);
+    void wait_for_deadline();
+
     // Parameters
-    struct timespec sleep_time;
+    LTE_FDD_ENB_RADIO_SIM_CNFG_STRUCT  cnfg;
+    FILE                              *ul_file;
+    FILE                              *dl_file;
+    complex                           *dl_subfr;
+    complex                           *noise;
+    complex                            cfo_phasor;
+    complex                            cfo_step;
+    uint64                             next_deadline_ns;
+    uint64                             N_ttis;
+    uint64                             N_late_ttis;
+    uint64                             max_late_ns;
+    uint32                             N_samps_per_subfr;
+    uint32                             noise_idx;
+    uint16                             dl_subfr_tti[LTE_FDD_ENB_RADIO_SIM_N_DL_SUBFRS];
 };
 
 class LTE_fdd_enb_radio_usrp_b2x0
@@ -220,6 +256,14 @@ public:
     LTE_FDD_ENB_ERROR_ENUM set_rx_gain(uint32 gain);
     std::string get_clock_source();
     LTE_FDD_ENB_ERROR_ENUM set_clock_source(std::string source);
+    std::string get_sim_ul_file();
+    LTE_FDD_ENB_ERROR_ENUM set_sim_ul_file(std::string file_name);
+    std::string get_sim_dl_file();
+    LTE_FDD_ENB_ERROR_ENUM set_sim_dl_file(std::string file_name);
+    std::string get_sim_pace();
+    LTE_FDD_ENB_ERROR_ENUM set_sim_pace(std::string pace);
+    std::string get_sim_loopback();
+    LTE_FDD_ENB_ERROR_ENUM set_sim_loopback(std::string loopback);
     uint32 get_phy_sample_rate();
     uint32 get_radio_sample_rate();
     void send(LTE_FDD_ENB_RADIO_TX_BUF_STRUCT *buf);
@@ -236,6 +280,7 @@ private:
     LTE_fdd_enb_phy                     *phy;
     pthread_t                            radio_thread;
     std::string                          clock_source;
+    LTE_FDD_ENB_RADIO_SIM_CNFG_STRUCT    sim_cnfg;
     LTE_FDD_ENB_RADIO_PARAMS_STRUCT      radio_params;
     LTE_FDD_ENB_AVAILABLE_RADIOS_STRUCT  available_radios;
     LTE_FDD_ENB_RADIO_TYPE_ENUM          selected_radio_type;
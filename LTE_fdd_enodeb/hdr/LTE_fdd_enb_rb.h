@@ -63,6 +63,7 @@
 *******************************************************************************/
 
 #include "LTE_fdd_enb_common.h"
+#include "LTE_fdd_enb_msg_pool.h"
 #include "liblte_rlc.h"
 #include <list>
 #include <map>
@@ -73,6 +74,7 @@
                               DEFINES
 *******************************************************************************/
 
+#define LTE_FDD_ENB_RLC_MAX_N_DATA LIBLTE_RLC_UMD_MAX_N_DATA
 
 /*******************************************************************************
                               FORWARD DECLARATIONS
@@ -189,6 +191,13 @@ static const char LTE_fdd_enb_rlc_config_text[LTE_FDD_ENB_RLC_CONFIG_N_ITEMS][20
                                                                                      "UM",
                                                                                      "AM"};
 
+typedef struct{
+    LIBLTE_RLC_FI_FIELD_ENUM fi;
+    uint32                   N_data;
+    uint32                   N_bytes;
+    uint16                   li[LTE_FDD_ENB_RLC_MAX_N_DATA];
+}LTE_FDD_ENB_RLC_SEGMENT_STRUCT;
+
 typedef enum{
     LTE_FDD_ENB_MAC_CONFIG_TM = 0,
     LTE_FDD_ENB_MAC_CONFIG_N_ITEMS,
@@ -255,6 +264,10 @@ public:
     void set_pdcp_rx_count(uint32 rx_count);
     uint32 get_pdcp_tx_count();
     void set_pdcp_tx_count(uint32 tx_count);
+    void set_pdcp_dl_ciphering(bool ciphering);
+    bool get_pdcp_dl_ciphering();
+    void set_pdcp_ul_ciphering(bool ciphering);
+    bool get_pdcp_ul_ciphering();
 
     // RLC
     void queue_rlc_pdu(LIBLTE_BYTE_MSG_STRUCT *pdu);
@@ -292,6 +305,10 @@ public:
     LTE_FDD_ENB_ERROR_ENUM rlc_um_reassemble(LIBLTE_BYTE_MSG_STRUCT *sdu);
     void set_rlc_vtus(uint16 vtus);
     uint16 get_rlc_vtus();
+    void rlc_get_tx_buffer_status(uint32 *N_bytes, uint32 *N_sdus);
+    LTE_FDD_ENB_ERROR_ENUM rlc_segment_tx_buffer(uint32 N_bytes, LTE_FDD_ENB_RLC_SEGMENT_STRUCT *seg);
+    void rlc_read_tx_buffer(LTE_FDD_ENB_RLC_SEGMENT_STRUCT *seg, LIBLTE_BYTE_MSG_STRUCT *pdu);
+    uint32 rlc_get_pdu_header_size(uint32 N_data);
 
     // MAC
     void queue_mac_sdu(LIBLTE_BYTE_MSG_STRUCT *sdu);
@@ -322,41 +339,44 @@ private:
     LTE_fdd_enb_rlc       *rlc;
 
     // GW
-    std::mutex                          gw_data_msg_queue_mutex;
-    std::list<LIBLTE_BYTE_MSG_STRUCT *> gw_data_msg_queue;
+    std::mutex                                    gw_data_msg_queue_mutex;
+    LTE_fdd_enb_msg_queue<LIBLTE_BYTE_MSG_STRUCT> gw_data_msg_queue;
 
     // MME
-    std::mutex                          mme_nas_msg_queue_mutex;
-    std::list<LIBLTE_BYTE_MSG_STRUCT *> mme_nas_msg_queue;
-    LTE_FDD_ENB_MME_PROC_ENUM           mme_procedure;
-    LTE_FDD_ENB_MME_STATE_ENUM          mme_state;
+    std::mutex                                    mme_nas_msg_queue_mutex;
+    LTE_fdd_enb_msg_queue<LIBLTE_BYTE_MSG_STRUCT> mme_nas_msg_queue;
+    LTE_FDD_ENB_MME_PROC_ENUM                     mme_procedure;
+    LTE_FDD_ENB_MME_STATE_ENUM                    mme_state;
 
     // RRC
-    std::mutex                          rrc_pdu_queue_mutex;
-    std::mutex                          rrc_nas_msg_queue_mutex;
-    std::list<LIBLTE_BIT_MSG_STRUCT *>  rrc_pdu_queue;
-    std::list<LIBLTE_BYTE_MSG_STRUCT *> rrc_nas_msg_queue;
-    LTE_FDD_ENB_RRC_PROC_ENUM           rrc_procedure;
-    LTE_FDD_ENB_RRC_STATE_ENUM          rrc_state;
-    uint8                               rrc_transaction_id;
+    std::mutex                                    rrc_pdu_queue_mutex;
+    std::mutex                                    rrc_nas_msg_queue_mutex;
+    LTE_fdd_enb_msg_queue<LIBLTE_BIT_MSG_STRUCT>  rrc_pdu_queue;
+    LTE_fdd_enb_msg_queue<LIBLTE_BYTE_MSG_STRUCT> rrc_nas_msg_queue;
+    LTE_FDD_ENB_RRC_PROC_ENUM                     rrc_procedure;
+    LTE_FDD_ENB_RRC_STATE_ENUM                    rrc_state;
+    uint8                                         rrc_transaction_id;
 
     // PDCP
-    std::mutex                          pdcp_pdu_queue_mutex;
-    std::mutex                          pdcp_sdu_queue_mutex;
-    std::mutex                          pdcp_data_sdu_queue_mutex;
-    std::list<LIBLTE_BYTE_MSG_STRUCT *> pdcp_pdu_queue;
-    std::list<LIBLTE_BIT_MSG_STRUCT *>  pdcp_sdu_queue;
-    std::list<LIBLTE_BYTE_MSG_STRUCT *> pdcp_data_sdu_queue;
-    LTE_FDD_ENB_PDCP_CONFIG_ENUM        pdcp_config;
-    uint32                              pdcp_rx_count;
-    uint32                              pdcp_tx_count;
+    std::mutex                                    pdcp_pdu_queue_mutex;
+    std::mutex                                    pdcp_sdu_queue_mutex;
+    std::mutex                                    pdcp_data_sdu_queue_mutex;
+    LTE_fdd_enb_msg_queue<LIBLTE_BYTE_MSG_STRUCT> pdcp_pdu_queue;
+    LTE_fdd_enb_msg_queue<LIBLTE_BIT_MSG_STRUCT>  pdcp_sdu_queue;
+    LTE_fdd_enb_msg_queue<LIBLTE_BYTE_MSG_STRUCT> pdcp_data_sdu_queue;
+    LTE_FDD_ENB_PDCP_CONFIG_ENUM                  pdcp_config;
+    uint32                                        pdcp_rx_count;
+    uint32                                        pdcp_tx_count;
+    bool                                          pdcp_dl_ciphering;
+    bool                                          pdcp_ul_ciphering;
 
     // RLC
     std::mutex                                           rlc_pdu_queue_mutex;
     std::mutex                                           rlc_sdu_queue_mutex;
-    std::list<LIBLTE_BYTE_MSG_STRUCT *>                  rlc_pdu_queue;
-    std::list<LIBLTE_BYTE_MSG_STRUCT *>                  rlc_sdu_queue;
+    LTE_fdd_enb_msg_queue<LIBLTE_BYTE_MSG_STRUCT>        rlc_pdu_queue;
+    LTE_fdd_enb_msg_queue<LIBLTE_BYTE_MSG_STRUCT>        rlc_sdu_queue;
     std::map<uint16, LIBLTE_RLC_SINGLE_AMD_PDU_STRUCT *> rlc_am_rx_buffer;
+    std::mutex                                           rlc_am_tx_buffer_mutex;
     std::map<uint16, LIBLTE_RLC_SINGLE_AMD_PDU_STRUCT *> rlc_am_tx_buffer;
     std::map<uint16, LIBLTE_RLC_UMD_PDU_STRUCT *>        rlc_um_rx_buffer;
     LTE_FDD_ENB_RLC_CONFIG_ENUM                          rlc_config;
@@ -373,13 +393,15 @@ private:
     uint16                                               rlc_first_um_segment_sn;
     uint16                                               rlc_last_um_segment_sn;
     uint16                                               rlc_vtus;
+    uint32                                               rlc_tx_buffer_bytes;
+    uint32                                               rlc_tx_buffer_offset;
 
     // MAC
-    std::mutex                          mac_sdu_queue_mutex;
-    std::list<LIBLTE_BYTE_MSG_STRUCT *> mac_sdu_queue;
-    LTE_FDD_ENB_MAC_CONFIG_ENUM         mac_config;
-    uint64                              mac_con_res_id;
-    bool                                mac_send_con_res_id;
+    std::mutex                                    mac_sdu_queue_mutex;
+    LTE_fdd_enb_msg_queue<LIBLTE_BYTE_MSG_STRUCT> mac_sdu_queue;
+    LTE_FDD_ENB_MAC_CONFIG_ENUM                   mac_config;
+    uint64                                        mac_con_res_id;
+    bool                                          mac_send_con_res_id;
 
     // DRB
     uint32 eps_bearer_id;
@@ -388,12 +410,12 @@ private:
     uint8  log_chan_group;
 
     // Generic
-    void queue_msg(LIBLTE_BIT_MSG_STRUCT *msg, std::mutex &mutex, std::list<LIBLTE_BIT_MSG_STRUCT *> *queue);
-    void queue_msg(LIBLTE_BYTE_MSG_STRUCT *msg, std::mutex &mutex, std::list<LIBLTE_BYTE_MSG_STRUCT *> *queue);
-    LTE_FDD_ENB_ERROR_ENUM get_next_msg(std::mutex &mutex, std::list<LIBLTE_BIT_MSG_STRUCT *> *queue, LIBLTE_BIT_MSG_STRUCT **msg);
-    LTE_FDD_ENB_ERROR_ENUM get_next_msg(std::mutex &mutex, std::list<LIBLTE_BYTE_MSG_STRUCT *> *queue, LIBLTE_BYTE_MSG_STRUCT **msg);
-    LTE_FDD_ENB_ERROR_ENUM delete_next_msg(std::mutex &mutex, std::list<LIBLTE_BIT_MSG_STRUCT *> *queue);
-    LTE_FDD_ENB_ERROR_ENUM delete_next_msg(std::mutex &mutex, std::list<LIBLTE_BYTE_MSG_STRUCT *> *queue);
+    void queue_msg(LIBLTE_BIT_MSG_STRUCT *msg, std::mutex &mutex, LTE_fdd_enb_msg_queue<LIBLTE_BIT_MSG_STRUCT> *queue);
+    void queue_msg(LIBLTE_BYTE_MSG_STRUCT *msg, std::mutex &mutex, LTE_fdd_enb_msg_queue<LIBLTE_BYTE_MSG_STRUCT> *queue);
+    LTE_FDD_ENB_ERROR_ENUM get_next_msg(std::mutex &mutex, LTE_fdd_enb_msg_queue<LIBLTE_BIT_MSG_STRUCT> *queue, LIBLTE_BIT_MSG_STRUCT **msg);
+    LTE_FDD_ENB_ERROR_ENUM get_next_msg(std::mutex &mutex, LTE_fdd_enb_msg_queue<LIBLTE_BYTE_MSG_STRUCT> *queue, LIBLTE_BYTE_MSG_STRUCT **msg);
+    LTE_FDD_ENB_ERROR_ENUM delete_next_msg(std::mutex &mutex, LTE_fdd_enb_msg_queue<LIBLTE_BIT_MSG_STRUCT> *queue);
+    LTE_FDD_ENB_ERROR_ENUM delete_next_msg(std::mutex &mutex, LTE_fdd_enb_msg_queue<LIBLTE_BYTE_MSG_STRUCT> *queue);
 };
 
 #endif /* __LTE_FDD_ENB_RB_H__ */
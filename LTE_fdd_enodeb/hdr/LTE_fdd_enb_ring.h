@@ -0,0 +1,164 @@
+/*******************************************************************************
+
+    Copyright 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************
+
+    File: LTE_fdd_enb_ring.h
+
+    Description: Contains all the definitions for the LTE FDD eNodeB
+                 single producer single consumer byte ring used for
+                 the per thread debug log and pcap records.
+
+    Revision History
+    ----------    -------------    --------------------------------------------
+    10/18/2026    agent            Created file.
+
+*******************************************************************************/
+
+#ifndef __LTE_FDD_ENB_RING_H__
+#define __LTE_FDD_ENB_RING_H__
+
+/*******************************************************************************
+                              INCLUDES
+*******************************************************************************/
+
+#include "typedefs.h"
+#include <atomic>
+
+/*******************************************************************************
+                              DEFINES
+*******************************************************************************/
+
+
+/*******************************************************************************
+                              FORWARD DECLARATIONS
+*******************************************************************************/
+
+
+/*******************************************************************************
+                              TYPEDEFS
+*******************************************************************************/
+
+// Entries are 8 byte aligned, so the tail of the ring always has room
+// for the padding entry that skips it
+typedef struct{
+    uint32 size;
+    uint32 pad;
+}LTE_FDD_ENB_RING_ENTRY_STRUCT;
+
+/*******************************************************************************
+                              CLASS DECLARATIONS
+*******************************************************************************/
+
+// One thread reserves and commits entries, another peeks and releases
+// them.  Positions only increase and the consumer's fields are kept off
+// the producer's cache line.  Entries that don't fit are dropped and
+// counted.
+template<uint32 SIZE>
+class LTE_fdd_enb_ring
+{
+public:
+    static_assert(0 == (SIZE & (SIZE - 1)), "Ring size must be a power of 2");
+
+    LTE_fdd_enb_ring() :
+        write_pos{0}, N_dropped{0}, pending_pos{0}, read_pos{0},
+        N_dropped_reported{0}, closed{false} {};
+
+    // Producer
+    uint8* reserve(uint32 N_bytes)
+    {
+        uint32 size   = (sizeof(LTE_FDD_ENB_RING_ENTRY_STRUCT) + N_bytes + 7) & ~7;
+        uint64 pos    = write_pos.load(std::memory_order_relaxed);
+        uint32 offset = pos & (SIZE - 1);
+        uint32 pad    = 0;
+
+        // Pad to the end of the ring if the entry doesn't fit there
+        if(offset + size > SIZE)
+            pad = SIZE - offset;
+        if(pos + pad + size - read_pos.load(std::memory_order_acquire) > SIZE)
+        {
+            N_dropped.store(N_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return NULL;
+        }
+        if(0 != pad)
+        {
+            LTE_FDD_ENB_RING_ENTRY_STRUCT *pad_entry = (LTE_FDD_ENB_RING_ENTRY_STRUCT *)&buf[offset];
+            pad_entry->size  = pad;
+            pad_entry->pad   = 1;
+            pos             += pad;
+            offset           = 0;
+        }
+
+        LTE_FDD_ENB_RING_ENTRY_STRUCT *entry = (LTE_FDD_ENB_RING_ENTRY_STRUCT *)&buf[offset];
+        entry->size = size;
+        entry->pad  = 0;
+        pending_pos = pos + size;
+
+        return (uint8 *)(entry + 1);
+    }
+    void commit() {write_pos.store(pending_pos, std::memory_order_release);}
+    void close() {closed.store(true, std::memory_order_release);}
+
+    // Consumer
+    uint64 get_read_pos() {return read_pos.load(std::memory_order_relaxed);}
+    uint64 get_write_pos() {return write_pos.load(std::memory_order_acquire);}
+    uint8* peek(uint64 &pos, uint64 end, uint32 *size)
+    {
+        while(pos < end)
+        {
+            LTE_FDD_ENB_RING_ENTRY_STRUCT *entry = (LTE_FDD_ENB_RING_ENTRY_STRUCT *)&buf[pos & (SIZE - 1)];
+            if(0 == entry->pad)
+            {
+                *size = entry->size;
+                return (uint8 *)(entry + 1);
+            }
+            pos += entry->size;
+        }
+
+        return NULL;
+    }
+    void release(uint64 pos) {read_pos.store(pos, std::memory_order_release);}
+    uint64 get_N_dropped() {return N_dropped.load(std::memory_order_relaxed);}
+    uint64 get_N_new_dropped()
+    {
+        uint64 N     = N_dropped.load(std::memory_order_relaxed);
+        uint64 N_new = N - N_dropped_reported;
+
+        N_dropped_reported = N;
+        return N_new;
+    }
+    bool is_closed_and_drained()
+    {
+        return(closed.load(std::memory_order_acquire) &&
+               read_pos.load(std::memory_order_relaxed) == write_pos.load(std::memory_order_acquire));
+    }
+
+private:
+    // Producer
+    alignas(64) std::atomic<uint64> write_pos;
+    std::atomic<uint64>             N_dropped;
+    uint64                          pending_pos;
+
+    // Consumer
+    alignas(64) std::atomic<uint64> read_pos;
+    uint64                          N_dropped_reported;
+    std::atomic<bool>               closed;
+
+    alignas(64) uint8 buf[SIZE];
+};
+
+#endif /* __LTE_FDD_ENB_RING_H__ */
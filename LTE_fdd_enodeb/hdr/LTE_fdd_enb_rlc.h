@@ -81,6 +81,8 @@ public:
     // External interface
     void update_sys_info();
     void handle_retransmit(LIBLTE_RLC_SINGLE_AMD_PDU_STRUCT *amd, LTE_fdd_enb_user *user, LTE_fdd_enb_rb *rb);
+    uint32 get_buffer_status(LTE_fdd_enb_rb *rb);
+    LTE_FDD_ENB_ERROR_ENUM build_pdu(LTE_fdd_enb_user *user, LTE_fdd_enb_rb *rb, uint32 N_bytes, LIBLTE_BYTE_MSG_STRUCT *pdu);
 
 private:
     // Start/Stop
@@ -91,6 +93,7 @@ private:
     // Communication
     void handle_mac_msg(LTE_FDD_ENB_MESSAGE_STRUCT &msg);
     void handle_pdcp_msg(LTE_FDD_ENB_MESSAGE_STRUCT &msg);
+    void send_mac_sdu_ready(LTE_fdd_enb_user *user, LTE_fdd_enb_rb *rb);
     void send_mac_sdu_ready(LTE_fdd_enb_user *user, LTE_fdd_enb_rb *rb, LIBLTE_BYTE_MSG_STRUCT *sdu);
     void send_pdcp_pdu_ready(LTE_fdd_enb_user *user, LTE_fdd_enb_rb *rb, LIBLTE_BYTE_MSG_STRUCT *pdu);
     LTE_fdd_enb_msgq *msgq_from_mac;
@@ -108,12 +111,12 @@ private:
     // PDCP Message Handlers
     void handle_sdu_ready(LTE_FDD_ENB_RLC_SDU_READY_MSG_STRUCT *sdu_ready);
     void handle_tm_sdu(LIBLTE_BYTE_MSG_STRUCT *sdu, LTE_fdd_enb_user *user, LTE_fdd_enb_rb *rb);
-    void handle_um_sdu(LIBLTE_BYTE_MSG_STRUCT *sdu, LTE_fdd_enb_user *user, LTE_fdd_enb_rb *rb);
-    void handle_am_sdu(LIBLTE_BYTE_MSG_STRUCT *sdu, LTE_fdd_enb_user *user, LTE_fdd_enb_rb *rb);
+    void handle_um_am_sdu(LTE_fdd_enb_user *user, LTE_fdd_enb_rb *rb);
 
     // Message Constructors
     void send_status_pdu(LIBLTE_RLC_STATUS_PDU_STRUCT *status_pdu, LTE_fdd_enb_user *user, LTE_fdd_enb_rb *rb);
-    void send_amd_pdu(LIBLTE_RLC_SINGLE_AMD_PDU_STRUCT *amd, LTE_fdd_enb_user *user, LTE_fdd_enb_rb *rb);
+    LTE_FDD_ENB_ERROR_ENUM build_umd_pdu(LTE_fdd_enb_user *user, LTE_fdd_enb_rb *rb, uint32 N_bytes, LIBLTE_BYTE_MSG_STRUCT *pdu);
+    LTE_FDD_ENB_ERROR_ENUM build_amd_pdu(LTE_fdd_enb_user *user, LTE_fdd_enb_rb *rb, uint32 N_bytes, LIBLTE_BYTE_MSG_STRUCT *pdu);
 
     // Parameters
     std::mutex                  sys_info_mutex;
@@ -103,6 +103,7 @@ private:
     void handle_pdcp_msg(LTE_FDD_ENB_MESSAGE_STRUCT &msg);
     void handle_mme_msg(LTE_FDD_ENB_MESSAGE_STRUCT &msg);
     void send_pdcp_sdu_ready(LTE_fdd_enb_user *user, LTE_fdd_enb_rb *rb, std::vector<uint8_t> &sdu);
+    void send_pdcp_sdu_ready(LTE_fdd_enb_user *user, LTE_fdd_enb_rb *rb, std::vector<uint8_t> &sdu, bool activate_security);
     void send_mme_nas_msg_ready(LTE_fdd_enb_user *user, LTE_fdd_enb_rb *rb, const std::vector<uint8_t> &nas_msg);
     LTE_fdd_enb_msgq *msgq_from_pdcp;
     LTE_fdd_enb_msgq *msgq_from_mme;
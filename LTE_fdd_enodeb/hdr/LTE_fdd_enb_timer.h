@@ -82,21 +82,30 @@ class LTE_fdd_enb_timer
 {
 public:
     // Constructor/Destructor
-    LTE_fdd_enb_timer(uint32 m_seconds, uint32 _id, LTE_fdd_enb_timer_cb _cb);
+    LTE_fdd_enb_timer();
     ~LTE_fdd_enb_timer();
 
     // External interface
-    void reset();
-    void increment();
-    bool expired();
-    void call_callback();
+    void   start(uint32 m_seconds, uint32 _id, LTE_fdd_enb_timer_cb _cb, uint64 current_tick);
+    void   reset(uint64 current_tick);
+    bool   expired(uint64 current_tick);
+    uint64 get_expiry_tick();
+    uint32 get_id();
+    void   call_callback();
+
+    // Timer wheel linkage, owned by LTE_fdd_enb_timer_mgr
+    uint32 prev;
+    uint32 next;
+    uint16 wheel_idx;
+    uint16 generation;
+    bool   in_use;
 
 private:
     // Identity
     LTE_fdd_enb_timer_cb cb;
     uint32               id;
     uint32               expiry_m_seconds;
-    uint32               current_m_seconds;
+    uint64               expiry_tick;
 };
 
 #endif /* __LTE_FDD_ENB_TIMER_H__ */
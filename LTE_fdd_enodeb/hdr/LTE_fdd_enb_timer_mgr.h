@@ -45,6 +45,7 @@
 #include "LTE_fdd_enb_timer.h"
 #include "LTE_fdd_enb_msgq.h"
 #include <mutex>
+#include <vector>
 
 /*******************************************************************************
                               DEFINES
@@ -52,6 +53,17 @@
 
 #define LTE_FDD_ENB_INVALID_TIMER_ID 0xFFFFFFFF
 
+// Timer wheel, each level covers 8 more bits of expiry time
+#define LTE_FDD_ENB_TIMER_WHEEL_N_LEVELS    4
+#define LTE_FDD_ENB_TIMER_WHEEL_N_SLOT_BITS 8
+#define LTE_FDD_ENB_TIMER_WHEEL_N_SLOTS     (1 << LTE_FDD_ENB_TIMER_WHEEL_N_SLOT_BITS)
+
+// Timer ids are the pool index in the low 16 bits and the pool entry
+// generation in the high 16 bits, index 0xFFFF is never allocated
+#define LTE_FDD_ENB_TIMER_POOL_MAX_SIZE 0xFFFF
+#define LTE_FDD_ENB_TIMER_NULL_IDX      0xFFFFFFFF
+#define LTE_FDD_ENB_TIMER_NULL_WHEEL    0xFFFF
+
 /*******************************************************************************
                               FORWARD DECLARATIONS
 *******************************************************************************/
@@ -81,6 +93,9 @@ public:
     LTE_FDD_ENB_ERROR_ENUM stop_timer(uint32 timer_id);
     LTE_FDD_ENB_ERROR_ENUM reset_timer(uint32 timer_id);
 
+    // One millisecond tick, normally sent by the MAC through msgq_from_mac
+    void handle_tick();
+
 private:
     // Start/Stop
     LTE_fdd_enb_interface *interface;
@@ -89,13 +104,19 @@ private:
 
     // Communication
     void handle_msg(LTE_FDD_ENB_MESSAGE_STRUCT &msg);
-    void handle_tick();
     LTE_fdd_enb_msgq *msgq_from_mac;
 
     // Timer Storage
-    std::mutex                           timer_mutex;
-    std::map<uint32, LTE_fdd_enb_timer*> timer_map;
-    uint32                               next_timer_id;
+    LTE_fdd_enb_timer* find_timer(uint32 timer_id);
+    void wheel_insert(uint32 idx);
+    void wheel_remove(uint32 idx);
+    void free_timer(uint32 idx);
+    std::mutex                     timer_mutex;
+    std::vector<LTE_fdd_enb_timer> timer_pool;
+    std::vector<uint32>            expired_timer_ids;
+    uint32                         timer_wheel[LTE_FDD_ENB_TIMER_WHEEL_N_LEVELS][LTE_FDD_ENB_TIMER_WHEEL_N_SLOTS];
+    uint32                         free_timer_idx;
+    uint64                         current_tick;
 };
 
 #endif /* __LTE_FDD_ENB_TIMER_MGR_H__ */
@@ -58,9 +58,11 @@
 #include "liblte_phy.h"
 #include "liblte_mac.h"
 #include "liblte_mme.h"
+#include "liblte_security.h"
 #include "typedefs.h"
 #include <string>
 #include <mutex>
+#include <list>
 
 /*******************************************************************************
                               DEFINES
@@ -68,6 +70,27 @@
 
 #define LTE_FDD_ENB_USER_INACTIVITY_TIMER_VALUE_MS 10000
 
+// DL link adaptation from H-ARQ feedback, each ACK raises the MCS by
+// STEP_UP and each NACK lowers it by STEP_UP*(1-BLER)/BLER so that
+// the MCS settles where the BLER meets the target
+#define LTE_FDD_ENB_USER_DL_MCS_MAX         28
+#define LTE_FDD_ENB_USER_DL_MCS_STEP_UP     0.1
+#define LTE_FDD_ENB_USER_DL_MCS_TARGET_BLER 0.1
+
+// UL link adaptation from the PUSCH DMRS SINR, filtered with weight
+// SINR_ALPHA, less an outer loop offset that each CRC failure raises
+// by OLLA_STEP_DB and each CRC pass lowers by OLLA_STEP_DB*BLER/(1-BLER).
+// MCS_MAX stays within 16QAM, which every UE category supports
+#define LTE_FDD_ENB_USER_UL_MCS_MAX         20
+#define LTE_FDD_ENB_USER_UL_SINR_ALPHA      0.1
+#define LTE_FDD_ENB_USER_UL_OLLA_STEP_DB    0.5
+#define LTE_FDD_ENB_USER_UL_OLLA_MAX_DB     10
+#define LTE_FDD_ENB_USER_UL_MCS_TARGET_BLER 0.1
+
+// H-ARQ processes are indexed directly by H-ARQ process ID, UL
+// processes are synchronous so the ID is the TTI modulo 8
+#define LTE_FDD_ENB_USER_N_HARQ_PROCESSES 8
+
 /*******************************************************************************
                               FORWARD DECLARATIONS
 *******************************************************************************/
@@ -86,23 +109,51 @@ typedef struct{
 }LTE_FDD_ENB_USER_ID_STRUCT;
 
 typedef struct{
-    uint32 nas_count_ul;
-    uint32 nas_count_dl;
-    uint8  rand[16];
-    uint8  res[8];
-    uint8  ck[16];
-    uint8  ik[16];
-    uint8  autn[16];
-    uint8  k_nas_enc[32];
-    uint8  k_nas_int[32];
-    uint8  k_rrc_enc[32];
-    uint8  k_rrc_int[32];
+    LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_ENUM eea;
+    LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_ENUM eia;
+    uint32                                      nas_count_ul;
+    uint32                                      nas_count_dl;
+    uint8                                       rand[16];
+    uint8                                       res[8];
+    uint8                                       ck[16];
+    uint8                                       ik[16];
+    uint8                                       autn[16];
+    uint8                                       k_nas_enc[32];
+    uint8                                       k_nas_int[32];
+    uint8                                       k_enb[32];
+    uint8                                       k_rrc_enc[32];
+    uint8                                       k_rrc_int[32];
+    uint8                                       k_up_enc[32];
+    uint8                                       k_up_int[32];
 }LTE_FDD_ENB_AUTHENTICATION_VECTOR_STRUCT;
 
+// Redundancy version of each transmission, 36.321 v10.1.0 section 5.4.2.2
+static const uint32 LTE_fdd_enb_harq_rv_idx[4] = {0, 2, 3, 1};
+
+typedef struct{
+    LIBLTE_PHY_MODULATION_TYPE_ENUM mod_type;
+    uint32                          tbs;
+    uint32                          N_prb;
+    uint32                          pucch_tti;
+    uint32                          harq_retx_count;
+    uint8                           tb[LIBLTE_MAX_MSG_SIZE];
+    uint8                           mcs;
+    bool                            ndi;
+    bool                            active;
+}LTE_FDD_ENB_DL_HARQ_PROC_STRUCT;
+
 typedef struct{
-    LIBLTE_MAC_PDU_STRUCT        mac_pdu;
-    LIBLTE_PHY_ALLOCATION_STRUCT alloc;
-}LTE_FDD_ENB_HARQ_INFO_STRUCT;
+    LIBLTE_PHY_SOFT_BUFFER_STRUCT   *soft_buffer;
+    LIBLTE_PHY_MODULATION_TYPE_ENUM  mod_type;
+    uint32                           tbs;
+    uint32                           N_prb;
+    uint32                           prb_start;
+    uint32                           current_tti;
+    uint32                           N_tx;
+    uint8                            mcs;
+    bool                             ndi;
+    bool                             active;
+}LTE_FDD_ENB_UL_HARQ_PROC_STRUCT;
 
 /*******************************************************************************
                               CLASS DECLARATIONS
@@ -192,25 +243,44 @@ public:
     LIBLTE_MME_PROTOCOL_CONFIG_OPTIONS_STRUCT* get_protocol_cnfg_opts();
 
     // MAC
-    uint8 get_harq_process();
-    void increment_harq_process();
-    void store_harq_info(uint32 pucch_tti, LIBLTE_MAC_PDU_STRUCT *mac_pdu, LIBLTE_PHY_ALLOCATION_STRUCT *alloc);
-    void clear_harq_info(uint32 pucch_tti);
-    LTE_FDD_ENB_ERROR_ENUM get_harq_info(uint32 pucch_tti, LIBLTE_MAC_PDU_STRUCT *mac_pdu, LIBLTE_PHY_ALLOCATION_STRUCT *alloc);
+    LTE_FDD_ENB_ERROR_ENUM get_free_harq_process(uint8 *harq_process, bool *ndi);
+    void store_harq_info(uint32 pucch_tti, LIBLTE_PHY_ALLOCATION_STRUCT *alloc);
+    void clear_harq_info(uint8 harq_process);
+    LTE_FDD_ENB_ERROR_ENUM get_harq_info(uint32 pucch_tti, uint8 *harq_process, uint32 *harq_retx_count);
+    LTE_FDD_ENB_ERROR_ENUM get_harq_retx_alloc(uint8 harq_process, LIBLTE_PHY_ALLOCATION_STRUCT *alloc);
+    LTE_FDD_ENB_UL_HARQ_PROC_STRUCT* get_ul_harq_proc(uint32 current_tti);
     void set_ul_buffer_size(uint32 N_bytes_in_buffer);
-    void update_ul_buffer_size(uint32 N_bytes_received);
+    void update_ul_buffer_size(uint32 N_bytes_granted);
     uint32 get_ul_buffer_size();
+    uint8 get_ul_mcs();
+    void update_ul_mcs(float sinr_db, bool crc_pass);
+    void set_ul_avg_thruput(float avg_thruput);
+    float get_ul_avg_thruput();
+    void set_ul_last_tti(uint32 tti);
+    uint32 get_ul_last_tti();
     uint8 get_mcs();
+    uint8 get_dl_mcs();
+    void update_dl_mcs(bool ack);
+    void set_dl_avg_thruput(float avg_thruput);
+    float get_dl_avg_thruput();
+    void set_dl_last_tti(uint32 tti);
+    uint32 get_dl_last_tti();
+    void set_ta_command_tti(uint32 tti);
+    uint32 get_ta_command_tti();
 
     // Generic
     void set_N_del_ticks(uint32 N_ticks);
     uint32 get_N_del_ticks();
-    uint32 get_max_ul_bytes_per_subfn();
-    uint32 get_max_dl_bytes_per_subfn();
     void start_inactivity_timer(uint32 m_seconds);
     void reset_inactivity_timer(uint32 m_seconds);
     void stop_inactivity_timer();
 
+    // User manager, the user's place in the user list and the order it
+    // was added in, 0 when it isn't in the list
+    void set_user_list_entry(std::list<LTE_fdd_enb_user*>::iterator it, uint64 seq);
+    std::list<LTE_fdd_enb_user*>::iterator get_user_list_it();
+    uint64 get_user_seq();
+
 private:
     // Identity
     LTE_FDD_ENB_USER_ID_STRUCT           id;
@@ -253,11 +323,20 @@ private:
     bool                                      eit_flag;
 
     // MAC
-    std::mutex                                      harq_buffer_mutex;
-    std::map<uint32, LTE_FDD_ENB_HARQ_INFO_STRUCT*> harq_buffer;
-    uint32                                          ul_buffer_size;
-    uint8                                           harq_process;
-    uint8                                           mcs;
+    std::mutex                      harq_mutex;
+    LTE_FDD_ENB_DL_HARQ_PROC_STRUCT dl_harq[LTE_FDD_ENB_USER_N_HARQ_PROCESSES];
+    LTE_FDD_ENB_UL_HARQ_PROC_STRUCT ul_harq[LTE_FDD_ENB_USER_N_HARQ_PROCESSES];
+    uint32                          ul_buffer_size;
+    uint32                          ta_command_tti;
+    uint32                          dl_last_tti;
+    float                           dl_avg_thruput;
+    float                           dl_mcs_olla;
+    uint32                          ul_last_tti;
+    float                           ul_avg_thruput;
+    float                           ul_sinr_db;
+    float                           ul_olla_db;
+    uint8                           next_harq_process;
+    uint8                           mcs;
 
     // Generic
     void handle_timer_expiry(uint32 timer_id);
@@ -267,6 +346,10 @@ private:
     LTE_fdd_enb_rlc       *rlc;
     uint32                 N_del_ticks;
     uint32                 inactivity_timer_id;
+
+    // User manager
+    std::list<LTE_fdd_enb_user*>::iterator user_list_it;
+    uint64                                 user_seq;
 };
 
 #endif /* __LTE_FDD_ENB_USER_H__ */
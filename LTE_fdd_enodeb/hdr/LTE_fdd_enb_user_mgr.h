@@ -51,11 +51,16 @@
 #include "LTE_fdd_enb_user.h"
 #include <string>
 #include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
 
 /*******************************************************************************
                               DEFINES
 *******************************************************************************/
 
+// A released user's soft buffers can still be in UL schedules queued
+// to the PHY, which runs up to 10 subframes behind the MAC's scheduling
+#define LTE_FDD_ENB_USER_MGR_SOFT_BUFFER_HOLD_TTIS 12
 
 /*******************************************************************************
                               FORWARD DECLARATIONS
@@ -78,7 +83,6 @@ public:
     ~LTE_fdd_enb_user_mgr();
 
     // External interface
-    LTE_FDD_ENB_ERROR_ENUM assign_c_rnti(LTE_fdd_enb_user *user, uint16 *c_rnti);
     LTE_FDD_ENB_ERROR_ENUM release_c_rnti(uint16 c_rnti);
     LTE_FDD_ENB_ERROR_ENUM transfer_c_rnti(LTE_fdd_enb_user *old_user, LTE_fdd_enb_user *new_user);
     LTE_FDD_ENB_ERROR_ENUM reset_c_rnti_timer(uint16 c_rnti);
@@ -93,25 +97,69 @@ public:
     LTE_FDD_ENB_ERROR_ENUM del_user(std::string imsi);
     LTE_FDD_ENB_ERROR_ENUM del_user(uint16 c_rnti);
     LTE_FDD_ENB_ERROR_ENUM del_user(LIBLTE_MME_EPS_MOBILE_ID_GUTI_STRUCT *guti);
+    void set_user_id(LTE_fdd_enb_user *user, LTE_FDD_ENB_USER_ID_STRUCT *identity);
+    void set_user_guti(LTE_fdd_enb_user *user, LIBLTE_MME_EPS_MOBILE_ID_GUTI_STRUCT *guti);
+    void set_user_ip_addr(LTE_fdd_enb_user *user, uint32 ip_addr);
+    void prepare_user_for_deletion(LTE_fdd_enb_user *user);
     std::string print_all_users();
 
+    // UL H-ARQ soft buffers
+    void set_max_users(uint32 N_users);
+    LIBLTE_PHY_SOFT_BUFFER_STRUCT* alloc_soft_buffer();
+    void free_soft_buffer(LIBLTE_PHY_SOFT_BUFFER_STRUCT *soft_buffer);
+    void reclaim_soft_buffers();
+
 private:
     // C-RNTI Timer
     void handle_c_rnti_timer_expiry(uint32 timer_id);
 
+    // User indexes, callers must hold user_mutex exclusively
+    LTE_FDD_ENB_ERROR_ENUM assign_c_rnti(LTE_fdd_enb_user *user);
+    void free_c_rnti(LTE_fdd_enb_user *user);
+    void index_user(LTE_fdd_enb_user *user);
+    void unindex_user(LTE_fdd_enb_user *user);
+    template<class INDEX, class KEY>
+    void erase_index_entry(INDEX &index, KEY key, LTE_fdd_enb_user *user);
+    template<class INDEX, class KEY, class MATCH>
+    LTE_fdd_enb_user* first_user(INDEX &index, KEY key, MATCH match);
+    void remove_user(LTE_fdd_enb_user *user);
+    void release_soft_buffers(LTE_fdd_enb_user *user);
+    bool guti_match(LIBLTE_MME_EPS_MOBILE_ID_GUTI_STRUCT *a, LIBLTE_MME_EPS_MOBILE_ID_GUTI_STRUCT *b);
+
     // User storage
     LTE_fdd_enb_interface               *interface;
     LTE_fdd_enb_timer_mgr               *timer_mgr;
     std::list<LTE_fdd_enb_user*>         user_list;
     std::list<LTE_fdd_enb_user*>         delayed_del_user_list;
-    std::map<uint16, LTE_fdd_enb_user*>  c_rnti_map;
     std::map<uint32, uint16>             timer_id_map_forward;
     std::map<uint16, uint32>             timer_id_map_reverse;
-    std::mutex                           user_mutex;
-    std::mutex                           c_rnti_mutex;
+    std::shared_timed_mutex              user_mutex;
     std::mutex                           timer_id_mutex;
     uint32                               next_m_tmsi;
     uint16                               next_c_rnti;
+    uint64                               next_user_seq;
+
+    // User indexes, protected by user_mutex.  A C-RNTI has one owner,
+    // the other keys can be shared and resolve to the user added first.
+    std::unordered_multimap<uint64, LTE_fdd_enb_user*> imsi_index;
+    std::unordered_multimap<uint32, LTE_fdd_enb_user*> m_tmsi_index;
+    std::unordered_multimap<uint32, LTE_fdd_enb_user*> ip_addr_index;
+    std::unordered_map<uint16, LTE_fdd_enb_user*>      c_rnti_index;
+
+    // UL H-ARQ soft buffer slab, one buffer holds every code block of
+    // a transport block and there is one per process of each of the
+    // configured users.  Allocated at start and handed out from a free
+    // stack so the per-TTI path never allocates.  Once they run out new
+    // transmissions are decoded without combining.
+    std::mutex                      soft_buffer_mutex;
+    LIBLTE_PHY_SOFT_BUFFER_STRUCT  *soft_buffer_slab;
+    LIBLTE_PHY_SOFT_BUFFER_STRUCT **free_soft_buffers;
+    LIBLTE_PHY_SOFT_BUFFER_STRUCT **held_soft_buffers;
+    uint32                         *held_soft_buffer_tti;
+    uint32                          N_soft_buffers;
+    uint32                          N_free_soft_buffers;
+    uint32                          N_held_soft_buffers;
+    uint32                          soft_buffer_tti;
 };
 
 #endif /* __LTE_FDD_ENB_USER_MGR_H__ */
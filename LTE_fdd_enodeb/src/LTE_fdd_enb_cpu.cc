@@ -0,0 +1,393 @@
+#line 2 "LTE_fdd_enb_cpu.cc" // Make __FILE__ omit the path
+/*******************************************************************************
+
+    Copyright 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************
+
+    File: LTE_fdd_enb_cpu.cc
+
+    Description: Contains all the implementations for the LTE FDD eNodeB
+                 CPU placement.
+
+    Revision History
+    ----------    -------------    --------------------------------------------
+    10/18/2026    agent            Created file.
+
+*******************************************************************************/
+
+/*******************************************************************************
+                              INCLUDES
+*******************************************************************************/
+
+#include "LTE_fdd_enb_cpu.h"
+#include "libtools_helpers.h"
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <string.h>
+#include <stdio.h>
+#include <thread>
+
+/*******************************************************************************
+                              DEFINES
+*******************************************************************************/
+
+#define SYS_NODE_DIR "/sys/devices/system/node"
+
+// Nodes that fit in the single word mbind mask
+#define MAX_N_NODES (sizeof(unsigned long)*8)
+
+// Cores the default placement keeps for the GW, one per TUN queue
+#define N_DEFAULT_GW_CORES 2
+
+/*******************************************************************************
+                              TYPEDEFS
+*******************************************************************************/
+
+
+/*******************************************************************************
+                              GLOBAL VARIABLES
+*******************************************************************************/
+
+
+/*******************************************************************************
+                              LOCAL FUNCTIONS
+*******************************************************************************/
+
+static size_t round_up_to_huge_page(size_t size)
+{
+    return (size + LTE_FDD_ENB_CPU_HUGE_PAGE_SIZE - 1) & ~((size_t)LTE_FDD_ENB_CPU_HUGE_PAGE_SIZE - 1);
+}
+
+static int sched_policy(LTE_FDD_ENB_THREAD_POLICY_ENUM policy)
+{
+    switch(policy)
+    {
+    case LTE_FDD_ENB_THREAD_POLICY_FIFO:
+        return SCHED_FIFO;
+    case LTE_FDD_ENB_THREAD_POLICY_RR:
+        return SCHED_RR;
+    default:
+        return SCHED_OTHER;
+    }
+}
+
+/*******************************************************************************
+                              CLASS IMPLEMENTATIONS
+*******************************************************************************/
+
+/********************************/
+/*    Constructor/Destructor    */
+/********************************/
+LTE_fdd_enb_cpu::LTE_fdd_enb_cpu() :
+    N_cpus{std::thread::hardware_concurrency()}, N_nodes{0}
+{
+    // Map every core to its NUMA node
+    cpu_node.assign(N_cpus, -1);
+    DIR *dir = opendir(SYS_NODE_DIR);
+    if(NULL != dir)
+    {
+        struct dirent *entry;
+        while(NULL != (entry = readdir(dir)))
+        {
+            uint32 node;
+            if(1 != sscanf(entry->d_name, "node%u", &node) || node >= MAX_N_NODES)
+                continue;
+            std::string file_name = std::string(SYS_NODE_DIR) + "/" + entry->d_name + "/cpulist";
+            FILE       *file      = fopen(file_name.c_str(), "r");
+            char        str[1024];
+            cpu_set_t   cores;
+            if(NULL == file)
+                continue;
+            if(NULL != fgets(str, sizeof(str), file) &&
+               string_to_cores(std::string(str).substr(0, strcspn(str, "\n")), &cores))
+            {
+                for(uint32 i=0; i<N_cpus; i++)
+                    if(CPU_ISSET(i, &cores))
+                        cpu_node[i] = node;
+                N_nodes++;
+            }
+            fclose(file);
+        }
+        closedir(dir);
+    }
+
+    // Default placement, the last core is for PHY/Radio, the second
+    // to last is for MAC, and the rest of the stack is below that
+    for(uint32 i=0; i<LTE_FDD_ENB_THREAD_ROLE_N_ITEMS; i++)
+    {
+        CPU_ZERO(&thread_cnfg[i].cores);
+        thread_cnfg[i].policy = LTE_FDD_ENB_THREAD_POLICY_OTHER;
+        thread_cnfg[i].prio   = 0;
+    }
+    if(N_cpus > 0)
+        CPU_SET(N_cpus-1, &thread_cnfg[LTE_FDD_ENB_THREAD_ROLE_RADIO].cores);
+    thread_cnfg[LTE_FDD_ENB_THREAD_ROLE_RADIO].policy = LTE_FDD_ENB_THREAD_POLICY_FIFO;
+    thread_cnfg[LTE_FDD_ENB_THREAD_ROLE_RADIO].prio   = sched_get_priority_max(SCHED_FIFO);
+    if(N_cpus > 1)
+        CPU_SET(N_cpus-2, &thread_cnfg[LTE_FDD_ENB_THREAD_ROLE_MAC].cores);
+    thread_cnfg[LTE_FDD_ENB_THREAD_ROLE_MAC].policy = LTE_FDD_ENB_THREAD_POLICY_FIFO;
+    thread_cnfg[LTE_FDD_ENB_THREAD_ROLE_MAC].prio   = sched_get_priority_max(SCHED_FIFO);
+    if(N_cpus > 2)
+        CPU_SET(N_cpus-3, &thread_cnfg[LTE_FDD_ENB_THREAD_ROLE_MSGQ].cores);
+    for(uint32 i=0; i<N_DEFAULT_GW_CORES; i++)
+        if(N_cpus > 3 + i)
+            CPU_SET(N_cpus-3-i, &thread_cnfg[LTE_FDD_ENB_THREAD_ROLE_GW].cores);
+}
+LTE_fdd_enb_cpu::~LTE_fdd_enb_cpu()
+{
+}
+
+/******************/
+/*    Topology    */
+/******************/
+std::string LTE_fdd_enb_cpu::get_topology_string()
+{
+    std::string str;
+
+    for(uint32 node=0; node<MAX_N_NODES; node++)
+    {
+        cpu_set_t cores;
+        CPU_ZERO(&cores);
+        for(uint32 i=0; i<N_cpus; i++)
+            if(cpu_node[i] == (int32)node)
+                CPU_SET(i, &cores);
+        if(0 != CPU_COUNT(&cores))
+            str += "node" + std::to_string(node) + ":" + cores_to_string(&cores) + " ";
+    }
+    if(0 == str.length())
+        return std::to_string(N_cpus) + " cores, no NUMA information";
+    return str.substr(0, str.length()-1);
+}
+int32 LTE_fdd_enb_cpu::get_node(LTE_FDD_ENB_THREAD_ROLE_ENUM role)
+{
+    std::lock_guard<std::mutex> lock(cnfg_mutex);
+
+    // Nothing to choose between on a single node
+    if(N_nodes < 2)
+        return -1;
+    for(uint32 i=0; i<N_cpus; i++)
+        if(CPU_ISSET(i, &thread_cnfg[role].cores))
+            return cpu_node[i];
+    return -1;
+}
+void LTE_fdd_enb_cpu::bind_to_node(void   *buf,
+                                   size_t  size,
+                                   int32   node,
+                                   bool    move)
+{
+    unsigned long mask = 1UL << node;
+
+    if(node < 0)
+        return;
+
+    // Preferred rather than bound so an exhausted node falls back
+    // instead of failing page faults
+    syscall(SYS_mbind, buf, size, MPOL_PREFERRED, &mask, MAX_N_NODES, move ? MPOL_MF_MOVE : 0);
+}
+std::string LTE_fdd_enb_cpu::cores_to_string(const cpu_set_t *cores)
+{
+    std::string str;
+    uint32      i = 0;
+
+    while(i < CPU_SETSIZE)
+    {
+        if(!CPU_ISSET(i, cores))
+        {
+            i++;
+            continue;
+        }
+        uint32 first = i;
+        while(i+1 < CPU_SETSIZE && CPU_ISSET(i+1, cores))
+            i++;
+        str += std::to_string(first);
+        if(i != first)
+            str += "-" + std::to_string(i);
+        str += ",";
+        i++;
+    }
+    if(0 == str.length())
+        return "none";
+    return str.substr(0, str.length()-1);
+}
+bool LTE_fdd_enb_cpu::string_to_cores(std::string  str,
+                                      cpu_set_t   *cores)
+{
+    CPU_ZERO(cores);
+    if("none" == str)
+        return true;
+
+    // Comma separated cores and ranges of cores, e.g. 2,4-7
+    while(0 != str.length())
+    {
+        std::string item = str.substr(0, str.find(","));
+        size_t      dash = item.find("-");
+        int64       first;
+        int64       last;
+        if(std::string::npos == dash)
+        {
+            if(to_number(item, first, 0, CPU_SETSIZE-1))
+                return false;
+            last = first;
+        }else if(to_number(item.substr(0, dash), first, 0, CPU_SETSIZE-1) ||
+                 to_number(item.substr(dash+1), last, first, CPU_SETSIZE-1)){
+            return false;
+        }
+        for(int64 i=first; i<=last; i++)
+            CPU_SET(i, cores);
+        if(std::string::npos == str.find(","))
+            break;
+        str = str.substr(str.find(",")+1);
+    }
+    return true;
+}
+
+/*****************/
+/*    Threads    */
+/*****************/
+std::string LTE_fdd_enb_cpu::get_thread_cnfg_string(LTE_FDD_ENB_THREAD_ROLE_ENUM role)
+{
+    std::lock_guard<std::mutex> lock(cnfg_mutex);
+
+    return(cores_to_string(&thread_cnfg[role].cores) + "/" +
+           LTE_fdd_enb_thread_policy_text[thread_cnfg[role].policy] + "/" +
+           std::to_string(thread_cnfg[role].prio));
+}
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_cpu::set_thread_cnfg(LTE_FDD_ENB_THREAD_ROLE_ENUM role,
+                                                        std::string                  cnfg)
+{
+    LTE_FDD_ENB_THREAD_CNFG_STRUCT new_cnfg;
+    size_t                         first  = cnfg.find("/");
+    size_t                         second = cnfg.find("/", first + 1);
+    int64                          prio;
+    uint32                         i;
+
+    // <cores>/<policy>/<priority>, e.g. 4-5/fifo/90 or none/other/0
+    if(std::string::npos == first || std::string::npos == second)
+        return LTE_FDD_ENB_ERROR_INVALID_PARAM;
+    if(!string_to_cores(cnfg.substr(0, first), &new_cnfg.cores))
+        return LTE_FDD_ENB_ERROR_INVALID_PARAM;
+    for(i=N_cpus; i<CPU_SETSIZE; i++)
+        if(CPU_ISSET(i, &new_cnfg.cores))
+            return LTE_FDD_ENB_ERROR_OUT_OF_BOUNDS;
+    for(i=0; i<LTE_FDD_ENB_THREAD_POLICY_N_ITEMS; i++)
+        if(cnfg.substr(first + 1, second - first - 1) == LTE_fdd_enb_thread_policy_text[i])
+            break;
+    if(LTE_FDD_ENB_THREAD_POLICY_N_ITEMS == i)
+        return LTE_FDD_ENB_ERROR_INVALID_PARAM;
+    new_cnfg.policy = (LTE_FDD_ENB_THREAD_POLICY_ENUM)i;
+    if(to_number(cnfg.substr(second + 1),
+                 prio,
+                 sched_get_priority_min(sched_policy(new_cnfg.policy)),
+                 sched_get_priority_max(sched_policy(new_cnfg.policy))))
+        return LTE_FDD_ENB_ERROR_OUT_OF_BOUNDS;
+    new_cnfg.prio = prio;
+
+    std::lock_guard<std::mutex> lock(cnfg_mutex);
+    thread_cnfg[role] = new_cnfg;
+    return LTE_FDD_ENB_ERROR_NONE;
+}
+void LTE_fdd_enb_cpu::place_thread(LTE_FDD_ENB_THREAD_ROLE_ENUM role,
+                                   uint32                       idx)
+{
+    LTE_FDD_ENB_THREAD_CNFG_STRUCT cnfg;
+    struct sched_param             param;
+    cpu_set_t                      af_mask;
+
+    cnfg_mutex.lock();
+    cnfg = thread_cnfg[role];
+    cnfg_mutex.unlock();
+
+    // Thread idx of a role gets the idx-th highest core of the set
+    // to itself, wrapping if there are more threads than cores
+    af_mask = cnfg.cores;
+    if(LTE_FDD_ENB_CPU_ALL_CORES != idx && 0 != CPU_COUNT(&cnfg.cores))
+    {
+        uint32 target = idx % CPU_COUNT(&cnfg.cores);
+        CPU_ZERO(&af_mask);
+        for(int32 i=CPU_SETSIZE-1; i>=0; i--)
+            if(CPU_ISSET(i, &cnfg.cores) && 0 == target--)
+            {
+                CPU_SET(i, &af_mask);
+                break;
+            }
+    }
+    if(0 != CPU_COUNT(&af_mask))
+        pthread_setaffinity_np(pthread_self(), sizeof(af_mask), &af_mask);
+
+    param.sched_priority = cnfg.prio;
+    pthread_setschedparam(pthread_self(), sched_policy(cnfg.policy), &param);
+}
+
+/****************/
+/*    Memory    */
+/****************/
+void* LTE_fdd_enb_cpu::alloc_buf(LTE_FDD_ENB_THREAD_ROLE_ENUM role,
+                                 size_t                       size,
+                                 bool                         hugetlb)
+{
+    size_t  len = round_up_to_huge_page(size);
+    uint8  *buf = (uint8 *)MAP_FAILED;
+
+    // Reserved huge pages first, they are committed up front so only
+    // buffers that are fully used should ask for them
+    if(hugetlb)
+        buf = (uint8 *)mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+    // Otherwise a huge page aligned mapping for transparent huge pages
+    if(MAP_FAILED == buf)
+    {
+        uint8 *raw = (uint8 *)mmap(NULL, len + LTE_FDD_ENB_CPU_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(MAP_FAILED == raw)
+            return NULL;
+        buf = (uint8 *)(((uintptr_t)raw + LTE_FDD_ENB_CPU_HUGE_PAGE_SIZE - 1) & ~((uintptr_t)LTE_FDD_ENB_CPU_HUGE_PAGE_SIZE - 1));
+        if(buf != raw)
+            munmap(raw, buf - raw);
+        if(buf + len != raw + len + LTE_FDD_ENB_CPU_HUGE_PAGE_SIZE)
+            munmap(buf + len, raw + LTE_FDD_ENB_CPU_HUGE_PAGE_SIZE - buf);
+        madvise(buf, len, MADV_HUGEPAGE);
+    }
+
+    // Nothing has been touched yet, so the policy places every page
+    bind_to_node(buf, len, get_node(role), false);
+
+    return buf;
+}
+void LTE_fdd_enb_cpu::free_buf(void   *buf,
+                               size_t  size)
+{
+    if(NULL != buf)
+        munmap(buf, round_up_to_huge_page(size));
+}
+void LTE_fdd_enb_cpu::place_buf(LTE_FDD_ENB_THREAD_ROLE_ENUM  role,
+                                void                         *buf,
+                                size_t                        size)
+{
+    uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    uintptr_t start     = ((uintptr_t)buf + page_size - 1) & ~(page_size - 1);
+    uintptr_t end       = ((uintptr_t)buf + size) & ~(page_size - 1);
+
+    // Buffers from other allocators, only whole pages inside the
+    // buffer are touched, pages already in use are migrated
+    if(end <= start)
+        return;
+    madvise((void *)start, end - start, MADV_HUGEPAGE);
+    bind_to_node((void *)start, end - start, get_node(role), true);
+}
@@ -0,0 +1,478 @@
+#line 2 "LTE_fdd_enb_debug_log.cc" // Make __FILE__ omit the path
+/*******************************************************************************
+
+    Copyright 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************
+
+    File: LTE_fdd_enb_debug_log.cc
+
+    Description: Contains all the implementations for the LTE FDD eNodeB
+                 debug log.
+
+    Revision History
+    ----------    -------------    --------------------------------------------
+    10/18/2026    agent            Created file.
+
+*******************************************************************************/
+
+/*******************************************************************************
+                              INCLUDES
+*******************************************************************************/
+
+#include "LTE_fdd_enb_debug_log.h"
+#include "LTE_fdd_enb_interface.h"
+#include "libtools_helpers.h"
+#include <string.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+/*******************************************************************************
+                              DEFINES
+*******************************************************************************/
+
+// Records formatted per send to the debug socket
+#define LTE_FDD_ENB_DEBUG_LOG_MAX_BATCH 1024
+
+/*******************************************************************************
+                              TYPEDEFS
+*******************************************************************************/
+
+// Ring of the calling thread, marked closed when the thread exits so
+// the background thread frees it once it has been drained
+class LTE_fdd_enb_debug_log_thread_ring
+{
+public:
+    ~LTE_fdd_enb_debug_log_thread_ring();
+
+    LTE_fdd_enb_debug_log      *owner = NULL;
+    LTE_fdd_enb_debug_log_ring *ring  = NULL;
+};
+
+/*******************************************************************************
+                              GLOBAL VARIABLES
+*******************************************************************************/
+
+static std::atomic<LTE_fdd_enb_debug_log *>               active_debug_log{NULL};
+static thread_local LTE_fdd_enb_debug_log_thread_ring     thread_ring;
+
+/*******************************************************************************
+                              LOCAL FUNCTIONS
+*******************************************************************************/
+
+static void append_printf(std::string &str, const char *fmt, ...)
+{
+    va_list args;
+    char    tmp[256];
+
+    va_start(args, fmt);
+    int32 N = vsnprintf(tmp, sizeof(tmp), fmt, args);
+    va_end(args);
+    if(N < 0)
+        return;
+    if(N < (int32)sizeof(tmp))
+    {
+        str.append(tmp, N);
+        return;
+    }
+
+    // Too long for the stack buffer, format straight into the string
+    uint32 len = str.size();
+    str.resize(len + N + 1);
+    va_start(args, fmt);
+    vsnprintf(&str[len], N + 1, fmt, args);
+    va_end(args);
+    str.resize(len + N);
+}
+
+/*******************************************************************************
+                              CLASS IMPLEMENTATIONS
+*******************************************************************************/
+
+LTE_fdd_enb_debug_log_thread_ring::~LTE_fdd_enb_debug_log_thread_ring()
+{
+    if(NULL != ring && owner == active_debug_log.load())
+        ring->close();
+}
+
+/********************************/
+/*    Constructor/Destructor    */
+/********************************/
+LTE_fdd_enb_debug_log::LTE_fdd_enb_debug_log(LTE_fdd_enb_interface *iface) :
+    interface{iface}, thread_run{true}
+{
+    active_debug_log = this;
+    thread           = new std::thread(log_thread, this);
+}
+LTE_fdd_enb_debug_log::~LTE_fdd_enb_debug_log()
+{
+    thread_run = false;
+    thread->join();
+    delete thread;
+    active_debug_log = NULL;
+
+    std::lock_guard<std::mutex> lock(ring_mutex);
+    for(auto ring : rings)
+        delete ring;
+}
+
+/*****************/
+/*    Logging    */
+/*****************/
+void LTE_fdd_enb_debug_log::write_record(uint8                                 type,
+                                         uint8                                 level,
+                                         const char                           *file_name,
+                                         int32                                 line,
+                                         LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_STRUCT *payload,
+                                         const char                           *fmt,
+                                         LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT     *arg,
+                                         uint32                                N_args)
+{
+    LTE_fdd_enb_debug_log_ring          *ring = get_thread_ring();
+    LTE_FDD_ENB_DEBUG_LOG_RECORD_STRUCT *rec;
+
+    // Size the record
+    uint32 size = sizeof(LTE_FDD_ENB_DEBUG_LOG_RECORD_STRUCT) + N_args*sizeof(LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT);
+    for(uint32 i=0; i<N_args; i++)
+    {
+        if(LTE_FDD_ENB_DEBUG_LOG_ARG_STRING == arg[i].type)
+        {
+            if(NULL == arg[i].s)
+                arg[i].s = "(null)";
+            arg[i].len  = strlen(arg[i].s) + 1;
+            size       += arg[i].len;
+        }
+    }
+    if(LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_BITS == payload->type)
+        size += (payload->len + 7) / 8;
+    else if(LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_BYTES == payload->type)
+        size += payload->len;
+
+    rec = (LTE_FDD_ENB_DEBUG_LOG_RECORD_STRUCT *)ring->reserve(size);
+    if(NULL == rec)
+        return;
+
+    // Header
+    rec->fmt          = fmt;
+    rec->file_name    = file_name;
+    clock_gettime(CLOCK_REALTIME, &rec->ts);
+    rec->line         = line;
+    rec->payload_len  = payload->len;
+    rec->type         = type;
+    rec->level        = level;
+    rec->payload_type = payload->type;
+    rec->N_args       = N_args;
+
+    // Arguments, then strings, then the payload
+    uint8 *ptr = (uint8 *)(rec + 1);
+    memcpy(ptr, arg, N_args*sizeof(LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT));
+    ptr += N_args*sizeof(LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT);
+    for(uint32 i=0; i<N_args; i++)
+    {
+        if(LTE_FDD_ENB_DEBUG_LOG_ARG_STRING == arg[i].type)
+        {
+            memcpy(ptr, arg[i].s, arg[i].len);
+            ptr += arg[i].len;
+        }
+    }
+    if(LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_BITS == payload->type)
+    {
+        memset(ptr, 0, (payload->len + 7) / 8);
+        for(uint32 i=0; i<payload->len; i++)
+            ptr[i/8] |= (payload->data[i] & 1) << (7 - (i % 8));
+    }else if(LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_BYTES == payload->type){
+        memcpy(ptr, payload->data, payload->len);
+    }
+
+    ring->commit();
+}
+
+/********************/
+/*    Formatting    */
+/********************/
+void LTE_fdd_enb_debug_log::format_record(LTE_FDD_ENB_DEBUG_LOG_RECORD_STRUCT *rec,
+                                          std::string                         &line)
+{
+    LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT *arg = (LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT *)(rec + 1);
+    const char                       *str = (const char *)&arg[rec->N_args];
+    struct tm                         local_time;
+    char                              spec[32];
+
+    // Point the string arguments at their copies
+    for(uint32 i=0; i<rec->N_args; i++)
+    {
+        if(LTE_FDD_ENB_DEBUG_LOG_ARG_STRING == arg[i].type)
+        {
+            arg[i].s  = str;
+            str      += arg[i].len;
+        }
+    }
+    const uint8 *payload = (const uint8 *)str;
+
+    // Same layout as get_formatted_time
+    localtime_r(&rec->ts.tv_sec, &local_time);
+    append_printf(line,
+                  "%02u/%02u/%04u %02u:%02u:%02u.%06u %s %s %s %d ",
+                  local_time.tm_mon + 1,
+                  local_time.tm_mday,
+                  local_time.tm_year + 1900,
+                  local_time.tm_hour,
+                  local_time.tm_min,
+                  local_time.tm_sec,
+                  (uint32)(rec->ts.tv_nsec / 1000),
+                  LTE_fdd_enb_debug_type_text[rec->type],
+                  LTE_fdd_enb_debug_level_text[rec->level],
+                  rec->file_name,
+                  rec->line);
+
+    // Format one conversion at a time, arguments were all widened
+    // to 64 bits so length modifiers are replaced
+    const char *p   = rec->fmt;
+    uint32      idx = 0;
+    while('\0' != *p)
+    {
+        if('%' != *p)
+        {
+            const char *next = strchr(p, '%');
+            uint32      N    = (NULL == next) ? strlen(p) : (uint32)(next - p);
+            line.append(p, N);
+            p += N;
+            continue;
+        }
+        if('%' == p[1])
+        {
+            line += '%';
+            p    += 2;
+            continue;
+        }
+        uint32 N = 0;
+        spec[N++] = *p++;
+        while('\0' != *p && NULL != strchr("-+ #0123456789.", *p) && N < sizeof(spec) - 4)
+            spec[N++] = *p++;
+        while('\0' != *p && NULL != strchr("hlLqjzt", *p))
+            p++;
+        char conv = *p;
+        if('\0' != conv)
+            p++;
+        if(idx >= rec->N_args)
+        {
+            line += "<?>";
+            continue;
+        }
+
+        LTE_FDD_ENB_DEBUG_LOG_ARG_STRUCT *a = &arg[idx++];
+        uint64                            u = a->u;
+        if(LTE_FDD_ENB_DEBUG_LOG_ARG_DOUBLE == a->type)
+            u = (uint64)(int64)a->d;
+        switch(conv)
+        {
+        case 'd':
+        case 'i':
+            spec[N++] = 'l';
+            spec[N++] = 'l';
+            spec[N++] = 'd';
+            spec[N]   = '\0';
+            append_printf(line, spec, (long long)u);
+            break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            // Keep the 32 bit wrap of negative values printed unsigned
+            if(LTE_FDD_ENB_DEBUG_LOG_ARG_INT == a->type && a->i < 0 && a->i >= INT32_MIN)
+                u = (uint32)a->i;
+            spec[N++] = 'l';
+            spec[N++] = 'l';
+            spec[N++] = conv;
+            spec[N]   = '\0';
+            append_printf(line, spec, (unsigned long long)u);
+            break;
+        case 'c':
+            spec[N++] = 'c';
+            spec[N]   = '\0';
+            append_printf(line, spec, (int)u);
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            spec[N++] = conv;
+            spec[N]   = '\0';
+            append_printf(line, spec, (LTE_FDD_ENB_DEBUG_LOG_ARG_DOUBLE == a->type) ? a->d : (double)(int64)u);
+            break;
+        case 's':
+            if(LTE_FDD_ENB_DEBUG_LOG_ARG_STRING != a->type)
+            {
+                line += "<?>";
+            }else if(1 == N){
+                line.append(a->s, a->len - 1);
+            }else{
+                spec[N++] = 's';
+                spec[N]   = '\0';
+                append_printf(line, spec, a->s);
+            }
+            break;
+        case 'p':
+            spec[N++] = 'p';
+            spec[N]   = '\0';
+            append_printf(line, spec, a->p);
+            break;
+        default:
+            line += "<?>";
+            break;
+        }
+    }
+
+    // Attached message
+    if(LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_BITS == rec->payload_type)
+    {
+        line += " ";
+        for(uint32 i=0; i<(rec->payload_len + 3) / 4; i++)
+        {
+            uint32 hex_val = (i % 2) ? (payload[i/2] & 0x0F) : (payload[i/2] >> 4);
+            if(hex_val < 0xA)
+            {
+                line += (char)(hex_val + '0');
+            }else{
+                line += (char)((hex_val-0xA) + 'A');
+            }
+        }
+    }else if(LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_BYTES == rec->payload_type){
+        line += " msg_size=" + std::to_string(rec->payload_len);
+        if(rec->payload_len > 0)
+        {
+            line += " ";
+            for(uint32 i=0; i<rec->payload_len; i++)
+                append_printf(line, "%02X", payload[i]);
+        }
+    }else if(LTE_FDD_ENB_DEBUG_LOG_PAYLOAD_SIZE == rec->payload_type){
+        line += " msg_size=" + std::to_string(rec->payload_len);
+    }
+    line += "\n";
+}
+
+/***************/
+/*    Rings    */
+/***************/
+LTE_fdd_enb_debug_log_ring* LTE_fdd_enb_debug_log::get_thread_ring()
+{
+    if(this == thread_ring.owner)
+        return thread_ring.ring;
+
+    // First record from this thread
+    LTE_fdd_enb_debug_log_ring *ring = new LTE_fdd_enb_debug_log_ring;
+
+    std::lock_guard<std::mutex> lock(ring_mutex);
+    rings.push_back(ring);
+    thread_ring.owner = this;
+    thread_ring.ring  = ring;
+
+    return ring;
+}
+
+/***************************/
+/*    Background Thread    */
+/***************************/
+void LTE_fdd_enb_debug_log::log_thread(LTE_fdd_enb_debug_log *log)
+{
+    while(log->thread_run)
+    {
+        if(!log->drain())
+            std::this_thread::sleep_for(std::chrono::microseconds(LTE_FDD_ENB_DEBUG_LOG_IDLE_SLEEP_US));
+    }
+    log->drain();
+}
+bool LTE_fdd_enb_debug_log::drain()
+{
+    std::string msg;
+
+    ring_mutex.lock();
+
+    // Merge the rings in time order up to what was written when the
+    // drain started
+    std::vector<uint64> pos(rings.size());
+    std::vector<uint64> end(rings.size());
+    for(uint32 i=0; i<rings.size(); i++)
+    {
+        pos[i] = rings[i]->get_read_pos();
+        end[i] = rings[i]->get_write_pos();
+    }
+    for(uint32 N_records=0; N_records<LTE_FDD_ENB_DEBUG_LOG_MAX_BATCH; N_records++)
+    {
+        LTE_FDD_ENB_DEBUG_LOG_RECORD_STRUCT *next_rec  = NULL;
+        uint32                               next_idx  = 0;
+        uint32                               next_size = 0;
+        for(uint32 i=0; i<rings.size(); i++)
+        {
+            uint32                               size;
+            LTE_FDD_ENB_DEBUG_LOG_RECORD_STRUCT *rec = (LTE_FDD_ENB_DEBUG_LOG_RECORD_STRUCT *)rings[i]->peek(pos[i], end[i], &size);
+            if(NULL != rec &&
+               (NULL == next_rec                           ||
+                rec->ts.tv_sec < next_rec->ts.tv_sec       ||
+                (rec->ts.tv_sec  == next_rec->ts.tv_sec &&
+                 rec->ts.tv_nsec <  next_rec->ts.tv_nsec)))
+            {
+                next_rec  = rec;
+                next_idx  = i;
+                next_size = size;
+            }
+        }
+        if(NULL == next_rec)
+            break;
+        format_record(next_rec, msg);
+        pos[next_idx] += next_size;
+        rings[next_idx]->release(pos[next_idx]);
+    }
+
+    // Release any trailing padding, report drops and free the rings of
+    // exited threads
+    for(uint32 i=0; i<rings.size(); i++)
+        rings[i]->release(pos[i]);
+    for(auto iter=rings.begin(); iter!=rings.end();)
+    {
+        LTE_fdd_enb_debug_log_ring *ring      = *iter;
+        uint64                      N_dropped = ring->get_N_new_dropped();
+        if(0 != N_dropped)
+        {
+            get_formatted_time(msg);
+            append_printf(msg,
+                          " %s %s %s %d Dropped %llu debug messages\n",
+                          LTE_fdd_enb_debug_type_text[LTE_FDD_ENB_DEBUG_TYPE_WARNING],
+                          LTE_fdd_enb_debug_level_text[LTE_FDD_ENB_DEBUG_LEVEL_IFACE],
+                          __FILE__,
+                          __LINE__,
+                          N_dropped);
+        }
+        if(ring->is_closed_and_drained())
+        {
+            delete ring;
+            iter = rings.erase(iter);
+        }else{
+            iter++;
+        }
+    }
+
+    ring_mutex.unlock();
+
+    if(msg.empty())
+        return false;
+    interface->send_debug_log(msg);
+    return true;
+}
@@ -54,8 +54,9 @@
 #include <linux/if_tun.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <poll.h>
 #include <errno.h>
-#include <thread>
+#include <unistd.h>
 
 /*******************************************************************************
                               DEFINES
@@ -80,7 +81,7 @@
 /*    Constructor/Destructor    */
 /********************************/
 LTE_fdd_enb_gw::LTE_fdd_enb_gw(LTE_fdd_enb_interface *iface, LTE_fdd_enb_user_mgr *um) :
-    interface{iface}, user_mgr{um}, started{false}
+    interface{iface}, user_mgr{um}, started{false}, N_tun_queues{0}
 {
 }
 LTE_fdd_enb_gw::~LTE_fdd_enb_gw()
@@ -107,6 +108,7 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_gw::start(LTE_fdd_enb_msgq *from_pdcp,
     int32                       sock;
     char                        dev[IFNAMSIZ] = "tun_openlte";
     uint32                      ip_addr;
+    uint32                      i;
 
     if(started)
         return LTE_FDD_ENB_ERROR_ALREADY_STARTED;
@@ -115,22 +117,32 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_gw::start(LTE_fdd_enb_msgq *from_pdcp,
 
     ip_addr = interface->get_ip_addr_start();
 
-    // Construct the TUN device
-    tun_fd = open("/dev/net/tun", O_RDWR);
-    if(0 > tun_fd)
-    {
-        err_str = strerror(errno);
-        started = false;
-        return LTE_FDD_ENB_ERROR_CANT_START;
-    }
+    // Construct the TUN device, one non-blocking file descriptor per
+    // queue, falling back to a single queue without IFF_MULTI_QUEUE
     memset(&ifr, 0, sizeof(ifr));
-    ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
+    ifr.ifr_flags = IFF_TUN | IFF_NO_PI | IFF_MULTI_QUEUE;
     strncpy(ifr.ifr_ifrn.ifrn_name, dev, IFNAMSIZ);
-    if(0 > ioctl(tun_fd, TUNSETIFF, &ifr))
+    N_tun_queues = 0;
+    for(i=0; i<LTE_FDD_ENB_GW_N_TUN_QUEUES; i++)
+    {
+        tun_queue[i].fd = open("/dev/net/tun", O_RDWR | O_NONBLOCK);
+        if(0 > tun_queue[i].fd)
+            break;
+        if(0 > ioctl(tun_queue[i].fd, TUNSETIFF, &ifr))
+        {
+            ifr.ifr_flags &= ~IFF_MULTI_QUEUE;
+            if(0 == i && 0 <= ioctl(tun_queue[i].fd, TUNSETIFF, &ifr))
+                N_tun_queues++;
+            else
+                close(tun_queue[i].fd);
+            break;
+        }
+        N_tun_queues++;
+    }
+    if(0 == N_tun_queues)
     {
         err_str = strerror(errno);
         started = false;
-        close(tun_fd);
         return LTE_FDD_ENB_ERROR_CANT_START;
     }
 
@@ -142,7 +154,8 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_gw::start(LTE_fdd_enb_msgq *from_pdcp,
     {
         err_str = strerror(errno);
         started = false;
-        close(tun_fd);
+        close(sock);
+        close_tun_queues();
         return LTE_FDD_ENB_ERROR_CANT_START;
     }
     ifr.ifr_netmask.sa_family                                 = AF_INET;
@@ -151,7 +164,8 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_gw::start(LTE_fdd_enb_msgq *from_pdcp,
     {
         err_str = strerror(errno);
         started = false;
-        close(tun_fd);
+        close(sock);
+        close_tun_queues();
         return LTE_FDD_ENB_ERROR_CANT_START;
     }
 
@@ -160,7 +174,8 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_gw::start(LTE_fdd_enb_msgq *from_pdcp,
     {
         err_str = strerror(errno);
         started = false;
-        close(tun_fd);
+        close(sock);
+        close_tun_queues();
         return LTE_FDD_ENB_ERROR_CANT_START;
     }
     ifr.ifr_flags |= IFF_UP | IFF_RUNNING;
@@ -168,29 +183,39 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_gw::start(LTE_fdd_enb_msgq *from_pdcp,
     {
         err_str = strerror(errno);
         started = false;
-        close(tun_fd);
+        close(sock);
+        close_tun_queues();
         return LTE_FDD_ENB_ERROR_CANT_START;
     }
+    close(sock);
 
     // Setup PDCP communication
     msgq_from_pdcp = from_pdcp;
     msgq_to_pdcp   = to_pdcp;
     msgq_from_pdcp->attach_rx(pdcp_cb);
 
-    // Setup a thread to receive packets from the TUN device
-    pthread_create(&rx_thread, NULL, &receive_thread, this);
+    // Setup a thread per TUN queue to receive packets
+    for(i=0; i<N_tun_queues; i++)
+    {
+        tun_queue[i].gw  = this;
+        tun_queue[i].idx = i;
+        pthread_create(&tun_queue[i].rx_thread, NULL, &receive_thread, &tun_queue[i]);
+    }
     return LTE_FDD_ENB_ERROR_NONE;
 }
 void LTE_fdd_enb_gw::stop()
 {
-    std::lock_guard<std::mutex> lock(start_mutex);
-    if(!started)
-        return;
-    started = false;
-    start_mutex.unlock();
-    pthread_cancel(rx_thread);
-    pthread_join(rx_thread, NULL);
-    close(tun_fd);
+    {
+        std::lock_guard<std::mutex> lock(start_mutex);
+        if(!started)
+            return;
+        started = false;
+    }
+
+    // The threads see started cleared within one poll timeout
+    for(uint32 i=0; i<N_tun_queues; i++)
+        pthread_join(tun_queue[i].rx_thread, NULL);
+    close_tun_queues();
 }
 
 /***********************/
@@ -216,28 +241,30 @@ void LTE_fdd_enb_gw::handle_gw_data(LTE_FDD_ENB_GW_DATA_READY_MSG_STRUCT *gw_dat
 {
     LIBLTE_BYTE_MSG_STRUCT *msg;
 
-    if(LTE_FDD_ENB_ERROR_NONE != gw_data->rb->get_next_gw_data_msg(&msg))
-        return;
-
-    interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
-                              LTE_FDD_ENB_DEBUG_LEVEL_GW,
-                              __FILE__,
-                              __LINE__,
-                              msg,
-                              "Received GW data message for RNTI=%u and RB=%s",
-                              gw_data->user->get_c_rnti(),
-                              LTE_fdd_enb_rb_text[gw_data->rb->get_rb_id()]);
-    interface->send_ip_pcap_msg(msg->msg, msg->N_bytes);
-
-    if(msg->N_bytes != write(tun_fd, msg->msg, msg->N_bytes))
-        interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ERROR,
+    // Write every queued packet, the notifications for packets written
+    // here find the queue empty and are ignored
+    while(LTE_FDD_ENB_ERROR_NONE == gw_data->rb->get_next_gw_data_msg(&msg))
+    {
+        interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
                                   LTE_FDD_ENB_DEBUG_LEVEL_GW,
                                   __FILE__,
                                   __LINE__,
-                                  "Write failure");
-
-    // Delete the message
-    gw_data->rb->delete_next_gw_data_msg();
+                                  msg,
+                                  "Received GW data message for RNTI=%u and RB=%s",
+                                  gw_data->user->get_c_rnti(),
+                                  LTE_fdd_enb_rb_text[gw_data->rb->get_rb_id()]);
+        interface->send_ip_pcap_msg(msg->msg, msg->N_bytes);
+
+        if(msg->N_bytes != write(tun_queue[0].fd, msg->msg, msg->N_bytes))
+            interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ERROR,
+                                      LTE_FDD_ENB_DEBUG_LEVEL_GW,
+                                      __FILE__,
+                                      __LINE__,
+                                      "Write failure");
+
+        // Delete the message
+        gw_data->rb->delete_next_gw_data_msg();
+    }
 }
 
 /********************/
@@ -245,72 +272,114 @@ void LTE_fdd_enb_gw::handle_gw_data(LTE_FDD_ENB_GW_DATA_READY_MSG_STRUCT *gw_dat
 /********************/
 void* LTE_fdd_enb_gw::receive_thread(void *inputs)
 {
-    LTE_fdd_enb_gw                             *gw = (LTE_fdd_enb_gw *)inputs;
-    LTE_FDD_ENB_PDCP_DATA_SDU_READY_MSG_STRUCT  pdcp_data_sdu;
-    LIBLTE_BYTE_MSG_STRUCT                      msg;
-    struct iphdr                                ipv4_pkt;
-    cpu_set_t                                   af_mask;
-    uint32                                      idx      = 0;
-    uint32                                      num_cpus = std::thread::hardware_concurrency();
-    int32                                       N_bytes;
-
-    // Set affinity to the third to the last core (last is for PHY/Radio, second to last is for MAC)
-    CPU_ZERO(&af_mask);
-    CPU_SET(num_cpus-3, &af_mask);
-    pthread_setaffinity_np(gw->rx_thread, sizeof(af_mask), &af_mask);
-
+    LTE_FDD_ENB_GW_TUN_QUEUE_STRUCT *queue    = (LTE_FDD_ENB_GW_TUN_QUEUE_STRUCT *)inputs;
+    LTE_fdd_enb_gw                  *gw       = queue->gw;
+    LIBLTE_BYTE_MSG_STRUCT          *pkt      = new LIBLTE_BYTE_MSG_STRUCT[LTE_FDD_ENB_GW_RX_BATCH];
+    struct pollfd                    pfd;
+    uint32                           N_pkts;
+    int32                            N_bytes;
+
+    // One core of the GW set per queue
+    gw->interface->get_cpu()->place_thread(LTE_FDD_ENB_THREAD_ROLE_GW, queue->idx);
+
+    pfd.fd     = queue->fd;
+    pfd.events = POLLIN;
     while(gw->is_started())
     {
-        N_bytes = read(gw->tun_fd, &msg.msg[idx], LIBLTE_MAX_MSG_SIZE);
-
-        if(N_bytes <= 0)
+        if(0 >= poll(&pfd, 1, LTE_FDD_ENB_GW_RX_POLL_TIMEOUT_MS))
+            continue;
+        if(0 != (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)))
             break; // Something bad has happened
 
-        msg.N_bytes = idx + N_bytes;
-        if(0x60 == (msg.msg[0] & 0xF0))
+        // Read everything that is queued, one packet per read
+        for(N_pkts=0; N_pkts<LTE_FDD_ENB_GW_RX_BATCH; N_pkts++)
         {
-            // Discard IPv6 packet
-            if(msg.N_bytes == ((msg.msg[4]<<8) + msg.msg[5]) + sizeof(ip6_hdr))
-            {
-                idx = 0;
-            }else{
-                idx += N_bytes;
-            }
-            continue;
+            N_bytes = read(queue->fd, pkt[N_pkts].msg, LIBLTE_MAX_MSG_SIZE);
+            if(0 >= N_bytes)
+                break;
+            pkt[N_pkts].N_bytes = N_bytes;
         }
-        memcpy(&ipv4_pkt, msg.msg, sizeof(iphdr));
 
-        // Check if entire packet was received
-        if(ntohs(ipv4_pkt.tot_len) != msg.N_bytes)
-        {
-            idx = N_bytes;
-            continue;
-        }
+        gw->handle_ip_pkt_batch(pkt, N_pkts);
+    }
 
-        // Find user and rb
-        if(LTE_FDD_ENB_ERROR_NONE == gw->user_mgr->find_user(ntohl(ipv4_pkt.daddr), &pdcp_data_sdu.user) &&
-           LTE_FDD_ENB_ERROR_NONE == pdcp_data_sdu.user->get_drb(LTE_FDD_ENB_RB_DRB1, &pdcp_data_sdu.rb))
+    delete [] pkt;
+    return NULL;
+}
+void LTE_fdd_enb_gw::handle_ip_pkt_batch(LIBLTE_BYTE_MSG_STRUCT *pkt,
+                                         uint32                  N_pkts)
+{
+    LTE_FDD_ENB_PDCP_DATA_SDU_READY_MSG_STRUCT pdcp_data_sdu[LTE_FDD_ENB_GW_RX_BATCH];
+    LTE_FDD_ENB_PDCP_DATA_SDU_READY_MSG_STRUCT cur;
+    struct iphdr                               ipv4_pkt;
+    struct ip6_hdr                             ipv6_pkt;
+    uint32                                     N_ready = 0;
+    uint32                                     i;
+    uint32                                     j;
+
+    for(i=0; i<N_pkts; i++)
+    {
+        if(0x60 == (pkt[i].msg[0] & 0xF0))
         {
-            gw->interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
+            // No IPv6 PDNs are granted so there is no bearer to use
+            memcpy(&ipv6_pkt, pkt[i].msg, sizeof(ip6_hdr));
+            if(pkt[i].N_bytes == ntohs(ipv6_pkt.ip6_plen) + sizeof(ip6_hdr))
+                interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
                                           LTE_FDD_ENB_DEBUG_LEVEL_GW,
                                           __FILE__,
                                           __LINE__,
-                                          &msg,
-                                          "Received IP packet for RNTI=%u and RB=%s",
-                                          pdcp_data_sdu.user->get_c_rnti(),
-                                          LTE_fdd_enb_rb_text[pdcp_data_sdu.rb->get_rb_id()]);
-            gw->interface->send_ip_pcap_msg(msg.msg, msg.N_bytes);
-
-            // Send message to PDCP
-            pdcp_data_sdu.rb->queue_pdcp_data_sdu(&msg);
-            gw->msgq_to_pdcp->send(LTE_FDD_ENB_MESSAGE_TYPE_PDCP_DATA_SDU_READY,
-                                   LTE_FDD_ENB_DEST_LAYER_PDCP,
-                                   (LTE_FDD_ENB_MESSAGE_UNION *)&pdcp_data_sdu,
-                                   sizeof(LTE_FDD_ENB_PDCP_DATA_SDU_READY_MSG_STRUCT));
+                                          &pkt[i],
+                                          "Discarding IPv6 packet, only IPv4 PDNs are supported");
+            continue;
         }
-            
-        idx = 0;
+        if(0x40 != (pkt[i].msg[0] & 0xF0) ||
+           sizeof(iphdr) > pkt[i].N_bytes)
+            continue;
+        memcpy(&ipv4_pkt, pkt[i].msg, sizeof(iphdr));
+
+        // Check if entire packet was received
+        if(ntohs(ipv4_pkt.tot_len) != pkt[i].N_bytes)
+            continue;
+
+        // Find user and rb
+        if(LTE_FDD_ENB_ERROR_NONE != user_mgr->find_user(ntohl(ipv4_pkt.daddr), &cur.user) ||
+           LTE_FDD_ENB_ERROR_NONE != cur.user->get_drb(LTE_FDD_ENB_RB_DRB1, &cur.rb))
+            continue;
+
+        interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
+                                  LTE_FDD_ENB_DEBUG_LEVEL_GW,
+                                  __FILE__,
+                                  __LINE__,
+                                  &pkt[i],
+                                  "Received IP packet for RNTI=%u and RB=%s",
+                                  cur.user->get_c_rnti(),
+                                  LTE_fdd_enb_rb_text[cur.rb->get_rb_id()]);
+        interface->send_ip_pcap_msg(pkt[i].msg, pkt[i].N_bytes);
+        cur.rb->queue_pdcp_data_sdu(&pkt[i]);
+
+        // PDCP drains the whole queue in cipher batches, so one
+        // message per RB
+        for(j=0; j<N_ready; j++)
+            if(cur.rb == pdcp_data_sdu[j].rb)
+                break;
+        if(j == N_ready)
+            pdcp_data_sdu[N_ready++] = cur;
     }
 
-    return NULL;
+    // Send messages to PDCP
+    for(i=0; i<N_ready; i++)
+        msgq_to_pdcp->send(LTE_FDD_ENB_MESSAGE_TYPE_PDCP_DATA_SDU_READY,
+                           LTE_FDD_ENB_DEST_LAYER_PDCP,
+                           (LTE_FDD_ENB_MESSAGE_UNION *)&pdcp_data_sdu[i],
+                           sizeof(LTE_FDD_ENB_PDCP_DATA_SDU_READY_MSG_STRUCT));
+}
+
+/********************/
+/*    TUN device    */
+/********************/
+void LTE_fdd_enb_gw::close_tun_queues()
+{
+    for(uint32 i=0; i<N_tun_queues; i++)
+        close(tun_queue[i].fd);
+    N_tun_queues = 0;
 }
@@ -49,8 +49,9 @@
 *******************************************************************************/
 
 #include "LTE_fdd_enb_hss.h"
-#include "liblte_security.h"
 #include "libtools_helpers.h"
+#include <algorithm>
+#include <vector>
 
 /*******************************************************************************
                               DEFINES
@@ -74,17 +75,27 @@
 /********************************/
 /*    Constructor/Destructor    */
 /********************************/
-LTE_fdd_enb_hss::LTE_fdd_enb_hss() :
-    use_user_file{false}
+LTE_fdd_enb_hss::LTE_fdd_enb_hss(std::string _journal_name) :
+    next_av_epoch{0}, av_thread_run{true}, journal_name{_journal_name}, journal_file{NULL},
+    N_journal_records{0}, use_user_file{false}
 {
-    user_list.clear();
+    av_gen_thread = new std::thread(av_thread, this);
 }
 LTE_fdd_enb_hss::~LTE_fdd_enb_hss()
 {
-    std::lock_guard<std::mutex> lock(user_mutex);
+    // Cleanup thread
+    av_mutex.lock();
+    av_thread_run = false;
+    av_mutex.unlock();
+    av_cv.notify_one();
+    av_gen_thread->join();
+    delete av_gen_thread;
 
-    for(auto user : user_list)
-        delete user;
+    std::lock_guard<std::mutex> lock(user_mutex);
+    if(NULL != journal_file)
+        fclose(journal_file);
+    for(auto user : imsi_map)
+        delete user.second;
 }
 
 /****************************/
@@ -94,85 +105,141 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_hss::add_user(std::string imsi,
                                                  std::string imei,
                                                  std::string k)
 {
-    LTE_FDD_ENB_HSS_USER_STRUCT *new_user = new LTE_FDD_ENB_HSS_USER_STRUCT;
-    LTE_FDD_ENB_ERROR_ENUM       err      = LTE_FDD_ENB_ERROR_BAD_ALLOC;
+    LTE_FDD_ENB_HSS_USER_STRUCT *user;
+    LTE_FDD_ENB_ERROR_ENUM       err = LTE_FDD_ENB_ERROR_BAD_ALLOC;
+    uint64                       imsi_num;
+    uint64                       imei_num;
+    uint8                        k_num[16];
+    uint8                        record[LTE_FDD_ENB_HSS_JOURNAL_RECORD_SIZE];
 
-    if(NULL != new_user      &&
-       15   == imsi.length() &&
-       15   == imei.length() &&
-       32   == k.length())
-    {
-        to_number(imsi, 15, &new_user->id.imsi);
-        to_number(imei, 15, &new_user->id.imei);
-        to_number(k, 16, new_user->stored_data.k);
+    if(15 != imsi.length() ||
+       15 != imei.length() ||
+       32 != k.length())
+        return err;
 
-        new_user->generated_data.sqn_he = 0;
-        new_user->generated_data.seq_he = 0;
-        new_user->generated_data.ind_he = 0;
+    to_number(imsi, 15, &imsi_num);
+    to_number(imei, 15, &imei_num);
+    to_number(k, 16, k_num);
 
-        user_mutex.lock();
-        err = LTE_FDD_ENB_ERROR_NONE;
-        for(auto user : user_list)
-            if(user->id.imsi == new_user->id.imsi &&
-               user->id.imei == new_user->id.imei)
-                err = LTE_FDD_ENB_ERROR_DUPLICATE_ENTRY;
-        if(LTE_FDD_ENB_ERROR_NONE == err)
-        {
-            user_list.push_back(new_user);
-        }else{
-            delete new_user;
-        }
-        user_mutex.unlock();
+    user = new_user(imsi_num, imei_num, k_num);
+    if(NULL == user)
+        return err;
 
-        if(use_user_file)
-            write_user_file();
+    user_mutex.lock();
+    err = insert_user(user);
+    if(LTE_FDD_ENB_ERROR_NONE == err)
+    {
+        pack_journal_record(LTE_FDD_ENB_HSS_JOURNAL_OP_ADD, user, record);
+        write_journal_records(record, 1);
+        queue_av_refill(user);
+    }else{
+        delete user;
     }
+    user_mutex.unlock();
 
     return err;
 }
 LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_hss::del_user(std::string imsi)
 {
-    LTE_FDD_ENB_HSS_USER_STRUCT *user = NULL;
-    LTE_FDD_ENB_ERROR_ENUM       err  = LTE_FDD_ENB_ERROR_USER_NOT_FOUND;
-    uint64                       imsi_num;
-    bool                         update_user_file = false;
+    LTE_FDD_ENB_ERROR_ENUM err = LTE_FDD_ENB_ERROR_USER_NOT_FOUND;
+    uint64                 imsi_num;
+    uint8                  record[LTE_FDD_ENB_HSS_JOURNAL_RECORD_SIZE];
 
     to_number(imsi, 15, &imsi_num);
 
     user_mutex.lock();
-    for(auto user_it=user_list.begin(); user_it!=user_list.end(); user_it++)
+    auto user_it = imsi_map.find(imsi_num);
+    if(imsi_map.end() != user_it)
+    {
+        pack_journal_record(LTE_FDD_ENB_HSS_JOURNAL_OP_DEL, (*user_it).second, record);
+        erase_user((*user_it).second);
+        write_journal_records(record, 1);
+        err = LTE_FDD_ENB_ERROR_NONE;
+    }
+    user_mutex.unlock();
+
+    return err;
+}
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_hss::import_users(std::string  file_name,
+                                                     uint32      *N_users)
+{
+    LTE_FDD_ENB_HSS_USER_STRUCT                *user;
+    FILE                                       *csv_file = fopen(file_name.c_str(), "r");
+    std::vector<LTE_FDD_ENB_HSS_USER_STRUCT *>  users;
+    std::vector<uint8>                          records;
+    std::string                                 imsi_str;
+    std::string                                 imei_str;
+    std::string                                 k_str;
+    char                                        str[LTE_FDD_ENB_MAX_LINE_SIZE];
+    uint64                                      imsi_num;
+    uint64                                      imei_num;
+    uint8                                       k_num[16];
+
+    *N_users = 0;
+    if(NULL == csv_file)
+        return LTE_FDD_ENB_ERROR_INVALID_PARAM;
+
+    // Each line is imsi,imei,k, anything else (headers, comments) is
+    // skipped.  The Milenage setup runs here, without the user lock.
+    while(NULL != fgets(str, LTE_FDD_ENB_MAX_LINE_SIZE, csv_file))
     {
-        if(imsi_num == (*user_it)->id.imsi)
+        std::string line_str = str;
+        line_str.erase(std::remove_if(line_str.begin(), line_str.end(), ::isspace), line_str.end());
+        imsi_str = line_str.substr(0, line_str.find(","));
+        line_str = line_str.substr(std::min(imsi_str.length() + 1, line_str.length()));
+        imei_str = line_str.substr(0, line_str.find(","));
+        k_str    = line_str.substr(std::min(imei_str.length() + 1, line_str.length()));
+        if(!is_string_valid_as_number(imsi_str, 15, 10) ||
+           !is_string_valid_as_number(imei_str, 15, 10) ||
+           !is_string_valid_as_number(k_str, 32, 16))
+            continue;
+
+        to_number(imsi_str, 15, &imsi_num);
+        to_number(imei_str, 15, &imei_num);
+        to_number(k_str, 16, k_num);
+
+        user = new_user(imsi_num, imei_num, k_num);
+        if(NULL == user)
+            break;
+        users.push_back(user);
+    }
+    fclose(csv_file);
+
+    // Insert the whole import and journal it as one write
+    records.resize(users.size()*LTE_FDD_ENB_HSS_JOURNAL_RECORD_SIZE);
+    user_mutex.lock();
+    for(uint32 i=0; i<users.size(); i++)
+    {
+        user = users[i];
+        if(LTE_FDD_ENB_ERROR_NONE != insert_user(user))
         {
-            user = (*user_it);
-            user_list.erase(user_it);
             delete user;
-            err = LTE_FDD_ENB_ERROR_NONE;
-            break;
+            continue;
         }
-
-        update_user_file = true;
+        pack_journal_record(LTE_FDD_ENB_HSS_JOURNAL_OP_ADD,
+                            user,
+                            &records[(*N_users)*LTE_FDD_ENB_HSS_JOURNAL_RECORD_SIZE]);
+        queue_av_refill(user);
+        (*N_users)++;
     }
+    if(0 != *N_users)
+        write_journal_records(&records[0], *N_users);
     user_mutex.unlock();
 
-    if(update_user_file &&
-       use_user_file)
-        write_user_file();
-
-    return err;
+    return LTE_FDD_ENB_ERROR_NONE;
 }
 std::string LTE_fdd_enb_hss::print_all_users()
 {
     std::lock_guard<std::mutex> lock(user_mutex);
     std::string                 output;
 
-    output = std::to_string((uint32)user_list.size());
-    for(auto user : user_list)
+    output = std::to_string((uint32)imsi_map.size());
+    for(auto user : imsi_map)
     {
         output += "\n";
-        output += "imsi=" + to_string(user->id.imsi, 15) + " ";
-        output += "imei=" + to_string(user->id.imei, 15) + " ";
-        output += "k=" + to_string(user->stored_data.k, 16);
+        output += "imsi=" + to_string(user.second->id.imsi, 15) + " ";
+        output += "imei=" + to_string(user.second->id.imei, 15) + " ";
+        output += "k=" + to_string(user.second->stored_data.k, 16);
     }
 
     return output;
@@ -181,39 +248,31 @@ bool LTE_fdd_enb_hss::is_imsi_allowed(uint64 imsi)
 {
     std::lock_guard<std::mutex> lock(user_mutex);
 
-    for(auto user : user_list)
-        if(imsi == user->id.imsi)
-            return true;
-
-    return false;
+    return imsi_map.end() != imsi_map.find(imsi);
 }
 bool LTE_fdd_enb_hss::is_imei_allowed(uint64 imei)
 {
     std::lock_guard<std::mutex> lock(user_mutex);
 
-    for(auto user : user_list)
-        if(imei == user->id.imei)
-            return true;
-
-    return false;
+    return imei_map.end() != imei_map.find(imei);
 }
 LTE_FDD_ENB_USER_ID_STRUCT* LTE_fdd_enb_hss::get_user_id_from_imsi(uint64 imsi)
 {
     std::lock_guard<std::mutex> lock(user_mutex);
+    auto                        user_it = imsi_map.find(imsi);
 
-    for(auto user : user_list)
-        if(imsi == user->id.imsi)
-            return &user->id;
+    if(imsi_map.end() != user_it)
+        return &(*user_it).second->id;
 
     return NULL;
 }
 LTE_FDD_ENB_USER_ID_STRUCT* LTE_fdd_enb_hss::get_user_id_from_imei(uint64 imei)
 {
     std::lock_guard<std::mutex> lock(user_mutex);
+    auto                        user_it = imei_map.find(imei);
 
-    for(auto user : user_list)
-        if(imei == user->id.imei)
-            return &user->id;
+    if(imei_map.end() != user_it)
+        return &(*user_it).second->id;
 
     return NULL;
 }
@@ -221,188 +280,375 @@ void LTE_fdd_enb_hss::generate_security_data(LTE_FDD_ENB_USER_ID_STRUCT *id,
                                              const MCC                  &mcc,
                                              const MNC                  &mnc)
 {
-    std::lock_guard<std::mutex> lock(user_mutex);
-    uint32                      i;
-    uint32                      rand_val;
-    uint8                       sqn[6];
-    uint8                       amf[2] = {0x80, 0x00}; // 3GPP 33.102 v10.0.0 Annex H
-
-    for(auto user : user_list)
-    {
-        if(id->imei == user->id.imei &&
-           id->imsi == user->id.imsi)
-        {
-            // Generate sqn
-            // From 33.102 v10.0.0 section C.3.2
-            user->generated_data.seq_he = (user->generated_data.seq_he + 1) % LTE_FDD_ENB_SEQ_HE_MAX_VALUE;
-            user->generated_data.ind_he = (user->generated_data.ind_he + 1) % LTE_FDD_ENB_IND_HE_MAX_VALUE;
-            user->generated_data.sqn_he = (user->generated_data.seq_he << LTE_FDD_ENB_IND_HE_N_BITS) | user->generated_data.ind_he;
-            for(i=0; i<6; i++)
-            {
-                sqn[i] = (user->generated_data.sqn_he >> (5-i)*8) & 0xFF;
-            }
+    std::lock_guard<std::mutex>    lock(user_mutex);
+    LTE_FDD_ENB_HSS_USER_STRUCT   *user = find_user(id);
+    LTE_FDD_ENB_AUTH_TUPLE_STRUCT  tuple;
+    uint32                         i;
+    uint8                          sqn[6];
 
-            // Generate RAND
-            for(i=0; i<4; i++)
-            {
-                rand_val                                  = rand();
-                user->generated_data.auth_vec.rand[i*4+0] = rand_val & 0xFF;
-                user->generated_data.auth_vec.rand[i*4+1] = (rand_val >> 8) & 0xFF;
-                user->generated_data.auth_vec.rand[i*4+2] = (rand_val >> 16) & 0xFF;
-                user->generated_data.auth_vec.rand[i*4+3] = (rand_val >> 24) & 0xFF;
-            }
-
-            // Generate MAC, RES, CK, IK, and AK
-            liblte_security_milenage_f1(user->stored_data.k,
-                                        user->generated_data.auth_vec.rand,
-                                        sqn,
-                                        amf,
-                                        user->generated_data.mac);
-            liblte_security_milenage_f2345(user->stored_data.k,
-                                           user->generated_data.auth_vec.rand,
-                                           user->generated_data.auth_vec.res,
-                                           user->generated_data.auth_vec.ck,
-                                           user->generated_data.auth_vec.ik,
-                                           user->generated_data.ak);
-
-            // Construct AUTN
-            for(i=0; i<6; i++)
-            {
-                user->generated_data.auth_vec.autn[i] = sqn[i] ^ user->generated_data.ak[i];
-            }
-            for(i=0; i<2; i++)
-            {
-                user->generated_data.auth_vec.autn[6+i] = amf[i];
-            }
-            for(i=0; i<8; i++)
-            {
-                user->generated_data.auth_vec.autn[8+i] = user->generated_data.mac[i];
-            }
+    if(NULL == user)
+        return;
 
-            // Reset NAS counts
-            // 3GPP 33.401 v10.0.0 section 6.5
-            user->generated_data.auth_vec.nas_count_ul = 0;
-            user->generated_data.auth_vec.nas_count_dl = 0;
-
-            // Generate Kasme
-            liblte_security_generate_k_asme(user->generated_data.auth_vec.ck,
-                                            user->generated_data.auth_vec.ik,
-                                            user->generated_data.ak,
-                                            sqn,
-                                            mcc,
-                                            mnc,
-                                            user->generated_data.k_asme);
-
-            // Generate K_nas_enc and K_nas_int
-            liblte_security_generate_k_nas(user->generated_data.k_asme,
-                                           LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_EEA0,
-                                           LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA2,
-                                           user->generated_data.auth_vec.k_nas_enc,
-                                           user->generated_data.auth_vec.k_nas_int);
-
-            // Generate K_enb
-            liblte_security_generate_k_enb(user->generated_data.k_asme,
-                                           user->generated_data.auth_vec.nas_count_ul,
-                                           user->generated_data.k_enb);
-
-            // Generate K_rrc_enc and K_rrc_int
-            liblte_security_generate_k_rrc(user->generated_data.k_enb,
-                                           LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_EEA0,
-                                           LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA2,
-                                           user->generated_data.auth_vec.k_rrc_enc,
-                                           user->generated_data.auth_vec.k_rrc_int);
-
-            // Generate K_up_enc and K_up_int
-            liblte_security_generate_k_up(user->generated_data.k_enb,
-                                          LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_EEA0,
-                                          LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA2,
-                                          user->generated_data.k_up_enc,
-                                          user->generated_data.k_up_int);
+    // Use a pre-generated tuple, falling back to generating one inline
+    if(0 != user->N_av_batch)
+    {
+        tuple = user->av_batch[0];
+        user->N_av_batch--;
+        memmove(&user->av_batch[0],
+                &user->av_batch[1],
+                user->N_av_batch*sizeof(LTE_FDD_ENB_AUTH_TUPLE_STRUCT));
+    }else{
+        // Discard any refill in flight, it holds older sequence numbers
+        user->av_epoch = next_av_epoch++;
+        generate_auth_tuple(&user->stored_data.milenage_key,
+                            &user->generated_data.seq_he,
+                            &user->generated_data.ind_he,
+                            &tuple);
+    }
+    if(LTE_FDD_ENB_HSS_AV_REFILL_THRESHOLD >= user->N_av_batch)
+        queue_av_refill(user);
 
-            break;
-        }
+    user->generated_data.sqn_he = tuple.sqn_he;
+    for(i=0; i<6; i++)
+    {
+        sqn[i] = (tuple.sqn_he >> (5-i)*8) & 0xFF;
     }
+    memcpy(user->generated_data.auth_vec.rand, tuple.rand, 16);
+    memcpy(user->generated_data.auth_vec.res, tuple.res, 8);
+    memcpy(user->generated_data.auth_vec.ck, tuple.ck, 16);
+    memcpy(user->generated_data.auth_vec.ik, tuple.ik, 16);
+    memcpy(user->generated_data.auth_vec.autn, tuple.autn, 16);
+    memcpy(user->generated_data.ak, tuple.ak, 6);
+    memcpy(user->generated_data.mac, tuple.mac, 8);
+
+    // Reset NAS counts
+    // 3GPP 33.401 v10.0.0 section 6.5
+    user->generated_data.auth_vec.nas_count_ul = 0;
+    user->generated_data.auth_vec.nas_count_dl = 0;
+
+    // Default AS algorithms, RRC rederives the AS keys once it selects
+    // algorithms from the UE capabilities
+    user->generated_data.auth_vec.eea = LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_EEA0;
+    user->generated_data.auth_vec.eia = LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA2;
+
+    // Generate Kasme
+    liblte_security_generate_k_asme(user->generated_data.auth_vec.ck,
+                                    user->generated_data.auth_vec.ik,
+                                    user->generated_data.ak,
+                                    sqn,
+                                    mcc,
+                                    mnc,
+                                    user->generated_data.k_asme);
+
+    // Generate K_nas_enc and K_nas_int
+    liblte_security_generate_k_nas(user->generated_data.k_asme,
+                                   LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_EEA0,
+                                   LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA2,
+                                   user->generated_data.auth_vec.k_nas_enc,
+                                   user->generated_data.auth_vec.k_nas_int);
+
+    // Generate K_enb
+    liblte_security_generate_k_enb(user->generated_data.k_asme,
+                                   user->generated_data.auth_vec.nas_count_ul,
+                                   user->generated_data.auth_vec.k_enb);
+
+    // Generate K_rrc_enc and K_rrc_int
+    liblte_security_generate_k_rrc(user->generated_data.auth_vec.k_enb,
+                                   LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_EEA0,
+                                   LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA2,
+                                   user->generated_data.auth_vec.k_rrc_enc,
+                                   user->generated_data.auth_vec.k_rrc_int);
+
+    // Generate K_up_enc and K_up_int
+    liblte_security_generate_k_up(user->generated_data.auth_vec.k_enb,
+                                  LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_EEA0,
+                                  LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA2,
+                                  user->generated_data.auth_vec.k_up_enc,
+                                  user->generated_data.auth_vec.k_up_int);
 }
 void LTE_fdd_enb_hss::security_resynch(LTE_FDD_ENB_USER_ID_STRUCT *id,
                                        const MCC                  &mcc,
                                        const MNC                  &mnc,
                                        uint8                      *auts)
 {
-    std::lock_guard<std::mutex> lock(user_mutex);
-    uint32                      i;
-    uint8                       sqn[6];
+    std::lock_guard<std::mutex>  lock(user_mutex);
+    LTE_FDD_ENB_HSS_USER_STRUCT *user = find_user(id);
+    uint32                       i;
+    uint8                        sqn[6];
+
+    if(NULL == user)
+        return;
 
-    for(auto user : user_list)
+    // Decode returned SQN and break into SEQ and IND
+    liblte_security_milenage_f5_star(&user->stored_data.milenage_key,
+                                     user->generated_data.auth_vec.rand,
+                                     user->generated_data.ak);
+    user->generated_data.sqn_he = 0;
+    for(i=0; i<6; i++)
     {
-        if(id->imei == user->id.imei &&
-           id->imsi == user->id.imsi)
-        {
-            // Decode returned SQN and break into SEQ and IND
-            liblte_security_milenage_f5_star(user->stored_data.k,
-                                             user->generated_data.auth_vec.rand,
-                                             user->generated_data.ak);
-            user->generated_data.sqn_he = 0;
-            for(i=0; i<6; i++)
-            {
-                sqn[i]                       = auts[i] ^ user->generated_data.ak[i];
-                user->generated_data.sqn_he |= (uint64)sqn[i] << (5-i)*8;
-            }
-            user->generated_data.seq_he = user->generated_data.sqn_he >> LTE_FDD_ENB_IND_HE_N_BITS;
-            user->generated_data.ind_he = user->generated_data.sqn_he & LTE_FDD_ENB_IND_HE_MASK;
-            if(user->generated_data.ind_he > 0)
-            {
-                user->generated_data.ind_he--;
-            }
+        sqn[i]                       = auts[i] ^ user->generated_data.ak[i];
+        user->generated_data.sqn_he |= (uint64)sqn[i] << (5-i)*8;
+    }
+    user->generated_data.seq_he = user->generated_data.sqn_he >> LTE_FDD_ENB_IND_HE_N_BITS;
+    user->generated_data.ind_he = user->generated_data.sqn_he & LTE_FDD_ENB_IND_HE_MASK;
+    if(user->generated_data.ind_he > 0)
+    {
+        user->generated_data.ind_he--;
+    }
+
+    // Pre-generated tuples are stale after a resynch
+    user->N_av_batch = 0;
+    user->av_epoch   = next_av_epoch++;
+    queue_av_refill(user);
+}
+LTE_FDD_ENB_AUTHENTICATION_VECTOR_STRUCT* LTE_fdd_enb_hss::regenerate_enb_security_data(LTE_FDD_ENB_USER_ID_STRUCT *id,
+                                                                                        uint32                      nas_count_ul)
+{
+    std::lock_guard<std::mutex>  lock(user_mutex);
+    LTE_FDD_ENB_HSS_USER_STRUCT *user = find_user(id);
+
+    if(NULL == user)
+        return NULL;
+
+    // Generate K_enb
+    liblte_security_generate_k_enb(user->generated_data.k_asme,
+                                   nas_count_ul,
+                                   user->generated_data.auth_vec.k_enb);
+
+    // Generate K_rrc_enc and K_rrc_int
+    liblte_security_generate_k_rrc(user->generated_data.auth_vec.k_enb,
+                                   LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_EEA0,
+                                   LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA2,
+                                   user->generated_data.auth_vec.k_rrc_enc,
+                                   user->generated_data.auth_vec.k_rrc_int);
+
+    // Generate K_up_enc and K_up_int
+    liblte_security_generate_k_up(user->generated_data.auth_vec.k_enb,
+                                  LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_EEA0,
+                                  LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA2,
+                                  user->generated_data.auth_vec.k_up_enc,
+                                  user->generated_data.auth_vec.k_up_int);
+
+    return &user->generated_data.auth_vec;
+}
+LTE_FDD_ENB_AUTHENTICATION_VECTOR_STRUCT* LTE_fdd_enb_hss::get_auth_vec(LTE_FDD_ENB_USER_ID_STRUCT *id)
+{
+    std::lock_guard<std::mutex>  lock(user_mutex);
+    LTE_FDD_ENB_HSS_USER_STRUCT *user = find_user(id);
+
+    if(NULL == user)
+        return NULL;
+
+    return &user->generated_data.auth_vec;
+}
+
+/***********************/
+/*    Allowed Users    */
+/***********************/
+LTE_FDD_ENB_HSS_USER_STRUCT* LTE_fdd_enb_hss::new_user(uint64  imsi,
+                                                       uint64  imei,
+                                                       uint8  *k)
+{
+    LTE_FDD_ENB_HSS_USER_STRUCT *user = new LTE_FDD_ENB_HSS_USER_STRUCT;
+
+    if(NULL != user)
+    {
+        user->id.imsi = imsi;
+        user->id.imei = imei;
+        memcpy(user->stored_data.k, k, 16);
+        liblte_security_milenage_key_init(user->stored_data.k,
+                                          NULL,
+                                          &user->stored_data.milenage_key);
+
+        user->generated_data.sqn_he = 0;
+        user->generated_data.seq_he = 0;
+        user->generated_data.ind_he = 0;
+        user->N_av_batch            = 0;
+        user->av_epoch              = 0;
+        user->av_refill_pending     = false;
+    }
+
+    return user;
+}
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_hss::insert_user(LTE_FDD_ENB_HSS_USER_STRUCT *user)
+{
+    if(imsi_map.end() != imsi_map.find(user->id.imsi))
+        return LTE_FDD_ENB_ERROR_DUPLICATE_ENTRY;
+
+    user->av_epoch          = next_av_epoch++;
+    imsi_map[user->id.imsi] = user;
+    imei_map.emplace(user->id.imei, user);
 
+    return LTE_FDD_ENB_ERROR_NONE;
+}
+LTE_FDD_ENB_HSS_USER_STRUCT* LTE_fdd_enb_hss::find_user(LTE_FDD_ENB_USER_ID_STRUCT *id)
+{
+    auto user_it = imsi_map.find(id->imsi);
+
+    if(imsi_map.end() != user_it &&
+       id->imei == (*user_it).second->id.imei)
+        return (*user_it).second;
+
+    return NULL;
+}
+void LTE_fdd_enb_hss::erase_user(LTE_FDD_ENB_HSS_USER_STRUCT *user)
+{
+    auto imei_range = imei_map.equal_range(user->id.imei);
+
+    // Other users may share the IMEI
+    for(auto imei_it = imei_range.first; imei_it != imei_range.second; imei_it++)
+    {
+        if(user == (*imei_it).second)
+        {
+            imei_map.erase(imei_it);
             break;
         }
     }
+    imsi_map.erase(user->id.imsi);
+    delete user;
 }
-LTE_FDD_ENB_AUTHENTICATION_VECTOR_STRUCT* LTE_fdd_enb_hss::regenerate_enb_security_data(LTE_FDD_ENB_USER_ID_STRUCT *id,
-                                                                                        uint32                      nas_count_ul)
+
+/*******************************/
+/*    Authentication Tuples    */
+/*******************************/
+void LTE_fdd_enb_hss::av_thread(LTE_fdd_enb_hss *hss)
 {
-    std::lock_guard<std::mutex> lock(user_mutex);
+    std::unique_lock<std::mutex> lock(hss->av_mutex);
+    uint64                       imsi;
 
-    for(auto user : user_list)
+    while(hss->av_thread_run)
     {
-        if(id->imei == user->id.imei &&
-           id->imsi == user->id.imsi)
+        if(hss->av_refill_queue.empty())
         {
-            // Generate K_enb
-            liblte_security_generate_k_enb(user->generated_data.k_asme,
-                                           nas_count_ul,
-                                           user->generated_data.k_enb);
-
-            // Generate K_rrc_enc and K_rrc_int
-            liblte_security_generate_k_rrc(user->generated_data.k_enb,
-                                           LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_EEA0,
-                                           LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA2,
-                                           user->generated_data.auth_vec.k_rrc_enc,
-                                           user->generated_data.auth_vec.k_rrc_int);
-
-            // Generate K_up_enc and K_up_int
-            liblte_security_generate_k_up(user->generated_data.k_enb,
-                                          LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_EEA0,
-                                          LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA2,
-                                          user->generated_data.k_up_enc,
-                                          user->generated_data.k_up_int);
-
-            return &user->generated_data.auth_vec;
+            hss->av_cv.wait(lock);
+            continue;
         }
+
+        imsi = hss->av_refill_queue.front();
+        hss->av_refill_queue.pop_front();
+        lock.unlock();
+        hss->refill_auth_tuples(imsi);
+        lock.lock();
+    }
+}
+void LTE_fdd_enb_hss::generate_auth_tuple(LIBLTE_SECURITY_MILENAGE_KEY_STRUCT *key,
+                                          uint64                              *seq_he,
+                                          uint8                               *ind_he,
+                                          LTE_FDD_ENB_AUTH_TUPLE_STRUCT       *tuple)
+{
+    uint32 i;
+    uint32 rand_val;
+    uint8  sqn[6];
+    uint8  amf[2] = {0x80, 0x00}; // 3GPP 33.102 v10.0.0 Annex H
+
+    // Generate sqn
+    // From 33.102 v10.0.0 section C.3.2
+    *seq_he       = (*seq_he + 1) % LTE_FDD_ENB_SEQ_HE_MAX_VALUE;
+    *ind_he       = (*ind_he + 1) % LTE_FDD_ENB_IND_HE_MAX_VALUE;
+    tuple->sqn_he = (*seq_he << LTE_FDD_ENB_IND_HE_N_BITS) | *ind_he;
+    for(i=0; i<6; i++)
+    {
+        sqn[i] = (tuple->sqn_he >> (5-i)*8) & 0xFF;
     }
 
-    return NULL;
+    // Generate RAND
+    for(i=0; i<4; i++)
+    {
+        rand_val           = rand();
+        tuple->rand[i*4+0] = rand_val & 0xFF;
+        tuple->rand[i*4+1] = (rand_val >> 8) & 0xFF;
+        tuple->rand[i*4+2] = (rand_val >> 16) & 0xFF;
+        tuple->rand[i*4+3] = (rand_val >> 24) & 0xFF;
+    }
+
+    // Generate MAC, RES, CK, IK, and AK
+    liblte_security_milenage_f1(key,
+                                tuple->rand,
+                                sqn,
+                                amf,
+                                tuple->mac);
+    liblte_security_milenage_f2345(key,
+                                   tuple->rand,
+                                   tuple->res,
+                                   tuple->ck,
+                                   tuple->ik,
+                                   tuple->ak);
+
+    // Construct AUTN
+    for(i=0; i<6; i++)
+    {
+        tuple->autn[i] = sqn[i] ^ tuple->ak[i];
+    }
+    for(i=0; i<2; i++)
+    {
+        tuple->autn[6+i] = amf[i];
+    }
+    for(i=0; i<8; i++)
+    {
+        tuple->autn[8+i] = tuple->mac[i];
+    }
 }
-LTE_FDD_ENB_AUTHENTICATION_VECTOR_STRUCT* LTE_fdd_enb_hss::get_auth_vec(LTE_FDD_ENB_USER_ID_STRUCT *id)
+void LTE_fdd_enb_hss::queue_av_refill(LTE_FDD_ENB_HSS_USER_STRUCT *user)
 {
-    std::lock_guard<std::mutex> lock(user_mutex);
+    if(user->av_refill_pending)
+        return;
 
-    for(auto user : user_list)
-        if(id->imei == user->id.imei &&
-           id->imsi == user->id.imsi)
-            return &user->generated_data.auth_vec;
+    user->av_refill_pending = true;
+    av_mutex.lock();
+    av_refill_queue.push_back(user->id.imsi);
+    av_mutex.unlock();
+    av_cv.notify_one();
+}
+void LTE_fdd_enb_hss::refill_auth_tuples(uint64 imsi)
+{
+    LTE_FDD_ENB_HSS_USER_STRUCT         *user;
+    LTE_FDD_ENB_AUTH_TUPLE_STRUCT        tuples[LTE_FDD_ENB_HSS_AV_BATCH_SIZE];
+    LIBLTE_SECURITY_MILENAGE_KEY_STRUCT  key;
+    uint64                               seq_he;
+    uint32                               N_tuples;
+    uint32                               epoch;
+    uint32                               i;
+    uint8                                ind_he;
+
+    // Reserve sequence numbers, then run Milenage without the user lock
+    user_mutex.lock();
+    auto user_it = imsi_map.find(imsi);
+    if(imsi_map.end() == user_it)
+    {
+        user_mutex.unlock();
+        return;
+    }
+    user                    = (*user_it).second;
+    user->av_refill_pending = false;
+    N_tuples                = LTE_FDD_ENB_HSS_AV_BATCH_SIZE - user->N_av_batch;
+    epoch                   = user->av_epoch;
+    seq_he                  = user->generated_data.seq_he;
+    ind_he                  = user->generated_data.ind_he;
+    key                     = user->stored_data.milenage_key;
+    for(i=0; i<N_tuples; i++)
+    {
+        user->generated_data.seq_he = (user->generated_data.seq_he + 1) % LTE_FDD_ENB_SEQ_HE_MAX_VALUE;
+        user->generated_data.ind_he = (user->generated_data.ind_he + 1) % LTE_FDD_ENB_IND_HE_MAX_VALUE;
+    }
+    user_mutex.unlock();
 
-    return NULL;
+    for(i=0; i<N_tuples; i++)
+    {
+        generate_auth_tuple(&key, &seq_he, &ind_he, &tuples[i]);
+    }
+
+    // Drop the batch if the user was deleted, re-added or resynched meanwhile
+    std::lock_guard<std::mutex> lock(user_mutex);
+    user_it = imsi_map.find(imsi);
+    if(imsi_map.end() == user_it        ||
+       user  != (*user_it).second       ||
+       epoch != user->av_epoch          ||
+       LTE_FDD_ENB_HSS_AV_BATCH_SIZE < user->N_av_batch + N_tuples)
+        return;
+    memcpy(&user->av_batch[user->N_av_batch],
+           tuples,
+           N_tuples*sizeof(LTE_FDD_ENB_AUTH_TUPLE_STRUCT));
+    user->N_av_batch += N_tuples;
 }
 
 /*******************/
@@ -410,51 +656,166 @@ LTE_FDD_ENB_AUTHENTICATION_VECTOR_STRUCT* LTE_fdd_enb_hss::get_auth_vec(LTE_FDD_
 /*******************/
 void LTE_fdd_enb_hss::set_use_user_file(bool uuf)
 {
+    std::lock_guard<std::mutex> lock(user_mutex);
+
     use_user_file = uuf;
 
     if(use_user_file)
     {
-        write_user_file();
+        compact_journal();
     }else{
         delete_user_file();
     }
 }
 void LTE_fdd_enb_hss::read_user_file(LTE_fdd_enb_interface *interface)
 {
-    FILE *user_file = fopen("/tmp/LTE_fdd_enb.user_db", "r");
-    if(NULL == user_file)
-        return;
-    char str[LTE_FDD_ENB_MAX_LINE_SIZE];
-    while(NULL != fgets(str, LTE_FDD_ENB_MAX_LINE_SIZE, user_file))
+    if(!replay_journal())
     {
-        std::string line_str = str;
-        interface->handle_add_user(line_str.substr(0, line_str.length()-1));
+        // Migrate the older text based user file
+        FILE *user_file = fopen(LTE_FDD_ENB_HSS_LEGACY_USER_FILE, "r");
+        if(NULL == user_file)
+            return;
+        char str[LTE_FDD_ENB_MAX_LINE_SIZE];
+        while(NULL != fgets(str, LTE_FDD_ENB_MAX_LINE_SIZE, user_file))
+        {
+            std::string line_str = str;
+            interface->handle_add_user("add_user " + line_str.substr(0, line_str.length()-1));
+        }
+        fclose(user_file);
+        remove(LTE_FDD_ENB_HSS_LEGACY_USER_FILE);
     }
-    fclose(user_file);
+    user_mutex.lock();
     use_user_file = true;
+    compact_journal();
+    user_mutex.unlock();
     interface->set_use_user_file("on");
 }
-void LTE_fdd_enb_hss::write_user_file()
+void LTE_fdd_enb_hss::write_journal_records(uint8  *records,
+                                            uint32  N_records)
 {
-    std::lock_guard<std::mutex>  lock(user_mutex);
-    FILE                        *user_file = NULL;
+    // Called with user_mutex held, so records land in the order the
+    // changes were made
+    if(!use_user_file ||
+       NULL == journal_file)
+        return;
+
+    fwrite(records, LTE_FDD_ENB_HSS_JOURNAL_RECORD_SIZE, N_records, journal_file);
+    fflush(journal_file);
+    N_journal_records += N_records;
+
+    // Compact once deletes have left the journal mostly dead records
+    if(LTE_FDD_ENB_HSS_JOURNAL_MIN_COMPACT < N_journal_records &&
+       2*imsi_map.size()                   < N_journal_records)
+        compact_journal();
+}
+void LTE_fdd_enb_hss::pack_journal_record(LTE_FDD_ENB_HSS_JOURNAL_OP_ENUM  op,
+                                          LTE_FDD_ENB_HSS_USER_STRUCT     *user,
+                                          uint8                           *record)
+{
+    uint32 i;
+
+    record[0] = op;
+    for(i=0; i<8; i++)
+    {
+        record[1+i] = (user->id.imsi >> (7-i)*8) & 0xFF;
+        record[9+i] = (user->id.imei >> (7-i)*8) & 0xFF;
+    }
+    memcpy(&record[17], user->stored_data.k, 16);
+}
+bool LTE_fdd_enb_hss::replay_journal()
+{
+    LTE_FDD_ENB_HSS_USER_STRUCT *user;
+    FILE                        *j_file = fopen(journal_name.c_str(), "rb");
+    uint64                       imsi;
+    uint64                       imei;
     uint32                       i;
+    uint8                        record[LTE_FDD_ENB_HSS_JOURNAL_RECORD_SIZE];
+    char                         magic[LTE_FDD_ENB_HSS_JOURNAL_MAGIC_SIZE];
 
-    user_file = fopen("/tmp/LTE_fdd_enodeb.user_db", "w");
+    if(NULL == j_file)
+        return false;
+    if(1 != fread(magic, LTE_FDD_ENB_HSS_JOURNAL_MAGIC_SIZE, 1, j_file) ||
+       0 != memcmp(magic, LTE_FDD_ENB_HSS_JOURNAL_MAGIC, LTE_FDD_ENB_HSS_JOURNAL_MAGIC_SIZE))
+    {
+        fclose(j_file);
+        return false;
+    }
 
-    if(NULL != user_file)
+    // A torn record at the end of the file is ignored
+    std::lock_guard<std::mutex> lock(user_mutex);
+    while(1 == fread(record, LTE_FDD_ENB_HSS_JOURNAL_RECORD_SIZE, 1, j_file))
     {
-        for(auto user : user_list)
+        imsi = 0;
+        imei = 0;
+        for(i=0; i<8; i++)
         {
-            fprintf(user_file, "imsi=%015llu imei=%015llu k=", user->id.imsi, user->id.imei);
-            for(i=0; i<16; i++)
-                fprintf(user_file, "%02X", user->stored_data.k[i]);
-            fprintf(user_file, "\n");
+            imsi = (imsi << 8) | record[1+i];
+            imei = (imei << 8) | record[9+i];
+        }
+        auto user_it = imsi_map.find(imsi);
+        if(imsi_map.end() != user_it)
+            erase_user((*user_it).second);
+        if(LTE_FDD_ENB_HSS_JOURNAL_OP_ADD == record[0])
+        {
+            user = new_user(imsi, imei, &record[17]);
+            if(NULL != user)
+            {
+                insert_user(user);
+                queue_av_refill(user);
+            }
         }
-        fclose(user_file);
+    }
+    fclose(j_file);
+
+    return true;
+}
+void LTE_fdd_enb_hss::compact_journal()
+{
+    std::vector<uint8>  records;
+    std::string         tmp_name = journal_name + ".tmp";
+    FILE               *tmp_file;
+    uint32              N_records = 0;
+
+    // Called with user_mutex held
+    if(NULL != journal_file)
+    {
+        fclose(journal_file);
+        journal_file = NULL;
+    }
+
+    records.resize(imsi_map.size()*LTE_FDD_ENB_HSS_JOURNAL_RECORD_SIZE);
+    for(auto user : imsi_map)
+    {
+        pack_journal_record(LTE_FDD_ENB_HSS_JOURNAL_OP_ADD,
+                            user.second,
+                            &records[N_records*LTE_FDD_ENB_HSS_JOURNAL_RECORD_SIZE]);
+        N_records++;
+    }
+
+    // Write a snapshot and atomically replace the journal with it
+    tmp_file = fopen(tmp_name.c_str(), "wb");
+    if(NULL == tmp_file)
+        return;
+    fwrite(LTE_FDD_ENB_HSS_JOURNAL_MAGIC, LTE_FDD_ENB_HSS_JOURNAL_MAGIC_SIZE, 1, tmp_file);
+    if(0 != N_records)
+        fwrite(&records[0], LTE_FDD_ENB_HSS_JOURNAL_RECORD_SIZE, N_records, tmp_file);
+    fclose(tmp_file);
+    if(0 == rename(tmp_name.c_str(), journal_name.c_str()))
+    {
+        journal_file      = fopen(journal_name.c_str(), "ab");
+        N_journal_records = N_records;
     }
 }
 void LTE_fdd_enb_hss::delete_user_file()
 {
-    remove("/tmp/LTE_fdd_enodeb.user_db");
+    // Called with user_mutex held
+    if(NULL != journal_file)
+    {
+        fclose(journal_file);
+        journal_file = NULL;
+    }
+    N_journal_records = 0;
+
+    remove(journal_name.c_str());
+    remove(LTE_FDD_ENB_HSS_LEGACY_USER_FILE);
 }
@@ -77,7 +77,6 @@
 #include "libtools_helpers.h"
 #include <boost/lexical_cast.hpp>
 #include <arpa/inet.h>
-#include <sys/time.h>
 #include <stdarg.h>
 
 /*******************************************************************************
@@ -103,13 +102,17 @@
 /*    Constructor/Destructor    */
 /********************************/
 LTE_fdd_enb_interface::LTE_fdd_enb_interface() :
-    ctrl_socket{NULL}, debug_socket{NULL}, ctrl_connected{false}, debug_connected{false},
+    ctrl_socket{NULL}, debug_socket{NULL}, ctrl_connected{false}, N_debug_clients{0},
+    debug_log{new LTE_fdd_enb_debug_log(this)}, debug_enabled_mask{0},
+    cpu{new LTE_fdd_enb_cpu()}, metrics{new LTE_fdd_enb_metrics()},
     shutdown_token{"shutdown"}, start_token{"start"}, stop_token{"stop"},
     construct_si_token{"construct_si"}, add_user_token{"add_user"},
     delete_user_token{"delete_user"}, print_users_token{"print_users"},
-    print_registered_users_token{"print_registered_users"},
+    print_registered_users_token{"print_registered_users"}, import_users_token{"import_users"},
+    print_metrics_token{"print_metrics"},
     read_token{"read"}, write_token{"write"}, help_token{"help"}, bandwidth_token{"bandwidth"},
     band_token{"band"}, dl_earfcn_token{"dl_earfcn"}, n_ant_token{"n_ant"},
+    max_users_token{"max_users"},
     n_id_cell_token{"n_id_cell"}, mcc_token{"mcc"}, mnc_token{"mnc"},
     cell_id_token{"cell_id"}, tracking_area_code_token{"tracking_area_code"},
     q_rx_lev_min_token{"q_rx_lev_min"}, si_periodicity_token{"si_periodicity"},
@@ -120,24 +123,33 @@ LTE_fdd_enb_interface::LTE_fdd_enb_interface() :
     sib7_present_token{"sib7_present"}, sib8_present_token{"sib8_present"},
     mac_direct_to_ue_token{"mac_direct_to_ue"}, phy_direct_to_ue_token{"phy_direct_to_ue"},
     debug_type_token{"debug_type"}, debug_level_token{"debug_level"},
-    enable_pcap_token{"enable_pcap"}, ip_addr_start_token{"ip_addr_start"},
+    dl_scheduler_token{"dl_scheduler"}, dl_ra_type_token{"dl_ra_type"},
+    enable_pcap_token{"enable_pcap"}, enable_metrics_token{"enable_metrics"},
+    ip_addr_start_token{"ip_addr_start"},
     dns_addr_token{"dns_addr"}, use_cnfg_file_token{"use_cnfg_file"},
     use_user_file_token{"use_user_file"}, available_radios_token{"available_radios"},
     selected_radio_name_token{"selected_radio_name"},
     selected_radio_idx_token{"selected_radio_idx"}, clock_source_token{"clock_source"},
-    tx_gain_token{"tx_gain"}, rx_gain_token{"rx_gain"}, imsi_token{"imsi"}, imei_token{"imei"},
-    k_token{"k"}, timer_mgr{new LTE_fdd_enb_timer_mgr(this)},
+    tx_gain_token{"tx_gain"}, rx_gain_token{"rx_gain"}, sim_ul_file_token{"sim_ul_file"},
+    sim_dl_file_token{"sim_dl_file"}, sim_pace_token{"sim_pace"},
+    sim_loopback_token{"sim_loopback"}, radio_thread_token{"radio_thread"},
+    mac_thread_token{"mac_thread"}, msgq_thread_token{"msgq_thread"},
+    gw_thread_token{"gw_thread"}, cpu_topology_token{"cpu_topology"},
+    imsi_token{"imsi"}, imei_token{"imei"},
+    k_token{"k"}, file_token{"file"}, timer_mgr{new LTE_fdd_enb_timer_mgr(this)},
     user_mgr{new LTE_fdd_enb_user_mgr(this, timer_mgr)}, hss{new LTE_fdd_enb_hss()},
     gw{new LTE_fdd_enb_gw(this, user_mgr)}, mme{new LTE_fdd_enb_mme(this, user_mgr, hss)},
     pdcp{new LTE_fdd_enb_pdcp(this)}, rlc{new LTE_fdd_enb_rlc(this)},
     mac{new LTE_fdd_enb_mac(this, timer_mgr, user_mgr, rlc)},
     phy{new LTE_fdd_enb_phy(this, mac)}, radio{new LTE_fdd_enb_radio(this, phy)},
+    dl_scheduler{LIBLTE_MAC_DL_SCHED_POLICY_PROPORTIONAL_FAIR},
+    dl_ra_type{LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_2},
     N_rb_dl{LIBLTE_PHY_N_RB_DL_10MHZ}, N_rb_ul{LIBLTE_PHY_N_RB_UL_10MHZ},
     dl_center_freq{liblte_interface_dl_earfcn_to_frequency(liblte_interface_first_dl_earfcn[0])},
     ul_center_freq{liblte_interface_dl_earfcn_to_frequency(liblte_interface_get_corresponding_ul_earfcn(liblte_interface_first_dl_earfcn[0]))},
     N_sc_rb_dl{LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP}, N_sc_rb_ul{LIBLTE_PHY_N_SC_RB_UL},
     debug_type{0xFFFFFFFF}, debug_level{0xFFFFFFFF}, ip_addr_start{0xC0A80102},
-    dns_addr{0xC0A80101}, N_id_cell{0}, dl_earfcn{liblte_interface_first_dl_earfcn[0]},
+    dns_addr{0xC0A80101}, max_users{LTE_FDD_ENB_DEFAULT_MAX_USERS}, N_id_cell{0}, dl_earfcn{liblte_interface_first_dl_earfcn[0]},
     ul_earfcn{liblte_interface_get_corresponding_ul_earfcn(dl_earfcn)}, N_ant{1},
     N_id_1{0}, N_id_2{0}, shutdown{false}, started{false}, sib3_present{false},
     sib4_present{false}, sib5_present{false}, sib6_present{false}, sib7_present{false},
@@ -193,7 +205,7 @@ LTE_fdd_enb_interface::LTE_fdd_enb_interface() :
     sys_info.sib2.radioResourceConfigCommon_Set()->rach_ConfigCommon_Set()->ra_SupervisionInfo_value.preambleTransMax_SetValue(RACH_ConfigCommon::ra_SupervisionInfo::k_preambleTransMax_n200);
     sys_info.sib2.radioResourceConfigCommon_Set()->rach_ConfigCommon_Set()->ra_SupervisionInfo_value.ra_ResponseWindowSize_SetValue(RACH_ConfigCommon::ra_SupervisionInfo::k_ra_ResponseWindowSize_sf7);
     sys_info.sib2.radioResourceConfigCommon_Set()->rach_ConfigCommon_Set()->ra_SupervisionInfo_value.mac_ContentionResolutionTimer_SetValue(RACH_ConfigCommon::ra_SupervisionInfo::k_mac_ContentionResolutionTimer_sf64);
-    sys_info.sib2.radioResourceConfigCommon_Set()->rach_ConfigCommon_Set()->maxHARQ_Msg3Tx_SetValue(1);
+    sys_info.sib2.radioResourceConfigCommon_Set()->rach_ConfigCommon_Set()->maxHARQ_Msg3Tx_SetValue(LTE_FDD_ENB_MAX_UL_HARQ_TX);
     sys_info.sib2.radioResourceConfigCommon_Set()->bcch_Config_Set()->modificationPeriodCoeff_SetValue(BCCH_Config::k_modificationPeriodCoeff_n2);
     sys_info.sib2.radioResourceConfigCommon_Set()->pcch_Config_Set()->defaultPagingCycle_SetValue(PCCH_Config::k_defaultPagingCycle_rf256);
     sys_info.sib2.radioResourceConfigCommon_Set()->pcch_Config_Set()->nB_SetValue(PCCH_Config::k_nB_oneT);
@@ -272,15 +284,17 @@ LTE_fdd_enb_interface::LTE_fdd_enb_interface() :
     sys_info.sib8.parametersHRPD_value.Clear();
     sys_info.sib8.parameters1XRTT_value.Clear();
 
-    open_lte_pcap_fd();
-    open_ip_pcap_fd();
+    lte_pcap = new LTE_fdd_enb_pcap(this, "/tmp/LTE_fdd_enodeb.pcap", 147);
+    ip_pcap  = new LTE_fdd_enb_pcap(this, "/tmp/LTE_fdd_enodeb_ip.pcap", 228);
 }
 LTE_fdd_enb_interface::~LTE_fdd_enb_interface()
 {
     stop_ports();
-
-    fclose(lte_pcap_fd);
-    fclose(ip_pcap_fd);
+    delete lte_pcap;
+    delete ip_pcap;
+    delete debug_log;
+    delete cpu;
+    delete metrics;
 }
 
 /***********************/
@@ -354,7 +368,13 @@ void LTE_fdd_enb_interface::start_debug_port()
                                               error_cb,
                                               error);
     if(LIBTOOLS_SERVER_SOCKET_ERROR_NONE == error)
+    {
+        // Monitoring clients that fall behind lose lines instead of
+        // holding up the eNodeB
+        debug_socket->set_slow_client_policy(LTE_FDD_ENB_DEBUG_HIGH_WATER_MARK,
+                                             LIBTOOLS_SERVER_SOCKET_SLOW_CLIENT_DROP);
         return;
+    }
     printf("Couldn't open debug_socket %s\n", libtools_server_socket_error_text[error]);
     debug_socket = NULL;
 }
@@ -365,29 +385,38 @@ void LTE_fdd_enb_interface::stop_ports()
 }
 void LTE_fdd_enb_interface::stop_ctrl_port()
 {
-    std::lock_guard<std::mutex> lock(ctrl_mutex);
-
-    if(NULL == ctrl_socket)
-        return;
+    libtools_server_socket *socket;
 
-    delete ctrl_socket;
+    // Deleting joins the socket thread, which may be waiting on the
+    // mutex in a callback
+    ctrl_mutex.lock();
+    socket      = ctrl_socket;
     ctrl_socket = NULL;
+    ctrl_mutex.unlock();
+
+    delete socket;
 }
 void LTE_fdd_enb_interface::stop_debug_port()
 {
-    std::lock_guard<std::mutex> lock(debug_mutex);
-
-    if(NULL == debug_socket)
-        return;
+    libtools_server_socket *socket;
 
-    delete debug_socket;
+    debug_mutex.lock();
+    socket       = debug_socket;
     debug_socket = NULL;
+    debug_mutex.unlock();
+
+    delete socket;
+
+    // Clients are closed without disconnect callbacks
+    std::lock_guard<std::mutex> lock(debug_mutex);
+    N_debug_clients = 0;
+    update_debug_enabled_mask();
 }
 void LTE_fdd_enb_interface::send_ctrl_msg(std::string msg)
 {
     std::lock_guard<std::mutex> lock(ctrl_mutex);
 
-    if(!ctrl_connected)
+    if(!ctrl_connected || NULL == ctrl_socket)
         return;
 
     ctrl_socket->send(msg + "\n", ctrl_sock_fd);
@@ -405,328 +434,25 @@ void LTE_fdd_enb_interface::send_ctrl_info_msg(std::string msg, ...)
     free(args_msg);
     send_ctrl_msg(tmp_msg);
 }
-void LTE_fdd_enb_interface::send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ENUM  type,
-                                           LTE_FDD_ENB_DEBUG_LEVEL_ENUM level,
-                                           std::string                  file_name,
-                                           int32                        line,
-                                           std::string                  msg,
-                                           ...)
-{
-    std::lock_guard<std::mutex>  lock(debug_mutex);
-    std::string                  tmp_msg;
-    va_list                      args;
-    char                        *args_msg;
-
-    if(!debug_connected             ||
-       !(debug_type  & (1 << type)) ||
-       !(debug_level & (1 << level)))
-        return;
-
-    // Format the output string
-    get_formatted_time(tmp_msg);
-    tmp_msg += " ";
-    tmp_msg += LTE_fdd_enb_debug_type_text[type];
-    tmp_msg += " ";
-    tmp_msg += LTE_fdd_enb_debug_level_text[level];
-    tmp_msg += " ";
-    tmp_msg += file_name.c_str();
-    tmp_msg += " ";
-    tmp_msg += std::to_string(line);
-    tmp_msg += " ";
-    va_start(args, msg);
-    if(-1 != vasprintf(&args_msg, msg.c_str(), args))
-        tmp_msg += args_msg;
-    tmp_msg += "\n";
-
-    // Cleanup the variable argument string
-    free(args_msg);
-
-    debug_socket->send(tmp_msg, debug_sock_fd);
-}
-void LTE_fdd_enb_interface::send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ENUM   type,
-                                           LTE_FDD_ENB_DEBUG_LEVEL_ENUM  level,
-                                           std::string                   file_name,
-                                           int32                         line,
-                                           LIBLTE_BIT_MSG_STRUCT        *lte_msg,
-                                           std::string                   msg,
-                                           ...)
-{
-    std::lock_guard<std::mutex>  lock(debug_mutex);
-    std::string                  tmp_msg;
-    va_list                      args;
-    uint32                       i;
-    uint32                       hex_val;
-    char                        *args_msg;
-
-    if(!debug_connected             ||
-       !(debug_type  & (1 << type)) ||
-       !(debug_level & (1 << level)))
-        return;
-
-    // Format the output string
-    get_formatted_time(tmp_msg);
-    tmp_msg += " ";
-    tmp_msg += LTE_fdd_enb_debug_type_text[type];
-    tmp_msg += " ";
-    tmp_msg += LTE_fdd_enb_debug_level_text[level];
-    tmp_msg += " ";
-    tmp_msg += file_name.c_str();
-    tmp_msg += " ";
-    tmp_msg += std::to_string(line);
-    tmp_msg += " ";
-    va_start(args, msg);
-    if(-1 != vasprintf(&args_msg, msg.c_str(), args))
-        tmp_msg += args_msg;
-    tmp_msg += " ";
-    hex_val  = 0;
-    for(i=0; i<lte_msg->N_bits; i++)
-    {
-        hex_val <<= 1;
-        hex_val  |= lte_msg->msg[i];
-        if((i % 4) == 3)
-        {
-            if(hex_val < 0xA)
-            {
-                tmp_msg += (char)(hex_val + '0');
-            }else{
-                tmp_msg += (char)((hex_val-0xA) + 'A');
-            }
-            hex_val = 0;
-        }
-    }
-    if((lte_msg->N_bits % 4) != 0)
-    {
-        for(i=0; i<4-(lte_msg->N_bits % 4); i++)
-        {
-            hex_val <<= 1;
-        }
-        if(hex_val < 0xA)
-        {
-            tmp_msg += (char)(hex_val + '0');
-        }else{
-            tmp_msg += (char)((hex_val-0xA) + 'A');
-        }
-    }
-    tmp_msg += "\n";
-
-    // Cleanup the variable argument string
-    free(args_msg);
-
-    debug_socket->send(tmp_msg, debug_sock_fd);
-}
-void LTE_fdd_enb_interface::send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ENUM   type,
-                                           LTE_FDD_ENB_DEBUG_LEVEL_ENUM  level,
-                                           std::string                   file_name,
-                                           int32                         line,
-                                           std::vector<bool>            &lte_msg,
-                                           std::string                   msg,
-                                           ...)
-{
-    std::lock_guard<std::mutex>  lock(debug_mutex);
-    std::string                  tmp_msg;
-    va_list                      args;
-    uint32                       i;
-    uint32                       hex_val;
-    char                        *args_msg;
-
-    if(!debug_connected             ||
-       !(debug_type  & (1 << type)) ||
-       !(debug_level & (1 << level)))
-        return;
-
-    // Format the output string
-    get_formatted_time(tmp_msg);
-    tmp_msg += " ";
-    tmp_msg += LTE_fdd_enb_debug_type_text[type];
-    tmp_msg += " ";
-    tmp_msg += LTE_fdd_enb_debug_level_text[level];
-    tmp_msg += " ";
-    tmp_msg += file_name.c_str();
-    tmp_msg += " ";
-    tmp_msg += std::to_string(line);
-    tmp_msg += " ";
-    va_start(args, msg);
-    if(-1 != vasprintf(&args_msg, msg.c_str(), args))
-        tmp_msg += args_msg;
-    tmp_msg += " ";
-    hex_val  = 0;
-    for(i=0; i<lte_msg.size(); i++)
-    {
-        hex_val <<= 1;
-        hex_val  |= lte_msg[i];
-        if((i % 4) == 3)
-        {
-            if(hex_val < 0xA)
-            {
-                tmp_msg += (char)(hex_val + '0');
-            }else{
-                tmp_msg += (char)((hex_val-0xA) + 'A');
-            }
-            hex_val = 0;
-        }
-    }
-    if((lte_msg.size() % 4) != 0)
-    {
-        for(i=0; i<4-(lte_msg.size() % 4); i++)
-        {
-            hex_val <<= 1;
-        }
-        if(hex_val < 0xA)
-        {
-            tmp_msg += (char)(hex_val + '0');
-        }else{
-            tmp_msg += (char)((hex_val-0xA) + 'A');
-        }
-    }
-    tmp_msg += "\n";
-
-    // Cleanup the variable argument string
-    free(args_msg);
-
-    debug_socket->send(tmp_msg, debug_sock_fd);
-}
-void LTE_fdd_enb_interface::send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ENUM   type,
-                                           LTE_FDD_ENB_DEBUG_LEVEL_ENUM  level,
-                                           std::string                   file_name,
-                                           int32                         line,
-                                           LIBLTE_BYTE_MSG_STRUCT       *lte_msg,
-                                           std::string                   msg,
-                                           ...)
+void LTE_fdd_enb_interface::send_debug_log(const std::string &msg)
 {
-    std::lock_guard<std::mutex>  lock(debug_mutex);
-    std::string                  tmp_msg;
-    va_list                      args;
-    char                        *args_msg;
+    std::lock_guard<std::mutex> lock(debug_mutex);
 
-    if(!debug_connected             ||
-       !(debug_type  & (1 << type)) ||
-       !(debug_level & (1 << level)))
+    if(0 == N_debug_clients || NULL == debug_socket)
         return;
 
-    // Format the output string
-    get_formatted_time(tmp_msg);
-    tmp_msg += " ";
-    tmp_msg += LTE_fdd_enb_debug_type_text[type];
-    tmp_msg += " ";
-    tmp_msg += LTE_fdd_enb_debug_level_text[level];
-    tmp_msg += " ";
-    tmp_msg += file_name.c_str();
-    tmp_msg += " ";
-    tmp_msg += std::to_string(line);
-    tmp_msg += " ";
-    va_start(args, msg);
-    if(-1 != vasprintf(&args_msg, msg.c_str(), args))
-        tmp_msg += args_msg;
-    tmp_msg += " msg_size=" + std::to_string(lte_msg->N_bytes);
-    if(lte_msg->N_bytes > 0)
-    {
-        tmp_msg += " " + to_string(lte_msg->msg, lte_msg->N_bytes) + "\n";
-    }else{
-        tmp_msg += "\n";
-    }
-
-    // Cleanup the variable argument string
-    free(args_msg);
-
-    debug_socket->send(tmp_msg, debug_sock_fd);
+    debug_socket->send_all(msg);
 }
-void LTE_fdd_enb_interface::send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ENUM   type,
-                                           LTE_FDD_ENB_DEBUG_LEVEL_ENUM  level,
-                                           std::string                   file_name,
-                                           int32                         line,
-                                           const std::vector<uint8_t>   &lte_msg,
-                                           std::string                   msg,
-                                           ...)
+void LTE_fdd_enb_interface::update_debug_enabled_mask()
 {
-    std::lock_guard<std::mutex>  lock(debug_mutex);
-    std::string                  tmp_msg;
-    va_list                      args;
-    char                        *args_msg;
-
-    if(!debug_connected             ||
-       !(debug_type  & (1 << type)) ||
-       !(debug_level & (1 << level)))
-        return;
-
-    // Format the output string
-    get_formatted_time(tmp_msg);
-    tmp_msg += " ";
-    tmp_msg += LTE_fdd_enb_debug_type_text[type];
-    tmp_msg += " ";
-    tmp_msg += LTE_fdd_enb_debug_level_text[level];
-    tmp_msg += " ";
-    tmp_msg += file_name.c_str();
-    tmp_msg += " ";
-    tmp_msg += std::to_string(line);
-    tmp_msg += " ";
-    va_start(args, msg);
-    if(-1 != vasprintf(&args_msg, msg.c_str(), args))
-        tmp_msg += args_msg;
-    tmp_msg += " msg_size=" + std::to_string(lte_msg.size());
-    tmp_msg += "\n";
-
-    // Cleanup the variable argument string
-    free(args_msg);
+    uint64 mask = 0;
 
-    debug_socket->send(tmp_msg, debug_sock_fd);
-}
-void LTE_fdd_enb_interface::open_lte_pcap_fd()
-{
-    uint32 magic_number = 0xa1b2c3d4;
-    uint32 timezone     = 0;
-    uint32 sigfigs      = 0;
-    uint32 snap_len     = 0xFFFF;
-    uint32 dlt          = 147;
-    uint32 tmp_u32;
-    uint16 major_version = 2;
-    uint16 minor_version = 4;
-    uint16 tmp_u16;
-
-    lte_pcap_fd = fopen("/tmp/LTE_fdd_enodeb.pcap", "w");
-
-    tmp_u32 = htonl(magic_number);
-    fwrite(&tmp_u32, sizeof(tmp_u32), 1, lte_pcap_fd);
-    tmp_u16 = htons(major_version);
-    fwrite(&tmp_u16, sizeof(tmp_u16), 1, lte_pcap_fd);
-    tmp_u16 = htons(minor_version);
-    fwrite(&tmp_u16, sizeof(tmp_u16), 1, lte_pcap_fd);
-    tmp_u32 = htonl(timezone);
-    fwrite(&tmp_u32, sizeof(tmp_u32), 1, lte_pcap_fd);
-    tmp_u32 = htonl(sigfigs);
-    fwrite(&tmp_u32, sizeof(tmp_u32), 1, lte_pcap_fd);
-    tmp_u32 = htonl(snap_len);
-    fwrite(&tmp_u32, sizeof(tmp_u32), 1, lte_pcap_fd);
-    tmp_u32 = htonl(dlt);
-    fwrite(&tmp_u32, sizeof(tmp_u32), 1, lte_pcap_fd);
-}
-void LTE_fdd_enb_interface::open_ip_pcap_fd()
-{
-    uint32 magic_number = 0xa1b2c3d4;
-    uint32 timezone     = 0;
-    uint32 sigfigs      = 0;
-    uint32 snap_len     = 0xFFFF;
-    uint32 dlt          = 228;
-    uint32 tmp_u32;
-    uint16 major_version = 2;
-    uint16 minor_version = 4;
-    uint16 tmp_u16;
-
-    ip_pcap_fd = fopen("/tmp/LTE_fdd_enodeb_ip.pcap", "w");
-
-    tmp_u32 = htonl(magic_number);
-    fwrite(&tmp_u32, sizeof(tmp_u32), 1, ip_pcap_fd);
-    tmp_u16 = htons(major_version);
-    fwrite(&tmp_u16, sizeof(tmp_u16), 1, ip_pcap_fd);
-    tmp_u16 = htons(minor_version);
-    fwrite(&tmp_u16, sizeof(tmp_u16), 1, ip_pcap_fd);
-    tmp_u32 = htonl(timezone);
-    fwrite(&tmp_u32, sizeof(tmp_u32), 1, ip_pcap_fd);
-    tmp_u32 = htonl(sigfigs);
-    fwrite(&tmp_u32, sizeof(tmp_u32), 1, ip_pcap_fd);
-    tmp_u32 = htonl(snap_len);
-    fwrite(&tmp_u32, sizeof(tmp_u32), 1, ip_pcap_fd);
-    tmp_u32 = htonl(dlt);
-    fwrite(&tmp_u32, sizeof(tmp_u32), 1, ip_pcap_fd);
+    if(0 != N_debug_clients)
+        for(uint32 i=0; i<LTE_FDD_ENB_DEBUG_TYPE_N_ITEMS; i++)
+            for(uint32 j=0; j<LTE_FDD_ENB_DEBUG_LEVEL_N_ITEMS; j++)
+                if((debug_type & (1 << i)) && (debug_level & (1 << j)))
+                    mask |= 1ULL << (i*LTE_FDD_ENB_DEBUG_LEVEL_N_ITEMS + j);
+    debug_enabled_mask.store(mask, std::memory_order_relaxed);
 }
 void LTE_fdd_enb_interface::send_lte_pcap_msg(LTE_FDD_ENB_PCAP_DIRECTION_ENUM  dir,
                                               uint32                           rnti,
@@ -734,21 +460,20 @@ void LTE_fdd_enb_interface::send_lte_pcap_msg(LTE_FDD_ENB_PCAP_DIRECTION_ENUM  d
                                               uint8                           *msg,
                                               uint32                           N_bits)
 {
-    struct timeval  time;
-    struct timezone time_zone;
-    uint32          i;
-    uint32          idx;
-    uint32          length;
-    uint32          tmp_u32;
-    uint16          tmp_u16;
-    uint8           pcap_c_hdr[15];
-    uint8           pcap_msg[LIBLTE_MAX_MSG_SIZE*2];
+    uint32  i;
+    uint32  N_bytes;
+    uint16  tmp_u16;
+    uint8  *pcap_c_hdr;
+    uint8  *pcap_msg;
 
     if(!enable_pcap)
         return;
 
-    // Get approximate time stamp
-    gettimeofday(&time, &time_zone);
+    // Build the record in place, dropped if the writer is behind
+    N_bytes    = N_bits / 8;
+    pcap_c_hdr = lte_pcap->start_record(15 + N_bytes);
+    if(NULL == pcap_c_hdr)
+        return;
 
     // Radio Type
     pcap_c_hdr[0] = 1;
@@ -795,57 +520,31 @@ void LTE_fdd_enb_interface::send_lte_pcap_msg(LTE_FDD_ENB_PCAP_DIRECTION_ENUM  d
     // Payload Tag
     pcap_c_hdr[14] = 1;
 
-    // Payload
-    idx           = 0;
-    pcap_msg[idx] = 0;
-    for(i=0; i<N_bits; i++)
+    // Payload, packed straight into the record
+    pcap_msg = &pcap_c_hdr[15];
+    for(i=0; i<N_bytes; i++)
     {
-        pcap_msg[idx] <<= 1;
-        pcap_msg[idx]  |= msg[i];
-        if((i % 8) == 7)
-        {
-            idx++;
-            pcap_msg[idx] = 0;
-        }
+        pcap_msg[i] = ((msg[0] << 7) | (msg[1] << 6) | (msg[2] << 5) | (msg[3] << 4) |
+                       (msg[4] << 3) | (msg[5] << 2) | (msg[6] << 1) | msg[7]);
+        msg += 8;
     }
 
-    // Total Length
-    length = 15 + idx;
-
-    // Write Data
-    tmp_u32 = htonl(time.tv_sec);
-    fwrite(&tmp_u32, sizeof(uint32), 1, lte_pcap_fd);
-    tmp_u32 = htonl(time.tv_usec);
-    fwrite(&tmp_u32, sizeof(uint32), 1, lte_pcap_fd);
-    tmp_u32 = htonl(length);
-    fwrite(&tmp_u32,   sizeof(uint32), 1,   lte_pcap_fd);
-    fwrite(&tmp_u32,   sizeof(uint32), 1,   lte_pcap_fd);
-    fwrite(pcap_c_hdr, sizeof(uint8),  15,  lte_pcap_fd);
-    fwrite(pcap_msg,   sizeof(uint8),  idx, lte_pcap_fd);
+    lte_pcap->end_record();
 }
 void LTE_fdd_enb_interface::send_ip_pcap_msg(uint8 *msg, uint32 N_bytes)
 {
-    struct timeval  time;
-    struct timezone time_zone;
-    uint32          tmp;
+    uint8 *pcap_msg;
 
     if(!enable_pcap)
         return;
 
-    // Get approximate time stamp
-    gettimeofday(&time, &time_zone);
-
-    // Write Data
-    tmp = htonl(time.tv_sec);
-    fwrite(&tmp, sizeof(uint32), 1, ip_pcap_fd);
-    tmp = htonl(time.tv_usec);
-    fwrite(&tmp, sizeof(uint32), 1, ip_pcap_fd);
-    tmp = htonl(N_bytes);
-    fwrite(&tmp, sizeof(uint32), 1,       ip_pcap_fd);
-    fwrite(&tmp, sizeof(uint32), 1,       ip_pcap_fd);
-    fwrite(msg,  sizeof(uint8),  N_bytes, ip_pcap_fd);
+    pcap_msg = ip_pcap->start_record(N_bytes);
+    if(NULL == pcap_msg)
+        return;
+    memcpy(pcap_msg, msg, N_bytes);
+    ip_pcap->end_record();
 }
-void LTE_fdd_enb_interface::handle_ctrl_msg(const std::string msg, const int32 sock_fd)
+void LTE_fdd_enb_interface::handle_ctrl_msg(std::string_view msg, const int32 sock_fd)
 {
     if(0 == msg.find(shutdown_token))
     {
@@ -872,8 +571,12 @@ void LTE_fdd_enb_interface::handle_ctrl_msg(const std::string msg, const int32 s
         return handle_delete_user(msg);
     if(0 == msg.find(print_users_token))
         return handle_print_users();
+    if(0 == msg.find(import_users_token))
+        return handle_import_users(msg);
     if(0 == msg.find(print_registered_users_token))
         return handle_print_registered_users();
+    if(0 == msg.find(print_metrics_token))
+        return handle_print_metrics();
     if(0 == msg.find(read_token))
         return handle_read(msg);
     if(0 == msg.find(write_token))
@@ -912,15 +615,15 @@ void LTE_fdd_enb_interface::handle_ctrl_error(const LIBTOOLS_SERVER_SOCKET_ERROR
                    libtools_server_socket_error_text[err]);
     assert(0);
 }
-void LTE_fdd_enb_interface::handle_debug_msg(const std::string msg, const int32 sock_fd)
+void LTE_fdd_enb_interface::handle_debug_msg(std::string_view msg, const int32 sock_fd)
 {
     // No messages to handle
 }
 void LTE_fdd_enb_interface::handle_debug_connect(const int32 sock_fd)
 {
     debug_mutex.lock();
-    debug_connected = true;
-    debug_sock_fd = sock_fd;
+    N_debug_clients++;
+    update_debug_enabled_mask();
     debug_mutex.unlock();
 
     send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
@@ -933,7 +636,8 @@ void LTE_fdd_enb_interface::handle_debug_disconnect(const int32 sock_fd)
 {
     std::lock_guard<std::mutex> lock(debug_mutex);
 
-    debug_connected = false;
+    N_debug_clients--;
+    update_debug_enabled_mask();
 }
 void LTE_fdd_enb_interface::handle_debug_error(const LIBTOOLS_SERVER_SOCKET_ERROR_ENUM err)
 {
@@ -941,14 +645,30 @@ void LTE_fdd_enb_interface::handle_debug_error(const LIBTOOLS_SERVER_SOCKET_ERRO
     assert(0);
 }
 
+/***********************/
+/*    CPU placement    */
+/***********************/
+LTE_fdd_enb_cpu* LTE_fdd_enb_interface::get_cpu()
+{
+    return cpu;
+}
+
+/*****************/
+/*    Metrics    */
+/*****************/
+LTE_fdd_enb_metrics* LTE_fdd_enb_interface::get_metrics()
+{
+    return metrics;
+}
+
 /******************/
 /*    Handlers    */
 /******************/
-void LTE_fdd_enb_interface::handle_read(std::string msg)
+void LTE_fdd_enb_interface::handle_read(std::string_view msg)
 {
     if(0 != msg.find(read_token + " "))
         return send_ctrl_msg("fail invalid " + read_token + " command");
-    std::string param = msg.substr(read_token.length() + 1);
+    std::string_view param = msg.substr(read_token.length() + 1);
     if(0 == param.find(bandwidth_token))
         return send_ctrl_msg("ok " + get_bandwidth_string());
     if(0 == param.find(band_token))
@@ -957,6 +677,8 @@ void LTE_fdd_enb_interface::handle_read(std::string msg)
         return send_ctrl_msg("ok " + std::to_string(dl_earfcn));
     if(0 == param.find(n_ant_token))
         return send_ctrl_msg("ok " + std::to_string(N_ant));
+    if(0 == param.find(max_users_token))
+        return send_ctrl_msg("ok " + std::to_string(max_users));
     if(0 == param.find(n_id_cell_token))
         return send_ctrl_msg("ok " + std::to_string(N_id_cell));
     if(0 == param.find(mcc_token))
@@ -999,8 +721,14 @@ void LTE_fdd_enb_interface::handle_read(std::string msg)
         return send_ctrl_msg("ok " + get_debug_type_string());
     if(0 == param.find(debug_level_token))
         return send_ctrl_msg("ok " + get_debug_level_string());
+    if(0 == param.find(dl_scheduler_token))
+        return send_ctrl_msg("ok " + get_dl_scheduler_string());
+    if(0 == param.find(dl_ra_type_token))
+        return send_ctrl_msg("ok " + get_dl_ra_type_string());
     if(0 == param.find(enable_pcap_token))
         return send_ctrl_msg("ok " + get_enable_pcap_string());
+    if(0 == param.find(enable_metrics_token))
+        return send_ctrl_msg("ok " + get_enable_metrics_string());
     if(0 == param.find(ip_addr_start_token))
         return send_ctrl_msg("ok " + get_ip_addr_start_string());
     if(0 == param.find(dns_addr_token))
@@ -1026,13 +754,32 @@ void LTE_fdd_enb_interface::handle_read(std::string msg)
     if(0 == param.find(rx_gain_token))
         return send_ctrl_msg(
             "ok " + std::to_string(radio->get_rx_gain()));
+    if(0 == param.find(sim_ul_file_token))
+        return send_ctrl_msg("ok " + radio->get_sim_ul_file());
+    if(0 == param.find(sim_dl_file_token))
+        return send_ctrl_msg("ok " + radio->get_sim_dl_file());
+    if(0 == param.find(sim_pace_token))
+        return send_ctrl_msg("ok " + radio->get_sim_pace());
+    if(0 == param.find(sim_loopback_token))
+        return send_ctrl_msg("ok " + radio->get_sim_loopback());
+    if(0 == param.find(radio_thread_token))
+        return send_ctrl_msg("ok " + cpu->get_thread_cnfg_string(LTE_FDD_ENB_THREAD_ROLE_RADIO));
+    if(0 == param.find(mac_thread_token))
+        return send_ctrl_msg("ok " + cpu->get_thread_cnfg_string(LTE_FDD_ENB_THREAD_ROLE_MAC));
+    if(0 == param.find(msgq_thread_token))
+        return send_ctrl_msg("ok " + cpu->get_thread_cnfg_string(LTE_FDD_ENB_THREAD_ROLE_MSGQ));
+    if(0 == param.find(gw_thread_token))
+        return send_ctrl_msg("ok " + cpu->get_thread_cnfg_string(LTE_FDD_ENB_THREAD_ROLE_GW));
+    if(0 == param.find(cpu_topology_token))
+        return send_ctrl_msg("ok " + cpu->get_topology_string());
     send_ctrl_msg("fail invalid " + read_token + " parameter");
 }
-void LTE_fdd_enb_interface::handle_write(std::string msg)
+void LTE_fdd_enb_interface::handle_write(std::string_view msg)
 {
     if(0 != msg.find(write_token + " "))
         return send_ctrl_msg("fail invalid " + write_token + " command");
-    std::string param = msg.substr(write_token.length() + 1);
+    // The setters take the value as a std::string
+    std::string param(msg.substr(write_token.length() + 1));
     if(0 == param.find(mcc_token + " "))
     {
         if(set_mcc(param.substr(mcc_token.length()+1)))
@@ -1129,6 +876,18 @@ void LTE_fdd_enb_interface::handle_write(std::string msg)
             return send_ctrl_msg("fail invalid " + debug_level_token + " value");
         return send_ctrl_msg("ok");
     }
+    if(0 == param.find(dl_scheduler_token + " "))
+    {
+        if(set_dl_scheduler(param.substr(dl_scheduler_token.length()+1)))
+            return send_ctrl_msg("fail invalid " + dl_scheduler_token + " value");
+        return send_ctrl_msg("ok");
+    }
+    if(0 == param.find(dl_ra_type_token + " "))
+    {
+        if(set_dl_ra_type(param.substr(dl_ra_type_token.length()+1)))
+            return send_ctrl_msg("fail invalid " + dl_ra_type_token + " value");
+        return send_ctrl_msg("ok");
+    }
     if(0 == param.find(use_cnfg_file_token + " "))
     {
         if(set_use_cnfg_file(param.substr(use_cnfg_file_token.length()+1)))
@@ -1141,6 +900,7 @@ void LTE_fdd_enb_interface::handle_write(std::string msg)
     {
         if(set_use_user_file(param.substr(use_user_file_token.length()+1)))
             return send_ctrl_msg("fail invalid " + use_user_file_token + " value");
+        hss->set_use_user_file(use_user_file);
         return send_ctrl_msg("ok");
     }
     {
@@ -1172,6 +932,12 @@ void LTE_fdd_enb_interface::handle_write(std::string msg)
             return send_ctrl_msg("fail invalid " + n_ant_token + " value");
         return send_ctrl_msg("ok");
     }
+    if(0 == param.find(max_users_token + " "))
+    {
+        if(set_max_users(param.substr(max_users_token.length()+1)))
+            return send_ctrl_msg("fail invalid " + max_users_token + " value");
+        return send_ctrl_msg("ok");
+    }
     if(0 == param.find(n_id_cell_token + " "))
     {
         if(set_n_id_cell(param.substr(n_id_cell_token.length()+1)))
@@ -1208,6 +974,12 @@ void LTE_fdd_enb_interface::handle_write(std::string msg)
             return send_ctrl_msg("fail invalid " + enable_pcap_token + " value");
         return send_ctrl_msg("ok");
     }
+    if(0 == param.find(enable_metrics_token + " "))
+    {
+        if(set_enable_metrics(param.substr(enable_metrics_token.length()+1)))
+            return send_ctrl_msg("fail invalid " + enable_metrics_token + " value");
+        return send_ctrl_msg("ok");
+    }
     if(0 == param.find(ip_addr_start_token + " "))
     {
         if(set_ip_addr_start(param.substr(ip_addr_start_token.length()+1)))
@@ -1244,6 +1016,54 @@ void LTE_fdd_enb_interface::handle_write(std::string msg)
             return send_ctrl_msg("fail invalid " + rx_gain_token + " value");
         return send_ctrl_msg("ok");
     }
+    if(0 == param.find(sim_ul_file_token + " "))
+    {
+        if(radio->set_sim_ul_file(param.substr(sim_ul_file_token.length()+1)))
+            return send_ctrl_msg("fail invalid " + sim_ul_file_token + " value");
+        return send_ctrl_msg("ok");
+    }
+    if(0 == param.find(sim_dl_file_token + " "))
+    {
+        if(radio->set_sim_dl_file(param.substr(sim_dl_file_token.length()+1)))
+            return send_ctrl_msg("fail invalid " + sim_dl_file_token + " value");
+        return send_ctrl_msg("ok");
+    }
+    if(0 == param.find(sim_pace_token + " "))
+    {
+        if(radio->set_sim_pace(param.substr(sim_pace_token.length()+1)))
+            return send_ctrl_msg("fail invalid " + sim_pace_token + " value");
+        return send_ctrl_msg("ok");
+    }
+    if(0 == param.find(sim_loopback_token + " "))
+    {
+        if(radio->set_sim_loopback(param.substr(sim_loopback_token.length()+1)))
+            return send_ctrl_msg("fail invalid " + sim_loopback_token + " value");
+        return send_ctrl_msg("ok");
+    }
+    if(0 == param.find(radio_thread_token + " "))
+    {
+        if(cpu->set_thread_cnfg(LTE_FDD_ENB_THREAD_ROLE_RADIO, param.substr(radio_thread_token.length()+1)))
+            return send_ctrl_msg("fail invalid " + radio_thread_token + " value");
+        return send_ctrl_msg("ok");
+    }
+    if(0 == param.find(mac_thread_token + " "))
+    {
+        if(cpu->set_thread_cnfg(LTE_FDD_ENB_THREAD_ROLE_MAC, param.substr(mac_thread_token.length()+1)))
+            return send_ctrl_msg("fail invalid " + mac_thread_token + " value");
+        return send_ctrl_msg("ok");
+    }
+    if(0 == param.find(msgq_thread_token + " "))
+    {
+        if(cpu->set_thread_cnfg(LTE_FDD_ENB_THREAD_ROLE_MSGQ, param.substr(msgq_thread_token.length()+1)))
+            return send_ctrl_msg("fail invalid " + msgq_thread_token + " value");
+        return send_ctrl_msg("ok");
+    }
+    if(0 == param.find(gw_thread_token + " "))
+    {
+        if(cpu->set_thread_cnfg(LTE_FDD_ENB_THREAD_ROLE_GW, param.substr(gw_thread_token.length()+1)))
+            return send_ctrl_msg("fail invalid " + gw_thread_token + " value");
+        return send_ctrl_msg("ok");
+    }
     send_ctrl_msg("fail invalid " + write_token + " parameter");
 }
 std::string LTE_fdd_enb_interface::get_bandwidth_string()
@@ -1372,6 +1192,18 @@ int LTE_fdd_enb_interface::set_n_ant(std::string _N_ant)
     N_ant = value;
     return 0;
 }
+uint32 LTE_fdd_enb_interface::get_max_users()
+{
+    return max_users;
+}
+int LTE_fdd_enb_interface::set_max_users(std::string _max_users)
+{
+    int64 value;
+    if(to_number(_max_users, value, 1, LTE_FDD_ENB_MAX_MAX_USERS))
+        return -1;
+    max_users = value;
+    return 0;
+}
 uint16 LTE_fdd_enb_interface::get_n_id_cell()
 {
     return N_id_cell;
@@ -1722,7 +1554,9 @@ int LTE_fdd_enb_interface::set_debug_type(std::string _debug_type)
     for(uint32 i=0; i<LTE_FDD_ENB_DEBUG_TYPE_N_ITEMS; i++)
         if(std::string::npos != _debug_type.find(LTE_fdd_enb_debug_type_text[i]))
             value |= 1 << i;
+    std::lock_guard<std::mutex> lock(debug_mutex);
     debug_type = value;
+    update_debug_enabled_mask();
     return 0;
 }
 std::string LTE_fdd_enb_interface::get_debug_level_string()
@@ -1743,9 +1577,47 @@ int LTE_fdd_enb_interface::set_debug_level(std::string _debug_level)
     for(uint32 i=0; i<LTE_FDD_ENB_DEBUG_LEVEL_N_ITEMS; i++)
         if(std::string::npos != _debug_level.find(LTE_fdd_enb_debug_level_text[i]))
             value |= 1 << i;
+    std::lock_guard<std::mutex> lock(debug_mutex);
     debug_level = value;
+    update_debug_enabled_mask();
     return 0;
 }
+std::string LTE_fdd_enb_interface::get_dl_scheduler_string()
+{
+    return liblte_mac_dl_sched_policy_text[dl_scheduler];
+}
+LIBLTE_MAC_DL_SCHED_POLICY_ENUM LTE_fdd_enb_interface::get_dl_scheduler()
+{
+    return dl_scheduler;
+}
+int LTE_fdd_enb_interface::set_dl_scheduler(std::string _dl_scheduler)
+{
+    for(uint32 i=0; i<LIBLTE_MAC_DL_SCHED_POLICY_N_ITEMS; i++)
+        if(_dl_scheduler == liblte_mac_dl_sched_policy_text[i])
+        {
+            dl_scheduler = (LIBLTE_MAC_DL_SCHED_POLICY_ENUM)i;
+            return 0;
+        }
+    return -1;
+}
+std::string LTE_fdd_enb_interface::get_dl_ra_type_string()
+{
+    return liblte_mac_resource_allocation_type_text[dl_ra_type];
+}
+LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_ENUM LTE_fdd_enb_interface::get_dl_ra_type()
+{
+    return dl_ra_type;
+}
+int LTE_fdd_enb_interface::set_dl_ra_type(std::string _dl_ra_type)
+{
+    for(uint32 i=0; i<LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_N_ITEMS; i++)
+        if(_dl_ra_type == liblte_mac_resource_allocation_type_text[i])
+        {
+            dl_ra_type = (LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_ENUM)i;
+            return 0;
+        }
+    return -1;
+}
 std::string LTE_fdd_enb_interface::get_enable_pcap_string()
 {
     return bool_to_enable_string(enable_pcap);
@@ -1759,6 +1631,15 @@ int LTE_fdd_enb_interface::set_enable_pcap(std::string _enable_pcap)
     enable_pcap = enable_string_to_bool(_enable_pcap);
     return 0;
 }
+std::string LTE_fdd_enb_interface::get_enable_metrics_string()
+{
+    return bool_to_enable_string(metrics->get_enabled());
+}
+int LTE_fdd_enb_interface::set_enable_metrics(std::string _enable_metrics)
+{
+    metrics->set_enabled(enable_string_to_bool(_enable_metrics));
+    return 0;
+}
 std::string LTE_fdd_enb_interface::get_ip_addr_start_string()
 {
     std::string str;
@@ -1886,6 +1767,9 @@ void LTE_fdd_enb_interface::handle_start()
     // Construct the system information
     construct_sys_info();
 
+    // Size the UL H-ARQ soft buffers for the configured users
+    user_mgr->set_max_users(max_users);
+
     // Start layers
     char err_str[LTE_FDD_ENB_MAX_LINE_SIZE];
     if(LTE_FDD_ENB_ERROR_NONE != gw->start(pdcp_to_gw_comm, gw_to_pdcp_comm, err_str))
@@ -2023,7 +1907,9 @@ void LTE_fdd_enb_interface::handle_help()
     send_ctrl_msg("\t\t" + add_user_token + " " + imsi_token + "=<" + imsi_token + "> " + imei_token + "=<" + imei_token + "> " + k_token + "=<" + k_token + "> - Adds a user to the HSS (<imsi> and <imei> are 15 decimal digits, and <k> is 32 hex digits)");
     send_ctrl_msg("\t\t" + delete_user_token + " " + imsi_token + "=<" + imsi_token + "> - Deletes a user from the HSS");
     send_ctrl_msg("\t\t" + print_users_token + " - Prints all the users in the HSS");
+    send_ctrl_msg("\t\t" + import_users_token + " " + file_token + "=<" + file_token + "> - Adds every imsi,imei,k line of a CSV file to the HSS");
     send_ctrl_msg("\t\t" + print_registered_users_token + " - Prints all the users currently registered");
+    send_ctrl_msg("\t\t" + print_metrics_token + " - Prints the latency of each pipeline stage (" + enable_metrics_token + " must be on)");
     send_ctrl_msg("\t\t" + read_token + " - Reads the specified parameter (" + read_token + " <param>)");
     send_ctrl_msg("\t\t" + write_token + " - Writes the specified parameter (" + write_token + " <param> <value>)");
 
@@ -2033,6 +1919,7 @@ void LTE_fdd_enb_interface::handle_help()
     send_ctrl_msg("\t\t" + band_token + " = " + std::to_string(get_band()));
     send_ctrl_msg("\t\t" + dl_earfcn_token + " = " + std::to_string(dl_earfcn));
     send_ctrl_msg("\t\t" + n_ant_token + " = " + std::to_string(N_ant));
+    send_ctrl_msg("\t\t" + max_users_token + " = " + std::to_string(max_users));
     send_ctrl_msg("\t\t" + n_id_cell_token + " = " + std::to_string(N_id_cell));
     send_ctrl_msg("\t\t" + mcc_token + " = " + get_mcc_string());
     send_ctrl_msg("\t\t" + mnc_token + " = " + get_mnc_string());
@@ -2054,54 +1941,76 @@ void LTE_fdd_enb_interface::handle_help()
     send_ctrl_msg("\t\t" + phy_direct_to_ue_token + " = " + get_phy_direct_to_ue_string());
     send_ctrl_msg("\t\t" + debug_type_token + " = " + get_debug_type_string());
     send_ctrl_msg("\t\t" + debug_level_token + " = " + get_debug_level_string());
+    send_ctrl_msg("\t\t" + dl_scheduler_token + " = " + get_dl_scheduler_string());
+    send_ctrl_msg("\t\t" + dl_ra_type_token + " = " + get_dl_ra_type_string());
     send_ctrl_msg("\t\t" + enable_pcap_token + " = " + get_enable_pcap_string());
+    send_ctrl_msg("\t\t" + enable_metrics_token + " = " + get_enable_metrics_string());
     send_ctrl_msg("\t\t" + ip_addr_start_token + " = " + get_ip_addr_start_string());
     send_ctrl_msg("\t\t" + dns_addr_token + " = " + get_dns_addr_string());
     send_ctrl_msg("\t\t" + use_cnfg_file_token + " = " + get_use_cnfg_file_string());
     send_ctrl_msg("\t\t" + use_user_file_token + " = " + get_use_user_file_string());
+    send_ctrl_msg("\t\t" + radio_thread_token + " = " + cpu->get_thread_cnfg_string(LTE_FDD_ENB_THREAD_ROLE_RADIO));
+    send_ctrl_msg("\t\t" + mac_thread_token + " = " + cpu->get_thread_cnfg_string(LTE_FDD_ENB_THREAD_ROLE_MAC));
+    send_ctrl_msg("\t\t" + msgq_thread_token + " = " + cpu->get_thread_cnfg_string(LTE_FDD_ENB_THREAD_ROLE_MSGQ));
+    send_ctrl_msg("\t\t" + gw_thread_token + " = " + cpu->get_thread_cnfg_string(LTE_FDD_ENB_THREAD_ROLE_GW));
+    send_ctrl_msg("\t\t" + cpu_topology_token + " = " + cpu->get_topology_string());
 }
-void LTE_fdd_enb_interface::handle_add_user(std::string msg)
+void LTE_fdd_enb_interface::handle_add_user(std::string_view msg)
 {
     if(0 != msg.find(add_user_token + " "))
         return send_ctrl_msg("fail invalid " + add_user_token + " command");
-    std::string param = msg.substr(add_user_token.length() + 1);
-    if(std::string::npos == param.find(imsi_token + "="))
+    std::string_view param = msg.substr(add_user_token.length() + 1);
+    if(std::string_view::npos == param.find(imsi_token + "="))
         return send_ctrl_msg("fail " + add_user_token + " command missing " + imsi_token);
-    std::string imsi_str = param.substr(param.find(imsi_token)+imsi_token.length()+1);
-    imsi_str = imsi_str.substr(0, imsi_str.find(" "));
+    std::string_view imsi_val = param.substr(param.find(imsi_token)+imsi_token.length()+1);
+    std::string      imsi_str(imsi_val.substr(0, imsi_val.find(" ")));
     if(!is_string_valid_as_number(imsi_str, 15, 10))
         return send_ctrl_msg("fail " + add_user_token + " command with invalid " + imsi_token);
-    if(std::string::npos == param.find(imei_token + "="))
+    if(std::string_view::npos == param.find(imei_token + "="))
         return send_ctrl_msg("fail " + add_user_token + " command missing " + imei_token);
-    std::string imei_str = param.substr(param.find(imei_token)+imei_token.length()+1);
-    imei_str = imei_str.substr(0, imei_str.find(" "));
+    std::string_view imei_val = param.substr(param.find(imei_token)+imei_token.length()+1);
+    std::string      imei_str(imei_val.substr(0, imei_val.find(" ")));
     if(!is_string_valid_as_number(imei_str, 15, 10))
         return send_ctrl_msg("fail " + add_user_token + " command with invalid " + imei_token);
-    if(std::string::npos == param.find(k_token + "="))
+    if(std::string_view::npos == param.find(k_token + "="))
         return send_ctrl_msg("fail " + add_user_token + " command missing " + k_token);
-    std::string k_str = param.substr(param.find(k_token)+k_token.length()+1);
-    k_str = k_str.substr(0, k_str.find(" "));
+    std::string_view k_val = param.substr(param.find(k_token)+k_token.length()+1);
+    std::string      k_str(k_val.substr(0, k_val.find(" ")));
     if(!is_string_valid_as_number(k_str, 32, 16))
         return send_ctrl_msg("fail " + add_user_token + " command with invalid " + k_token);
     if(LTE_FDD_ENB_ERROR_NONE != hss->add_user(imsi_str, imei_str, k_str))
         return send_ctrl_msg("fail HSS add_user failure");
     send_ctrl_msg("ok");
 }
-void LTE_fdd_enb_interface::handle_delete_user(std::string msg)
+void LTE_fdd_enb_interface::handle_delete_user(std::string_view msg)
 {
     if(0 != msg.find(delete_user_token + " "))
         return send_ctrl_msg("fail invalid " + delete_user_token + " command");
-    std::string param = msg.substr(delete_user_token.length() + 1);
-    if(std::string::npos == param.find(imsi_token + "="))
+    std::string_view param = msg.substr(delete_user_token.length() + 1);
+    if(std::string_view::npos == param.find(imsi_token + "="))
         return send_ctrl_msg("fail " + delete_user_token + " command missing " + imsi_token);
-    std::string imsi_str = param.substr(param.find(imsi_token)+imsi_token.length()+1);
-    imsi_str = imsi_str.substr(0, imsi_str.find(" "));
+    std::string_view imsi_val = param.substr(param.find(imsi_token)+imsi_token.length()+1);
+    std::string      imsi_str(imsi_val.substr(0, imsi_val.find(" ")));
     if(!is_string_valid_as_number(imsi_str, 15, 10))
         return send_ctrl_msg("fail " + delete_user_token + " command with invalid " + imsi_token);
     if(LTE_FDD_ENB_ERROR_NONE != hss->del_user(imsi_str))
         return send_ctrl_msg("fail HSS delete user failure");
     send_ctrl_msg("ok");
 }
+void LTE_fdd_enb_interface::handle_import_users(std::string_view msg)
+{
+    uint32 N_users;
+
+    if(0 != msg.find(import_users_token + " "))
+        return send_ctrl_msg("fail invalid " + import_users_token + " command");
+    std::string_view param = msg.substr(import_users_token.length() + 1);
+    if(0 != param.find(file_token + "="))
+        return send_ctrl_msg("fail " + import_users_token + " command missing " + file_token);
+    std::string file_str(param.substr(file_token.length() + 1));
+    if(LTE_FDD_ENB_ERROR_NONE != hss->import_users(file_str, &N_users))
+        return send_ctrl_msg("fail HSS import_users failure");
+    send_ctrl_msg("ok " + std::to_string(N_users));
+}
 void LTE_fdd_enb_interface::handle_print_users()
 {
     send_ctrl_msg("ok " + hss->print_all_users());
@@ -2110,6 +2019,10 @@ void LTE_fdd_enb_interface::handle_print_registered_users()
 {
     send_ctrl_msg("ok " + user_mgr->print_all_users());
 }
+void LTE_fdd_enb_interface::handle_print_metrics()
+{
+    send_ctrl_msg("ok " + metrics->get_report_string());
+}
 void LTE_fdd_enb_interface::read_cnfg_file()
 {
     hss->read_user_file(this);
@@ -2136,6 +2049,7 @@ void LTE_fdd_enb_interface::write_cnfg_file()
     fprintf(cnfg_file, "%s %s\n", band_token.c_str(), std::to_string(get_band()).c_str());
     fprintf(cnfg_file, "%s %s\n", dl_earfcn_token.c_str(), std::to_string(dl_earfcn).c_str());
     fprintf(cnfg_file, "%s %s\n", n_ant_token.c_str(), std::to_string(N_ant).c_str());
+    fprintf(cnfg_file, "%s %s\n", max_users_token.c_str(), std::to_string(max_users).c_str());
     fprintf(cnfg_file, "%s %s\n", n_id_cell_token.c_str(), std::to_string(N_id_cell).c_str());
     fprintf(cnfg_file, "%s %s\n", mcc_token.c_str(), get_mcc_string().c_str());
     fprintf(cnfg_file, "%s %s\n", mnc_token.c_str(), get_mnc_string().c_str());
@@ -2157,10 +2071,17 @@ void LTE_fdd_enb_interface::write_cnfg_file()
     fprintf(cnfg_file, "%s %s\n", phy_direct_to_ue_token.c_str(), get_phy_direct_to_ue_string().c_str());
     fprintf(cnfg_file, "%s %s\n", debug_type_token.c_str(), get_debug_type_string().c_str());
     fprintf(cnfg_file, "%s %s\n", debug_level_token.c_str(), get_debug_level_string().c_str());
+    fprintf(cnfg_file, "%s %s\n", dl_scheduler_token.c_str(), get_dl_scheduler_string().c_str());
+    fprintf(cnfg_file, "%s %s\n", dl_ra_type_token.c_str(), get_dl_ra_type_string().c_str());
     fprintf(cnfg_file, "%s %s\n", enable_pcap_token.c_str(), get_enable_pcap_string().c_str());
+    fprintf(cnfg_file, "%s %s\n", enable_metrics_token.c_str(), get_enable_metrics_string().c_str());
     fprintf(cnfg_file, "%s %s\n", ip_addr_start_token.c_str(), get_ip_addr_start_string().c_str());
     fprintf(cnfg_file, "%s %s\n", dns_addr_token.c_str(), get_dns_addr_string().c_str());
     fprintf(cnfg_file, "%s %s\n", use_user_file_token.c_str(), get_use_user_file_string().c_str());
+    fprintf(cnfg_file, "%s %s\n", radio_thread_token.c_str(), cpu->get_thread_cnfg_string(LTE_FDD_ENB_THREAD_ROLE_RADIO).c_str());
+    fprintf(cnfg_file, "%s %s\n", mac_thread_token.c_str(), cpu->get_thread_cnfg_string(LTE_FDD_ENB_THREAD_ROLE_MAC).c_str());
+    fprintf(cnfg_file, "%s %s\n", msgq_thread_token.c_str(), cpu->get_thread_cnfg_string(LTE_FDD_ENB_THREAD_ROLE_MSGQ).c_str());
+    fprintf(cnfg_file, "%s %s\n", gw_thread_token.c_str(), cpu->get_thread_cnfg_string(LTE_FDD_ENB_THREAD_ROLE_GW).c_str());
     fclose(cnfg_file);
 }
 void LTE_fdd_enb_interface::delete_cnfg_file()
@@ -80,12 +80,14 @@
 #include "LTE_fdd_enb_timer_mgr.h"
 #include "LTE_fdd_enb_mac.h"
 #include "LTE_fdd_enb_phy.h"
+#include "LTE_fdd_enb_rlc.h"
 
 /*******************************************************************************
                               DEFINES
 *******************************************************************************/
 
 #define BSR_GRANT_SIZE_BYTES 10
+#define DIRECT_TO_UE_SINR_DB 30 // The IPC link never corrupts a PDU
 
 /*******************************************************************************
                               TYPEDEFS
@@ -106,7 +108,8 @@
 /********************************/
 LTE_fdd_enb_mac::LTE_fdd_enb_mac(LTE_fdd_enb_interface *iface, LTE_fdd_enb_timer_mgr *tm,
                                  LTE_fdd_enb_user_mgr *um, LTE_fdd_enb_rlc *_rlc) :
-    interface{iface}, started{false}, timer_mgr{tm}, user_mgr{um}, rlc{_rlc}
+    interface{iface}, started{false}, dl_harq_retx_queue_head{0}, N_dl_harq_retx{0}, timer_mgr{tm},
+    user_mgr{um}, rlc{_rlc}
 {
 }
 LTE_fdd_enb_mac::~LTE_fdd_enb_mac()
@@ -147,7 +150,8 @@ void LTE_fdd_enb_mac::start(LTE_fdd_enb_msgq      *from_phy,
                                this);
     msgq_from_rlc->attach_rx(rlc_cb);
 
-    msgq_to_ue = NULL;
+    msgq_to_ue   = NULL;
+    msgq_from_ue = NULL;
     if(direct_to_ue)
     {
         libtools_ipc_msgq_cb ue_cb(&libtools_ipc_msgq_cb_wrapper<LTE_fdd_enb_mac, &LTE_fdd_enb_mac::handle_ue_msg>,
@@ -168,11 +172,11 @@ void LTE_fdd_enb_mac::start(LTE_fdd_enb_msgq      *from_phy,
         sched_dl_subfr[i].next_prb               = 0;
 
         sched_ul_subfr[i].decodes.N_ul_alloc = 0;
-        sched_ul_subfr[i].N_avail_prbs       = interface->get_n_rb_ul();
+        sched_ul_subfr[i].N_avail_prbs       = interface->get_n_rb_ul() - 2*get_n_pucch_prbs();
         sched_ul_subfr[i].N_sched_prbs       = 0;
         sched_ul_subfr[i].current_tti        = i;
         sched_ul_subfr[i].N_pucch            = 0;
-        sched_ul_subfr[i].next_prb           = 0;
+        sched_ul_subfr[i].next_prb           = get_n_pucch_prbs();
     }
     sched_dl_subfr[0].current_tti = 10;
     sched_dl_subfr[1].current_tti = 11;
@@ -234,6 +238,10 @@ void LTE_fdd_enb_mac::stop()
     started = false;
     if(NULL != msgq_to_ue)
         delete msgq_to_ue;
+    msgq_to_ue = NULL;
+    if(NULL != msgq_from_ue)
+        delete msgq_from_ue;
+    msgq_from_ue = NULL;
 }
 
 /***********************/
@@ -315,7 +323,9 @@ void LTE_fdd_enb_mac::handle_ue_msg(LIBTOOLS_IPC_MSGQ_MESSAGE_STRUCT *msg)
     case LIBTOOLS_IPC_MSGQ_MESSAGE_TYPE_MAC_PDU:
         memcpy(&pusch_decode.msg, &msg->msg.mac_pdu_msg.msg, sizeof(pusch_decode.msg));
         pusch_decode.current_tti = sched_ul_subfr[sched_cur_ul_subfn].current_tti;
+        pusch_decode.sinr_db     = DIRECT_TO_UE_SINR_DB;
         pusch_decode.rnti        = msg->msg.mac_pdu_msg.rnti;
+        pusch_decode.crc_pass    = true;
         handle_pusch_decode(&pusch_decode);
         break;
     default:
@@ -416,6 +426,8 @@ void LTE_fdd_enb_mac::remove_periodic_sr_pucch(uint16 rnti)
 /**********************/
 void LTE_fdd_enb_mac::handle_ready_to_send(LTE_FDD_ENB_READY_TO_SEND_MSG_STRUCT *rts)
 {
+    uint64 start = interface->get_metrics()->start();
+
     // Send tick to timer manager
     LTE_FDD_ENB_TIMER_TICK_MSG_STRUCT timer_tick;
     msgq_to_timer->send(LTE_FDD_ENB_MESSAGE_TYPE_TIMER_TICK,
@@ -428,12 +440,17 @@ void LTE_fdd_enb_mac::handle_ready_to_send(LTE_FDD_ENB_READY_TO_SEND_MSG_STRUCT
                       &sched_ul_subfr[sched_cur_ul_subfn]);
 
     advance_tti_and_clear_subframe();
+    user_mgr->reclaim_soft_buffers();
 
     // Call the schedulers
     rar_scheduler();
     dl_scheduler();
+    dl_harq_scheduler();
+    dl_mux_scheduler();
     ul_scheduler();
     ul_sr_scheduler();
+
+    interface->get_metrics()->record(LTE_FDD_ENB_METRICS_STAGE_MAC_READY_TO_SEND, start);
 }
 void LTE_fdd_enb_mac::handle_prach_decode(LTE_FDD_ENB_PRACH_DECODE_MSG_STRUCT *prach_decode)
 {
@@ -491,10 +508,18 @@ void LTE_fdd_enb_mac::handle_pucch_ack_nack(LTE_fdd_enb_user      *user,
                               user->get_c_rnti(),
                               msg->msg[0]);
 
+    // H-ARQ feedback drives the DL link adaptation
+    user->update_dl_mcs(msg->msg[0]);
+
+    uint8  harq_process;
+    uint32 harq_retx_count;
     if(msg->msg[0])
     {
         // Received ACK
-        user->clear_harq_info(current_tti);
+        if(LTE_FDD_ENB_ERROR_NONE == user->get_harq_info(current_tti,
+                                                         &harq_process,
+                                                         &harq_retx_count))
+            user->clear_harq_info(harq_process);
         interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
                                   LTE_FDD_ENB_DEBUG_LEVEL_MAC,
                                   __FILE__,
@@ -506,11 +531,9 @@ void LTE_fdd_enb_mac::handle_pucch_ack_nack(LTE_fdd_enb_user      *user,
     }
 
     // Received NACK, resend HARQ information if possible
-    LIBLTE_MAC_PDU_STRUCT        mac_pdu;
-    LIBLTE_PHY_ALLOCATION_STRUCT alloc;
     if(LTE_FDD_ENB_ERROR_NONE != user->get_harq_info(current_tti,
-                                                     &mac_pdu,
-                                                     &alloc))
+                                                     &harq_process,
+                                                     &harq_retx_count))
         return interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ERROR,
                                          LTE_FDD_ENB_DEBUG_LEVEL_MAC,
                                          __FILE__,
@@ -518,7 +541,9 @@ void LTE_fdd_enb_mac::handle_pucch_ack_nack(LTE_fdd_enb_user      *user,
                                          "Failed to find HARQ info RNTI=%u TTI=%u",
                                          user->get_c_rnti(),
                                          current_tti);
-    if(LTE_FDD_ENB_MAX_HARQ_RETX <= alloc.harq_retx_count)
+    if(LTE_FDD_ENB_MAX_HARQ_RETX <= harq_retx_count)
+    {
+        user->clear_harq_info(harq_process);
         return interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
                                          LTE_FDD_ENB_DEBUG_LEVEL_MAC,
                                          __FILE__,
@@ -526,12 +551,11 @@ void LTE_fdd_enb_mac::handle_pucch_ack_nack(LTE_fdd_enb_user      *user,
                                          "Not resending HARQ due to max retx RNTI=%u TTI=%u",
                                          user->get_c_rnti(),
                                          current_tti);
-    alloc.harq_retx_count++;
-    alloc.ndi ^= 0x01;
-    if(LTE_FDD_ENB_ERROR_NONE == add_to_dl_sched_queue(liblte_phy_add_to_tti(sched_dl_subfr[sched_cur_dl_subfn].current_tti,
-                                                                             4),
-                                                       &mac_pdu,
-                                                       &alloc))
+    }
+    if(LTE_FDD_ENB_ERROR_NONE == add_to_dl_harq_retx_queue(liblte_phy_add_to_tti(sched_dl_subfr[sched_cur_dl_subfn].current_tti,
+                                                                                 4),
+                                                           user->get_c_rnti(),
+                                                           harq_process))
         return interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
                                          LTE_FDD_ENB_DEBUG_LEVEL_MAC,
                                          __FILE__,
@@ -539,7 +563,8 @@ void LTE_fdd_enb_mac::handle_pucch_ack_nack(LTE_fdd_enb_user      *user,
                                          "Resending HARQ info RNTI=%u TTI=%u (%u)",
                                          user->get_c_rnti(),
                                          current_tti,
-                                         alloc.harq_retx_count);
+                                         harq_retx_count+1);
+    user->clear_harq_info(harq_process);
     interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ERROR,
                               LTE_FDD_ENB_DEBUG_LEVEL_MAC,
                               __FILE__,
@@ -564,7 +589,9 @@ void LTE_fdd_enb_mac::handle_pucch_sr(LTE_fdd_enb_user      *user,
                               user->get_c_rnti());
 
     // Schedule a grant big enough to at least hold long BSR
-    sched_ul(user, BSR_GRANT_SIZE_BYTES*8);
+    if(user->get_ul_buffer_size() < BSR_GRANT_SIZE_BYTES)
+        user->set_ul_buffer_size(BSR_GRANT_SIZE_BYTES);
+    sched_ul(user);
 }
 void LTE_fdd_enb_mac::handle_pusch_decode(LTE_FDD_ENB_PUSCH_DECODE_MSG_STRUCT *pusch_decode)
 {
@@ -579,6 +606,21 @@ void LTE_fdd_enb_mac::handle_pusch_decode(LTE_FDD_ENB_PUSCH_DECODE_MSG_STRUCT *p
                                          "PUSCH decode for invalid RNTI (%u)",
                                          pusch_decode->rnti);
 
+    // Adapt the UL MCS to the measured SINR and the CRC result
+    user->update_ul_mcs(pusch_decode->sinr_db, pusch_decode->crc_pass);
+
+    // Release or retransmit the UL H-ARQ process
+    handle_ul_harq(user, pusch_decode->current_tti, pusch_decode->crc_pass);
+    if(!pusch_decode->crc_pass)
+        return interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
+                                         LTE_FDD_ENB_DEBUG_LEVEL_MAC,
+                                         __FILE__,
+                                         __LINE__,
+                                         "PUSCH CRC failure for RNTI=%u CURRENT_TTI=%u SINR=%.1fdB",
+                                         pusch_decode->rnti,
+                                         pusch_decode->current_tti,
+                                         pusch_decode->sinr_db);
+
     // Reset the C-RNTI release timer
     user_mgr->reset_c_rnti_timer(pusch_decode->rnti);
 
@@ -636,95 +678,22 @@ void LTE_fdd_enb_mac::handle_pusch_decode(LTE_FDD_ENB_PUSCH_DECODE_MSG_STRUCT *p
 /******************************/
 void LTE_fdd_enb_mac::handle_sdu_ready(LTE_FDD_ENB_MAC_SDU_READY_MSG_STRUCT *sdu_ready)
 {
-    LIBLTE_BYTE_MSG_STRUCT *sdu;
-    if(LTE_FDD_ENB_ERROR_NONE != sdu_ready->rb->get_next_mac_sdu(&sdu))
-        return interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ERROR,
-                                         LTE_FDD_ENB_DEBUG_LEVEL_MAC,
-                                         __FILE__,
-                                         __LINE__,
-                                         "Received sdu_ready message with no SDU queued");
-
-    LTE_fdd_enb_user *user = sdu_ready->user;
+    uint16 rnti = sdu_ready->user->get_c_rnti();
 
     interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
                               LTE_FDD_ENB_DEBUG_LEVEL_MAC,
                               __FILE__,
                               __LINE__,
-                              sdu,
-                              "Received SDU for RNTI=%u and RB=%s",
-                              user->get_c_rnti(),
+                              "Received SDU ready for RNTI=%u and RB=%s",
+                              rnti,
                               LTE_fdd_enb_rb_text[sdu_ready->rb->get_rb_id()]);
 
-    // Fill in the allocation
-    LIBLTE_PHY_ALLOCATION_STRUCT alloc = {0};
-    alloc.pre_coder_type = LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY;
-    alloc.mod_type       = get_modulation_type(user->get_mcs());
-    alloc.chan_type      = LIBLTE_PHY_CHAN_TYPE_DLSCH;
-    alloc.rv_idx         = 0;
-    alloc.N_codewords    = 1;
-    sys_info_mutex.lock();
-    if(1 == interface->get_n_ant())
-    {
-        alloc.tx_mode = 1;
-    }else{
-        alloc.tx_mode = 2;
-    }
-    sys_info_mutex.unlock();
-    alloc.rnti         = user->get_c_rnti();
-    alloc.tpc          = LIBLTE_PHY_TPC_COMMAND_DCI_1_1A_1B_1D_2_3_DB_ZERO;
-    alloc.harq_process = user->get_harq_process();
-    user->increment_harq_process();
-    alloc.ndi             = 0;
-    alloc.harq_retx_count = 0;
-
-    // Pack the PDU
-    LIBLTE_MAC_PDU_STRUCT mac_pdu;
-    mac_pdu.chan_type = LIBLTE_MAC_CHAN_TYPE_DLSCH;
-    if(sdu_ready->rb->get_send_con_res_id())
-    {
-        mac_pdu.N_subheaders                          = 2;
-        mac_pdu.subheader[0].lcid                     = LIBLTE_MAC_DLSCH_UE_CONTENTION_RESOLUTION_ID_LCID;
-        mac_pdu.subheader[0].payload.ue_con_res_id.id = sdu_ready->rb->get_con_res_id();
-        mac_pdu.subheader[1].lcid                     = sdu_ready->rb->get_rb_id();
-        memcpy(&mac_pdu.subheader[1].payload.sdu, sdu, sizeof(LIBLTE_BYTE_MSG_STRUCT));
-        sdu_ready->rb->set_send_con_res_id(false);
-    }else{
-        mac_pdu.N_subheaders      = 1;
-        mac_pdu.subheader[0].lcid = sdu_ready->rb->get_rb_id();
-        memcpy(&mac_pdu.subheader[0].payload.sdu, sdu, sizeof(LIBLTE_BYTE_MSG_STRUCT));
-    }
-
-    // Add the PDU to the scheduling queue
-    interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
-                              LTE_FDD_ENB_DEBUG_LEVEL_MAC,
-                              __FILE__,
-                              __LINE__,
-                              "Attempting to schedule PDU for RNTI=%u, requested TTI=%u",
-                              alloc.rnti,
-                              liblte_phy_add_to_tti(sched_dl_subfr[sched_cur_dl_subfn].current_tti, 4));
-    if(LTE_FDD_ENB_ERROR_NONE != add_to_dl_sched_queue(liblte_phy_add_to_tti(sched_dl_subfr[sched_cur_dl_subfn].current_tti,
-                                                                             4),
-                                                       &mac_pdu,
-                                                       &alloc))
-    {
-        interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ERROR,
-                                  LTE_FDD_ENB_DEBUG_LEVEL_MAC,
-                                  __FILE__,
-                                  __LINE__,
-                                  "Can't schedule PDU");
-    }else{
-        interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
-                                  LTE_FDD_ENB_DEBUG_LEVEL_MAC,
-                                  __FILE__,
-                                  __LINE__,
-                                  &alloc.msg[0],
-                                  "PDU scheduled for RNTI=%u, DL_QUEUE_SIZE=%u",
-                                  alloc.rnti,
-                                  dl_sched_queue.size());
-    }
-
-    // Delete the SDU
-    sdu_ready->rb->delete_next_mac_sdu();
+    // Data is pulled from the RBs when the UE gets a DL grant
+    std::lock_guard<std::mutex> lock(dl_pending_mutex);
+    for(auto pending_rnti : dl_pending_rntis)
+        if(pending_rnti == rnti)
+            return;
+    dl_pending_rntis.push_back(rnti);
 }
 
 /**************************/
@@ -776,12 +745,6 @@ void LTE_fdd_enb_mac::handle_ulsch_ccch_sdu(LTE_fdd_enb_user       *user,
 
     // Send the SDU to RLC
     send_rlc_pdu_ready(user, rb, sdu);
-
-    // Update the uplink buffer size
-    user->update_ul_buffer_size(sdu->N_bytes);
-
-    // Schedule uplink
-    sched_ul(user, user->get_ul_buffer_size()*8);
 }
 void LTE_fdd_enb_mac::handle_ulsch_dcch_sdu(LTE_fdd_enb_user       *user,
                                             uint32                  lcid,
@@ -833,12 +796,6 @@ void LTE_fdd_enb_mac::handle_ulsch_dcch_sdu(LTE_fdd_enb_user       *user,
 
     // Send the SDU to RLC
     send_rlc_pdu_ready(user, rb, sdu);
-
-    // Update the uplink buffer size
-    user->update_ul_buffer_size(sdu->N_bytes);
-
-    // Schedule uplink
-    sched_ul(user, user->get_ul_buffer_size()*8);
 }
 void LTE_fdd_enb_mac::handle_ulsch_ext_power_headroom_report(LTE_fdd_enb_user                        *user,
                                                              LIBLTE_MAC_EXT_POWER_HEADROOM_CE_STRUCT *ext_power_headroom)
@@ -888,7 +845,7 @@ void LTE_fdd_enb_mac::handle_ulsch_truncated_bsr(LTE_fdd_enb_user
 
     user->set_ul_buffer_size(truncated_bsr->max_buffer_size);
 
-    sched_ul(user, truncated_bsr->max_buffer_size*8);
+    sched_ul(user);
 }
 void LTE_fdd_enb_mac::handle_ulsch_short_bsr(LTE_fdd_enb_user               *user,
                                              LIBLTE_MAC_SHORT_BSR_CE_STRUCT *short_bsr)
@@ -905,7 +862,7 @@ void LTE_fdd_enb_mac::handle_ulsch_short_bsr(LTE_fdd_enb_user               *use
 
     user->set_ul_buffer_size(short_bsr->max_buffer_size);
 
-    sched_ul(user, short_bsr->max_buffer_size*8);
+    sched_ul(user);
 }
 void LTE_fdd_enb_mac::handle_ulsch_long_bsr(LTE_fdd_enb_user              *user,
                                             LIBLTE_MAC_LONG_BSR_CE_STRUCT *long_bsr)
@@ -930,10 +887,7 @@ void LTE_fdd_enb_mac::handle_ulsch_long_bsr(LTE_fdd_enb_user              *user,
                              long_bsr->max_buffer_size_2 +
                              long_bsr->max_buffer_size_3);
 
-    sched_ul(user, (long_bsr->max_buffer_size_0 +
-                    long_bsr->max_buffer_size_1 +
-                    long_bsr->max_buffer_size_2 +
-                    long_bsr->max_buffer_size_3)*8);
+    sched_ul(user);
 }
 
 /***************************/
@@ -952,9 +906,10 @@ void LTE_fdd_enb_mac::construct_random_access_response(uint8  preamble,
                                          __LINE__,
                                          "No free C-RNTI or add_user fail");
 
-    // Save C-RNTI
+    // Save C-RNTI, the RAR starts the time alignment timer
     LIBLTE_MAC_RAR_STRUCT rar;
     rar.temp_c_rnti = user->get_c_rnti();
+    user->set_ta_command_tti(current_tti);
 
     // Fill in the DL allocation
     LIBLTE_PHY_ALLOCATION_STRUCT dl_alloc;
@@ -1019,60 +974,23 @@ void LTE_fdd_enb_mac::construct_random_access_response(uint8  preamble,
 /*******************/
 /*    Scheduler    */
 /*******************/
-void LTE_fdd_enb_mac::sched_ul(LTE_fdd_enb_user *user,
-                               uint32            requested_tbs)
+void LTE_fdd_enb_mac::sched_ul(LTE_fdd_enb_user *user)
 {
-    if(requested_tbs == 0)
-        return;
+    uint16 rnti = user->get_c_rnti();
 
-    LIBLTE_PHY_ALLOCATION_STRUCT alloc;
-    alloc.pre_coder_type = LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY;
-    alloc.mod_type       = get_modulation_type(user->get_mcs());
-    alloc.chan_type      = LIBLTE_PHY_CHAN_TYPE_ULSCH;
-    alloc.rv_idx         = 0;
-    alloc.N_codewords    = 1;
-    alloc.N_layers       = 1;
-    alloc.tx_mode        = 1;
-    alloc.rnti           = user->get_c_rnti();
-    alloc.tpc            = LIBLTE_PHY_TPC_COMMAND_DCI_0_3_4_DB_NEG_1;
-    alloc.ndi            = 0;
-    uint32 bits_req      = requested_tbs;
-    if(bits_req > (user->get_max_ul_bytes_per_subfn()*8))
-        bits_req = user->get_max_ul_bytes_per_subfn()*8;
-    sys_info_mutex.lock();
-    liblte_phy_get_tbs_and_n_prb_for_ul(bits_req,
-                                        interface->get_n_rb_ul(),
-                                        user->get_mcs(),
-                                        &alloc.tbs,
-                                        &alloc.N_prb);
-    sys_info_mutex.unlock();
-
-    // Add the allocation to the scheduling queue
-    uint32 tti = liblte_phy_add_to_tti(sched_ul_subfr[sched_cur_ul_subfn].current_tti, 10);
-    if(LTE_FDD_ENB_ERROR_NONE != add_to_ul_sched_queue(tti, &alloc))
-        return interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ERROR,
-                                         LTE_FDD_ENB_DEBUG_LEVEL_MAC,
-                                         __FILE__,
-                                         __LINE__,
-                                         "Can't schedule UL");
-    interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
-                              LTE_FDD_ENB_DEBUG_LEVEL_MAC,
-                              __FILE__,
-                              __LINE__,
-                              "UL scheduled (mcs=%u, tbs=%u, N_prb=%u) for RNTI=%u, UL_QUEUE_SIZE=%u TTI=%u",
-                              alloc.mcs,
-                              alloc.tbs,
-                              alloc.N_prb,
-                              alloc.rnti,
-                              ul_sched_queue.size(),
-                              tti);
+    // Grants are sized from the UE's buffer status when the UE is scheduled
+    std::lock_guard<std::mutex> lock(ul_pending_mutex);
+    for(auto pending_rnti : ul_pending_rntis)
+        if(pending_rnti == rnti)
+            return;
+    ul_pending_rntis.push_back(rnti);
 }
 void LTE_fdd_enb_mac::persistent_dl(LTE_FDD_ENB_PERSISTENT_DL_STRUCT *sched)
 {
     while(!liblte_phy_is_tti_in_future(sched->next_tti,
                                        sched_dl_subfr[sched_cur_dl_subfn].current_tti))
         sched->next_tti = liblte_phy_add_to_tti(sched->next_tti, sched->tti_periodicity);
-    add_to_dl_sched_queue(sched->next_tti, NULL, &sched->alloc);
+    add_to_dl_sched_queue(sched->next_tti, &sched->alloc);
     sched->next_tti = liblte_phy_add_to_tti(sched->next_tti, sched->tti_periodicity);
 
     if(sched->timer_id == LTE_FDD_ENB_INVALID_TIMER_ID)
@@ -1154,8 +1072,9 @@ void LTE_fdd_enb_mac::rar_scheduler()
                                      rar_sched->dl_alloc.msg[0].N_bits);
 
         // Determine the RB start for the UL allocation
-        uint32 rb_start     = ul_subfr->next_prb;
-        ul_subfr->next_prb += rar_sched->ul_alloc.N_prb;
+        uint32 rb_start         = ul_subfr->next_prb;
+        ul_subfr->next_prb     += rar_sched->ul_alloc.N_prb;
+        ul_subfr->N_sched_prbs += rar_sched->ul_alloc.N_prb;
 
         // Fill in the PRBs for the UL allocation
         for(uint32 i=0; i<rar_sched->ul_alloc.N_prb; i++)
@@ -1180,8 +1099,9 @@ void LTE_fdd_enb_mac::rar_scheduler()
                                                    &rar_sched->dl_alloc.msg[0]);
 
         // Determine the RB start for the DL allocation
-        rb_start            = dl_subfr->next_prb;
-        dl_subfr->next_prb += rar_sched->dl_alloc.N_prb;
+        rb_start                = dl_subfr->next_prb;
+        dl_subfr->next_prb     += rar_sched->dl_alloc.N_prb;
+        dl_subfr->N_sched_prbs += rar_sched->dl_alloc.N_prb;
 
         // Fill in the PRBs for the DL allocation
         for(uint32 i=0; i<rar_sched->dl_alloc.N_prb; i++)
@@ -1209,6 +1129,8 @@ void LTE_fdd_enb_mac::rar_scheduler()
                    sizeof(LIBLTE_PHY_ALLOCATION_STRUCT));
             dl_subfr->allocations.N_dl_alloc++;
             // Schedule UL decode 6 subframes from now
+            ul_subfr->soft_buffer[ul_subfr->decodes.N_ul_alloc] = start_ul_harq(ul_subfr->current_tti,
+                                                                                &rar_sched->ul_alloc);
             memcpy(&ul_subfr->decodes.ul_alloc[ul_subfr->decodes.N_ul_alloc],
                    &rar_sched->ul_alloc,
                    sizeof(LIBLTE_PHY_ALLOCATION_STRUCT));
@@ -1257,194 +1179,220 @@ void LTE_fdd_enb_mac::dl_scheduler()
         if(dl_sched->current_tti != sched_dl_subfr[sched_cur_dl_subfn].current_tti)
             break;
 
+        // SI is already packed, place it contiguously ahead of
+        // H-ARQ retransmissions and new data
         LTE_FDD_ENB_DL_SCHEDULE_MSG_STRUCT *dl_subfr = &sched_dl_subfr[sched_cur_dl_subfn];
-        if(dl_sched->alloc.rnti != LIBLTE_MAC_SI_RNTI)
-        {
-            // Pack the message and determine TBS
-            liblte_mac_pack_mac_pdu(&dl_sched->mac_pdu,
-                                    &dl_sched->alloc.msg[0]);
-            liblte_phy_get_tbs_and_n_prb_for_dl(dl_sched->alloc.msg[0].N_bits,
-                                                dl_subfr->N_avail_prbs - dl_subfr->N_sched_prbs,
-                                                dl_sched->alloc.mcs,
-                                                &dl_sched->alloc.tbs,
-                                                &dl_sched->alloc.N_prb);
-
-            // Pad and repack if needed
-            if(dl_sched->alloc.tbs > dl_sched->alloc.msg[0].N_bits)
-            {
-                uint32 N_pad = (dl_sched->alloc.tbs - dl_sched->alloc.msg[0].N_bits)/8;
-
-                if(1 == N_pad)
-                {
-                    for(uint32 i=0; i<dl_sched->mac_pdu.N_subheaders; i++)
-                        memcpy(&dl_sched->mac_pdu.subheader[dl_sched->mac_pdu.N_subheaders-i],
-                               &dl_sched->mac_pdu.subheader[dl_sched->mac_pdu.N_subheaders-i-1],
-                               sizeof(LIBLTE_MAC_PDU_SUBHEADER_STRUCT));
-                    dl_sched->mac_pdu.subheader[0].lcid = LIBLTE_MAC_DLSCH_PADDING_LCID;
-                    dl_sched->mac_pdu.N_subheaders++;
-                }else if(2 == N_pad){
-                    for(uint32 i=0; i<dl_sched->mac_pdu.N_subheaders; i++)
-                        memcpy(&dl_sched->mac_pdu.subheader[dl_sched->mac_pdu.N_subheaders-i+1],
-                               &dl_sched->mac_pdu.subheader[dl_sched->mac_pdu.N_subheaders-i-1],
-                               sizeof(LIBLTE_MAC_PDU_SUBHEADER_STRUCT));
-                    dl_sched->mac_pdu.subheader[0].lcid  = LIBLTE_MAC_DLSCH_PADDING_LCID;
-                    dl_sched->mac_pdu.subheader[1].lcid  = LIBLTE_MAC_DLSCH_PADDING_LCID;
-                    dl_sched->mac_pdu.N_subheaders      += 2;
-                }else{
-                    dl_sched->mac_pdu.subheader[dl_sched->mac_pdu.N_subheaders].lcid = LIBLTE_MAC_DLSCH_PADDING_LCID;
-                    dl_sched->mac_pdu.N_subheaders++;
-                }
-
-                liblte_mac_pack_mac_pdu(&dl_sched->mac_pdu,
-                                        &dl_sched->alloc.msg[0]);
-            }
-        }
-
-        // Check for scheduling headroom
         if(!scheduling_headroom(dl_subfr, NULL, dl_sched->alloc.N_prb, 0))
             break;
-
-        // Determine the RB start for the allocation
-        uint32 rb_start     = dl_subfr->next_prb;
-        dl_subfr->next_prb += dl_sched->alloc.N_prb;
-
-        // Fill in the PRBs for the allocation
         for(uint32 i=0; i<dl_sched->alloc.N_prb; i++)
         {
-            dl_sched->alloc.prb[0][i] = rb_start+i;
-            dl_sched->alloc.prb[1][i] = rb_start+i;
-        }
-
-        // Send a PCAP message
-        interface->send_lte_pcap_msg(LTE_FDD_ENB_PCAP_DIRECTION_DL,
-                                     dl_sched->alloc.rnti,
-                                     dl_subfr->current_tti,
-                                     dl_sched->alloc.msg[0].msg,
-                                     dl_sched->alloc.tbs);
-
-        interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
-                                  LTE_FDD_ENB_DEBUG_LEVEL_MAC,
-                                  __FILE__,
-                                  __LINE__,
-                                  &dl_sched->alloc.msg[0],
-                                  "DL allocation (mcs=%u, tbs=%u, N_prb=%u) sent for RNTI=%u CURRENT_TTI=%u",
-                                  dl_sched->alloc.mcs,
-                                  dl_sched->alloc.tbs,
-                                  dl_sched->alloc.N_prb,
-                                  dl_sched->alloc.rnti,
-                                  dl_subfr->current_tti);
-
-        // Schedule DL
-        if(NULL == msgq_to_ue)
-        {
-            memcpy(&dl_subfr->allocations.dl_alloc[dl_subfr->allocations.N_dl_alloc],
-                   &dl_sched->alloc,
-                   sizeof(LIBLTE_PHY_ALLOCATION_STRUCT));
-            dl_subfr->allocations.N_dl_alloc++;
-
-            if(dl_sched->alloc.rnti != LIBLTE_MAC_SI_RNTI)
-            {
-                // Schedule ACK/NACK PUCCH 4 subframes from now and store the DL allocation for potential H-ARQ retransmission
-                std::lock_guard<std::mutex>         si_lock(sys_info_mutex);
-                LTE_FDD_ENB_UL_SCHEDULE_MSG_STRUCT *ul_subfr   = &sched_ul_subfr[(sched_cur_dl_subfn+4)%10];
-                ul_subfr->pucch[ul_subfr->N_pucch].type        = LTE_FDD_ENB_PUCCH_TYPE_ACK_NACK;
-                ul_subfr->pucch[ul_subfr->N_pucch].rnti        = dl_sched->alloc.rnti;
-                ul_subfr->pucch[ul_subfr->N_pucch].n_1_p_pucch = sys_info.sib2.radioResourceConfigCommon_Get().pucch_ConfigCommon_Get().n1PUCCH_AN_Value();
-                ul_subfr->pucch[ul_subfr->N_pucch].decode      = true;
-                ul_subfr->N_pucch++;
-                LTE_fdd_enb_user *user;
-                if(LTE_FDD_ENB_ERROR_NONE == user_mgr->find_user(dl_sched->alloc.rnti, &user))
-                    user->store_harq_info(ul_subfr->current_tti, &dl_sched->mac_pdu, &dl_sched->alloc);
-            }
-        }else{
-            LIBTOOLS_IPC_MSGQ_MAC_PDU_MSG_STRUCT mac_pdu_msg;
-            memcpy(&mac_pdu_msg.msg, &dl_sched->alloc.msg[0], sizeof(mac_pdu_msg.msg));
-            mac_pdu_msg.rnti = dl_sched->alloc.rnti;
-            msgq_to_ue->send(LIBTOOLS_IPC_MSGQ_MESSAGE_TYPE_MAC_PDU,
-                             (LIBTOOLS_IPC_MSGQ_MESSAGE_UNION *)&mac_pdu_msg,
-                             sizeof(mac_pdu_msg));
+            dl_sched->alloc.prb[0][i] = dl_subfr->next_prb + i;
+            dl_sched->alloc.prb[1][i] = dl_subfr->next_prb + i;
         }
+        send_dl_alloc(dl_subfr, &dl_sched->alloc);
 
         // Remove DL schedule from queue
         dl_sched_queue.pop_front();
         delete dl_sched;
     }
 }
-void LTE_fdd_enb_mac::ul_scheduler()
+void LTE_fdd_enb_mac::dl_harq_scheduler()
 {
-    std::lock_guard<std::mutex> lock(ul_sched_queue_mutex);
-
-    // Schedule UL for the next subframe
-    while(0 != ul_sched_queue.size())
+    LTE_FDD_ENB_DL_SCHEDULE_MSG_STRUCT *dl_subfr = &sched_dl_subfr[sched_cur_dl_subfn];
+    LIBLTE_PHY_ALLOCATION_STRUCT        alloc;
+    LTE_fdd_enb_user                   *user;
+    std::lock_guard<std::mutex>         lock(dl_harq_retx_queue_mutex);
+
+    // Retransmissions are asynchronous, any that are not due yet or
+    // don't fit in this subframe go to the back of the queue
+    uint32 N_retx = N_dl_harq_retx;
+    for(uint32 i=0; i<N_retx; i++)
     {
-        LTE_FDD_ENB_UL_SCHED_QUEUE_STRUCT  *ul_sched = ul_sched_queue.front();
-        LTE_FDD_ENB_DL_SCHEDULE_MSG_STRUCT *dl_subfr = &sched_dl_subfr[sched_cur_dl_subfn];
-        LTE_FDD_ENB_UL_SCHEDULE_MSG_STRUCT *ul_subfr = &sched_ul_subfr[(sched_cur_dl_subfn+4)%10];
+        LTE_FDD_ENB_DL_HARQ_RETX_STRUCT retx = dl_harq_retx_queue[dl_harq_retx_queue_head];
+        dl_harq_retx_queue_head = (dl_harq_retx_queue_head + 1) % LTE_FDD_ENB_MAC_DL_HARQ_RETX_QUEUE_SIZE;
+        N_dl_harq_retx--;
+        if(LTE_FDD_ENB_ERROR_NONE != user_mgr->find_user(retx.rnti, &user))
+            continue;
 
-        // Check if the scheduled TTI is in the past
-        if(liblte_phy_is_tti_in_past(ul_sched->current_tti, ul_subfr->current_tti))
+        bool send = !liblte_phy_is_tti_in_future(retx.current_tti, dl_subfr->current_tti);
+        for(uint32 j=0; j<dl_subfr->allocations.N_dl_alloc; j++)
+            if(retx.rnti == dl_subfr->allocations.dl_alloc[j].rnti)
+                send = false;
+        if(send)
         {
-            // Remove UL schedule from queue
-            interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
-                                      LTE_FDD_ENB_DEBUG_LEVEL_MAC,
-                                      __FILE__,
-                                      __LINE__,
-                                      "UL in the past %u %u",
-                                      ul_sched->current_tti,
-                                      ul_subfr->current_tti);
-            ul_sched_queue.pop_front();
-            delete ul_sched;
+            fill_dl_alloc(user, &alloc);
+            if(LTE_FDD_ENB_ERROR_NONE != user->get_harq_retx_alloc(retx.harq_process, &alloc))
+                continue;
+            send = scheduling_headroom(dl_subfr, NULL, alloc.N_prb, 0);
+        }
+        if(!send)
+        {
+            dl_harq_retx_queue[(dl_harq_retx_queue_head + N_dl_harq_retx) % LTE_FDD_ENB_MAC_DL_HARQ_RETX_QUEUE_SIZE] = retx;
+            N_dl_harq_retx++;
             continue;
         }
 
-        // Check for scheduling headroom
-        if(!scheduling_headroom(dl_subfr, ul_subfr, 0, ul_sched->alloc.N_prb))
-            break;
-
-        // Determine the RB start
-        uint32 rb_start     = ul_subfr->next_prb;
-        ul_subfr->next_prb += ul_sched->alloc.N_prb;
-
-        // Fill in the PRBs
-        for(uint32 i=0; i<ul_sched->alloc.N_prb; i++)
+        // The stored transport block is resent unchanged, so it keeps
+        // its PRB count and is placed contiguously after SI
+        for(uint32 j=0; j<alloc.N_prb; j++)
         {
-            ul_sched->alloc.prb[0][i] = rb_start+i;
-            ul_sched->alloc.prb[1][i] = rb_start+i;
+            alloc.prb[0][j] = dl_subfr->next_prb + j;
+            alloc.prb[1][j] = dl_subfr->next_prb + j;
         }
+        send_dl_alloc(dl_subfr, &alloc);
+    }
+}
+void LTE_fdd_enb_mac::dl_mux_scheduler()
+{
+    LTE_FDD_ENB_DL_SCHEDULE_MSG_STRUCT    *dl_subfr = &sched_dl_subfr[sched_cur_dl_subfn];
+    LTE_FDD_ENB_DL_SCHED_CANDIDATE_STRUCT  cand[LIBLTE_MAC_DL_SCHED_MAX_N_UE];
+    LIBLTE_MAC_DL_SCHED_UE_STRUCT          sched_ue[LIBLTE_MAC_DL_SCHED_MAX_N_UE];
+    uint32                                 order[LIBLTE_MAC_DL_SCHED_MAX_N_UE];
+    bool                                   prb_used[LIBLTE_PHY_N_RB_DL_MAX];
+    LTE_fdd_enb_user                      *user;
+    uint32                                 N_cand  = 0;
+    uint32                                 N_rb_dl = interface->get_n_rb_dl();
+    std::lock_guard<std::mutex>            lock(dl_pending_mutex);
+
+    if(dl_subfr->N_sched_prbs >= dl_subfr->N_avail_prbs)
+        return;
 
-        interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
-                                  LTE_FDD_ENB_DEBUG_LEVEL_MAC,
-                                  __FILE__,
-                                  __LINE__,
-                                  "UL allocation sent for RNTI=%u CURRENT_TTI=%u",
-                                  ul_sched->alloc.rnti,
-                                  ul_subfr->current_tti);
+    // Collect up to LIBLTE_MAC_DL_SCHED_MAX_N_UE UEs with DL data,
+    // rotating the order each TTI so every UE gets considered
+    uint32 N_pending = dl_pending_rntis.size();
+    for(uint32 i=0; i<N_pending && N_cand<LIBLTE_MAC_DL_SCHED_MAX_N_UE; i++)
+    {
+        uint16 rnti = dl_pending_rntis.front();
+        dl_pending_rntis.pop_front();
+        if(LTE_FDD_ENB_ERROR_NONE != user_mgr->find_user(rnti, &user))
+            continue;
 
-        // Schedule UL decode 4 subframes from now
-        if(NULL == msgq_to_ue)
-        {
-            memcpy(&ul_subfr->decodes.ul_alloc[ul_subfr->decodes.N_ul_alloc],
-                   &ul_sched->alloc,
-                   sizeof(LIBLTE_PHY_ALLOCATION_STRUCT));
-            ul_subfr->decodes.N_ul_alloc++;
-            // Schedule UL allocation
-            memcpy(&dl_subfr->allocations.ul_alloc[dl_subfr->allocations.N_ul_alloc],
-                   &ul_sched->alloc,
-                   sizeof(LIBLTE_PHY_ALLOCATION_STRUCT));
-            dl_subfr->allocations.N_ul_alloc++;
-        }else{
-            LIBTOOLS_IPC_MSGQ_UL_ALLOC_MSG_STRUCT ul_alloc_msg;
-            ul_alloc_msg.size = ul_sched->alloc.tbs;
-            ul_alloc_msg.tti  = ul_subfr->current_tti;
-            ul_alloc_msg.rnti = ul_sched->alloc.rnti;
-            msgq_to_ue->send(LIBTOOLS_IPC_MSGQ_MESSAGE_TYPE_UL_ALLOC,
-                             (LIBTOOLS_IPC_MSGQ_MESSAGE_UNION *)&ul_alloc_msg,
-                             sizeof(ul_alloc_msg));
-        }
+        uint32 N_min_bytes;
+        uint32 N_bytes = get_dl_buffer_status(user, dl_subfr->current_tti, &N_min_bytes);
+        if(0 == N_bytes)
+            continue;
+        dl_pending_rntis.push_back(rnti);
+
+        // H-ARQ retransmissions for this UE have already been scheduled
+        bool scheduled = false;
+        for(uint32 j=0; j<dl_subfr->allocations.N_dl_alloc; j++)
+            if(rnti == dl_subfr->allocations.dl_alloc[j].rnti)
+                scheduled = true;
+        if(scheduled)
+            continue;
 
-        // Remove UL schedule from queue
-        ul_sched_queue.pop_front();
-        delete ul_sched;
+        // The rate the UE could get from all of the remaining PRBs
+        uint32 inst_rate;
+        uint32 N_prb;
+        liblte_phy_get_tbs_and_n_prb_for_dl(LIBLTE_MAX_MSG_SIZE*8,
+                                            dl_subfr->N_avail_prbs - dl_subfr->N_sched_prbs,
+                                            user->get_dl_mcs(),
+                                            &inst_rate,
+                                            &N_prb);
+
+        cand[N_cand].user            = user;
+        cand[N_cand].N_bytes         = N_bytes;
+        cand[N_cand].N_min_bytes     = N_min_bytes;
+        sched_ue[N_cand].avg_thruput = user->get_dl_avg_thruput();
+        sched_ue[N_cand].inst_rate   = inst_rate;
+        sched_ue[N_cand].last_tti    = user->get_dl_last_tti();
+        sched_ue[N_cand].rnti        = rnti;
+        N_cand++;
+    }
+    if(0 == N_cand ||
+       LIBLTE_SUCCESS != liblte_mac_dl_sched_order(interface->get_dl_scheduler(),
+                                                   sched_ue,
+                                                   N_cand,
+                                                   dl_subfr->current_tti,
+                                                   order))
+        return;
+
+    // PRBs already taken by SI, RARs, and H-ARQ retransmissions
+    for(uint32 i=0; i<N_rb_dl; i++)
+        prb_used[i] = (i < dl_subfr->next_prb || i >= dl_subfr->N_avail_prbs);
+
+    // Serve the UEs in policy order until the PRBs or DCIs run out,
+    // every candidate's average throughput is updated either way
+    LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_ENUM ra_type = interface->get_dl_ra_type();
+    for(uint32 i=0; i<N_cand; i++)
+    {
+        uint32 idx    = order[i];
+        uint32 N_bits = 0;
+        if(dl_subfr->N_sched_prbs < dl_subfr->N_avail_prbs &&
+           scheduling_headroom(dl_subfr, NULL, 1, 0))
+            N_bits = schedule_dl_user(dl_subfr, &cand[idx], ra_type, prb_used);
+        liblte_mac_dl_sched_update(&sched_ue[idx], dl_subfr->current_tti, N_bits);
+        cand[idx].user->set_dl_avg_thruput(sched_ue[idx].avg_thruput);
+        cand[idx].user->set_dl_last_tti(sched_ue[idx].last_tti);
+    }
+}
+void LTE_fdd_enb_mac::ul_scheduler()
+{
+    LTE_FDD_ENB_DL_SCHEDULE_MSG_STRUCT *dl_subfr = &sched_dl_subfr[sched_cur_dl_subfn];
+    LTE_FDD_ENB_UL_SCHEDULE_MSG_STRUCT *ul_subfr = &sched_ul_subfr[(sched_cur_dl_subfn+4)%10];
+    LTE_fdd_enb_user                   *cand[LIBLTE_MAC_DL_SCHED_MAX_N_UE];
+    LIBLTE_MAC_DL_SCHED_UE_STRUCT       sched_ue[LIBLTE_MAC_DL_SCHED_MAX_N_UE];
+    uint32                              order[LIBLTE_MAC_DL_SCHED_MAX_N_UE];
+    LTE_fdd_enb_user                   *user;
+    uint32                              N_cand = 0;
+    std::lock_guard<std::mutex>         lock(ul_pending_mutex);
+
+    if(ul_subfr->N_sched_prbs >= ul_subfr->N_avail_prbs)
+        return;
+
+    // Collect up to LIBLTE_MAC_DL_SCHED_MAX_N_UE UEs with UL data,
+    // rotating the order each TTI so every UE gets considered
+    uint32 N_pending = ul_pending_rntis.size();
+    for(uint32 i=0; i<N_pending && N_cand<LIBLTE_MAC_DL_SCHED_MAX_N_UE; i++)
+    {
+        uint16 rnti = ul_pending_rntis.front();
+        ul_pending_rntis.pop_front();
+        if(LTE_FDD_ENB_ERROR_NONE != user_mgr->find_user(rnti, &user) ||
+           0                      == user->get_ul_buffer_size())
+            continue;
+        ul_pending_rntis.push_back(rnti);
+
+        // The UE retransmits on its own when the H-ARQ process for
+        // this subframe is still waiting on a CRC pass
+        if(user->get_ul_harq_proc(ul_subfr->current_tti)->active)
+            continue;
+
+        // The rate the UE could get from all of the remaining PRBs
+        uint32 inst_rate;
+        uint32 N_prb;
+        liblte_phy_get_tbs_and_n_prb_for_ul(LIBLTE_MAX_MSG_SIZE*8,
+                                            ul_subfr->N_avail_prbs - ul_subfr->N_sched_prbs,
+                                            user->get_ul_mcs(),
+                                            &inst_rate,
+                                            &N_prb);
+
+        cand[N_cand]                 = user;
+        sched_ue[N_cand].avg_thruput = user->get_ul_avg_thruput();
+        sched_ue[N_cand].inst_rate   = inst_rate;
+        sched_ue[N_cand].last_tti    = user->get_ul_last_tti();
+        sched_ue[N_cand].rnti        = rnti;
+        N_cand++;
+    }
+    if(0 == N_cand ||
+       LIBLTE_SUCCESS != liblte_mac_dl_sched_order(LIBLTE_MAC_DL_SCHED_POLICY_PROPORTIONAL_FAIR,
+                                                   sched_ue,
+                                                   N_cand,
+                                                   ul_subfr->current_tti,
+                                                   order))
+        return;
+
+    // Pack the UEs in proportional fair order into back to back PRB
+    // blocks between the PUCCH regions until the PRBs or DCIs run out
+    for(uint32 i=0; i<N_cand; i++)
+    {
+        uint32 idx    = order[i];
+        uint32 N_bits = 0;
+        if(ul_subfr->N_sched_prbs < ul_subfr->N_avail_prbs &&
+           scheduling_headroom(dl_subfr, ul_subfr, 0, 1))
+            N_bits = schedule_ul_user(dl_subfr, ul_subfr, cand[idx]);
+        liblte_mac_dl_sched_update(&sched_ue[idx], ul_subfr->current_tti, N_bits);
+        cand[idx]->set_ul_avg_thruput(sched_ue[idx].avg_thruput);
+        cand[idx]->set_ul_last_tti(sched_ue[idx].last_tti);
     }
 }
 void LTE_fdd_enb_mac::ul_sr_scheduler()
@@ -1489,7 +1437,6 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_mac::add_to_rar_sched_queue(uint32
     return LTE_FDD_ENB_ERROR_NONE;
 }
 LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_mac::add_to_dl_sched_queue(uint32                        current_tti,
-                                                              LIBLTE_MAC_PDU_STRUCT        *mac_pdu,
                                                               LIBLTE_PHY_ALLOCATION_STRUCT *alloc)
 {
     LTE_FDD_ENB_DL_SCHED_QUEUE_STRUCT *dl_sched = NULL;
@@ -1498,8 +1445,6 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_mac::add_to_dl_sched_queue(uint32
         return LTE_FDD_ENB_ERROR_CANT_SCHEDULE;
 
     dl_sched->current_tti = current_tti;
-    if(mac_pdu != NULL)
-        memcpy(&dl_sched->mac_pdu, mac_pdu, sizeof(LIBLTE_MAC_PDU_STRUCT));
     memcpy(&dl_sched->alloc, alloc, sizeof(LIBLTE_PHY_ALLOCATION_STRUCT));
 
     std::lock_guard<std::mutex> lock(dl_sched_queue_mutex);
@@ -1519,29 +1464,545 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_mac::add_to_dl_sched_queue(uint32
 
     return LTE_FDD_ENB_ERROR_NONE;
 }
-LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_mac::add_to_ul_sched_queue(uint32                        current_tti,
-                                                              LIBLTE_PHY_ALLOCATION_STRUCT *alloc)
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_mac::add_to_dl_harq_retx_queue(uint32 current_tti,
+                                                                  uint16 rnti,
+                                                                  uint8  harq_process)
 {
-    LTE_FDD_ENB_UL_SCHED_QUEUE_STRUCT *ul_sched = NULL;
-    ul_sched = new LTE_FDD_ENB_UL_SCHED_QUEUE_STRUCT;
-    if(NULL == ul_sched)
-        return LTE_FDD_ENB_ERROR_CANT_SCHEDULE;
-
-    ul_sched->current_tti = current_tti;
-    memcpy(&ul_sched->alloc, alloc, sizeof(LIBLTE_PHY_ALLOCATION_STRUCT));
+    std::lock_guard<std::mutex> lock(dl_harq_retx_queue_mutex);
 
-    std::lock_guard<std::mutex> lock(ul_sched_queue_mutex);
-    bool sched = true;
-    for(auto ul_sq : ul_sched_queue)
-        if(ul_sq->alloc.rnti == alloc->rnti && ul_sq->current_tti == ul_sched->current_tti)
-            sched = false;
-    if(!sched)
+    if(LTE_FDD_ENB_MAC_DL_HARQ_RETX_QUEUE_SIZE <= N_dl_harq_retx)
         return LTE_FDD_ENB_ERROR_CANT_SCHEDULE;
 
-    ul_sched_queue.push_back(ul_sched);
+    LTE_FDD_ENB_DL_HARQ_RETX_STRUCT *retx = &dl_harq_retx_queue[(dl_harq_retx_queue_head + N_dl_harq_retx) % LTE_FDD_ENB_MAC_DL_HARQ_RETX_QUEUE_SIZE];
+    retx->current_tti  = current_tti;
+    retx->rnti         = rnti;
+    retx->harq_process = harq_process;
+    N_dl_harq_retx++;
+
     return LTE_FDD_ENB_ERROR_NONE;
 }
 
+/*************************/
+/*    DL Multiplexing    */
+/*************************/
+void LTE_fdd_enb_mac::fill_dl_alloc(LTE_fdd_enb_user             *user,
+                                    LIBLTE_PHY_ALLOCATION_STRUCT *alloc)
+{
+    alloc->pre_coder_type = LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY;
+    alloc->mod_type       = get_modulation_type(user->get_dl_mcs());
+    alloc->chan_type      = LIBLTE_PHY_CHAN_TYPE_DLSCH;
+    alloc->tbs            = 0;
+    alloc->rv_idx         = 0;
+    alloc->N_prb          = 0;
+    alloc->N_codewords    = 1;
+    alloc->N_layers       = 0;
+    sys_info_mutex.lock();
+    if(1 == interface->get_n_ant())
+    {
+        alloc->tx_mode = 1;
+    }else{
+        alloc->tx_mode = 2;
+    }
+    sys_info_mutex.unlock();
+    alloc->codebook_idx    = 0;
+    alloc->harq_retx_count = 0;
+    alloc->rnti            = user->get_c_rnti();
+    alloc->mcs             = user->get_dl_mcs();
+    alloc->tpc             = LIBLTE_PHY_TPC_COMMAND_DCI_1_1A_1B_1D_2_3_DB_ZERO;
+    alloc->harq_process    = 0;
+    alloc->ndi             = 0;
+    alloc->dl_alloc        = true;
+}
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_mac::get_dl_rb(LTE_fdd_enb_user  *user,
+                                                  uint32             rb_id,
+                                                  LTE_fdd_enb_rb   **rb)
+{
+    switch(rb_id)
+    {
+    case LTE_FDD_ENB_RB_SRB0:
+        user->get_srb0(rb);
+        return LTE_FDD_ENB_ERROR_NONE;
+    case LTE_FDD_ENB_RB_SRB1:
+        return user->get_srb1(rb);
+    case LTE_FDD_ENB_RB_SRB2:
+        return user->get_srb2(rb);
+    default:
+        break;
+    }
+
+    return user->get_drb((LTE_FDD_ENB_RB_ENUM)rb_id, rb);
+}
+uint32 LTE_fdd_enb_mac::get_dl_buffer_status(LTE_fdd_enb_user *user,
+                                             uint32            current_tti,
+                                             uint32           *N_min_bytes)
+{
+    LTE_fdd_enb_rb         *rb;
+    LIBLTE_BYTE_MSG_STRUCT *sdu;
+    uint32                  N_bytes     = 0;
+    uint32                  N_hol_bytes = 0;
+
+    // Control elements
+    user->get_srb0(&rb);
+    if(rb->get_send_con_res_id())
+        N_bytes += LIBLTE_MAC_DLSCH_CE_SUBHEADER_N_BYTES + LIBLTE_MAC_UE_CONTENTION_RESOLUTION_ID_CE_N_BYTES;
+    if(LTE_FDD_ENB_MAC_TA_COMMAND_PERIOD <= liblte_phy_sub_from_tti(current_tti, user->get_ta_command_tti()))
+        N_bytes += LIBLTE_MAC_DLSCH_CE_SUBHEADER_N_BYTES + LIBLTE_MAC_TA_COMMAND_CE_N_BYTES;
+    *N_min_bytes = N_bytes;
+
+    // Logical channels
+    for(uint32 rb_id=LTE_FDD_ENB_RB_SRB0; rb_id<LTE_FDD_ENB_RB_N_ITEMS; rb_id++)
+    {
+        if(LTE_FDD_ENB_ERROR_NONE != get_dl_rb(user, rb_id, &rb))
+            continue;
+        if(LTE_FDD_ENB_ERROR_NONE == rb->get_next_mac_sdu(&sdu))
+        {
+            N_bytes += sdu->N_bytes + LIBLTE_MAC_DLSCH_SDU_SUBHEADER_MAX_N_BYTES;
+            if(sdu->N_bytes + LIBLTE_MAC_DLSCH_SDU_SUBHEADER_MAX_N_BYTES > N_hol_bytes)
+                N_hol_bytes = sdu->N_bytes + LIBLTE_MAC_DLSCH_SDU_SUBHEADER_MAX_N_BYTES;
+        }
+        uint32 N_rlc_bytes = rlc->get_buffer_status(rb);
+        if(0 != N_rlc_bytes)
+            N_bytes += N_rlc_bytes + LIBLTE_MAC_DLSCH_SDU_SUBHEADER_MAX_N_BYTES;
+    }
+    *N_min_bytes += N_hol_bytes;
+
+    return N_bytes;
+}
+void LTE_fdd_enb_mac::build_dl_mac_pdu(LTE_fdd_enb_user      *user,
+                                       uint32                 current_tti,
+                                       uint32                 N_bytes,
+                                       LIBLTE_MAC_PDU_STRUCT *mac_pdu)
+{
+    LTE_fdd_enb_rb                  *rb;
+    LIBLTE_BYTE_MSG_STRUCT          *sdu;
+    LIBLTE_MAC_PDU_SUBHEADER_STRUCT *subheader;
+    uint32                           N_subheader_bytes;
+
+    // Leave room for up to two padding subheaders
+    uint32 N_max_subheaders = LIBLTE_MAC_MAX_MAC_PDU_N_SUBHEADERS - 2;
+
+    mac_pdu->chan_type    = LIBLTE_MAC_CHAN_TYPE_DLSCH;
+    mac_pdu->N_subheaders = 0;
+
+    // Control elements go first
+    user->get_srb0(&rb);
+    N_subheader_bytes = LIBLTE_MAC_DLSCH_CE_SUBHEADER_N_BYTES + LIBLTE_MAC_UE_CONTENTION_RESOLUTION_ID_CE_N_BYTES;
+    if(rb->get_send_con_res_id() && N_subheader_bytes <= N_bytes)
+    {
+        subheader                           = &mac_pdu->subheader[mac_pdu->N_subheaders++];
+        subheader->lcid                     = LIBLTE_MAC_DLSCH_UE_CONTENTION_RESOLUTION_ID_LCID;
+        subheader->payload.ue_con_res_id.id = rb->get_con_res_id();
+        rb->set_send_con_res_id(false);
+        N_bytes -= N_subheader_bytes;
+    }
+    N_subheader_bytes = LIBLTE_MAC_DLSCH_CE_SUBHEADER_N_BYTES + LIBLTE_MAC_TA_COMMAND_CE_N_BYTES;
+    if(LTE_FDD_ENB_MAC_TA_COMMAND_PERIOD <= liblte_phy_sub_from_tti(current_tti, user->get_ta_command_tti()) &&
+       N_subheader_bytes                 <= N_bytes)
+    {
+        // No UL timing is measured, so only restart the UE time
+        // alignment timer
+        subheader                        = &mac_pdu->subheader[mac_pdu->N_subheaders++];
+        subheader->lcid                  = LIBLTE_MAC_DLSCH_TA_COMMAND_LCID;
+        subheader->payload.ta_command.ta = LTE_FDD_ENB_MAC_TA_COMMAND_NO_CHANGE;
+        user->set_ta_command_tti(current_tti);
+        N_bytes -= N_subheader_bytes;
+    }
+
+    // Logical channels in priority order, SRBs before DRBs
+    for(uint32 rb_id=LTE_FDD_ENB_RB_SRB0; rb_id<LTE_FDD_ENB_RB_N_ITEMS; rb_id++)
+    {
+        if(LTE_FDD_ENB_ERROR_NONE != get_dl_rb(user, rb_id, &rb))
+            continue;
+
+        // PDUs that RLC has already built (TM, STATUS, and retransmissions)
+        while(mac_pdu->N_subheaders < N_max_subheaders                 &&
+              LTE_FDD_ENB_ERROR_NONE == rb->get_next_mac_sdu(&sdu)     &&
+              sdu->N_bytes + LIBLTE_MAC_DLSCH_SDU_SUBHEADER_MAX_N_BYTES <= N_bytes)
+        {
+            subheader                      = &mac_pdu->subheader[mac_pdu->N_subheaders++];
+            subheader->lcid                = rb->get_rb_id();
+            subheader->payload.sdu.N_bytes = sdu->N_bytes;
+            memcpy(subheader->payload.sdu.msg, sdu->msg, sdu->N_bytes);
+            N_bytes -= sdu->N_bytes + LIBLTE_MAC_DLSCH_SDU_SUBHEADER_MAX_N_BYTES;
+            rb->delete_next_mac_sdu();
+        }
+
+        // New data sized to what is left of the grant
+        if(mac_pdu->N_subheaders < N_max_subheaders                 &&
+           LIBLTE_MAC_DLSCH_SDU_SUBHEADER_MAX_N_BYTES < N_bytes     &&
+           0                                          != rlc->get_buffer_status(rb))
+        {
+            subheader                      = &mac_pdu->subheader[mac_pdu->N_subheaders];
+            subheader->payload.sdu.N_bytes = 0;
+            if(LTE_FDD_ENB_ERROR_NONE == rlc->build_pdu(user,
+                                                        rb,
+                                                        N_bytes - LIBLTE_MAC_DLSCH_SDU_SUBHEADER_MAX_N_BYTES,
+                                                        &subheader->payload.sdu) &&
+               0 != subheader->payload.sdu.N_bytes)
+            {
+                subheader->lcid = rb->get_rb_id();
+                mac_pdu->N_subheaders++;
+                N_bytes -= subheader->payload.sdu.N_bytes + LIBLTE_MAC_DLSCH_SDU_SUBHEADER_MAX_N_BYTES;
+            }
+        }
+    }
+}
+uint32 LTE_fdd_enb_mac::schedule_dl_user(LTE_FDD_ENB_DL_SCHEDULE_MSG_STRUCT       *dl_subfr,
+                                         LTE_FDD_ENB_DL_SCHED_CANDIDATE_STRUCT    *cand,
+                                         LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_ENUM  ra_type,
+                                         bool                                     *prb_used)
+{
+    LIBLTE_PHY_ALLOCATION_STRUCT alloc;
+    LIBLTE_MAC_PDU_STRUCT        mac_pdu;
+    LIBLTE_BYTE_MSG_STRUCT       tb;
+    uint32                       N_rb_dl  = interface->get_n_rb_dl();
+    uint32                       rbg_size = liblte_phy_get_rbg_size(N_rb_dl);
+    uint32                       N_bytes  = cand->N_bytes;
+    uint32                       N_prb_req;
+    uint32                       N_prb;
+
+    // New data needs an idle H-ARQ process
+    fill_dl_alloc(cand->user, &alloc);
+    if(LTE_FDD_ENB_ERROR_NONE != cand->user->get_free_harq_process(&alloc.harq_process, &alloc.ndi))
+        return 0;
+
+    // Size the transport block, PDUs that RLC has already built
+    // can't be segmented so they must fit whole
+    if(N_bytes > LIBLTE_MAX_MSG_SIZE)
+        N_bytes = LIBLTE_MAX_MSG_SIZE;
+    liblte_phy_get_tbs_and_n_prb_for_dl(N_bytes*8,
+                                        N_rb_dl,
+                                        alloc.mcs,
+                                        &alloc.tbs,
+                                        &N_prb_req);
+    if(LIBLTE_SUCCESS != liblte_mac_dl_sched_alloc_prbs(ra_type,
+                                                        rbg_size,
+                                                        N_rb_dl,
+                                                        N_prb_req,
+                                                        prb_used,
+                                                        alloc.prb[0],
+                                                        &alloc.N_prb) ||
+       0 == alloc.N_prb)
+        return 0;
+
+    // Type 0 rounds up to whole RBGs, give RBGs back from the top
+    // until the transport block fits in a message
+    liblte_phy_get_tbs_and_n_prb_for_dl(LIBLTE_MAX_MSG_SIZE*8, alloc.N_prb, alloc.mcs, &alloc.tbs, &N_prb);
+    while(LIBLTE_MAX_MSG_SIZE*8 < alloc.tbs)
+    {
+        uint32 rbg = alloc.prb[0][alloc.N_prb-1]/rbg_size;
+        while(0 < alloc.N_prb && rbg == alloc.prb[0][alloc.N_prb-1]/rbg_size)
+            prb_used[alloc.prb[0][--alloc.N_prb]] = false;
+        if(0 == alloc.N_prb)
+            return 0;
+        liblte_phy_get_tbs_and_n_prb_for_dl(LIBLTE_MAX_MSG_SIZE*8, alloc.N_prb, alloc.mcs, &alloc.tbs, &N_prb);
+    }
+    if(alloc.tbs < cand->N_min_bytes*8)
+    {
+        release_dl_prbs(&alloc, prb_used);
+        return 0;
+    }
+    for(uint32 i=0; i<alloc.N_prb; i++)
+        alloc.prb[1][i] = alloc.prb[0][i];
+
+    // Fill the transport block and pack it
+    build_dl_mac_pdu(cand->user, dl_subfr->current_tti, alloc.tbs/8, &mac_pdu);
+    if(0 == mac_pdu.N_subheaders)
+    {
+        release_dl_prbs(&alloc, prb_used);
+        return 0;
+    }
+    if(LIBLTE_SUCCESS != liblte_mac_pack_dlsch_mac_pdu(&mac_pdu, alloc.tbs/8, &tb))
+    {
+        interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ERROR,
+                                  LTE_FDD_ENB_DEBUG_LEVEL_MAC,
+                                  __FILE__,
+                                  __LINE__,
+                                  "Can't pack DL MAC PDU for RNTI=%u, tbs=%u",
+                                  alloc.rnti,
+                                  alloc.tbs);
+        release_dl_prbs(&alloc, prb_used);
+        return 0;
+    }
+    uint8 *msg_ptr = alloc.msg[0].msg;
+    liblte_bytes_2_bits(tb.msg, tb.N_bytes, &msg_ptr);
+    alloc.msg[0].N_bits = alloc.tbs;
+
+    send_dl_alloc(dl_subfr, &alloc);
+
+    return alloc.tbs;
+}
+void LTE_fdd_enb_mac::release_dl_prbs(LIBLTE_PHY_ALLOCATION_STRUCT *alloc,
+                                      bool                         *prb_used)
+{
+    for(uint32 i=0; i<alloc->N_prb; i++)
+        prb_used[alloc->prb[0][i]] = false;
+    alloc->N_prb = 0;
+}
+void LTE_fdd_enb_mac::send_dl_alloc(LTE_FDD_ENB_DL_SCHEDULE_MSG_STRUCT *dl_subfr,
+                                    LIBLTE_PHY_ALLOCATION_STRUCT       *alloc)
+{
+    // Account for the PRBs of the allocation, which are in
+    // ascending order
+    dl_subfr->N_sched_prbs += alloc->N_prb;
+    if(0 != alloc->N_prb && alloc->prb[0][alloc->N_prb-1] >= dl_subfr->next_prb)
+        dl_subfr->next_prb = alloc->prb[0][alloc->N_prb-1] + 1;
+
+    // Send a PCAP message
+    interface->send_lte_pcap_msg(LTE_FDD_ENB_PCAP_DIRECTION_DL,
+                                 alloc->rnti,
+                                 dl_subfr->current_tti,
+                                 alloc->msg[0].msg,
+                                 alloc->tbs);
+
+    interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
+                              LTE_FDD_ENB_DEBUG_LEVEL_MAC,
+                              __FILE__,
+                              __LINE__,
+                              &alloc->msg[0],
+                              "DL allocation (mcs=%u, tbs=%u, N_prb=%u) sent for RNTI=%u CURRENT_TTI=%u",
+                              alloc->mcs,
+                              alloc->tbs,
+                              alloc->N_prb,
+                              alloc->rnti,
+                              dl_subfr->current_tti);
+
+    // Schedule DL
+    if(NULL == msgq_to_ue)
+    {
+        memcpy(&dl_subfr->allocations.dl_alloc[dl_subfr->allocations.N_dl_alloc],
+               alloc,
+               sizeof(LIBLTE_PHY_ALLOCATION_STRUCT));
+        dl_subfr->allocations.N_dl_alloc++;
+
+        if(alloc->rnti != LIBLTE_MAC_SI_RNTI)
+        {
+            // Schedule ACK/NACK PUCCH 4 subframes from now and store the DL allocation for potential H-ARQ retransmission
+            std::lock_guard<std::mutex>         si_lock(sys_info_mutex);
+            LTE_FDD_ENB_UL_SCHEDULE_MSG_STRUCT *ul_subfr   = &sched_ul_subfr[(sched_cur_dl_subfn+4)%10];
+            ul_subfr->pucch[ul_subfr->N_pucch].type        = LTE_FDD_ENB_PUCCH_TYPE_ACK_NACK;
+            ul_subfr->pucch[ul_subfr->N_pucch].rnti        = alloc->rnti;
+            ul_subfr->pucch[ul_subfr->N_pucch].n_1_p_pucch = sys_info.sib2.radioResourceConfigCommon_Get().pucch_ConfigCommon_Get().n1PUCCH_AN_Value();
+            ul_subfr->pucch[ul_subfr->N_pucch].decode      = true;
+            ul_subfr->N_pucch++;
+            LTE_fdd_enb_user *user;
+            if(LTE_FDD_ENB_ERROR_NONE == user_mgr->find_user(alloc->rnti, &user))
+                user->store_harq_info(ul_subfr->current_tti, alloc);
+        }
+    }else{
+        LIBTOOLS_IPC_MSGQ_MAC_PDU_MSG_STRUCT mac_pdu_msg;
+        memcpy(&mac_pdu_msg.msg, &alloc->msg[0], sizeof(mac_pdu_msg.msg));
+        mac_pdu_msg.rnti = alloc->rnti;
+        msgq_to_ue->send(LIBTOOLS_IPC_MSGQ_MESSAGE_TYPE_MAC_PDU,
+                         (LIBTOOLS_IPC_MSGQ_MESSAGE_UNION *)&mac_pdu_msg,
+                         sizeof(mac_pdu_msg));
+    }
+}
+
+/*************************/
+/*    UL Multiplexing    */
+/*************************/
+uint32 LTE_fdd_enb_mac::schedule_ul_user(LTE_FDD_ENB_DL_SCHEDULE_MSG_STRUCT *dl_subfr,
+                                         LTE_FDD_ENB_UL_SCHEDULE_MSG_STRUCT *ul_subfr,
+                                         LTE_fdd_enb_user                   *user)
+{
+    LIBLTE_PHY_ALLOCATION_STRUCT alloc;
+    alloc.pre_coder_type = LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY;
+    alloc.mcs            = user->get_ul_mcs();
+    alloc.mod_type       = get_ul_modulation_type(alloc.mcs);
+    alloc.chan_type      = LIBLTE_PHY_CHAN_TYPE_ULSCH;
+    alloc.rv_idx         = 0;
+    alloc.N_codewords    = 1;
+    alloc.N_layers       = 1;
+    alloc.tx_mode        = 1;
+    alloc.rnti           = user->get_c_rnti();
+    alloc.tpc            = LIBLTE_PHY_TPC_COMMAND_DCI_0_3_4_DB_NEG_1;
+    alloc.ndi            = 0;
+    if(LIBLTE_SUCCESS != liblte_phy_get_tbs_and_n_prb_for_ul(user->get_ul_buffer_size()*8,
+                                                             ul_subfr->N_avail_prbs - ul_subfr->N_sched_prbs,
+                                                             alloc.mcs,
+                                                             &alloc.tbs,
+                                                             &alloc.N_prb))
+        return 0;
+
+    // Place the block directly after the previous one
+    for(uint32 i=0; i<alloc.N_prb; i++)
+    {
+        alloc.prb[0][i] = ul_subfr->next_prb + i;
+        alloc.prb[1][i] = ul_subfr->next_prb + i;
+    }
+    ul_subfr->next_prb     += alloc.N_prb;
+    ul_subfr->N_sched_prbs += alloc.N_prb;
+
+    // The granted bytes are considered sent until the next BSR
+    user->update_ul_buffer_size(alloc.tbs/8);
+
+    interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
+                              LTE_FDD_ENB_DEBUG_LEVEL_MAC,
+                              __FILE__,
+                              __LINE__,
+                              "UL scheduled (mcs=%u, tbs=%u, N_prb=%u, rb_start=%u) for RNTI=%u CURRENT_TTI=%u",
+                              alloc.mcs,
+                              alloc.tbs,
+                              alloc.N_prb,
+                              alloc.prb[0][0],
+                              alloc.rnti,
+                              ul_subfr->current_tti);
+
+    send_ul_alloc(dl_subfr, ul_subfr, &alloc);
+
+    return alloc.tbs;
+}
+void LTE_fdd_enb_mac::send_ul_alloc(LTE_FDD_ENB_DL_SCHEDULE_MSG_STRUCT *dl_subfr,
+                                    LTE_FDD_ENB_UL_SCHEDULE_MSG_STRUCT *ul_subfr,
+                                    LIBLTE_PHY_ALLOCATION_STRUCT       *alloc)
+{
+    // Schedule UL decode 4 subframes from now
+    if(NULL == msgq_to_ue)
+    {
+        ul_subfr->soft_buffer[ul_subfr->decodes.N_ul_alloc] = start_ul_harq(ul_subfr->current_tti, alloc);
+        memcpy(&ul_subfr->decodes.ul_alloc[ul_subfr->decodes.N_ul_alloc],
+               alloc,
+               sizeof(LIBLTE_PHY_ALLOCATION_STRUCT));
+        ul_subfr->decodes.N_ul_alloc++;
+        // Schedule UL allocation
+        memcpy(&dl_subfr->allocations.ul_alloc[dl_subfr->allocations.N_ul_alloc],
+               alloc,
+               sizeof(LIBLTE_PHY_ALLOCATION_STRUCT));
+        dl_subfr->allocations.N_ul_alloc++;
+    }else{
+        LIBTOOLS_IPC_MSGQ_UL_ALLOC_MSG_STRUCT ul_alloc_msg;
+        ul_alloc_msg.size = alloc->tbs;
+        ul_alloc_msg.tti  = ul_subfr->current_tti;
+        ul_alloc_msg.rnti = alloc->rnti;
+        msgq_to_ue->send(LIBTOOLS_IPC_MSGQ_MESSAGE_TYPE_UL_ALLOC,
+                         (LIBTOOLS_IPC_MSGQ_MESSAGE_UNION *)&ul_alloc_msg,
+                         sizeof(ul_alloc_msg));
+    }
+}
+
+/******************/
+/*    UL H-ARQ    */
+/******************/
+LIBLTE_PHY_SOFT_BUFFER_STRUCT* LTE_fdd_enb_mac::start_ul_harq(uint32                        current_tti,
+                                                              LIBLTE_PHY_ALLOCATION_STRUCT *alloc)
+{
+    LTE_fdd_enb_user *user;
+
+    if(LTE_FDD_ENB_ERROR_NONE != user_mgr->find_user(alloc->rnti, &user))
+        return NULL;
+
+    // UL H-ARQ is synchronous, the process is fixed by the TTI and
+    // new data toggles its NDI
+    LTE_FDD_ENB_UL_HARQ_PROC_STRUCT *proc = user->get_ul_harq_proc(current_tti);
+    proc->ndi         = !proc->ndi;
+    proc->mod_type    = alloc->mod_type;
+    proc->tbs         = alloc->tbs;
+    proc->N_prb       = alloc->N_prb;
+    proc->prb_start   = alloc->prb[0][0];
+    proc->current_tti = current_tti;
+    proc->N_tx        = 1;
+    proc->mcs         = alloc->mcs;
+    proc->active      = true;
+    alloc->ndi        = proc->ndi;
+
+    // Decode without combining if the soft buffers have run out
+    if(NULL == proc->soft_buffer)
+        proc->soft_buffer = user_mgr->alloc_soft_buffer();
+    if(NULL != proc->soft_buffer)
+        proc->soft_buffer->N_combined = 0;
+
+    return proc->soft_buffer;
+}
+void LTE_fdd_enb_mac::handle_ul_harq(LTE_fdd_enb_user *user,
+                                     uint32            current_tti,
+                                     bool              crc_pass)
+{
+    LTE_FDD_ENB_UL_HARQ_PROC_STRUCT *proc = user->get_ul_harq_proc(current_tti);
+
+    if(!proc->active || current_tti != proc->current_tti)
+        return;
+    if(crc_pass)
+        return stop_ul_harq(proc);
+    if(LTE_FDD_ENB_MAX_UL_HARQ_TX <= proc->N_tx)
+    {
+        stop_ul_harq(proc);
+        return interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
+                                         LTE_FDD_ENB_DEBUG_LEVEL_MAC,
+                                         __FILE__,
+                                         __LINE__,
+                                         "Not expecting UL HARQ retx due to max tx RNTI=%u TTI=%u",
+                                         user->get_c_rnti(),
+                                         current_tti);
+    }
+
+    // The PHICH NACK makes the UE retransmit on the same PRBs 8
+    // subframes later, which can still be added to the decodes as
+    // long as that subframe hasn't been sent to the PHY
+    uint32                              retx_tti = liblte_phy_add_to_tti(current_tti, 8);
+    LTE_FDD_ENB_UL_SCHEDULE_MSG_STRUCT *ul_subfr = &sched_ul_subfr[retx_tti%10];
+    if(retx_tti                   != ul_subfr->current_tti ||
+       LIBLTE_PHY_PDCCH_MAX_ALLOC <= ul_subfr->decodes.N_ul_alloc)
+    {
+        stop_ul_harq(proc);
+        return interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ERROR,
+                                         LTE_FDD_ENB_DEBUG_LEVEL_MAC,
+                                         __FILE__,
+                                         __LINE__,
+                                         "Can't decode UL HARQ retx RNTI=%u TTI=%u",
+                                         user->get_c_rnti(),
+                                         retx_tti);
+    }
+
+    LIBLTE_PHY_ALLOCATION_STRUCT *alloc = &ul_subfr->decodes.ul_alloc[ul_subfr->decodes.N_ul_alloc];
+    alloc->pre_coder_type  = LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY;
+    alloc->mod_type        = proc->mod_type;
+    alloc->chan_type       = LIBLTE_PHY_CHAN_TYPE_ULSCH;
+    alloc->tbs             = proc->tbs;
+    alloc->rv_idx          = LTE_fdd_enb_harq_rv_idx[proc->N_tx%4];
+    alloc->N_prb           = proc->N_prb;
+    alloc->N_codewords     = 1;
+    alloc->N_layers        = 1;
+    alloc->tx_mode         = 1;
+    alloc->harq_retx_count = proc->N_tx;
+    alloc->rnti            = user->get_c_rnti();
+    alloc->mcs             = proc->mcs;
+    alloc->tpc             = LIBLTE_PHY_TPC_COMMAND_DCI_0_3_4_DB_NEG_1;
+    alloc->ndi             = proc->ndi;
+    alloc->dl_alloc        = false;
+    for(uint32 i=0; i<proc->N_prb; i++)
+    {
+        alloc->prb[0][i] = proc->prb_start + i;
+        alloc->prb[1][i] = proc->prb_start + i;
+    }
+    ul_subfr->soft_buffer[ul_subfr->decodes.N_ul_alloc] = proc->soft_buffer;
+    ul_subfr->decodes.N_ul_alloc++;
+    proc->current_tti = retx_tti;
+    proc->N_tx++;
+
+    // Keep new grants clear of the retransmission
+    if(proc->prb_start + proc->N_prb > ul_subfr->next_prb)
+    {
+        ul_subfr->N_sched_prbs += proc->prb_start + proc->N_prb - ul_subfr->next_prb;
+        ul_subfr->next_prb      = proc->prb_start + proc->N_prb;
+    }
+
+    interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
+                              LTE_FDD_ENB_DEBUG_LEVEL_MAC,
+                              __FILE__,
+                              __LINE__,
+                              "Expecting UL HARQ retx (rv_idx=%u) for RNTI=%u TTI=%u",
+                              alloc->rv_idx,
+                              alloc->rnti,
+                              retx_tti);
+}
+void LTE_fdd_enb_mac::stop_ul_harq(LTE_FDD_ENB_UL_HARQ_PROC_STRUCT *proc)
+{
+    user_mgr->free_soft_buffer(proc->soft_buffer);
+    proc->soft_buffer = NULL;
+    proc->active      = false;
+}
+
 /*****************/
 /*    Helpers    */
 /*****************/
@@ -1558,9 +2019,10 @@ void LTE_fdd_enb_mac::advance_tti_and_clear_subframe()
     sched_dl_subfr[sched_cur_dl_subfn].N_sched_prbs           = 0;
     sched_dl_subfr[sched_cur_dl_subfn].next_prb               = 0;
     sched_ul_subfr[sched_cur_ul_subfn].decodes.N_ul_alloc     = 0;
+    sched_ul_subfr[sched_cur_ul_subfn].N_avail_prbs           = interface->get_n_rb_ul() - 2*get_n_pucch_prbs();
     sched_ul_subfr[sched_cur_ul_subfn].N_sched_prbs           = 0;
     sched_ul_subfr[sched_cur_ul_subfn].N_pucch                = 0;
-    sched_ul_subfr[sched_cur_ul_subfn].next_prb               = 0;
+    sched_ul_subfr[sched_cur_ul_subfn].next_prb               = get_n_pucch_prbs();
 
     // Advance the subframe numbers
     sched_cur_dl_subfn = (sched_cur_dl_subfn + 1) % 10;
@@ -1587,6 +2049,21 @@ uint32 LTE_fdd_enb_mac::get_n_reserved_prbs(uint32 current_tti)
 
     return N_reserved_prbs;
 }
+uint32 LTE_fdd_enb_mac::get_n_pucch_prbs()
+{
+    // PUCCH resource n uses PRB n in the first slot and PRB N_rb_ul-n-1
+    // in the second, so PUSCH must stay clear of the highest one in use
+    uint32 n_max = sys_info.sib2.radioResourceConfigCommon_Get().pucch_ConfigCommon_Get().n1PUCCH_AN_Value();
+
+    std::lock_guard<std::mutex> lock(ul_sr_sched_queue_mutex);
+    for(auto ul_sr : ul_sr_sched_queue)
+        if(ul_sr->n_1_p_pucch > n_max)
+            n_max = ul_sr->n_1_p_pucch;
+
+    if(2*(n_max + 1) > interface->get_n_rb_ul())
+        return interface->get_n_rb_ul()/2;
+    return n_max + 1;
+}
 bool LTE_fdd_enb_mac::scheduling_headroom(LTE_FDD_ENB_DL_SCHEDULE_MSG_STRUCT *dl_subfr,
                                           LTE_FDD_ENB_UL_SCHEDULE_MSG_STRUCT *ul_subfr,
                                           uint32                              N_dl_prbs,
@@ -1620,3 +2097,11 @@ LIBLTE_PHY_MODULATION_TYPE_ENUM LTE_fdd_enb_mac::get_modulation_type(uint8 mcs)
         return LIBLTE_PHY_MODULATION_TYPE_16QAM;
     return LIBLTE_PHY_MODULATION_TYPE_64QAM;
 }
+LIBLTE_PHY_MODULATION_TYPE_ENUM LTE_fdd_enb_mac::get_ul_modulation_type(uint8 mcs)
+{
+    if(mcs < 11 || mcs == 29)
+        return LIBLTE_PHY_MODULATION_TYPE_QPSK;
+    if(mcs < 21)
+        return LIBLTE_PHY_MODULATION_TYPE_16QAM;
+    return LIBLTE_PHY_MODULATION_TYPE_64QAM;
+}
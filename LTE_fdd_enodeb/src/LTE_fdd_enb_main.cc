@@ -38,6 +38,7 @@
 
 #include "LTE_fdd_enb_interface.h"
 #include "LTE_fdd_enb_hss.h"
+#include <unistd.h>
 
 /*******************************************************************************
                               DEFINES
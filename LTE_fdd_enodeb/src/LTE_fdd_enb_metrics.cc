@@ -0,0 +1,303 @@
+#line 2 "LTE_fdd_enb_metrics.cc" // Make __FILE__ omit the path
+/*******************************************************************************
+
+    Copyright 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************
+
+    File: LTE_fdd_enb_metrics.cc
+
+    Description: Contains all the implementations for the LTE FDD eNodeB
+                 pipeline stage latency metrics.
+
+    Revision History
+    ----------    -------------    --------------------------------------------
+    10/18/2026    agent            Created file.
+
+*******************************************************************************/
+
+/*******************************************************************************
+                              INCLUDES
+*******************************************************************************/
+
+#include "LTE_fdd_enb_metrics.h"
+#include <algorithm>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+/*******************************************************************************
+                              DEFINES
+*******************************************************************************/
+
+#define TICK_CALIBRATION_NS 10000000
+
+/*******************************************************************************
+                              TYPEDEFS
+*******************************************************************************/
+
+
+/*******************************************************************************
+                              GLOBAL VARIABLES
+*******************************************************************************/
+
+// Samples longer than this count as deadline misses, every stage but
+// a single code block has to fit in one TTI
+static const uint64 stage_deadline_ns[LTE_FDD_ENB_METRICS_STAGE_N_ITEMS] = {1000000,
+                                                                             1000000,
+                                                                             1000000,
+                                                                             250000,
+                                                                             1000000,
+                                                                             1000000};
+
+/*******************************************************************************
+                              LOCAL FUNCTIONS
+*******************************************************************************/
+
+static uint64 get_monotonic_ns()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64)ts.tv_sec*1000000000 + ts.tv_nsec;
+}
+
+// Highest value of the bucket holding the pct'th percentile sample
+static uint64 get_percentile(LTE_FDD_ENB_METRICS_FILE_STAGE_STRUCT *stage,
+                             float                                  pct)
+{
+    uint64 target = (uint64)(pct*stage->N_samples/100);
+    uint64 N      = 0;
+
+    for(uint32 i=0; i<LTE_FDD_ENB_METRICS_N_BUCKETS; i++)
+    {
+        N += stage->bucket[i];
+        if(N > target)
+            return std::min(LTE_fdd_enb_metrics::bucket_to_ns(i+1) - 1, stage->max_ns);
+    }
+
+    return stage->max_ns;
+}
+
+/*******************************************************************************
+                              CLASS IMPLEMENTATIONS
+*******************************************************************************/
+
+/********************************/
+/*    Constructor/Destructor    */
+/********************************/
+LTE_fdd_enb_metrics::LTE_fdd_enb_metrics() :
+    ns_per_tick{1}, enabled{false}, thread_run{true}
+{
+    calibrate_ticks();
+    reset();
+    thread = new std::thread(snapshot_thread, this);
+}
+LTE_fdd_enb_metrics::~LTE_fdd_enb_metrics()
+{
+    thread_run = false;
+    thread->join();
+    delete thread;
+}
+
+/****************/
+/*    Enable    */
+/****************/
+bool LTE_fdd_enb_metrics::get_enabled()
+{
+    return enabled;
+}
+void LTE_fdd_enb_metrics::set_enabled(bool enable)
+{
+    // Each enable starts from empty histograms
+    if(enable && !enabled)
+        reset();
+    enabled = enable;
+}
+
+/*****************/
+/*    Reports    */
+/*****************/
+std::string LTE_fdd_enb_metrics::get_report_string()
+{
+    LTE_FDD_ENB_METRICS_FILE_STAGE_STRUCT stage;
+    std::string                           output;
+    char                                  line[256];
+
+    output = std::to_string((uint32)LTE_FDD_ENB_METRICS_STAGE_N_ITEMS);
+    for(uint32 i=0; i<LTE_FDD_ENB_METRICS_STAGE_N_ITEMS; i++)
+    {
+        copy_stage(i, &stage);
+        snprintf(line,
+                 sizeof(line),
+                 "\n%s n=%llu mean=%.1fus p50=%.1fus p90=%.1fus p99=%.1fus p99.9=%.1fus max=%.1fus late=%llu (>%lluus)",
+                 stage.name,
+                 (unsigned long long)stage.N_samples,
+                 (0 == stage.N_samples) ? 0.0 : (double)stage.sum_ns/stage.N_samples/1000,
+                 get_percentile(&stage, 50)/1000.0,
+                 get_percentile(&stage, 90)/1000.0,
+                 get_percentile(&stage, 99)/1000.0,
+                 get_percentile(&stage, 99.9)/1000.0,
+                 stage.max_ns/1000.0,
+                 (unsigned long long)stage.N_misses,
+                 (unsigned long long)stage.deadline_ns/1000);
+        output += line;
+    }
+
+    return output;
+}
+
+/***************************/
+/*    Histogram Buckets    */
+/***************************/
+uint32 LTE_fdd_enb_metrics::ns_to_bucket(uint64 ns)
+{
+    const uint64 max_ns = (1ULL << LTE_FDD_ENB_METRICS_MAX_NS_BITS) - 1;
+
+    if(ns > max_ns)
+        ns = max_ns;
+    if(ns < (1 << LTE_FDD_ENB_METRICS_SUB_BUCKET_BITS))
+        return ns;
+
+    // Top SUB_BUCKET_BITS bits below the leading one pick the bucket
+    // within the power of 2
+    uint32 shift = 63 - __builtin_clzll(ns) - LTE_FDD_ENB_METRICS_SUB_BUCKET_BITS;
+    return(((shift + 1) << LTE_FDD_ENB_METRICS_SUB_BUCKET_BITS) +
+           ((ns >> shift) & ((1 << LTE_FDD_ENB_METRICS_SUB_BUCKET_BITS) - 1)));
+}
+uint64 LTE_fdd_enb_metrics::bucket_to_ns(uint32 bucket)
+{
+    if(bucket < (1 << LTE_FDD_ENB_METRICS_SUB_BUCKET_BITS))
+        return bucket;
+
+    uint32 shift = (bucket >> LTE_FDD_ENB_METRICS_SUB_BUCKET_BITS) - 1;
+    uint64 sub   = bucket & ((1 << LTE_FDD_ENB_METRICS_SUB_BUCKET_BITS) - 1);
+    return((1ULL << LTE_FDD_ENB_METRICS_SUB_BUCKET_BITS) + sub) << shift;
+}
+
+/*******************/
+/*    Recording    */
+/*******************/
+void LTE_fdd_enb_metrics::calibrate_ticks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    // The TSC is invariant on every CPU an eNodeB runs on, so a
+    // short measurement against the monotonic clock is enough
+    uint64 start_ns    = get_monotonic_ns();
+    uint64 start_ticks = get_ticks();
+    struct timespec ts = {0, TICK_CALIBRATION_NS};
+    nanosleep(&ts, NULL);
+    uint64 end_ns    = get_monotonic_ns();
+    uint64 end_ticks = get_ticks();
+    if(end_ticks > start_ticks)
+        ns_per_tick = (float)(end_ns - start_ns)/(end_ticks - start_ticks);
+#endif
+}
+void LTE_fdd_enb_metrics::record_ns(LTE_FDD_ENB_METRICS_STAGE_ENUM stage,
+                                    uint64                         ns)
+{
+    LTE_FDD_ENB_METRICS_HIST_STRUCT *h   = &hist[stage];
+    uint64                           max = h->max_ns.load(std::memory_order_relaxed);
+
+    h->bucket[ns_to_bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+    h->sum_ns.fetch_add(ns, std::memory_order_relaxed);
+    while(ns > max && !h->max_ns.compare_exchange_weak(max, ns, std::memory_order_relaxed));
+    if(ns > stage_deadline_ns[stage])
+        h->N_misses.fetch_add(1, std::memory_order_relaxed);
+}
+void LTE_fdd_enb_metrics::reset()
+{
+    for(uint32 i=0; i<LTE_FDD_ENB_METRICS_STAGE_N_ITEMS; i++)
+    {
+        hist[i].sum_ns.store(0, std::memory_order_relaxed);
+        hist[i].max_ns.store(0, std::memory_order_relaxed);
+        hist[i].N_misses.store(0, std::memory_order_relaxed);
+        for(uint32 j=0; j<LTE_FDD_ENB_METRICS_N_BUCKETS; j++)
+            hist[i].bucket[j].store(0, std::memory_order_relaxed);
+    }
+}
+
+/*************************/
+/*    Snapshot Thread    */
+/*************************/
+void LTE_fdd_enb_metrics::snapshot_thread(LTE_fdd_enb_metrics *metrics)
+{
+    uint64 next_ns = get_monotonic_ns();
+
+    while(metrics->thread_run)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if(get_monotonic_ns() < next_ns)
+            continue;
+        next_ns += (uint64)LTE_FDD_ENB_METRICS_SNAPSHOT_PERIOD_S*1000000000;
+        if(metrics->enabled)
+            metrics->write_snapshot();
+    }
+}
+void LTE_fdd_enb_metrics::write_snapshot()
+{
+    LTE_FDD_ENB_METRICS_FILE_HDR_STRUCT   hdr;
+    LTE_FDD_ENB_METRICS_FILE_STAGE_STRUCT stage;
+    struct timespec                       ts;
+    std::string                           tmp_name = std::string(LTE_FDD_ENB_METRICS_FILE_NAME) + ".tmp";
+    FILE                                 *file     = fopen(tmp_name.c_str(), "wb");
+    bool                                  ok;
+
+    if(NULL == file)
+        return;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    hdr.magic           = LTE_FDD_ENB_METRICS_FILE_MAGIC;
+    hdr.version         = LTE_FDD_ENB_METRICS_FILE_VERSION;
+    hdr.ts_us           = (uint64)ts.tv_sec*1000000 + ts.tv_nsec/1000;
+    hdr.N_stages        = LTE_FDD_ENB_METRICS_STAGE_N_ITEMS;
+    hdr.N_buckets       = LTE_FDD_ENB_METRICS_N_BUCKETS;
+    hdr.sub_bucket_bits = LTE_FDD_ENB_METRICS_SUB_BUCKET_BITS;
+    hdr.reserved        = 0;
+    ok                  = (1 == fwrite(&hdr, sizeof(hdr), 1, file));
+    for(uint32 i=0; i<LTE_FDD_ENB_METRICS_STAGE_N_ITEMS && ok; i++)
+    {
+        copy_stage(i, &stage);
+        ok = (1 == fwrite(&stage, sizeof(stage), 1, file));
+    }
+    if(0 != fclose(file))
+        ok = false;
+
+    // Readers only ever see a complete snapshot
+    if(ok)
+        rename(tmp_name.c_str(), LTE_FDD_ENB_METRICS_FILE_NAME);
+    else
+        remove(tmp_name.c_str());
+}
+void LTE_fdd_enb_metrics::copy_stage(uint32                                 stage,
+                                     LTE_FDD_ENB_METRICS_FILE_STAGE_STRUCT *copy)
+{
+    // Not atomic as a whole, a sample recorded during the copy may be
+    // counted in some fields and not others
+    memset(copy->name, 0, sizeof(copy->name));
+    strncpy(copy->name, LTE_fdd_enb_metrics_stage_text[stage], sizeof(copy->name) - 1);
+    copy->deadline_ns = stage_deadline_ns[stage];
+    copy->sum_ns      = hist[stage].sum_ns.load(std::memory_order_relaxed);
+    copy->max_ns      = hist[stage].max_ns.load(std::memory_order_relaxed);
+    copy->N_misses    = hist[stage].N_misses.load(std::memory_order_relaxed);
+    copy->N_samples   = 0;
+    for(uint32 i=0; i<LTE_FDD_ENB_METRICS_N_BUCKETS; i++)
+    {
+        copy->bucket[i]  = hist[stage].bucket[i].load(std::memory_order_relaxed);
+        copy->N_samples += copy->bucket[i];
+    }
+}
@@ -632,7 +632,7 @@ void LTE_fdd_enb_mme::parse_attach_request(LIBLTE_BYTE_MSG_STRUCT  *msg,
             if((*user)->get_eea_support(0) && (*user)->get_eia_support(2))
             {
                 (*rb)->set_mme_state(LTE_FDD_ENB_MME_STATE_AUTHENTICATE);
-                (*user)->set_id(hss->get_user_id_from_imsi(imsi_num));
+                user_mgr->set_user_id(*user, hss->get_user_id_from_imsi(imsi_num));
             }else{
                 (*user)->set_emm_cause(LIBLTE_MME_EMM_CAUSE_UE_SECURITY_CAPABILITIES_MISMATCH);
                 (*rb)->set_mme_state(LTE_FDD_ENB_MME_STATE_REJECT);
@@ -660,7 +660,7 @@ void LTE_fdd_enb_mme::parse_attach_request(LIBLTE_BYTE_MSG_STRUCT  *msg,
             if((*user)->get_eea_support(0) && (*user)->get_eia_support(2))
             {
                 (*rb)->set_mme_state(LTE_FDD_ENB_MME_STATE_AUTHENTICATE);
-                (*user)->set_id(hss->get_user_id_from_imei(imei_num));
+                user_mgr->set_user_id(*user, hss->get_user_id_from_imei(imei_num));
             }else{
                 (*user)->set_emm_cause(LIBLTE_MME_EMM_CAUSE_UE_SECURITY_CAPABILITIES_MISMATCH);
                 (*rb)->set_mme_state(LTE_FDD_ENB_MME_STATE_REJECT);
@@ -803,7 +803,7 @@ void LTE_fdd_enb_mme::parse_detach_request(LIBLTE_BYTE_MSG_STRUCT *msg,
     rb->set_mme_state(LTE_FDD_ENB_MME_STATE_SEND_DETACH_ACCEPT);
 
     // Delete the user
-    user->prepare_for_deletion();
+    user_mgr->prepare_user_for_deletion(user);
 }
 void LTE_fdd_enb_mme::parse_identity_response(LIBLTE_BYTE_MSG_STRUCT *msg,
                                               LTE_fdd_enb_user       *user,
@@ -846,7 +846,7 @@ void LTE_fdd_enb_mme::parse_identity_response(LIBLTE_BYTE_MSG_STRUCT *msg,
             if(user->get_eea_support(0) && user->get_eia_support(2))
             {
                 rb->set_mme_state(LTE_FDD_ENB_MME_STATE_AUTHENTICATE);
-                user->set_id(hss->get_user_id_from_imsi(imsi_num));
+                user_mgr->set_user_id(user, hss->get_user_id_from_imsi(imsi_num));
             }else{
                 user->set_emm_cause(LIBLTE_MME_EMM_CAUSE_UE_SECURITY_CAPABILITIES_MISMATCH);
                 rb->set_mme_state(LTE_FDD_ENB_MME_STATE_REJECT);
@@ -874,7 +874,7 @@ void LTE_fdd_enb_mme::parse_identity_response(LIBLTE_BYTE_MSG_STRUCT *msg,
             if(user->get_eea_support(0) && user->get_eia_support(2))
             {
                 rb->set_mme_state(LTE_FDD_ENB_MME_STATE_AUTHENTICATE);
-                user->set_id(hss->get_user_id_from_imei(imei_num));
+                user_mgr->set_user_id(user, hss->get_user_id_from_imei(imei_num));
             }else{
                 user->set_emm_cause(LIBLTE_MME_EMM_CAUSE_UE_SECURITY_CAPABILITIES_MISMATCH);
                 rb->set_mme_state(LTE_FDD_ENB_MME_STATE_REJECT);
@@ -1032,8 +1032,11 @@ void LTE_fdd_enb_mme::parse_service_request(LIBLTE_BYTE_MSG_STRUCT *msg,
             {
                 for(i=0; i<32; i++)
                 {
+                    auth_vec->k_enb[i]     = hss_auth_vec->k_enb[i];
                     auth_vec->k_rrc_enc[i] = hss_auth_vec->k_rrc_enc[i];
                     auth_vec->k_rrc_int[i] = hss_auth_vec->k_rrc_int[i];
+                    auth_vec->k_up_enc[i]  = hss_auth_vec->k_up_enc[i];
+                    auth_vec->k_up_int[i]  = hss_auth_vec->k_up_int[i];
                 }
             }
         }
@@ -1206,7 +1209,7 @@ void LTE_fdd_enb_mme::attach_sm(LTE_fdd_enb_user *user,
         send_identity_request(user, rb, LIBLTE_MME_ID_TYPE_2_IMSI);
         break;
     case LTE_FDD_ENB_MME_STATE_REJECT:
-        user->prepare_for_deletion();
+        user_mgr->prepare_user_for_deletion(user);
         send_attach_reject(user, rb);
         break;
     case LTE_FDD_ENB_MME_STATE_AUTHENTICATE:
@@ -1311,7 +1314,7 @@ void LTE_fdd_enb_mme::send_attach_accept(LTE_fdd_enb_user *user,
     uint32                                                             ip_addr;
 
     // Assign IP address to user
-    user->set_ip_addr(get_next_ip_addr());
+    user_mgr->set_user_ip_addr(user, get_next_ip_addr());
     ip_addr = user->get_ip_addr();
 
     act_def_eps_bearer_context_req.eps_bearer_id = user->get_eps_bearer_id();
@@ -1382,7 +1385,7 @@ void LTE_fdd_enb_mme::send_attach_accept(LTE_fdd_enb_user *user,
     attach_accept.additional_update_result_present    = false;
     attach_accept.t3412_ext_present                   = false;
     sys_info_mutex.unlock();
-    user->set_guti(&attach_accept.guti.guti);
+    user_mgr->set_user_guti(user, &attach_accept.guti.guti);
     liblte_mme_pack_attach_accept_msg(&attach_accept,
                                       LIBLTE_MME_SECURITY_HDR_TYPE_INTEGRITY_AND_CIPHERED,
                                       user->get_auth_vec()->k_nas_int,
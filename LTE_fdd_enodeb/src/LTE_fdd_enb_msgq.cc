@@ -50,7 +50,8 @@
 
 #include "LTE_fdd_enb_interface.h"
 #include "LTE_fdd_enb_msgq.h"
-#include <thread>
+#include <new>
+#include <stdlib.h>
 
 /*******************************************************************************
                               DEFINES
@@ -91,11 +92,20 @@ void LTE_fdd_enb_msgq_cb::operator()(LTE_FDD_ENB_MESSAGE_STRUCT &msg)
 /*    Constructor/Destructor    */
 /********************************/
 LTE_fdd_enb_msgq::LTE_fdd_enb_msgq(LTE_fdd_enb_interface *iface, std::string _msgq_name) :
-    interface{iface}, msgq_name{_msgq_name}, rx_setup{false}
+    interface{iface}, slot_head{0}, N_msgs{0}, msgq_name{_msgq_name}, rx_setup{false}
 {
     sem_init(&sync_sem, 0, 1);
     sem_init(&msg_sem, 0, 1);
-    circ_buf  = new boost::circular_buffer<LTE_FDD_ENB_MESSAGE_STRUCT>(100);
+
+    // Slots are only touched when used, so the huge pages are not reserved up front
+    slots = (LTE_FDD_ENB_MESSAGE_STRUCT *)interface->get_cpu()->alloc_buf(LTE_FDD_ENB_THREAD_ROLE_MSGQ,
+                                                                          LTE_FDD_ENB_MSGQ_N_SLOTS*sizeof(LTE_FDD_ENB_MESSAGE_STRUCT),
+                                                                          false);
+    slots_mapped = (NULL != slots);
+    if(!slots_mapped)
+        slots = (LTE_FDD_ENB_MESSAGE_STRUCT *)malloc(LTE_FDD_ENB_MSGQ_N_SLOTS*sizeof(LTE_FDD_ENB_MESSAGE_STRUCT));
+    if(NULL == slots)
+        throw std::bad_alloc();
 }
 LTE_fdd_enb_msgq::~LTE_fdd_enb_msgq()
 {
@@ -113,7 +123,10 @@ LTE_fdd_enb_msgq::~LTE_fdd_enb_msgq()
     }
     sem_destroy(&msg_sem);
     sem_destroy(&sync_sem);
-    delete circ_buf;
+    if(slots_mapped)
+        interface->get_cpu()->free_buf(slots, LTE_FDD_ENB_MSGQ_N_SLOTS*sizeof(LTE_FDD_ENB_MESSAGE_STRUCT));
+    else
+        free(slots);
 }
 
 /***************/
@@ -131,6 +144,11 @@ void LTE_fdd_enb_msgq::attach_rx(LTE_fdd_enb_msgq_cb cb,
 {
     callback = cb;
     prio     = _prio;
+
+    // Move the slots to the node of the role receive_thread runs as
+    interface->get_cpu()->place_buf((prio != 0) ? LTE_FDD_ENB_THREAD_ROLE_MAC : LTE_FDD_ENB_THREAD_ROLE_MSGQ,
+                                    slots,
+                                    LTE_FDD_ENB_MSGQ_N_SLOTS*sizeof(LTE_FDD_ENB_MESSAGE_STRUCT));
     pthread_create(&rx_thread, NULL, &receive_thread, this);
     rx_setup = true;
 }
@@ -143,17 +161,16 @@ void LTE_fdd_enb_msgq::send(LTE_FDD_ENB_MESSAGE_TYPE_ENUM  type,
                             LTE_FDD_ENB_MESSAGE_UNION     *msg_content,
                             uint32                         msg_content_size)
 {
-    LTE_FDD_ENB_MESSAGE_STRUCT msg;
+    LTE_FDD_ENB_MESSAGE_STRUCT *msg;
 
-    msg.type       = type;
-    msg.dest_layer = dest_layer;
+    sem_wait(&sync_sem);
+    msg             = get_free_slot();
+    msg->type       = type;
+    msg->dest_layer = dest_layer;
     if(msg_content != NULL)
     {
-        memcpy(&msg.msg, msg_content, msg_content_size);
+        memcpy(&msg->msg, msg_content, msg_content_size);
     }
-
-    sem_wait(&sync_sem);
-    circ_buf->push_back(msg);
     sem_post(&sync_sem);
     sem_post(&msg_sem);
 }
@@ -161,64 +178,61 @@ void LTE_fdd_enb_msgq::send(LTE_FDD_ENB_MESSAGE_TYPE_ENUM       type,
                             LTE_FDD_ENB_DL_SCHEDULE_MSG_STRUCT *dl_sched,
                             LTE_FDD_ENB_UL_SCHEDULE_MSG_STRUCT *ul_sched)
 {
-    LTE_FDD_ENB_MESSAGE_STRUCT msg;
-
-    msg.type       = type;
-    msg.dest_layer = LTE_FDD_ENB_DEST_LAYER_PHY;
-    memcpy(&msg.msg.phy_schedule.dl_sched, dl_sched, sizeof(LTE_FDD_ENB_DL_SCHEDULE_MSG_STRUCT));
-    memcpy(&msg.msg.phy_schedule.ul_sched, ul_sched, sizeof(LTE_FDD_ENB_UL_SCHEDULE_MSG_STRUCT));
+    LTE_FDD_ENB_MESSAGE_STRUCT *msg;
 
     sem_wait(&sync_sem);
-    circ_buf->push_back(msg);
+    msg             = get_free_slot();
+    msg->type       = type;
+    msg->dest_layer = LTE_FDD_ENB_DEST_LAYER_PHY;
+    memcpy(&msg->msg.phy_schedule.dl_sched, dl_sched, sizeof(LTE_FDD_ENB_DL_SCHEDULE_MSG_STRUCT));
+    memcpy(&msg->msg.phy_schedule.ul_sched, ul_sched, sizeof(LTE_FDD_ENB_UL_SCHEDULE_MSG_STRUCT));
     sem_post(&sync_sem);
     sem_post(&msg_sem);
 }
 void LTE_fdd_enb_msgq::send(LTE_FDD_ENB_MESSAGE_STRUCT &msg)
 {
     sem_wait(&sync_sem);
-    circ_buf->push_back(msg);
+    *get_free_slot() = msg;
     sem_post(&sync_sem);
     sem_post(&msg_sem);
 }
+LTE_FDD_ENB_MESSAGE_STRUCT* LTE_fdd_enb_msgq::get_free_slot()
+{
+    // When full the oldest message is dropped, as the circular buffer did
+    if(LTE_FDD_ENB_MSGQ_N_SLOTS == N_msgs)
+    {
+        slot_head = (slot_head + 1) % LTE_FDD_ENB_MSGQ_N_SLOTS;
+        N_msgs--;
+    }
+    uint32 idx      = (slot_head + N_msgs++) % LTE_FDD_ENB_MSGQ_N_SLOTS;
+    slot_start[idx] = interface->get_metrics()->start();
+    return &slots[idx];
+}
 void* LTE_fdd_enb_msgq::receive_thread(void *inputs)
 {
     LTE_fdd_enb_msgq           *msgq      = (LTE_fdd_enb_msgq *)inputs;
     LTE_FDD_ENB_MESSAGE_STRUCT  msg;
-    struct sched_param          priority;
-    cpu_set_t                   af_mask;
-    int                         sched_policy;
-    uint32                      num_cpus = std::thread::hardware_concurrency();
     bool                        not_done = true;
 
-    // Set priority
+    // The MAC queue is the only one with a priority
     if(msgq->prio != 0)
-    {
-        pthread_getschedparam(msgq->rx_thread, &sched_policy, &priority);
-        priority.sched_priority = sched_get_priority_max(SCHED_FIFO);
-        pthread_setschedparam(msgq->rx_thread, SCHED_FIFO, &priority);
-
-        // Set affinity to the second to the last core for MAC (last core is for PHY/Radio)
-        CPU_ZERO(&af_mask);
-        CPU_SET(num_cpus-2, &af_mask);
-        pthread_setaffinity_np(msgq->rx_thread, sizeof(af_mask), &af_mask);
-    }else{
-        // Set affinity to the third to the last core (last is for PHY/Radio, second to last is for MAC)
-        CPU_ZERO(&af_mask);
-        CPU_SET(num_cpus-3, &af_mask);
-        pthread_setaffinity_np(msgq->rx_thread, sizeof(af_mask), &af_mask);
-    }
+        msgq->interface->get_cpu()->place_thread(LTE_FDD_ENB_THREAD_ROLE_MAC, LTE_FDD_ENB_CPU_ALL_CORES);
+    else
+        msgq->interface->get_cpu()->place_thread(LTE_FDD_ENB_THREAD_ROLE_MSGQ, LTE_FDD_ENB_CPU_ALL_CORES);
 
     while(not_done)
     {
         // Wait for a message
         sem_wait(&msgq->msg_sem);
         sem_wait(&msgq->sync_sem);
-        if(msgq->circ_buf->size() != 0)
+        if(msgq->N_msgs != 0)
         {
-            while(msgq->circ_buf->size() != 0)
+            while(msgq->N_msgs != 0)
             {
-                msg = msgq->circ_buf->front();
-                msgq->circ_buf->pop_front();
+                msgq->interface->get_metrics()->record(LTE_FDD_ENB_METRICS_STAGE_MSGQ_WAIT, msgq->slot_start[msgq->slot_head]);
+                msg             = msgq->slots[msgq->slot_head];
+                msgq->slot_head = (msgq->slot_head + 1) % LTE_FDD_ENB_MSGQ_N_SLOTS;
+                msgq->N_msgs--;
                 sem_post(&msgq->sync_sem);
 
                 // Process message
@@ -0,0 +1,356 @@
+#line 2 "LTE_fdd_enb_pcap.cc" // Make __FILE__ omit the path
+/*******************************************************************************
+
+    Copyright 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************
+
+    File: LTE_fdd_enb_pcap.cc
+
+    Description: Contains all the implementations for the LTE FDD eNodeB
+                 pcap writer.
+
+    Revision History
+    ----------    -------------    --------------------------------------------
+    10/18/2026    agent            Created file.
+
+*******************************************************************************/
+
+/*******************************************************************************
+                              INCLUDES
+*******************************************************************************/
+
+#include "LTE_fdd_enb_pcap.h"
+#include "LTE_fdd_enb_interface.h"
+#include <arpa/inet.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <algorithm>
+#include <set>
+
+/*******************************************************************************
+                              DEFINES
+*******************************************************************************/
+
+
+/*******************************************************************************
+                              TYPEDEFS
+*******************************************************************************/
+
+// Ring of the calling thread for one pcap writer, writers are told
+// apart by id so a stale entry never matches a new writer
+typedef struct{
+    uint32                 id;
+    LTE_fdd_enb_pcap_ring *ring;
+}LTE_FDD_ENB_PCAP_THREAD_RING_STRUCT;
+
+// Rings of the calling thread, marked closed when the thread exits so
+// the background thread of each live writer frees them once drained
+class LTE_fdd_enb_pcap_thread_rings
+{
+public:
+    ~LTE_fdd_enb_pcap_thread_rings();
+
+    std::vector<LTE_FDD_ENB_PCAP_THREAD_RING_STRUCT> rings;
+};
+
+/*******************************************************************************
+                              GLOBAL VARIABLES
+*******************************************************************************/
+
+static std::atomic<uint32>                        next_pcap_id{1};
+static std::mutex                                 live_pcap_mutex;
+static std::set<uint32>                           live_pcap_ids;
+static thread_local LTE_fdd_enb_pcap_thread_rings thread_rings;
+
+/*******************************************************************************
+                              CLASS IMPLEMENTATIONS
+*******************************************************************************/
+
+LTE_fdd_enb_pcap_thread_rings::~LTE_fdd_enb_pcap_thread_rings()
+{
+    std::lock_guard<std::mutex> lock(live_pcap_mutex);
+
+    // Rings of a writer that is gone were freed with it
+    for(auto &thread_ring : rings)
+        if(live_pcap_ids.end() != live_pcap_ids.find(thread_ring.id))
+            thread_ring.ring->close();
+}
+
+/********************************/
+/*    Constructor/Destructor    */
+/********************************/
+LTE_fdd_enb_pcap::LTE_fdd_enb_pcap(LTE_fdd_enb_interface *iface,
+                                   std::string            _file_name,
+                                   uint32                 _dlt) :
+    id{next_pcap_id++}, file_name{_file_name}, file_size{0}, file_open_time{0},
+    dlt{_dlt}, fd{-1}, interface{iface}, thread_run{true}
+{
+    live_pcap_mutex.lock();
+    live_pcap_ids.insert(id);
+    live_pcap_mutex.unlock();
+
+    open_file();
+    thread = new std::thread(write_thread, this);
+}
+LTE_fdd_enb_pcap::~LTE_fdd_enb_pcap()
+{
+    live_pcap_mutex.lock();
+    live_pcap_ids.erase(id);
+    live_pcap_mutex.unlock();
+
+    thread_run = false;
+    thread->join();
+    delete thread;
+
+    if(-1 != fd)
+        close(fd);
+    std::lock_guard<std::mutex> lock(ring_mutex);
+    for(auto ring : rings)
+        delete ring;
+}
+
+/*****************/
+/*    Records    */
+/*****************/
+uint8* LTE_fdd_enb_pcap::start_record(uint32 N_bytes)
+{
+    LTE_fdd_enb_pcap_ring          *ring = get_thread_ring();
+    LTE_FDD_ENB_PCAP_RECORD_STRUCT *rec;
+    struct timespec                 ts;
+    uint32                          len  = LTE_FDD_ENB_PCAP_RECORD_HDR_SIZE + N_bytes;
+    uint32                          tmp;
+
+    rec = (LTE_FDD_ENB_PCAP_RECORD_STRUCT *)ring->reserve(sizeof(LTE_FDD_ENB_PCAP_RECORD_STRUCT) + len);
+    if(NULL == rec)
+        return NULL;
+
+    // Ring header
+    clock_gettime(CLOCK_REALTIME, &ts);
+    rec->ts_us = (uint64)ts.tv_sec*1000000 + ts.tv_nsec/1000;
+    rec->len   = len;
+
+    // Pcap record header
+    uint8 *hdr = (uint8 *)(rec + 1);
+    tmp = htonl(ts.tv_sec);
+    memcpy(&hdr[0], &tmp, sizeof(uint32));
+    tmp = htonl(ts.tv_nsec/1000);
+    memcpy(&hdr[4], &tmp, sizeof(uint32));
+    tmp = htonl(N_bytes);
+    memcpy(&hdr[8], &tmp, sizeof(uint32));
+    memcpy(&hdr[12], &tmp, sizeof(uint32));
+
+    return &hdr[LTE_FDD_ENB_PCAP_RECORD_HDR_SIZE];
+}
+void LTE_fdd_enb_pcap::end_record()
+{
+    get_thread_ring()->commit();
+}
+
+/***************/
+/*    Rings    */
+/***************/
+LTE_fdd_enb_pcap_ring* LTE_fdd_enb_pcap::get_thread_ring()
+{
+    for(auto &thread_ring : thread_rings.rings)
+        if(id == thread_ring.id)
+            return thread_ring.ring;
+
+    // First record from this thread
+    LTE_fdd_enb_pcap_ring *ring = new LTE_fdd_enb_pcap_ring;
+
+    std::lock_guard<std::mutex> lock(ring_mutex);
+    rings.push_back(ring);
+    thread_rings.rings.push_back({id, ring});
+
+    return ring;
+}
+
+/**************/
+/*    File    */
+/**************/
+void LTE_fdd_enb_pcap::open_file()
+{
+    uint32 hdr_u32[6];
+    uint16 hdr_u16[2];
+    uint8  hdr[24];
+
+    fd = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(-1 == fd)
+        return;
+
+    // Global header, magic number, version 2.4, timezone, sigfigs,
+    // snap length and link type
+    hdr_u32[0] = htonl(0xa1b2c3d4);
+    hdr_u16[0] = htons(2);
+    hdr_u16[1] = htons(4);
+    hdr_u32[1] = htonl(0);
+    hdr_u32[2] = htonl(0);
+    hdr_u32[3] = htonl(0xFFFF);
+    hdr_u32[4] = htonl(dlt);
+    memcpy(&hdr[0],  &hdr_u32[0], sizeof(uint32));
+    memcpy(&hdr[4],  &hdr_u16[0], sizeof(uint16));
+    memcpy(&hdr[6],  &hdr_u16[1], sizeof(uint16));
+    memcpy(&hdr[8],  &hdr_u32[1], sizeof(uint32));
+    memcpy(&hdr[12], &hdr_u32[2], sizeof(uint32));
+    memcpy(&hdr[16], &hdr_u32[3], sizeof(uint32));
+    memcpy(&hdr[20], &hdr_u32[4], sizeof(uint32));
+    if(sizeof(hdr) != write(fd, hdr, sizeof(hdr)))
+    {
+        close(fd);
+        fd = -1;
+        return;
+    }
+
+    file_size      = sizeof(hdr);
+    file_open_time = time(NULL);
+}
+void LTE_fdd_enb_pcap::rotate_file()
+{
+    if(-1 != fd)
+        close(fd);
+
+    for(uint32 i=LTE_FDD_ENB_PCAP_N_OLD_FILES; i>1; i--)
+        rename((file_name + "." + std::to_string(i-1)).c_str(),
+               (file_name + "." + std::to_string(i)).c_str());
+    if(0 < LTE_FDD_ENB_PCAP_N_OLD_FILES)
+        rename(file_name.c_str(), (file_name + ".1").c_str());
+
+    open_file();
+}
+
+/***************************/
+/*    Background Thread    */
+/***************************/
+void LTE_fdd_enb_pcap::write_thread(LTE_fdd_enb_pcap *pcap)
+{
+    while(pcap->thread_run)
+    {
+        if(!pcap->drain())
+            std::this_thread::sleep_for(std::chrono::microseconds(LTE_FDD_ENB_PCAP_IDLE_SLEEP_US));
+    }
+    while(pcap->drain());
+}
+bool LTE_fdd_enb_pcap::drain()
+{
+    struct iovec iov[LTE_FDD_ENB_PCAP_MAX_BATCH];
+    uint32       N_iov = 0;
+    uint64       N_bytes = 0;
+
+    // Rings are only freed by this thread, so the list can be walked
+    // without the lock once copied
+    ring_mutex.lock();
+    std::vector<LTE_fdd_enb_pcap_ring *> cur_rings(rings);
+    ring_mutex.unlock();
+
+    // Merge the rings in time order, pointing straight at the records
+    std::vector<uint64> pos(cur_rings.size());
+    std::vector<uint64> end(cur_rings.size());
+    for(uint32 i=0; i<cur_rings.size(); i++)
+    {
+        pos[i] = cur_rings[i]->get_read_pos();
+        end[i] = cur_rings[i]->get_write_pos();
+    }
+    while(N_iov < LTE_FDD_ENB_PCAP_MAX_BATCH)
+    {
+        LTE_FDD_ENB_PCAP_RECORD_STRUCT *next_rec  = NULL;
+        uint32                          next_idx  = 0;
+        uint32                          next_size = 0;
+        for(uint32 i=0; i<cur_rings.size(); i++)
+        {
+            uint32                          size;
+            LTE_FDD_ENB_PCAP_RECORD_STRUCT *rec = (LTE_FDD_ENB_PCAP_RECORD_STRUCT *)cur_rings[i]->peek(pos[i], end[i], &size);
+            if(NULL != rec &&
+               (NULL == next_rec || rec->ts_us < next_rec->ts_us))
+            {
+                next_rec  = rec;
+                next_idx  = i;
+                next_size = size;
+            }
+        }
+        if(NULL == next_rec)
+            break;
+        iov[N_iov].iov_base  = next_rec + 1;
+        iov[N_iov].iov_len   = next_rec->len;
+        N_bytes             += next_rec->len;
+        N_iov++;
+        pos[next_idx] += next_size;
+    }
+
+    // Write the batch, continuing after partial writes
+    struct iovec *cur_iov   = iov;
+    uint32        N_cur_iov = N_iov;
+    while(-1 != fd && 0 < N_cur_iov)
+    {
+        ssize_t N_written = writev(fd, cur_iov, N_cur_iov);
+        if(0 > N_written)
+        {
+            if(EINTR == errno)
+                continue;
+            break;
+        }
+        file_size += N_written;
+        while(0 < N_cur_iov && (size_t)N_written >= cur_iov->iov_len)
+        {
+            N_written -= cur_iov->iov_len;
+            cur_iov++;
+            N_cur_iov--;
+        }
+        if(0 < N_cur_iov)
+        {
+            cur_iov->iov_base  = (uint8 *)cur_iov->iov_base + N_written;
+            cur_iov->iov_len  -= N_written;
+        }
+    }
+
+    // Release the space, report drops and free the rings of exited
+    // threads
+    for(uint32 i=0; i<cur_rings.size(); i++)
+    {
+        LTE_fdd_enb_pcap_ring *ring      = cur_rings[i];
+        uint64                 N_dropped = ring->get_N_new_dropped();
+        ring->release(pos[i]);
+        if(0 != N_dropped)
+        {
+            interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_WARNING,
+                                      LTE_FDD_ENB_DEBUG_LEVEL_IFACE,
+                                      __FILE__,
+                                      __LINE__,
+                                      "Dropped %llu pcap records for %s",
+                                      N_dropped,
+                                      file_name.c_str());
+        }
+        if(ring->is_closed_and_drained())
+        {
+            ring_mutex.lock();
+            rings.erase(std::find(rings.begin(), rings.end(), ring));
+            ring_mutex.unlock();
+            delete ring;
+        }
+    }
+
+    if(0 != N_iov &&
+       (LTE_FDD_ENB_PCAP_MAX_FILE_SIZE     <= file_size ||
+        LTE_FDD_ENB_PCAP_MAX_FILE_DURATION <= time(NULL) - file_open_time))
+        rotate_file();
+
+    return(0 != N_bytes);
+}
@@ -240,9 +240,11 @@ void LTE_fdd_enb_pdcp::handle_pdu_ready(LTE_FDD_ENB_PDCP_PDU_READY_MSG_STRUCT *p
     LTE_FDD_ENB_GW_DATA_READY_MSG_STRUCT      gw_data_ready;
     LIBLTE_PDCP_CONTROL_PDU_STRUCT            contents;
     LIBLTE_PDCP_DATA_PDU_WITH_LONG_SN_STRUCT  data_contents;
+    LIBLTE_PDCP_SECURITY_CONFIG_STRUCT        sec;
     LIBLTE_BYTE_MSG_STRUCT                   *pdu;
     LIBLTE_BIT_MSG_STRUCT                     rrc_pdu;
     uint8                                    *pdu_ptr;
+    uint32                                    count;
     uint32                                    i;
 
     if(LTE_FDD_ENB_ERROR_NONE != pdu_ready->rb->get_next_pdcp_pdu(&pdu))
@@ -257,8 +259,6 @@ void LTE_fdd_enb_pdcp::handle_pdu_ready(LTE_FDD_ENB_PDCP_PDU_READY_MSG_STRUCT *p
                               pdu_ready->user->get_c_rnti(),
                               LTE_fdd_enb_rb_text[pdu_ready->rb->get_rb_id()]);
 
-    // FIXME: Add SN and integrity verification
-
     if(LTE_FDD_ENB_RB_SRB0 == pdu_ready->rb->get_rb_id())
     {
         // Convert to bit struct for RRC
@@ -269,14 +269,67 @@ void LTE_fdd_enb_pdcp::handle_pdu_ready(LTE_FDD_ENB_PDCP_PDU_READY_MSG_STRUCT *p
 
         // Send the SDU to RRC
         send_rrc_pdu_ready(pdu_ready->user, pdu_ready->rb, &rrc_pdu);
-    }else if(LTE_FDD_ENB_RB_SRB1 == pdu_ready->rb->get_rb_id() ||
-             LTE_FDD_ENB_RB_SRB2 == pdu_ready->rb->get_rb_id()){
-        liblte_pdcp_unpack_control_pdu(pdu, &contents);
+    }else if((LTE_FDD_ENB_RB_SRB1 == pdu_ready->rb->get_rb_id() ||
+              LTE_FDD_ENB_RB_SRB2 == pdu_ready->rb->get_rb_id()) &&
+             pdu->N_bytes >= 5){
+        count = get_rx_count(pdu_ready->rb, pdu->msg[0] & 0x1F, 5);
+        if(LTE_FDD_ENB_PDCP_CONFIG_SECURITY == pdu_ready->rb->get_pdcp_config())
+        {
+            get_security_config(pdu_ready->user,
+                                pdu_ready->rb,
+                                pdu_ready->rb->get_pdcp_ul_ciphering(),
+                                &sec);
+            if(LIBLTE_SUCCESS != liblte_pdcp_unpack_control_pdu(pdu,
+                                                                &sec,
+                                                                count,
+                                                                LIBLTE_SECURITY_DIRECTION_UPLINK,
+                                                                get_bearer(pdu_ready->rb),
+                                                                &contents))
+            {
+                interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ERROR,
+                                          LTE_FDD_ENB_DEBUG_LEVEL_PDCP,
+                                          __FILE__,
+                                          __LINE__,
+                                          "Integrity verification failed for RNTI=%u, RB=%s, COUNT=%u",
+                                          pdu_ready->user->get_c_rnti(),
+                                          LTE_fdd_enb_rb_text[pdu_ready->rb->get_rb_id()],
+                                          count);
+                pdu_ready->rb->delete_next_pdcp_pdu();
+                return;
+            }
+        }else{
+            liblte_pdcp_unpack_control_pdu(pdu, &contents);
+        }
+        pdu_ready->rb->set_pdcp_rx_count(count + 1);
 
         // Send the SDU to RRC
         send_rrc_pdu_ready(pdu_ready->user, pdu_ready->rb, &contents.data);
-    }else if(LTE_FDD_ENB_RB_DRB1 == pdu_ready->rb->get_rb_id()){
-        liblte_pdcp_unpack_data_pdu_with_long_sn(pdu, &data_contents);
+    }else if(LTE_FDD_ENB_RB_DRB1 == pdu_ready->rb->get_rb_id() &&
+             pdu->N_bytes >= 2){
+        count = get_rx_count(pdu_ready->rb, ((pdu->msg[0] & 0x0F) << 8) | pdu->msg[1], 12);
+        get_security_config(pdu_ready->user,
+                            pdu_ready->rb,
+                            pdu_ready->rb->get_pdcp_ul_ciphering(),
+                            &sec);
+        if(LIBLTE_SUCCESS != liblte_pdcp_unpack_data_pdu_with_long_sn(pdu,
+                                                                      &sec,
+                                                                      count,
+                                                                      LIBLTE_SECURITY_DIRECTION_UPLINK,
+                                                                      get_bearer(pdu_ready->rb),
+                                                                      &data_contents))
+        {
+            interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ERROR,
+                                      LTE_FDD_ENB_DEBUG_LEVEL_PDCP,
+                                      __FILE__,
+                                      __LINE__,
+                                      pdu,
+                                      "Received non-data PDU for RNTI=%u and RB=%s",
+                                      pdu_ready->user->get_c_rnti(),
+                                      LTE_fdd_enb_rb_text[pdu_ready->rb->get_rb_id()]);
+            pdu_ready->rb->delete_next_pdcp_pdu();
+            return;
+        }
+        pdu_ready->rb->set_pdcp_rx_count(count + 1);
 
         // Queue the SDU for GW
         pdu_ready->rb->queue_gw_data_msg(&data_contents.data);
@@ -308,11 +361,12 @@ void LTE_fdd_enb_pdcp::handle_pdu_ready(LTE_FDD_ENB_PDCP_PDU_READY_MSG_STRUCT *p
 /******************************/
 void LTE_fdd_enb_pdcp::handle_sdu_ready(LTE_FDD_ENB_PDCP_SDU_READY_MSG_STRUCT *sdu_ready)
 {
-    LIBLTE_PDCP_CONTROL_PDU_STRUCT  contents;
-    LIBLTE_BYTE_MSG_STRUCT          pdu;
-    LIBLTE_BIT_MSG_STRUCT          *sdu;
-    uint8                          *sdu_ptr;
-    uint32                          i;
+    LIBLTE_PDCP_CONTROL_PDU_STRUCT      contents;
+    LIBLTE_PDCP_SECURITY_CONFIG_STRUCT  sec;
+    LIBLTE_BYTE_MSG_STRUCT              pdu;
+    LIBLTE_BIT_MSG_STRUCT              *sdu;
+    uint8                              *sdu_ptr;
+    uint32                              i;
 
     if(LTE_FDD_ENB_ERROR_NONE != sdu_ready->rb->get_next_pdcp_sdu(&sdu))
     {
@@ -351,15 +405,23 @@ void LTE_fdd_enb_pdcp::handle_sdu_ready(LTE_FDD_ENB_PDCP_SDU_READY_MSG_STRUCT *s
         send_rlc_sdu_ready(sdu_ready->user, sdu_ready->rb, &pdu);
     }else if(LTE_FDD_ENB_RB_SRB1 == sdu_ready->rb->get_rb_id() ||
              LTE_FDD_ENB_RB_SRB2 == sdu_ready->rb->get_rb_id()){
+        // The Security Mode Command is the first integrity protected SDU
+        if(sdu_ready->activate_security)
+            sdu_ready->rb->set_pdcp_config(LTE_FDD_ENB_PDCP_CONFIG_SECURITY);
+
         // Pack the control PDU
         contents.count = sdu_ready->rb->get_pdcp_tx_count();
         if(LTE_FDD_ENB_PDCP_CONFIG_SECURITY == sdu_ready->rb->get_pdcp_config())
         {
+            get_security_config(sdu_ready->user,
+                                sdu_ready->rb,
+                                sdu_ready->rb->get_pdcp_dl_ciphering(),
+                                &sec);
             liblte_pdcp_pack_control_pdu(&contents,
                                          sdu,
-                                         sdu_ready->user->get_auth_vec()->k_rrc_int,
+                                         &sec,
                                          LIBLTE_SECURITY_DIRECTION_DOWNLINK,
-                                         sdu_ready->rb->get_rb_id()-1,
+                                         get_bearer(sdu_ready->rb),
                                          &pdu);
         }else{
             liblte_pdcp_pack_control_pdu(&contents,
@@ -370,6 +432,10 @@ void LTE_fdd_enb_pdcp::handle_sdu_ready(LTE_FDD_ENB_PDCP_SDU_READY_MSG_STRUCT *s
         // Increment the SN
         sdu_ready->rb->set_pdcp_tx_count(contents.count + 1);
 
+        // Downlink ciphering starts after the Security Mode Command
+        if(sdu_ready->activate_security)
+            sdu_ready->rb->set_pdcp_dl_ciphering(true);
+
         send_rlc_sdu_ready(sdu_ready->user, sdu_ready->rb, &pdu);
     }else{
         interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ERROR,
@@ -392,51 +458,129 @@ void LTE_fdd_enb_pdcp::handle_sdu_ready(LTE_FDD_ENB_PDCP_SDU_READY_MSG_STRUCT *s
 void LTE_fdd_enb_pdcp::handle_data_sdu_ready(LTE_FDD_ENB_PDCP_DATA_SDU_READY_MSG_STRUCT *data_sdu_ready)
 {
     LIBLTE_PDCP_DATA_PDU_WITH_LONG_SN_STRUCT  contents;
-    LIBLTE_BYTE_MSG_STRUCT                    pdu;
+    LIBLTE_PDCP_SECURITY_CONFIG_STRUCT        sec;
     LIBLTE_BYTE_MSG_STRUCT                   *sdu;
+    LTE_fdd_enb_rb                           *rb = data_sdu_ready->rb;
+    uint32                                    N_pdus;
+    uint32                                    i;
+    bool                                      not_done = true;
 
-    if(LTE_FDD_ENB_ERROR_NONE != data_sdu_ready->rb->get_next_pdcp_data_sdu(&sdu))
+    if(rb->get_rb_id()       <  LTE_FDD_ENB_RB_DRB1 ||
+       rb->get_pdcp_config() != LTE_FDD_ENB_PDCP_CONFIG_LONG_SN)
     {
         interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ERROR,
                                   LTE_FDD_ENB_DEBUG_LEVEL_PDCP,
                                   __FILE__,
                                   __LINE__,
-                                  "Received data SDU ready from GW with no data, RNTI=%u, RB=%s",
-                                  data_sdu_ready->user->get_c_rnti(),
-                                  LTE_fdd_enb_rb_text[data_sdu_ready->rb->get_rb_id()]);
+                                  "Received data SDU from GW for invalid RB=%s, RNTI=%u",
+                                  LTE_fdd_enb_rb_text[rb->get_rb_id()],
+                                  data_sdu_ready->user->get_c_rnti());
+        rb->delete_next_pdcp_data_sdu();
         return;
     }
 
-    interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
-                              LTE_FDD_ENB_DEBUG_LEVEL_PDCP,
-                              __FILE__,
-                              __LINE__,
-                              sdu,
-                              "Received data SDU from GW for RNTI=%u and RB=%s",
-                              data_sdu_ready->user->get_c_rnti(),
-                              LTE_fdd_enb_rb_text[data_sdu_ready->rb->get_rb_id()]);
-
-    if(data_sdu_ready->rb->get_rb_id()       >= LTE_FDD_ENB_RB_DRB1 &&
-       data_sdu_ready->rb->get_pdcp_config() == LTE_FDD_ENB_PDCP_CONFIG_LONG_SN)
+    // Drain every queued SDU, ciphering LTE_FDD_ENB_PDCP_MAX_CIPHER_BATCH
+    // at a time, the notifications for SDUs drained here find the queue
+    // empty and are ignored
+    while(not_done)
     {
-        // Pack the data PDU
-        contents.count = data_sdu_ready->rb->get_pdcp_tx_count();
-        liblte_pdcp_pack_data_pdu_with_long_sn(&contents, sdu, &pdu);
+        N_pdus = 0;
+        while(N_pdus < LTE_FDD_ENB_PDCP_MAX_CIPHER_BATCH &&
+              LTE_FDD_ENB_ERROR_NONE == rb->get_next_pdcp_data_sdu(&sdu))
+        {
+            interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
+                                      LTE_FDD_ENB_DEBUG_LEVEL_PDCP,
+                                      __FILE__,
+                                      __LINE__,
+                                      sdu,
+                                      "Received data SDU from GW for RNTI=%u and RB=%s",
+                                      data_sdu_ready->user->get_c_rnti(),
+                                      LTE_fdd_enb_rb_text[rb->get_rb_id()]);
+
+            // Pack the data PDU
+            contents.count = rb->get_pdcp_tx_count();
+            liblte_pdcp_pack_data_pdu_with_long_sn(&contents, sdu, &cipher_batch_pdu[N_pdus]);
+            cipher_batch_job[N_pdus].msg       = &cipher_batch_pdu[N_pdus].msg[2];
+            cipher_batch_job[N_pdus].out       = &cipher_batch_pdu[N_pdus].msg[2];
+            cipher_batch_job[N_pdus].msg_len   = cipher_batch_pdu[N_pdus].N_bytes - 2;
+            cipher_batch_job[N_pdus].count     = contents.count;
+            cipher_batch_job[N_pdus].bearer    = get_bearer(rb);
+            cipher_batch_job[N_pdus].direction = LIBLTE_SECURITY_DIRECTION_DOWNLINK;
+            N_pdus++;
+
+            // Increment the SN
+            rb->set_pdcp_tx_count(contents.count + 1);
+
+            // Delete the SDU
+            rb->delete_next_pdcp_data_sdu();
+        }
 
-        // Increment the SN
-        data_sdu_ready->rb->set_pdcp_tx_count(contents.count + 1);
+        if(0 == N_pdus)
+            return;
+
+        // Cipher the batch
+        if(rb->get_pdcp_dl_ciphering())
+        {
+            get_security_config(data_sdu_ready->user, rb, true, &sec);
+            if(LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_EEA0 != sec.eea)
+                liblte_security_encryption_batch(sec.eea,
+                                                 &sec.k_enc[16],
+                                                 cipher_batch_job,
+                                                 N_pdus);
+        }
 
-        send_rlc_sdu_ready(data_sdu_ready->user, data_sdu_ready->rb, &pdu);
+        for(i=0; i<N_pdus; i++)
+            send_rlc_sdu_ready(data_sdu_ready->user, rb, &cipher_batch_pdu[i]);
+
+        // A short batch emptied the queue
+        not_done = (LTE_FDD_ENB_PDCP_MAX_CIPHER_BATCH == N_pdus);
+    }
+}
+
+/******************/
+/*    Security    */
+/******************/
+void LTE_fdd_enb_pdcp::get_security_config(LTE_fdd_enb_user                   *user,
+                                           LTE_fdd_enb_rb                     *rb,
+                                           bool                                ciphering,
+                                           LIBLTE_PDCP_SECURITY_CONFIG_STRUCT *sec)
+{
+    LTE_FDD_ENB_AUTHENTICATION_VECTOR_STRUCT *auth_vec = user->get_auth_vec();
+
+    if(LTE_FDD_ENB_RB_SRB1 == rb->get_rb_id() ||
+       LTE_FDD_ENB_RB_SRB2 == rb->get_rb_id())
+    {
+        sec->k_int = auth_vec->k_rrc_int;
+        sec->k_enc = auth_vec->k_rrc_enc;
     }else{
-        interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ERROR,
-                                  LTE_FDD_ENB_DEBUG_LEVEL_PDCP,
-                                  __FILE__,
-                                  __LINE__,
-                                  "Received data SDU from GW for invalid RB=%s, RNTI=%u",
-                                  LTE_fdd_enb_rb_text[data_sdu_ready->rb->get_rb_id()],
-                                  data_sdu_ready->user->get_c_rnti());
+        sec->k_int = NULL;
+        sec->k_enc = auth_vec->k_up_enc;
+    }
+    sec->eia = auth_vec->eia;
+    if(ciphering)
+    {
+        sec->eea = auth_vec->eea;
+    }else{
+        sec->eea = LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_EEA0;
     }
+}
+uint8 LTE_fdd_enb_pdcp::get_bearer(LTE_fdd_enb_rb *rb)
+{
+    // BEARER is the RB identity minus one, 36.323 section 5.6
+    if(rb->get_rb_id() >= LTE_FDD_ENB_RB_DRB1)
+        return rb->get_drb_id() - 1;
+    return rb->get_rb_id() - 1;
+}
+uint32 LTE_fdd_enb_pdcp::get_rx_count(LTE_fdd_enb_rb *rb,
+                                      uint32          sn,
+                                      uint32          sn_len)
+{
+    uint32 next_count = rb->get_pdcp_rx_count();
+    uint32 hfn        = next_count >> sn_len;
 
-    // Delete the SDU
-    data_sdu_ready->rb->delete_next_pdcp_data_sdu();
+    // A SN below the next expected one means the SN wrapped
+    if(sn < (next_count & ((1 << sn_len) - 1)))
+        hfn++;
+
+    return (hfn << sn_len) | sn;
 }
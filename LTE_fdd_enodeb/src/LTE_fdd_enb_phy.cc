@@ -121,9 +121,15 @@ void LTE_fdd_enb_phy::start(LTE_fdd_enb_msgq      *from_mac,
                     interface->get_n_rb_dl(),
                     interface->get_n_sc_rb_dl(),
                     sys_info.mib.phich_Config_Get().phich_Resource_Value());
+
+    // liblte allocates the PHY struct, move it next to the radio thread
+    interface->get_cpu()->place_buf(LTE_FDD_ENB_THREAD_ROLE_RADIO, phy_struct, sizeof(LIBLTE_PHY_STRUCT));
+
     liblte_phy_ul_init(phy_struct,
                        interface->get_n_id_cell(),
                        sys_info.sib2.radioResourceConfigCommon_Get());
+    phy_struct->turbo_decode_hook     = &turbo_decode_hook;
+    phy_struct->turbo_decode_hook_obj = this;
 
     // Downlink
     for(uint32 i=0; i<10; i++)
@@ -245,6 +251,7 @@ void LTE_fdd_enb_phy::stop()
 
     if(NULL != msgq_to_ue)
         delete msgq_to_ue;
+    msgq_to_ue = NULL;
 
     liblte_phy_ul_cleanup(phy_struct);
     liblte_phy_cleanup(phy_struct);
@@ -342,16 +349,23 @@ void LTE_fdd_enb_phy::handle_ue_msg(LIBTOOLS_IPC_MSGQ_MESSAGE_STRUCT *msg)
 void LTE_fdd_enb_phy::radio_interface(LTE_FDD_ENB_RADIO_TX_BUF_STRUCT *tx_buf,
                                       LTE_FDD_ENB_RADIO_RX_BUF_STRUCT *rx_buf)
 {
+    LTE_fdd_enb_metrics *metrics = interface->get_metrics();
+
     if(!started)
         return;
 
     // Once started, this routine gets called every millisecond (except the first) to:
     //     1) align TTIs
+    uint64 tti_start = metrics->start();
     align_ttis_with_radio(rx_buf->current_tti);
     //     2) process the new uplink subframe
+    uint64 ul_start = metrics->start();
     process_ul(rx_buf);
     //     3) generate the next downlink subframe
+    uint64 dl_start = metrics->record(LTE_FDD_ENB_METRICS_STAGE_PHY_UL, ul_start);
     process_dl(tx_buf);
+    metrics->record(LTE_FDD_ENB_METRICS_STAGE_PHY_DL, dl_start);
+    metrics->record(LTE_FDD_ENB_METRICS_STAGE_PHY_TTI, tti_start);
 }
 void LTE_fdd_enb_phy::radio_interface(LTE_FDD_ENB_RADIO_TX_BUF_STRUCT *tx_buf)
 {
@@ -574,9 +588,7 @@ void LTE_fdd_enb_phy::process_dl(LTE_FDD_ENB_RADIO_TX_BUF_STRUCT *tx_buf)
 
     // Send samples to UE
     if(NULL != msgq_to_ue)
-        msgq_to_ue->send(LIBTOOLS_IPC_MSGQ_MESSAGE_TYPE_PHY_SAMPS,
-                         (LIBTOOLS_IPC_MSGQ_MESSAGE_UNION *)tx_buf,
-                         sizeof(LIBTOOLS_IPC_MSGQ_PHY_SAMPS_MSG_STRUCT));
+        msgq_to_ue->send_samps(tx_buf);
 }
 
 /****************/
@@ -664,27 +676,30 @@ void LTE_fdd_enb_phy::process_pusch()
         phich[(ul_subframe.num + 4) % 10].present[n_group_phich][n_seq_phich] = true;
         phich[(ul_subframe.num + 4) % 10].b[n_group_phich][n_seq_phich]       = 0;
 
-        // Attempt decode
-        if(LIBLTE_SUCCESS == liblte_phy_pusch_channel_decode(phy_struct,
-                                                             &ul_subframe,
-                                                             &ul_schedule[ul_subframe.num].decodes.ul_alloc[i],
-                                                             interface->get_n_id_cell(),
-                                                             1,
-                                                             N_TURBO_ITERATIONS,
-                                                             pusch_decode.msg.msg,
-                                                             &pusch_decode.msg.N_bits))
-        {
-            pusch_decode.current_tti = ul_current_tti;
-            pusch_decode.rnti        = ul_schedule[ul_subframe.num].decodes.ul_alloc[i].rnti;
-
-            msgq_to_mac->send(LTE_FDD_ENB_MESSAGE_TYPE_PUSCH_DECODE,
-                              LTE_FDD_ENB_DEST_LAYER_MAC,
-                              (LTE_FDD_ENB_MESSAGE_UNION *)&pusch_decode,
-                              sizeof(LTE_FDD_ENB_PUSCH_DECODE_MSG_STRUCT));
+        // Attempt decode, failures are reported too so the MAC can adapt the UL MCS
+        pusch_decode.crc_pass    = (LIBLTE_SUCCESS == liblte_phy_pusch_channel_decode(phy_struct,
+                                                                                      &ul_subframe,
+                                                                                      &ul_schedule[ul_subframe.num].decodes.ul_alloc[i],
+                                                                                      interface->get_n_id_cell(),
+                                                                                      1,
+                                                                                      N_TURBO_ITERATIONS,
+                                                                                      ul_schedule[ul_subframe.num].soft_buffer[i],
+                                                                                      pusch_decode.msg.msg,
+                                                                                      &pusch_decode.msg.N_bits));
+        pusch_decode.current_tti = ul_current_tti;
+        pusch_decode.sinr_db     = phy_struct->pusch_sinr_db;
+        pusch_decode.rnti        = ul_schedule[ul_subframe.num].decodes.ul_alloc[i].rnti;
+        if(!pusch_decode.crc_pass)
+            pusch_decode.msg.N_bits = 0;
+
+        msgq_to_mac->send(LTE_FDD_ENB_MESSAGE_TYPE_PUSCH_DECODE,
+                          LTE_FDD_ENB_DEST_LAYER_MAC,
+                          (LTE_FDD_ENB_MESSAGE_UNION *)&pusch_decode,
+                          sizeof(LTE_FDD_ENB_PUSCH_DECODE_MSG_STRUCT));
 
-            // Add ACK to PHICH
-            phich[(ul_subframe.num + 4) % 10].b[n_group_phich][n_seq_phich]       = 1;
-        }
+        // Add ACK to PHICH
+        if(pusch_decode.crc_pass)
+            phich[(ul_subframe.num + 4) % 10].b[n_group_phich][n_seq_phich] = 1;
     }
     ul_schedule[ul_subframe.num].decodes.N_ul_alloc = 0;
 }
@@ -715,3 +730,13 @@ void LTE_fdd_enb_phy::process_ul(LTE_FDD_ENB_RADIO_RX_BUF_STRUCT *rx_buf)
     // Update counters
     ul_current_tti = liblte_phy_add_to_tti(ul_current_tti, 1);
 }
+void LTE_fdd_enb_phy::turbo_decode_hook(void *obj,
+                                        bool  done)
+{
+    LTE_fdd_enb_phy *phy = (LTE_fdd_enb_phy *)obj;
+
+    if(done)
+        phy->interface->get_metrics()->record(LTE_FDD_ENB_METRICS_STAGE_TURBO_DECODE_CB, phy->turbo_decode_start);
+    else
+        phy->turbo_decode_start = phy->interface->get_metrics()->start();
+}
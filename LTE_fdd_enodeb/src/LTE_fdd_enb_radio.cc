@@ -70,7 +70,11 @@
 #include <uhd/types/device_addr.hpp>
 #include <uhd/property_tree.hpp>
 #include <uhd/utils/thread.hpp>
-#include <thread>
+#include <random>
+#include <algorithm>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
 
 /*******************************************************************************
                               DEFINES
@@ -80,6 +84,9 @@
 #define EXTRA_RX_RADIO_DEBUG 0
 #define EXTRA_TX_RADIO_DEBUG 0
 
+// Both TX buffers followed by both RX buffers
+#define RADIO_BUFS_SIZE (2*sizeof(LTE_FDD_ENB_RADIO_TX_BUF_STRUCT) + 2*sizeof(LTE_FDD_ENB_RADIO_RX_BUF_STRUCT))
+
 // bladeRF defines
 #define BLADERF_NUM_BUFFERS   256
 #define BLADERF_NUM_TRANSFERS 32
@@ -146,6 +153,15 @@ static uint32 find_bladerfs()
     return find_bladerfs(NULL);
 }
 
+static uint64 get_monotonic_ns()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64)ts.tv_sec*1000000000 + ts.tv_nsec;
+}
+
 /*******************************************************************************
                               CLASS IMPLEMENTATIONS
 *******************************************************************************/
@@ -153,50 +169,217 @@ static uint32 find_bladerfs()
 /**************************************/
 /*    No-RF Constructor/Destructor    */
 /**************************************/
-LTE_fdd_enb_radio_no_rf::LTE_fdd_enb_radio_no_rf()
+LTE_fdd_enb_radio_no_rf::LTE_fdd_enb_radio_no_rf() :
+    ul_file{NULL}, dl_file{NULL}, dl_subfr{NULL}, noise{NULL}
 {
-    // Sleep time between subframes
-    sleep_time.tv_sec  = 0;
-    sleep_time.tv_nsec = 1000000;
 }
 LTE_fdd_enb_radio_no_rf::~LTE_fdd_enb_radio_no_rf()
 {
+    teardown(NULL);
 }
 
 /*******************************/
 /*    No-RF Radio Functions    */
 /*******************************/
-LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_radio_no_rf::setup()
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_radio_no_rf::setup(LTE_FDD_ENB_RADIO_SIM_CNFG_STRUCT *_cnfg,
+                                                      uint32                             _N_samps_per_subfr)
 {
+    cnfg              = *_cnfg;
+    N_samps_per_subfr = _N_samps_per_subfr;
+    N_ttis            = 0;
+    N_late_ttis       = 0;
+    max_late_ns       = 0;
+
+    if(0 != cnfg.ul_file_name.length())
+    {
+        ul_file = fopen(cnfg.ul_file_name.c_str(), "rb");
+        if(NULL == ul_file)
+            return LTE_FDD_ENB_ERROR_CANT_START;
+    }
+    if(0 != cnfg.dl_file_name.length())
+    {
+        dl_file = fopen(cnfg.dl_file_name.c_str(), "wb");
+        if(NULL == dl_file)
+        {
+            teardown(NULL);
+            return LTE_FDD_ENB_ERROR_CANT_START;
+        }
+    }
+
+    if(cnfg.loopback)
+    {
+        dl_subfr = new complex[LTE_FDD_ENB_RADIO_SIM_N_DL_SUBFRS*N_samps_per_subfr]();
+        for(uint32 i=0; i<LTE_FDD_ENB_RADIO_SIM_N_DL_SUBFRS; i++)
+            dl_subfr_tti[i] = LIBLTE_PHY_TTI_MAX + 1;
+
+        // Fixed seed so runs are repeatable
+        std::mt19937                    gen(1);
+        std::normal_distribution<float> dist(0, sqrt(0.5));
+        noise = new complex[LTE_FDD_ENB_RADIO_SIM_NOISE_TABLE_LEN];
+        for(uint32 i=0; i<LTE_FDD_ENB_RADIO_SIM_NOISE_TABLE_LEN; i++)
+            noise[i] = complex(dist(gen), dist(gen));
+        noise_idx = 0;
+
+        cfo_phasor = complex(1, 0);
+        cfo_step   = std::polar(1.0f, (float)(2*M_PI*cnfg.loop_cfo/(N_samps_per_subfr*1000.0)));
+    }
+
     return LTE_FDD_ENB_ERROR_NONE;
 }
-void LTE_fdd_enb_radio_no_rf::teardown()
+void LTE_fdd_enb_radio_no_rf::teardown(LTE_fdd_enb_interface *interface)
 {
+    if(NULL != interface)
+        interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
+                                  LTE_FDD_ENB_DEBUG_LEVEL_RADIO,
+                                  __FILE__,
+                                  __LINE__,
+                                  "No-RF radio stopped after %llu TTIs, %llu late, max late %llu us",
+                                  N_ttis,
+                                  N_late_ttis,
+                                  max_late_ns/1000);
+
+    if(NULL != ul_file)
+        fclose(ul_file);
+    ul_file = NULL;
+    if(NULL != dl_file)
+        fclose(dl_file);
+    dl_file = NULL;
+    delete [] dl_subfr;
+    dl_subfr = NULL;
+    delete [] noise;
+    noise = NULL;
 }
-void LTE_fdd_enb_radio_no_rf::send()
+void LTE_fdd_enb_radio_no_rf::send(LTE_FDD_ENB_RADIO_TX_BUF_STRUCT *buf)
 {
+    if(NULL != dl_file)
+        fwrite(buf->samps[0], sizeof(complex), buf->N_samps_per_ant, dl_file);
+
+    if(NULL != dl_subfr)
+    {
+        uint32 idx = buf->current_tti % LTE_FDD_ENB_RADIO_SIM_N_DL_SUBFRS;
+        memcpy(&dl_subfr[idx*N_samps_per_subfr], buf->samps[0], N_samps_per_subfr*sizeof(complex));
+        dl_subfr_tti[idx] = buf->current_tti;
+    }
 }
 void LTE_fdd_enb_radio_no_rf::init(LTE_FDD_ENB_RADIO_PARAMS_STRUCT *radio_params)
 {
+    next_deadline_ns = get_monotonic_ns();
 }
 void LTE_fdd_enb_radio_no_rf::receive(LTE_FDD_ENB_RADIO_PARAMS_STRUCT *radio_params)
 {
+    LTE_FDD_ENB_RADIO_RX_BUF_STRUCT *rx_buf = &radio_params->rx_radio_buf[radio_params->buf_idx];
+
     if(radio_params->init_needed)
     {
         // Signal PHY to generate first subframe
         radio_params->phy->radio_interface(&radio_params->tx_radio_buf[1]);
         radio_params->init_needed = false;
     }
-    radio_params->rx_radio_buf[radio_params->buf_idx].current_tti = radio_params->rx_current_tti;
+
+    // Build the UL subframe
+    rx_buf->current_tti     = radio_params->rx_current_tti;
+    rx_buf->N_samps_per_ant = N_samps_per_subfr;
+    rx_buf->N_ant           = 1;
+    if(NULL != ul_file)
+        read_ul_file(rx_buf->samps[0]);
+    else
+        std::fill_n(rx_buf->samps[0], N_samps_per_subfr, 0);
+    if(NULL != dl_subfr)
+        apply_loopback(rx_buf->samps[0], rx_buf->current_tti);
+
     radio_params->phy->radio_interface(&radio_params->tx_radio_buf[radio_params->buf_idx],
-                                       &radio_params->rx_radio_buf[radio_params->buf_idx]);
+                                       rx_buf);
     radio_params->buf_idx        = (radio_params->buf_idx + 1) % 2;
     radio_params->rx_current_tti = liblte_phy_add_to_tti(radio_params->rx_current_tti, 1);
-    struct timespec time_rem;
-    nanosleep(&sleep_time, &time_rem);
 
-    if(radio_params->rx_current_tti == 4000)
-        radio_params->rx_current_tti = liblte_phy_add_to_tti(radio_params->rx_current_tti, 20);
+    N_ttis++;
+    if(!cnfg.fast_pace)
+        wait_for_deadline();
+}
+void LTE_fdd_enb_radio_no_rf::read_ul_file(complex *samps)
+{
+    uint32 N_read = 0;
+
+    // Replay the file in a loop
+    while(N_read < N_samps_per_subfr)
+    {
+        N_read += fread(&samps[N_read], sizeof(complex), N_samps_per_subfr - N_read, ul_file);
+        if(N_read < N_samps_per_subfr)
+        {
+            if(0 == ftell(ul_file))
+            {
+                std::fill_n(&samps[N_read], N_samps_per_subfr - N_read, 0);
+                break;
+            }
+            rewind(ul_file);
+        }
+    }
+}
+void LTE_fdd_enb_radio_no_rf::apply_loopback(complex *samps,
+                                             uint16   current_tti)
+{
+    uint32   cur_idx  = current_tti % LTE_FDD_ENB_RADIO_SIM_N_DL_SUBFRS;
+    uint32   prev_idx = liblte_phy_sub_from_tti(current_tti, 1) % LTE_FDD_ENB_RADIO_SIM_N_DL_SUBFRS;
+    complex *cur      = &dl_subfr[cur_idx*N_samps_per_subfr];
+    complex *prev     = &dl_subfr[prev_idx*N_samps_per_subfr];
+    float    sig_pow  = 0;
+    uint32   delay    = std::min(cnfg.loop_delay, N_samps_per_subfr);
+    uint32   i;
+
+    // Nothing sent for this TTI yet
+    if(current_tti != dl_subfr_tti[cur_idx])
+        return;
+    if(liblte_phy_sub_from_tti(current_tti, 1) != dl_subfr_tti[prev_idx])
+        prev = NULL;
+
+    // Delay and frequency offset
+    for(i=0; i<N_samps_per_subfr; i++)
+    {
+        complex x;
+        if(i >= delay)
+            x = cur[i - delay];
+        else if(NULL != prev)
+            x = prev[N_samps_per_subfr - delay + i];
+        else
+            x = 0;
+        x           *= cfo_phasor;
+        cfo_phasor  *= cfo_step;
+        samps[i]    += x;
+        sig_pow     += std::norm(x);
+    }
+    cfo_phasor /= std::abs(cfo_phasor);
+
+    // Noise relative to the DL power
+    if(0 == sig_pow)
+        return;
+    float scale = sqrt(sig_pow/N_samps_per_subfr/pow(10, cnfg.loop_snr/10.0));
+    for(i=0; i<N_samps_per_subfr; i++)
+    {
+        samps[i]  += noise[noise_idx]*scale;
+        noise_idx  = (noise_idx + 1) % LTE_FDD_ENB_RADIO_SIM_NOISE_TABLE_LEN;
+    }
+    noise_idx = (noise_idx + 7919) % LTE_FDD_ENB_RADIO_SIM_NOISE_TABLE_LEN;
+}
+void LTE_fdd_enb_radio_no_rf::wait_for_deadline()
+{
+    struct timespec deadline;
+    uint64          now_ns;
+
+    // Absolute 1ms deadlines on the monotonic clock so sleep jitter
+    // doesn't accumulate, a TTI is late if processing ran past it
+    next_deadline_ns += 1000000;
+    now_ns            = get_monotonic_ns();
+    if(now_ns > next_deadline_ns)
+    {
+        N_late_ttis++;
+        max_late_ns = std::max(max_late_ns, now_ns - next_deadline_ns);
+        if(now_ns - next_deadline_ns > LTE_FDD_ENB_RADIO_SIM_MAX_LATE_NS)
+            next_deadline_ns = now_ns;
+        return;
+    }
+    deadline.tv_sec  = next_deadline_ns / 1000000000;
+    deadline.tv_nsec = next_deadline_ns % 1000000000;
+    while(EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL));
 }
 
 /******************************************/
@@ -312,11 +495,11 @@ void LTE_fdd_enb_radio_usrp_b2x0::send(LTE_FDD_ENB_RADIO_TX_BUF_STRUCT *buf,
     while(samps_to_send)
     {
         metadata.time_spec = next_tx_ts;
-        for(uint32 i=0; i<N_tx_samps; i++)
-            tx_buf[i] = buf->samps[0][idx+i]/complex(50, 0);
-        uint32 sent_samps = N_tx_samps;
+        uint32 sent_samps  = N_tx_samps;
         if(samps_to_send < N_tx_samps)
             sent_samps = samps_to_send;
+        // Scaled into tx_buf since buf is also sent to the UE
+        liblte_phy_scale_fc32(&buf->samps[0][idx], 1.0/50, sent_samps, tx_buf);
 #if EXTRA_TX_RADIO_DEBUG
         radio_params->interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
                                                 LTE_FDD_ENB_DEBUG_LEVEL_RADIO,
@@ -416,7 +599,11 @@ void LTE_fdd_enb_radio_usrp_b2x0::receive(LTE_FDD_ENB_RADIO_PARAMS_STRUCT *radio
                                                 __LINE__,
                                                 "Calling recv");
 #endif
-    uint32 N_samps = rx_stream->recv(rx_buf, N_rx_samps, metadata);
+    // Receive straight into the PHY's buffer, N_rx_samps divides the
+    // subframe so this never crosses a subframe boundary
+    uint32 N_samps = rx_stream->recv(&radio_params->rx_radio_buf[radio_params->buf_idx].samps[0][radio_params->samp_idx],
+                                     std::min((uint32)N_rx_samps, radio_params->N_samps_per_subfr - radio_params->samp_idx),
+                                     metadata);
 #if EXTRA_RX_RADIO_DEBUG
         radio_params->interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
                                                 LTE_FDD_ENB_DEBUG_LEVEL_RADIO,
@@ -495,8 +682,6 @@ void LTE_fdd_enb_radio_usrp_b2x0::receive(LTE_FDD_ENB_RADIO_PARAMS_STRUCT *radio
                                                        radio_params->samp_idx + N_samps,
                                                        radio_params->N_samps_per_subfr);
 
-    for(uint32 i=0; i<N_samps; i++)
-        radio_params->rx_radio_buf[radio_params->buf_idx].samps[0][radio_params->samp_idx+i] = rx_buf[i];
     radio_params->samp_idx += N_samps;
 
     if(radio_params->samp_idx == radio_params->N_samps_per_subfr)
@@ -865,11 +1050,7 @@ void LTE_fdd_enb_radio_bladerf::send(LTE_FDD_ENB_RADIO_TX_BUF_STRUCT *buf,
     }
 
     uint32 samps_to_send = radio_params->N_samps_per_subfr;
-    for(uint32 i=0; i<samps_to_send; i++)
-    {
-        tx_buf[(i*2)  ] = (int16_t)(buf->samps[0][i].real() * 40.0);
-        tx_buf[(i*2)+1] = (int16_t)(buf->samps[0][i].imag() * 40.0);
-    }
+    liblte_phy_fc32_to_sc16(buf->samps[0], 40, samps_to_send, tx_buf);
 
     if(first_tx_sample)
     {
@@ -951,8 +1132,10 @@ void LTE_fdd_enb_radio_bladerf::receive(LTE_FDD_ENB_RADIO_PARAMS_STRUCT *radio_p
 
         // FIXME: This doesn't recover from the overrun
     }else{
-        for(uint32 i=0; i<radio_params->N_samps_per_subfr; i++)
-            radio_params->rx_radio_buf[radio_params->buf_idx].samps[0][i] = complex(rx_buf[i*2] / 40.0, rx_buf[i*2+1] / 40.0);
+        liblte_phy_sc16_to_fc32(rx_buf,
+                                1.0/40,
+                                radio_params->N_samps_per_subfr,
+                                radio_params->rx_radio_buf[radio_params->buf_idx].samps[0]);
         metadata_rx.timestamp                                         += radio_params->N_samps_per_subfr;
         radio_params->rx_radio_buf[radio_params->buf_idx].current_tti  = radio_params->rx_current_tti;
         radio_params->phy->radio_interface(&radio_params->tx_radio_buf[radio_params->buf_idx],
@@ -969,8 +1152,21 @@ LTE_fdd_enb_radio::LTE_fdd_enb_radio(LTE_fdd_enb_interface *iface, LTE_fdd_enb_p
     started{false}, interface{iface}, phy{_phy}, clock_source{"internal"}, tx_gain{0},
     rx_gain{0}
 {
+    sim_cnfg.loop_cfo   = 0;
+    sim_cnfg.loop_snr   = 30;
+    sim_cnfg.loop_delay = 0;
+    sim_cnfg.fast_pace  = false;
+    sim_cnfg.loopback   = false;
+
     bladerf.set_interface(interface);
 
+    // Sample buffers on the radio thread's node, every page is
+    // used each subframe so reserved huge pages are worth it
+    radio_params.tx_radio_buf = (LTE_FDD_ENB_RADIO_TX_BUF_STRUCT *)interface->get_cpu()->alloc_buf(LTE_FDD_ENB_THREAD_ROLE_RADIO,
+                                                                                                   RADIO_BUFS_SIZE,
+                                                                                                   true);
+    radio_params.rx_radio_buf = (LTE_FDD_ENB_RADIO_RX_BUF_STRUCT *)&radio_params.tx_radio_buf[2];
+
     // Setup generic radios
     available_radios.num_radios = 0;
     get_available_radios();
@@ -981,6 +1177,7 @@ LTE_fdd_enb_radio::LTE_fdd_enb_radio(LTE_fdd_enb_interface *iface, LTE_fdd_enb_p
 LTE_fdd_enb_radio::~LTE_fdd_enb_radio()
 {
     stop();
+    interface->get_cpu()->free_buf(radio_params.tx_radio_buf, RADIO_BUFS_SIZE);
 }
 
 /********************/
@@ -1037,7 +1234,7 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_radio::start()
         switch(get_selected_radio_type())
         {
         case LTE_FDD_ENB_RADIO_TYPE_NO_RF:
-            err = no_rf.setup();
+            err = no_rf.setup(&sim_cnfg, radio_params.N_samps_per_subfr);
             if(LTE_FDD_ENB_ERROR_NONE != err)
             {
                 started = false;
@@ -1079,6 +1276,9 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_radio::start()
             break;
         }
 
+        // Follow the radio thread if it has moved node
+        interface->get_cpu()->place_buf(LTE_FDD_ENB_THREAD_ROLE_RADIO, radio_params.tx_radio_buf, RADIO_BUFS_SIZE);
+
         pthread_create(&radio_thread, NULL, &radio_thread_func, this);
     }else{
         start_mutex.unlock();
@@ -1098,7 +1298,7 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_radio::stop()
         switch(get_selected_radio_type())
         {
         case LTE_FDD_ENB_RADIO_TYPE_NO_RF:
-            no_rf.teardown();
+            // Torn down by the radio thread once it stops using it
             break;
         case LTE_FDD_ENB_RADIO_TYPE_USRP_B2X0:
             usrp_b2x0.teardown();
@@ -1274,6 +1474,102 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_radio::set_clock_source(std::string source)
     clock_source = source;
     return LTE_FDD_ENB_ERROR_NONE;
 }
+std::string LTE_fdd_enb_radio::get_sim_ul_file()
+{
+    if(0 == sim_cnfg.ul_file_name.length())
+        return "none";
+    return sim_cnfg.ul_file_name;
+}
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_radio::set_sim_ul_file(std::string file_name)
+{
+    std::lock_guard<std::mutex> lock(start_mutex);
+
+    if(started)
+        return LTE_FDD_ENB_ERROR_OUT_OF_BOUNDS;
+
+    if("none" == file_name)
+        file_name = "";
+    sim_cnfg.ul_file_name = file_name;
+    return LTE_FDD_ENB_ERROR_NONE;
+}
+std::string LTE_fdd_enb_radio::get_sim_dl_file()
+{
+    if(0 == sim_cnfg.dl_file_name.length())
+        return "none";
+    return sim_cnfg.dl_file_name;
+}
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_radio::set_sim_dl_file(std::string file_name)
+{
+    std::lock_guard<std::mutex> lock(start_mutex);
+
+    if(started)
+        return LTE_FDD_ENB_ERROR_OUT_OF_BOUNDS;
+
+    if("none" == file_name)
+        file_name = "";
+    sim_cnfg.dl_file_name = file_name;
+    return LTE_FDD_ENB_ERROR_NONE;
+}
+std::string LTE_fdd_enb_radio::get_sim_pace()
+{
+    if(sim_cnfg.fast_pace)
+        return "fast";
+    return "realtime";
+}
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_radio::set_sim_pace(std::string pace)
+{
+    std::lock_guard<std::mutex> lock(start_mutex);
+
+    if(started)
+        return LTE_FDD_ENB_ERROR_OUT_OF_BOUNDS;
+
+    if("realtime" != pace && "fast" != pace)
+        return LTE_FDD_ENB_ERROR_OUT_OF_BOUNDS;
+
+    sim_cnfg.fast_pace = ("fast" == pace);
+    return LTE_FDD_ENB_ERROR_NONE;
+}
+std::string LTE_fdd_enb_radio::get_sim_loopback()
+{
+    if(!sim_cnfg.loopback)
+        return "disable";
+    return(std::to_string(sim_cnfg.loop_delay) + "," +
+           std::to_string(sim_cnfg.loop_cfo)   + "," +
+           std::to_string(sim_cnfg.loop_snr));
+}
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_radio::set_sim_loopback(std::string loopback)
+{
+    std::lock_guard<std::mutex> lock(start_mutex);
+    int64                       delay;
+    int64                       cfo;
+    int64                       snr;
+    size_t                      first;
+    size_t                      second;
+
+    if(started)
+        return LTE_FDD_ENB_ERROR_OUT_OF_BOUNDS;
+
+    if("disable" == loopback)
+    {
+        sim_cnfg.loopback = false;
+        return LTE_FDD_ENB_ERROR_NONE;
+    }
+
+    // <delay in samples>,<CFO in Hz>,<SNR in dB>
+    first  = loopback.find(",");
+    second = loopback.find(",", first + 1);
+    if(std::string::npos == first || std::string::npos == second ||
+       to_number(loopback.substr(0, first), delay, 0, LIBLTE_PHY_N_SAMPS_PER_SUBFR_30_72MHZ) ||
+       to_number(loopback.substr(first + 1, second - first - 1), cfo, -20000, 20000) ||
+       to_number(loopback.substr(second + 1), snr, -20, 100))
+        return LTE_FDD_ENB_ERROR_OUT_OF_BOUNDS;
+
+    sim_cnfg.loop_delay = delay;
+    sim_cnfg.loop_cfo   = cfo;
+    sim_cnfg.loop_snr   = snr;
+    sim_cnfg.loopback   = true;
+    return LTE_FDD_ENB_ERROR_NONE;
+}
 uint32 LTE_fdd_enb_radio::get_phy_sample_rate()
 {
     if(started)
@@ -1322,7 +1618,7 @@ void LTE_fdd_enb_radio::send(LTE_FDD_ENB_RADIO_TX_BUF_STRUCT *buf)
     switch(selected_radio_type)
     {
     case LTE_FDD_ENB_RADIO_TYPE_NO_RF:
-        no_rf.send();
+        no_rf.send(buf);
         break;
     case LTE_FDD_ENB_RADIO_TYPE_USRP_B2X0:
         usrp_b2x0.send(buf, &radio_params);
@@ -1361,19 +1657,8 @@ void* LTE_fdd_enb_radio::radio_thread_func(void *inputs)
     radio->radio_params.init_needed    = true;
     radio->radio_params.rx_synced      = false;
 
-    // Set highest priority
-    struct sched_param priority;
-    int                sched_policy;
-    pthread_getschedparam(radio->radio_thread, &sched_policy, &priority);
-    priority.sched_priority = sched_get_priority_max(SCHED_FIFO);
-    pthread_setschedparam(radio->radio_thread, SCHED_FIFO, &priority);
-
-    // Set affinity to the last core for PHY/Radio
-    cpu_set_t af_mask;
-    CPU_ZERO(&af_mask);
-    uint32 num_cpus = std::thread::hardware_concurrency();
-    CPU_SET(num_cpus-1, &af_mask);
-    pthread_setaffinity_np(radio->get_radio_thread(), sizeof(af_mask), &af_mask);
+    // Priority and affinity for PHY/Radio
+    radio->interface->get_cpu()->place_thread(LTE_FDD_ENB_THREAD_ROLE_RADIO, LTE_FDD_ENB_CPU_ALL_CORES);
 
     switch(radio->get_selected_radio_type())
     {
@@ -1381,6 +1666,7 @@ void* LTE_fdd_enb_radio::radio_thread_func(void *inputs)
         radio->no_rf.init(&radio->radio_params);
         while(radio->is_started())
             radio->no_rf.receive(&radio->radio_params);
+        radio->no_rf.teardown(radio->interface);
         break;
     case LTE_FDD_ENB_RADIO_TYPE_USRP_B2X0:
         radio->usrp_b2x0.init(&radio->radio_params);
@@ -97,12 +97,12 @@ LTE_fdd_enb_rb::LTE_fdd_enb_rb(LTE_FDD_ENB_RB_ENUM    _rb,
                                LTE_fdd_enb_user      *_user,
                                LTE_fdd_enb_rlc       *_rlc) :
     rb{_rb}, interface{iface}, timer_mgr{tm}, user{_user}, rlc{_rlc}, rrc_transaction_id{0},
-    pdcp_rx_count{0}, pdcp_tx_count{0},
+    pdcp_rx_count{0}, pdcp_tx_count{0}, pdcp_dl_ciphering{false}, pdcp_ul_ciphering{false},
     t_poll_retransmit_timer_id{LTE_FDD_ENB_INVALID_TIMER_ID}, rlc_vrr{0},
     rlc_vrmr{LIBLTE_RLC_AM_WINDOW_SIZE}, rlc_vrh{0}, rlc_vta{0},
     rlc_vtms{LIBLTE_RLC_AM_WINDOW_SIZE}, rlc_vts{0}, rlc_vruh{0}, rlc_vrur{0},
     rlc_um_window_size{512}, rlc_first_um_segment_sn{0xFFFF}, rlc_last_um_segment_sn{0xFFFF},
-    rlc_vtus{0}, mac_con_res_id{0}
+    rlc_vtus{0}, rlc_tx_buffer_bytes{0}, rlc_tx_buffer_offset{0}, mac_con_res_id{0}
 {
     if(LTE_FDD_ENB_RB_SRB0 == rb)
     {
@@ -148,16 +148,13 @@ LTE_fdd_enb_rb::~LTE_fdd_enb_rb()
 {
     // MAC
     mac_sdu_queue_mutex.lock();
-    for(auto it=mac_sdu_queue.begin(); it!=mac_sdu_queue.end(); it++)
-        delete (*it);
+    mac_sdu_queue.clear();
 
     // RLC
     rlc_pdu_queue_mutex.lock();
-    for(auto it=rlc_pdu_queue.begin(); it!=rlc_pdu_queue.end(); it++)
-        delete (*it);
+    rlc_pdu_queue.clear();
     rlc_sdu_queue_mutex.lock();
-    for(auto it=rlc_sdu_queue.begin(); it!=rlc_sdu_queue.end(); it++)
-        delete (*it);
+    rlc_sdu_queue.clear();
     for(auto rlc_am_rx : rlc_am_rx_buffer)
         delete rlc_am_rx.second;
     for(auto rlc_am_tx : rlc_am_tx_buffer)
@@ -169,32 +166,25 @@ LTE_fdd_enb_rb::~LTE_fdd_enb_rb()
 
     // PDCP
     pdcp_pdu_queue_mutex.lock();
-    for(auto it=pdcp_pdu_queue.begin(); it!=pdcp_pdu_queue.end(); it++)
-        delete (*it);
+    pdcp_pdu_queue.clear();
     pdcp_sdu_queue_mutex.lock();
-    for(auto it=pdcp_sdu_queue.begin(); it!=pdcp_sdu_queue.end(); it++)
-        delete (*it);
+    pdcp_sdu_queue.clear();
     pdcp_data_sdu_queue_mutex.lock();
-    for(auto it=pdcp_data_sdu_queue.begin(); it!=pdcp_data_sdu_queue.end(); it++)
-        delete (*it);
+    pdcp_data_sdu_queue.clear();
 
     // RRC
     rrc_pdu_queue_mutex.lock();
-    for(auto it=rrc_pdu_queue.begin(); it!=rrc_pdu_queue.end(); it++)
-        delete (*it);
+    rrc_pdu_queue.clear();
     rrc_nas_msg_queue_mutex.lock();
-    for(auto it=rrc_nas_msg_queue.begin(); it!=rrc_nas_msg_queue.end(); it++)
-        delete (*it);
+    rrc_nas_msg_queue.clear();
 
     // MME
     mme_nas_msg_queue_mutex.lock();
-    for(auto it=mme_nas_msg_queue.begin(); it!=mme_nas_msg_queue.end(); it++)
-        delete (*it);
+    mme_nas_msg_queue.clear();
 
     // GW
     gw_data_msg_queue_mutex.lock();
-    for(auto it=gw_data_msg_queue.begin(); it!=gw_data_msg_queue.end(); it++)
-        delete (*it);
+    gw_data_msg_queue.clear();
 }
 
 /******************/
@@ -418,6 +408,22 @@ void LTE_fdd_enb_rb::set_pdcp_tx_count(uint32 tx_count)
 {
     pdcp_tx_count = tx_count;
 }
+void LTE_fdd_enb_rb::set_pdcp_dl_ciphering(bool ciphering)
+{
+    pdcp_dl_ciphering = ciphering;
+}
+bool LTE_fdd_enb_rb::get_pdcp_dl_ciphering()
+{
+    return pdcp_dl_ciphering;
+}
+void LTE_fdd_enb_rb::set_pdcp_ul_ciphering(bool ciphering)
+{
+    pdcp_ul_ciphering = ciphering;
+}
+bool LTE_fdd_enb_rb::get_pdcp_ul_ciphering()
+{
+    return pdcp_ul_ciphering;
+}
 
 /*************/
 /*    RLC    */
@@ -436,7 +442,13 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_rb::delete_next_rlc_pdu()
 }
 void LTE_fdd_enb_rb::queue_rlc_sdu(LIBLTE_BYTE_MSG_STRUCT *sdu)
 {
-    queue_msg(sdu, rlc_sdu_queue_mutex, &rlc_sdu_queue);
+    std::lock_guard<std::mutex>  lock(rlc_sdu_queue_mutex);
+    LIBLTE_BYTE_MSG_STRUCT      *loc_sdu = LTE_fdd_enb_msg_pool<LIBLTE_BYTE_MSG_STRUCT>::alloc();
+
+    loc_sdu->N_bytes = sdu->N_bytes;
+    memcpy(loc_sdu->msg, sdu->msg, sdu->N_bytes);
+    rlc_sdu_queue.push_back(loc_sdu);
+    rlc_tx_buffer_bytes += sdu->N_bytes;
 }
 LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_rb::get_next_rlc_sdu(LIBLTE_BYTE_MSG_STRUCT **sdu)
 {
@@ -444,7 +456,17 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_rb::get_next_rlc_sdu(LIBLTE_BYTE_MSG_STRUCT *
 }
 LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_rb::delete_next_rlc_sdu()
 {
-    return delete_next_msg(rlc_sdu_queue_mutex, &rlc_sdu_queue);
+    std::lock_guard<std::mutex>  lock(rlc_sdu_queue_mutex);
+    LIBLTE_BYTE_MSG_STRUCT      *sdu;
+
+    if(0 == rlc_sdu_queue.size())
+        return LTE_FDD_ENB_ERROR_NO_MSG_IN_QUEUE;
+
+    sdu = rlc_sdu_queue.pop_front();
+    rlc_tx_buffer_bytes  -= sdu->N_bytes - rlc_tx_buffer_offset;
+    rlc_tx_buffer_offset  = 0;
+    LTE_fdd_enb_msg_pool<LIBLTE_BYTE_MSG_STRUCT>::free(sdu);
+    return LTE_FDD_ENB_ERROR_NONE;
 }
 LTE_FDD_ENB_RLC_CONFIG_ENUM LTE_fdd_enb_rb::get_rlc_config()
 {
@@ -589,8 +611,8 @@ uint16 LTE_fdd_enb_rb::get_rlc_vta()
 }
 void LTE_fdd_enb_rb::set_rlc_vta(uint16 vta)
 {
-    rlc_vta  = vta;
-    rlc_vtms = rlc_vta + LIBLTE_RLC_AM_WINDOW_SIZE;
+    rlc_vta  = vta % LIBLTE_RLC_AM_SN_MOD;
+    rlc_vtms = (rlc_vta + LIBLTE_RLC_AM_WINDOW_SIZE) % LIBLTE_RLC_AM_SN_MOD;
 }
 uint16 LTE_fdd_enb_rb::get_rlc_vtms()
 {
@@ -602,10 +624,11 @@ uint16 LTE_fdd_enb_rb::get_rlc_vts()
 }
 void LTE_fdd_enb_rb::set_rlc_vts(uint16 vts)
 {
-    rlc_vts = vts;
+    rlc_vts = vts % LIBLTE_RLC_AM_SN_MOD;
 }
 void LTE_fdd_enb_rb::rlc_add_to_transmission_buffer(LIBLTE_RLC_SINGLE_AMD_PDU_STRUCT *amd_pdu)
 {
+    std::lock_guard<std::mutex>       lock(rlc_am_tx_buffer_mutex);
     LIBLTE_RLC_SINGLE_AMD_PDU_STRUCT *new_pdu = new LIBLTE_RLC_SINGLE_AMD_PDU_STRUCT;
 
     if(NULL == new_pdu)
@@ -616,10 +639,11 @@ void LTE_fdd_enb_rb::rlc_add_to_transmission_buffer(LIBLTE_RLC_SINGLE_AMD_PDU_ST
 }
 void LTE_fdd_enb_rb::rlc_update_transmission_buffer(LIBLTE_RLC_STATUS_PDU_STRUCT *status)
 {
-    uint32 i = rlc_vta;
-    uint32 j;
-    bool   update_vta = true;
-    bool   remove_sn;
+    std::lock_guard<std::mutex> lock(rlc_am_tx_buffer_mutex);
+    uint32                      i = rlc_vta;
+    uint32                      j;
+    bool                        update_vta = true;
+    bool                        remove_sn;
 
     while(i != status->ack_sn)
     {
@@ -644,7 +668,7 @@ void LTE_fdd_enb_rb::rlc_update_transmission_buffer(LIBLTE_RLC_STATUS_PDU_STRUCT
             if(update_vta)
                 set_rlc_vta(i+1);
         }
-        i = (i+1) % 1024;
+        i = (i+1) % LIBLTE_RLC_AM_SN_MOD;
     }
 
     if(rlc_am_tx_buffer.size() == 0)
@@ -664,12 +688,23 @@ void LTE_fdd_enb_rb::rlc_stop_t_poll_retransmit()
 }
 void LTE_fdd_enb_rb::handle_t_poll_retransmit_timer_expiry(uint32 timer_id)
 {
-    auto rlc_am_tx_it = rlc_am_tx_buffer.find(rlc_vta);
+    LIBLTE_RLC_SINGLE_AMD_PDU_STRUCT amd;
 
     t_poll_retransmit_timer_id = LTE_FDD_ENB_INVALID_TIMER_ID;
 
-    if(rlc_am_tx_buffer.end() != rlc_am_tx_it)
-        rlc->handle_retransmit((*rlc_am_tx_it).second, user, this);
+    rlc_am_tx_buffer_mutex.lock();
+    auto rlc_am_tx_it = rlc_am_tx_buffer.find(rlc_vta);
+    if(rlc_am_tx_buffer.end() == rlc_am_tx_it)
+    {
+        rlc_am_tx_buffer_mutex.unlock();
+        return;
+    }
+    amd.hdr          = (*rlc_am_tx_it).second->hdr;
+    amd.data.N_bytes = (*rlc_am_tx_it).second->data.N_bytes;
+    memcpy(amd.data.msg, (*rlc_am_tx_it).second->data.msg, amd.data.N_bytes);
+    rlc_am_tx_buffer_mutex.unlock();
+
+    rlc->handle_retransmit(&amd, user, this);
 }
 void LTE_fdd_enb_rb::set_rlc_vruh(uint16 vruh)
 {
@@ -776,6 +811,86 @@ uint16 LTE_fdd_enb_rb::get_rlc_vtus()
 {
     return rlc_vtus;
 }
+void LTE_fdd_enb_rb::rlc_get_tx_buffer_status(uint32 *N_bytes,
+                                              uint32 *N_sdus)
+{
+    std::lock_guard<std::mutex> lock(rlc_sdu_queue_mutex);
+
+    *N_bytes = rlc_tx_buffer_bytes;
+    *N_sdus  = rlc_sdu_queue.size();
+}
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_rb::rlc_segment_tx_buffer(uint32                          N_bytes,
+                                                             LTE_FDD_ENB_RLC_SEGMENT_STRUCT *seg)
+{
+    std::lock_guard<std::mutex> lock(rlc_sdu_queue_mutex);
+    uint32                      offset  = rlc_tx_buffer_offset;
+    uint32                      fi_bits = 0;
+
+    // FI bit 1 set means the first byte does not start an SDU
+    if(0 != offset)
+        fi_bits = 2;
+
+    seg->N_data  = 0;
+    seg->N_bytes = 0;
+    for(auto sdu=rlc_sdu_queue.front(); NULL != sdu; sdu=rlc_sdu_queue.next(sdu))
+    {
+        // Each additional data field needs an 11 bit LI for the previous one
+        if(LTE_FDD_ENB_RLC_MAX_N_DATA == seg->N_data ||
+           (0 != seg->N_data && 0x7FF < seg->li[seg->N_data-1]))
+            break;
+
+        uint32 N_hdr_bytes = rlc_get_pdu_header_size(seg->N_data+1);
+        if(N_bytes <= N_hdr_bytes + seg->N_bytes)
+            break;
+
+        uint32 N_avail     = N_bytes - N_hdr_bytes - seg->N_bytes;
+        uint32 N_remaining = sdu->N_bytes - offset;
+        offset             = 0;
+        if(N_remaining > N_avail)
+        {
+            // FI bit 0 set means the last byte does not end an SDU
+            seg->li[seg->N_data++]  = N_avail;
+            seg->N_bytes           += N_avail;
+            fi_bits                |= 1;
+            break;
+        }
+        seg->li[seg->N_data++]  = N_remaining;
+        seg->N_bytes           += N_remaining;
+    }
+    seg->fi = (LIBLTE_RLC_FI_FIELD_ENUM)fi_bits;
+
+    if(0 == seg->N_data)
+        return LTE_FDD_ENB_ERROR_NO_MSG_IN_QUEUE;
+
+    return LTE_FDD_ENB_ERROR_NONE;
+}
+void LTE_fdd_enb_rb::rlc_read_tx_buffer(LTE_FDD_ENB_RLC_SEGMENT_STRUCT *seg,
+                                        LIBLTE_BYTE_MSG_STRUCT         *pdu)
+{
+    std::lock_guard<std::mutex> lock(rlc_sdu_queue_mutex);
+
+    for(uint32 i=0; i<seg->N_data && 0 != rlc_sdu_queue.size(); i++)
+    {
+        LIBLTE_BYTE_MSG_STRUCT *sdu = rlc_sdu_queue.front();
+        memcpy(&pdu->msg[pdu->N_bytes], &sdu->msg[rlc_tx_buffer_offset], seg->li[i]);
+        pdu->N_bytes         += seg->li[i];
+        rlc_tx_buffer_offset += seg->li[i];
+        rlc_tx_buffer_bytes  -= seg->li[i];
+        if(rlc_tx_buffer_offset == sdu->N_bytes)
+        {
+            rlc_sdu_queue.pop_front();
+            LTE_fdd_enb_msg_pool<LIBLTE_BYTE_MSG_STRUCT>::free(sdu);
+            rlc_tx_buffer_offset = 0;
+        }
+    }
+}
+uint32 LTE_fdd_enb_rb::rlc_get_pdu_header_size(uint32 N_data)
+{
+    if(LTE_FDD_ENB_RLC_CONFIG_UM == rlc_config)
+        return liblte_rlc_get_umd_pdu_header_size(LIBLTE_RLC_UMD_SN_SIZE_10_BITS, N_data);
+
+    return liblte_rlc_get_amd_pdu_header_size(LIBLTE_RLC_RF_FIELD_AMD_PDU, N_data);
+}
 
 /*************/
 /*    MAC    */
@@ -852,29 +967,34 @@ uint8 LTE_fdd_enb_rb::get_log_chan_group()
 /*****************/
 /*    Generic    */
 /*****************/
-void LTE_fdd_enb_rb::queue_msg(LIBLTE_BIT_MSG_STRUCT              *msg,
-                               std::mutex                         &mutex,
-                               std::list<LIBLTE_BIT_MSG_STRUCT *> *queue)
+void LTE_fdd_enb_rb::queue_msg(LIBLTE_BIT_MSG_STRUCT                        *msg,
+                               std::mutex                                   &mutex,
+                               LTE_fdd_enb_msg_queue<LIBLTE_BIT_MSG_STRUCT> *queue)
 {
-    std::lock_guard<std::mutex>  lock(mutex);
-    LIBLTE_BIT_MSG_STRUCT       *loc_msg = new LIBLTE_BIT_MSG_STRUCT;
+    LIBLTE_BIT_MSG_STRUCT *loc_msg = LTE_fdd_enb_msg_pool<LIBLTE_BIT_MSG_STRUCT>::alloc();
 
-    memcpy(loc_msg, msg, sizeof(LIBLTE_BIT_MSG_STRUCT));
+    // Only the used part of the message is copied
+    loc_msg->N_bits = msg->N_bits;
+    memcpy(loc_msg->msg, msg->msg, msg->N_bits);
+
+    std::lock_guard<std::mutex> lock(mutex);
     queue->push_back(loc_msg);
 }
-void LTE_fdd_enb_rb::queue_msg(LIBLTE_BYTE_MSG_STRUCT              *msg,
-                               std::mutex                          &mutex,
-                               std::list<LIBLTE_BYTE_MSG_STRUCT *> *queue)
+void LTE_fdd_enb_rb::queue_msg(LIBLTE_BYTE_MSG_STRUCT                        *msg,
+                               std::mutex                                    &mutex,
+                               LTE_fdd_enb_msg_queue<LIBLTE_BYTE_MSG_STRUCT> *queue)
 {
-    std::lock_guard<std::mutex>  lock(mutex);
-    LIBLTE_BYTE_MSG_STRUCT      *loc_msg = new LIBLTE_BYTE_MSG_STRUCT;
+    LIBLTE_BYTE_MSG_STRUCT *loc_msg = LTE_fdd_enb_msg_pool<LIBLTE_BYTE_MSG_STRUCT>::alloc();
+
+    loc_msg->N_bytes = msg->N_bytes;
+    memcpy(loc_msg->msg, msg->msg, msg->N_bytes);
 
-    memcpy(loc_msg, msg, sizeof(LIBLTE_BYTE_MSG_STRUCT));
+    std::lock_guard<std::mutex> lock(mutex);
     queue->push_back(loc_msg);
 }
-LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_rb::get_next_msg(std::mutex                          &mutex,
-                                                    std::list<LIBLTE_BIT_MSG_STRUCT *>  *queue,
-                                                    LIBLTE_BIT_MSG_STRUCT              **msg)
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_rb::get_next_msg(std::mutex                                    &mutex,
+                                                    LTE_fdd_enb_msg_queue<LIBLTE_BIT_MSG_STRUCT>  *queue,
+                                                    LIBLTE_BIT_MSG_STRUCT                        **msg)
 {
     std::lock_guard<std::mutex> lock(mutex);
 
@@ -884,9 +1004,9 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_rb::get_next_msg(std::mutex
     *msg = queue->front();
     return LTE_FDD_ENB_ERROR_NONE;
 }
-LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_rb::get_next_msg(std::mutex                           &mutex,
-                                                    std::list<LIBLTE_BYTE_MSG_STRUCT *>  *queue,
-                                                    LIBLTE_BYTE_MSG_STRUCT              **msg)
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_rb::get_next_msg(std::mutex                                     &mutex,
+                                                    LTE_fdd_enb_msg_queue<LIBLTE_BYTE_MSG_STRUCT>  *queue,
+                                                    LIBLTE_BYTE_MSG_STRUCT                        **msg)
 {
     std::lock_guard<std::mutex> lock(mutex);
 
@@ -896,31 +1016,27 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_rb::get_next_msg(std::mutex
     *msg = queue->front();
     return LTE_FDD_ENB_ERROR_NONE;
 }
-LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_rb::delete_next_msg(std::mutex                         &mutex,
-                                                       std::list<LIBLTE_BIT_MSG_STRUCT *> *queue)
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_rb::delete_next_msg(std::mutex                                   &mutex,
+                                                       LTE_fdd_enb_msg_queue<LIBLTE_BIT_MSG_STRUCT> *queue)
 {
     std::lock_guard<std::mutex>  lock(mutex);
-    LIBLTE_BIT_MSG_STRUCT       *msg;
+    LIBLTE_BIT_MSG_STRUCT       *msg = queue->pop_front();
 
-    if(0 == queue->size())
+    if(NULL == msg)
         return LTE_FDD_ENB_ERROR_NO_MSG_IN_QUEUE;
 
-    msg = queue->front();
-    queue->pop_front();
-    delete msg;
+    LTE_fdd_enb_msg_pool<LIBLTE_BIT_MSG_STRUCT>::free(msg);
     return LTE_FDD_ENB_ERROR_NONE;
 }
-LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_rb::delete_next_msg(std::mutex                          &mutex,
-                                                       std::list<LIBLTE_BYTE_MSG_STRUCT *> *queue)
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_rb::delete_next_msg(std::mutex                                    &mutex,
+                                                       LTE_fdd_enb_msg_queue<LIBLTE_BYTE_MSG_STRUCT> *queue)
 {
     std::lock_guard<std::mutex>  lock(mutex);
-    LIBLTE_BYTE_MSG_STRUCT      *msg;
+    LIBLTE_BYTE_MSG_STRUCT      *msg = queue->pop_front();
 
-    if(0 == queue->size())
+    if(NULL == msg)
         return LTE_FDD_ENB_ERROR_NO_MSG_IN_QUEUE;
 
-    msg = queue->front();
-    queue->pop_front();
-    delete msg;
+    LTE_fdd_enb_msg_pool<LIBLTE_BYTE_MSG_STRUCT>::free(msg);
     return LTE_FDD_ENB_ERROR_NONE;
 }
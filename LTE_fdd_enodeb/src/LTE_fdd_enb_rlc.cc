@@ -155,6 +155,18 @@ void LTE_fdd_enb_rlc::handle_pdcp_msg(LTE_FDD_ENB_MESSAGE_STRUCT &msg)
                               "Received invalid PDCP message %s",
                               LTE_fdd_enb_message_type_text[msg.type]);
 }
+void LTE_fdd_enb_rlc::send_mac_sdu_ready(LTE_fdd_enb_user *user,
+                                         LTE_fdd_enb_rb   *rb)
+{
+    LTE_FDD_ENB_MAC_SDU_READY_MSG_STRUCT sdu_ready;
+
+    sdu_ready.user = user;
+    sdu_ready.rb   = rb;
+    msgq_to_mac->send(LTE_FDD_ENB_MESSAGE_TYPE_MAC_SDU_READY,
+                      LTE_FDD_ENB_DEST_LAYER_MAC,
+                      (LTE_FDD_ENB_MESSAGE_UNION *)&sdu_ready,
+                      sizeof(sdu_ready));
+}
 void LTE_fdd_enb_rlc::send_mac_sdu_ready(LTE_fdd_enb_user       *user,
                                          LTE_fdd_enb_rb         *rb,
                                          LIBLTE_BYTE_MSG_STRUCT *sdu)
@@ -220,9 +232,11 @@ void LTE_fdd_enb_rlc::handle_retransmit(LIBLTE_RLC_SINGLE_AMD_PDU_STRUCT *amd,
 {
     LIBLTE_BYTE_MSG_STRUCT pdu;
 
-    // Pack the PDU
-    amd->hdr.p = LIBLTE_RLC_P_FIELD_STATUS_REPORT_REQUESTED;
-    liblte_rlc_pack_amd_pdu(amd, &amd->data, &pdu);
+    // The stored PDU is already packed with its LI fields, only set the poll bit
+    amd->hdr.p  = LIBLTE_RLC_P_FIELD_STATUS_REPORT_REQUESTED;
+    pdu.N_bytes = amd->data.N_bytes;
+    memcpy(pdu.msg, amd->data.msg, amd->data.N_bytes);
+    pdu.msg[0] |= (amd->hdr.p & 0x01) << 5;
 
     // Start t-pollretransmit
     rb->rlc_start_t_poll_retransmit();
@@ -244,6 +258,41 @@ void LTE_fdd_enb_rlc::handle_retransmit(LIBLTE_RLC_SINGLE_AMD_PDU_STRUCT *amd,
     // Send the SDU to MAC
     send_mac_sdu_ready(user, rb, &pdu);
 }
+uint32 LTE_fdd_enb_rlc::get_buffer_status(LTE_fdd_enb_rb *rb)
+{
+    uint32 N_bytes;
+    uint32 N_sdus;
+
+    if(LTE_FDD_ENB_RLC_CONFIG_TM == rb->get_rlc_config())
+        return 0;
+
+    rb->rlc_get_tx_buffer_status(&N_bytes, &N_sdus);
+    if(0 == N_sdus)
+        return 0;
+
+    // Assume the whole buffer goes out in one PDU for the header estimate
+    if(LTE_FDD_ENB_RLC_MAX_N_DATA < N_sdus)
+        N_sdus = LTE_FDD_ENB_RLC_MAX_N_DATA;
+
+    return N_bytes + rb->rlc_get_pdu_header_size(N_sdus);
+}
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_rlc::build_pdu(LTE_fdd_enb_user       *user,
+                                                  LTE_fdd_enb_rb         *rb,
+                                                  uint32                  N_bytes,
+                                                  LIBLTE_BYTE_MSG_STRUCT *pdu)
+{
+    switch(rb->get_rlc_config())
+    {
+    case LTE_FDD_ENB_RLC_CONFIG_UM:
+        return build_umd_pdu(user, rb, N_bytes, pdu);
+    case LTE_FDD_ENB_RLC_CONFIG_AM:
+        return build_amd_pdu(user, rb, N_bytes, pdu);
+    default:
+        break;
+    }
+
+    return LTE_FDD_ENB_ERROR_INVALID_PARAM;
+}
 
 /******************************/
 /*    MAC Message Handlers    */
@@ -509,32 +558,33 @@ void LTE_fdd_enb_rlc::handle_sdu_ready(LTE_FDD_ENB_RLC_SDU_READY_MSG_STRUCT *sdu
 {
     LIBLTE_BYTE_MSG_STRUCT *sdu;
 
-    if(LTE_FDD_ENB_ERROR_NONE != sdu_ready->rb->get_next_rlc_sdu(&sdu))
-        return interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ERROR,
-                                         LTE_FDD_ENB_DEBUG_LEVEL_RLC,
-                                         __FILE__,
-                                         __LINE__,
-                                         "Received sdu_ready message with no SDU queued");
-
-    interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
-                              LTE_FDD_ENB_DEBUG_LEVEL_RLC,
-                              __FILE__,
-                              __LINE__,
-                              sdu,
-                              "Received SDU for RNTI=%u and RB=%s",
-                              sdu_ready->user->get_c_rnti(),
-                              LTE_fdd_enb_rb_text[sdu_ready->rb->get_rb_id()]);
-
     switch(sdu_ready->rb->get_rlc_config())
     {
     case LTE_FDD_ENB_RLC_CONFIG_TM:
+        if(LTE_FDD_ENB_ERROR_NONE != sdu_ready->rb->get_next_rlc_sdu(&sdu))
+            return interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ERROR,
+                                             LTE_FDD_ENB_DEBUG_LEVEL_RLC,
+                                             __FILE__,
+                                             __LINE__,
+                                             "Received sdu_ready message with no SDU queued");
+
+        interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
+                                  LTE_FDD_ENB_DEBUG_LEVEL_RLC,
+                                  __FILE__,
+                                  __LINE__,
+                                  sdu,
+                                  "Received SDU for RNTI=%u and RB=%s",
+                                  sdu_ready->user->get_c_rnti(),
+                                  LTE_fdd_enb_rb_text[sdu_ready->rb->get_rb_id()]);
+
         handle_tm_sdu(sdu, sdu_ready->user, sdu_ready->rb);
+
+        // Delete the SDU
+        sdu_ready->rb->delete_next_rlc_sdu();
         break;
     case LTE_FDD_ENB_RLC_CONFIG_UM:
-        handle_um_sdu(sdu, sdu_ready->user, sdu_ready->rb);
-        break;
     case LTE_FDD_ENB_RLC_CONFIG_AM:
-        handle_am_sdu(sdu, sdu_ready->user, sdu_ready->rb);
+        handle_um_am_sdu(sdu_ready->user, sdu_ready->rb);
         break;
     default:
         interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_ERROR,
@@ -547,9 +597,6 @@ void LTE_fdd_enb_rlc::handle_sdu_ready(LTE_FDD_ENB_RLC_SDU_READY_MSG_STRUCT *sdu
                                   LTE_fdd_enb_rlc_config_text[sdu_ready->rb->get_rlc_config()]);
         break;
     }
-
-    // Delete the SDU
-    sdu_ready->rb->delete_next_rlc_sdu();
 }
 void LTE_fdd_enb_rlc::handle_tm_sdu(LIBLTE_BYTE_MSG_STRUCT *sdu,
                                     LTE_fdd_enb_user       *user,
@@ -566,114 +613,28 @@ void LTE_fdd_enb_rlc::handle_tm_sdu(LIBLTE_BYTE_MSG_STRUCT *sdu,
     // Send the PDU to MAC
     send_mac_sdu_ready(user, rb, sdu);
 }
-void LTE_fdd_enb_rlc::handle_um_sdu(LIBLTE_BYTE_MSG_STRUCT *sdu,
-                                    LTE_fdd_enb_user       *user,
-                                    LTE_fdd_enb_rb         *rb)
-{
-    LIBLTE_RLC_UMD_PDU_STRUCT umd;
-    LIBLTE_BYTE_MSG_STRUCT    pdu;
-    uint32                    byte_idx        = 0;
-    uint32                    bytes_per_subfn = user->get_max_dl_bytes_per_subfn();
-    uint16                    vtus            = rb->get_rlc_vtus();
-
-    if(sdu->N_bytes <= bytes_per_subfn)
-    {
-        // Pack the PDU
-        umd.hdr.fi      = LIBLTE_RLC_FI_FIELD_FULL_SDU;
-        umd.hdr.sn      = vtus;
-        umd.hdr.sn_size = LIBLTE_RLC_UMD_SN_SIZE_10_BITS;
-        umd.N_data      = 1;
-        memcpy(&umd.data, sdu, sizeof(LIBLTE_BYTE_MSG_STRUCT));
-        rb->set_rlc_vtus(vtus+1);
-        liblte_rlc_pack_umd_pdu(&umd, &pdu);
-
-        // Send the PDU to MAC
-        send_mac_sdu_ready(user, rb, &pdu);
-
-        return;
-    }
-
-    // Segment the message
-    while(byte_idx < sdu->N_bytes)
-    {
-        umd.hdr.fi = LIBLTE_RLC_FI_FIELD_MIDDLE_SDU_SEGMENT;
-        umd.hdr.sn = vtus;
-        if(byte_idx == 0)
-            umd.hdr.fi = LIBLTE_RLC_FI_FIELD_FIRST_SDU_SEGMENT;
-        if((sdu->N_bytes - byte_idx) >= bytes_per_subfn)
-        {
-            memcpy(&umd.data[0].msg[0], &sdu->msg[byte_idx], bytes_per_subfn);
-            umd.data[0].N_bytes  = bytes_per_subfn;
-            byte_idx            += bytes_per_subfn;
-        }else{
-            memcpy(&umd.data[0].msg[0], &sdu->msg[byte_idx], sdu->N_bytes - byte_idx);
-            umd.data[0].N_bytes = sdu->N_bytes - byte_idx;
-            byte_idx            = sdu->N_bytes;
-        }
-        umd.N_data = 1;
-        if(byte_idx == sdu->N_bytes)
-            umd.hdr.fi = LIBLTE_RLC_FI_FIELD_LAST_SDU_SEGMENT;
-        rb->set_rlc_vtus(vtus+1);
-        vtus = rb->get_rlc_vtus();
-        liblte_rlc_pack_umd_pdu(&umd, &pdu);
-
-        // Send the PDU to MAC
-        send_mac_sdu_ready(user, rb, &pdu);
-    }
-}
-void LTE_fdd_enb_rlc::handle_am_sdu(LIBLTE_BYTE_MSG_STRUCT *sdu,
-                                    LTE_fdd_enb_user       *user,
-                                    LTE_fdd_enb_rb         *rb)
+void LTE_fdd_enb_rlc::handle_um_am_sdu(LTE_fdd_enb_user *user,
+                                       LTE_fdd_enb_rb   *rb)
 {
-    LIBLTE_RLC_SINGLE_AMD_PDU_STRUCT amd;
-    uint32                           byte_idx        = 0;
-    uint32                           bytes_per_subfn = user->get_max_dl_bytes_per_subfn();
-    uint16                           vts             = rb->get_rlc_vts();
+    uint32 N_bytes;
+    uint32 N_sdus;
 
-    if(sdu->N_bytes <= bytes_per_subfn)
-    {
-        amd.hdr.dc = LIBLTE_RLC_DC_FIELD_DATA_PDU;
-        amd.hdr.rf = LIBLTE_RLC_RF_FIELD_AMD_PDU;
-        amd.hdr.sn = vts;
-        amd.hdr.p  = LIBLTE_RLC_P_FIELD_STATUS_REPORT_REQUESTED;
-        amd.hdr.fi = LIBLTE_RLC_FI_FIELD_FULL_SDU;
-        memcpy(&amd.data, sdu, sizeof(LIBLTE_BYTE_MSG_STRUCT));
-        rb->set_rlc_vts(vts+1);
-
-        send_amd_pdu(&amd, user, rb);
-        return;
-    }
+    // The SDU stays in the transmission buffer until MAC pulls a PDU
+    // sized to its grant, see build_pdu
+    rb->rlc_get_tx_buffer_status(&N_bytes, &N_sdus);
 
-    // Segment the message
-    while(byte_idx < sdu->N_bytes)
-    {
-        amd.hdr.dc = LIBLTE_RLC_DC_FIELD_DATA_PDU;
-        amd.hdr.rf = LIBLTE_RLC_RF_FIELD_AMD_PDU;
-        amd.hdr.sn = vts;
-        amd.hdr.p  = LIBLTE_RLC_P_FIELD_STATUS_REPORT_NOT_REQUESTED;
-        amd.hdr.fi = LIBLTE_RLC_FI_FIELD_MIDDLE_SDU_SEGMENT;
-        if(byte_idx == 0)
-            amd.hdr.fi = LIBLTE_RLC_FI_FIELD_FIRST_SDU_SEGMENT;
-        if((sdu->N_bytes - byte_idx) >= bytes_per_subfn)
-        {
-            memcpy(&amd.data.msg[0], &sdu->msg[byte_idx], bytes_per_subfn);
-            amd.data.N_bytes  = bytes_per_subfn;
-            byte_idx         += bytes_per_subfn;
-        }else{
-            memcpy(&amd.data.msg[0], &sdu->msg[byte_idx], sdu->N_bytes - byte_idx);
-            amd.data.N_bytes = sdu->N_bytes - byte_idx;
-            byte_idx         = sdu->N_bytes;
-        }
-        if(byte_idx == sdu->N_bytes)
-        {
-            amd.hdr.fi = LIBLTE_RLC_FI_FIELD_LAST_SDU_SEGMENT;
-            amd.hdr.p  = LIBLTE_RLC_P_FIELD_STATUS_REPORT_REQUESTED;
-        }
-        rb->set_rlc_vts(vts+1);
-        vts = rb->get_rlc_vts();
+    interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
+                              LTE_FDD_ENB_DEBUG_LEVEL_RLC,
+                              __FILE__,
+                              __LINE__,
+                              "Buffered SDU for RNTI=%u, RB=%s, N_sdus=%u, N_bytes=%u",
+                              user->get_c_rnti(),
+                              LTE_fdd_enb_rb_text[rb->get_rb_id()],
+                              N_sdus,
+                              N_bytes);
 
-        send_amd_pdu(&amd, user, rb);
-    }
+    // Let MAC know there is data to schedule
+    send_mac_sdu_ready(user, rb);
 }
 
 /******************************/
@@ -699,54 +660,108 @@ void LTE_fdd_enb_rlc::send_status_pdu(LIBLTE_RLC_STATUS_PDU_STRUCT *status_pdu,
     // Send the PDU to MAC
     send_mac_sdu_ready(user, rb, &mac_sdu);
 }
-void LTE_fdd_enb_rlc::send_amd_pdu(LIBLTE_RLC_SINGLE_AMD_PDU_STRUCT *amd,
-                                   LTE_fdd_enb_user                 *user,
-                                   LTE_fdd_enb_rb                   *rb)
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_rlc::build_umd_pdu(LTE_fdd_enb_user       *user,
+                                                      LTE_fdd_enb_rb         *rb,
+                                                      uint32                  N_bytes,
+                                                      LIBLTE_BYTE_MSG_STRUCT *pdu)
 {
-    LIBLTE_BYTE_MSG_STRUCT pdu;
-    uint16                 vta  = rb->get_rlc_vta();
-    uint16                 vtms = rb->get_rlc_vtms();
+    LTE_FDD_ENB_RLC_SEGMENT_STRUCT   seg;
+    LIBLTE_RLC_UMD_PDU_HEADER_STRUCT hdr;
+    uint16                           vtus = rb->get_rlc_vtus();
+
+    // Concatenate and segment the buffered SDUs to fit N_bytes
+    if(LTE_FDD_ENB_ERROR_NONE != rb->rlc_segment_tx_buffer(N_bytes, &seg))
+        return LTE_FDD_ENB_ERROR_NO_MSG_IN_QUEUE;
 
     // Pack the PDU
-    liblte_rlc_pack_amd_pdu(amd, &amd->data, &pdu);
+    hdr.fi      = seg.fi;
+    hdr.sn_size = LIBLTE_RLC_UMD_SN_SIZE_10_BITS;
+    hdr.sn      = vtus;
+    rb->set_rlc_vtus(vtus+1);
+    liblte_rlc_pack_umd_pdu_header(&hdr, seg.li, seg.N_data, pdu);
+    rb->rlc_read_tx_buffer(&seg, pdu);
 
-    // Store
-    rb->rlc_add_to_transmission_buffer(amd);
+    interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
+                              LTE_FDD_ENB_DEBUG_LEVEL_RLC,
+                              __FILE__,
+                              __LINE__,
+                              "Sending UMD PDU for RNTI=%u, RB=%s, SN=%u, FI=%s, N_data=%u, N_bytes=%u",
+                              user->get_c_rnti(),
+                              LTE_fdd_enb_rb_text[rb->get_rb_id()],
+                              hdr.sn,
+                              liblte_rlc_fi_field_text[hdr.fi],
+                              seg.N_data,
+                              pdu->N_bytes);
 
-    // Start t-pollretransmit
-    rb->rlc_start_t_poll_retransmit();
+    return LTE_FDD_ENB_ERROR_NONE;
+}
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_rlc::build_amd_pdu(LTE_fdd_enb_user       *user,
+                                                      LTE_fdd_enb_rb         *rb,
+                                                      uint32                  N_bytes,
+                                                      LIBLTE_BYTE_MSG_STRUCT *pdu)
+{
+    LTE_FDD_ENB_RLC_SEGMENT_STRUCT   seg;
+    LIBLTE_RLC_SINGLE_AMD_PDU_STRUCT amd;
+    uint16                           vta  = rb->get_rlc_vta();
+    uint16                           vtms = rb->get_rlc_vtms();
+    uint16                           vts  = rb->get_rlc_vts();
 
-    if(vta         <= amd->hdr.sn &&
-       amd->hdr.sn <  vtms)
+    // Hold new data back while the transmit window is full
+    if(!liblte_rlc_am_sn_in_tx_window(vts, vta))
     {
         interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
                                   LTE_FDD_ENB_DEBUG_LEVEL_RLC,
                                   __FILE__,
                                   __LINE__,
-                                  "Sending AMD PDU for RNTI=%u, RB=%s, VT(A)=%u, SN=%u, VT(MS)=%u, RF=%s, P=%s, FI=%s",
+                                  "Can't build AMD PDU for RNTI=%u, RB=%s, outside of transmit window (%u <= %u < %u)",
                                   user->get_c_rnti(),
                                   LTE_fdd_enb_rb_text[rb->get_rb_id()],
                                   vta,
-                                  amd->hdr.sn,
-                                  vtms,
-                                  liblte_rlc_rf_field_text[amd->hdr.rf],
-                                  liblte_rlc_p_field_text[amd->hdr.p],
-                                  liblte_rlc_fi_field_text[amd->hdr.fi]);
-
-        // Send the PDU to MAC
-        send_mac_sdu_ready(user, rb, &pdu);
-        return;
+                                  vts,
+                                  vtms);
+        return LTE_FDD_ENB_ERROR_CANT_SCHEDULE;
     }
 
+    // Concatenate and segment the buffered SDUs to fit N_bytes
+    if(LTE_FDD_ENB_ERROR_NONE != rb->rlc_segment_tx_buffer(N_bytes, &seg))
+        return LTE_FDD_ENB_ERROR_NO_MSG_IN_QUEUE;
+
+    // Pack the PDU, polling whenever it completes an SDU
+    amd.hdr.dc = LIBLTE_RLC_DC_FIELD_DATA_PDU;
+    amd.hdr.rf = LIBLTE_RLC_RF_FIELD_AMD_PDU;
+    amd.hdr.sn = vts;
+    amd.hdr.p  = LIBLTE_RLC_P_FIELD_STATUS_REPORT_REQUESTED;
+    amd.hdr.fi = seg.fi;
+    if(LIBLTE_RLC_FI_FIELD_FIRST_SDU_SEGMENT  == seg.fi ||
+       LIBLTE_RLC_FI_FIELD_MIDDLE_SDU_SEGMENT == seg.fi)
+        amd.hdr.p = LIBLTE_RLC_P_FIELD_STATUS_REPORT_NOT_REQUESTED;
+    rb->set_rlc_vts(vts+1);
+    liblte_rlc_pack_amd_pdu_header(&amd.hdr, seg.li, seg.N_data, pdu);
+    rb->rlc_read_tx_buffer(&seg, pdu);
+
+    // Store the packed PDU, a retransmission repeats the same LI fields
+    amd.data.N_bytes = pdu->N_bytes;
+    memcpy(amd.data.msg, pdu->msg, pdu->N_bytes);
+    rb->rlc_add_to_transmission_buffer(&amd);
+
+    // Start t-pollretransmit
+    rb->rlc_start_t_poll_retransmit();
+
     interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
                               LTE_FDD_ENB_DEBUG_LEVEL_RLC,
                               __FILE__,
                               __LINE__,
-                              &pdu,
-                              "Can't send AMD PDU for RNTI=%u, RB=%s, outside of transmit window (%u <= %u < %u)",
+                              "Sending AMD PDU for RNTI=%u, RB=%s, VT(A)=%u, SN=%u, VT(MS)=%u, RF=%s, P=%s, FI=%s, N_data=%u, N_bytes=%u",
                               user->get_c_rnti(),
                               LTE_fdd_enb_rb_text[rb->get_rb_id()],
                               vta,
-                              amd->hdr.sn,
-                              vtms);
+                              amd.hdr.sn,
+                              vtms,
+                              liblte_rlc_rf_field_text[amd.hdr.rf],
+                              liblte_rlc_p_field_text[amd.hdr.p],
+                              liblte_rlc_fi_field_text[amd.hdr.fi],
+                              seg.N_data,
+                              pdu->N_bytes);
+
+    return LTE_FDD_ENB_ERROR_NONE;
 }
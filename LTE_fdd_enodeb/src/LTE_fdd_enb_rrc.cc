@@ -184,6 +184,13 @@ void LTE_fdd_enb_rrc::handle_mme_msg(LTE_FDD_ENB_MESSAGE_STRUCT &msg)
 void LTE_fdd_enb_rrc::send_pdcp_sdu_ready(LTE_fdd_enb_user     *user,
                                           LTE_fdd_enb_rb       *rb,
                                           std::vector<uint8_t> &sdu)
+{
+    send_pdcp_sdu_ready(user, rb, sdu, false);
+}
+void LTE_fdd_enb_rrc::send_pdcp_sdu_ready(LTE_fdd_enb_user     *user,
+                                          LTE_fdd_enb_rb       *rb,
+                                          std::vector<uint8_t> &sdu,
+                                          bool                  activate_security)
 {
     LTE_FDD_ENB_PDCP_SDU_READY_MSG_STRUCT sdu_ready;
 
@@ -198,8 +205,9 @@ void LTE_fdd_enb_rrc::send_pdcp_sdu_ready(LTE_fdd_enb_user     *user,
                               user->get_c_rnti(),
                               LTE_fdd_enb_rb_text[rb->get_rb_id()]);
 
-    sdu_ready.user = user;
-    sdu_ready.rb   = rb;
+    sdu_ready.user              = user;
+    sdu_ready.rb                = rb;
+    sdu_ready.activate_security = activate_security;
     msgq_to_pdcp->send(LTE_FDD_ENB_MESSAGE_TYPE_PDCP_SDU_READY,
                        LTE_FDD_ENB_DEST_LAYER_PDCP,
                        (LTE_FDD_ENB_MESSAGE_UNION *)&sdu_ready,
@@ -363,12 +371,16 @@ void LTE_fdd_enb_rrc::handle_cmd(LTE_FDD_ENB_RRC_CMD_READY_MSG_STRUCT *cmd)
         srb2->set_mme_procedure(cmd->rb->get_mme_procedure());
         srb2->set_mme_state(cmd->rb->get_mme_state());
         srb2->set_pdcp_config(cmd->rb->get_pdcp_config());
+        srb2->set_pdcp_dl_ciphering(cmd->rb->get_pdcp_dl_ciphering());
+        srb2->set_pdcp_ul_ciphering(cmd->rb->get_pdcp_ul_ciphering());
 
         // Configure DRB1
         drb1->set_eps_bearer_id(cmd->user->get_eps_bearer_id());
         drb1->set_drb_id(1);
         drb1->set_lc_id(3);
         drb1->set_log_chan_group(2);
+        drb1->set_pdcp_dl_ciphering(cmd->rb->get_pdcp_dl_ciphering());
+        drb1->set_pdcp_ul_ciphering(cmd->rb->get_pdcp_ul_ciphering());
 
         if(LTE_FDD_ENB_ERROR_NONE == cmd->rb->get_next_rrc_nas_msg(&msg))
         {
@@ -397,18 +409,24 @@ void LTE_fdd_enb_rrc::handle_cmd(LTE_FDD_ENB_RRC_CMD_READY_MSG_STRUCT *cmd)
         srb2->set_mme_procedure(cmd->rb->get_mme_procedure());
         srb2->set_mme_state(cmd->rb->get_mme_state());
         srb2->set_pdcp_config(cmd->rb->get_pdcp_config());
+        srb2->set_pdcp_dl_ciphering(cmd->rb->get_pdcp_dl_ciphering());
+        srb2->set_pdcp_ul_ciphering(cmd->rb->get_pdcp_ul_ciphering());
 
         // Configure DRB1
         drb1->set_eps_bearer_id(cmd->user->get_eps_bearer_id());
         drb1->set_drb_id(1);
         drb1->set_lc_id(3);
         drb1->set_log_chan_group(2);
+        drb1->set_pdcp_dl_ciphering(cmd->rb->get_pdcp_dl_ciphering());
+        drb1->set_pdcp_ul_ciphering(cmd->rb->get_pdcp_ul_ciphering());
 
         // Configure DRB2
         drb2->set_eps_bearer_id(cmd->user->get_eps_bearer_id()+1);
         drb2->set_drb_id(2);
         drb2->set_lc_id(4);
         drb2->set_log_chan_group(3);
+        drb2->set_pdcp_dl_ciphering(cmd->rb->get_pdcp_dl_ciphering());
+        drb2->set_pdcp_ul_ciphering(cmd->rb->get_pdcp_ul_ciphering());
 
         if(LTE_FDD_ENB_ERROR_NONE == cmd->rb->get_next_rrc_nas_msg(&msg))
         {
@@ -725,6 +743,9 @@ void LTE_fdd_enb_rrc::parse_ul_dcch_message(std::vector<uint8_t> &msg,
         send_mme_nas_msg_ready(user, rb, ul_dcch.message_Get().c1_ulInformationTransfer_Get().criticalExtensions_c1_ulInformationTransfer_r8_Get().dedicatedInfoType_dedicatedInfoNAS_Get().Value());
         break;
     case UL_DCCH_MessageType::k_c1_securityModeComplete:
+        // Security Mode Complete is the last unciphered uplink message
+        rb->set_pdcp_ul_ciphering(true);
+
         // Signal MME
         cmd_resp.user     = user;
         cmd_resp.rb       = rb;
@@ -916,7 +937,7 @@ void LTE_fdd_enb_rrc::send_rrc_con_reest(LTE_fdd_enb_user *user,
     rrc_con_reest.radioResourceConfigDedicated_Set()->drb_ToReleaseList_Clear();
     rrc_con_reest.radioResourceConfigDedicated_Set()->mac_MainConfig_SetChoice(RadioResourceConfigDedicated::k_mac_MainConfig_explicitValue);
     rrc_con_reest.radioResourceConfigDedicated_Set()->mac_MainConfig_explicitValue_Set()->ul_SCH_Config_value.SetPresence(true);
-    rrc_con_reest.radioResourceConfigDedicated_Set()->mac_MainConfig_explicitValue_Set()->ul_SCH_Config_value.maxHARQ_Tx_SetValue(MAC_MainConfig::ul_SCH_Config::k_maxHARQ_Tx_n1);
+    rrc_con_reest.radioResourceConfigDedicated_Set()->mac_MainConfig_explicitValue_Set()->ul_SCH_Config_value.maxHARQ_Tx_SetValue(MAC_MainConfig::ul_SCH_Config::k_maxHARQ_Tx_n4);
     rrc_con_reest.radioResourceConfigDedicated_Set()->mac_MainConfig_explicitValue_Set()->ul_SCH_Config_value.periodicBSR_Timer_Clear();
     rrc_con_reest.radioResourceConfigDedicated_Set()->mac_MainConfig_explicitValue_Set()->ul_SCH_Config_value.retxBSR_Timer_SetValue(MAC_MainConfig::ul_SCH_Config::k_retxBSR_Timer_sf1280);
     rrc_con_reest.radioResourceConfigDedicated_Set()->mac_MainConfig_explicitValue_Set()->ul_SCH_Config_value.ttiBundling_SetValue(false);
@@ -1015,7 +1036,7 @@ void LTE_fdd_enb_rrc::send_rrc_con_setup(LTE_fdd_enb_user *user,
     dl_ccch.message_Set()->c1_rrcConnectionSetup_Set()->criticalExtensions_c1_rrcConnectionSetup_r8_Set()->radioResourceConfigDedicated_Set()->drb_ToReleaseList_Clear();
     dl_ccch.message_Set()->c1_rrcConnectionSetup_Set()->criticalExtensions_c1_rrcConnectionSetup_r8_Set()->radioResourceConfigDedicated_Set()->mac_MainConfig_SetChoice(RadioResourceConfigDedicated::k_mac_MainConfig_explicitValue);
     dl_ccch.message_Set()->c1_rrcConnectionSetup_Set()->criticalExtensions_c1_rrcConnectionSetup_r8_Set()->radioResourceConfigDedicated_Set()->mac_MainConfig_explicitValue_Set()->ul_SCH_Config_value.SetPresence(true);
-    dl_ccch.message_Set()->c1_rrcConnectionSetup_Set()->criticalExtensions_c1_rrcConnectionSetup_r8_Set()->radioResourceConfigDedicated_Set()->mac_MainConfig_explicitValue_Set()->ul_SCH_Config_value.maxHARQ_Tx_SetValue(MAC_MainConfig::ul_SCH_Config::k_maxHARQ_Tx_n1);
+    dl_ccch.message_Set()->c1_rrcConnectionSetup_Set()->criticalExtensions_c1_rrcConnectionSetup_r8_Set()->radioResourceConfigDedicated_Set()->mac_MainConfig_explicitValue_Set()->ul_SCH_Config_value.maxHARQ_Tx_SetValue(MAC_MainConfig::ul_SCH_Config::k_maxHARQ_Tx_n4);
     dl_ccch.message_Set()->c1_rrcConnectionSetup_Set()->criticalExtensions_c1_rrcConnectionSetup_r8_Set()->radioResourceConfigDedicated_Set()->mac_MainConfig_explicitValue_Set()->ul_SCH_Config_value.periodicBSR_Timer_Clear();
     dl_ccch.message_Set()->c1_rrcConnectionSetup_Set()->criticalExtensions_c1_rrcConnectionSetup_r8_Set()->radioResourceConfigDedicated_Set()->mac_MainConfig_explicitValue_Set()->ul_SCH_Config_value.retxBSR_Timer_SetValue(MAC_MainConfig::ul_SCH_Config::k_retxBSR_Timer_sf1280);
     dl_ccch.message_Set()->c1_rrcConnectionSetup_Set()->criticalExtensions_c1_rrcConnectionSetup_r8_Set()->radioResourceConfigDedicated_Set()->mac_MainConfig_explicitValue_Set()->ul_SCH_Config_value.ttiBundling_SetValue(false);
@@ -1049,14 +1070,60 @@ void LTE_fdd_enb_rrc::send_rrc_con_setup(LTE_fdd_enb_user *user,
 void LTE_fdd_enb_rrc::send_security_mode_command(LTE_fdd_enb_user *user,
                                                  LTE_fdd_enb_rb   *rb)
 {
-    DL_DCCH_Message dl_dcch;
+    LTE_FDD_ENB_AUTHENTICATION_VECTOR_STRUCT *auth_vec = user->get_auth_vec();
+    DL_DCCH_Message                           dl_dcch;
+    uint32                                    i;
+
+    // Select the AS algorithms, 128-EEA2 is only preferred when AES runs
+    // in hardware as the software AES is far slower than SNOW 3G
+    LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_ENUM eea_pref[3] = {LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA1,
+                                                               LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA3,
+                                                               LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA2};
+    if(liblte_security_aes_hw_accelerated())
+    {
+        eea_pref[0] = LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA2;
+        eea_pref[1] = LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA1;
+        eea_pref[2] = LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA3;
+    }
+    auth_vec->eea = LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_EEA0;
+    for(i=0; i<3; i++)
+    {
+        if(user->get_eea_support(eea_pref[i]))
+        {
+            auth_vec->eea = eea_pref[i];
+            break;
+        }
+    }
+    if(!user->get_eia_support(LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA2) &&
+       user->get_eia_support(LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA1))
+    {
+        auth_vec->eia = LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA1;
+    }else if(!user->get_eia_support(LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA2) &&
+             user->get_eia_support(LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA3)){
+        auth_vec->eia = LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA3;
+    }else{
+        auth_vec->eia = LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA2;
+    }
+
+    // Derive the AS keys for the selected algorithms
+    liblte_security_generate_k_rrc(auth_vec->k_enb,
+                                   auth_vec->eea,
+                                   auth_vec->eia,
+                                   auth_vec->k_rrc_enc,
+                                   auth_vec->k_rrc_int);
+    liblte_security_generate_k_up(auth_vec->k_enb,
+                                  auth_vec->eea,
+                                  auth_vec->eia,
+                                  auth_vec->k_up_enc,
+                                  auth_vec->k_up_int);
+
     dl_dcch.message_Set()->SetChoice(DL_DCCH_MessageType::k_c1);
     dl_dcch.message_Set()->c1_SetChoice(DL_DCCH_MessageType::k_c1_securityModeCommand);
     dl_dcch.message_Set()->c1_securityModeCommand_Set()->rrc_TransactionIdentifier_Set()->SetValue(rb->get_rrc_transaction_id());
     dl_dcch.message_Set()->c1_securityModeCommand_Set()->criticalExtensions_SetChoice(SecurityModeCommand::k_criticalExtensions_c1);
     dl_dcch.message_Set()->c1_securityModeCommand_Set()->criticalExtensions_c1_SetChoice(SecurityModeCommand::k_criticalExtensions_c1_securityModeCommand_r8);
-    dl_dcch.message_Set()->c1_securityModeCommand_Set()->criticalExtensions_c1_securityModeCommand_r8_Set()->securityConfigSMC_Set()->securityAlgorithmConfig_Set()->cipheringAlgorithm_SetValue(SecurityAlgorithmConfig::k_cipheringAlgorithm_eea0);
-    dl_dcch.message_Set()->c1_securityModeCommand_Set()->criticalExtensions_c1_securityModeCommand_r8_Set()->securityConfigSMC_Set()->securityAlgorithmConfig_Set()->integrityProtAlgorithm_SetValue(SecurityAlgorithmConfig::k_integrityProtAlgorithm_eia2);
+    dl_dcch.message_Set()->c1_securityModeCommand_Set()->criticalExtensions_c1_securityModeCommand_r8_Set()->securityConfigSMC_Set()->securityAlgorithmConfig_Set()->cipheringAlgorithm_SetValue((SecurityAlgorithmConfig::cipheringAlgorithm_Enum)auth_vec->eea);
+    dl_dcch.message_Set()->c1_securityModeCommand_Set()->criticalExtensions_c1_securityModeCommand_r8_Set()->securityConfigSMC_Set()->securityAlgorithmConfig_Set()->integrityProtAlgorithm_SetValue((SecurityAlgorithmConfig::integrityProtAlgorithm_Enum)auth_vec->eia);
     dl_dcch.message_Set()->c1_securityModeCommand_Set()->criticalExtensions_c1_securityModeCommand_r8_Set()->nonCriticalExtension_Clear();
     liblte_full_stack_message fsm;
     dl_dcch.Pack(fsm.rrc);
@@ -1064,15 +1131,14 @@ void LTE_fdd_enb_rrc::send_security_mode_command(LTE_fdd_enb_user *user,
                               LTE_FDD_ENB_DEBUG_LEVEL_RRC,
                               __FILE__,
                               __LINE__,
-                              "Sending Security Mode Command for RNTI=%u, RB=%s",
+                              "Sending Security Mode Command (%s, %s) for RNTI=%u, RB=%s",
+                              liblte_security_ciphering_algorithm_id_text[auth_vec->eea],
+                              liblte_security_integrity_algorithm_id_text[auth_vec->eia],
                               user->get_c_rnti(),
                               LTE_fdd_enb_rb_text[rb->get_rb_id()]);
 
-    // Configure PDCP for security
-    rb->set_pdcp_config(LTE_FDD_ENB_PDCP_CONFIG_SECURITY);
-
-    // Send the PDU to PDCP
-    send_pdcp_sdu_ready(user, rb, fsm.rrc);
+    // Send the PDU to PDCP, which activates security with it
+    send_pdcp_sdu_ready(user, rb, fsm.rrc, true);
 }
 void LTE_fdd_enb_rrc::send_ue_capability_enquiry(LTE_fdd_enb_user *user,
                                                  LTE_fdd_enb_rb   *rb)
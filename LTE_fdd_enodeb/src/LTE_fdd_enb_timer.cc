@@ -77,10 +77,9 @@ void LTE_fdd_enb_timer_cb::operator()(uint32 id)
 /********************************/
 /*    Constructor/Destructor    */
 /********************************/
-LTE_fdd_enb_timer::LTE_fdd_enb_timer(uint32               m_seconds,
-                                     uint32               _id,
-                                     LTE_fdd_enb_timer_cb _cb) :
-    cb{_cb}, id{_id}, expiry_m_seconds{m_seconds}, current_m_seconds{0}
+LTE_fdd_enb_timer::LTE_fdd_enb_timer() :
+    prev{0}, next{0}, wheel_idx{0}, generation{0}, in_use{false}, id{0},
+    expiry_m_seconds{0}, expiry_tick{0}
 {
 }
 LTE_fdd_enb_timer::~LTE_fdd_enb_timer()
@@ -90,22 +89,36 @@ LTE_fdd_enb_timer::~LTE_fdd_enb_timer()
 /****************************/
 /*    External Interface    */
 /****************************/
-void LTE_fdd_enb_timer::reset()
+void LTE_fdd_enb_timer::start(uint32               m_seconds,
+                              uint32               _id,
+                              LTE_fdd_enb_timer_cb _cb,
+                              uint64               current_tick)
 {
-    current_m_seconds = 0;
+    cb               = _cb;
+    id               = _id;
+    expiry_m_seconds = m_seconds;
+    reset(current_tick);
 }
-void LTE_fdd_enb_timer::increment()
+void LTE_fdd_enb_timer::reset(uint64 current_tick)
 {
-    current_m_seconds++;
+    // Expires on the tick after m_seconds ticks have elapsed
+    expiry_tick = current_tick + expiry_m_seconds + 1;
 }
-bool LTE_fdd_enb_timer::expired()
+bool LTE_fdd_enb_timer::expired(uint64 current_tick)
 {
-    if(current_m_seconds > expiry_m_seconds)
+    if(current_tick >= expiry_tick)
         return true;
     return false;
 }
+uint64 LTE_fdd_enb_timer::get_expiry_tick()
+{
+    return expiry_tick;
+}
+uint32 LTE_fdd_enb_timer::get_id()
+{
+    return id;
+}
 void LTE_fdd_enb_timer::call_callback()
 {
-    if(expired())
-        cb(id);
+    cb(id);
 }
@@ -43,7 +43,6 @@
 
 #include "LTE_fdd_enb_timer_mgr.h"
 #include "LTE_fdd_enb_user_mgr.h"
-#include <list>
 
 /*******************************************************************************
                               DEFINES
@@ -68,14 +67,14 @@
 /*    Constructor/Destructor    */
 /********************************/
 LTE_fdd_enb_timer_mgr::LTE_fdd_enb_timer_mgr(LTE_fdd_enb_interface *iface) :
-    interface{iface}, started{false}
+    interface{iface}, started{false}, free_timer_idx{LTE_FDD_ENB_TIMER_NULL_IDX}, current_tick{0}
 {
+    for(uint32 i=0; i<LTE_FDD_ENB_TIMER_WHEEL_N_LEVELS; i++)
+        for(uint32 j=0; j<LTE_FDD_ENB_TIMER_WHEEL_N_SLOTS; j++)
+            timer_wheel[i][j] = LTE_FDD_ENB_TIMER_NULL_IDX;
 }
 LTE_fdd_enb_timer_mgr::~LTE_fdd_enb_timer_mgr()
 {
-    std::lock_guard<std::mutex> lock(timer_mutex);
-    for(auto timer : timer_map)
-        delete timer.second;
 }
 
 /********************/
@@ -90,7 +89,6 @@ void LTE_fdd_enb_timer_mgr::start(LTE_fdd_enb_msgq *from_mac)
         return;
 
     started       = true;
-    next_timer_id = 0;
     msgq_from_mac = from_mac;
     msgq_from_mac->attach_rx(timer_cb);
 }
@@ -109,49 +107,50 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_timer_mgr::start_timer(uint32
                                                           LTE_fdd_enb_timer_cb  cb,
                                                           uint32               *timer_id)
 {
-    std::lock_guard<std::mutex>  lock(timer_mutex);
-    auto                         timer_it  = timer_map.find(next_timer_id);
-    LTE_fdd_enb_timer           *new_timer = NULL;
-    LTE_FDD_ENB_ERROR_ENUM       err       = LTE_FDD_ENB_ERROR_BAD_ALLOC;
-
-    while(timer_map.end()              != timer_it &&
-          LTE_FDD_ENB_INVALID_TIMER_ID != next_timer_id)
-    {
-        next_timer_id++;
-        timer_it = timer_map.find(next_timer_id);
-    }
-    new_timer = new LTE_fdd_enb_timer(m_seconds, next_timer_id, cb);
+    std::lock_guard<std::mutex> lock(timer_mutex);
+    uint32                      idx = free_timer_idx;
 
-    if(NULL != new_timer)
+    if(LTE_FDD_ENB_TIMER_NULL_IDX == idx)
     {
-        *timer_id                  = next_timer_id;
-        timer_map[next_timer_id++] = new_timer;
-        err                        = LTE_FDD_ENB_ERROR_NONE;
+        if(LTE_FDD_ENB_TIMER_POOL_MAX_SIZE <= timer_pool.size())
+            return LTE_FDD_ENB_ERROR_BAD_ALLOC;
+        timer_pool.emplace_back();
+        idx = timer_pool.size() - 1;
+    }else{
+        free_timer_idx = timer_pool[idx].next;
     }
 
-    return err;
+    timer_pool[idx].in_use = true;
+    *timer_id              = ((uint32)timer_pool[idx].generation << 16) | idx;
+    timer_pool[idx].start(m_seconds, *timer_id, cb, current_tick);
+    wheel_insert(idx);
+    return LTE_FDD_ENB_ERROR_NONE;
 }
 LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_timer_mgr::stop_timer(uint32 timer_id)
 {
-    std::lock_guard<std::mutex> lock(timer_mutex);
-    auto                        timer_it = timer_map.find(timer_id);
+    std::lock_guard<std::mutex>  lock(timer_mutex);
+    LTE_fdd_enb_timer           *timer = find_timer(timer_id);
 
-    if(timer_map.end() == timer_it)
+    if(NULL == timer)
         return LTE_FDD_ENB_ERROR_TIMER_NOT_FOUND;
 
-    delete (*timer_it).second;
-    timer_map.erase(timer_it);
+    if(LTE_FDD_ENB_TIMER_NULL_WHEEL != timer->wheel_idx)
+        wheel_remove(timer_id & 0xFFFF);
+    free_timer(timer_id & 0xFFFF);
     return LTE_FDD_ENB_ERROR_NONE;
 }
 LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_timer_mgr::reset_timer(uint32 timer_id)
 {
-    std::lock_guard<std::mutex> lock(timer_mutex);
-    auto                        timer_it = timer_map.find(timer_id);
+    std::lock_guard<std::mutex>  lock(timer_mutex);
+    LTE_fdd_enb_timer           *timer = find_timer(timer_id);
 
-    if(timer_map.end() == timer_it)
+    if(NULL == timer)
         return LTE_FDD_ENB_ERROR_TIMER_NOT_FOUND;
 
-    (*timer_it).second->reset();
+    if(LTE_FDD_ENB_TIMER_NULL_WHEEL != timer->wheel_idx)
+        wheel_remove(timer_id & 0xFFFF);
+    timer->reset(current_tick);
+    wheel_insert(timer_id & 0xFFFF);
     return LTE_FDD_ENB_ERROR_NONE;
 }
 
@@ -188,30 +187,123 @@ void LTE_fdd_enb_timer_mgr::handle_msg(LTE_FDD_ENB_MESSAGE_STRUCT &msg)
 }
 void LTE_fdd_enb_timer_mgr::handle_tick()
 {
-    std::list<uint32> expired_list;
+    uint32 idx;
+    uint32 next;
+    uint32 slot;
 
     timer_mutex.lock();
-    for(auto timer : timer_map)
+    current_tick++;
+
+    // Move timers down a level each time the level below wraps
+    for(uint32 level=1; level<LTE_FDD_ENB_TIMER_WHEEL_N_LEVELS; level++)
     {
-        timer.second->increment();
+        if(0 != (current_tick & ((1ULL << (LTE_FDD_ENB_TIMER_WHEEL_N_SLOT_BITS*level)) - 1)))
+            break;
+        slot                     = (current_tick >> (LTE_FDD_ENB_TIMER_WHEEL_N_SLOT_BITS*level)) & (LTE_FDD_ENB_TIMER_WHEEL_N_SLOTS - 1);
+        idx                      = timer_wheel[level][slot];
+        timer_wheel[level][slot] = LTE_FDD_ENB_TIMER_NULL_IDX;
+        while(LTE_FDD_ENB_TIMER_NULL_IDX != idx)
+        {
+            next                       = timer_pool[idx].next;
+            timer_pool[idx].wheel_idx  = LTE_FDD_ENB_TIMER_NULL_WHEEL;
+            wheel_insert(idx);
+            idx = next;
+        }
+    }
 
-        if(timer.second->expired())
+    // Collect expired timers
+    expired_timer_ids.clear();
+    slot                 = current_tick & (LTE_FDD_ENB_TIMER_WHEEL_N_SLOTS - 1);
+    idx                  = timer_wheel[0][slot];
+    timer_wheel[0][slot] = LTE_FDD_ENB_TIMER_NULL_IDX;
+    while(LTE_FDD_ENB_TIMER_NULL_IDX != idx)
+    {
+        next                      = timer_pool[idx].next;
+        timer_pool[idx].wheel_idx = LTE_FDD_ENB_TIMER_NULL_WHEEL;
+        if(timer_pool[idx].expired(current_tick))
         {
-            expired_list.push_back(timer.first);
+            expired_timer_ids.push_back(timer_pool[idx].get_id());
+        }else{
+            wheel_insert(idx);
         }
+        idx = next;
     }
     timer_mutex.unlock();
 
-    // Delete expired timers
-    while(0 != expired_list.size())
+    // Call the callbacks without the lock held, skipping any timer that
+    // was stopped or reset since it was collected
+    for(auto timer_id : expired_timer_ids)
     {
-        auto timer_it = timer_map.find(expired_list.front());
-        if(timer_map.end() != timer_it)
+        timer_mutex.lock();
+        LTE_fdd_enb_timer *timer = find_timer(timer_id);
+        if(NULL == timer ||
+           LTE_FDD_ENB_TIMER_NULL_WHEEL != timer->wheel_idx)
         {
-            (*timer_it).second->call_callback();
-            delete (*timer_it).second;
-            timer_map.erase(timer_it);
+            timer_mutex.unlock();
+            continue;
         }
-        expired_list.pop_front();
+        LTE_fdd_enb_timer expired_timer = *timer;
+        free_timer(timer_id & 0xFFFF);
+        timer_mutex.unlock();
+
+        expired_timer.call_callback();
+    }
+}
+
+/***********************/
+/*    Timer Storage    */
+/***********************/
+LTE_fdd_enb_timer* LTE_fdd_enb_timer_mgr::find_timer(uint32 timer_id)
+{
+    uint32 idx = timer_id & 0xFFFF;
+
+    if(idx >= timer_pool.size()          ||
+       !timer_pool[idx].in_use            ||
+       timer_pool[idx].generation != (timer_id >> 16))
+        return NULL;
+
+    return &timer_pool[idx];
+}
+void LTE_fdd_enb_timer_mgr::wheel_insert(uint32 idx)
+{
+    LTE_fdd_enb_timer *timer       = &timer_pool[idx];
+    uint64             expiry_tick = timer->get_expiry_tick();
+    uint64             delta       = expiry_tick - current_tick;
+    uint32             level       = 0;
+    uint32             slot;
+
+    while(level < (LTE_FDD_ENB_TIMER_WHEEL_N_LEVELS - 1) &&
+          delta >= (1ULL << (LTE_FDD_ENB_TIMER_WHEEL_N_SLOT_BITS*(level+1))))
+        level++;
+    slot = (expiry_tick >> (LTE_FDD_ENB_TIMER_WHEEL_N_SLOT_BITS*level)) & (LTE_FDD_ENB_TIMER_WHEEL_N_SLOTS - 1);
+
+    timer->prev      = LTE_FDD_ENB_TIMER_NULL_IDX;
+    timer->next      = timer_wheel[level][slot];
+    timer->wheel_idx = level*LTE_FDD_ENB_TIMER_WHEEL_N_SLOTS + slot;
+    if(LTE_FDD_ENB_TIMER_NULL_IDX != timer->next)
+        timer_pool[timer->next].prev = idx;
+    timer_wheel[level][slot] = idx;
+}
+void LTE_fdd_enb_timer_mgr::wheel_remove(uint32 idx)
+{
+    LTE_fdd_enb_timer *timer = &timer_pool[idx];
+    uint32             level = timer->wheel_idx / LTE_FDD_ENB_TIMER_WHEEL_N_SLOTS;
+    uint32             slot  = timer->wheel_idx % LTE_FDD_ENB_TIMER_WHEEL_N_SLOTS;
+
+    if(LTE_FDD_ENB_TIMER_NULL_IDX != timer->prev)
+    {
+        timer_pool[timer->prev].next = timer->next;
+    }else{
+        timer_wheel[level][slot] = timer->next;
     }
+    if(LTE_FDD_ENB_TIMER_NULL_IDX != timer->next)
+        timer_pool[timer->next].prev = timer->prev;
+    timer->wheel_idx = LTE_FDD_ENB_TIMER_NULL_WHEEL;
+}
+void LTE_fdd_enb_timer_mgr::free_timer(uint32 idx)
+{
+    timer_pool[idx].in_use = false;
+    timer_pool[idx].generation++;
+    timer_pool[idx].next   = free_timer_idx;
+    free_timer_idx         = idx;
 }
@@ -95,8 +95,11 @@ LTE_fdd_enb_user::LTE_fdd_enb_user(LTE_fdd_enb_interface *iface,
     auth_vec_set{false}, uea_set{false}, uia_set{false}, gea_set{false}, srb1{NULL},
     srb2{NULL}, emm_cause{LIBLTE_MME_EMM_CAUSE_ROAMING_NOT_ALLOWED_IN_THIS_TRACKING_AREA},
     attach_type{0}, pdn_type{0}, eps_bearer_id{0}, proc_transaction_id{0}, eit_flag{false},
-    ul_buffer_size{0}, harq_process{0}, mcs{0}, interface{iface}, timer_mgr{tm}, rrc{_rrc},
-    rlc{_rlc}, N_del_ticks{0}, inactivity_timer_id{LTE_FDD_ENB_INVALID_TIMER_ID}
+    ul_buffer_size{0}, ta_command_tti{0}, dl_last_tti{0}, dl_avg_thruput{0},
+    dl_mcs_olla{0}, ul_last_tti{0}, ul_avg_thruput{0}, ul_sinr_db{0}, ul_olla_db{0},
+    next_harq_process{0}, mcs{0}, interface{iface},
+    timer_mgr{tm}, rrc{_rrc}, rlc{_rlc}, N_del_ticks{0},
+    inactivity_timer_id{LTE_FDD_ENB_INVALID_TIMER_ID}, user_seq{0}
 {
     uint32 i;
 
@@ -121,19 +124,19 @@ LTE_fdd_enb_user::LTE_fdd_enb_user(LTE_fdd_enb_interface *iface,
     protocol_cnfg_opts.N_opts = 0;
 
     // MAC
-    harq_buffer.clear();
+    for(i=0; i<LTE_FDD_ENB_USER_N_HARQ_PROCESSES; i++)
+    {
+        dl_harq[i].ndi         = false;
+        dl_harq[i].active      = false;
+        ul_harq[i].soft_buffer = NULL;
+        ul_harq[i].ndi         = false;
+        ul_harq[i].active      = false;
+    }
 }
 LTE_fdd_enb_user::~LTE_fdd_enb_user()
 {
     uint32 i;
 
-    // MAC
-    harq_buffer_mutex.lock();
-    for(auto harq_msg : harq_buffer)
-    {
-        delete harq_msg.second;
-    }
-
     // Radio Bearers
     for(i=0; i<8; i++)
     {
@@ -178,8 +181,23 @@ void LTE_fdd_enb_user::init()
     protocol_cnfg_opts.N_opts = 0;
 
     // MAC
-    harq_process = 0;
-    mcs          = 0;
+    ta_command_tti    = 0;
+    dl_last_tti       = 0;
+    dl_avg_thruput    = 0;
+    dl_mcs_olla       = 0;
+    ul_last_tti       = 0;
+    ul_avg_thruput    = 0;
+    ul_sinr_db        = 0;
+    ul_olla_db        = 0;
+    next_harq_process = 0;
+    mcs               = 0;
+    harq_mutex.lock();
+    for(i=0; i<LTE_FDD_ENB_USER_N_HARQ_PROCESSES; i++)
+    {
+        dl_harq[i].active = false;
+        ul_harq[i].active = false;
+    }
+    harq_mutex.unlock();
 
     // Identity
     c_rnti     = 0xFFFF;
@@ -580,79 +598,200 @@ LIBLTE_MME_PROTOCOL_CONFIG_OPTIONS_STRUCT* LTE_fdd_enb_user::get_protocol_cnfg_o
 /*************/
 /*    MAC    */
 /*************/
-uint8 LTE_fdd_enb_user::get_harq_process()
-{
-    return harq_process;
-}
-void LTE_fdd_enb_user::increment_harq_process()
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user::get_free_harq_process(uint8 *harq_process,
+                                                               bool  *ndi)
 {
-    harq_process = (harq_process + 1) % 8;
+    std::lock_guard<std::mutex> lock(harq_mutex);
+
+    // Round robin over the processes that are not waiting for feedback
+    for(uint32 i=0; i<LTE_FDD_ENB_USER_N_HARQ_PROCESSES; i++)
+    {
+        uint8 id = (next_harq_process + i) % LTE_FDD_ENB_USER_N_HARQ_PROCESSES;
+        if(!dl_harq[id].active)
+        {
+            *harq_process = id;
+            *ndi          = !dl_harq[id].ndi;
+            return LTE_FDD_ENB_ERROR_NONE;
+        }
+    }
+
+    return LTE_FDD_ENB_ERROR_NO_FREE_HARQ_PROCESS;
 }
 void LTE_fdd_enb_user::store_harq_info(uint32                        pucch_tti,
-                                       LIBLTE_MAC_PDU_STRUCT        *mac_pdu,
                                        LIBLTE_PHY_ALLOCATION_STRUCT *alloc)
 {
-    LTE_FDD_ENB_HARQ_INFO_STRUCT *harq_info = NULL;
+    std::lock_guard<std::mutex>      lock(harq_mutex);
+    LTE_FDD_ENB_DL_HARQ_PROC_STRUCT *proc = &dl_harq[alloc->harq_process % LTE_FDD_ENB_USER_N_HARQ_PROCESSES];
 
-    harq_info = new LTE_FDD_ENB_HARQ_INFO_STRUCT;
-
-    if(NULL != harq_info)
+    // Retransmissions reuse the transport block that is already stored
+    if(0 == alloc->harq_retx_count)
     {
-        memcpy(&harq_info->mac_pdu, mac_pdu, sizeof(LIBLTE_MAC_PDU_STRUCT));
-        memcpy(&harq_info->alloc, alloc, sizeof(LIBLTE_PHY_ALLOCATION_STRUCT));
-        harq_buffer_mutex.lock();
-        harq_buffer[pucch_tti] = harq_info;
-        harq_buffer_mutex.unlock();
+        uint8 *msg_ptr = alloc->msg[0].msg;
+        for(uint32 i=0; i<alloc->tbs/8; i++)
+            proc->tb[i] = liblte_bits_2_value(&msg_ptr, 8);
+        proc->mod_type = alloc->mod_type;
+        proc->tbs      = alloc->tbs;
+        proc->N_prb    = alloc->N_prb;
+        proc->mcs      = alloc->mcs;
+        proc->ndi      = alloc->ndi;
+        next_harq_process = (alloc->harq_process + 1) % LTE_FDD_ENB_USER_N_HARQ_PROCESSES;
     }
+    proc->pucch_tti       = pucch_tti;
+    proc->harq_retx_count = alloc->harq_retx_count;
+    proc->active          = true;
+}
+void LTE_fdd_enb_user::clear_harq_info(uint8 harq_process)
+{
+    std::lock_guard<std::mutex> lock(harq_mutex);
+
+    dl_harq[harq_process % LTE_FDD_ENB_USER_N_HARQ_PROCESSES].active = false;
 }
-void LTE_fdd_enb_user::clear_harq_info(uint32 pucch_tti)
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user::get_harq_info(uint32  pucch_tti,
+                                                       uint8  *harq_process,
+                                                       uint32 *harq_retx_count)
 {
-    std::lock_guard<std::mutex> lock(harq_buffer_mutex);
+    std::lock_guard<std::mutex> lock(harq_mutex);
 
-    auto harq_it = harq_buffer.find(pucch_tti);
-    if(harq_buffer.end() != harq_it)
+    for(uint32 i=0; i<LTE_FDD_ENB_USER_N_HARQ_PROCESSES; i++)
     {
-        delete (*harq_it).second;
-        harq_buffer.erase(harq_it);
+        if(dl_harq[i].active && pucch_tti == dl_harq[i].pucch_tti)
+        {
+            *harq_process    = i;
+            *harq_retx_count = dl_harq[i].harq_retx_count;
+            return LTE_FDD_ENB_ERROR_NONE;
+        }
     }
+
+    return LTE_FDD_ENB_ERROR_HARQ_INFO_NOT_FOUND;
 }
-LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user::get_harq_info(uint32                        pucch_tti,
-                                                       LIBLTE_MAC_PDU_STRUCT        *mac_pdu,
-                                                       LIBLTE_PHY_ALLOCATION_STRUCT *alloc)
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user::get_harq_retx_alloc(uint8                         harq_process,
+                                                             LIBLTE_PHY_ALLOCATION_STRUCT *alloc)
 {
-    std::lock_guard<std::mutex> lock(harq_buffer_mutex);
+    std::lock_guard<std::mutex>      lock(harq_mutex);
+    LTE_FDD_ENB_DL_HARQ_PROC_STRUCT *proc = &dl_harq[harq_process % LTE_FDD_ENB_USER_N_HARQ_PROCESSES];
 
-    auto harq_it = harq_buffer.find(pucch_tti);
-    if(harq_buffer.end() == harq_it)
+    if(!proc->active)
         return LTE_FDD_ENB_ERROR_HARQ_INFO_NOT_FOUND;
 
-    memcpy(mac_pdu, &(*harq_it).second->mac_pdu, sizeof(LIBLTE_MAC_PDU_STRUCT));
-    memcpy(alloc, &(*harq_it).second->alloc, sizeof(LIBLTE_PHY_ALLOCATION_STRUCT));
-    delete (*harq_it).second;
-    harq_buffer.erase(harq_it);
+    // Same transport block, NDI, and MCS with the next redundancy version
+    alloc->mod_type        = proc->mod_type;
+    alloc->tbs             = proc->tbs;
+    alloc->N_prb           = proc->N_prb;
+    alloc->mcs             = proc->mcs;
+    alloc->ndi             = proc->ndi;
+    alloc->harq_process    = harq_process % LTE_FDD_ENB_USER_N_HARQ_PROCESSES;
+    alloc->harq_retx_count = proc->harq_retx_count + 1;
+    alloc->rv_idx          = LTE_fdd_enb_harq_rv_idx[alloc->harq_retx_count % 4];
+    uint8 *msg_ptr = alloc->msg[0].msg;
+    liblte_bytes_2_bits(proc->tb, proc->tbs/8, &msg_ptr);
+    alloc->msg[0].N_bits = proc->tbs;
+
     return LTE_FDD_ENB_ERROR_NONE;
 }
+LTE_FDD_ENB_UL_HARQ_PROC_STRUCT* LTE_fdd_enb_user::get_ul_harq_proc(uint32 current_tti)
+{
+    return &ul_harq[current_tti % LTE_FDD_ENB_USER_N_HARQ_PROCESSES];
+}
 void LTE_fdd_enb_user::set_ul_buffer_size(uint32 N_bytes_in_buffer)
 {
     ul_buffer_size = N_bytes_in_buffer;
 }
-void LTE_fdd_enb_user::update_ul_buffer_size(uint32 N_bytes_received)
+void LTE_fdd_enb_user::update_ul_buffer_size(uint32 N_bytes_granted)
 {
-    if(N_bytes_received > ul_buffer_size)
+    if(N_bytes_granted > ul_buffer_size)
     {
         ul_buffer_size = 0;
     }else{
-        ul_buffer_size -= N_bytes_received;
+        ul_buffer_size -= N_bytes_granted;
     }
 }
 uint32 LTE_fdd_enb_user::get_ul_buffer_size()
 {
     return ul_buffer_size;
 }
+uint8 LTE_fdd_enb_user::get_ul_mcs()
+{
+    uint8 ul_mcs = 0;
+    liblte_mac_ul_sched_get_mcs(ul_sinr_db - ul_olla_db, LTE_FDD_ENB_USER_UL_MCS_MAX, &ul_mcs);
+    return ul_mcs;
+}
+void LTE_fdd_enb_user::update_ul_mcs(float sinr_db,
+                                     bool  crc_pass)
+{
+    ul_sinr_db += LTE_FDD_ENB_USER_UL_SINR_ALPHA * (sinr_db - ul_sinr_db);
+
+    if(crc_pass)
+    {
+        ul_olla_db -= LTE_FDD_ENB_USER_UL_OLLA_STEP_DB * LTE_FDD_ENB_USER_UL_MCS_TARGET_BLER / (1 - LTE_FDD_ENB_USER_UL_MCS_TARGET_BLER);
+    }else{
+        ul_olla_db += LTE_FDD_ENB_USER_UL_OLLA_STEP_DB;
+    }
+    if(ul_olla_db < -LTE_FDD_ENB_USER_UL_OLLA_MAX_DB)
+        ul_olla_db = -LTE_FDD_ENB_USER_UL_OLLA_MAX_DB;
+    if(ul_olla_db > LTE_FDD_ENB_USER_UL_OLLA_MAX_DB)
+        ul_olla_db = LTE_FDD_ENB_USER_UL_OLLA_MAX_DB;
+}
+void LTE_fdd_enb_user::set_ul_avg_thruput(float avg_thruput)
+{
+    ul_avg_thruput = avg_thruput;
+}
+float LTE_fdd_enb_user::get_ul_avg_thruput()
+{
+    return ul_avg_thruput;
+}
+void LTE_fdd_enb_user::set_ul_last_tti(uint32 tti)
+{
+    ul_last_tti = tti;
+}
+uint32 LTE_fdd_enb_user::get_ul_last_tti()
+{
+    return ul_last_tti;
+}
 uint8 LTE_fdd_enb_user::get_mcs()
 {
     return mcs;
 }
+uint8 LTE_fdd_enb_user::get_dl_mcs()
+{
+    return (uint8)dl_mcs_olla;
+}
+void LTE_fdd_enb_user::update_dl_mcs(bool ack)
+{
+    if(ack)
+    {
+        dl_mcs_olla += LTE_FDD_ENB_USER_DL_MCS_STEP_UP;
+    }else{
+        dl_mcs_olla -= LTE_FDD_ENB_USER_DL_MCS_STEP_UP * (1 - LTE_FDD_ENB_USER_DL_MCS_TARGET_BLER) / LTE_FDD_ENB_USER_DL_MCS_TARGET_BLER;
+    }
+    if(dl_mcs_olla < 0)
+        dl_mcs_olla = 0;
+    if(dl_mcs_olla > LTE_FDD_ENB_USER_DL_MCS_MAX)
+        dl_mcs_olla = LTE_FDD_ENB_USER_DL_MCS_MAX;
+}
+void LTE_fdd_enb_user::set_dl_avg_thruput(float avg_thruput)
+{
+    dl_avg_thruput = avg_thruput;
+}
+float LTE_fdd_enb_user::get_dl_avg_thruput()
+{
+    return dl_avg_thruput;
+}
+void LTE_fdd_enb_user::set_dl_last_tti(uint32 tti)
+{
+    dl_last_tti = tti;
+}
+uint32 LTE_fdd_enb_user::get_dl_last_tti()
+{
+    return dl_last_tti;
+}
+void LTE_fdd_enb_user::set_ta_command_tti(uint32 tti)
+{
+    ta_command_tti = tti;
+}
+uint32 LTE_fdd_enb_user::get_ta_command_tti()
+{
+    return ta_command_tti;
+}
 
 /*****************/
 /*    Generic    */
@@ -680,16 +819,6 @@ void LTE_fdd_enb_user::handle_timer_expiry(uint32 timer_id)
         }
     }
 }
-uint32 LTE_fdd_enb_user::get_max_ul_bytes_per_subfn()
-{
-    // FIXME: Make this dynamic based on channel conditions
-    return 50;
-}
-uint32 LTE_fdd_enb_user::get_max_dl_bytes_per_subfn()
-{
-    // FIXME: Make this dynamic based on channel conditions
-    return 325;
-}
 void LTE_fdd_enb_user::start_inactivity_timer(uint32 m_seconds)
 {
     LTE_fdd_enb_timer_cb timer_expiry_cb(&LTE_fdd_enb_timer_cb_wrapper<LTE_fdd_enb_user, &LTE_fdd_enb_user::handle_timer_expiry>, this);
@@ -712,3 +841,21 @@ void LTE_fdd_enb_user::stop_inactivity_timer()
     timer_mgr->stop_timer(inactivity_timer_id);
     inactivity_timer_id = LTE_FDD_ENB_INVALID_TIMER_ID;
 }
+
+/**********************/
+/*    User Manager    */
+/**********************/
+void LTE_fdd_enb_user::set_user_list_entry(std::list<LTE_fdd_enb_user*>::iterator it,
+                                           uint64                                 seq)
+{
+    user_list_it = it;
+    user_seq     = seq;
+}
+std::list<LTE_fdd_enb_user*>::iterator LTE_fdd_enb_user::get_user_list_it()
+{
+    return user_list_it;
+}
+uint64 LTE_fdd_enb_user::get_user_seq()
+{
+    return user_seq;
+}
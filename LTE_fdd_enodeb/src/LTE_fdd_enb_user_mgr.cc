@@ -88,141 +88,91 @@
 /********************************/
 LTE_fdd_enb_user_mgr::LTE_fdd_enb_user_mgr(LTE_fdd_enb_interface *iface,
                                            LTE_fdd_enb_timer_mgr *tm) :
-    interface{iface}, timer_mgr{tm}, next_m_tmsi{1}, next_c_rnti{LIBLTE_MAC_C_RNTI_START}
+    interface{iface}, timer_mgr{tm}, next_m_tmsi{1}, next_c_rnti{LIBLTE_MAC_C_RNTI_START},
+    next_user_seq{1}, soft_buffer_slab{NULL}, free_soft_buffers{NULL},
+    held_soft_buffers{NULL}, held_soft_buffer_tti{NULL}, N_soft_buffers{0},
+    N_free_soft_buffers{0}, N_held_soft_buffers{0}, soft_buffer_tti{0}
 {
 }
 LTE_fdd_enb_user_mgr::~LTE_fdd_enb_user_mgr()
 {
+    delete [] soft_buffer_slab;
+    delete [] free_soft_buffers;
+    delete [] held_soft_buffers;
+    delete [] held_soft_buffer_tti;
 }
 
 /****************************/
 /*    External Interface    */
 /****************************/
-LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user_mgr::assign_c_rnti(LTE_fdd_enb_user *user,
-                                                           uint16           *c_rnti)
-{
-    std::lock_guard<std::mutex> lock(c_rnti_mutex);
-    auto                        c_rnti_it    = c_rnti_map.find(next_c_rnti);
-    LTE_FDD_ENB_ERROR_ENUM      err          = LTE_FDD_ENB_ERROR_NONE;
-    uint16                      start_c_rnti = next_c_rnti;
-
-    while(c_rnti_map.end() != c_rnti_it)
-    {
-        next_c_rnti++;
-        if(LIBLTE_MAC_C_RNTI_END < next_c_rnti)
-        {
-            next_c_rnti = LIBLTE_MAC_C_RNTI_START;
-        }
-        if(next_c_rnti == start_c_rnti)
-        {
-            err = LTE_FDD_ENB_ERROR_NO_FREE_C_RNTI;
-            break;
-        }
-
-        c_rnti_it = c_rnti_map.find(next_c_rnti);
-    }
-
-    if(LTE_FDD_ENB_ERROR_NONE == err)
-    {
-        c_rnti_map[next_c_rnti] = user;
-        *c_rnti                 = next_c_rnti++;
-
-        interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
-                                  LTE_FDD_ENB_DEBUG_LEVEL_USER,
-                                  __FILE__,
-                                  __LINE__,
-                                  "C-RNTI=%u assigned",
-                                  *c_rnti);
-
-        if(LIBLTE_MAC_C_RNTI_END < next_c_rnti)
-        {
-            next_c_rnti = LIBLTE_MAC_C_RNTI_START;
-        }
-    }
-
-    return err;
-}
 LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user_mgr::release_c_rnti(uint16 c_rnti)
 {
-    std::lock_guard<std::mutex>        c_rnti_lock(c_rnti_mutex);
-    std::lock_guard<std::mutex>        timer_lock(timer_id_mutex);
-    auto                               c_rnti_it = c_rnti_map.find(c_rnti);
-    std::map<uint16, uint32>::iterator tr_iter;
-    std::map<uint32, uint16>::iterator tf_iter;
-    LTE_FDD_ENB_ERROR_ENUM             err = LTE_FDD_ENB_ERROR_C_RNTI_NOT_FOUND;
-
-    if(c_rnti_map.end() != c_rnti_it)
-    {
-        interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
-                                  LTE_FDD_ENB_DEBUG_LEVEL_USER,
-                                  __FILE__,
-                                  __LINE__,
-                                  "C-RNTI=%u released",
-                                  c_rnti);
+    std::lock_guard<std::shared_timed_mutex>  lock(user_mutex);
+    auto                                      c_rnti_it = c_rnti_index.find(c_rnti);
+    LTE_fdd_enb_user                         *user;
 
-        // Initialize or delete the user
-        if((*c_rnti_it).second->is_id_set())
-        {
-            (*c_rnti_it).second->init();
-        }else{
-            del_user((*c_rnti_it).second);
-        }
+    if(c_rnti_index.end() == c_rnti_it)
+        return LTE_FDD_ENB_ERROR_C_RNTI_NOT_FOUND;
 
-        // Release the C-RNTI
-        c_rnti_map.erase(c_rnti_it);
+    interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
+                              LTE_FDD_ENB_DEBUG_LEVEL_USER,
+                              __FILE__,
+                              __LINE__,
+                              "C-RNTI=%u released",
+                              c_rnti);
 
-        // Stop the C-RNTI timer
-        auto timer_rev_it = timer_id_map_reverse.find(c_rnti);
-        if(timer_id_map_reverse.end() != timer_rev_it)
-        {
-            timer_mgr->stop_timer((*timer_rev_it).second);
-            auto timer_fwd_it = timer_id_map_forward.find((*timer_rev_it).second);
-            if(timer_id_map_forward.end() != timer_fwd_it)
-            {
-                timer_id_map_forward.erase(timer_fwd_it);
-            }
-            timer_id_map_reverse.erase(timer_rev_it);
-        }
-
-        err = LTE_FDD_ENB_ERROR_NONE;
+    // Initialize or delete the user
+    user = (*c_rnti_it).second;
+    if(user->is_id_set())
+    {
+        free_c_rnti(user);
+        unindex_user(user);
+        release_soft_buffers(user);
+        user->init();
+        index_user(user);
+    }else{
+        remove_user(user);
     }
 
-    return err;
+    return LTE_FDD_ENB_ERROR_NONE;
 }
 LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user_mgr::transfer_c_rnti(LTE_fdd_enb_user *old_user,
                                                              LTE_fdd_enb_user *new_user)
 {
-    std::lock_guard<std::mutex> lock(c_rnti_mutex);
-    auto                        c_rnti_it = c_rnti_map.find(old_user->get_c_rnti());
-    LTE_FDD_ENB_ERROR_ENUM      err  = LTE_FDD_ENB_ERROR_C_RNTI_NOT_FOUND;
-    uint16                      c_rnti;
+    std::lock_guard<std::shared_timed_mutex> lock(user_mutex);
+    uint16                                   c_rnti    = old_user->get_c_rnti();
+    auto                                     c_rnti_it = c_rnti_index.find(c_rnti);
 
-    if(c_rnti_map.end() != c_rnti_it)
-    {
-        c_rnti = old_user->get_c_rnti();
+    if(c_rnti_index.end() == c_rnti_it || old_user != (*c_rnti_it).second)
+        return LTE_FDD_ENB_ERROR_C_RNTI_NOT_FOUND;
 
-        // Cleanup the old user
-        if(old_user->is_id_set())
-        {
-            old_user->init();
-        }else{
-            old_user->prepare_for_deletion();
-        }
+    unindex_user(old_user);
+    unindex_user(new_user);
 
-        // Update the C-RNTI map
-        c_rnti_map.erase(c_rnti_it);
-        c_rnti_map[c_rnti] = new_user;
-        c_rnti_it          = c_rnti_map.find(new_user->get_c_rnti());
-        if(c_rnti_map.end() != c_rnti_it)
-        {
-            c_rnti_map.erase(c_rnti_it);
-        }
-        new_user->set_c_rnti(c_rnti);
+    // Cleanup the old user
+    if(old_user->is_id_set())
+    {
+        old_user->init();
+    }else{
+        old_user->prepare_for_deletion();
+    }
 
-        err = LTE_FDD_ENB_ERROR_NONE;
+    // Hand the C-RNTI and its timer to the new user, dropping the one
+    // it had before
+    if(new_user->is_c_rnti_set())
+    {
+        auto new_c_rnti_it = c_rnti_index.find(new_user->get_c_rnti());
+        if(c_rnti_index.end() != new_c_rnti_it && new_user == (*new_c_rnti_it).second)
+            c_rnti_index.erase(new_c_rnti_it);
     }
+    c_rnti_index[c_rnti] = new_user;
+    new_user->set_c_rnti(c_rnti);
 
-    return err;
+    // Update the user indexes
+    index_user(old_user);
+    index_user(new_user);
+
+    return LTE_FDD_ENB_ERROR_NONE;
 }
 LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user_mgr::reset_c_rnti_timer(uint16 c_rnti)
 {
@@ -247,30 +197,30 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user_mgr::add_user(LTE_fdd_enb_user **user,
     LTE_fdd_enb_timer_cb    timer_expiry_cb(&LTE_fdd_enb_timer_cb_wrapper<LTE_fdd_enb_user_mgr, &LTE_fdd_enb_user_mgr::handle_c_rnti_timer_expiry>, this);
     LTE_FDD_ENB_ERROR_ENUM  err       = LTE_FDD_ENB_ERROR_NONE;
     uint32                  timer_id;
-    uint16                  c_rnti;
 
     new_user = new LTE_fdd_enb_user(interface, timer_mgr, rrc, rlc);
 
     if(NULL != new_user)
     {
+        std::lock_guard<std::shared_timed_mutex> lock(user_mutex);
+
         // Assign C-RNTI
-        if(LTE_FDD_ENB_ERROR_NONE == assign_c_rnti(new_user, &c_rnti))
+        if(LTE_FDD_ENB_ERROR_NONE == assign_c_rnti(new_user))
         {
             // Start C-RNTI reservation timer
             timer_mgr->start_timer(50000, timer_expiry_cb, &timer_id);
             timer_id_mutex.lock();
-            timer_id_map_forward[timer_id] = c_rnti;
-            timer_id_map_reverse[c_rnti]   = timer_id;
+            timer_id_map_forward[timer_id]                = new_user->get_c_rnti();
+            timer_id_map_reverse[new_user->get_c_rnti()] = timer_id;
             timer_id_mutex.unlock();
 
             // Setup user
-            new_user->set_c_rnti(c_rnti);
             new_user->start_inactivity_timer(LTE_FDD_ENB_USER_INACTIVITY_TIMER_VALUE_MS);
 
             // Store user
-            user_mutex.lock();
-            user_list.push_back(new_user);
-            user_mutex.unlock();
+            new_user->set_user_list_entry(user_list.insert(user_list.end(), new_user),
+                                          next_user_seq++);
+            index_user(new_user);
 
             // Return user
             *user = new_user;
@@ -287,22 +237,16 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user_mgr::add_user(LTE_fdd_enb_user **user,
 LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user_mgr::find_user(std::string        imsi,
                                                        LTE_fdd_enb_user **user)
 {
-    std::lock_guard<std::mutex> lock(user_mutex);
-    uint64                      imsi_num = 0;
+    std::shared_lock<std::shared_timed_mutex> lock(user_mutex);
+    uint64                                    imsi_num = 0;
 
     if(imsi.length() == 15)
     {
         to_number(imsi, 15, &imsi_num);
 
-        for(auto u : user_list)
-        {
-            if(u->is_id_set() &&
-               u->get_id()->imsi == imsi_num)
-            {
-                *user = u;
-                return LTE_FDD_ENB_ERROR_NONE;
-            }
-        }
+        *user = first_user(imsi_index, imsi_num, [](LTE_fdd_enb_user *u) {return true;});
+        if(NULL != *user)
+            return LTE_FDD_ENB_ERROR_NONE;
     }
 
     return LTE_FDD_ENB_ERROR_USER_NOT_FOUND;
@@ -310,16 +254,13 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user_mgr::find_user(std::string        imsi,
 LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user_mgr::find_user(uint16             c_rnti,
                                                        LTE_fdd_enb_user **user)
 {
-    std::lock_guard<std::mutex> lock(user_mutex);
+    std::shared_lock<std::shared_timed_mutex> lock(user_mutex);
+    auto                                      c_rnti_it = c_rnti_index.find(c_rnti);
 
-    for(auto u : user_list)
+    if(c_rnti_index.end() != c_rnti_it)
     {
-        if(u->is_c_rnti_set() &&
-           u->get_c_rnti() == c_rnti)
-        {
-            *user = u;
-            return LTE_FDD_ENB_ERROR_NONE;
-        }
+        *user = (*c_rnti_it).second;
+        return LTE_FDD_ENB_ERROR_NONE;
     }
 
     return LTE_FDD_ENB_ERROR_USER_NOT_FOUND;
@@ -327,141 +268,64 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user_mgr::find_user(uint16             c_rnti
 LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user_mgr::find_user(LIBLTE_MME_EPS_MOBILE_ID_GUTI_STRUCT  *guti,
                                                        LTE_fdd_enb_user                     **user)
 {
-    std::lock_guard<std::mutex> lock(user_mutex);
+    std::shared_lock<std::shared_timed_mutex> lock(user_mutex);
 
-    for(auto u : user_list)
-    {
-        if(!u->is_guti_set() || u->get_guti()->m_tmsi != guti->m_tmsi ||
-           u->get_guti()->mme_group_id != guti->mme_group_id ||
-           u->get_guti()->mme_code != guti->mme_code ||
-           u->get_guti()->mcc.Value().size() != guti->mcc.Value().size() ||
-           u->get_guti()->mnc.Value().size() != guti->mnc.Value().size())
-            continue;
-        for(uint32 i=0; i<u->get_guti()->mcc.Value().size(); i++)
-            if(u->get_guti()->mcc.Value()[0].Value() != guti->mcc.Value()[0].Value())
-                continue;
-        for(uint32 i=0; i<u->get_guti()->mnc.Value().size(); i++)
-            if(u->get_guti()->mnc.Value()[0].Value() != guti->mnc.Value()[0].Value())
-                continue;
-        *user = u;
+    *user = first_user(m_tmsi_index, guti->m_tmsi, [this, guti](LTE_fdd_enb_user *u) {return guti_match(u->get_guti(), guti);});
+    if(NULL != *user)
         return LTE_FDD_ENB_ERROR_NONE;
-    }
 
     return LTE_FDD_ENB_ERROR_USER_NOT_FOUND;
 }
 LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user_mgr::find_user(const S_TMSI      &s_tmsi,
                                                        LTE_fdd_enb_user **user)
 {
-    std::lock_guard<std::mutex> lock(user_mutex);
+    std::shared_lock<std::shared_timed_mutex> lock(user_mutex);
+    uint32                                    mme_code = s_tmsi.mmec_Get().Value();
 
-    for(auto u : user_list)
-    {
-        if(u->is_guti_set()                          &&
-           u->get_guti()->m_tmsi   == s_tmsi.m_TMSI_Value() &&
-           u->get_guti()->mme_code == s_tmsi.mmec_Get().Value())
-        {
-            *user = u;
-            return LTE_FDD_ENB_ERROR_NONE;
-        }
-    }
+    *user = first_user(m_tmsi_index, (uint32)s_tmsi.m_TMSI_Value(), [mme_code](LTE_fdd_enb_user *u) {return u->get_guti()->mme_code == mme_code;});
+    if(NULL != *user)
+        return LTE_FDD_ENB_ERROR_NONE;
 
     return LTE_FDD_ENB_ERROR_USER_NOT_FOUND;
 }
 LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user_mgr::find_user(uint32             ip_addr,
                                                        LTE_fdd_enb_user **user)
 {
-    std::lock_guard<std::mutex> lock(user_mutex);
+    std::shared_lock<std::shared_timed_mutex> lock(user_mutex);
 
-    for(auto u : user_list)
-    {
-        if(u->is_ip_addr_set() &&
-           u->get_ip_addr() == ip_addr)
-        {
-            *user = u;
-            return LTE_FDD_ENB_ERROR_NONE;
-        }
-    }
+    *user = first_user(ip_addr_index, ip_addr, [](LTE_fdd_enb_user *u) {return true;});
+    if(NULL != *user)
+        return LTE_FDD_ENB_ERROR_NONE;
 
     return LTE_FDD_ENB_ERROR_USER_NOT_FOUND;
 }
 LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user_mgr::del_user(LTE_fdd_enb_user *user)
 {
-    std::lock_guard<std::mutex>             lock(user_mutex);
-    std::list<LTE_fdd_enb_user*>::iterator  iter;
-    LTE_fdd_enb_user                       *tmp_user = NULL;
+    std::lock_guard<std::shared_timed_mutex> lock(user_mutex);
 
-    if(user->is_id_set())
+    if(0 != user->get_user_seq())
     {
-        for(iter=user_list.begin(); iter!=user_list.end(); iter++)
-        {
-            if(user->get_id()->imsi == (*iter)->get_id()->imsi &&
-               user->get_id()->imei == (*iter)->get_id()->imei)
-            {
-                tmp_user = (*iter);
-                iter     = user_list.erase(iter);
-                delete tmp_user;
-                return LTE_FDD_ENB_ERROR_NONE;
-            }
-        }
-    }else if(user->is_guti_set()){
-        for(iter=user_list.begin(); iter!=user_list.end(); iter++)
-        {
-            if(!(*iter)->is_guti_set() || !user->is_guti_set() ||
-               (*iter)->get_guti()->m_tmsi != user->get_guti()->m_tmsi ||
-               (*iter)->get_guti()->mme_group_id != user->get_guti()->mme_group_id ||
-               (*iter)->get_guti()->mme_code != user->get_guti()->mme_code ||
-               (*iter)->get_guti()->mcc.Value().size() != user->get_guti()->mcc.Value().size() ||
-               (*iter)->get_guti()->mnc.Value().size() != user->get_guti()->mnc.Value().size())
-                continue;
-            for(uint32 i=0; i<(*iter)->get_guti()->mcc.Value().size(); i++)
-                if((*iter)->get_guti()->mcc.Value()[0].Value() !=
-                   user->get_guti()->mcc.Value()[0].Value())
-                    continue;
-            for(uint32 i=0; i<(*iter)->get_guti()->mnc.Value().size(); i++)
-                if((*iter)->get_guti()->mnc.Value()[0].Value() !=
-                   user->get_guti()->mnc.Value()[0].Value())
-                    continue;
-            tmp_user = (*iter);
-            iter     = user_list.erase(iter);
-            delete tmp_user;
-            return LTE_FDD_ENB_ERROR_NONE;
-        }
-    }else if(user->is_c_rnti_set()){
-        for(iter=user_list.begin(); iter!=user_list.end(); iter++)
-        {
-            if(user->get_c_rnti() == (*iter)->get_c_rnti())
-            {
-                tmp_user = (*iter);
-                iter     = user_list.erase(iter);
-                delete tmp_user;
-                return LTE_FDD_ENB_ERROR_NONE;
-            }
-        }
+        remove_user(user);
+        return LTE_FDD_ENB_ERROR_NONE;
     }
 
     return LTE_FDD_ENB_ERROR_USER_NOT_FOUND;
 }
 LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user_mgr::del_user(std::string imsi)
 {
-    std::lock_guard<std::mutex>             lock(user_mutex);
-    std::list<LTE_fdd_enb_user*>::iterator  iter;
-    LTE_fdd_enb_user                       *tmp_user = NULL;
-    uint64                                  imsi_num = 0;
+    std::lock_guard<std::shared_timed_mutex>  lock(user_mutex);
+    LTE_fdd_enb_user                         *user;
+    uint64                                    imsi_num = 0;
 
     if(imsi.length() == 15)
     {
         to_number(imsi, 15, &imsi_num);
 
-        for(iter=user_list.begin(); iter!=user_list.end(); iter++)
+        user = first_user(imsi_index, imsi_num, [](LTE_fdd_enb_user *u) {return true;});
+        if(NULL != user)
         {
-            if((*iter)->is_id_set() &&
-               (*iter)->get_id()->imsi == imsi_num)
-            {
-                tmp_user = (*iter);
-                iter     = user_list.erase(iter);
-                delete tmp_user;
-                return LTE_FDD_ENB_ERROR_NONE;
-            }
+            remove_user(user);
+            return LTE_FDD_ENB_ERROR_NONE;
         }
     }
 
@@ -469,59 +333,73 @@ LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user_mgr::del_user(std::string imsi)
 }
 LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user_mgr::del_user(uint16 c_rnti)
 {
-    std::lock_guard<std::mutex>             lock(user_mutex);
-    std::list<LTE_fdd_enb_user*>::iterator  iter;
-    LTE_fdd_enb_user                       *tmp_user = NULL;
+    std::lock_guard<std::shared_timed_mutex> lock(user_mutex);
+    auto                                     c_rnti_it = c_rnti_index.find(c_rnti);
 
-    for(iter=user_list.begin(); iter!=user_list.end(); iter++)
+    if(c_rnti_index.end() != c_rnti_it)
     {
-        if((*iter)->is_c_rnti_set() &&
-           (*iter)->get_c_rnti() == c_rnti)
-        {
-            tmp_user = (*iter);
-            iter     = user_list.erase(iter);
-            delete tmp_user;
-            return LTE_FDD_ENB_ERROR_NONE;
-        }
+        remove_user((*c_rnti_it).second);
+        return LTE_FDD_ENB_ERROR_NONE;
     }
 
     return LTE_FDD_ENB_ERROR_USER_NOT_FOUND;
 }
 LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user_mgr::del_user(LIBLTE_MME_EPS_MOBILE_ID_GUTI_STRUCT *guti)
 {
-    std::lock_guard<std::mutex>             lock(user_mutex);
-    std::list<LTE_fdd_enb_user*>::iterator  iter;
-    LTE_fdd_enb_user                       *tmp_user = NULL;
+    std::lock_guard<std::shared_timed_mutex>  lock(user_mutex);
+    LTE_fdd_enb_user                         *user;
 
-    for(iter=user_list.begin(); iter!=user_list.end(); iter++)
+    user = first_user(m_tmsi_index, guti->m_tmsi, [this, guti](LTE_fdd_enb_user *u) {return guti_match(u->get_guti(), guti);});
+    if(NULL != user)
     {
-        if(!(*iter)->is_guti_set() || (*iter)->get_guti()->m_tmsi != guti->m_tmsi ||
-           (*iter)->get_guti()->mme_group_id != guti->mme_group_id ||
-           (*iter)->get_guti()->mme_code != guti->mme_code ||
-           (*iter)->get_guti()->mcc.Value().size() != guti->mcc.Value().size() ||
-           (*iter)->get_guti()->mnc.Value().size() != guti->mnc.Value().size())
-            continue;
-        for(uint32 i=0; i<(*iter)->get_guti()->mcc.Value().size(); i++)
-            if((*iter)->get_guti()->mcc.Value()[0].Value() != guti->mcc.Value()[0].Value())
-                continue;
-        for(uint32 i=0; i<(*iter)->get_guti()->mnc.Value().size(); i++)
-            if((*iter)->get_guti()->mnc.Value()[0].Value() != guti->mnc.Value()[0].Value())
-                continue;
-        tmp_user = (*iter);
-        iter     = user_list.erase(iter);
-        delete tmp_user;
+        remove_user(user);
         return LTE_FDD_ENB_ERROR_NONE;
     }
 
     return LTE_FDD_ENB_ERROR_USER_NOT_FOUND;
 }
+void LTE_fdd_enb_user_mgr::set_user_id(LTE_fdd_enb_user           *user,
+                                       LTE_FDD_ENB_USER_ID_STRUCT *identity)
+{
+    std::lock_guard<std::shared_timed_mutex> lock(user_mutex);
+
+    unindex_user(user);
+    user->set_id(identity);
+    index_user(user);
+}
+void LTE_fdd_enb_user_mgr::set_user_guti(LTE_fdd_enb_user                     *user,
+                                         LIBLTE_MME_EPS_MOBILE_ID_GUTI_STRUCT *guti)
+{
+    std::lock_guard<std::shared_timed_mutex> lock(user_mutex);
+
+    unindex_user(user);
+    user->set_guti(guti);
+    index_user(user);
+}
+void LTE_fdd_enb_user_mgr::set_user_ip_addr(LTE_fdd_enb_user *user,
+                                            uint32            ip_addr)
+{
+    std::lock_guard<std::shared_timed_mutex> lock(user_mutex);
+
+    unindex_user(user);
+    user->set_ip_addr(ip_addr);
+    index_user(user);
+}
+void LTE_fdd_enb_user_mgr::prepare_user_for_deletion(LTE_fdd_enb_user *user)
+{
+    std::lock_guard<std::shared_timed_mutex> lock(user_mutex);
+
+    unindex_user(user);
+    user->prepare_for_deletion();
+    index_user(user);
+}
 std::string LTE_fdd_enb_user_mgr::print_all_users()
 {
-    std::lock_guard<std::mutex>           lock(user_mutex);
-    std::string                           output;
-    LIBLTE_MME_EPS_MOBILE_ID_GUTI_STRUCT *guti;
-    uint32                                i;
-    uint32                                hex_val;
+    std::shared_lock<std::shared_timed_mutex>  lock(user_mutex);
+    std::string                                output;
+    LIBLTE_MME_EPS_MOBILE_ID_GUTI_STRUCT      *guti;
+    uint32                                     i;
+    uint32                                     hex_val;
 
     output = std::to_string((uint32)user_list.size());
     for(auto user : user_list)
@@ -554,15 +432,83 @@ std::string LTE_fdd_enb_user_mgr::print_all_users()
     return output;
 }
 
+void LTE_fdd_enb_user_mgr::set_max_users(uint32 N_users)
+{
+    std::lock_guard<std::shared_timed_mutex> user_lock(user_mutex);
+    std::lock_guard<std::mutex>              lock(soft_buffer_mutex);
+
+    if(N_users*LTE_FDD_ENB_USER_N_HARQ_PROCESSES == N_soft_buffers)
+        return;
+
+    // Called at start, so no schedule can still point at the old slab
+    for(LTE_fdd_enb_user *user : user_list)
+    {
+        for(uint32 i=0; i<LTE_FDD_ENB_USER_N_HARQ_PROCESSES; i++)
+        {
+            LTE_FDD_ENB_UL_HARQ_PROC_STRUCT *proc = user->get_ul_harq_proc(i);
+            proc->soft_buffer = NULL;
+            proc->active      = false;
+        }
+    }
+    delete [] soft_buffer_slab;
+    delete [] free_soft_buffers;
+    delete [] held_soft_buffers;
+    delete [] held_soft_buffer_tti;
+
+    N_soft_buffers       = N_users*LTE_FDD_ENB_USER_N_HARQ_PROCESSES;
+    soft_buffer_slab     = new LIBLTE_PHY_SOFT_BUFFER_STRUCT[N_soft_buffers];
+    free_soft_buffers    = new LIBLTE_PHY_SOFT_BUFFER_STRUCT*[N_soft_buffers];
+    held_soft_buffers    = new LIBLTE_PHY_SOFT_BUFFER_STRUCT*[N_soft_buffers];
+    held_soft_buffer_tti = new uint32[N_soft_buffers];
+    N_held_soft_buffers  = 0;
+    for(N_free_soft_buffers=0; N_free_soft_buffers<N_soft_buffers; N_free_soft_buffers++)
+        free_soft_buffers[N_free_soft_buffers] = &soft_buffer_slab[N_free_soft_buffers];
+}
+LIBLTE_PHY_SOFT_BUFFER_STRUCT* LTE_fdd_enb_user_mgr::alloc_soft_buffer()
+{
+    std::lock_guard<std::mutex> lock(soft_buffer_mutex);
+
+    if(0 == N_free_soft_buffers)
+        return NULL;
+    return free_soft_buffers[--N_free_soft_buffers];
+}
+void LTE_fdd_enb_user_mgr::free_soft_buffer(LIBLTE_PHY_SOFT_BUFFER_STRUCT *soft_buffer)
+{
+    std::lock_guard<std::mutex> lock(soft_buffer_mutex);
+
+    if(NULL != soft_buffer && N_soft_buffers > N_free_soft_buffers)
+        free_soft_buffers[N_free_soft_buffers++] = soft_buffer;
+}
+void LTE_fdd_enb_user_mgr::reclaim_soft_buffers()
+{
+    std::lock_guard<std::mutex> lock(soft_buffer_mutex);
+    uint32                      N_held = 0;
+
+    // Called once per TTI by the MAC
+    soft_buffer_tti++;
+    for(uint32 i=0; i<N_held_soft_buffers; i++)
+    {
+        if(LTE_FDD_ENB_USER_MGR_SOFT_BUFFER_HOLD_TTIS <= soft_buffer_tti - held_soft_buffer_tti[i])
+        {
+            free_soft_buffers[N_free_soft_buffers++] = held_soft_buffers[i];
+        }else{
+            held_soft_buffers[N_held]    = held_soft_buffers[i];
+            held_soft_buffer_tti[N_held] = held_soft_buffer_tti[i];
+            N_held++;
+        }
+    }
+    N_held_soft_buffers = N_held;
+}
+
 /**********************/
 /*    C-RNTI Timer    */
 /**********************/
 void LTE_fdd_enb_user_mgr::handle_c_rnti_timer_expiry(uint32 timer_id)
 {
-    auto   timer_fwd_it = timer_id_map_forward.find(timer_id);
     uint16 c_rnti;
 
     timer_id_mutex.lock();
+    auto timer_fwd_it = timer_id_map_forward.find(timer_id);
     if(timer_id_map_forward.end() != timer_fwd_it)
     {
         interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
@@ -585,3 +531,188 @@ void LTE_fdd_enb_user_mgr::handle_c_rnti_timer_expiry(uint32 timer_id)
         timer_id_mutex.unlock();
     }
 }
+
+/**********************/
+/*    User Indexes    */
+/**********************/
+LTE_FDD_ENB_ERROR_ENUM LTE_fdd_enb_user_mgr::assign_c_rnti(LTE_fdd_enb_user *user)
+{
+    uint16 start_c_rnti = next_c_rnti;
+
+    while(c_rnti_index.end() != c_rnti_index.find(next_c_rnti))
+    {
+        next_c_rnti++;
+        if(LIBLTE_MAC_C_RNTI_END < next_c_rnti)
+        {
+            next_c_rnti = LIBLTE_MAC_C_RNTI_START;
+        }
+        if(next_c_rnti == start_c_rnti)
+        {
+            return LTE_FDD_ENB_ERROR_NO_FREE_C_RNTI;
+        }
+    }
+
+    c_rnti_index[next_c_rnti] = user;
+    user->set_c_rnti(next_c_rnti++);
+    if(LIBLTE_MAC_C_RNTI_END < next_c_rnti)
+    {
+        next_c_rnti = LIBLTE_MAC_C_RNTI_START;
+    }
+
+    interface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
+                              LTE_FDD_ENB_DEBUG_LEVEL_USER,
+                              __FILE__,
+                              __LINE__,
+                              "C-RNTI=%u assigned",
+                              user->get_c_rnti());
+
+    return LTE_FDD_ENB_ERROR_NONE;
+}
+void LTE_fdd_enb_user_mgr::free_c_rnti(LTE_fdd_enb_user *user)
+{
+    std::lock_guard<std::mutex> lock(timer_id_mutex);
+    uint16                      c_rnti    = user->get_c_rnti();
+    auto                        c_rnti_it = c_rnti_index.find(c_rnti);
+
+    // A user left behind by a C-RNTI transfer no longer owns it
+    if(!user->is_c_rnti_set() ||c_rnti_index.end() == c_rnti_it || user != (*c_rnti_it).second)
+        return;
+    c_rnti_index.erase(c_rnti_it);
+
+    // Stop the C-RNTI timer
+    auto timer_rev_it = timer_id_map_reverse.find(c_rnti);
+    if(timer_id_map_reverse.end() != timer_rev_it)
+    {
+        timer_mgr->stop_timer((*timer_rev_it).second);
+        timer_id_map_forward.erase((*timer_rev_it).second);
+        timer_id_map_reverse.erase(timer_rev_it);
+    }
+}
+void LTE_fdd_enb_user_mgr::index_user(LTE_fdd_enb_user *user)
+{
+    if(user->is_id_set())
+    {
+        imsi_index.emplace(user->get_id()->imsi, user);
+    }
+    if(user->is_guti_set())
+    {
+        m_tmsi_index.emplace(user->get_guti()->m_tmsi, user);
+    }
+    if(user->is_ip_addr_set())
+    {
+        ip_addr_index.emplace(user->get_ip_addr(), user);
+    }
+}
+void LTE_fdd_enb_user_mgr::unindex_user(LTE_fdd_enb_user *user)
+{
+    if(user->is_id_set())
+    {
+        erase_index_entry(imsi_index, user->get_id()->imsi, user);
+    }
+    if(user->is_guti_set())
+    {
+        erase_index_entry(m_tmsi_index, user->get_guti()->m_tmsi, user);
+    }
+    if(user->is_ip_addr_set())
+    {
+        erase_index_entry(ip_addr_index, user->get_ip_addr(), user);
+    }
+}
+template<class INDEX, class KEY>
+void LTE_fdd_enb_user_mgr::erase_index_entry(INDEX            &index,
+                                             KEY               key,
+                                             LTE_fdd_enb_user *user)
+{
+    auto range = index.equal_range(key);
+
+    for(auto it=range.first; it!=range.second; it++)
+    {
+        if(user == (*it).second)
+        {
+            index.erase(it);
+            return;
+        }
+    }
+}
+template<class INDEX, class KEY, class MATCH>
+LTE_fdd_enb_user* LTE_fdd_enb_user_mgr::first_user(INDEX &index,
+                                                   KEY    key,
+                                                   MATCH  match)
+{
+    LTE_fdd_enb_user *first = NULL;
+    auto              range = index.equal_range(key);
+
+    // Users sharing a key resolve to the one added first, the same one
+    // a search of the user list would find
+    for(auto it=range.first; it!=range.second; it++)
+    {
+        if(match((*it).second) &&
+           (NULL == first || (*it).second->get_user_seq() < first->get_user_seq()))
+        {
+            first = (*it).second;
+        }
+    }
+
+    return first;
+}
+void LTE_fdd_enb_user_mgr::remove_user(LTE_fdd_enb_user *user)
+{
+    unindex_user(user);
+    free_c_rnti(user);
+    user_list.erase(user->get_user_list_it());
+    release_soft_buffers(user);
+    delete user;
+}
+void LTE_fdd_enb_user_mgr::release_soft_buffers(LTE_fdd_enb_user *user)
+{
+    std::lock_guard<std::mutex> lock(soft_buffer_mutex);
+
+    // Hold the buffers until the PHY is done with any schedule that
+    // still points at them
+    for(uint32 i=0; i<LTE_FDD_ENB_USER_N_HARQ_PROCESSES; i++)
+    {
+        LTE_FDD_ENB_UL_HARQ_PROC_STRUCT *proc = user->get_ul_harq_proc(i);
+        if(NULL != proc->soft_buffer)
+        {
+            held_soft_buffers[N_held_soft_buffers]    = proc->soft_buffer;
+            held_soft_buffer_tti[N_held_soft_buffers] = soft_buffer_tti;
+            N_held_soft_buffers++;
+        }
+        proc->soft_buffer = NULL;
+        proc->active      = false;
+    }
+}
+bool LTE_fdd_enb_user_mgr::guti_match(LIBLTE_MME_EPS_MOBILE_ID_GUTI_STRUCT *a,
+                                      LIBLTE_MME_EPS_MOBILE_ID_GUTI_STRUCT *b)
+{
+    std::vector<MCC_MNC_Digit> a_mcc = a->mcc.Value();
+    std::vector<MCC_MNC_Digit> b_mcc = b->mcc.Value();
+    std::vector<MCC_MNC_Digit> a_mnc = a->mnc.Value();
+    std::vector<MCC_MNC_Digit> b_mnc = b->mnc.Value();
+    uint32                     i;
+
+    if(a->m_tmsi       != b->m_tmsi       ||
+       a->mme_group_id != b->mme_group_id ||
+       a->mme_code     != b->mme_code     ||
+       a_mcc.size()    != b_mcc.size()    ||
+       a_mnc.size()    != b_mnc.size())
+    {
+        return false;
+    }
+    for(i=0; i<a_mcc.size(); i++)
+    {
+        if(a_mcc[i].Value() != b_mcc[i].Value())
+        {
+            return false;
+        }
+    }
+    for(i=0; i<a_mnc.size(); i++)
+    {
+        if(a_mnc[i].Value() != b_mnc[i].Value())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,118 @@
+/*******************************************************************************
+
+    Copyright 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************
+
+    File: LTE_fdd_enb_debug_log_bench.cc
+
+    Description: Measures the caller side cost of send_debug_msg with
+                 the type/level disabled and enabled.
+
+    Revision History
+    ----------    -------------    --------------------------------------------
+    10/18/2026    agent            Created file.
+
+*******************************************************************************/
+
+/*******************************************************************************
+                              INCLUDES
+*******************************************************************************/
+
+#include "LTE_fdd_enb_interface.h"
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+/*******************************************************************************
+                              DEFINES
+*******************************************************************************/
+
+// Calls per batch, small enough that a batch fits in the ring
+#define N_CALLS_PER_BATCH 1000
+#define N_BATCHES         1000
+
+// Time for the background thread to drain the ring between batches
+#define DRAIN_SLEEP_MS 5
+
+/*******************************************************************************
+                              TYPEDEFS
+*******************************************************************************/
+
+typedef enum{
+    BENCH_MSG_TEXT = 0,
+    BENCH_MSG_BITS,
+}BENCH_MSG_ENUM;
+
+/*******************************************************************************
+                              FUNCTIONS
+*******************************************************************************/
+
+double call_bench(LTE_fdd_enb_interface *iface,
+                  BENCH_MSG_ENUM         msg_type,
+                  LIBLTE_BIT_MSG_STRUCT *msg)
+{
+    double ns = 0;
+
+    for(uint32 i=0; i<N_BATCHES; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for(uint32 j=0; j<N_CALLS_PER_BATCH; j++)
+        {
+            if(BENCH_MSG_TEXT == msg_type)
+                iface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
+                                      LTE_FDD_ENB_DEBUG_LEVEL_MAC,
+                                      __FILE__,
+                                      __LINE__,
+                                      "Received UE message %s for RNTI=%u in TTI=%u",
+                                      LTE_fdd_enb_message_type_text[LTE_FDD_ENB_MESSAGE_TYPE_MAC_SDU_READY],
+                                      j,
+                                      i);
+            else
+                iface->send_debug_msg(LTE_FDD_ENB_DEBUG_TYPE_INFO,
+                                      LTE_FDD_ENB_DEBUG_LEVEL_PHY,
+                                      __FILE__,
+                                      __LINE__,
+                                      msg,
+                                      "PUSCH decode success RNTI=%u TTI=%u",
+                                      j,
+                                      i);
+        }
+        ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        std::this_thread::sleep_for(std::chrono::milliseconds(DRAIN_SLEEP_MS));
+    }
+
+    return ns/(N_BATCHES*N_CALLS_PER_BATCH);
+}
+
+int main(int argc, char *argv[])
+{
+    LTE_fdd_enb_interface *iface = new LTE_fdd_enb_interface();
+    LIBLTE_BIT_MSG_STRUCT  msg;
+
+    msg.N_bits = 1000;
+    memset(msg.msg, 1, msg.N_bits);
+
+    // Every type and level is enabled by default, so logging is only
+    // gated by the number of debug clients.  A client connected without
+    // a debug socket makes the background thread format each record
+    // and then discard it.
+    printf("disabled:            %8.1f ns/call\n", call_bench(iface, BENCH_MSG_TEXT, &msg));
+    iface->handle_debug_connect(-1);
+    printf("enabled, text:       %8.1f ns/call\n", call_bench(iface, BENCH_MSG_TEXT, &msg));
+    printf("enabled, %4u bits:  %8.1f ns/call\n", msg.N_bits, call_bench(iface, BENCH_MSG_BITS, &msg));
+    iface->handle_debug_disconnect(-1);
+}
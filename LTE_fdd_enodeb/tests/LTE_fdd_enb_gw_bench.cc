@@ -0,0 +1,237 @@
+/*******************************************************************************
+
+    Copyright 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************
+
+    File: LTE_fdd_enb_gw_bench.cc
+
+    Description: Measures TUN receive rates for the LTE FDD eNodeB
+                 gateway's read loop.  UDP senders route packets into a
+                 TUN device, which is read with one blocking read per
+                 packet, with poll and drain on one queue, and with
+                 poll and drain on LTE_FDD_ENB_GW_N_TUN_QUEUES queues.
+                 Needs CAP_NET_ADMIN.
+
+    Revision History
+    ----------    -------------    --------------------------------------------
+    10/18/2026    agent            Created file.
+
+*******************************************************************************/
+
+/*******************************************************************************
+                              INCLUDES
+*******************************************************************************/
+
+#include "LTE_fdd_enb_gw.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <linux/if.h>
+#include <linux/if_tun.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+
+/*******************************************************************************
+                              DEFINES
+*******************************************************************************/
+
+#define TUN_ADDR      "10.99.0.1"
+#define TUN_NETMASK   "255.255.255.0"
+#define N_DEST_ADDRS  200
+#define N_SENDERS     4
+#define PAYLOAD_SIZE  1000
+#define SEND_SECONDS  2
+
+/*******************************************************************************
+                              TYPEDEFS
+*******************************************************************************/
+
+typedef struct{
+    std::vector<int32>  fd;
+    std::atomic<bool>   run;
+    std::atomic<uint64> N_pkts;
+    std::atomic<uint64> N_wakeups;
+    bool                drain;
+}BENCH_TUN_STRUCT;
+
+/*******************************************************************************
+                              FUNCTIONS
+*******************************************************************************/
+
+bool open_tun(BENCH_TUN_STRUCT *tun,
+              const char       *name,
+              uint32            N_queues)
+{
+    struct ifreq ifr;
+    int32        sock;
+    bool         ok;
+
+    memset(&ifr, 0, sizeof(ifr));
+    ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
+    if(1 < N_queues)
+        ifr.ifr_flags |= IFF_MULTI_QUEUE;
+    strncpy(ifr.ifr_name, name, IFNAMSIZ - 1);
+    for(uint32 i=0; i<N_queues; i++)
+    {
+        int32 fd = open("/dev/net/tun", O_RDWR | (tun->drain ? O_NONBLOCK : 0));
+        if(0 > fd)
+            return false;
+        tun->fd.push_back(fd);
+        if(0 > ioctl(fd, TUNSETIFF, &ifr))
+            return false;
+    }
+
+    // Address and bring up the interface
+    sock                                                      = socket(AF_INET, SOCK_DGRAM, 0);
+    ifr.ifr_addr.sa_family                                    = AF_INET;
+    ((struct sockaddr_in *)&ifr.ifr_addr)->sin_addr.s_addr    = inet_addr(TUN_ADDR);
+    ok                                                        = 0 <= ioctl(sock, SIOCSIFADDR, &ifr);
+    ifr.ifr_netmask.sa_family                                 = AF_INET;
+    ((struct sockaddr_in *)&ifr.ifr_netmask)->sin_addr.s_addr = inet_addr(TUN_NETMASK);
+    ok                                                        = ok && 0 <= ioctl(sock, SIOCSIFNETMASK, &ifr);
+    ok                                                        = ok && 0 <= ioctl(sock, SIOCGIFFLAGS, &ifr);
+    ifr.ifr_flags                                            |= IFF_UP | IFF_RUNNING;
+    ok                                                        = ok && 0 <= ioctl(sock, SIOCSIFFLAGS, &ifr);
+    close(sock);
+
+    return ok;
+}
+
+// Same loop as LTE_fdd_enb_gw::receive_thread, without the PDCP hand off
+void receive_thread(BENCH_TUN_STRUCT *tun,
+                    int32             fd)
+{
+    LIBLTE_BYTE_MSG_STRUCT *pkt = new LIBLTE_BYTE_MSG_STRUCT[LTE_FDD_ENB_GW_RX_BATCH];
+    struct pollfd           pfd;
+
+    pfd.fd     = fd;
+    pfd.events = POLLIN;
+    while(tun->run)
+    {
+        if(!tun->drain)
+        {
+            if(0 < read(fd, pkt[0].msg, LIBLTE_MAX_MSG_SIZE))
+            {
+                tun->N_pkts++;
+                tun->N_wakeups++;
+            }
+            continue;
+        }
+
+        if(0 >= poll(&pfd, 1, LTE_FDD_ENB_GW_RX_POLL_TIMEOUT_MS))
+            continue;
+        tun->N_wakeups++;
+        for(uint32 i=0; i<LTE_FDD_ENB_GW_RX_BATCH; i++)
+        {
+            if(0 >= read(fd, pkt[i].msg, LIBLTE_MAX_MSG_SIZE))
+                break;
+            tun->N_pkts++;
+        }
+    }
+
+    delete [] pkt;
+}
+
+// Sends for SEND_SECONDS, or until stop is set with a pause per packet
+void send_thread(uint32             idx,
+                 std::atomic<bool> *stop)
+{
+    struct sockaddr_in dest;
+    uint8              payload[PAYLOAD_SIZE];
+    int32              sock = socket(AF_INET, SOCK_DGRAM, 0);
+    uint32             base = ntohl(inet_addr(TUN_ADDR)) + 1;
+
+    memset(payload, 0, sizeof(payload));
+    memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_port   = htons(5000 + idx);
+    auto end = std::chrono::steady_clock::now() + std::chrono::seconds(SEND_SECONDS);
+    for(uint32 i=0; NULL != stop ? !stop->load() : std::chrono::steady_clock::now() < end; i++)
+    {
+        dest.sin_addr.s_addr = htonl(base + i%N_DEST_ADDRS);
+        sendto(sock, payload, sizeof(payload), 0, (struct sockaddr *)&dest, sizeof(dest));
+        if(NULL != stop)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    close(sock);
+}
+
+int tun_bench(const char *name,
+              uint32      N_queues,
+              bool        drain)
+{
+    BENCH_TUN_STRUCT         tun;
+    std::vector<std::thread> rx;
+    std::vector<std::thread> tx;
+    std::atomic<bool>        stop{false};
+
+    tun.run       = true;
+    tun.N_pkts    = 0;
+    tun.N_wakeups = 0;
+    tun.drain     = drain;
+    if(!open_tun(&tun, name, N_queues))
+    {
+        perror("Can't set up the TUN device");
+        for(int32 fd : tun.fd)
+            close(fd);
+        return -1;
+    }
+
+    for(uint32 i=0; i<N_queues; i++)
+        rx.emplace_back(receive_thread, &tun, tun.fd[i]);
+    auto start = std::chrono::steady_clock::now();
+    for(uint32 i=0; i<N_SENDERS; i++)
+        tx.emplace_back(send_thread, i, (std::atomic<bool> *)NULL);
+    for(std::thread &t : tx)
+        t.join();
+    double  s      = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64  N_pkts = tun.N_pkts;
+    uint64  N_wake = tun.N_wakeups;
+
+    // Blocking readers only see the run flag after another packet
+    tun.run = false;
+    std::thread waker(send_thread, 0, &stop);
+    for(std::thread &t : rx)
+        t.join();
+    stop = true;
+    waker.join();
+    for(int32 fd : tun.fd)
+        close(fd);
+
+    printf("%u queue(s), %-13s: %8.0f pps, %5.2f pkts/wakeup\n",
+           N_queues,
+           drain ? "poll+drain" : "blocking read",
+           N_pkts/s,
+           (double)N_pkts/N_wake);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if(0 != tun_bench("tun_bench0", 1, false) ||
+       0 != tun_bench("tun_bench1", 1, true)  ||
+       0 != tun_bench("tun_bench2", LTE_FDD_ENB_GW_N_TUN_QUEUES, true))
+        return -1;
+}
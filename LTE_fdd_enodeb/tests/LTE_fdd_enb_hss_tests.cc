@@ -0,0 +1,214 @@
+/*******************************************************************************
+
+    Copyright 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************
+
+    File: LTE_fdd_enb_hss_tests.cc
+
+    Description: Contains all the tests for the LTE FDD eNodeB home
+                 subscriber server.
+
+    Revision History
+    ----------    -------------    --------------------------------------------
+    10/18/2026    agent            Created file.
+
+*******************************************************************************/
+
+/*******************************************************************************
+                              INCLUDES
+*******************************************************************************/
+
+#include "LTE_fdd_enb_hss.h"
+#include <sys/stat.h>
+
+/*******************************************************************************
+                              DEFINES
+*******************************************************************************/
+
+#define TEST_JOURNAL_FILE "/tmp/LTE_fdd_enb_hss_test.user_journal"
+#define TEST_CSV_FILE     "/tmp/LTE_fdd_enb_hss_test.csv"
+#define TEST_IMEI         490154203237518ULL
+
+/*******************************************************************************
+                              FUNCTIONS
+*******************************************************************************/
+
+std::string imsi_string(uint32 imsi)
+{
+    char str[16];
+
+    snprintf(str, sizeof(str), "%015u", imsi);
+
+    return str;
+}
+
+std::string k_string(uint32 k)
+{
+    char str[33];
+
+    snprintf(str, sizeof(str), "%032X", k);
+
+    return str;
+}
+
+uint32 journal_size(void)
+{
+    struct stat st;
+
+    if(0 != stat(TEST_JOURNAL_FILE, &st))
+        return 0;
+
+    return st.st_size;
+}
+
+int csv_import_test(void)
+{
+    LTE_fdd_enb_hss            *hss  = new LTE_fdd_enb_hss(TEST_JOURNAL_FILE);
+    FILE                       *file = fopen(TEST_CSV_FILE, "w");
+    LTE_FDD_ENB_USER_ID_STRUCT *id;
+    uint32                      N_users;
+    int                         ret  = 0;
+
+    // A header, two users sharing an IMEI, whitespace and CRLF, a bad
+    // line and a duplicate IMSI
+    fprintf(file, "imsi,imei,k\n");
+    fprintf(file, "%s,%llu,%s\n", imsi_string(1).c_str(), TEST_IMEI, k_string(1).c_str());
+    fprintf(file, "%s,%llu,%s\n", imsi_string(2).c_str(), TEST_IMEI, k_string(2).c_str());
+    fprintf(file, " %s , 490154203237519 , %s \r\n", imsi_string(3).c_str(), k_string(3).c_str());
+    fprintf(file, "%s,12345,%s\n", imsi_string(4).c_str(), k_string(4).c_str());
+    fprintf(file, "%s,%llu,%s\n", imsi_string(1).c_str(), TEST_IMEI, k_string(5).c_str());
+    fclose(file);
+
+    if(LTE_FDD_ENB_ERROR_INVALID_PARAM != hss->import_users("/nonexistent/users.csv", &N_users) ||
+       LTE_FDD_ENB_ERROR_NONE          != hss->import_users(TEST_CSV_FILE, &N_users)            ||
+       3                               != N_users                                               ||
+       !hss->is_imsi_allowed(1)                                                                 ||
+       !hss->is_imsi_allowed(2)                                                                 ||
+       !hss->is_imsi_allowed(3)                                                                 ||
+       hss->is_imsi_allowed(4)                                                                  ||
+       !hss->is_imei_allowed(490154203237519ULL)                                                ||
+       std::string::npos == hss->print_all_users().find("k=" + k_string(1)))
+        ret = -1;
+
+    // The shared IMEI stays allowed until both users are gone
+    if(LTE_FDD_ENB_ERROR_NONE != hss->del_user(imsi_string(1)) ||
+       !hss->is_imei_allowed(TEST_IMEI))
+        ret = -1;
+    id = hss->get_user_id_from_imei(TEST_IMEI);
+    if(NULL == id || 2 != id->imsi)
+        ret = -1;
+    if(LTE_FDD_ENB_ERROR_NONE != hss->del_user(imsi_string(2)) ||
+       hss->is_imei_allowed(TEST_IMEI)                         ||
+       NULL != hss->get_user_id_from_imei(TEST_IMEI))
+        ret = -1;
+
+    delete hss;
+    remove(TEST_CSV_FILE);
+    return ret;
+}
+
+int journal_replay_test(LTE_fdd_enb_interface *interface)
+{
+    LTE_fdd_enb_hss *hss = new LTE_fdd_enb_hss(TEST_JOURNAL_FILE);
+    std::string      imei = std::to_string(TEST_IMEI);
+    std::string      users;
+    int              ret  = 0;
+
+    remove(TEST_JOURNAL_FILE);
+    hss->set_use_user_file(true);
+    if(LTE_FDD_ENB_ERROR_NONE != hss->add_user(imsi_string(1), imei, k_string(1)) ||
+       LTE_FDD_ENB_ERROR_NONE != hss->add_user(imsi_string(2), imei, k_string(2)) ||
+       LTE_FDD_ENB_ERROR_NONE != hss->add_user(imsi_string(3), imei, k_string(3)) ||
+       LTE_FDD_ENB_ERROR_NONE != hss->del_user(imsi_string(2))                    ||
+       LTE_FDD_ENB_ERROR_NONE != hss->del_user(imsi_string(3))                    ||
+       LTE_FDD_ENB_ERROR_NONE != hss->add_user(imsi_string(3), imei, k_string(4)))
+        ret = -1;
+    delete hss;
+
+    // A new HSS rebuilds the same users from the journal
+    hss = new LTE_fdd_enb_hss(TEST_JOURNAL_FILE);
+    hss->read_user_file(interface);
+    users = hss->print_all_users();
+    if(0 != users.find("2\n")                                 ||
+       !hss->is_imsi_allowed(1)                               ||
+       hss->is_imsi_allowed(2)                                ||
+       !hss->is_imsi_allowed(3)                               ||
+       std::string::npos == users.find("k=" + k_string(4))    ||
+       std::string::npos != users.find("k=" + k_string(3)))
+        ret = -1;
+    delete hss;
+
+    remove(TEST_JOURNAL_FILE);
+    return ret;
+}
+
+int journal_compaction_test(LTE_fdd_enb_interface *interface)
+{
+    LTE_fdd_enb_hss *hss  = new LTE_fdd_enb_hss(TEST_JOURNAL_FILE);
+    std::string      imei = std::to_string(TEST_IMEI);
+    uint32           i;
+    int              ret  = 0;
+
+    remove(TEST_JOURNAL_FILE);
+    hss->set_use_user_file(true);
+    for(i=1; i<=600; i++)
+        if(LTE_FDD_ENB_ERROR_NONE != hss->add_user(imsi_string(i), imei, k_string(i)))
+            ret = -1;
+    for(i=1; i<=500; i++)
+        if(LTE_FDD_ENB_ERROR_NONE != hss->del_user(imsi_string(i)))
+            ret = -1;
+    delete hss;
+
+    // Compaction dropped the dead records and left whole records behind
+    if(LTE_FDD_ENB_HSS_JOURNAL_MAGIC_SIZE + 1100*LTE_FDD_ENB_HSS_JOURNAL_RECORD_SIZE <= journal_size() ||
+       0 != (journal_size() - LTE_FDD_ENB_HSS_JOURNAL_MAGIC_SIZE) % LTE_FDD_ENB_HSS_JOURNAL_RECORD_SIZE)
+        ret = -1;
+
+    hss = new LTE_fdd_enb_hss(TEST_JOURNAL_FILE);
+    hss->read_user_file(interface);
+    if(0 != hss->print_all_users().find("100\n") ||
+       hss->is_imsi_allowed(500)                 ||
+       !hss->is_imsi_allowed(501)                ||
+       !hss->is_imsi_allowed(600))
+        ret = -1;
+    delete hss;
+
+    remove(TEST_JOURNAL_FILE);
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    LTE_fdd_enb_interface *interface = new LTE_fdd_enb_interface();
+
+    printf("csv_import_test: ");
+    if(0 != csv_import_test())
+        exit(-1);
+    printf("pass\n");
+
+    printf("journal_replay_test: ");
+    if(0 != journal_replay_test(interface))
+        exit(-1);
+    printf("pass\n");
+
+    printf("journal_compaction_test: ");
+    if(0 != journal_compaction_test(interface))
+        exit(-1);
+    printf("pass\n");
+
+    exit(0);
+}
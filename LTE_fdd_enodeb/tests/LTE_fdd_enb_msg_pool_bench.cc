@@ -0,0 +1,189 @@
+/*******************************************************************************
+
+    Copyright 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************
+
+    File: LTE_fdd_enb_msg_pool_bench.cc
+
+    Description: Measures queueing a 1400 byte packet the way the radio
+                 bearers used to (new, whole struct copy, std::list) and
+                 through the message pool and queue, on one thread and
+                 between a producer and a consumer thread.
+
+    Revision History
+    ----------    -------------    --------------------------------------------
+    10/18/2026    agent            Created file.
+
+*******************************************************************************/
+
+/*******************************************************************************
+                              INCLUDES
+*******************************************************************************/
+
+#include "LTE_fdd_enb_msg_pool.h"
+#include "liblte_common.h"
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <stdio.h>
+#include <string.h>
+
+/*******************************************************************************
+                              DEFINES
+*******************************************************************************/
+
+#define PKT_SIZE 1400
+#define N_MSGS   1000000
+
+/*******************************************************************************
+                              CLASS DECLARATIONS
+*******************************************************************************/
+
+// Previous radio bearer queue, a full copy of the struct per message
+template<class T>
+class list_queue
+{
+public:
+    void push(T *src)
+    {
+        T *msg = new T;
+        memcpy(msg, src, sizeof(T));
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(msg);
+    }
+    bool pop()
+    {
+        T *msg;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(queue.empty())
+                return false;
+            msg = queue.front();
+            queue.pop_front();
+        }
+        delete msg;
+        return true;
+    }
+
+    std::mutex    mutex;
+    std::list<T*> queue;
+};
+
+// Pooled blocks, only the payload is copied
+template<class T>
+class pool_queue
+{
+public:
+    void push(T *src)
+    {
+        T *msg = LTE_fdd_enb_msg_pool<T>::alloc();
+        copy_msg(msg, src);
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(msg);
+    }
+    bool pop()
+    {
+        T *msg;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            msg = queue.pop_front();
+        }
+        if(NULL == msg)
+            return false;
+        LTE_fdd_enb_msg_pool<T>::free(msg);
+        return true;
+    }
+
+    static void copy_msg(LIBLTE_BYTE_MSG_STRUCT *dst, LIBLTE_BYTE_MSG_STRUCT *src)
+    {
+        dst->N_bytes = src->N_bytes;
+        memcpy(dst->msg, src->msg, src->N_bytes);
+    }
+    static void copy_msg(LIBLTE_BIT_MSG_STRUCT *dst, LIBLTE_BIT_MSG_STRUCT *src)
+    {
+        dst->N_bits = src->N_bits;
+        memcpy(dst->msg, src->msg, src->N_bits);
+    }
+
+    std::mutex               mutex;
+    LTE_fdd_enb_msg_queue<T> queue;
+};
+
+/*******************************************************************************
+                              FUNCTIONS
+*******************************************************************************/
+
+template<class Q, class T>
+double same_thread_bench(T *src)
+{
+    Q queue;
+
+    auto start = std::chrono::steady_clock::now();
+    for(uint32 i=0; i<N_MSGS; i++)
+    {
+        queue.push(src);
+        queue.pop();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count()/N_MSGS;
+}
+
+template<class Q, class T>
+double cross_thread_bench(T *src)
+{
+    Q queue;
+
+    auto        start = std::chrono::steady_clock::now();
+    std::thread producer([&queue, src]() {for(uint32 i=0; i<N_MSGS; i++) queue.push(src);});
+    for(uint32 N_popped=0; N_popped<N_MSGS; )
+    {
+        if(queue.pop())
+            N_popped++;
+        else
+            std::this_thread::yield();
+    }
+    producer.join();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count()/N_MSGS;
+}
+
+int main(int argc, char *argv[])
+{
+    LIBLTE_BYTE_MSG_STRUCT *byte_msg = new LIBLTE_BYTE_MSG_STRUCT;
+    LIBLTE_BIT_MSG_STRUCT  *bit_msg  = new LIBLTE_BIT_MSG_STRUCT;
+
+    byte_msg->N_bytes = PKT_SIZE;
+    memset(byte_msg->msg, 1, PKT_SIZE);
+    bit_msg->N_bits = PKT_SIZE*8;
+    memset(bit_msg->msg, 1, PKT_SIZE*8);
+
+    printf("%u byte packet, ns per message    list    pool\n", PKT_SIZE);
+    printf("byte msg, same thread:         %7.1f %7.1f\n",
+           same_thread_bench<list_queue<LIBLTE_BYTE_MSG_STRUCT> >(byte_msg),
+           same_thread_bench<pool_queue<LIBLTE_BYTE_MSG_STRUCT> >(byte_msg));
+    printf("byte msg, cross thread:        %7.1f %7.1f\n",
+           cross_thread_bench<list_queue<LIBLTE_BYTE_MSG_STRUCT> >(byte_msg),
+           cross_thread_bench<pool_queue<LIBLTE_BYTE_MSG_STRUCT> >(byte_msg));
+    printf("bit msg,  same thread:         %7.1f %7.1f\n",
+           same_thread_bench<list_queue<LIBLTE_BIT_MSG_STRUCT> >(bit_msg),
+           same_thread_bench<pool_queue<LIBLTE_BIT_MSG_STRUCT> >(bit_msg));
+    printf("bit msg,  cross thread:        %7.1f %7.1f\n",
+           cross_thread_bench<list_queue<LIBLTE_BIT_MSG_STRUCT> >(bit_msg),
+           cross_thread_bench<pool_queue<LIBLTE_BIT_MSG_STRUCT> >(bit_msg));
+
+    delete byte_msg;
+    delete bit_msg;
+}
@@ -0,0 +1,239 @@
+/*******************************************************************************
+
+    Copyright 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************
+
+    File: LTE_fdd_enb_msg_pool_tests.cc
+
+    Description: Contains all the tests for the LTE FDD eNodeB message
+                 pool and message queue.
+
+    Revision History
+    ----------    -------------    --------------------------------------------
+    10/18/2026    agent            Created file.
+
+*******************************************************************************/
+
+/*******************************************************************************
+                              INCLUDES
+*******************************************************************************/
+
+#include "LTE_fdd_enb_msg_pool.h"
+#include <set>
+#include <thread>
+#include <stdio.h>
+
+/*******************************************************************************
+                              DEFINES
+*******************************************************************************/
+
+// Whole batches, so no cache is left holding blocks that were never
+// handed out, and more than a cache holds
+#define N_MSGS (4*LTE_FDD_ENB_MSG_POOL_BATCH)
+
+/*******************************************************************************
+                              TYPEDEFS
+*******************************************************************************/
+
+// Every test uses its own message type, so it starts from an empty pool
+template<uint32 TEST>
+struct test_msg{
+    uint32 value;
+};
+
+/*******************************************************************************
+                              FUNCTIONS
+*******************************************************************************/
+
+int cross_thread_free_test(void)
+{
+    typedef test_msg<0> MSG;
+    std::set<MSG*>      allocated;
+    MSG                *msgs[N_MSGS];
+    int                 ret = 0;
+
+    // Allocated on one thread, freed on another whose cache goes back
+    // to the shared list when it exits
+    std::thread producer([&msgs]() {
+        for(uint32 i=0; i<N_MSGS; i++)
+        {
+            msgs[i]        = LTE_fdd_enb_msg_pool<MSG>::alloc();
+            msgs[i]->value = i;
+        }
+    });
+    producer.join();
+    std::thread consumer([&msgs, &ret]() {
+        for(uint32 i=0; i<N_MSGS; i++)
+        {
+            if(i != msgs[i]->value)
+                ret = -1;
+            LTE_fdd_enb_msg_pool<MSG>::free(msgs[i]);
+        }
+    });
+    consumer.join();
+
+    // This thread gets the same blocks back instead of new slabs
+    for(uint32 i=0; i<N_MSGS; i++)
+        allocated.insert(msgs[i]);
+    for(uint32 i=0; i<N_MSGS; i++)
+    {
+        msgs[i] = LTE_fdd_enb_msg_pool<MSG>::alloc();
+        if(0 == allocated.count(msgs[i]))
+            ret = -1;
+    }
+    for(uint32 i=0; i<N_MSGS; i++)
+        LTE_fdd_enb_msg_pool<MSG>::free(msgs[i]);
+
+    return ret;
+}
+
+int cache_overflow_test(void)
+{
+    typedef test_msg<1> MSG;
+    std::set<MSG*>      freed;
+    MSG                *msgs[N_MSGS];
+    int                 ret = 0;
+
+    for(uint32 i=0; i<N_MSGS; i++)
+        msgs[i] = LTE_fdd_enb_msg_pool<MSG>::alloc();
+    for(uint32 i=0; i<N_MSGS; i++)
+    {
+        LTE_fdd_enb_msg_pool<MSG>::free(msgs[i]);
+        freed.insert(msgs[i]);
+    }
+
+    // More than LTE_FDD_ENB_MSG_POOL_MAX_N_CACHED were freed, so this
+    // thread's cache drained a batch that another thread can refill from
+    std::thread other([&freed, &ret]() {
+        MSG *other_msgs[LTE_FDD_ENB_MSG_POOL_BATCH];
+
+        for(uint32 i=0; i<LTE_FDD_ENB_MSG_POOL_BATCH; i++)
+        {
+            other_msgs[i] = LTE_fdd_enb_msg_pool<MSG>::alloc();
+            if(0 == freed.count(other_msgs[i]))
+                ret = -1;
+        }
+        for(uint32 i=0; i<LTE_FDD_ENB_MSG_POOL_BATCH; i++)
+            LTE_fdd_enb_msg_pool<MSG>::free(other_msgs[i]);
+    });
+    other.join();
+
+    return ret;
+}
+
+int queue_fifo_test(void)
+{
+    typedef test_msg<2> MSG;
+    LTE_fdd_enb_msg_queue<MSG> queue;
+    MSG                       *msg;
+    uint32                     i;
+    int                        ret = 0;
+
+    if(NULL != queue.front() || NULL != queue.pop_front() || 0 != queue.size())
+        ret = -1;
+    for(i=0; i<N_MSGS; i++)
+    {
+        msg        = LTE_fdd_enb_msg_pool<MSG>::alloc();
+        msg->value = i;
+        queue.push_back(msg);
+    }
+    if(N_MSGS != queue.size())
+        ret = -1;
+
+    // Walking with next() doesn't remove anything
+    for(i=0, msg=queue.front(); NULL != msg; i++, msg=queue.next(msg))
+        if(i != msg->value)
+            ret = -1;
+    if(N_MSGS != i || N_MSGS != queue.size())
+        ret = -1;
+
+    for(i=0; i<N_MSGS; i++)
+    {
+        msg = queue.pop_front();
+        if(NULL == msg || i != msg->value)
+            ret = -1;
+        LTE_fdd_enb_msg_pool<MSG>::free(msg);
+    }
+    if(NULL != queue.front() || 0 != queue.size())
+        ret = -1;
+
+    // An emptied queue is usable again
+    msg        = LTE_fdd_enb_msg_pool<MSG>::alloc();
+    msg->value = N_MSGS;
+    queue.push_back(msg);
+    if(msg != queue.front() || NULL != queue.next(msg) || 1 != queue.size())
+        ret = -1;
+
+    return ret;
+}
+
+int queue_clear_test(void)
+{
+    typedef test_msg<3> MSG;
+    LTE_fdd_enb_msg_queue<MSG> queue;
+    std::set<MSG*>             queued;
+    MSG                       *msg;
+    int                        ret = 0;
+
+    for(uint32 i=0; i<N_MSGS; i++)
+    {
+        msg = LTE_fdd_enb_msg_pool<MSG>::alloc();
+        queue.push_back(msg);
+        queued.insert(msg);
+    }
+    queue.clear();
+    if(NULL != queue.front() || 0 != queue.size())
+        ret = -1;
+
+    // Nothing else uses this pool, so every block comes back
+    for(uint32 i=0; i<N_MSGS; i++)
+    {
+        msg = LTE_fdd_enb_msg_pool<MSG>::alloc();
+        if(0 == queued.erase(msg))
+            ret = -1;
+        queue.push_back(msg);
+    }
+    if(!queued.empty())
+        ret = -1;
+
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    printf("cross_thread_free_test: ");
+    if(0 != cross_thread_free_test())
+        exit(-1);
+    printf("pass\n");
+
+    printf("cache_overflow_test: ");
+    if(0 != cache_overflow_test())
+        exit(-1);
+    printf("pass\n");
+
+    printf("queue_fifo_test: ");
+    if(0 != queue_fifo_test())
+        exit(-1);
+    printf("pass\n");
+
+    printf("queue_clear_test: ");
+    if(0 != queue_clear_test())
+        exit(-1);
+    printf("pass\n");
+
+    exit(0);
+}
@@ -0,0 +1,146 @@
+/*******************************************************************************
+
+    Copyright 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************
+
+    File: LTE_fdd_enb_pdcp_tests.cc
+
+    Description: Contains all the tests for the LTE FDD eNodeB PDCP layer.
+
+    Revision History
+    ----------    -------------    --------------------------------------------
+    10/18/2026    agent            Created file.
+
+*******************************************************************************/
+
+/*******************************************************************************
+                              INCLUDES
+*******************************************************************************/
+
+#include "LTE_fdd_enb_pdcp.h"
+#include "LTE_fdd_enb_user.h"
+#include "LTE_fdd_enb_timer_mgr.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+/*******************************************************************************
+                              DEFINES
+*******************************************************************************/
+
+// More than two cipher batches, with a partial one at the end
+#define N_SDUS (2*LTE_FDD_ENB_PDCP_MAX_CIPHER_BATCH + 5)
+
+/*******************************************************************************
+                              CLASS DECLARATIONS
+*******************************************************************************/
+
+class rlc_sink
+{
+public:
+    rlc_sink() : N_sdu_ready{0} {};
+    void handle_msg(LTE_FDD_ENB_MESSAGE_STRUCT &msg)
+    {
+        if(LTE_FDD_ENB_MESSAGE_TYPE_RLC_SDU_READY == msg.type)
+            N_sdu_ready++;
+    }
+
+    std::atomic<uint32> N_sdu_ready;
+};
+
+/*******************************************************************************
+                              FUNCTIONS
+*******************************************************************************/
+
+int data_sdu_drain_test(void)
+{
+    LTE_fdd_enb_interface                      *interface = new LTE_fdd_enb_interface();
+    LTE_fdd_enb_timer_mgr                      *timer_mgr = new LTE_fdd_enb_timer_mgr(interface);
+    LTE_fdd_enb_user                           *user      = new LTE_fdd_enb_user(interface, timer_mgr, NULL, NULL);
+    LTE_fdd_enb_pdcp                           *pdcp      = new LTE_fdd_enb_pdcp(interface);
+    LTE_fdd_enb_msgq                           *from_rlc  = new LTE_fdd_enb_msgq(interface, "test_rlc_pdcp");
+    LTE_fdd_enb_msgq                           *from_rrc  = new LTE_fdd_enb_msgq(interface, "test_rrc_pdcp");
+    LTE_fdd_enb_msgq                           *from_gw   = new LTE_fdd_enb_msgq(interface, "test_gw_pdcp");
+    LTE_fdd_enb_msgq                           *to_rlc    = new LTE_fdd_enb_msgq(interface, "test_pdcp_rlc");
+    LTE_fdd_enb_msgq                           *to_rrc    = new LTE_fdd_enb_msgq(interface, "test_pdcp_rrc");
+    LTE_fdd_enb_msgq                           *to_gw     = new LTE_fdd_enb_msgq(interface, "test_pdcp_gw");
+    LTE_fdd_enb_rb                             *rb;
+    LIBLTE_BYTE_MSG_STRUCT                      sdu;
+    LIBLTE_BYTE_MSG_STRUCT                     *queued;
+    LTE_FDD_ENB_PDCP_DATA_SDU_READY_MSG_STRUCT  sdu_ready;
+    rlc_sink                                    sink;
+    uint32                                      N_rlc_sdus = 0;
+    int                                         ret        = 0;
+
+    user->setup_drb(LTE_FDD_ENB_RB_DRB1, &rb);
+    rb->set_pdcp_config(LTE_FDD_ENB_PDCP_CONFIG_LONG_SN);
+    rb->set_pdcp_dl_ciphering(false);
+    to_rlc->attach_rx(LTE_fdd_enb_msgq_cb(&LTE_fdd_enb_msgq_cb_wrapper<rlc_sink, &rlc_sink::handle_msg>, &sink));
+    pdcp->start(from_rlc, from_rrc, from_gw, to_rlc, to_rrc, to_gw);
+
+    // Queue the whole burst behind a single notification, like the GW
+    // does for a batch of packets to one RB
+    sdu.N_bytes = 100;
+    memset(sdu.msg, 0xA5, sdu.N_bytes);
+    for(uint32 i=0; i<N_SDUS; i++)
+        rb->queue_pdcp_data_sdu(&sdu);
+    sdu_ready.user = user;
+    sdu_ready.rb   = rb;
+    from_gw->send(LTE_FDD_ENB_MESSAGE_TYPE_PDCP_DATA_SDU_READY,
+                  LTE_FDD_ENB_DEST_LAYER_PDCP,
+                  (LTE_FDD_ENB_MESSAGE_UNION *)&sdu_ready,
+                  sizeof(sdu_ready));
+
+    for(uint32 i=0; i<1000 && N_SDUS != sink.N_sdu_ready; i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    pdcp->stop();
+
+    // Every SDU became a PDU for RLC and nothing is left behind
+    if(N_SDUS != sink.N_sdu_ready ||
+       LTE_FDD_ENB_ERROR_NONE == rb->get_next_pdcp_data_sdu(&queued))
+        ret = -1;
+    while(LTE_FDD_ENB_ERROR_NONE == rb->get_next_rlc_sdu(&queued))
+    {
+        if(102 != queued->N_bytes)
+            ret = -1;
+        rb->delete_next_rlc_sdu();
+        N_rlc_sdus++;
+    }
+    if(N_SDUS != N_rlc_sdus || N_SDUS != rb->get_pdcp_tx_count())
+        ret = -1;
+
+    // The queues join their threads before PDCP goes away
+    delete from_rlc;
+    delete from_rrc;
+    delete from_gw;
+    delete to_rlc;
+    delete to_rrc;
+    delete to_gw;
+    delete pdcp;
+    delete user;
+    delete timer_mgr;
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    printf("data_sdu_drain_test: ");
+    if(0 != data_sdu_drain_test())
+        exit(-1);
+    printf("pass\n");
+    exit(0);
+}
@@ -0,0 +1,156 @@
+/*******************************************************************************
+
+    Copyright 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************
+
+    File: LTE_fdd_enb_timer_mgr_bench.cc
+
+    Description: Measures the LTE FDD eNodeB timer manager's tick
+                 processing and start/stop/reset costs.
+
+    Revision History
+    ----------    -------------    --------------------------------------------
+    10/18/2026    agent            Created file.
+
+*******************************************************************************/
+
+/*******************************************************************************
+                              INCLUDES
+*******************************************************************************/
+
+#include "LTE_fdd_enb_timer_mgr.h"
+#include <chrono>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*******************************************************************************
+                              DEFINES
+*******************************************************************************/
+
+// Longest expiry, about the longest timer the eNodeB starts
+#define MAX_EXPIRY_MS 300000
+#define N_TICKS       1000000
+
+/*******************************************************************************
+                              TYPEDEFS
+*******************************************************************************/
+
+
+/*******************************************************************************
+                              CLASS DECLARATIONS
+*******************************************************************************/
+
+// Restarts every timer that expires, so the number running stays fixed
+class timer_restarter
+{
+public:
+    timer_restarter(LTE_fdd_enb_timer_mgr *tm) : timer_mgr{tm}, N_expired{0} {};
+    void handle_expiry(uint32 timer_id)
+    {
+        uint32 new_id;
+        N_expired++;
+        timer_mgr->start_timer(1 + rand()%MAX_EXPIRY_MS,
+                               LTE_fdd_enb_timer_cb(&LTE_fdd_enb_timer_cb_wrapper<timer_restarter, &timer_restarter::handle_expiry>, this),
+                               &new_id);
+    }
+
+    LTE_fdd_enb_timer_mgr *timer_mgr;
+    uint64                 N_expired;
+};
+
+/*******************************************************************************
+                              FUNCTIONS
+*******************************************************************************/
+
+double ns_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+int tick_bench(uint32 N_timers)
+{
+    LTE_fdd_enb_timer_mgr timer_mgr(NULL);
+    timer_restarter       restarter(&timer_mgr);
+    uint32                timer_id;
+
+    srand(1);
+    for(uint32 i=0; i<N_timers; i++)
+        if(LTE_FDD_ENB_ERROR_NONE != timer_mgr.start_timer(1 + rand()%MAX_EXPIRY_MS,
+                                                           LTE_fdd_enb_timer_cb(&LTE_fdd_enb_timer_cb_wrapper<timer_restarter, &timer_restarter::handle_expiry>, &restarter),
+                                                           &timer_id))
+            return -1;
+
+    // Tick directly, without the MAC message queue
+    auto start = std::chrono::steady_clock::now();
+    for(uint32 i=0; i<N_TICKS; i++)
+        timer_mgr.handle_tick();
+    double ns = ns_since(start);
+
+    printf("tick with %5u timers: %6.1f ns/tick (%llu expiries)\n",
+           N_timers,
+           ns/N_TICKS,
+           (unsigned long long)restarter.N_expired);
+    return 0;
+}
+
+int start_stop_reset_bench(uint32 N_timers)
+{
+    LTE_fdd_enb_timer_mgr timer_mgr(NULL);
+    timer_restarter       restarter(&timer_mgr);
+    std::vector<uint32>   timer_id(N_timers);
+    LTE_fdd_enb_timer_cb  cb(&LTE_fdd_enb_timer_cb_wrapper<timer_restarter, &timer_restarter::handle_expiry>, &restarter);
+
+    srand(1);
+    auto start = std::chrono::steady_clock::now();
+    for(uint32 i=0; i<N_timers; i++)
+        if(LTE_FDD_ENB_ERROR_NONE != timer_mgr.start_timer(1 + rand()%MAX_EXPIRY_MS, cb, &timer_id[i]))
+            return -1;
+    printf("start with %5u timers: %6.1f ns/op\n", N_timers, ns_since(start)/N_timers);
+
+    start = std::chrono::steady_clock::now();
+    for(uint32 i=0; i<N_timers; i++)
+        if(LTE_FDD_ENB_ERROR_NONE != timer_mgr.reset_timer(timer_id[i]))
+            return -1;
+    printf("reset with %5u timers: %6.1f ns/op\n", N_timers, ns_since(start)/N_timers);
+
+    start = std::chrono::steady_clock::now();
+    for(uint32 i=0; i<N_timers; i++)
+        if(LTE_FDD_ENB_ERROR_NONE != timer_mgr.stop_timer(timer_id[i]))
+            return -1;
+    printf("stop  with %5u timers: %6.1f ns/op\n", N_timers, ns_since(start)/N_timers);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32 N_timers[] = {0, 100, 1000, 10000, 60000};
+
+    for(uint32 i=0; i<sizeof(N_timers)/sizeof(N_timers[0]); i++)
+    {
+        if(0 != tick_bench(N_timers[i]))
+        {
+            printf("tick bench failed\n");
+            exit(-1);
+        }
+    }
+    if(0 != start_stop_reset_bench(60000))
+    {
+        printf("start/stop/reset bench failed\n");
+        exit(-1);
+    }
+}
@@ -71,15 +71,15 @@ public:
     void start_ctrl_port();
     void stop_ctrl_port();
     void send_ctrl_msg(std::string msg);
-    void handle_ctrl_msg(const std::string msg, const int32 sock_fd);
+    void handle_ctrl_msg(std::string_view msg, const int32 sock_fd);
     void handle_ctrl_connect(const int32 sock_fd);
     void handle_ctrl_disconnect(const int32 sock_fd);
     void handle_ctrl_error(const LIBTOOLS_SERVER_SOCKET_ERROR_ENUM err);
     bool get_shutdown();
 
 private:
-    void handle_read(std::string msg);
-    void handle_write(std::string msg);
+    void handle_read(std::string_view msg);
+    void handle_write(std::string_view msg);
     void write_earfcn(std::string earfcn_str);
     void handle_start();
     void handle_stop();
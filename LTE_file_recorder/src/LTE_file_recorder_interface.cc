@@ -121,8 +121,8 @@ void LTE_file_recorder_interface::send_ctrl_msg(std::string msg)
     ctrl_socket->send(msg + "\n", ctrl_sock_fd);
 }
 
-void LTE_file_recorder_interface::handle_ctrl_msg(const std::string msg,
-                                                  const int32       sock_fd)
+void LTE_file_recorder_interface::handle_ctrl_msg(std::string_view msg,
+                                                  const int32      sock_fd)
 {
     if(0 == msg.find("shutdown"))
     {
@@ -167,11 +167,11 @@ void LTE_file_recorder_interface::handle_ctrl_error(const LIBTOOLS_SERVER_SOCKET
     assert(0);
 }
 
-void LTE_file_recorder_interface::handle_read(std::string msg)
+void LTE_file_recorder_interface::handle_read(std::string_view msg)
 {
     if(0 != msg.find("read "))
         return send_ctrl_msg("fail invalid read command");
-    std::string param = msg.substr(5);
+    std::string_view param = msg.substr(5);
     if(0 == param.find(earfcn_token))
         return send_ctrl_msg("ok " + std::to_string(earfcn));
     if(0 == param.find(file_name_token))
@@ -179,11 +179,11 @@ void LTE_file_recorder_interface::handle_read(std::string msg)
     send_ctrl_msg("fail invalid read parameter");
 }
 
-void LTE_file_recorder_interface::handle_write(std::string msg)
+void LTE_file_recorder_interface::handle_write(std::string_view msg)
 {
     if(0 != msg.find("write "))
         return send_ctrl_msg("fail invalid write command");
-    std::string param = msg.substr(6);
+    std::string param(msg.substr(6));
     if(0 == param.find(earfcn_token))
         return write_earfcn(param.substr(earfcn_token.length()+1));
     if(0 == param.find(file_name_token))
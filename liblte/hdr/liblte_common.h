@@ -116,4 +116,13 @@ void liblte_value_2_bits(uint32   value,
 uint32 liblte_bits_2_value(uint8  **bits,
                            uint32   N_bits);
 
+/*********************************************************************
+    Name: liblte_bytes_2_bits
+
+    Description: Converts a byte string to a bit string
+*********************************************************************/
+void liblte_bytes_2_bits(uint8   *bytes,
+                         uint32   N_bytes,
+                         uint8  **bits);
+
 #endif /* __LIBLTE_COMMON_H__ */
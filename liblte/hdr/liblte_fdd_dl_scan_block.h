@@ -263,6 +263,9 @@ private:
     void do_bch_decode(bool &switch_freq, int32 &done_flag);
     void do_pdsch_decode_sib1(bool &switch_freq, int32 &done_flag);
     void do_pdsch_decode_si_generic(bool &switch_freq, int32 &done_flag);
+    LIBLTE_ERROR_ENUM decode_pdcch_and_pdsch(uint32 sfr_num, LIBLTE_PHY_PCFICH_STRUCT *pcfich, LIBLTE_PHY_PHICH_STRUCT *phich, LIBLTE_PHY_PDCCH_STRUCT *pdcch);
+    void alloc_samp_buf(void);
+    void free_samp_buf(void);
     void copy_input_to_samp_buf(gr_vector_const_void_star &input_items, int32 ninput_items);
     void freq_shift(uint32 start_idx, uint32 num_samps, float freq_offset);
     void channel_found(bool &switch_freq, int32 &done_flag);
@@ -287,17 +290,22 @@ private:
     std::vector<SystemInformation_r8_IEs::sib_TypeAndInfo_::sib_TypeAndInfo_Enum>  received_sibs;
     LIBLTE_PHY_STRUCT                                                             *phy_struct;
     LIBLTE_PHY_COARSE_TIMING_STRUCT                                                timing_struct;
+    LIBLTE_PHY_SUBFRAME_STRUCT                                                     subframe;
     LIBLTE_BIT_MSG_STRUCT                                                          rrc_msg;
     LIBLTE_FDD_DL_SCAN_BLOCK_STATE_ENUM                                            state;
     PHICH_Config::phich_Duration_Enum                                              phich_dur;
     size_t                                                                         in_size;
     complex                                                                       *samp_buf;
+    complex                                                                       *samp_buf_ring;
+    size_t                                                                         samp_buf_ring_bytes;
     float                                                                          phich_res;
     float                                                                          freq_offset;
     uint32                                                                         samp_buf_size;
     uint32                                                                         N_samps_needed;
     uint32                                                                         samp_buf_w_idx;
     uint32                                                                         samp_buf_r_idx;
+    uint32                                                                         samp_buf_ring_idx;
+    uint32                                                                         samp_buf_gen;
     uint32                                                                         N_freq_change_iterations;
     uint32                                                                         frame_start_idx;
     uint32                                                                         sfn;
@@ -378,6 +378,28 @@ LIBLTE_ERROR_ENUM liblte_mac_unpack_mac_pdu(LIBLTE_BIT_MSG_STRUCT *pdu,
                                             bool                   simultaneous_pucch_pusch,
                                             LIBLTE_MAC_PDU_STRUCT *mac_pdu);
 
+/*********************************************************************
+    PDU Name: DL-SCH MAC PDU sized to a transport block
+
+    Description: Byte aligned DL-SCH MAC PDU packed in a single pass
+                 and padded to exactly fill a transport block
+
+    Document Reference: 36.321 v10.2.0 Sections 6.1.2 and 6.2.1
+*********************************************************************/
+// Defines
+#define LIBLTE_MAC_DLSCH_SDU_SUBHEADER_MAX_N_BYTES        3
+#define LIBLTE_MAC_DLSCH_CE_SUBHEADER_N_BYTES             1
+#define LIBLTE_MAC_UE_CONTENTION_RESOLUTION_ID_CE_N_BYTES 6
+#define LIBLTE_MAC_TA_COMMAND_CE_N_BYTES                  1
+#define LIBLTE_MAC_ACTIVATION_DEACTIVATION_CE_N_BYTES     1
+// Enums
+// Structs
+// Functions
+uint32 liblte_mac_get_dlsch_mac_pdu_size(LIBLTE_MAC_PDU_STRUCT *mac_pdu);
+LIBLTE_ERROR_ENUM liblte_mac_pack_dlsch_mac_pdu(LIBLTE_MAC_PDU_STRUCT  *mac_pdu,
+                                                uint32                  N_tb_bytes,
+                                                LIBLTE_BYTE_MSG_STRUCT *pdu);
+
 /*********************************************************************
     PDU Name: Transparent
 
@@ -458,4 +480,78 @@ LIBLTE_ERROR_ENUM liblte_mac_pack_random_access_response_pdu(LIBLTE_MAC_RAR_STRU
 LIBLTE_ERROR_ENUM liblte_mac_unpack_random_access_response_pdu(LIBLTE_BIT_MSG_STRUCT *pdu,
                                                                LIBLTE_MAC_RAR_STRUCT *rar);
 
+/*********************************************************************
+    Name: Downlink scheduler
+
+    Description: Orders the UEs with downlink data according to a
+                 scheduling policy and assigns PRB sets using
+                 resource allocation type 0 or type 2.  The work per
+                 TTI is bounded by LIBLTE_MAC_DL_SCHED_MAX_N_UE.
+
+    Document Reference: 36.213 v10.3.0 Sections 7.1.6.1 and 7.1.6.3
+*********************************************************************/
+// Defines
+#define LIBLTE_MAC_DL_SCHED_MAX_N_UE  16
+#define LIBLTE_MAC_DL_SCHED_MAX_N_RB  110
+#define LIBLTE_MAC_DL_SCHED_PF_N_TTIS 100
+#define LIBLTE_MAC_DL_SCHED_N_TTIS    10240
+// Enums
+typedef enum{
+    LIBLTE_MAC_DL_SCHED_POLICY_ROUND_ROBIN = 0,
+    LIBLTE_MAC_DL_SCHED_POLICY_MAX_CI,
+    LIBLTE_MAC_DL_SCHED_POLICY_PROPORTIONAL_FAIR,
+    LIBLTE_MAC_DL_SCHED_POLICY_N_ITEMS,
+}LIBLTE_MAC_DL_SCHED_POLICY_ENUM;
+static const char liblte_mac_dl_sched_policy_text[LIBLTE_MAC_DL_SCHED_POLICY_N_ITEMS][20] = {"round_robin",
+                                                                                              "max_ci",
+                                                                                              "proportional_fair"};
+typedef enum{
+    LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_0 = 0,
+    LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_2,
+    LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_N_ITEMS,
+}LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_ENUM;
+static const char liblte_mac_resource_allocation_type_text[LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_N_ITEMS][20] = {"type_0",
+                                                                                                                "type_2"};
+// Structs
+typedef struct{
+    float  avg_thruput; // Bits per TTI
+    uint32 inst_rate;   // Bits per TTI over all available PRBs
+    uint32 last_tti;
+    uint16 rnti;
+}LIBLTE_MAC_DL_SCHED_UE_STRUCT;
+// Functions
+LIBLTE_ERROR_ENUM liblte_mac_dl_sched_order(LIBLTE_MAC_DL_SCHED_POLICY_ENUM  policy,
+                                            LIBLTE_MAC_DL_SCHED_UE_STRUCT   *ue,
+                                            uint32                           N_ue,
+                                            uint32                           current_tti,
+                                            uint32                          *order);
+void liblte_mac_dl_sched_update(LIBLTE_MAC_DL_SCHED_UE_STRUCT *ue,
+                                uint32                         current_tti,
+                                uint32                         N_bits);
+LIBLTE_ERROR_ENUM liblte_mac_dl_sched_alloc_prbs(LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_ENUM  ra_type,
+                                                 uint32                                    rbg_size,
+                                                 uint32                                    N_rb_dl,
+                                                 uint32                                    N_prb_req,
+                                                 bool                                     *prb_used,
+                                                 uint32                                   *prb,
+                                                 uint32                                   *N_prb);
+
+/*********************************************************************
+    Name: Uplink link adaptation
+
+    Description: Selects the highest uplink MCS whose SINR threshold
+                 is met by a PUSCH SINR estimate.  Any outer loop
+                 offset is applied by the caller.
+
+    Document Reference: 36.213 v10.3.0 Section 8.6.1
+*********************************************************************/
+// Defines
+#define LIBLTE_MAC_UL_SCHED_MAX_MCS 28
+// Enums
+// Structs
+// Functions
+LIBLTE_ERROR_ENUM liblte_mac_ul_sched_get_mcs(float  sinr_db,
+                                              uint8  max_mcs,
+                                              uint8 *mcs);
+
 #endif /* __LIBLTE_MAC_H__ */
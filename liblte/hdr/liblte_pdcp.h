@@ -44,6 +44,7 @@
 *******************************************************************************/
 
 #include "liblte_common.h"
+#include "liblte_security.h"
 
 /*******************************************************************************
                               DEFINES
@@ -54,6 +55,14 @@
                               TYPEDEFS
 *******************************************************************************/
 
+// Keys are the 256-bit outputs of the key derivation, the 128-bit
+// algorithm key is the least significant half
+typedef struct{
+    uint8                                       *k_int;
+    uint8                                       *k_enc;
+    LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_ENUM  eia;
+    LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_ENUM  eea;
+}LIBLTE_PDCP_SECURITY_CONFIG_STRUCT;
 
 /*******************************************************************************
                               PARAMETER DECLARATIONS
@@ -151,8 +160,20 @@ LIBLTE_ERROR_ENUM liblte_pdcp_pack_control_pdu(LIBLTE_PDCP_CONTROL_PDU_STRUCT *c
                                                uint8                           direction,
                                                uint8                           rb_id,
                                                LIBLTE_BYTE_MSG_STRUCT         *pdu);
+LIBLTE_ERROR_ENUM liblte_pdcp_pack_control_pdu(LIBLTE_PDCP_CONTROL_PDU_STRUCT     *contents,
+                                               LIBLTE_BIT_MSG_STRUCT              *data,
+                                               LIBLTE_PDCP_SECURITY_CONFIG_STRUCT *sec,
+                                               uint8                               direction,
+                                               uint8                               rb_id,
+                                               LIBLTE_BYTE_MSG_STRUCT             *pdu);
 LIBLTE_ERROR_ENUM liblte_pdcp_unpack_control_pdu(LIBLTE_BYTE_MSG_STRUCT         *pdu,
                                                  LIBLTE_PDCP_CONTROL_PDU_STRUCT *contents);
+LIBLTE_ERROR_ENUM liblte_pdcp_unpack_control_pdu(LIBLTE_BYTE_MSG_STRUCT             *pdu,
+                                                 LIBLTE_PDCP_SECURITY_CONFIG_STRUCT *sec,
+                                                 uint32                              count,
+                                                 uint8                               direction,
+                                                 uint8                               rb_id,
+                                                 LIBLTE_PDCP_CONTROL_PDU_STRUCT     *contents);
 
 /*********************************************************************
     PDU Type: User Plane PDCP Data PDU with long PDCP SN
@@ -172,7 +193,19 @@ LIBLTE_ERROR_ENUM liblte_pdcp_pack_data_pdu_with_long_sn(LIBLTE_PDCP_DATA_PDU_WI
 LIBLTE_ERROR_ENUM liblte_pdcp_pack_data_pdu_with_long_sn(LIBLTE_PDCP_DATA_PDU_WITH_LONG_SN_STRUCT *contents,
                                                          LIBLTE_BYTE_MSG_STRUCT                   *data,
                                                          LIBLTE_BYTE_MSG_STRUCT                   *pdu);
+LIBLTE_ERROR_ENUM liblte_pdcp_pack_data_pdu_with_long_sn(LIBLTE_PDCP_DATA_PDU_WITH_LONG_SN_STRUCT *contents,
+                                                         LIBLTE_BYTE_MSG_STRUCT                   *data,
+                                                         LIBLTE_PDCP_SECURITY_CONFIG_STRUCT       *sec,
+                                                         uint8                                     direction,
+                                                         uint8                                     rb_id,
+                                                         LIBLTE_BYTE_MSG_STRUCT                   *pdu);
+LIBLTE_ERROR_ENUM liblte_pdcp_unpack_data_pdu_with_long_sn(LIBLTE_BYTE_MSG_STRUCT                   *pdu,
+                                                           LIBLTE_PDCP_DATA_PDU_WITH_LONG_SN_STRUCT *contents);
 LIBLTE_ERROR_ENUM liblte_pdcp_unpack_data_pdu_with_long_sn(LIBLTE_BYTE_MSG_STRUCT                   *pdu,
+                                                           LIBLTE_PDCP_SECURITY_CONFIG_STRUCT       *sec,
+                                                           uint32                                    count,
+                                                           uint8                                     direction,
+                                                           uint8                                     rb_id,
                                                            LIBLTE_PDCP_DATA_PDU_WITH_LONG_SN_STRUCT *contents);
 
 /*********************************************************************
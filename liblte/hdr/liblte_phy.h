@@ -194,6 +194,9 @@
 #define LIBLTE_PHY_PDCCH_N_CCE_MAX  (LIBLTE_PHY_PDCCH_N_REGS_MAX / LIBLTE_PHY_PDCCH_N_REG_CCE)
 #define LIBLTE_PHY_PDCCH_N_BITS_MAX 576
 
+// Channel estimate regions remembered by a subframe
+#define LIBLTE_PHY_N_RX_CE_REGIONS 4
+
 /*******************************************************************************
                               TYPEDEFS
 *******************************************************************************/
@@ -231,11 +234,31 @@ typedef enum{
     LIBLTE_PHY_CHAN_TYPE_ULCCH,
 }LIBLTE_PHY_CHAN_TYPE_ENUM;
 
+typedef struct{
+    uint32 first_prb;
+    uint32 N_prb;
+    uint32 first_symb;
+    uint32 N_symbs;
+    uint8  N_ant;
+}LIBLTE_PHY_CE_REGION_STRUCT;
+
 typedef struct{
     // Receive
     complex rx_symb[16][LIBLTE_PHY_N_RB_DL_20MHZ*LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP];
     complex rx_ce[LIBLTE_PHY_N_ANT_MAX][16][LIBLTE_PHY_N_RB_DL_20MHZ*LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP];
 
+    // Receive cache, identifies the samples that rx_symb and rx_ce
+    // currently hold and the regions that have channel estimates
+    LIBLTE_PHY_CE_REGION_STRUCT rx_ce_region[LIBLTE_PHY_N_RX_CE_REGIONS];
+    uint32                      rx_samps_gen;
+    uint32                      rx_start_idx;
+    uint32                      rx_N_id_cell;
+    uint32                      rx_N_rb_dl;
+    uint32                      rx_symb_mask;
+    uint32                      rx_N_ce_regions;
+    uint32                      rx_ce_region_idx;
+    bool                        rx_valid;
+
     // Transmit
     complex tx_symb[LIBLTE_PHY_N_ANT_MAX][16][LIBLTE_PHY_N_RB_DL_20MHZ*LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP];
 
@@ -281,11 +304,12 @@ typedef struct{
     complex        pusch_y[14400];
     complex        pusch_x[14400];
     complex        pusch_d[14400];
-    float          pusch_descramb_bits[28800];
-    uint32         pusch_c[28800];
-    uint8          pusch_encode_bits[28800];
-    uint8          pusch_scramb_bits[28800];
-    int8           pusch_soft_bits[28800];
+    float          pusch_descramb_bits[57600];
+    uint32         pusch_c[57600];
+    uint8          pusch_encode_bits[57600];
+    uint8          pusch_scramb_bits[57600];
+    int8           pusch_soft_bits[57600];
+    float          pusch_sinr_db;
 
     // PUCCH
     complex pucch_z_est[LIBLTE_PHY_N_SC_RB_UL*14];
@@ -399,17 +423,16 @@ typedef struct{
     // CRS & Channel Estimate
     complex crs[14][LIBLTE_PHY_N_RB_DL_20MHZ*LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP];
     complex dl_ce_crs[16][LIBLTE_PHY_N_RB_DL_20MHZ*LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP];
+    // Rows strided by N_rb_dl, see the DL kernels
     float   dl_ce_mag[5][LIBLTE_PHY_N_RB_DL_20MHZ*LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP];
     float   dl_ce_ang[5][LIBLTE_PHY_N_RB_DL_20MHZ*LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP];
 
     // PSS
-    complex pss_mod_n1[3][LIBLTE_PHY_N_RB_DL_20MHZ*LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP];
-    complex pss_mod[3][LIBLTE_PHY_N_RB_DL_20MHZ*LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP];
-    complex pss_mod_p1[3][LIBLTE_PHY_N_RB_DL_20MHZ*LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP];
+    complex pss_mod[3][62];
+    complex pss_bins[64];
+    complex pss_corr[80];
 
     // SSS
-    complex sss_mod_0[168][LIBLTE_PHY_N_RB_DL_20MHZ*LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP];
-    complex sss_mod_5[168][LIBLTE_PHY_N_RB_DL_20MHZ*LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP];
     complex sss_0[63];
     complex sss_5[63];
     uint8   sss_x_s_tilda[31];
@@ -424,6 +447,7 @@ typedef struct{
     int8    sss_c1[31];
     int8    sss_z1_m0[31];
     int8    sss_z1_m1[31];
+    int16   sss_n_id_1[31][31];
 
     // Timing
     float dl_timing_abs_corr[LIBLTE_PHY_N_SAMPS_PER_SLOT_30_72MHZ*2];
@@ -536,8 +560,14 @@ typedef struct{
     uint32  N_sc_rb_ul;
     uint32  FFT_pad_size;
     uint32  FFT_size;
+    uint32  dl_kernels_idx;
     uint8   N_ant;
     bool    ul_init;
+
+    // Optional, called before (done=false) and after (done=true)
+    // every ULSCH code block turbo decode
+    void  (*turbo_decode_hook)(void *obj, bool done);
+    void   *turbo_decode_hook_obj;
 }LIBLTE_PHY_STRUCT;
 // Functions
 LIBLTE_ERROR_ENUM liblte_phy_init(LIBLTE_PHY_STRUCT                 **phy_struct,
@@ -640,6 +670,7 @@ typedef struct{
     uint32                          N_codewords;
     uint32                          N_layers;
     uint32                          tx_mode;
+    uint32                          codebook_idx;
     uint32                          harq_retx_count;
     uint16                          rnti;
     uint8                           mcs;
@@ -662,19 +693,36 @@ LIBLTE_ERROR_ENUM liblte_phy_pusch_channel_encode(LIBLTE_PHY_STRUCT            *
                  Channel
 
     Document Reference: 3GPP TS 36.211 v10.1.0 section 5.3
+
+    Notes: Leaves the DMRS SINR estimate in phy_struct->pusch_sinr_db
+
+    Notes: soft_buffer is optional, when present the soft bits of
+           each code block are added to the ones from earlier
+           transmissions of the same transport block before turbo
+           decoding. Set N_combined to 0 for a new transport block.
+           The demapper's soft bits are integers within +-127, so
+           the sums are kept as saturated 16 bit integers.
 *********************************************************************/
 // Defines
+#define LIBLTE_PHY_SOFT_BUFFER_NULL_BIT (-32768)
+#define LIBLTE_PHY_SOFT_BUFFER_MAX_BIT  32767
 // Enums
 // Structs
+typedef struct{
+    int16  d_bits[5][LIBLTE_PHY_BASE_CODING_RATE*LIBLTE_PHY_MAX_CODE_BLOCK_SIZE];
+    uint32 tbs;
+    uint32 N_combined;
+}LIBLTE_PHY_SOFT_BUFFER_STRUCT;
 // Functions
-LIBLTE_ERROR_ENUM liblte_phy_pusch_channel_decode(LIBLTE_PHY_STRUCT            *phy_struct,
-                                                  LIBLTE_PHY_SUBFRAME_STRUCT   *subframe,
-                                                  LIBLTE_PHY_ALLOCATION_STRUCT *alloc,
-                                                  uint32                        N_id_cell,
-                                                  uint8                         N_ant,
-                                                  uint32                        N_turbo_iterations,
-                                                  uint8                        *out_bits,
-                                                  uint32                       *N_out_bits);
+LIBLTE_ERROR_ENUM liblte_phy_pusch_channel_decode(LIBLTE_PHY_STRUCT             *phy_struct,
+                                                  LIBLTE_PHY_SUBFRAME_STRUCT    *subframe,
+                                                  LIBLTE_PHY_ALLOCATION_STRUCT  *alloc,
+                                                  uint32                         N_id_cell,
+                                                  uint8                          N_ant,
+                                                  uint32                         N_turbo_iterations,
+                                                  LIBLTE_PHY_SOFT_BUFFER_STRUCT *soft_buffer,
+                                                  uint8                         *out_bits,
+                                                  uint32                        *N_out_bits);
 
 /*********************************************************************
     Name: liblte_phy_pucch_format_1_1a_1b_channel_encode
@@ -1119,6 +1167,18 @@ LIBLTE_ERROR_ENUM liblte_phy_create_dl_subframe(LIBLTE_PHY_STRUCT          *phy_
                  particular downlink subframe
 
     Document Reference: 3GPP TS 36.211 v10.1.0
+
+    Notes: The second version only resolves the channel estimates for
+           N_prb PRBs starting at first_prb and N_symbs OFDM symbols
+           starting at first_symb, and only demodulates the OFDM
+           symbols needed for those.  It returns without doing any
+           work if one of the last LIBLTE_PHY_N_RX_CE_REGIONS regions
+           estimated in subframe covers the requested one for the
+           same subframe number and samps_gen, so callers must
+           change samps_gen whenever the contents of samps change and
+           clear subframe->rx_valid before the first call with a new
+           subframe.  The first version always resolves the subframe
+           from scratch.
 *********************************************************************/
 // Defines
 // Enums
@@ -1131,6 +1191,18 @@ LIBLTE_ERROR_ENUM liblte_phy_get_dl_subframe_and_ce(LIBLTE_PHY_STRUCT          *
                                                     uint32                      N_id_cell,
                                                     uint8                       N_ant,
                                                     LIBLTE_PHY_SUBFRAME_STRUCT *subframe);
+LIBLTE_ERROR_ENUM liblte_phy_get_dl_subframe_and_ce(LIBLTE_PHY_STRUCT          *phy_struct,
+                                                    complex                    *samps,
+                                                    uint32                      samps_gen,
+                                                    uint32                      frame_start_idx,
+                                                    uint8                       subfr_num,
+                                                    uint32                      N_id_cell,
+                                                    uint8                       N_ant,
+                                                    uint32                      first_prb,
+                                                    uint32                      N_prb,
+                                                    uint32                      first_symb,
+                                                    uint32                      N_symbs,
+                                                    LIBLTE_PHY_SUBFRAME_STRUCT *subframe);
 
 /*********************************************************************
     Name: liblte_phy_create_ul_subframe
@@ -1193,7 +1265,8 @@ LIBLTE_ERROR_ENUM liblte_phy_get_tbs_mcs_and_n_prb_for_dl(uint32  N_bits,
     Description: Determines the transport block size and the number of
                  PRBs needed to send the specified number of DL bits
                  according to the specified modulation and coding
-                 scheme
+                 scheme, or the largest transport block that fits in
+                 N_rb_dl PRBs if the bits do not fit
 
     Document Reference: 3GPP TS 36.213 v10.3.0 section 7.1.7
 
@@ -1234,9 +1307,11 @@ LIBLTE_ERROR_ENUM liblte_phy_get_tbs_mcs_and_n_prb_for_ul(uint32  N_bits,
     Description: Determines the transport block size and the number of
                  PRBs needed to send the specified number of UL bits
                  according to the specified modulation and coding
-                 scheme
+                 scheme, or the largest allocation within N_rb_ul
+                 PRBs if the bits do not fit
 
-    Document Reference: 3GPP TS 36.213 v10.3.0 section 7.1.7
+    Document Reference: 3GPP TS 36.213 v10.3.0 sections 7.1.7 and 8.6
+                        3GPP TS 36.211 v10.1.0 section 5.3.3
 *********************************************************************/
 // Defines
 // Enums
@@ -1266,6 +1341,20 @@ LIBLTE_ERROR_ENUM liblte_phy_get_n_cce(LIBLTE_PHY_STRUCT *phy_struct,
                                        uint8              N_ant,
                                        uint32            *N_cce);
 
+/*********************************************************************
+    Name: liblte_phy_get_rbg_size
+
+    Description: Determines the resource block group size used by
+                 downlink resource allocation type 0
+
+    Document Reference: 3GPP TS 36.213 v10.3.0 section 7.1.6.1
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+uint32 liblte_phy_get_rbg_size(uint32 N_rb_dl);
+
 /*********************************************************************
     Name: liblte_phy_add_to_tti
 
@@ -1327,6 +1416,60 @@ bool liblte_phy_is_tti_in_future(uint32 tti_to_check,
 bool liblte_phy_is_tti_in_past(uint32 tti_to_check,
                                uint32 reference_tti);
 
+/*********************************************************************
+    Name: liblte_phy_fc32_to_sc16
+
+    Description: Converts complex float samples to interleaved int16
+                 I/Q, scaling, rounding and saturating each component.
+                 Uses SSE2/AVX2 when the CPU supports them.
+
+    Document Reference: N/A
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+void liblte_phy_fc32_to_sc16(const complex *in,
+                             float          scale,
+                             uint32         N_samps,
+                             int16         *out);
+
+/*********************************************************************
+    Name: liblte_phy_sc16_to_fc32
+
+    Description: Converts interleaved int16 I/Q samples to complex
+                 float, scaling each component.  Uses SSE2/AVX2 when
+                 the CPU supports them.
+
+    Document Reference: N/A
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+void liblte_phy_sc16_to_fc32(const int16 *in,
+                             float        scale,
+                             uint32       N_samps,
+                             complex     *out);
+
+/*********************************************************************
+    Name: liblte_phy_scale_fc32
+
+    Description: Scales complex float samples by a real factor.  Uses
+                 SSE2/AVX2 when the CPU supports them, in and out may
+                 be the same buffer.
+
+    Document Reference: N/A
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+void liblte_phy_scale_fc32(const complex *in,
+                           float          scale,
+                           uint32         N_samps,
+                           complex       *out);
+
 /*********************************************************************
     Name: liblte_phy_rate_match_turbo
 
@@ -49,6 +49,7 @@
 *******************************************************************************/
 
 #define LIBLTE_RLC_AM_WINDOW_SIZE 512
+#define LIBLTE_RLC_AM_SN_MOD      1024
 
 /*******************************************************************************
                               TYPEDEFS
@@ -277,6 +278,12 @@ LIBLTE_ERROR_ENUM liblte_rlc_pack_umd_pdu(LIBLTE_RLC_UMD_PDU_STRUCT *umd,
                                           LIBLTE_BYTE_MSG_STRUCT    *pdu);
 LIBLTE_ERROR_ENUM liblte_rlc_unpack_umd_pdu(LIBLTE_BYTE_MSG_STRUCT    *pdu,
                                             LIBLTE_RLC_UMD_PDU_STRUCT *umd);
+uint32 liblte_rlc_get_umd_pdu_header_size(LIBLTE_RLC_UMD_SN_SIZE_ENUM sn_size,
+                                          uint32                      N_data);
+LIBLTE_ERROR_ENUM liblte_rlc_pack_umd_pdu_header(LIBLTE_RLC_UMD_PDU_HEADER_STRUCT *hdr,
+                                                 uint16                           *li,
+                                                 uint32                            N_data,
+                                                 LIBLTE_BYTE_MSG_STRUCT           *pdu);
 
 /*********************************************************************
     PDU Type: Acknowledged Mode Data PDU
@@ -312,6 +319,14 @@ LIBLTE_ERROR_ENUM liblte_rlc_pack_amd_pdu(LIBLTE_RLC_SINGLE_AMD_PDU_STRUCT *amd,
                                           LIBLTE_BYTE_MSG_STRUCT           *pdu);
 LIBLTE_ERROR_ENUM liblte_rlc_unpack_amd_pdu(LIBLTE_BYTE_MSG_STRUCT     *pdu,
                                             LIBLTE_RLC_AMD_PDUS_STRUCT *amd);
+uint32 liblte_rlc_get_amd_pdu_header_size(LIBLTE_RLC_RF_FIELD_ENUM rf,
+                                          uint32                   N_data);
+LIBLTE_ERROR_ENUM liblte_rlc_pack_amd_pdu_header(LIBLTE_RLC_AMD_PDU_HEADER_STRUCT *hdr,
+                                                 uint16                           *li,
+                                                 uint32                            N_data,
+                                                 LIBLTE_BYTE_MSG_STRUCT           *pdu);
+bool liblte_rlc_am_sn_in_tx_window(uint16 sn,
+                                   uint16 vt_a);
 
 /*********************************************************************
     PDU Type: Status PDU
@@ -101,20 +101,24 @@ typedef enum{
     LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_EEA0 = 0,
     LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA1,
     LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA2,
+    LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA3,
     LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_N_ITEMS,
 }LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_ENUM;
 static const char liblte_security_ciphering_algorithm_id_text[LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_N_ITEMS][20] = {"EEA0",
                                                                                                                      "128-EEA1",
-                                                                                                                     "128-EEA2"};
+                                                                                                                     "128-EEA2",
+                                                                                                                     "128-EEA3"};
 typedef enum{
     LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_EIA0 = 0,
     LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA1,
     LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA2,
+    LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA3,
     LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_N_ITEMS,
 }LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_ENUM;
 static const char liblte_security_integrity_algorithm_id_text[LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_N_ITEMS][20] = {"EIA0",
                                                                                                                      "128-EIA1",
-                                                                                                                     "128-EIA2"};
+                                                                                                                     "128-EIA2",
+                                                                                                                     "128-EIA3"};
 // Structs
 // Functions
 LIBLTE_ERROR_ENUM liblte_security_generate_k_nas(uint8                                       *k_asme,
@@ -187,6 +191,225 @@ LIBLTE_ERROR_ENUM liblte_security_128_eia2(uint8                 *key,
                                            LIBLTE_BIT_MSG_STRUCT *msg,
                                            uint8                 *mac);
 
+/*********************************************************************
+    Name: liblte_security_128_eia1
+
+    Description: 128-bit integrity algorithm EIA1 (SNOW 3G based).
+
+    Document Reference: 33.401 v10.0.0 Annex B.2.2
+                        35.215 v10.0.0 Section 4
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+LIBLTE_ERROR_ENUM liblte_security_128_eia1(uint8  *key,
+                                           uint32  count,
+                                           uint8   bearer,
+                                           uint8   direction,
+                                           uint8  *msg,
+                                           uint32  msg_len,
+                                           uint8  *mac);
+LIBLTE_ERROR_ENUM liblte_security_128_eia1(uint8                 *key,
+                                           uint32                 count,
+                                           uint8                  bearer,
+                                           uint8                  direction,
+                                           LIBLTE_BIT_MSG_STRUCT *msg,
+                                           uint8                 *mac);
+
+/*********************************************************************
+    Name: liblte_security_128_eia3
+
+    Description: 128-bit integrity algorithm EIA3 (ZUC based).
+
+    Document Reference: 33.401 v11.5.0 Annex B.2.4
+                        ETSI/SAGE 128-EEA3 & 128-EIA3 Specification
+                        v1.6 Section 4
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+LIBLTE_ERROR_ENUM liblte_security_128_eia3(uint8  *key,
+                                           uint32  count,
+                                           uint8   bearer,
+                                           uint8   direction,
+                                           uint8  *msg,
+                                           uint32  msg_len,
+                                           uint8  *mac);
+LIBLTE_ERROR_ENUM liblte_security_128_eia3(uint8                 *key,
+                                           uint32                 count,
+                                           uint8                  bearer,
+                                           uint8                  direction,
+                                           LIBLTE_BIT_MSG_STRUCT *msg,
+                                           uint8                 *mac);
+
+/*********************************************************************
+    Name: liblte_security_encryption_eea1
+
+    Description: 128-bit encryption algorithm EEA1 (SNOW 3G based).
+                 msg_len is in bytes.  Deciphering is the same
+                 operation.
+
+    Document Reference: 33.401 v10.0.0 Annex B.1.2
+                        35.215 v10.0.0 Section 3
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+LIBLTE_ERROR_ENUM liblte_security_encryption_eea1(uint8  *key,
+                                                  uint32  count,
+                                                  uint8   bearer,
+                                                  uint8   direction,
+                                                  uint8  *msg,
+                                                  uint32  msg_len,
+                                                  uint8  *out);
+
+/*********************************************************************
+    Name: liblte_security_encryption_eea2
+
+    Description: 128-bit encryption algorithm EEA2 (AES-CTR based).
+                 msg_len is in bytes.  Deciphering is the same
+                 operation.
+
+    Document Reference: 33.401 v10.0.0 Annex B.1.3
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+LIBLTE_ERROR_ENUM liblte_security_encryption_eea2(uint8  *key,
+                                                  uint32  count,
+                                                  uint8   bearer,
+                                                  uint8   direction,
+                                                  uint8  *msg,
+                                                  uint32  msg_len,
+                                                  uint8  *out);
+
+/*********************************************************************
+    Name: liblte_security_encryption_eea3
+
+    Description: 128-bit encryption algorithm EEA3 (ZUC based).
+                 msg_len is in bytes.  Deciphering is the same
+                 operation.
+
+    Document Reference: 33.401 v11.5.0 Annex B.1.4
+                        ETSI/SAGE 128-EEA3 & 128-EIA3 Specification
+                        v1.6 Section 3
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+LIBLTE_ERROR_ENUM liblte_security_encryption_eea3(uint8  *key,
+                                                  uint32  count,
+                                                  uint8   bearer,
+                                                  uint8   direction,
+                                                  uint8  *msg,
+                                                  uint32  msg_len,
+                                                  uint8  *out);
+
+/*********************************************************************
+    Name: liblte_security_encryption_batch
+
+    Description: Ciphers or deciphers a batch of messages that share
+                 a key, e.g. every PDCP PDU of a radio bearer queued in
+                 one TTI.  The key schedule is computed once and, for
+                 EEA2, the counter blocks of all messages are run
+                 through AES together.  out may equal msg.
+
+    Document Reference: 33.401 v10.0.0 Annex B.1
+*********************************************************************/
+// Defines
+#define LIBLTE_SECURITY_BATCH_AES_BLOCKS 64
+// Enums
+// Structs
+typedef struct{
+    uint8  *msg;
+    uint8  *out;
+    uint32  msg_len;
+    uint32  count;
+    uint8   bearer;
+    uint8   direction;
+}LIBLTE_SECURITY_CIPHER_JOB_STRUCT;
+// Functions
+LIBLTE_ERROR_ENUM liblte_security_encryption_batch(LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_ENUM  alg,
+                                                   uint8                                       *key,
+                                                   LIBLTE_SECURITY_CIPHER_JOB_STRUCT           *jobs,
+                                                   uint32                                       N_jobs);
+
+/*********************************************************************
+    Name: liblte_security_aes_key_schedule
+
+    Description: Expands a 128-bit AES key into its round keys.  Uses
+                 AES-NI when the CPU supports it, otherwise a constant
+                 time software implementation.
+
+    Document Reference: FIPS 197
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+typedef struct{
+    uint8 rk[11][16];
+}LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT;
+// Functions
+LIBLTE_ERROR_ENUM liblte_security_aes_key_schedule(uint8                                   *key,
+                                                   LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT *ks);
+
+/*********************************************************************
+    Name: liblte_security_aes_encrypt
+
+    Description: Encrypts a single 128-bit block with an expanded AES
+                 key.
+
+    Document Reference: FIPS 197
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+LIBLTE_ERROR_ENUM liblte_security_aes_encrypt(LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT *ks,
+                                              uint8                                   *input,
+                                              uint8                                   *output);
+
+/*********************************************************************
+    Name: liblte_security_aes_hw_accelerated
+
+    Description: Reports whether the AES engine runs on AES-NI, so
+                 callers can prefer 128-EEA2 only when it is fast.
+
+    Document Reference: N/A
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+bool liblte_security_aes_hw_accelerated(void);
+
+/*********************************************************************
+    Name: liblte_security_milenage_key_init
+
+    Description: Precomputes the Rijndael round keys and OPc for a
+                 subscriber key K, so repeated Milenage calls for the
+                 same subscriber skip both.  A NULL OP selects the
+                 operator variant built into openLTE.
+
+    Document Reference: 35.206 v10.0.0 Annex 3
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+typedef struct{
+    LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT ks;
+    uint8                                   op_c[16];
+}LIBLTE_SECURITY_MILENAGE_KEY_STRUCT;
+// Functions
+LIBLTE_ERROR_ENUM liblte_security_milenage_key_init(uint8                               *k,
+                                                    uint8                               *op,
+                                                    LIBLTE_SECURITY_MILENAGE_KEY_STRUCT *key);
+
 /*********************************************************************
     Name: liblte_security_milenage_f1
 
@@ -206,6 +429,11 @@ LIBLTE_ERROR_ENUM liblte_security_milenage_f1(uint8 *k,
                                               uint8 *sqn,
                                               uint8 *amf,
                                               uint8 *mac_a);
+LIBLTE_ERROR_ENUM liblte_security_milenage_f1(LIBLTE_SECURITY_MILENAGE_KEY_STRUCT *key,
+                                              uint8                               *rand,
+                                              uint8                               *sqn,
+                                              uint8                               *amf,
+                                              uint8                               *mac_a);
 
 /*********************************************************************
     Name: liblte_security_milenage_f1_star
@@ -226,6 +454,11 @@ LIBLTE_ERROR_ENUM liblte_security_milenage_f1_star(uint8 *k,
                                                    uint8 *sqn,
                                                    uint8 *amf,
                                                    uint8 *mac_s);
+LIBLTE_ERROR_ENUM liblte_security_milenage_f1_star(LIBLTE_SECURITY_MILENAGE_KEY_STRUCT *key,
+                                                   uint8                               *rand,
+                                                   uint8                               *sqn,
+                                                   uint8                               *amf,
+                                                   uint8                               *mac_s);
 
 /*********************************************************************
     Name: liblte_security_milenage_f2345
@@ -247,6 +480,12 @@ LIBLTE_ERROR_ENUM liblte_security_milenage_f2345(uint8 *k,
                                                  uint8 *ck,
                                                  uint8 *ik,
                                                  uint8 *ak);
+LIBLTE_ERROR_ENUM liblte_security_milenage_f2345(LIBLTE_SECURITY_MILENAGE_KEY_STRUCT *key,
+                                                 uint8                               *rand,
+                                                 uint8                               *res,
+                                                 uint8                               *ck,
+                                                 uint8                               *ik,
+                                                 uint8                               *ak);
 
 /*********************************************************************
     Name: liblte_security_milenage_f5_star
@@ -264,5 +503,8 @@ LIBLTE_ERROR_ENUM liblte_security_milenage_f2345(uint8 *k,
 LIBLTE_ERROR_ENUM liblte_security_milenage_f5_star(uint8 *k,
                                                    uint8 *rand,
                                                    uint8 *ak);
+LIBLTE_ERROR_ENUM liblte_security_milenage_f5_star(LIBLTE_SECURITY_MILENAGE_KEY_STRUCT *key,
+                                                   uint8                               *rand,
+                                                   uint8                               *ak);
 
 #endif /* __LIBLTE_SECURITY_H__ */
@@ -102,3 +102,30 @@ uint32 liblte_bits_2_value(uint8  **bits,
 
     return value;
 }
+
+/*********************************************************************
+    Name: liblte_bytes_2_bits
+
+    Description: Converts a byte string to a bit string
+*********************************************************************/
+void liblte_bytes_2_bits(uint8   *bytes,
+                         uint32   N_bytes,
+                         uint8  **bits)
+{
+    uint8 *bit_ptr = *bits;
+
+    for(uint32 i=0; i<N_bytes; i++)
+    {
+        uint8 byte = bytes[i];
+        bit_ptr[0] = (byte >> 7) & 0x1;
+        bit_ptr[1] = (byte >> 6) & 0x1;
+        bit_ptr[2] = (byte >> 5) & 0x1;
+        bit_ptr[3] = (byte >> 4) & 0x1;
+        bit_ptr[4] = (byte >> 3) & 0x1;
+        bit_ptr[5] = (byte >> 2) & 0x1;
+        bit_ptr[6] = (byte >> 1) & 0x1;
+        bit_ptr[7] = byte & 0x1;
+        bit_ptr   += 8;
+    }
+    *bits = bit_ptr;
+}
@@ -44,6 +44,8 @@
 #include "liblte_fdd_dl_scan_block.h"
 #include "liblte_mac.h"
 #include <gnuradio/io_signature.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 /*******************************************************************************
                               DEFINES
@@ -213,10 +215,12 @@ void liblte_fdd_dl_scan_block::initialize(uint32             N_samp_buf_frames,
                     1);
 
     // Initialize the sample buffer
-    samp_buf = (complex *)malloc(samp_buf_size * sizeof(complex));
-    samp_buf_w_idx  = 0;
-    samp_buf_r_idx  = 0;
-    last_samp_was_i = false;
+    alloc_samp_buf();
+    samp_buf_w_idx    = 0;
+    samp_buf_r_idx    = 0;
+    samp_buf_gen      = 0;
+    last_samp_was_i   = false;
+    subframe.rx_valid = false;
 
     // Variables
     change_freq_init();
@@ -232,7 +236,7 @@ liblte_fdd_dl_scan_block::~liblte_fdd_dl_scan_block()
     liblte_phy_cleanup(phy_struct);
 
     // Free the sample buffer
-    free(samp_buf);
+    free_samp_buf();
 }
 
 int32 liblte_fdd_dl_scan_block::work(int32                      ninput_items,
@@ -368,9 +372,18 @@ int32 liblte_fdd_dl_scan_block::work(int32                      ninput_items,
             freq_shift(samp_buf_r_idx,
                        samps_to_copy,
                        -timing_struct.freq_offset[corr_peak_idx]);
-            for(uint32 i=0; i<samps_to_copy; i++)
-                samp_buf[samp_buf_w_idx++] = samp_buf[samp_buf_r_idx++];
+            if(NULL != samp_buf_ring)
+            {
+                // Advance the window, the mirrored mapping keeps it contiguous
+                samp_buf_ring_idx = (samp_buf_ring_idx + samp_buf_r_idx) % samp_buf_size;
+                samp_buf          = &samp_buf_ring[samp_buf_ring_idx];
+                samp_buf_w_idx    = samps_to_copy;
+            }else{
+                for(uint32 i=0; i<samps_to_copy; i++)
+                    samp_buf[samp_buf_w_idx++] = samp_buf[samp_buf_r_idx++];
+            }
             samp_buf_r_idx = 100;
+            samp_buf_gen++;
         }
 
         if(true == copy_input)
@@ -408,6 +421,7 @@ void liblte_fdd_dl_scan_block::change_freq_init(void)
     N_bch_attempts   = 0;
     N_pdsch_attempts = 0;
     sib1_sent        = false;
+    samp_buf_gen++;
 }
 
 void liblte_fdd_dl_scan_block::do_freq_change_wait()
@@ -527,18 +541,23 @@ void liblte_fdd_dl_scan_block::do_sss_search(float pss_thresh, bool &switch_freq
 
 void liblte_fdd_dl_scan_block::do_bch_decode(bool &switch_freq, int32 &done_flag)
 {
-    LIBLTE_PHY_SUBFRAME_STRUCT subframe;
-    uint32                     N_rb_dl = LIBLTE_PHY_N_RB_DL_20MHZ;
-    uint8                      sfn_offset;
+    uint32 N_rb_dl = LIBLTE_PHY_N_RB_DL_20MHZ;
+    uint8  sfn_offset;
 //    for(uint32 i=0; i<15360; i++)
 //        printf("(%f,%f) ", samp_buf[samp_buf_r_idx+i].real(), samp_buf[samp_buf_r_idx+i].imag());
 //    printf("\n");
+    // Only the central 6 PRBs of the second slot carry PBCH
     if(!(LIBLTE_SUCCESS == liblte_phy_get_dl_subframe_and_ce(phy_struct,
                                                              samp_buf,
+                                                             samp_buf_gen,
                                                              samp_buf_r_idx,
                                                              0,
                                                              N_id_cell,
                                                              4,
+                                                             (phy_struct->N_rb_dl - 6)/2,
+                                                             6 + (phy_struct->N_rb_dl % 2),
+                                                             7,
+                                                             4,
                                                              &subframe) &&
          LIBLTE_SUCCESS == liblte_phy_bch_channel_decode(phy_struct,
                                                          &subframe,
@@ -636,35 +655,10 @@ void liblte_fdd_dl_scan_block::do_bch_decode(bool &switch_freq, int32 &done_flag
 
 void liblte_fdd_dl_scan_block::do_pdsch_decode_sib1(bool &switch_freq, int32 &done_flag)
 {
-    LIBLTE_PHY_SUBFRAME_STRUCT subframe;
-    LIBLTE_PHY_PCFICH_STRUCT   pcfich;
-    LIBLTE_PHY_PHICH_STRUCT    phich;
-    LIBLTE_PHY_PDCCH_STRUCT    pdcch;
-    if(!(LIBLTE_SUCCESS == liblte_phy_get_dl_subframe_and_ce(phy_struct,
-                                                             samp_buf,
-                                                             samp_buf_r_idx,
-                                                             5,
-                                                             N_id_cell,
-                                                             N_ant,
-                                                             &subframe) &&
-         LIBLTE_SUCCESS == liblte_phy_pdcch_channel_decode(phy_struct,
-                                                           &subframe,
-                                                           N_id_cell,
-                                                           N_ant,
-                                                           phich_res,
-                                                           phich_dur,
-                                                           &pcfich,
-                                                           &phich,
-                                                           &pdcch) &&
-         LIBLTE_SUCCESS == liblte_phy_pdsch_channel_decode(phy_struct,
-                                                           &subframe,
-                                                           &pdcch.dl_alloc[0],
-                                                           pdcch.N_symbs,
-                                                           N_id_cell,
-                                                           N_ant,
-                                                           N_TURBO_ITERATIONS,
-                                                           rrc_msg.msg,
-                                                           &rrc_msg.N_bits)))
+    LIBLTE_PHY_PCFICH_STRUCT pcfich;
+    LIBLTE_PHY_PHICH_STRUCT  phich;
+    LIBLTE_PHY_PDCCH_STRUCT  pdcch;
+    if(LIBLTE_SUCCESS != decode_pdcch_and_pdsch(5, &pcfich, &phich, &pdcch))
     {
         // Try to decode SIB1 again
         N_samps_needed  = phy_struct->N_samps_per_frame * PDSCH_DECODE_SIB1_NUM_FRAMES;
@@ -700,35 +694,10 @@ void liblte_fdd_dl_scan_block::do_pdsch_decode_sib1(bool &switch_freq, int32 &do
 void liblte_fdd_dl_scan_block::do_pdsch_decode_si_generic(bool  &switch_freq,
                                                           int32 &done_flag)
 {
-    LIBLTE_PHY_SUBFRAME_STRUCT subframe;
-    LIBLTE_PHY_PCFICH_STRUCT   pcfich;
-    LIBLTE_PHY_PHICH_STRUCT    phich;
-    LIBLTE_PHY_PDCCH_STRUCT    pdcch;
-    if(LIBLTE_SUCCESS == liblte_phy_get_dl_subframe_and_ce(phy_struct,
-                                                           samp_buf,
-                                                           samp_buf_r_idx,
-                                                           N_sfr,
-                                                           N_id_cell,
-                                                           N_ant,
-                                                           &subframe) &&
-       LIBLTE_SUCCESS == liblte_phy_pdcch_channel_decode(phy_struct,
-                                                         &subframe,
-                                                         N_id_cell,
-                                                         N_ant,
-                                                         phich_res,
-                                                         phich_dur,
-                                                         &pcfich,
-                                                         &phich,
-                                                         &pdcch) &&
-       LIBLTE_SUCCESS == liblte_phy_pdsch_channel_decode(phy_struct,
-                                                         &subframe,
-                                                         &pdcch.dl_alloc[0],
-                                                         pdcch.N_symbs,
-                                                         N_id_cell,
-                                                         N_ant,
-                                                         N_TURBO_ITERATIONS,
-                                                         rrc_msg.msg,
-                                                         &rrc_msg.N_bits))
+    LIBLTE_PHY_PCFICH_STRUCT pcfich;
+    LIBLTE_PHY_PHICH_STRUCT  phich;
+    LIBLTE_PHY_PDCCH_STRUCT  pdcch;
+    if(LIBLTE_SUCCESS == decode_pdcch_and_pdsch(N_sfr, &pcfich, &phich, &pdcch))
     {
         // Send a PCAP message
         send_pcap_cb(pdcch.dl_alloc[0].rnti, sfn*10 + subframe.num, rrc_msg);
@@ -775,6 +744,145 @@ void liblte_fdd_dl_scan_block::do_pdsch_decode_si_generic(bool  &switch_freq,
     }
 }
 
+LIBLTE_ERROR_ENUM liblte_fdd_dl_scan_block::decode_pdcch_and_pdsch(uint32                    sfr_num,
+                                                                   LIBLTE_PHY_PCFICH_STRUCT *pcfich,
+                                                                   LIBLTE_PHY_PHICH_STRUCT  *phich,
+                                                                   LIBLTE_PHY_PDCCH_STRUCT  *pdcch)
+{
+    LIBLTE_ERROR_ENUM err;
+    uint32            N_ctrl_symbs;
+    uint32            first_prb;
+    uint32            last_prb;
+
+    // Demodulate the largest possible control region first
+    N_ctrl_symbs = 3;
+    if(phy_struct->N_rb_dl <= 10)
+        N_ctrl_symbs = 4;
+    err = liblte_phy_get_dl_subframe_and_ce(phy_struct,
+                                            samp_buf,
+                                            samp_buf_gen,
+                                            samp_buf_r_idx,
+                                            sfr_num,
+                                            N_id_cell,
+                                            N_ant,
+                                            0,
+                                            phy_struct->N_rb_dl,
+                                            0,
+                                            N_ctrl_symbs,
+                                            &subframe);
+    if(LIBLTE_SUCCESS != err)
+        return(err);
+    err = liblte_phy_pdcch_channel_decode(phy_struct,
+                                          &subframe,
+                                          N_id_cell,
+                                          N_ant,
+                                          phich_res,
+                                          phich_dur,
+                                          pcfich,
+                                          phich,
+                                          pdcch);
+    if(LIBLTE_SUCCESS != err)
+        return(err);
+    if(0 == pdcch->N_dl_alloc ||
+       0 == pdcch->dl_alloc[0].N_prb)
+        return(LIBLTE_ERROR_DECODE_FAIL);
+
+    // Then only the PRBs and symbols of the allocation
+    first_prb = phy_struct->N_rb_dl;
+    last_prb  = 0;
+    for(uint32 i=0; i<LIBLTE_PHY_N_SLOTS_PER_SUBFR; i++)
+    {
+        for(uint32 j=0; j<pdcch->dl_alloc[0].N_prb; j++)
+        {
+            if(pdcch->dl_alloc[0].prb[i][j] < first_prb)
+                first_prb = pdcch->dl_alloc[0].prb[i][j];
+            if(pdcch->dl_alloc[0].prb[i][j] > last_prb)
+                last_prb = pdcch->dl_alloc[0].prb[i][j];
+        }
+    }
+    if(last_prb >= phy_struct->N_rb_dl)
+        return(LIBLTE_ERROR_DECODE_FAIL);
+    err = liblte_phy_get_dl_subframe_and_ce(phy_struct,
+                                            samp_buf,
+                                            samp_buf_gen,
+                                            samp_buf_r_idx,
+                                            sfr_num,
+                                            N_id_cell,
+                                            N_ant,
+                                            first_prb,
+                                            last_prb - first_prb + 1,
+                                            pdcch->N_symbs,
+                                            14 - pdcch->N_symbs,
+                                            &subframe);
+    if(LIBLTE_SUCCESS != err)
+        return(err);
+    return(liblte_phy_pdsch_channel_decode(phy_struct,
+                                           &subframe,
+                                           &pdcch->dl_alloc[0],
+                                           pdcch->N_symbs,
+                                           N_id_cell,
+                                           N_ant,
+                                           N_TURBO_ITERATIONS,
+                                           rrc_msg.msg,
+                                           &rrc_msg.N_bits));
+}
+
+void liblte_fdd_dl_scan_block::alloc_samp_buf(void)
+{
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    int    fd;
+    void  *base;
+
+    // Map the same pages twice, back to back, so that any window of up
+    // to samp_buf_size samples starting inside the first copy is
+    // contiguous
+    samp_buf_ring       = NULL;
+    samp_buf_ring_idx   = 0;
+    samp_buf_ring_bytes = samp_buf_size * sizeof(complex);
+    samp_buf_ring_bytes = ((samp_buf_ring_bytes + page_size - 1) / page_size) * page_size;
+    fd                  = memfd_create("liblte_fdd_dl_scan_block", 0);
+    if(-1 != fd)
+    {
+        base = MAP_FAILED;
+        if(0 == ftruncate(fd, samp_buf_ring_bytes))
+            base = mmap(NULL, 2*samp_buf_ring_bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(MAP_FAILED != base)
+        {
+            if(MAP_FAILED != mmap(base, samp_buf_ring_bytes, PROT_READ | PROT_WRITE,
+                                  MAP_SHARED | MAP_FIXED, fd, 0) &&
+               MAP_FAILED != mmap((uint8 *)base + samp_buf_ring_bytes, samp_buf_ring_bytes,
+                                  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0))
+            {
+                samp_buf_ring = (complex *)base;
+            }else{
+                munmap(base, 2*samp_buf_ring_bytes);
+            }
+        }
+        close(fd);
+    }
+
+    if(NULL != samp_buf_ring)
+    {
+        samp_buf_size = samp_buf_ring_bytes / sizeof(complex);
+        samp_buf      = samp_buf_ring;
+    }else{
+        // Fall back to a flat buffer that is compacted by copying
+        samp_buf = (complex *)malloc(samp_buf_size * sizeof(complex));
+    }
+}
+
+void liblte_fdd_dl_scan_block::free_samp_buf(void)
+{
+    if(NULL != samp_buf_ring)
+    {
+        munmap(samp_buf_ring, 2*samp_buf_ring_bytes);
+        samp_buf_ring = NULL;
+    }else{
+        free(samp_buf);
+    }
+    samp_buf = NULL;
+}
+
 void liblte_fdd_dl_scan_block::copy_input_to_samp_buf(gr_vector_const_void_star &input_items,
                                                       int32                      ninput_items)
 {
@@ -811,6 +919,7 @@ void liblte_fdd_dl_scan_block::freq_shift(uint32 start_idx, uint32 num_samps,
 {
     if(state == LIBLTE_FDD_DL_SCAN_BLOCK_STATE_COARSE_TIMING_SEARCH)
         return;
+    samp_buf_gen++;
     for(uint32 i=start_idx; i<(start_idx+num_samps); i++)
         samp_buf[i] = samp_buf[i] *
             std::conj(std::polar<float>(1, (i+1)*freq_offset*2*M_PI/phy_struct->fs));
@@ -77,6 +77,12 @@ uint32 bsr_min_buffer_size[64] = {     0,      0,     10,     12,     14,     17
                                    14099,  16507,  19325,  22624,  26487,  31009,  36304,  42502,
                                    49759,  58255,  68201,  79864,  93479, 109439, 128125, 150000};
 
+// Approximate PUSCH SINR in dB needed for 10% BLER, indexed by uplink MCS
+float ul_mcs_min_sinr_db[LIBLTE_MAC_UL_SCHED_MAX_MCS+1] = {-1.0, -0.2,  0.6,  1.4,  2.2,  3.0,  3.8,  4.6,
+                                                             5.4,  6.2,  7.0,  7.6,  8.4,  9.2, 10.0, 10.8,
+                                                            11.6, 12.4, 13.2, 14.0, 14.8, 15.6, 16.4, 17.2,
+                                                            18.0, 18.8, 19.6, 20.4, 21.2};
+
 /*******************************************************************************
                               CONTROL ELEMENT FUNCTIONS
 *******************************************************************************/
@@ -784,6 +790,148 @@ LIBLTE_ERROR_ENUM liblte_mac_unpack_mac_pdu(LIBLTE_BIT_MSG_STRUCT *msg,
     return LIBLTE_SUCCESS;
 }
 
+/*********************************************************************
+    PDU Name: DL-SCH MAC PDU sized to a transport block
+
+    Description: Byte aligned DL-SCH MAC PDU packed in a single pass
+                 and padded to exactly fill a transport block
+
+    Document Reference: 36.321 v10.2.0 Sections 6.1.2 and 6.2.1
+*********************************************************************/
+bool dlsch_is_ce(uint32 lcid)
+{
+    return(LIBLTE_MAC_DLSCH_ACTIVATION_DEACTIVATION_LCID     == lcid ||
+           LIBLTE_MAC_DLSCH_UE_CONTENTION_RESOLUTION_ID_LCID == lcid ||
+           LIBLTE_MAC_DLSCH_TA_COMMAND_LCID                  == lcid ||
+           LIBLTE_MAC_DLSCH_DRX_COMMAND_LCID                 == lcid ||
+           LIBLTE_MAC_DLSCH_PADDING_LCID                     == lcid);
+}
+uint32 dlsch_length_field_size(uint32 N_bytes)
+{
+    if(N_bytes < 128)
+        return 1;
+    return 2;
+}
+uint32 dlsch_payload_size(LIBLTE_MAC_PDU_SUBHEADER_STRUCT *subheader)
+{
+    if(LIBLTE_MAC_DLSCH_ACTIVATION_DEACTIVATION_LCID == subheader->lcid)
+        return LIBLTE_MAC_ACTIVATION_DEACTIVATION_CE_N_BYTES;
+    if(LIBLTE_MAC_DLSCH_UE_CONTENTION_RESOLUTION_ID_LCID == subheader->lcid)
+        return LIBLTE_MAC_UE_CONTENTION_RESOLUTION_ID_CE_N_BYTES;
+    if(LIBLTE_MAC_DLSCH_TA_COMMAND_LCID == subheader->lcid)
+        return LIBLTE_MAC_TA_COMMAND_CE_N_BYTES;
+    if(dlsch_is_ce(subheader->lcid))
+        return 0;
+    return subheader->payload.sdu.N_bytes;
+}
+uint32 liblte_mac_get_dlsch_mac_pdu_size(LIBLTE_MAC_PDU_STRUCT *mac_pdu)
+{
+    uint32 N_bytes = 0;
+
+    if(mac_pdu == NULL)
+        return 0;
+
+    for(uint32 i=0; i<mac_pdu->N_subheaders; i++)
+    {
+        N_bytes += LIBLTE_MAC_DLSCH_CE_SUBHEADER_N_BYTES + dlsch_payload_size(&mac_pdu->subheader[i]);
+        if(i != (mac_pdu->N_subheaders-1) &&
+           !dlsch_is_ce(mac_pdu->subheader[i].lcid))
+            N_bytes += dlsch_length_field_size(mac_pdu->subheader[i].payload.sdu.N_bytes);
+    }
+
+    return N_bytes;
+}
+LIBLTE_ERROR_ENUM liblte_mac_pack_dlsch_mac_pdu(LIBLTE_MAC_PDU_STRUCT  *mac_pdu,
+                                                uint32                  N_tb_bytes,
+                                                LIBLTE_BYTE_MSG_STRUCT *pdu)
+{
+    if(mac_pdu == NULL || pdu == NULL)
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    if(LIBLTE_MAC_CHAN_TYPE_DLSCH != mac_pdu->chan_type ||
+       LIBLTE_MAC_MAX_MAC_PDU_N_SUBHEADERS < mac_pdu->N_subheaders ||
+       LIBLTE_MAX_MSG_SIZE < N_tb_bytes)
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    uint32 N_bytes = liblte_mac_get_dlsch_mac_pdu_size(mac_pdu);
+    if(N_bytes > N_tb_bytes)
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    // Up to two bytes of padding are sent as single byte padding
+    // subheaders at the start of the header, anything more as a
+    // padding subheader after the last subheader, which then needs
+    // a length field of its own
+    uint32 N_pad          = N_tb_bytes - N_bytes;
+    uint32 N_lead_pad     = 0;
+    uint32 N_trailing_pad = 0;
+    if(N_pad <= 2)
+    {
+        N_lead_pad = N_pad;
+    }else{
+        N_trailing_pad = 1;
+        if(0 != mac_pdu->N_subheaders &&
+           !dlsch_is_ce(mac_pdu->subheader[mac_pdu->N_subheaders-1].lcid))
+            N_pad -= dlsch_length_field_size(mac_pdu->subheader[mac_pdu->N_subheaders-1].payload.sdu.N_bytes);
+        N_pad--;
+    }
+    if(LIBLTE_MAC_MAX_MAC_PDU_N_SUBHEADERS < (N_lead_pad + mac_pdu->N_subheaders + N_trailing_pad))
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    // Pack the subheaders
+    uint8  *msg_ptr      = pdu->msg;
+    uint32  N_subheaders = N_lead_pad + mac_pdu->N_subheaders + N_trailing_pad;
+    uint32  idx          = 0;
+    for(uint32 i=0; i<N_lead_pad; i++)
+        *msg_ptr++ = ((++idx != N_subheaders) << 5) | LIBLTE_MAC_DLSCH_PADDING_LCID;
+    for(uint32 i=0; i<mac_pdu->N_subheaders; i++)
+    {
+        bool e_bit = (++idx != N_subheaders);
+        *msg_ptr++ = (e_bit << 5) | (mac_pdu->subheader[i].lcid & 0x1F);
+        if(!e_bit || dlsch_is_ce(mac_pdu->subheader[i].lcid))
+            continue;
+        uint32 length = mac_pdu->subheader[i].payload.sdu.N_bytes;
+        if(1 == dlsch_length_field_size(length))
+        {
+            *msg_ptr++ = length;
+        }else{
+            *msg_ptr++ = 0x80 | ((length >> 8) & 0x7F); // F
+            *msg_ptr++ = length & 0xFF;
+        }
+    }
+    if(N_trailing_pad)
+        *msg_ptr++ = LIBLTE_MAC_DLSCH_PADDING_LCID;
+
+    // Pack the control elements and SDUs
+    for(uint32 i=0; i<mac_pdu->N_subheaders; i++)
+    {
+        LIBLTE_MAC_SUBHEADER_PAYLOAD_UNION *payload = &mac_pdu->subheader[i].payload;
+        if(LIBLTE_MAC_DLSCH_ACTIVATION_DEACTIVATION_LCID == mac_pdu->subheader[i].lcid)
+        {
+            *msg_ptr++ = ((payload->act_deact.c7 << 7) |
+                          (payload->act_deact.c6 << 6) |
+                          (payload->act_deact.c5 << 5) |
+                          (payload->act_deact.c4 << 4) |
+                          (payload->act_deact.c3 << 3) |
+                          (payload->act_deact.c2 << 2) |
+                          (payload->act_deact.c1 << 1));
+        }else if(LIBLTE_MAC_DLSCH_UE_CONTENTION_RESOLUTION_ID_LCID == mac_pdu->subheader[i].lcid){
+            for(int32 j=LIBLTE_MAC_UE_CONTENTION_RESOLUTION_ID_CE_N_BYTES-1; j>=0; j--)
+                *msg_ptr++ = (payload->ue_con_res_id.id >> (j*8)) & 0xFF;
+        }else if(LIBLTE_MAC_DLSCH_TA_COMMAND_LCID == mac_pdu->subheader[i].lcid){
+            *msg_ptr++ = payload->ta_command.ta & 0x3F;
+        }else if(!dlsch_is_ce(mac_pdu->subheader[i].lcid)){
+            memcpy(msg_ptr, payload->sdu.msg, payload->sdu.N_bytes);
+            msg_ptr += payload->sdu.N_bytes;
+        }
+    }
+
+    // Fill the rest of the transport block with padding
+    memset(msg_ptr, 0, N_pad - N_lead_pad);
+    pdu->N_bytes = N_tb_bytes;
+
+    return LIBLTE_SUCCESS;
+}
+
 /*********************************************************************
     PDU Name: Transparent
 
@@ -885,3 +1033,165 @@ LIBLTE_ERROR_ENUM liblte_mac_unpack_random_access_response_pdu(LIBLTE_BIT_MSG_ST
 
     return LIBLTE_ERROR_INVALID_INPUTS;
 }
+
+/*********************************************************************
+    Name: Downlink scheduler
+
+    Description: Orders the UEs with downlink data according to a
+                 scheduling policy and assigns PRB sets using
+                 resource allocation type 0 or type 2.  The work per
+                 TTI is bounded by LIBLTE_MAC_DL_SCHED_MAX_N_UE.
+
+    Document Reference: 36.213 v10.3.0 Sections 7.1.6.1 and 7.1.6.3
+*********************************************************************/
+float dl_sched_metric(LIBLTE_MAC_DL_SCHED_POLICY_ENUM  policy,
+                      LIBLTE_MAC_DL_SCHED_UE_STRUCT   *ue,
+                      uint32                           current_tti)
+{
+    if(LIBLTE_MAC_DL_SCHED_POLICY_ROUND_ROBIN == policy)
+        return (float)((current_tti + LIBLTE_MAC_DL_SCHED_N_TTIS - ue->last_tti) % LIBLTE_MAC_DL_SCHED_N_TTIS);
+    if(LIBLTE_MAC_DL_SCHED_POLICY_MAX_CI == policy)
+        return (float)ue->inst_rate;
+
+    // Proportional fair, a UE that has received nothing is
+    // treated as having received one bit per TTI
+    if(ue->avg_thruput < 1)
+        return (float)ue->inst_rate;
+    return (float)ue->inst_rate / ue->avg_thruput;
+}
+LIBLTE_ERROR_ENUM liblte_mac_dl_sched_order(LIBLTE_MAC_DL_SCHED_POLICY_ENUM  policy,
+                                            LIBLTE_MAC_DL_SCHED_UE_STRUCT   *ue,
+                                            uint32                           N_ue,
+                                            uint32                           current_tti,
+                                            uint32                          *order)
+{
+    float metric[LIBLTE_MAC_DL_SCHED_MAX_N_UE];
+
+    if(ue     == NULL                               ||
+       order  == NULL                               ||
+       N_ue   >  LIBLTE_MAC_DL_SCHED_MAX_N_UE       ||
+       policy >= LIBLTE_MAC_DL_SCHED_POLICY_N_ITEMS)
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    // Stable insertion sort on the metric, ties keep the caller's
+    // order so rotating the input shares ties out
+    for(uint32 i=0; i<N_ue; i++)
+    {
+        float  m = dl_sched_metric(policy, &ue[i], current_tti);
+        uint32 j = i;
+        while(j > 0 && metric[j-1] < m)
+        {
+            metric[j] = metric[j-1];
+            order[j]  = order[j-1];
+            j--;
+        }
+        metric[j] = m;
+        order[j]  = i;
+    }
+
+    return LIBLTE_SUCCESS;
+}
+void liblte_mac_dl_sched_update(LIBLTE_MAC_DL_SCHED_UE_STRUCT *ue,
+                                uint32                         current_tti,
+                                uint32                         N_bits)
+{
+    if(ue == NULL)
+        return;
+
+    ue->avg_thruput += ((float)N_bits - ue->avg_thruput) / LIBLTE_MAC_DL_SCHED_PF_N_TTIS;
+    if(0 != N_bits)
+        ue->last_tti = current_tti;
+}
+LIBLTE_ERROR_ENUM liblte_mac_dl_sched_alloc_prbs(LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_ENUM  ra_type,
+                                                 uint32                                    rbg_size,
+                                                 uint32                                    N_rb_dl,
+                                                 uint32                                    N_prb_req,
+                                                 bool                                     *prb_used,
+                                                 uint32                                   *prb,
+                                                 uint32                                   *N_prb)
+{
+    if(prb_used  == NULL                          ||
+       prb       == NULL                          ||
+       N_prb     == NULL                          ||
+       N_rb_dl   == 0                             ||
+       N_rb_dl   >  LIBLTE_MAC_DL_SCHED_MAX_N_RB  ||
+       rbg_size  == 0                             ||
+       N_prb_req == 0)
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    *N_prb = 0;
+    if(LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_0 == ra_type)
+    {
+        // Lowest free RBGs until the request is covered, the last
+        // RBG may be smaller than rbg_size
+        for(uint32 rbg_start=0; rbg_start<N_rb_dl && *N_prb<N_prb_req; rbg_start+=rbg_size)
+        {
+            uint32 rbg_end = rbg_start + rbg_size;
+            if(rbg_end > N_rb_dl)
+                rbg_end = N_rb_dl;
+            bool free = true;
+            for(uint32 i=rbg_start; i<rbg_end; i++)
+                if(prb_used[i])
+                    free = false;
+            if(!free)
+                continue;
+            for(uint32 i=rbg_start; i<rbg_end; i++)
+            {
+                prb_used[i]     = true;
+                prb[(*N_prb)++] = i;
+            }
+        }
+    }else if(LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_2 == ra_type){
+        // First free run that fits the request, otherwise the
+        // longest free run
+        uint32 best_start  = 0;
+        uint32 best_length = 0;
+        uint32 run_start   = 0;
+        for(uint32 i=0; i<=N_rb_dl && best_length<N_prb_req; i++)
+        {
+            if(i < N_rb_dl && !prb_used[i])
+                continue;
+            if(i - run_start > best_length)
+            {
+                best_start  = run_start;
+                best_length = i - run_start;
+            }
+            run_start = i + 1;
+        }
+        if(best_length > N_prb_req)
+            best_length = N_prb_req;
+        for(uint32 i=best_start; i<best_start+best_length; i++)
+        {
+            prb_used[i]     = true;
+            prb[(*N_prb)++] = i;
+        }
+    }else{
+        return LIBLTE_ERROR_INVALID_INPUTS;
+    }
+
+    return LIBLTE_SUCCESS;
+}
+
+/*********************************************************************
+    Name: Uplink link adaptation
+
+    Description: Selects the highest uplink MCS whose SINR threshold
+                 is met by a PUSCH SINR estimate.  Any outer loop
+                 offset is applied by the caller.
+
+    Document Reference: 36.213 v10.3.0 Section 8.6.1
+*********************************************************************/
+LIBLTE_ERROR_ENUM liblte_mac_ul_sched_get_mcs(float  sinr_db,
+                                              uint8  max_mcs,
+                                              uint8 *mcs)
+{
+    if(mcs == NULL || max_mcs > LIBLTE_MAC_UL_SCHED_MAX_MCS)
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    *mcs = 0;
+    for(uint32 i=1; i<=max_mcs; i++)
+        if(sinr_db >= ul_mcs_min_sinr_db[i])
+            *mcs = i;
+
+    return LIBLTE_SUCCESS;
+}
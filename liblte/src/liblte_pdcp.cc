@@ -59,6 +59,25 @@
 *******************************************************************************/
 
 
+/*******************************************************************************
+                              LOCAL FUNCTION PROTOTYPES
+*******************************************************************************/
+
+void pdcp_compute_mac(LIBLTE_PDCP_SECURITY_CONFIG_STRUCT *sec,
+                      uint32                              count,
+                      uint8                               rb_id,
+                      uint8                               direction,
+                      uint8                              *msg,
+                      uint32                              msg_len,
+                      uint8                              *mac);
+void pdcp_cipher(LIBLTE_PDCP_SECURITY_CONFIG_STRUCT *sec,
+                 uint32                              count,
+                 uint8                               rb_id,
+                 uint8                               direction,
+                 uint8                              *msg,
+                 uint32                              msg_len);
+
+
 /*******************************************************************************
                               PDU FUNCTIONS
 *******************************************************************************/
@@ -77,7 +96,7 @@ LIBLTE_ERROR_ENUM liblte_pdcp_pack_control_pdu(LIBLTE_PDCP_CONTROL_PDU_STRUCT *c
                                                LIBLTE_BIT_MSG_STRUCT          *data,
                                                LIBLTE_BYTE_MSG_STRUCT         *pdu)
 {
-    return liblte_pdcp_pack_control_pdu(contents, data, NULL, 0, 0, pdu);
+    return liblte_pdcp_pack_control_pdu(contents, data, (LIBLTE_PDCP_SECURITY_CONFIG_STRUCT *)NULL, 0, 0, pdu);
 }
 LIBLTE_ERROR_ENUM liblte_pdcp_pack_control_pdu(LIBLTE_PDCP_CONTROL_PDU_STRUCT *contents,
                                                uint8                          *key_256,
@@ -93,6 +112,22 @@ LIBLTE_ERROR_ENUM liblte_pdcp_pack_control_pdu(LIBLTE_PDCP_CONTROL_PDU_STRUCT *c
                                                uint8                           direction,
                                                uint8                           rb_id,
                                                LIBLTE_BYTE_MSG_STRUCT         *pdu)
+{
+    LIBLTE_PDCP_SECURITY_CONFIG_STRUCT sec;
+
+    sec.k_int = key_256;
+    sec.k_enc = NULL;
+    sec.eia   = LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA2;
+    sec.eea   = LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_EEA0;
+
+    return liblte_pdcp_pack_control_pdu(contents, data, &sec, direction, rb_id, pdu);
+}
+LIBLTE_ERROR_ENUM liblte_pdcp_pack_control_pdu(LIBLTE_PDCP_CONTROL_PDU_STRUCT     *contents,
+                                               LIBLTE_BIT_MSG_STRUCT              *data,
+                                               LIBLTE_PDCP_SECURITY_CONFIG_STRUCT *sec,
+                                               uint8                               direction,
+                                               uint8                               rb_id,
+                                               LIBLTE_BYTE_MSG_STRUCT             *pdu)
 {
     if(contents == NULL || data == NULL || pdu == NULL)
         return LIBLTE_ERROR_INVALID_INPUTS;
@@ -120,7 +155,7 @@ LIBLTE_ERROR_ENUM liblte_pdcp_pack_control_pdu(LIBLTE_PDCP_CONTROL_PDU_STRUCT *c
     }
 
     // MAC
-    if(NULL == key_256)
+    if(NULL == sec || NULL == sec->k_int)
     {
         *pdu_ptr = (LIBLTE_PDCP_CONTROL_MAC_I >> 24) & 0xFF;
         pdu_ptr++;
@@ -131,20 +166,27 @@ LIBLTE_ERROR_ENUM liblte_pdcp_pack_control_pdu(LIBLTE_PDCP_CONTROL_PDU_STRUCT *c
         *pdu_ptr = LIBLTE_PDCP_CONTROL_MAC_I & 0xFF;
         pdu_ptr++;
     }else{
-        pdu->N_bytes = pdu_ptr - pdu->msg;
-        liblte_security_128_eia2(&key_256[16],
-                                 contents->count,
-                                 rb_id,
-                                 direction,
-                                 pdu->msg,
-                                 pdu->N_bytes,
-                                 pdu_ptr);
+        pdcp_compute_mac(sec,
+                         contents->count,
+                         rb_id,
+                         direction,
+                         pdu->msg,
+                         pdu_ptr - pdu->msg,
+                         pdu_ptr);
         pdu_ptr += 4;
     }
 
     // Fill in the number of bytes used
     pdu->N_bytes = pdu_ptr - pdu->msg;
 
+    // Cipher data and MAC
+    pdcp_cipher(sec,
+                contents->count,
+                rb_id,
+                direction,
+                &pdu->msg[1],
+                pdu->N_bytes - 1);
+
     return LIBLTE_SUCCESS;
 }
 LIBLTE_ERROR_ENUM liblte_pdcp_unpack_control_pdu(LIBLTE_BYTE_MSG_STRUCT         *pdu,
@@ -170,6 +212,45 @@ LIBLTE_ERROR_ENUM liblte_pdcp_unpack_control_pdu(LIBLTE_BYTE_MSG_STRUCT
 
     return LIBLTE_SUCCESS;
 }
+LIBLTE_ERROR_ENUM liblte_pdcp_unpack_control_pdu(LIBLTE_BYTE_MSG_STRUCT             *pdu,
+                                                 LIBLTE_PDCP_SECURITY_CONFIG_STRUCT *sec,
+                                                 uint32                              count,
+                                                 uint8                               direction,
+                                                 uint8                               rb_id,
+                                                 LIBLTE_PDCP_CONTROL_PDU_STRUCT     *contents)
+{
+    if(pdu == NULL || sec == NULL || contents == NULL || pdu->N_bytes < 5)
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    uint8 mac[4];
+
+    // Decipher data and MAC
+    pdcp_cipher(sec,
+                count,
+                rb_id,
+                direction,
+                &pdu->msg[1],
+                pdu->N_bytes - 1);
+
+    // Verify MAC
+    if(NULL != sec->k_int)
+    {
+        pdcp_compute_mac(sec,
+                         count,
+                         rb_id,
+                         direction,
+                         pdu->msg,
+                         pdu->N_bytes - 4,
+                         mac);
+        if(0 != memcmp(mac, &pdu->msg[pdu->N_bytes - 4], 4))
+            return LIBLTE_ERROR_INVALID_CRC;
+    }
+
+    liblte_pdcp_unpack_control_pdu(pdu, contents);
+    contents->count = count;
+
+    return LIBLTE_SUCCESS;
+}
 
 /*********************************************************************
     PDU Type: User Plane PDCP Data PDU with long PDCP SN
@@ -205,6 +286,26 @@ LIBLTE_ERROR_ENUM liblte_pdcp_pack_data_pdu_with_long_sn(LIBLTE_PDCP_DATA_PDU_WI
 
     return LIBLTE_SUCCESS;
 }
+LIBLTE_ERROR_ENUM liblte_pdcp_pack_data_pdu_with_long_sn(LIBLTE_PDCP_DATA_PDU_WITH_LONG_SN_STRUCT *contents,
+                                                         LIBLTE_BYTE_MSG_STRUCT                   *data,
+                                                         LIBLTE_PDCP_SECURITY_CONFIG_STRUCT       *sec,
+                                                         uint8                                     direction,
+                                                         uint8                                     rb_id,
+                                                         LIBLTE_BYTE_MSG_STRUCT                   *pdu)
+{
+    if(LIBLTE_SUCCESS != liblte_pdcp_pack_data_pdu_with_long_sn(contents, data, pdu))
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    // Cipher data
+    pdcp_cipher(sec,
+                contents->count,
+                rb_id,
+                direction,
+                &pdu->msg[2],
+                pdu->N_bytes - 2);
+
+    return LIBLTE_SUCCESS;
+}
 LIBLTE_ERROR_ENUM liblte_pdcp_unpack_data_pdu_with_long_sn(LIBLTE_BYTE_MSG_STRUCT                   *pdu,
                                                            LIBLTE_PDCP_DATA_PDU_WITH_LONG_SN_STRUCT *contents)
 {
@@ -227,6 +328,30 @@ LIBLTE_ERROR_ENUM liblte_pdcp_unpack_data_pdu_with_long_sn(LIBLTE_BYTE_MSG_STRUC
 
     return LIBLTE_SUCCESS;
 }
+LIBLTE_ERROR_ENUM liblte_pdcp_unpack_data_pdu_with_long_sn(LIBLTE_BYTE_MSG_STRUCT                   *pdu,
+                                                           LIBLTE_PDCP_SECURITY_CONFIG_STRUCT       *sec,
+                                                           uint32                                    count,
+                                                           uint8                                     direction,
+                                                           uint8                                     rb_id,
+                                                           LIBLTE_PDCP_DATA_PDU_WITH_LONG_SN_STRUCT *contents)
+{
+    if(pdu == NULL || sec == NULL || contents == NULL || pdu->N_bytes < 2)
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    if(LIBLTE_SUCCESS != liblte_pdcp_unpack_data_pdu_with_long_sn(pdu, contents))
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    // Decipher data
+    pdcp_cipher(sec,
+                count,
+                rb_id,
+                direction,
+                contents->data.msg,
+                contents->data.N_bytes);
+    contents->count = count;
+
+    return LIBLTE_SUCCESS;
+}
 
 /*********************************************************************
     PDU Type: User Plane PDCP Data PDU with short PDCP SN
@@ -437,3 +562,74 @@ LIBLTE_ERROR_ENUM liblte_pdcp_unpack_rn_user_plane_data_pdu(LIBLTE_BYTE_MSG_STRU
 
     return LIBLTE_SUCCESS;
 }
+
+/*******************************************************************************
+                              LOCAL FUNCTIONS
+*******************************************************************************/
+
+/*********************************************************************
+    Name: pdcp_compute_mac
+
+    Description: Computes the MAC-I of a PDCP PDU with the negotiated
+                 integrity algorithm.  EIA0 produces a zero MAC-I.
+
+    Document Reference: 36.323 v10.1.0 Section 5.7
+*********************************************************************/
+void pdcp_compute_mac(LIBLTE_PDCP_SECURITY_CONFIG_STRUCT *sec,
+                      uint32                              count,
+                      uint8                               rb_id,
+                      uint8                               direction,
+                      uint8                              *msg,
+                      uint32                              msg_len,
+                      uint8                              *mac)
+{
+    switch(sec->eia)
+    {
+    case LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA1:
+        liblte_security_128_eia1(&sec->k_int[16], count, rb_id, direction, msg, msg_len, mac);
+        break;
+    case LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA2:
+        liblte_security_128_eia2(&sec->k_int[16], count, rb_id, direction, msg, msg_len, mac);
+        break;
+    case LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA3:
+        liblte_security_128_eia3(&sec->k_int[16], count, rb_id, direction, msg, msg_len, mac);
+        break;
+    default:
+        memset(mac, 0, 4);
+        break;
+    }
+}
+
+/*********************************************************************
+    Name: pdcp_cipher
+
+    Description: Ciphers or deciphers a PDCP PDU payload in place with
+                 the negotiated ciphering algorithm.
+
+    Document Reference: 36.323 v10.1.0 Section 5.6
+*********************************************************************/
+void pdcp_cipher(LIBLTE_PDCP_SECURITY_CONFIG_STRUCT *sec,
+                 uint32                              count,
+                 uint8                               rb_id,
+                 uint8                               direction,
+                 uint8                              *msg,
+                 uint32                              msg_len)
+{
+    if(NULL == sec || NULL == sec->k_enc || 0 == msg_len)
+        return;
+
+    switch(sec->eea)
+    {
+    case LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA1:
+        liblte_security_encryption_eea1(&sec->k_enc[16], count, rb_id, direction, msg, msg_len, msg);
+        break;
+    case LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA2:
+        liblte_security_encryption_eea2(&sec->k_enc[16], count, rb_id, direction, msg, msg_len, msg);
+        break;
+    case LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA3:
+        liblte_security_encryption_eea3(&sec->k_enc[16], count, rb_id, direction, msg, msg_len, msg);
+        break;
+    default:
+        break;
+    }
+}
@@ -153,6 +153,19 @@
 
 #define N_SYMB_DL_NORMAL_CP 7
 
+// Build with -DLIBLTE_PHY_HAVE_SIMD=0 to force the scalar sample
+// conversions and pre coder kernels
+#ifndef LIBLTE_PHY_HAVE_SIMD
+#if defined(__x86_64__)
+#define LIBLTE_PHY_HAVE_SIMD 1
+#else
+#define LIBLTE_PHY_HAVE_SIMD 0
+#endif
+#endif
+#if LIBLTE_PHY_HAVE_SIMD
+#include <immintrin.h>
+#endif
+
 /*******************************************************************************
                               TYPEDEFS
 *******************************************************************************/
@@ -402,6 +415,18 @@ complex PHICH_w_extended_cp_6_9_1_2[4][2] = {{complex( 1, 0),complex( 1, 0)},
                                              {complex( 0, 1),complex( 0, 1)},
                                              {complex( 0, 1),complex( 0,-1)}};
 
+// Codebook for antenna ports {0,1} from 3GPP TS 36.211 v10.1.0 table 6.3.4.2.3-1
+complex CODEBOOK_6_3_4_2_3_1_1_LAYER[4][2] = {{complex(1/sqrt(2), 0),complex( 1/sqrt(2), 0)},
+                                              {complex(1/sqrt(2), 0),complex(-1/sqrt(2), 0)},
+                                              {complex(1/sqrt(2), 0),complex( 0, 1/sqrt(2))},
+                                              {complex(1/sqrt(2), 0),complex( 0,-1/sqrt(2))}};
+complex CODEBOOK_6_3_4_2_3_1_2_LAYERS[3][2][2] = {{{complex(1/sqrt(2), 0),complex(0, 0)},
+                                                   {complex(0, 0),complex(1/sqrt(2), 0)}},
+                                                  {{complex(0.5, 0),complex( 0.5, 0)},
+                                                   {complex(0.5, 0),complex(-0.5, 0)}},
+                                                  {{complex(0.5, 0),complex( 0.5, 0)},
+                                                   {complex(0, 0.5),complex( 0,-0.5)}}};
+
 // BPSK symbols from 3GPP TS 36.211 v10.1.0 table 7.1.1-1
 complex mod_map_bpsk[2] = {complex( 1/sqrt(2), 1/sqrt(2)),complex(-1/sqrt(2), 1/sqrt(2))};
 
@@ -797,6 +822,22 @@ uint32 TBS_71723[32] = {  40,  56,  72, 120, 136, 144, 176, 208, 224, 256, 280,
                               LOCAL FUNCTION PROTOTYPES
 *******************************************************************************/
 
+/*********************************************************************
+    Name: avx2_supported
+
+    Description: Checks whether the CPU supports AVX2, once.
+
+    Document Reference: N/A
+*********************************************************************/
+#if LIBLTE_PHY_HAVE_SIMD
+static bool avx2_supported(void)
+{
+    static const bool supported = __builtin_cpu_supports("avx2");
+
+    return supported;
+}
+#endif
+
 /*********************************************************************
     Name: layer_mapper_ul / layer_demapper_ul
 
@@ -1455,7 +1496,7 @@ void prach_preamble_seq_gen(LIBLTE_PHY_STRUCT *phy_struct,
 
     Document Reference: 3GPP TS 36.211 v10.1.0 section 6.3.3
 
-    Notes: Currently only supports single antenna or TX diversity
+    Notes: For spatial multiplexing N_ant is the number of layers
 *********************************************************************/
 // Defines
 #define RX_NULL_SYMB 10000
@@ -1598,13 +1639,26 @@ void layer_demapper_dl(complex                        *x,
                        complex                        *d,
                        uint32                         *M_symb)
 {
-    // FIXME: Only supports TX diversity
     // Index all arrays
     complex *x_ptr[N_ant];
     for(uint32 p=0; p<N_ant; p++)
         x_ptr[p] = &x[p*M_layer_symb];
 
-    // 3GPP TS 36.211 v10.1.0 sections 6.3.3.1 and 6.3.3.3
+    if(LIBLTE_PHY_PRE_CODER_TYPE_SPATIAL_MULTIPLEXING == type &&
+       N_ant                                          == 2    &&
+       N_codewords                                    == 2)
+    {
+        // 3GPP TS 36.211 v10.1.0 section 6.3.3.2
+        *M_symb = M_layer_symb;
+        for(uint32 i=0; i<M_layer_symb; i++)
+        {
+            d[i]              = x_ptr[0][i];
+            d[M_layer_symb+i] = x_ptr[1][i];
+        }
+        return;
+    }
+
+    // 3GPP TS 36.211 v10.1.0 sections 6.3.3.1, 6.3.3.2, and 6.3.3.3
     *M_symb = M_layer_symb*N_ant;
     if(N_ant                    == 4                                   &&
        x_ptr[2][M_layer_symb-1] == complex(RX_NULL_SYMB, RX_NULL_SYMB) &&
@@ -1620,178 +1674,586 @@ void layer_demapper_dl(complex                        *x,
     Name: pre_coder_dl / de_pre_coder_dl
 
     Description: Generates a block of vectors to be mapped onto
-                 resources on each downlink antenna port / Alamouti
-                 decodes a block of vectors from resources on each
-                 downlink antenna port
+                 resources on each downlink antenna port / Detects a
+                 block of vectors from resources on each downlink
+                 antenna port
 
     Document Reference: 3GPP TS 36.211 v10.1.0 section 6.3.4
 
-    NOTES: Currently only supports signle antenna or TX diversity
+    Notes: Supports single antenna, TX diversity for 2 and 4
+           antenna ports, and closed loop spatial multiplexing with
+           codebook precoding for 2 antenna ports.  Layers and
+           antenna ports are stored one plane per layer/port.  The
+           AVX2 kernels split blocks of 8 complex values into real
+           and imaginary vectors, work on those and interleave the
+           results again, the scalar loops handle the remainder and
+           CPUs without AVX2.  Codebook indices outside of table
+           6.3.4.2.3-1 and spatial multiplexing on 4 antenna ports
+           are rejected with LIBLTE_ERROR_INVALID_INPUTS, as is
+           detecting more layers than there are receive antennas.
 *********************************************************************/
 // Defines
+#define DE_PRE_CODER_N_RX_ANT        1
+#define DL_CODEBOOK_N_IDX_1_LAYER    4
+#define DL_CODEBOOK_N_IDX_2_LAYERS   3
 // Enums
 // Structs
 // Functions
-void pre_coder_dl(complex                        *x,
-                  uint32                          M_layer_symb,
-                  uint8                           N_ant,
-                  LIBLTE_PHY_PRE_CODER_TYPE_ENUM  type,
-                  complex                        *y,
-                  uint32                          y_len,
-                  uint32                         *M_ap_symb)
+LIBLTE_ERROR_ENUM get_dl_codebook(uint32 N_layers,
+                                  uint32 codebook_idx,
+                                  float  w_re[2][2],
+                                  float  w_im[2][2])
+{
+    // 3GPP TS 36.211 v10.1.0 table 6.3.4.2.3-1
+    if(!(N_layers == 1 && codebook_idx < DL_CODEBOOK_N_IDX_1_LAYER) &&
+       !(N_layers == 2 && codebook_idx < DL_CODEBOOK_N_IDX_2_LAYERS))
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    for(uint32 p=0; p<2; p++)
+    {
+        for(uint32 l=0; l<2; l++)
+        {
+            complex w;
+            if(N_layers == 1)
+            {
+                w = CODEBOOK_6_3_4_2_3_1_1_LAYER[codebook_idx][p];
+            }else{
+                w = CODEBOOK_6_3_4_2_3_1_2_LAYERS[codebook_idx][p][l];
+            }
+            w_re[p][l] = w.real();
+            w_im[p][l] = w.imag();
+        }
+    }
+
+    return LIBLTE_SUCCESS;
+}
+#if LIBLTE_PHY_HAVE_SIMD
+// Splits 8 complex values into real and imaginary vectors
+__attribute__((target("avx2")))
+static inline void load_complex_avx2(const float *in,
+                                     __m256      *re,
+                                     __m256      *im)
+{
+    __m256 a  = _mm256_loadu_ps(&in[0]);
+    __m256 b  = _mm256_loadu_ps(&in[8]);
+    __m256 lo = _mm256_permute2f128_ps(a, b, 0x20);
+    __m256 hi = _mm256_permute2f128_ps(a, b, 0x31);
+    *re = _mm256_shuffle_ps(lo, hi, 0x88);
+    *im = _mm256_shuffle_ps(lo, hi, 0xDD);
+}
+__attribute__((target("avx2")))
+static inline void store_complex_avx2(__m256  re,
+                                      __m256  im,
+                                      float  *out)
+{
+    __m256 lo = _mm256_unpacklo_ps(re, im);
+    __m256 hi = _mm256_unpackhi_ps(re, im);
+    _mm256_storeu_ps(&out[0], _mm256_permute2f128_ps(lo, hi, 0x20));
+    _mm256_storeu_ps(&out[8], _mm256_permute2f128_ps(lo, hi, 0x31));
+}
+// Loads 8 groups of 4 floats, group k starting at in[k*step], so that
+// v[j] holds float j of every group
+__attribute__((target("avx2")))
+static inline void load_groups_avx2(const float *in,
+                                    uint32       step,
+                                    __m256       v[4])
+{
+    __m256 r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&in[0*step])), _mm_loadu_ps(&in[4*step]), 1);
+    __m256 r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&in[1*step])), _mm_loadu_ps(&in[5*step]), 1);
+    __m256 r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&in[2*step])), _mm_loadu_ps(&in[6*step]), 1);
+    __m256 r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&in[3*step])), _mm_loadu_ps(&in[7*step]), 1);
+    __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+    __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+    __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+    __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+    v[0] = _mm256_shuffle_ps(t0, t2, 0x44);
+    v[1] = _mm256_shuffle_ps(t0, t2, 0xEE);
+    v[2] = _mm256_shuffle_ps(t1, t3, 0x44);
+    v[3] = _mm256_shuffle_ps(t1, t3, 0xEE);
+}
+__attribute__((target("avx2")))
+static inline void store_groups_avx2(const __m256  v[4],
+                                     uint32        step,
+                                     float        *out)
+{
+    __m256 t0 = _mm256_unpacklo_ps(v[0], v[1]);
+    __m256 t1 = _mm256_unpackhi_ps(v[0], v[1]);
+    __m256 t2 = _mm256_unpacklo_ps(v[2], v[3]);
+    __m256 t3 = _mm256_unpackhi_ps(v[2], v[3]);
+    __m256 r0 = _mm256_shuffle_ps(t0, t2, 0x44);
+    __m256 r1 = _mm256_shuffle_ps(t0, t2, 0xEE);
+    __m256 r2 = _mm256_shuffle_ps(t1, t3, 0x44);
+    __m256 r3 = _mm256_shuffle_ps(t1, t3, 0xEE);
+    _mm_storeu_ps(&out[0*step], _mm256_castps256_ps128(r0));
+    _mm_storeu_ps(&out[1*step], _mm256_castps256_ps128(r1));
+    _mm_storeu_ps(&out[2*step], _mm256_castps256_ps128(r2));
+    _mm_storeu_ps(&out[3*step], _mm256_castps256_ps128(r3));
+    _mm_storeu_ps(&out[4*step], _mm256_extractf128_ps(r0, 1));
+    _mm_storeu_ps(&out[5*step], _mm256_extractf128_ps(r1, 1));
+    _mm_storeu_ps(&out[6*step], _mm256_extractf128_ps(r2, 1));
+    _mm_storeu_ps(&out[7*step], _mm256_extractf128_ps(r3, 1));
+}
+__attribute__((target("avx2")))
+static uint32 sfbc_encoder_avx2(const float *x_a,
+                                const float *x_b,
+                                uint32       N_pairs,
+                                uint32       stride,
+                                float       *y_a,
+                                float       *y_b)
+{
+    __m256 c   = _mm256_set1_ps(1/sqrt(2));
+    __m256 neg = _mm256_set1_ps(-1/sqrt(2));
+    __m256 x_a_re;
+    __m256 x_a_im;
+    __m256 x_b_re;
+    __m256 x_b_im;
+    __m256 v[4];
+    uint32 i;
+
+    for(i=0; i+8<=N_pairs; i+=8)
+    {
+        load_complex_avx2(&x_a[2*i], &x_a_re, &x_a_im);
+        load_complex_avx2(&x_b[2*i], &x_b_re, &x_b_im);
+        v[0] = _mm256_mul_ps(x_a_re, c);
+        v[1] = _mm256_mul_ps(x_a_im, c);
+        v[2] = _mm256_mul_ps(x_b_re, c);
+        v[3] = _mm256_mul_ps(x_b_im, c);
+        store_groups_avx2(v, 2*stride, &y_a[2*stride*i]);
+        v[0] = _mm256_mul_ps(x_b_re, neg);
+        v[1] = _mm256_mul_ps(x_b_im, c);
+        v[2] = _mm256_mul_ps(x_a_re, c);
+        v[3] = _mm256_mul_ps(x_a_im, neg);
+        store_groups_avx2(v, 2*stride, &y_b[2*stride*i]);
+    }
+    return i;
+}
+__attribute__((target("avx2")))
+static uint32 sfbc_decoder_avx2(const float *y,
+                                const float *h_a,
+                                const float *h_b,
+                                uint32       N_pairs,
+                                uint32       stride,
+                                float       *x_a,
+                                float       *x_b)
+{
+    __m256 sqrt_2 = _mm256_set1_ps(sqrt(2));
+    __m256 y_v[4];
+    __m256 ha[4];
+    __m256 hb[4];
+    uint32 i;
+
+    for(i=0; i+8<=N_pairs; i+=8)
+    {
+        // Index 0/1 are RE 0 real/imaginary, 2/3 are RE 1
+        load_groups_avx2(&y[2*stride*i],   2*stride, y_v);
+        load_groups_avx2(&h_a[2*stride*i], 2*stride, ha);
+        load_groups_avx2(&h_b[2*stride*i], 2*stride, hb);
+        __m256 g_a = _mm256_div_ps(sqrt_2,
+                                   _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ha[0], ha[0]), _mm256_mul_ps(ha[1], ha[1])),
+                                                 _mm256_add_ps(_mm256_mul_ps(hb[2], hb[2]), _mm256_mul_ps(hb[3], hb[3]))));
+        __m256 g_b = _mm256_div_ps(sqrt_2,
+                                   _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ha[2], ha[2]), _mm256_mul_ps(ha[3], ha[3])),
+                                                 _mm256_add_ps(_mm256_mul_ps(hb[0], hb[0]), _mm256_mul_ps(hb[1], hb[1]))));
+
+        // x_a = conj(h_a[0])*y[0] + h_b[1]*conj(y[1])
+        __m256 x_a_re = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ha[0], y_v[0]), _mm256_mul_ps(ha[1], y_v[1])),
+                                      _mm256_add_ps(_mm256_mul_ps(hb[2], y_v[2]), _mm256_mul_ps(hb[3], y_v[3])));
+        __m256 x_a_im = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(ha[0], y_v[1]), _mm256_mul_ps(ha[1], y_v[0])),
+                                      _mm256_sub_ps(_mm256_mul_ps(hb[3], y_v[2]), _mm256_mul_ps(hb[2], y_v[3])));
+        // x_b = conj(h_a[1])*y[1] - h_b[0]*conj(y[0])
+        __m256 x_b_re = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(ha[2], y_v[2]), _mm256_mul_ps(ha[3], y_v[3])),
+                                      _mm256_add_ps(_mm256_mul_ps(hb[0], y_v[0]), _mm256_mul_ps(hb[1], y_v[1])));
+        __m256 x_b_im = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(ha[2], y_v[3]), _mm256_mul_ps(ha[3], y_v[2])),
+                                      _mm256_sub_ps(_mm256_mul_ps(hb[0], y_v[1]), _mm256_mul_ps(hb[1], y_v[0])));
+        store_complex_avx2(_mm256_mul_ps(x_a_re, g_a), _mm256_mul_ps(x_a_im, g_a), &x_a[2*i]);
+        store_complex_avx2(_mm256_mul_ps(x_b_re, g_b), _mm256_mul_ps(x_b_im, g_b), &x_b[2*i]);
+    }
+    return i;
+}
+__attribute__((target("avx2")))
+static uint32 single_ant_decoder_avx2(const float *y,
+                                      const float *h,
+                                      uint32       N_symbs,
+                                      float       *x)
+{
+    __m256 one = _mm256_set1_ps(1);
+    __m256 y_re;
+    __m256 y_im;
+    __m256 h_re;
+    __m256 h_im;
+    uint32 i;
+
+    for(i=0; i+8<=N_symbs; i+=8)
+    {
+        load_complex_avx2(&y[2*i], &y_re, &y_im);
+        load_complex_avx2(&h[2*i], &h_re, &h_im);
+        __m256 g = _mm256_div_ps(one, _mm256_add_ps(_mm256_mul_ps(h_re, h_re), _mm256_mul_ps(h_im, h_im)));
+        store_complex_avx2(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(h_re, y_re), _mm256_mul_ps(h_im, y_im)), g),
+                           _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(h_re, y_im), _mm256_mul_ps(h_im, y_re)), g),
+                           &x[2*i]);
+    }
+    return i;
+}
+__attribute__((target("avx2")))
+static uint32 codebook_encoder_avx2(float  **x,
+                                    uint32   N_layers,
+                                    float    w_re[2],
+                                    float    w_im[2],
+                                    uint32   N_symbs,
+                                    float   *y)
+{
+    __m256 x_re;
+    __m256 x_im;
+    uint32 i;
+
+    for(i=0; i+8<=N_symbs; i+=8)
+    {
+        __m256 y_re = _mm256_setzero_ps();
+        __m256 y_im = _mm256_setzero_ps();
+        for(uint32 l=0; l<N_layers; l++)
+        {
+            __m256 wr = _mm256_set1_ps(w_re[l]);
+            __m256 wi = _mm256_set1_ps(w_im[l]);
+            load_complex_avx2(&x[l][2*i], &x_re, &x_im);
+            y_re = _mm256_add_ps(y_re, _mm256_sub_ps(_mm256_mul_ps(wr, x_re), _mm256_mul_ps(wi, x_im)));
+            y_im = _mm256_add_ps(y_im, _mm256_add_ps(_mm256_mul_ps(wr, x_im), _mm256_mul_ps(wi, x_re)));
+        }
+        store_complex_avx2(y_re, y_im, &y[2*i]);
+    }
+    return i;
+}
+__attribute__((target("avx2")))
+static uint32 codebook_decoder_avx2(const float *y,
+                                    const float *h_0,
+                                    const float *h_1,
+                                    float        w_re[2][2],
+                                    float        w_im[2][2],
+                                    uint32       N_symbs,
+                                    float       *x)
+{
+    __m256 one    = _mm256_set1_ps(1);
+    __m256 w00_re = _mm256_set1_ps(w_re[0][0]);
+    __m256 w00_im = _mm256_set1_ps(w_im[0][0]);
+    __m256 w10_re = _mm256_set1_ps(w_re[1][0]);
+    __m256 w10_im = _mm256_set1_ps(w_im[1][0]);
+    __m256 y_re;
+    __m256 y_im;
+    __m256 h0_re;
+    __m256 h0_im;
+    __m256 h1_re;
+    __m256 h1_im;
+    uint32 i;
+
+    for(i=0; i+8<=N_symbs; i+=8)
+    {
+        load_complex_avx2(&y[2*i],   &y_re,  &y_im);
+        load_complex_avx2(&h_0[2*i], &h0_re, &h0_im);
+        load_complex_avx2(&h_1[2*i], &h1_re, &h1_im);
+        __m256 g_re = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(h0_re, w00_re), _mm256_mul_ps(h0_im, w00_im)),
+                                    _mm256_sub_ps(_mm256_mul_ps(h1_re, w10_re), _mm256_mul_ps(h1_im, w10_im)));
+        __m256 g_im = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(h0_re, w00_im), _mm256_mul_ps(h0_im, w00_re)),
+                                    _mm256_add_ps(_mm256_mul_ps(h1_re, w10_im), _mm256_mul_ps(h1_im, w10_re)));
+        __m256 norm = _mm256_div_ps(one, _mm256_add_ps(_mm256_mul_ps(g_re, g_re), _mm256_mul_ps(g_im, g_im)));
+        store_complex_avx2(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(g_re, y_re), _mm256_mul_ps(g_im, y_im)), norm),
+                           _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(g_re, y_im), _mm256_mul_ps(g_im, y_re)), norm),
+                           &x[2*i]);
+    }
+    return i;
+}
+#endif
+void sfbc_encoder(float  *x_a,
+                  float  *x_b,
+                  uint32  N_pairs,
+                  uint32  stride,
+                  float  *y_a,
+                  float  *y_b)
+{
+    // 3GPP TS 36.211 v10.1.0 section 6.3.4.3, x_a/x_b are mapped
+    // to REs 0 and 1 of every stride REs of ports a and b
+    float  one_over_sqrt_2 = 1/sqrt(2);
+    uint32 i               = 0;
+#if LIBLTE_PHY_HAVE_SIMD
+    if(avx2_supported())
+        i = sfbc_encoder_avx2(x_a, x_b, N_pairs, stride, y_a, y_b);
+#endif
+    for(; i<N_pairs; i++)
+    {
+        float x_a_re = one_over_sqrt_2*x_a[2*i+0];
+        float x_a_im = one_over_sqrt_2*x_a[2*i+1];
+        float x_b_re = one_over_sqrt_2*x_b[2*i+0];
+        float x_b_im = one_over_sqrt_2*x_b[2*i+1];
+        y_a[2*stride*i+0] =  x_a_re;
+        y_a[2*stride*i+1] =  x_a_im;
+        y_a[2*stride*i+2] =  x_b_re;
+        y_a[2*stride*i+3] =  x_b_im;
+        y_b[2*stride*i+0] = -x_b_re;
+        y_b[2*stride*i+1] =  x_b_im;
+        y_b[2*stride*i+2] =  x_a_re;
+        y_b[2*stride*i+3] = -x_a_im;
+    }
+}
+void sfbc_decoder(float  *y,
+                  float  *h_a,
+                  float  *h_b,
+                  uint32  N_pairs,
+                  uint32  stride,
+                  float  *x_a,
+                  float  *x_b)
+{
+    // 3GPP TS 36.211 v10.1.0 section 6.3.4.3, Alamouti combining of
+    // REs 0 and 1 of every stride REs, scaled by sqrt(2) to undo the
+    // pre coder normalization
+    float  sqrt_2 = sqrt(2);
+    uint32 i      = 0;
+#if LIBLTE_PHY_HAVE_SIMD
+    if(avx2_supported())
+        i = sfbc_decoder_avx2(y, h_a, h_b, N_pairs, stride, x_a, x_b);
+#endif
+    for(; i<N_pairs; i++)
+    {
+        float y0_re  = y[2*stride*i+0];
+        float y0_im  = y[2*stride*i+1];
+        float y1_re  = y[2*stride*i+2];
+        float y1_im  = y[2*stride*i+3];
+        float ha0_re = h_a[2*stride*i+0];
+        float ha0_im = h_a[2*stride*i+1];
+        float ha1_re = h_a[2*stride*i+2];
+        float ha1_im = h_a[2*stride*i+3];
+        float hb0_re = h_b[2*stride*i+0];
+        float hb0_im = h_b[2*stride*i+1];
+        float hb1_re = h_b[2*stride*i+2];
+        float hb1_im = h_b[2*stride*i+3];
+        float g_a    = sqrt_2/(ha0_re*ha0_re + ha0_im*ha0_im + hb1_re*hb1_re + hb1_im*hb1_im);
+        float g_b    = sqrt_2/(ha1_re*ha1_re + ha1_im*ha1_im + hb0_re*hb0_re + hb0_im*hb0_im);
+
+        // x_a = conj(h_a[0])*y[0] + h_b[1]*conj(y[1])
+        x_a[2*i+0] = (ha0_re*y0_re + ha0_im*y0_im + hb1_re*y1_re + hb1_im*y1_im)*g_a;
+        x_a[2*i+1] = (ha0_re*y0_im - ha0_im*y0_re + hb1_im*y1_re - hb1_re*y1_im)*g_a;
+        // x_b = conj(h_a[1])*y[1] - h_b[0]*conj(y[0])
+        x_b[2*i+0] = (ha1_re*y1_re + ha1_im*y1_im - hb0_re*y0_re - hb0_im*y0_im)*g_b;
+        x_b[2*i+1] = (ha1_re*y1_im - ha1_im*y1_re - hb0_im*y0_re + hb0_re*y0_im)*g_b;
+    }
+}
+void single_ant_decoder(float  *y,
+                        float  *h,
+                        uint32  N_symbs,
+                        float  *x)
+{
+    // 3GPP TS 36.211 v10.1.0 section 6.3.4.1, x = y/h
+    uint32 i = 0;
+#if LIBLTE_PHY_HAVE_SIMD
+    if(avx2_supported())
+        i = single_ant_decoder_avx2(y, h, N_symbs, x);
+#endif
+    for(; i<N_symbs; i++)
+    {
+        float h_re = h[2*i+0];
+        float h_im = h[2*i+1];
+        float y_re = y[2*i+0];
+        float y_im = y[2*i+1];
+        float g    = 1/(h_re*h_re + h_im*h_im);
+        x[2*i+0] = (h_re*y_re + h_im*y_im)*g;
+        x[2*i+1] = (h_re*y_im - h_im*y_re)*g;
+    }
+}
+void codebook_encoder(float  **x,
+                      uint32   N_layers,
+                      float    w_re[2],
+                      float    w_im[2],
+                      uint32   N_symbs,
+                      float   *y)
+{
+    // 3GPP TS 36.211 v10.1.0 section 6.3.4.2.1, one antenna port's
+    // row of W times the layers
+    uint32 i = 0;
+#if LIBLTE_PHY_HAVE_SIMD
+    if(avx2_supported())
+        i = codebook_encoder_avx2(x, N_layers, w_re, w_im, N_symbs, y);
+#endif
+    for(; i<N_symbs; i++)
+    {
+        float y_re = 0;
+        float y_im = 0;
+        for(uint32 l=0; l<N_layers; l++)
+        {
+            float x_re = x[l][2*i+0];
+            float x_im = x[l][2*i+1];
+            y_re += w_re[l]*x_re - w_im[l]*x_im;
+            y_im += w_re[l]*x_im + w_im[l]*x_re;
+        }
+        y[2*i+0] = y_re;
+        y[2*i+1] = y_im;
+    }
+}
+void codebook_decoder(float  *y,
+                      float  *h_0,
+                      float  *h_1,
+                      float   w_re[2][2],
+                      float   w_im[2][2],
+                      uint32  N_symbs,
+                      float  *x)
 {
+    // Matched filter on the effective channel g = h*W of a single
+    // layer
+    uint32 i = 0;
+#if LIBLTE_PHY_HAVE_SIMD
+    if(avx2_supported())
+        i = codebook_decoder_avx2(y, h_0, h_1, w_re, w_im, N_symbs, x);
+#endif
+    for(; i<N_symbs; i++)
+    {
+        float h0_re = h_0[2*i+0];
+        float h0_im = h_0[2*i+1];
+        float h1_re = h_1[2*i+0];
+        float h1_im = h_1[2*i+1];
+        float y_re  = y[2*i+0];
+        float y_im  = y[2*i+1];
+        float g_re  = h0_re*w_re[0][0] - h0_im*w_im[0][0] + h1_re*w_re[1][0] - h1_im*w_im[1][0];
+        float g_im  = h0_re*w_im[0][0] + h0_im*w_re[0][0] + h1_re*w_im[1][0] + h1_im*w_re[1][0];
+        float norm  = 1/(g_re*g_re + g_im*g_im);
+        x[2*i+0] = (g_re*y_re + g_im*y_im)*norm;
+        x[2*i+1] = (g_re*y_im - g_im*y_re)*norm;
+    }
+}
+LIBLTE_ERROR_ENUM pre_coder_dl(complex                        *x,
+                               uint32                          M_layer_symb,
+                               uint8                           N_ant,
+                               uint32                          N_layers,
+                               uint32                          codebook_idx,
+                               LIBLTE_PHY_PRE_CODER_TYPE_ENUM  type,
+                               complex                        *y,
+                               uint32                          y_len,
+                               uint32                         *M_ap_symb)
+{
+    float w_re[2][2];
+    float w_im[2][2];
+
+    // Spatial multiplexing is only supported for 2 antenna ports
+    if(N_ant != 1                                             &&
+       LIBLTE_PHY_PRE_CODER_TYPE_SPATIAL_MULTIPLEXING == type &&
+       (N_ant != 2 || LIBLTE_SUCCESS != get_dl_codebook(N_layers, codebook_idx, w_re, w_im)))
+    {
+        *M_ap_symb = 0;
+        return LIBLTE_ERROR_INVALID_INPUTS;
+    }
+
     // Index all arrays
-    complex *x_ptr[N_ant];
-    complex *y_ptr[N_ant];
+    float *x_ptr[LIBLTE_PHY_N_ANT_MAX];
+    float *y_ptr[LIBLTE_PHY_N_ANT_MAX];
     for(uint32 p=0; p<N_ant; p++)
     {
-        x_ptr[p] = &x[p*M_layer_symb];
-        y_ptr[p] = &y[p*y_len];
+        x_ptr[p] = (float *)&x[p*M_layer_symb];
+        y_ptr[p] = (float *)&y[p*y_len];
     }
 
-    float one_over_sqrt_2 = 1/sqrt(2);
     if(N_ant == 1)
     {
         // 3GPP TS 36.211 v10.1.0 section 6.3.4.1
         *M_ap_symb = M_layer_symb;
-        for(uint32 i=0; i<*M_ap_symb; i++)
+        for(uint32 i=0; i<2*M_layer_symb; i++)
             y_ptr[0][i] = x_ptr[0][i];
-    }else if(N_ant == 2){
-        if(LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY == type)
+    }else if(LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY == type){
+        if(N_ant == 2)
         {
             // 3GPP TS 36.211 v10.1.0 section 6.3.4.3
             *M_ap_symb = 2*M_layer_symb;
-            for(uint32 i=0; i<M_layer_symb; i++)
-            {
-                y_ptr[0][2*i+0] = +one_over_sqrt_2 * x_ptr[0][i];
-                y_ptr[1][2*i+0] = -one_over_sqrt_2 * std::conj(x_ptr[1][i]);
-                y_ptr[0][2*i+1] = +one_over_sqrt_2 * x_ptr[1][i];
-                y_ptr[1][2*i+1] = +one_over_sqrt_2 * std::conj(x_ptr[0][i]);
-            }
-        }else{
-            // FIXME: Currently only supporting TX Diversity
-        }
-    }else{
-        if(LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY == type)
-        {
+            sfbc_encoder(x_ptr[0], x_ptr[1], M_layer_symb, 2, y_ptr[0], y_ptr[1]);
+        }else{ // N_ant == 4
             // 3GPP TS 36.211 v10.1.0 section 6.3.4.3
-            if(x_ptr[2][M_layer_symb-1] == complex(TX_NULL_SYMB, TX_NULL_SYMB) &&
-               x_ptr[3][M_layer_symb-1] == complex(TX_NULL_SYMB, TX_NULL_SYMB))
+            if(x[3*M_layer_symb-1] == complex(TX_NULL_SYMB, TX_NULL_SYMB) &&
+               x[4*M_layer_symb-1] == complex(TX_NULL_SYMB, TX_NULL_SYMB))
             {
                 *M_ap_symb = 4*M_layer_symb - 2;
             }else{
                 *M_ap_symb = 4*M_layer_symb;
             }
-            for(uint32 i=0; i<M_layer_symb; i++)
-            {
-                y_ptr[0][4*i+0] = +one_over_sqrt_2 * x_ptr[0][i];
-                y_ptr[1][4*i+0] = complex(0, 0);
-                y_ptr[2][4*i+0] = -one_over_sqrt_2 * std::conj(x_ptr[1][i]);
-                y_ptr[3][4*i+0] = complex(0, 0);
-                y_ptr[0][4*i+1] = +one_over_sqrt_2 * x_ptr[1][i];
-                y_ptr[1][4*i+1] = complex(0, 0);
-                y_ptr[2][4*i+1] = +one_over_sqrt_2 * std::conj(x_ptr[0][i]);
-                y_ptr[3][4*i+1] = complex(0, 0);
-                y_ptr[0][4*i+2] = complex(0, 0);
-                y_ptr[1][4*i+2] = +one_over_sqrt_2 * x_ptr[2][i];
-                y_ptr[2][4*i+2] = complex(0, 0);
-                y_ptr[3][4*i+2] = -one_over_sqrt_2 * std::conj(x_ptr[3][i]);
-                y_ptr[0][4*i+3] = complex(0, 0);
-                y_ptr[1][4*i+3] = +one_over_sqrt_2 * x_ptr[3][i];
-                y_ptr[2][4*i+3] = complex(0, 0);
-                y_ptr[3][4*i+3] = +one_over_sqrt_2 * std::conj(x_ptr[2][i]);
-            }
-        }else{
-            // FIXME: Currently only supporting TX Diversity
+            for(uint32 p=0; p<N_ant; p++)
+                for(uint32 i=0; i<8*M_layer_symb; i++)
+                    y_ptr[p][i] = 0;
+            sfbc_encoder(x_ptr[0], x_ptr[1], M_layer_symb, 4, &y_ptr[0][0], &y_ptr[2][0]);
+            sfbc_encoder(x_ptr[2], x_ptr[3], M_layer_symb, 4, &y_ptr[1][4], &y_ptr[3][4]);
         }
+    }else{ // N_ant == 2
+        // 3GPP TS 36.211 v10.1.0 section 6.3.4.2.1
+        *M_ap_symb = M_layer_symb;
+        for(uint32 p=0; p<N_ant; p++)
+            codebook_encoder(x_ptr, N_layers, w_re[p], w_im[p], M_layer_symb, y_ptr[p]);
     }
+
+    return LIBLTE_SUCCESS;
 }
-void de_pre_coder_dl(complex                        *y,
-                     complex                        *h,
-                     uint32                          h_len,
-                     uint32                          M_ap_symb,
-                     uint8                           N_ant,
-                     LIBLTE_PHY_PRE_CODER_TYPE_ENUM  type,
-                     complex                        *x,
-                     uint32                         *M_layer_symb)
+LIBLTE_ERROR_ENUM de_pre_coder_dl(complex                        *y,
+                                  complex                        *h,
+                                  uint32                          h_len,
+                                  uint32                          M_ap_symb,
+                                  uint8                           N_ant,
+                                  uint32                          N_layers,
+                                  uint32                          codebook_idx,
+                                  LIBLTE_PHY_PRE_CODER_TYPE_ENUM  type,
+                                  complex                        *x,
+                                  uint32                         *M_layer_symb)
 {
+    float w_re[2][2];
+    float w_im[2][2];
+
+    // Spatial multiplexing is only supported for 2 antenna ports and
+    // each layer needs its own receive antenna
+    if(N_ant != 1                                             &&
+       LIBLTE_PHY_PRE_CODER_TYPE_SPATIAL_MULTIPLEXING == type &&
+       (N_ant != 2 || N_layers > DE_PRE_CODER_N_RX_ANT ||
+        LIBLTE_SUCCESS != get_dl_codebook(N_layers, codebook_idx, w_re, w_im)))
+    {
+        *M_layer_symb = 0;
+        return LIBLTE_ERROR_INVALID_INPUTS;
+    }
+
+    // Determine the layer size
+    if(N_ant == 1)
+    {
+        *M_layer_symb = M_ap_symb;
+    }else if(LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY == type){
+        *M_layer_symb = (M_ap_symb + N_ant - 1)/N_ant;
+    }else{
+        *M_layer_symb = M_ap_symb;
+    }
+
     // Index all arrays
-    complex *h_ptr[N_ant];
-    complex *x_ptr[N_ant];
+    float *y_ptr = (float *)y;
+    float *h_ptr[LIBLTE_PHY_N_ANT_MAX];
+    float *x_ptr[LIBLTE_PHY_N_ANT_MAX];
     for(uint32 p=0; p<N_ant; p++)
     {
-        h_ptr[p] = &h[p*h_len];
-        x_ptr[p] = &x[p*(M_ap_symb/N_ant)];
+        h_ptr[p] = (float *)&h[p*h_len];
+        x_ptr[p] = (float *)&x[p*(*M_layer_symb)];
     }
 
     if(N_ant == 1)
     {
         // 3GPP TS 36.211 v10.1.0 section 6.3.4.1
-        *M_layer_symb = M_ap_symb;
-        for(uint32 i=0; i<*M_layer_symb; i++)
-            x_ptr[0][i] = y[i] / h_ptr[0][i];
-    }else if(N_ant == 2){
-        // 3GPP TS 36.211 v10.1.0 section 6.3.4.3
-        *M_layer_symb = M_ap_symb/2;
-        for(uint32 i=0; i<*M_layer_symb; i++)
-        {
-            x_ptr[0][i] = ((std::conj(h_ptr[0][i*2+0]) * y[i*2+0] +
-                            h_ptr[1][i*2+1] * std::conj(y[i*2+1])) /
-                           std::abs(complex(std::norm(h_ptr[0][i*2+0]),
-                                            std::norm(h_ptr[1][i*2+1]))));
-            x_ptr[1][i] = -(std::conj(std::conj(h_ptr[0][i*2+1]) * y[i*2+0] -
-                                      h_ptr[1][i*2+0] * std::conj(y[i*2+1])) /
-                            std::abs(complex(std::norm(h_ptr[1][i*2+0]),
-                                             std::norm(h_ptr[0][i*2+1]))));
-        }
-    }else{ // N_ant == 4
-        // 3GPP TS 36.211 v10.1.0 section 6.3.4.3
-        *M_layer_symb = M_ap_symb/4;
-        uint32 i;
-        for(i=0; i<*M_layer_symb; i++)
-        {
-            x_ptr[0][i] = ((std::conj(h_ptr[0][i*4+0]) * y[i*4+0] +
-                            h_ptr[2][i*4+1] * std::conj(y[i*4+1])) /
-                           std::abs(complex(std::norm(h_ptr[0][i*4+0]),
-                                            std::norm(h_ptr[2][i*4+1]))));
-            x_ptr[1][i] = -(std::conj(std::conj(h_ptr[0][i*4+1]) * y[i*4+0] -
-                                      h_ptr[2][i*4+0] * std::conj(y[i*4+1])) /
-                            std::abs(complex(std::norm(h_ptr[0][i*4+1]),
-                                             std::norm(h_ptr[2][i*4+0]))));
-            x_ptr[2][i] = ((std::conj(h_ptr[1][i*4+2]) * y[i*4+2] +
-                            h_ptr[3][i*4+3] * std::conj(y[i*4+3])) /
-                           std::abs(complex(std::norm(h_ptr[1][i*4+2]),
-                                            std::norm(h_ptr[3][i*4+3]))));
-            x_ptr[3][i] = -(std::conj(std::conj(h_ptr[1][i*4+3]) * y[i*4+2] -
-                                      h_ptr[3][i*4+2] * std::conj(y[i*4+3])) /
-                            std::abs(complex(std::norm(h_ptr[1][i*4+3]),
-                                             std::norm(h_ptr[3][i*4+2]))));
-        }
-        if((M_ap_symb % 4) != 0)
-        {
-            *M_layer_symb    = (M_ap_symb+2)/4;
-            float h_norm_0_2 = std::norm(complex(std::norm(h_ptr[0][i*4+0]),
-                                                 std::norm(h_ptr[2][i*4+0])));
-            x_ptr[0][i]      = complex((h_ptr[0][i*4+0].real() * y[i*4+0].real() +
-                                        h_ptr[0][i*4+0].imag() * y[i*4+0].imag() +
-                                        h_ptr[2][i*4+0].real() * y[i*4+1].real() +
-                                        h_ptr[2][i*4+0].imag() * y[i*4+1].imag()) / h_norm_0_2,
-                                       (h_ptr[0][i*4+0].real() * y[i*4+0].imag() -
-                                        h_ptr[0][i*4+0].imag() * y[i*4+0].real() -
-                                        h_ptr[2][i*4+0].real() * y[i*4+1].imag() +
-                                        h_ptr[2][i*4+0].imag() * y[i*4+1].real()) / h_norm_0_2);
-            x_ptr[1][i]      = complex((-h_ptr[2][i*4+0].real() * y[i*4+0].real() -
-                                        h_ptr[2][i*4+0].imag() * y[i*4+0].imag() +
-                                        h_ptr[0][i*4+0].real() * y[i*4+1].real() +
-                                        h_ptr[0][i*4+0].imag() * y[i*4+1].imag()) / h_norm_0_2,
-                                       (-h_ptr[2][i*4+0].real() * y[i*4+0].imag() +
-                                        h_ptr[2][i*4+0].imag() * y[i*4+0].real() -
-                                        h_ptr[0][i*4+0].real() * y[i*4+1].real() +
-                                        h_ptr[0][i*4+0].imag() * y[i*4+1].imag()) / h_norm_0_2);
-            x_ptr[2][i]      = complex(RX_NULL_SYMB, RX_NULL_SYMB);
-            x_ptr[3][i]      = complex(RX_NULL_SYMB, RX_NULL_SYMB);
+        single_ant_decoder(y_ptr, h_ptr[0], M_ap_symb, x_ptr[0]);
+    }else if(LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY == type){
+        if(N_ant == 2)
+        {
+            // 3GPP TS 36.211 v10.1.0 section 6.3.4.3
+            sfbc_decoder(y_ptr, h_ptr[0], h_ptr[1], *M_layer_symb, 2, x_ptr[0], x_ptr[1]);
+        }else{ // N_ant == 4
+            // 3GPP TS 36.211 v10.1.0 section 6.3.4.3, ports 0 and 2 carry
+            // the first pair of every 4 REs and ports 1 and 3 carry the
+            // second pair, which is absent from a trailing half group
+            sfbc_decoder(&y_ptr[0], &h_ptr[0][0], &h_ptr[2][0], *M_layer_symb, 4, x_ptr[0], x_ptr[1]);
+            sfbc_decoder(&y_ptr[4], &h_ptr[1][4], &h_ptr[3][4], M_ap_symb/4, 4, x_ptr[2], x_ptr[3]);
+            if((M_ap_symb % 4) != 0)
+            {
+                x[3*(*M_layer_symb)-1] = complex(RX_NULL_SYMB, RX_NULL_SYMB);
+                x[4*(*M_layer_symb)-1] = complex(RX_NULL_SYMB, RX_NULL_SYMB);
+            }
         }
+    }else{ // N_ant == 2, N_layers == 1
+        // 3GPP TS 36.211 v10.1.0 section 6.3.4.2.1
+        codebook_decoder(y_ptr, h_ptr[0], h_ptr[1], w_re, w_im, M_ap_symb, x_ptr[0]);
     }
+
+    return LIBLTE_SUCCESS;
 }
 
 /*********************************************************************
@@ -2270,6 +2732,8 @@ void pcfich_channel_map(LIBLTE_PHY_STRUCT          *phy_struct,
     pre_coder_dl(phy_struct->pdcch_x,
                  M_layer_symb,
                  N_ant,
+                 N_ant,
+                 0,
                  LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY,
                  phy_struct->pdcch_y[0],
                  576,
@@ -2332,6 +2796,8 @@ void pcfich_channel_demap(LIBLTE_PHY_STRUCT          *phy_struct,
                     576,
                     16,
                     N_ant,
+                    N_ant,
+                    0,
                     LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY,
                     phy_struct->pdcch_x,
                     &M_layer_symb);
@@ -2493,6 +2959,8 @@ void phich_channel_map(LIBLTE_PHY_STRUCT                 *phy_struct,
         pre_coder_dl(phy_struct->pdcch_x,
                      M_layer_symb,
                      N_ant,
+                     N_ant,
+                     0,
                      LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY,
                      phy_struct->pdcch_y[0],
                      576,
@@ -2731,90 +3199,683 @@ void generate_sss(LIBLTE_PHY_STRUCT *phy_struct,
 }
 
 /*********************************************************************
-    Name: symbols_to_samples_dl / samples_to_symbols_dl
+    Name: wrap_phase
 
-    Description: Converts subcarrier symbols to I/Q samples for the
-                 downlink / Converts I/Q samples to subcarrier symbols
-                 for the downlink
+    Description: Checks the phase difference between two angles and
+                 wraps one to make the difference less than 2*pi.
 
-    Document Reference: 3GPP TS 36.211 v10.1.0 section 6.12
+    Document Reference: N/A
 *********************************************************************/
 // Defines
 // Enums
 // Structs
 // Functions
-void symbols_to_samples_dl(LIBLTE_PHY_STRUCT *phy_struct,
-                           complex           *symb,
-                           uint32             symbol_offset,
-                           complex           *samps,
-                           uint32            *N_samps)
+inline void wrap_phase(float *phase_1,
+                       float  phase_2)
+{
+    while((*phase_1 - phase_2) >= M_PI)
+        *phase_1 = *phase_1 - 2*M_PI;
+    while((*phase_1 - phase_2) <= -M_PI)
+        *phase_1 = *phase_1 + 2*M_PI;
+}
+
+/*********************************************************************
+    Name: is_this_RE_for_PDSCH
+
+    Description: Determines if a resource element is available for
+                 the Physical Downlink Shared Channel
+
+    Document Reference: 3GPP TS 36.211 v10.1.0 section 6.3.5
+
+    Notes: Inlined into the bandwidth specialized PDSCH kernels so
+           the N_rb_dl dependent PBCH/PSS/SSS bounds fold away
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+inline bool is_this_RE_for_PDSCH(uint8 N_ant,
+                                 uint32 L,
+                                 uint32 N_id_cell,
+                                 uint32 sc,
+                                 uint32 N_rb_dl,
+                                 uint32 N_sc_rb_dl,
+                                 uint32 subfr_num,
+                                 uint32 prb)
+{
+    if(N_ant == 1 && (L % 7) == 0 && (N_id_cell % 6) == (sc % 6))
+        // Skip CRS
+        return false;
+    if(N_ant == 1 && (L % 7) == 4 && ((N_id_cell+3) % 6) == (sc % 6))
+        // Skip CRS
+        return false;
+    if((N_ant == 2 || N_ant == 4) && ((L % 7) == 0 || (L % 7) == 4) && (N_id_cell % 3) == (sc % 3))
+        // Skip CRS
+        return false;
+    if(N_ant == 4 && (L % 7) == 1 && (N_id_cell % 3) == (sc % 3))
+        // Skip CRS
+        return false;
+    uint32 first_sc;
+    uint32 last_sc;
+    if(N_rb_dl == 6)
+    {
+        first_sc = 0;
+        last_sc  = (6*N_sc_rb_dl)-1;
+    }else if(N_rb_dl == 15){
+        first_sc = (4*N_sc_rb_dl)+6;
+        last_sc  = (11*N_sc_rb_dl)-7;
+    }else if(N_rb_dl == 25){
+        first_sc = (9*N_sc_rb_dl)+6;
+        last_sc  = (16*N_sc_rb_dl)-7;
+    }else if(N_rb_dl == 50){
+        first_sc = 22*N_sc_rb_dl;
+        last_sc  = (28*N_sc_rb_dl)-1;
+    }else if(N_rb_dl == 75){
+        first_sc = (34*N_sc_rb_dl)+6;
+        last_sc  = (41*N_sc_rb_dl)-7;
+    }else{ // N_rb_dl == 100
+        first_sc = 47*N_sc_rb_dl;
+        last_sc  = (53*N_sc_rb_dl)-1;
+    }
+    if(subfr_num == 0 && (prb*N_sc_rb_dl + sc) >= first_sc && (prb*N_sc_rb_dl + sc) <= last_sc && L >= 7 && L <= 10)
+        // Skip PBCH
+        return false;
+    if((subfr_num == 0 || subfr_num == 5) && (prb*N_sc_rb_dl + sc) >= first_sc && (prb*N_sc_rb_dl + sc) <= last_sc && L == 6)
+        // Skip PSS
+        return false;
+    if((subfr_num == 0 || subfr_num == 5) && (prb*N_sc_rb_dl + sc) >= first_sc && (prb*N_sc_rb_dl + sc) <= last_sc && L == 5)
+        // Skip SSS
+        return false;
+    return true;
+}
+
+/*********************************************************************
+    Name: get_dl_ce_crs_mask
+
+    Description: Determines which of an antenna port's CRS symbols are
+                 needed to construct the channel estimates for a range
+                 of OFDM symbols
+
+    Document Reference: 3GPP TS 36.211 v10.1.0 section 6.10.1
+
+    Notes: Bit i of the returned mask is set if the i'th CRS symbol of
+           the port is needed, matching the interpolation done in
+           dl_ce_kernel
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+uint32 get_dl_ce_crs_mask(uint32 p,
+                          uint32 first_symb,
+                          uint32 last_symb)
+{
+    uint32 mask = 0;
+
+    if(p < 2)
+    {
+        // CRS in symbols 0, 4, 7, and 11
+        bool symb_0    = (first_symb == 0);
+        bool symb_1_3  = (first_symb <= 3 && last_symb >= 1);
+        bool symb_4    = (first_symb <= 4 && last_symb >= 4);
+        bool symb_5_6  = (first_symb <= 6 && last_symb >= 5);
+        bool symb_7    = (first_symb <= 7 && last_symb >= 7);
+        bool symb_8_13 = (last_symb >= 8);
+        if(symb_0 || symb_1_3)
+            mask |= 0x1;
+        if(symb_1_3 || symb_4 || symb_5_6)
+            mask |= 0x2;
+        if(symb_5_6 || symb_7 || symb_8_13)
+            mask |= 0x4;
+        if(symb_8_13)
+            mask |= 0x8;
+    }else{
+        // CRS in symbols 1, 8, and 15
+        if(first_symb <= 7)
+            mask |= 0x1;
+        mask |= 0x2;
+        if(last_symb >= 9)
+            mask |= 0x4;
+    }
+
+    return mask;
+}
+
+/*********************************************************************
+    Name: Bandwidth specialized downlink kernels
+
+    Description: OFDM modulation/demodulation, CRS mapping, channel
+                 estimation, and PDSCH mapping/de-mapping for each of
+                 the LTE downlink bandwidths
+
+    Document Reference: 3GPP TS 36.211 v10.1.0 sections 6.3.5, 6.10.1,
+                        and 6.12
+
+    Notes: Each kernel is instantiated once per bandwidth with N_RB_DL
+           as a compile time constant so that all loop trip counts
+           are fixed and only the used subcarriers are touched.
+           N_RB_DL of 0 is the generic version which reads N_rb_dl
+           and N_sc_rb_dl from phy_struct.  The kernels for a
+           phy_struct are selected in liblte_phy_update_n_rb_dl.
+           The channel estimation scratch is strided by the bandwidth,
+           the subframe arrays are part of the public struct and keep
+           their 20 MHz stride.
+*********************************************************************/
+// Defines
+#define N_DL_KERNELS 7
+// Enums
+// Structs
+typedef struct{
+    uint32   N_rb_dl;
+    void   (*symbols_to_samples_dl)(LIBLTE_PHY_STRUCT *phy_struct, complex *symb, uint32 symbol_offset, complex *samps, uint32 *N_samps);
+    void   (*samples_to_symbols_dl)(LIBLTE_PHY_STRUCT *phy_struct, complex *samps, uint32 slot_start_idx, uint32 symbol_offset, uint8 scale, complex *symb);
+    void   (*map_crs)(LIBLTE_PHY_STRUCT *phy_struct, complex **crs, uint32 N_id_cell, uint8 N_ant, LIBLTE_PHY_SUBFRAME_STRUCT *subframe);
+    void   (*dl_ce)(LIBLTE_PHY_STRUCT *phy_struct, uint32 N_id_cell, uint8 N_ant, uint32 first_prb, uint32 N_prb, uint32 first_symb, uint32 N_symbs, LIBLTE_PHY_SUBFRAME_STRUCT *subframe);
+    void   (*pdsch_map)(LIBLTE_PHY_STRUCT *phy_struct, LIBLTE_PHY_ALLOCATION_STRUCT *alloc, uint32 N_pdcch_symbs, uint32 N_id_cell, uint8 N_ant, LIBLTE_PHY_SUBFRAME_STRUCT *subframe);
+    uint32 (*pdsch_demap)(LIBLTE_PHY_STRUCT *phy_struct, LIBLTE_PHY_SUBFRAME_STRUCT *subframe, LIBLTE_PHY_ALLOCATION_STRUCT *alloc, uint32 N_pdcch_symbs, uint32 N_id_cell, uint8 N_ant);
+}LIBLTE_PHY_DL_KERNELS_STRUCT;
+// Functions
+template<uint32 N_RB_DL>
+void symbols_to_samples_dl_kernel(LIBLTE_PHY_STRUCT *phy_struct,
+                                  complex           *symb,
+                                  uint32             symbol_offset,
+                                  complex           *samps,
+                                  uint32            *N_samps)
 {
+    fftwf_complex *in        = phy_struct->s2s_in;
+    fftwf_complex *out       = phy_struct->s2s_out;
+    uint32         N_fft     = phy_struct->N_samps_per_symb;
+    const uint32   N_sc_half = (0 != N_RB_DL) ? (N_RB_DL*LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP)/2 :
+                                                (phy_struct->FFT_size/2)-phy_struct->FFT_pad_size;
+
     // Calculate index and CP length
     uint32 CP_len = phy_struct->N_samps_cp_l_else;
     if((symbol_offset % 7) == 0)
         CP_len = phy_struct->N_samps_cp_l_0;
 
-    for(uint32 i=0; i<phy_struct->N_samps_per_symb; i++)
+    // DC and guard band
+    in[0][0] = 0;
+    in[0][1] = 0;
+    for(uint32 i=N_sc_half+1; i<N_fft-N_sc_half; i++)
     {
-        phy_struct->s2s_in[i][0] = 0;
-        phy_struct->s2s_in[i][1] = 0;
+        in[i][0] = 0;
+        in[i][1] = 0;
     }
-    for(uint32 i=0; i<(phy_struct->FFT_size/2)-phy_struct->FFT_pad_size; i++)
+    for(uint32 i=0; i<N_sc_half; i++)
     {
         // Positive spectrum
-        phy_struct->s2s_in[i+1][0] = symb[i+((phy_struct->FFT_size/2)-phy_struct->FFT_pad_size)].real();
-        phy_struct->s2s_in[i+1][1] = symb[i+((phy_struct->FFT_size/2)-phy_struct->FFT_pad_size)].imag();
+        in[i+1][0] = symb[N_sc_half+i].real();
+        in[i+1][1] = symb[N_sc_half+i].imag();
 
         // Negative spectrum
-        phy_struct->s2s_in[phy_struct->N_samps_per_symb-i-1][0] = symb[((phy_struct->FFT_size/2)-phy_struct->FFT_pad_size)-i-1].real();
-        phy_struct->s2s_in[phy_struct->N_samps_per_symb-i-1][1] = symb[((phy_struct->FFT_size/2)-phy_struct->FFT_pad_size)-i-1].imag();
+        in[N_fft-i-1][0] = symb[N_sc_half-i-1].real();
+        in[N_fft-i-1][1] = symb[N_sc_half-i-1].imag();
     }
     fftwf_execute(phy_struct->symbs_to_samps_dl_plan);
-    for(uint32 i=0; i<phy_struct->N_samps_per_symb; i++)
-        samps[CP_len+i] = complex(phy_struct->s2s_out[i][0], phy_struct->s2s_out[i][1]);
+    for(uint32 i=0; i<N_fft; i++)
+        samps[CP_len+i] = complex(out[i][0], out[i][1]);
     for(uint32 i=0; i<CP_len; i++)
-        samps[i] = samps[phy_struct->N_samps_per_symb+i];
-    *N_samps = phy_struct->N_samps_per_symb + CP_len;
+        samps[i] = samps[N_fft+i];
+    *N_samps = N_fft + CP_len;
 }
-void samples_to_symbols_dl(LIBLTE_PHY_STRUCT *phy_struct,
-                           complex           *samps,
-                           uint32             slot_start_idx,
-                           uint32             symbol_offset,
-                           uint8              scale,
-                           complex           *symb)
+template<uint32 N_RB_DL>
+void samples_to_symbols_dl_kernel(LIBLTE_PHY_STRUCT *phy_struct,
+                                  complex           *samps,
+                                  uint32             slot_start_idx,
+                                  uint32             symbol_offset,
+                                  uint8              scale,
+                                  complex           *symb)
 {
+    fftwf_complex *in        = phy_struct->s2s_in;
+    fftwf_complex *out       = phy_struct->s2s_out;
+    uint32         N_fft     = phy_struct->N_samps_per_symb;
+    const uint32   N_sc_half = (0 != N_RB_DL) ? (N_RB_DL*LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP)/2 :
+                                                (phy_struct->FFT_size/2)-phy_struct->FFT_pad_size;
+
     // Calculate index and CP length
     uint32 CP_len = phy_struct->N_samps_cp_l_else;
     if((symbol_offset % 7) == 0)
         CP_len = phy_struct->N_samps_cp_l_0;
-    uint32 index = slot_start_idx + (phy_struct->N_samps_per_symb+phy_struct->N_samps_cp_l_else)*symbol_offset;
+    uint32 index = slot_start_idx + (N_fft+phy_struct->N_samps_cp_l_else)*symbol_offset;
     if(symbol_offset > 0)
         index += phy_struct->N_samps_cp_l_0 - phy_struct->N_samps_cp_l_else;
 
-    for(uint32 i=0; i<phy_struct->N_samps_per_symb; i++)
+    complex *samps_ptr = &samps[index+CP_len-1];
+    for(uint32 i=0; i<N_fft; i++)
     {
-        phy_struct->s2s_in[i][0] = samps[index+CP_len-1+i].real();
-        phy_struct->s2s_in[i][1] = samps[index+CP_len-1+i].imag();
+        in[i][0] = samps_ptr[i].real();
+        in[i][1] = samps_ptr[i].imag();
     }
     fftwf_execute(phy_struct->samps_to_symbs_dl_plan);
-    for(uint32 i=0; i<(phy_struct->FFT_size/2)-phy_struct->FFT_pad_size; i++)
+    for(uint32 i=0; i<N_sc_half; i++)
     {
         // Positive spectrum
-        symb[i+((phy_struct->FFT_size/2)-phy_struct->FFT_pad_size)] =
-            complex(phy_struct->s2s_out[i+1][0], phy_struct->s2s_out[i+1][1]);
+        symb[N_sc_half+i] = complex(out[i+1][0], out[i+1][1]);
 
         // Negative spectrum
-        symb[((phy_struct->FFT_size/2)-phy_struct->FFT_pad_size)-i-1] =
-            complex(phy_struct->s2s_out[phy_struct->N_samps_per_symb-i-1][0], phy_struct->s2s_out[phy_struct->N_samps_per_symb-i-1][1]);
+        symb[N_sc_half-i-1] = complex(out[N_fft-i-1][0], out[N_fft-i-1][1]);
     }
 
     if(scale == 1)
-        for(uint32 i=0; i<2*((phy_struct->FFT_size/2)-phy_struct->FFT_pad_size); i++)
+        for(uint32 i=0; i<2*N_sc_half; i++)
             symb[i] = complex_polar(1, std::arg(symb[i]));
 }
+template<uint32 N_RB_DL>
+void map_crs_kernel(LIBLTE_PHY_STRUCT          *phy_struct,
+                    complex                   **crs,
+                    uint32                      N_id_cell,
+                    uint8                       N_ant,
+                    LIBLTE_PHY_SUBFRAME_STRUCT *subframe)
+{
+    const uint32 N_rb_dl = (0 != N_RB_DL) ? N_RB_DL : phy_struct->N_rb_dl;
+    uint32       v_p0_2[4]   = {0, 3, 0, 3};
+    uint32       v_p1[4]     = {3, 0, 3, 0};
+    uint32       v_p3[2]     = {3, 6};
+    uint32       sym_p0_1[4] = {0, 4, 7, 11};
+    uint32       sym_p2_3[2] = {1, 8};
+    uint32       v_shift     = N_id_cell % 6;
 
-/*********************************************************************
-    Name: symbols_to_samples_ul / samples_to_symbols_ul
+    for(uint32 p=0; p<N_ant; p++)
+    {
+        uint32 *v;
+        uint32 *sym;
+        uint32  N_sym;
+        if(p == 0)
+        {
+            v     = v_p0_2;
+            sym   = sym_p0_1;
+            N_sym = 4;
+        }else if(p == 1){
+            v     = v_p1;
+            sym   = sym_p0_1;
+            N_sym = 4;
+        }else if(p == 2){
+            v     = v_p0_2;
+            sym   = sym_p2_3;
+            N_sym = 2;
+        }else{ // p == 3
+            v     = v_p3;
+            sym   = sym_p2_3;
+            N_sym = 2;
+        }
+        for(uint32 i=0; i<N_sym; i++)
+        {
+            complex *tx_symb = &subframe->tx_symb[p][sym[i]][(v[i] + v_shift)%6];
+            complex *rs      = &crs[sym[i]][LIBLTE_PHY_N_RB_DL_MAX - N_rb_dl];
+            for(uint32 j=0; j<2*N_rb_dl; j++)
+                tx_symb[6*j] = rs[j];
+        }
+    }
+}
+template<uint32 N_RB_DL>
+void dl_ce_kernel(LIBLTE_PHY_STRUCT          *phy_struct,
+                  uint32                      N_id_cell,
+                  uint8                       N_ant,
+                  uint32                      first_prb,
+                  uint32                      N_prb,
+                  uint32                      first_symb,
+                  uint32                      N_symbs,
+                  LIBLTE_PHY_SUBFRAME_STRUCT *subframe)
+{
+    const uint32 N_rb_dl    = (0 != N_RB_DL) ? N_RB_DL : phy_struct->N_rb_dl;
+    const uint32 N_sc_rb_dl = (0 != N_RB_DL) ? LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP : phy_struct->N_sc_rb_dl;
+    uint32       last_symb  = first_symb + N_symbs - 1;
+    uint32       first_sc   = first_prb*N_sc_rb_dl;
+    uint32       end_sc     = (first_prb + N_prb)*N_sc_rb_dl;
+    uint32       first_crs  = 2*first_prb;
+    uint32       end_crs    = 2*(first_prb + N_prb);
+    float       *dl_ce_mag[5];
+    float       *dl_ce_ang[5];
+
+    // Rows of the magnitude and phase scratch are N_RB_DL PRBs apart
+    // rather than 20 MHz apart, so small bandwidths stay in a few cache
+    // lines
+    for(uint32 i=0; i<5; i++)
+    {
+        dl_ce_mag[i] = (float *)phy_struct->dl_ce_mag + i*N_rb_dl*N_sc_rb_dl;
+        dl_ce_ang[i] = (float *)phy_struct->dl_ce_ang + i*N_rb_dl*N_sc_rb_dl;
+    }
+
+    for(uint32 p=0; p<N_ant; p++)
+    {
+        // Define v, sym, and N_sym
+        uint32 *v;
+        uint32 *sym;
+        uint32  N_sym;
+        uint32  v_p0[5]      = {0, 3, 0, 3, 0};
+        uint32  v_p1[5]      = {3, 0, 3, 0, 3};
+        uint32  v_p2[3]      = {0, 3, 0};
+        uint32  v_p3[3]      = {3, 6, 3};
+        uint32  sym_p0_p1[5] = {0, 4, 7, 11, 14};
+        uint32  sym_p2_p3[3] = {1, 8, 15};
+        if(p == 0)
+        {
+            v     = v_p0;
+            sym   = sym_p0_p1;
+            N_sym = 5;
+        }else if(p == 1){
+            v     = v_p1;
+            sym   = sym_p0_p1;
+            N_sym = 5;
+        }else if(p == 2){
+            v     = v_p2;
+            sym   = sym_p2_p3;
+            N_sym = 3;
+        }else{ // p == 3
+            v     = v_p3;
+            sym   = sym_p2_p3;
+            N_sym = 3;
+        }
+
+        float  frac_mag = 0;
+        float  frac_ang = 0;
+        uint32 v_shift  = N_id_cell % 6;
+        uint32 crs_mask = get_dl_ce_crs_mask(p, first_symb, last_symb);
+        for(uint32 i=0; i<N_sym; i++)
+        {
+            if(0 == (crs_mask & (1 << i)))
+                continue;
+
+            complex *sym_c = &subframe->rx_symb[sym[i]][0];
+            complex *rs    = &phy_struct->dl_ce_crs[sym[i]][LIBLTE_PHY_N_RB_DL_MAX - N_rb_dl];
+            float   *mag   = &dl_ce_mag[i][0];
+            float   *ang   = &dl_ce_ang[i][0];
+            uint32   k     = 0;
+
+            for(uint32 j=first_crs; j<end_crs; j++)
+            {
+                k           = 6*j + (v[i] + v_shift)%6;
+                complex tmp = sym_c[k] / rs[j];
+                mag[k]      = std::abs(tmp);
+                ang[k]      = std::arg(tmp);
+
+                // Unwrap phase
+                if(j > first_crs)
+                {
+                    wrap_phase(&ang[k], ang[k-6]);
+
+                    // Linearly interpolate between CRSs
+                    frac_mag = (mag[k] - mag[k-6])/6;
+                    frac_ang = (ang[k] - ang[k-6])/6;
+                    for(uint32 z=1; z<6; z++)
+                    {
+                        mag[k-z] = mag[k-(z-1)] - frac_mag;
+                        ang[k-z] = ang[k-(z-1)] - frac_ang;
+                    }
+                }
+
+                // Linearly interpolate before 1st CRS
+                if(j == first_crs+1)
+                {
+                    for(uint32 z=1; z<((v[i] + v_shift)%6)+1; z++)
+                    {
+                        mag[k-6-z] = mag[k-6-(z-1)] - frac_mag;
+                        ang[k-6-z] = ang[k-6-(z-1)] - frac_ang;
+                    }
+                }
+            }
+
+            // Linearly interpolate after last CRS
+            for(uint32 z=1; z<(5-(v[i] + v_shift)%6)+1; z++)
+            {
+                mag[k+z] = mag[k+(z-1)] + frac_mag;
+                ang[k+z] = ang[k+(z-1)] + frac_ang;
+            }
+        }
+
+        // Linearly interpolate between symbols to construct the requested channel estimates
+        float ce_mag;
+        float ce_ang;
+        if(N_sym == 3)
+        {
+            for(uint32 j=first_sc; j<end_sc; j++)
+            {
+                // Construct symbol 1 and 8 channel estimates directly
+                if(first_symb <= 1 && last_symb >= 1)
+                    subframe->rx_ce[p][1][j] = complex_polar(dl_ce_mag[0][j], dl_ce_ang[0][j]);
+                if(first_symb <= 8 && last_symb >= 8)
+                    subframe->rx_ce[p][8][j] = complex_polar(dl_ce_mag[1][j], dl_ce_ang[1][j]);
+
+                if(first_symb <= 7)
+                {
+                    // Interpolate for symbol 2, 3, 4, 5, 6, and 7 channel estimates
+                    frac_mag = (dl_ce_mag[1][j] - dl_ce_mag[0][j])/7;
+                    wrap_phase(&dl_ce_ang[1][j], dl_ce_ang[0][j]);
+                    frac_ang = (dl_ce_ang[1][j] - dl_ce_ang[0][j]);
+                    wrap_phase(&frac_ang, 0);
+                    frac_ang /= 7;
+                    ce_mag    = dl_ce_mag[1][j];
+                    ce_ang    = dl_ce_ang[1][j];
+                    for(uint32 z=7; z>1; z--)
+                    {
+                        ce_mag                   -= frac_mag;
+                        ce_ang                   -= frac_ang;
+                        subframe->rx_ce[p][z][j]  = complex_polar(ce_mag, ce_ang);
+                    }
+
+                    // Interpolate for symbol 0 channel estimate
+                    // FIXME: Use previous slot to do this correctly
+                    ce_mag                   = dl_ce_mag[0][j] - frac_mag;
+                    ce_ang                   = dl_ce_ang[0][j] - frac_ang;
+                    subframe->rx_ce[p][0][j] = complex_polar(ce_mag, ce_ang);
+                }
+
+                if(last_symb >= 9)
+                {
+                    // Interpolate for symbol 9, 10, 11, 12, and 13 channel estimates
+                    frac_mag = (dl_ce_mag[2][j] - dl_ce_mag[1][j])/7;
+                    wrap_phase(&dl_ce_ang[2][j], dl_ce_ang[1][j]);
+                    frac_ang = (dl_ce_ang[2][j] - dl_ce_ang[1][j]);
+                    wrap_phase(&frac_ang, 0);
+                    frac_ang /= 7;
+                    ce_mag    = dl_ce_mag[2][j] - frac_mag;
+                    ce_ang    = dl_ce_ang[2][j] - frac_ang;
+                    for(uint32 z=13; z>8; z--)
+                    {
+                        ce_mag                   -= frac_mag;
+                        ce_ang                   -= frac_ang;
+                        subframe->rx_ce[p][z][j]  = complex_polar(ce_mag, ce_ang);
+                    }
+                }
+            }
+        }else{
+            for(uint32 j=first_sc; j<end_sc; j++)
+            {
+                // Construct symbol 0, 4, 7, and 11 channel estimates directly
+                if(0 == first_symb)
+                    subframe->rx_ce[p][0][j]  = complex_polar(dl_ce_mag[0][j], dl_ce_ang[0][j]);
+                if(first_symb <= 4 && last_symb >= 4)
+                    subframe->rx_ce[p][4][j]  = complex_polar(dl_ce_mag[1][j], dl_ce_ang[1][j]);
+                if(first_symb <= 7 && last_symb >= 7)
+                    subframe->rx_ce[p][7][j]  = complex_polar(dl_ce_mag[2][j], dl_ce_ang[2][j]);
+                if(first_symb <= 11 && last_symb >= 11)
+                    subframe->rx_ce[p][11][j] = complex_polar(dl_ce_mag[3][j], dl_ce_ang[3][j]);
+
+                if(first_symb <= 3 && last_symb >= 1)
+                {
+                    // Interpolate for symbol 1, 2, and 3 channel estimates
+                    frac_mag = (dl_ce_mag[1][j] - dl_ce_mag[0][j])/4;
+                    wrap_phase(&dl_ce_ang[1][j], dl_ce_ang[0][j]);
+                    frac_ang = (dl_ce_ang[1][j] - dl_ce_ang[0][j]);
+                    wrap_phase(&frac_ang, 0);
+                    frac_ang /= 4;
+                    ce_mag    = dl_ce_mag[1][j];
+                    ce_ang    = dl_ce_ang[1][j];
+                    for(uint32 z=3; z>0; z--)
+                    {
+                        ce_mag                   -= frac_mag;
+                        ce_ang                   -= frac_ang;
+                        subframe->rx_ce[p][z][j]  = complex_polar(ce_mag, ce_ang);
+                    }
+                }
+
+                if(first_symb <= 6 && last_symb >= 5)
+                {
+                    // Interpolate for symbol 5 and 6 channel estimates
+                    frac_mag = (dl_ce_mag[2][j] - dl_ce_mag[1][j])/3;
+                    wrap_phase(&dl_ce_ang[2][j], dl_ce_ang[1][j]);
+                    frac_ang = (dl_ce_ang[2][j] - dl_ce_ang[1][j]);
+                    wrap_phase(&frac_ang, 0);
+                    frac_ang /= 3;
+                    ce_mag    = dl_ce_mag[2][j];
+                    ce_ang    = dl_ce_ang[2][j];
+                    for(uint32 z=6; z>4; z--)
+                    {
+                        ce_mag                   -= frac_mag;
+                        ce_ang                   -= frac_ang;
+                        subframe->rx_ce[p][z][j]  = complex_polar(ce_mag, ce_ang);
+                    }
+                }
+
+                if(last_symb >= 8)
+                {
+                    // Interpolate for symbol 8, 9, and 10 channel estimates
+                    frac_mag = (dl_ce_mag[3][j] - dl_ce_mag[2][j])/4;
+                    wrap_phase(&dl_ce_ang[3][j], dl_ce_ang[2][j]);
+                    frac_ang = (dl_ce_ang[3][j] - dl_ce_ang[2][j]);
+                    wrap_phase(&frac_ang, 0);
+                    frac_ang /= 4;
+                    ce_mag    = dl_ce_mag[3][j];
+                    ce_ang    = dl_ce_ang[3][j];
+                    for(uint32 z=10; z>7; z--)
+                    {
+                        ce_mag                   -= frac_mag;
+                        ce_ang                   -= frac_ang;
+                        subframe->rx_ce[p][z][j]  = complex_polar(ce_mag, ce_ang);
+                    }
+
+                    // Linearly interpolate for symbol 12 and 13 channel estimates
+                    ce_mag = dl_ce_mag[3][j];
+                    ce_ang = dl_ce_ang[3][j];
+                    for(uint32 z=12; z<14; z++)
+                    {
+                        ce_mag                   += frac_mag;
+                        ce_ang                   += frac_ang;
+                        subframe->rx_ce[p][z][j]  = complex_polar(ce_mag, ce_ang);
+                    }
+                }
+            }
+        }
+    }
+}
+template<uint32 N_RB_DL>
+void pdsch_map_kernel(LIBLTE_PHY_STRUCT            *phy_struct,
+                      LIBLTE_PHY_ALLOCATION_STRUCT *alloc,
+                      uint32                        N_pdcch_symbs,
+                      uint32                        N_id_cell,
+                      uint8                         N_ant,
+                      LIBLTE_PHY_SUBFRAME_STRUCT   *subframe)
+{
+    const uint32 N_rb_dl    = (0 != N_RB_DL) ? N_RB_DL : phy_struct->N_rb_dl;
+    const uint32 N_sc_rb_dl = (0 != N_RB_DL) ? LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP : phy_struct->N_sc_rb_dl;
+
+    for(uint32 p=0; p<N_ant; p++)
+    {
+        uint32 idx = 0;
+        for(uint32 L=N_pdcch_symbs; L<14; L++)
+        {
+            for(uint32 prb_idx=0; prb_idx<alloc->N_prb; prb_idx++)
+            {
+                uint32   i       = alloc->prb[L/7][prb_idx];
+                complex *tx_symb = &subframe->tx_symb[p][L][i*N_sc_rb_dl];
+                for(uint32 j=0; j<N_sc_rb_dl; j++)
+                {
+                    if(is_this_RE_for_PDSCH(N_ant, L, N_id_cell, j, N_rb_dl, N_sc_rb_dl, subframe->num, i))
+                        tx_symb[j] = phy_struct->pdsch_y[p][idx++];
+                }
+            }
+        }
+    }
+}
+template<uint32 N_RB_DL>
+uint32 pdsch_demap_kernel(LIBLTE_PHY_STRUCT            *phy_struct,
+                          LIBLTE_PHY_SUBFRAME_STRUCT   *subframe,
+                          LIBLTE_PHY_ALLOCATION_STRUCT *alloc,
+                          uint32                        N_pdcch_symbs,
+                          uint32                        N_id_cell,
+                          uint8                         N_ant)
+{
+    const uint32 N_rb_dl    = (0 != N_RB_DL) ? N_RB_DL : phy_struct->N_rb_dl;
+    const uint32 N_sc_rb_dl = (0 != N_RB_DL) ? LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP : phy_struct->N_sc_rb_dl;
+    uint32       idx        = 0;
+
+    for(uint32 L=N_pdcch_symbs; L<14; L++)
+    {
+        for(uint32 prb_idx=0; prb_idx<alloc->N_prb; prb_idx++)
+        {
+            uint32 i    = alloc->prb[L/7][prb_idx];
+            uint32 k_rb = i*N_sc_rb_dl;
+            for(uint32 j=0; j<N_sc_rb_dl; j++)
+            {
+                if(!is_this_RE_for_PDSCH(N_ant, L, N_id_cell, j, N_rb_dl, N_sc_rb_dl, subframe->num, i))
+                    continue;
+                phy_struct->pdsch_y_est[idx] = subframe->rx_symb[L][k_rb+j];
+                for(uint32 p=0; p<N_ant; p++)
+                    phy_struct->pdsch_c_est[p][idx] = subframe->rx_ce[p][L][k_rb+j];
+                idx++;
+            }
+        }
+    }
+
+    return idx;
+}
+#define DL_KERNELS_ENTRY(N_RB_DL) {N_RB_DL,                               \
+                                   symbols_to_samples_dl_kernel<N_RB_DL>, \
+                                   samples_to_symbols_dl_kernel<N_RB_DL>, \
+                                   map_crs_kernel<N_RB_DL>,               \
+                                   dl_ce_kernel<N_RB_DL>,                 \
+                                   pdsch_map_kernel<N_RB_DL>,             \
+                                   pdsch_demap_kernel<N_RB_DL>}
+const LIBLTE_PHY_DL_KERNELS_STRUCT dl_kernels[N_DL_KERNELS] = {DL_KERNELS_ENTRY(0),
+                                                               DL_KERNELS_ENTRY(LIBLTE_PHY_N_RB_DL_1_4MHZ),
+                                                               DL_KERNELS_ENTRY(LIBLTE_PHY_N_RB_DL_3MHZ),
+                                                               DL_KERNELS_ENTRY(LIBLTE_PHY_N_RB_DL_5MHZ),
+                                                               DL_KERNELS_ENTRY(LIBLTE_PHY_N_RB_DL_10MHZ),
+                                                               DL_KERNELS_ENTRY(LIBLTE_PHY_N_RB_DL_15MHZ),
+                                                               DL_KERNELS_ENTRY(LIBLTE_PHY_N_RB_DL_20MHZ)};
+
+/*********************************************************************
+    Name: symbols_to_samples_dl / samples_to_symbols_dl
+
+    Description: Converts subcarrier symbols to I/Q samples for the
+                 downlink / Converts I/Q samples to subcarrier symbols
+                 for the downlink
+
+    Document Reference: 3GPP TS 36.211 v10.1.0 section 6.12
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+void symbols_to_samples_dl(LIBLTE_PHY_STRUCT *phy_struct,
+                           complex           *symb,
+                           uint32             symbol_offset,
+                           complex           *samps,
+                           uint32            *N_samps)
+{
+    dl_kernels[phy_struct->dl_kernels_idx].symbols_to_samples_dl(phy_struct,
+                                                                 symb,
+                                                                 symbol_offset,
+                                                                 samps,
+                                                                 N_samps);
+}
+void samples_to_symbols_dl(LIBLTE_PHY_STRUCT *phy_struct,
+                           complex           *samps,
+                           uint32             slot_start_idx,
+                           uint32             symbol_offset,
+                           uint8              scale,
+                           complex           *symb)
+{
+    dl_kernels[phy_struct->dl_kernels_idx].samples_to_symbols_dl(phy_struct,
+                                                                 samps,
+                                                                 slot_start_idx,
+                                                                 symbol_offset,
+                                                                 scale,
+                                                                 symb);
+}
+
+/*********************************************************************
+    Name: symbols_to_samples_ul / samples_to_symbols_ul
 
     Description: Converts subcarrier symbols to I/Q samples for the
                  uplink / Converts I/Q samples to subcarrier symbols
@@ -4188,6 +5249,14 @@ void ulsch_channel_deinterleaver(LIBLTE_PHY_STRUCT *phy_struct,
 // Enums
 // Structs
 // Functions
+inline int16 saturate_soft_bit(float bit)
+{
+    if(bit > LIBLTE_PHY_SOFT_BUFFER_MAX_BIT)
+        return LIBLTE_PHY_SOFT_BUFFER_MAX_BIT;
+    if(bit < -LIBLTE_PHY_SOFT_BUFFER_MAX_BIT)
+        return -LIBLTE_PHY_SOFT_BUFFER_MAX_BIT;
+    return (int16)lrintf(bit);
+}
 void ulsch_channel_encode(LIBLTE_PHY_STRUCT *phy_struct,
                           uint8             *in_bits,
                           uint32             N_in_bits,
@@ -4289,18 +5358,19 @@ void ulsch_channel_encode(LIBLTE_PHY_STRUCT *phy_struct,
                               out_bits,
                               N_out_bits);
 }
-LIBLTE_ERROR_ENUM ulsch_channel_decode(LIBLTE_PHY_STRUCT *phy_struct,
-                                       float             *in_bits,
-                                       uint32             N_in_bits,
-                                       uint32             tbs,
-                                       uint32             tx_mode,
-                                       uint32             G,
-                                       uint32             N_l,
-                                       uint32             Q_m,
-                                       uint32             rv_idx,
-                                       uint32             N_turbo_iterations,
-                                       uint8             *out_bits,
-                                       uint32            *N_out_bits)
+LIBLTE_ERROR_ENUM ulsch_channel_decode(LIBLTE_PHY_STRUCT             *phy_struct,
+                                       float                         *in_bits,
+                                       uint32                         N_in_bits,
+                                       uint32                         tbs,
+                                       uint32                         tx_mode,
+                                       uint32                         G,
+                                       uint32                         N_l,
+                                       uint32                         Q_m,
+                                       uint32                         rv_idx,
+                                       uint32                         N_turbo_iterations,
+                                       LIBLTE_PHY_SOFT_BUFFER_STRUCT *soft_buffer,
+                                       uint8                         *out_bits,
+                                       uint32                        *N_out_bits)
 {
     // In order to decode an ULSCH message, the NULL bit pattern must be
     // determined by encoding a sequence of zeros
@@ -4378,7 +5448,46 @@ LIBLTE_ERROR_ENUM ulsch_channel_decode(LIBLTE_PHY_STRUCT *phy_struct,
                                       phy_struct->ulsch_rx_d_bits,
                                       &N_d_bits);
 
+        // Chase/IR combine with the earlier transmissions, bits that
+        // have not been received by any transmission stay punctured
+        if(soft_buffer != NULL)
+        {
+            int16 *soft_bits = soft_buffer->d_bits[cb];
+            float *rx_bits   = phy_struct->ulsch_rx_d_bits;
+            if(0 == soft_buffer->N_combined || tbs != soft_buffer->tbs)
+            {
+                for(uint32 i=0; i<N_d_bits; i++)
+                {
+                    if(RX_NULL_BIT == rx_bits[i])
+                    {
+                        soft_bits[i] = LIBLTE_PHY_SOFT_BUFFER_NULL_BIT;
+                    }else{
+                        soft_bits[i] = saturate_soft_bit(rx_bits[i]);
+                    }
+                }
+            }else{
+                for(uint32 i=0; i<N_d_bits; i++)
+                {
+                    if(LIBLTE_PHY_SOFT_BUFFER_NULL_BIT == soft_bits[i])
+                    {
+                        if(RX_NULL_BIT != rx_bits[i])
+                            soft_bits[i] = saturate_soft_bit(rx_bits[i]);
+                    }else if(RX_NULL_BIT != rx_bits[i]){
+                        soft_bits[i] = saturate_soft_bit(soft_bits[i] + rx_bits[i]);
+                    }
+                    if(LIBLTE_PHY_SOFT_BUFFER_NULL_BIT == soft_bits[i])
+                    {
+                        rx_bits[i] = RX_NULL_BIT;
+                    }else{
+                        rx_bits[i] = soft_bits[i];
+                    }
+                }
+            }
+        }
+
         // Determine c_bits
+        if(NULL != phy_struct->turbo_decode_hook)
+            phy_struct->turbo_decode_hook(phy_struct->turbo_decode_hook_obj, false);
         turbo_decode(phy_struct,
                      phy_struct->ulsch_rx_d_bits,
                      N_d_bits,
@@ -4386,6 +5495,14 @@ LIBLTE_ERROR_ENUM ulsch_channel_decode(LIBLTE_PHY_STRUCT *phy_struct,
                      N_turbo_iterations,
                      phy_struct->ulsch_c.bits[cb],
                      &phy_struct->ulsch_c.N_bits[cb]);
+        if(NULL != phy_struct->turbo_decode_hook)
+            phy_struct->turbo_decode_hook(phy_struct->turbo_decode_hook_obj, true);
+    }
+
+    if(soft_buffer != NULL)
+    {
+        soft_buffer->tbs = tbs;
+        soft_buffer->N_combined++;
     }
 
     // Determine b_bits
@@ -4859,34 +5976,95 @@ LIBLTE_ERROR_ENUM dci_channel_decode(LIBLTE_PHY_STRUCT *phy_struct,
 }
 
 /*********************************************************************
-    Name: dci_0_pack / dci_0_unpack
-
-    Description: Packs / Unpacks all of the fields into / from the
-                 Downlink Control Information format 0
+    Name: get_mcs_from_I_tbs / get_I_tbs_from_mcs /
+          get_I_tbs_from_ul_mcs
 
-    Document Reference: 3GPP TS 36.212 v10.1.0 section 5.3.3.1.1
-                        3GPP TS 36.213 v10.3.0 section 8.1.1
-                        3GPP TS 36.213 v10.3.0 section 8.6
+    Description: Calculates MCS based on Itbs and vice versa
 
-    Notes: Currently only handles non-hopping single-cluster
-           assignments
+    Document Reference: 3GPP TS 36.213 v10.3.0 sections 7.1.7.1 and
+                        8.6.1
 *********************************************************************/
 // Defines
-#define DCI_0_1A_FLAG_0          0
-#define DCI_0_1A_FLAG_1A         1
-#define DCI_VRB_TYPE_LOCALIZED   0
-#define DCI_VRB_TYPE_DISTRIBUTED 1
 // Enums
 // Structs
 // Functions
-void dci_0_pack(LIBLTE_PHY_ALLOCATION_STRUCT    *alloc,
-                LIBLTE_PHY_DCI_CA_PRESENCE_ENUM  ca_presence,
-                uint32                           N_rb_ul,
-                uint8                            N_ant,
-                uint8                           *out_bits,
-                uint32                          *N_out_bits)
+uint8 get_mcs_from_I_tbs(uint32 I_tbs)
 {
-    uint8 *dci = out_bits;
+    if(9 >= I_tbs)
+        return I_tbs;
+    if(15 >= I_tbs)
+        return I_tbs + 1;
+    return I_tbs + 2;
+}
+uint32 get_I_tbs_from_mcs(uint8 mcs)
+{
+    if(9 >= mcs)
+        return mcs;
+    if(16 >= mcs)
+        return mcs - 1;
+    return mcs - 2;
+}
+uint32 get_I_tbs_from_ul_mcs(uint8 mcs)
+{
+    if(10 >= mcs)
+        return mcs;
+    if(20 >= mcs)
+        return mcs - 1;
+    return mcs - 2;
+}
+
+/*********************************************************************
+    Name: get_rbg_size
+
+    Description: Calculates the resource block group size used by
+                 downlink resource allocation type 0
+
+    Document Reference: 3GPP TS 36.213 v10.3.0 section 7.1.6.1
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+uint32 get_rbg_size(uint32 N_rb_dl)
+{
+    if(10 >= N_rb_dl)
+        return 1;
+    if(26 >= N_rb_dl)
+        return 2;
+    if(63 >= N_rb_dl)
+        return 3;
+    return 4;
+}
+
+/*********************************************************************
+    Name: dci_0_pack / dci_0_unpack
+
+    Description: Packs / Unpacks all of the fields into / from the
+                 Downlink Control Information format 0
+
+    Document Reference: 3GPP TS 36.212 v10.1.0 section 5.3.3.1.1
+                        3GPP TS 36.213 v10.3.0 section 8.1.1
+                        3GPP TS 36.213 v10.3.0 section 8.6
+
+    Notes: Currently only handles non-hopping single-cluster
+           assignments
+*********************************************************************/
+// Defines
+#define DCI_0_1A_FLAG_0          0
+#define DCI_0_1A_FLAG_1A         1
+#define DCI_VRB_TYPE_LOCALIZED   0
+#define DCI_VRB_TYPE_DISTRIBUTED 1
+// Enums
+// Structs
+// Functions
+void dci_0_pack(LIBLTE_PHY_ALLOCATION_STRUCT    *alloc,
+                LIBLTE_PHY_DCI_CA_PRESENCE_ENUM  ca_presence,
+                uint32                           N_rb_ul,
+                uint8                            N_ant,
+                uint8                           *out_bits,
+                uint32                          *N_out_bits)
+{
+    uint8 *dci = out_bits;
 
     // Carrier indicator
     if(LIBLTE_PHY_DCI_CA_PRESENT == ca_presence)
@@ -5031,7 +6209,7 @@ void dci_1a_pack(LIBLTE_PHY_ALLOCATION_STRUCT    *alloc,
         liblte_value_2_bits(alloc->tpc, &dci, 2);
 
         // Calculate the TBS
-        alloc->tbs = TBS_71721[alloc->mcs][alloc->N_prb-1];
+        alloc->tbs = TBS_71721[get_I_tbs_from_mcs(alloc->mcs)][alloc->N_prb-1];
     }
 
     // Pad if needed
@@ -5153,13 +6331,100 @@ LIBLTE_ERROR_ENUM dci_1a_unpack(uint8                           *in_bits,
         alloc->pre_coder_type = LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY;
         alloc->tx_mode        = 1;
         alloc->N_codewords    = 1;
-        alloc->tbs            = TBS_71721[alloc->mcs][alloc->N_prb-1];
+        if(28 < alloc->mcs)
+            return LIBLTE_ERROR_INVALID_CONTENTS;
+        alloc->tbs            = TBS_71721[get_I_tbs_from_mcs(alloc->mcs)][alloc->N_prb-1];
         alloc->rnti           = rnti;
     }
 
     return LIBLTE_SUCCESS;
 }
 
+/*********************************************************************
+    Name: dci_1_pack
+
+    Description: Packs all of the fields into the Downlink Control
+                 Information format 1
+
+    Document Reference: 3GPP TS 36.212 v10.1.0 section 5.3.3.1.2
+                        3GPP TS 36.213 v10.3.0 section 7.1.6.1
+                        3GPP TS 36.213 v10.3.0 section 7.1.7
+
+    Notes: Currently only handles C-RNTI and resource allocation
+           type 0
+*********************************************************************/
+// Defines
+#define DCI_RA_TYPE_0 0
+// Enums
+// Structs
+// Functions
+void dci_1_pack(LIBLTE_PHY_ALLOCATION_STRUCT    *alloc,
+                LIBLTE_PHY_DCI_CA_PRESENCE_ENUM  ca_presence,
+                uint32                           N_rb_dl,
+                uint8                            N_ant,
+                uint8                           *out_bits,
+                uint32                          *N_out_bits)
+{
+    uint8 *dci = out_bits;
+
+    // Carrier indicator
+    if(LIBLTE_PHY_DCI_CA_PRESENT == ca_presence)
+    {
+        printf("WARNING: Not handling carrier indicator\n");
+        liblte_value_2_bits(0, &dci, 3);
+    }
+
+    // Resource allocation header
+    if(10 < N_rb_dl)
+        liblte_value_2_bits(DCI_RA_TYPE_0, &dci, 1);
+
+    // Resource block group bitmap, RBG 0 is the MSB
+    uint32 P     = get_rbg_size(N_rb_dl);
+    uint32 N_rbg = (N_rb_dl + P - 1)/P;
+    for(uint32 rbg=0; rbg<N_rbg; rbg++)
+    {
+        uint32 bit = 0;
+        for(uint32 i=0; i<alloc->N_prb; i++)
+            if(rbg == alloc->prb[0][i]/P)
+                bit = 1;
+        liblte_value_2_bits(bit, &dci, 1);
+    }
+
+    // Modulation and coding scheme
+    liblte_value_2_bits(alloc->mcs, &dci, 5);
+
+    // HARQ process number, FIXME: FDD only
+    liblte_value_2_bits(alloc->harq_process, &dci, 3);
+
+    // New data indicator
+    liblte_value_2_bits(alloc->ndi, &dci, 1);
+
+    // Redundancy version
+    liblte_value_2_bits(alloc->rv_idx, &dci, 2);
+
+    // TPC
+    liblte_value_2_bits(alloc->tpc, &dci, 2);
+
+    // Calculate the TBS
+    alloc->tbs = TBS_71721[get_I_tbs_from_mcs(alloc->mcs)][alloc->N_prb-1];
+
+    // Pad until the size differs from format 0/1A and is not ambiguous
+    uint32 size_1a = ((LIBLTE_PHY_DCI_CA_PRESENT == ca_presence) ? 3 : 0) + 1 + 1 +
+                     (uint32)ceilf(logf(N_rb_dl*(N_rb_dl+1)/2)/logf(2)) + 13;
+    if(size_1a == 12 || size_1a == 14 || size_1a == 16 || size_1a == 20 || size_1a == 24 ||
+       size_1a == 26 || size_1a == 32 || size_1a == 40 || size_1a == 44 || size_1a == 56)
+        size_1a++;
+    uint32 size = dci - out_bits;
+    while(size == size_1a || size == 12 || size == 14 || size == 16 || size == 20 ||
+          size == 24      || size == 26 || size == 32 || size == 40 || size == 44 ||
+          size == 56)
+    {
+        size++;
+        liblte_value_2_bits(0, &dci, 1);
+    }
+    *N_out_bits = size;
+}
+
 /*********************************************************************
     Name: dci_1c_pack / dci_1c_unpack
 
@@ -5402,6 +6667,62 @@ void get_ulsch_ce(LIBLTE_PHY_STRUCT *phy_struct,
     }
 }
 
+/*********************************************************************
+    Name: get_ulsch_sinr
+
+    Description: Estimates the signal to interference plus noise
+                 ratio of the uplink shared channel from the two DMRS
+                 symbols
+
+    Document Reference: N/A
+
+    Notes: The common phase rotation between the slots is removed
+           before differencing, so a frequency offset is not counted
+           as noise
+*********************************************************************/
+// Defines
+#define ULSCH_SINR_MAX_DB 40
+// Enums
+// Structs
+// Functions
+float get_ulsch_sinr(LIBLTE_PHY_STRUCT *phy_struct,
+                     complex           *c_est_0,
+                     complex           *c_est_1,
+                     uint32             N_prb,
+                     uint32             N_subfr)
+{
+    complex *dmrs_0     = phy_struct->pusch_dmrs_0[N_subfr][N_prb];
+    complex *dmrs_1     = phy_struct->pusch_dmrs_1[N_subfr][N_prb];
+    uint32   M_pusch_sc = N_prb * phy_struct->N_sc_rb_ul;
+
+    // Common phase rotation from the first to the second slot
+    complex rot(0, 0);
+    for(uint32 i=0; i<M_pusch_sc; i++)
+        rot += (c_est_1[i] / dmrs_1[i]) * std::conj(c_est_0[i] / dmrs_0[i]);
+    complex derot(1, 0);
+    if(std::abs(rot) > 0)
+        derot = std::conj(rot) / std::abs(rot);
+
+    // Each estimate carries noise N, so |h_0-h_1|^2 averages 2N and
+    // |(h_0+h_1)/2|^2 averages S+N/2
+    float sig   = 0;
+    float noise = 0;
+    for(uint32 i=0; i<M_pusch_sc; i++)
+    {
+        complex h_0 = c_est_0[i] / dmrs_0[i];
+        complex h_1 = (c_est_1[i] / dmrs_1[i]) * derot;
+        sig   += std::norm((h_0 + h_1) * 0.5f);
+        noise += std::norm(h_0 - h_1) * 0.5f;
+    }
+    sig -= noise / 2;
+
+    if(sig <= 0)
+        return -ULSCH_SINR_MAX_DB;
+    if(noise <= sig * powf(10, -ULSCH_SINR_MAX_DB/10.0))
+        return ULSCH_SINR_MAX_DB;
+    return 10*log10f(sig / noise);
+}
+
 /*********************************************************************
     Name: get_ulcch_ce
 
@@ -5621,55 +6942,6 @@ uint32 get_num_bits_in_prb(uint32                          N_subframe,
     }
 }
 
-/*********************************************************************
-    Name: wrap_phase
-
-    Description: Checks the phase difference between two angles and
-                 wraps one to make the difference less than 2*pi.
-
-    Document Reference: N/A
-*********************************************************************/
-// Defines
-// Enums
-// Structs
-// Functions
-inline void wrap_phase(float *phase_1,
-                       float  phase_2)
-{
-    while((*phase_1 - phase_2) >= M_PI)
-        *phase_1 = *phase_1 - 2*M_PI;
-    while((*phase_1 - phase_2) <= -M_PI)
-        *phase_1 = *phase_1 + 2*M_PI;
-}
-
-/*********************************************************************
-    Name: get_mcs_from_I_tbs / get_I_tbs_from_mcs
-
-    Description: Calculates MCS based on Itbs and vice versa
-
-    Document Reference: N/A
-*********************************************************************/
-// Defines
-// Enums
-// Structs
-// Functions
-uint8 get_mcs_from_I_tbs(uint32 I_tbs)
-{
-    if(9 >= I_tbs)
-        return I_tbs;
-    if(15 >= I_tbs)
-        return I_tbs + 1;
-    return I_tbs + 2;
-}
-uint32 get_I_tbs_from_mcs(uint8 mcs)
-{
-    if(9 >= mcs)
-        return mcs;
-    if(16 >= mcs)
-        return mcs - 1;
-    return mcs - 2;
-}
-
 /*******************************************************************************
                               LIBRARY FUNCTIONS
 *******************************************************************************/
@@ -5786,11 +7058,14 @@ LIBLTE_ERROR_ENUM liblte_phy_init(LIBLTE_PHY_STRUCT  **phy_struct,
     default:
         break;
     }
-    (*phy_struct)->N_sc_rb_dl = N_sc_rb_dl;
-    (*phy_struct)->N_sc_rb_ul = LIBLTE_PHY_N_SC_RB_UL;
+    (*phy_struct)->N_sc_rb_dl     = N_sc_rb_dl;
+    (*phy_struct)->N_sc_rb_ul     = LIBLTE_PHY_N_SC_RB_UL;
+    (*phy_struct)->dl_kernels_idx = 0;
     liblte_phy_update_n_rb_dl((*phy_struct), N_rb_dl);
-    (*phy_struct)->N_ant   = N_ant;
-    (*phy_struct)->ul_init = false;
+    (*phy_struct)->N_ant                 = N_ant;
+    (*phy_struct)->ul_init               = false;
+    (*phy_struct)->turbo_decode_hook     = NULL;
+    (*phy_struct)->turbo_decode_hook_obj = NULL;
 
     // PHICH
     if(LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP == (*phy_struct)->N_sc_rb_dl)
@@ -6139,6 +7414,17 @@ LIBLTE_ERROR_ENUM liblte_phy_update_n_rb_dl(LIBLTE_PHY_STRUCT *phy_struct,
         phy_struct->N_rb_dl      = N_rb_dl;
         phy_struct->N_rb_ul      = N_rb_dl;
         phy_struct->FFT_pad_size = (phy_struct->FFT_size - used_subcarriers)/2;
+
+        // Select the downlink kernels for this bandwidth
+        phy_struct->dl_kernels_idx = 0;
+        if(LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP == phy_struct->N_sc_rb_dl)
+        {
+            for(uint32 i=1; i<N_DL_KERNELS; i++)
+            {
+                if(dl_kernels[i].N_rb_dl == N_rb_dl)
+                    phy_struct->dl_kernels_idx = i;
+            }
+        }
     }
 
     return err;
@@ -6248,16 +7534,21 @@ LIBLTE_ERROR_ENUM liblte_phy_pusch_channel_encode(LIBLTE_PHY_STRUCT            *
 
     Document Reference: 3GPP TS 36.211 v10.1.0 section 5.3
 
+    Notes: Leaves the DMRS SINR estimate in phy_struct->pusch_sinr_db
+
+    Notes: Combines with soft_buffer when it is not NULL
+
     Notes: Only handles normal CP
 *********************************************************************/
-LIBLTE_ERROR_ENUM liblte_phy_pusch_channel_decode(LIBLTE_PHY_STRUCT            *phy_struct,
-                                                  LIBLTE_PHY_SUBFRAME_STRUCT   *subframe,
-                                                  LIBLTE_PHY_ALLOCATION_STRUCT *alloc,
-                                                  uint32                        N_id_cell,
-                                                  uint8                         N_ant,
-                                                  uint32                        N_turbo_iterations,
-                                                  uint8                        *out_bits,
-                                                  uint32                       *N_out_bits)
+LIBLTE_ERROR_ENUM liblte_phy_pusch_channel_decode(LIBLTE_PHY_STRUCT             *phy_struct,
+                                                  LIBLTE_PHY_SUBFRAME_STRUCT    *subframe,
+                                                  LIBLTE_PHY_ALLOCATION_STRUCT  *alloc,
+                                                  uint32                         N_id_cell,
+                                                  uint8                          N_ant,
+                                                  uint32                         N_turbo_iterations,
+                                                  LIBLTE_PHY_SOFT_BUFFER_STRUCT *soft_buffer,
+                                                  uint8                         *out_bits,
+                                                  uint32                        *N_out_bits)
 {
     if(phy_struct == NULL || subframe == NULL || alloc == NULL || out_bits == NULL ||
        N_out_bits == NULL || !phy_struct->ul_init)
@@ -6293,6 +7584,11 @@ LIBLTE_ERROR_ENUM liblte_phy_pusch_channel_decode(LIBLTE_PHY_STRUCT            *
                  alloc->N_prb,
                  subframe->num,
                  phy_struct->pusch_c_est);
+    phy_struct->pusch_sinr_db = get_ulsch_sinr(phy_struct,
+                                               phy_struct->pusch_c_est_0,
+                                               phy_struct->pusch_c_est_1,
+                                               alloc->N_prb,
+                                               subframe->num);
     uint32 M_layer_symb = 0;
     de_pre_coder_ul(phy_struct->pusch_z_est,
                     phy_struct->pusch_c_est,
@@ -6338,6 +7634,7 @@ LIBLTE_ERROR_ENUM liblte_phy_pusch_channel_decode(LIBLTE_PHY_STRUCT            *
                                 Q_m,
                                 alloc->rv_idx,
                                 N_turbo_iterations,
+                                soft_buffer,
                                 out_bits,
                                 N_out_bits);
 }
@@ -6856,60 +8153,6 @@ LIBLTE_ERROR_ENUM liblte_phy_detect_prach(LIBLTE_PHY_STRUCT *phy_struct,
 
     Document Reference: 3GPP TS 36.211 v10.1.0 sections 6.3 and 6.4
 *********************************************************************/
-bool is_this_RE_for_PDSCH(uint8 N_ant,
-                          uint32 L,
-                          uint32 N_id_cell,
-                          uint32 sc,
-                          uint32 N_rb_dl,
-                          uint32 N_sc_rb_dl,
-                          uint32 subfr_num,
-                          uint32 prb)
-{
-    if(N_ant == 1 && (L % 7) == 0 && (N_id_cell % 6) == (sc % 6))
-        // Skip CRS
-        return false;
-    if(N_ant == 1 && (L % 7) == 4 && ((N_id_cell+3) % 6) == (sc % 6))
-        // Skip CRS
-        return false;
-    if((N_ant == 2 || N_ant == 4) && ((L % 7) == 0 || (L % 7) == 4) && (N_id_cell % 3) == (sc % 3))
-        // Skip CRS
-        return false;
-    if(N_ant == 4 && (L % 7) == 1 && (N_id_cell % 3) == (sc % 3))
-        // Skip CRS
-        return false;
-    uint32 first_sc;
-    uint32 last_sc;
-    if(N_rb_dl == 6)
-    {
-        first_sc = 0;
-        last_sc  = (6*N_sc_rb_dl)-1;
-    }else if(N_rb_dl == 15){
-        first_sc = (4*N_sc_rb_dl)+6;
-        last_sc  = (11*N_sc_rb_dl)-7;
-    }else if(N_rb_dl == 25){
-        first_sc = (9*N_sc_rb_dl)+6;
-        last_sc  = (16*N_sc_rb_dl)-7;
-    }else if(N_rb_dl == 50){
-        first_sc = 22*N_sc_rb_dl;
-        last_sc  = (28*N_sc_rb_dl)-1;
-    }else if(N_rb_dl == 75){
-        first_sc = (34*N_sc_rb_dl)+6;
-        last_sc  = (41*N_sc_rb_dl)-7;
-    }else{ // N_rb_dl == 100
-        first_sc = 47*N_sc_rb_dl;
-        last_sc  = (53*N_sc_rb_dl)-1;
-    }
-    if(subfr_num == 0 && (prb*N_sc_rb_dl + sc) >= first_sc && (prb*N_sc_rb_dl + sc) <= last_sc && L >= 7 && L <= 10)
-        // Skip PBCH
-        return false;
-    if((subfr_num == 0 || subfr_num == 5) && (prb*N_sc_rb_dl + sc) >= first_sc && (prb*N_sc_rb_dl + sc) <= last_sc && L == 6)
-        // Skip PSS
-        return false;
-    if((subfr_num == 0 || subfr_num == 5) && (prb*N_sc_rb_dl + sc) >= first_sc && (prb*N_sc_rb_dl + sc) <= last_sc && L == 5)
-        // Skip SSS
-        return false;
-    return true;
-}
 LIBLTE_ERROR_ENUM liblte_phy_pdsch_channel_encode(LIBLTE_PHY_STRUCT          *phy_struct,
                                                   LIBLTE_PHY_PDCCH_STRUCT    *pdcch,
                                                   uint32                      N_id_cell,
@@ -6933,6 +8176,13 @@ LIBLTE_ERROR_ENUM liblte_phy_pdsch_channel_encode(LIBLTE_PHY_STRUCT          *ph
                                               phy_struct->N_rb_dl,
                                               N_ant,
                                               pdcch->dl_alloc[alloc_idx].mod_type);
+        // Spatially multiplexed codewords are spread over their share of the layers
+        uint32 N_layers = N_ant;
+        if(LIBLTE_PHY_PRE_CODER_TYPE_SPATIAL_MULTIPLEXING == pdcch->dl_alloc[alloc_idx].pre_coder_type)
+        {
+            N_layers    = pdcch->dl_alloc[alloc_idx].N_layers;
+            N_bits_tot *= N_layers/pdcch->dl_alloc[alloc_idx].N_codewords;
+        }
         // Determine Q_m
         uint32 Q_m = liblte_phy_modulation_type_to_q_m[pdcch->dl_alloc[alloc_idx].mod_type];
         uint32 N_bits;
@@ -6967,38 +8217,30 @@ LIBLTE_ERROR_ENUM liblte_phy_pdsch_channel_encode(LIBLTE_PHY_STRUCT          *ph
         uint32 M_layer_symb = 0;
         layer_mapper_dl(phy_struct->pdsch_d,
                         M_symb,
-                        N_ant,
+                        N_layers,
                         pdcch->dl_alloc[alloc_idx].N_codewords,
                         pdcch->dl_alloc[alloc_idx].pre_coder_type,
                         phy_struct->pdsch_x,
                         &M_layer_symb);
         uint32 M_ap_symb;
-        pre_coder_dl(phy_struct->pdsch_x,
-                     M_layer_symb,
-                     N_ant,
-                     pdcch->dl_alloc[alloc_idx].pre_coder_type,
-                     phy_struct->pdsch_y[0],
-                     5000,
-                     &M_ap_symb);
+        if(LIBLTE_SUCCESS != pre_coder_dl(phy_struct->pdsch_x,
+                                          M_layer_symb,
+                                          N_ant,
+                                          N_layers,
+                                          pdcch->dl_alloc[alloc_idx].codebook_idx,
+                                          pdcch->dl_alloc[alloc_idx].pre_coder_type,
+                                          phy_struct->pdsch_y[0],
+                                          5000,
+                                          &M_ap_symb))
+            return LIBLTE_ERROR_INVALID_INPUTS;
 
         // Map the symbols to resource elements 3GPP TS 36.211 v10.1.0 section 6.3.5
-        for(uint32 p=0; p<N_ant; p++)
-        {
-            uint32 idx = 0;
-            for(uint32 L=pdcch->N_symbs; L<14; L++)
-            {
-                for(uint32 prb_idx=0; prb_idx<pdcch->dl_alloc[alloc_idx].N_prb; prb_idx++)
-                {
-                    uint32 i = pdcch->dl_alloc[alloc_idx].prb[L/7][prb_idx];
-                    for(uint32 j=0; j<phy_struct->N_sc_rb_dl; j++)
-                    {
-                        if(is_this_RE_for_PDSCH(N_ant, L, N_id_cell, j, phy_struct->N_rb_dl,
-                                                phy_struct->N_sc_rb_dl, subframe->num, i))
-                            subframe->tx_symb[p][L][i*phy_struct->N_sc_rb_dl+j] = phy_struct->pdsch_y[p][idx++];
-                    }
-                }
-            }
-        }
+        dl_kernels[phy_struct->dl_kernels_idx].pdsch_map(phy_struct,
+                                                         &pdcch->dl_alloc[alloc_idx],
+                                                         pdcch->N_symbs,
+                                                         N_id_cell,
+                                                         N_ant,
+                                                         subframe);
     }
 
     return LIBLTE_SUCCESS;
@@ -7027,37 +8269,31 @@ LIBLTE_ERROR_ENUM liblte_phy_pdsch_channel_decode(LIBLTE_PHY_STRUCT            *
         return LIBLTE_ERROR_INVALID_INPUTS;
 
     // Extract resource elements and channel estimate 3GPP TS 36.211 v10.1.0 section 6.3.5
-    uint32 idx = 0;
-    for(uint32 L=N_pdcch_symbs; L<14; L++)
-    {
-        for(uint32 prb_idx=0; prb_idx<alloc->N_prb; prb_idx++)
-        {
-            uint32 i = alloc->prb[L/7][prb_idx];
-            for(uint32 j=0; j<phy_struct->N_sc_rb_dl; j++)
-            {
-                if(!is_this_RE_for_PDSCH(N_ant, L, N_id_cell, j, phy_struct->N_rb_dl,
-                                         phy_struct->N_sc_rb_dl, subframe->num, i))
-                    continue;
-                phy_struct->pdsch_y_est[idx] = subframe->rx_symb[L][i*phy_struct->N_sc_rb_dl+j];
-                for(uint32 p=0; p<N_ant; p++)
-                    phy_struct->pdsch_c_est[p][idx] = subframe->rx_ce[p][L][i*phy_struct->N_sc_rb_dl+j];
-                idx++;
-            }
-        }
-    }
+    uint32 idx = dl_kernels[phy_struct->dl_kernels_idx].pdsch_demap(phy_struct,
+                                                                    subframe,
+                                                                    alloc,
+                                                                    N_pdcch_symbs,
+                                                                    N_id_cell,
+                                                                    N_ant);
+    uint32 N_layers = N_ant;
+    if(LIBLTE_PHY_PRE_CODER_TYPE_SPATIAL_MULTIPLEXING == alloc->pre_coder_type)
+        N_layers = alloc->N_layers;
     uint32 M_layer_symb;
-    de_pre_coder_dl(phy_struct->pdsch_y_est,
-                    phy_struct->pdsch_c_est[0],
-                    5000,
-                    idx,
-                    N_ant,
-                    alloc->pre_coder_type,
-                    phy_struct->pdsch_x,
-                    &M_layer_symb);
+    if(LIBLTE_SUCCESS != de_pre_coder_dl(phy_struct->pdsch_y_est,
+                                         phy_struct->pdsch_c_est[0],
+                                         5000,
+                                         idx,
+                                         N_ant,
+                                         N_layers,
+                                         alloc->codebook_idx,
+                                         alloc->pre_coder_type,
+                                         phy_struct->pdsch_x,
+                                         &M_layer_symb))
+        return LIBLTE_ERROR_INVALID_INPUTS;
     uint32 M_symb;
     layer_demapper_dl(phy_struct->pdsch_x,
                       M_layer_symb,
-                      N_ant,
+                      N_layers,
                       alloc->N_codewords,
                       alloc->pre_coder_type,
                       phy_struct->pdsch_d,
@@ -7082,6 +8318,8 @@ LIBLTE_ERROR_ENUM liblte_phy_pdsch_channel_decode(LIBLTE_PHY_STRUCT            *
                                           phy_struct->N_rb_dl,
                                           N_ant,
                                           alloc->mod_type);
+    if(LIBLTE_PHY_PRE_CODER_TYPE_SPATIAL_MULTIPLEXING == alloc->pre_coder_type)
+        N_bits_tot *= N_layers;
     return dlsch_channel_decode(phy_struct,
                                 phy_struct->pdsch_descramb_bits,
                                 N_bits,
@@ -7153,6 +8391,8 @@ LIBLTE_ERROR_ENUM liblte_phy_bch_channel_encode(LIBLTE_PHY_STRUCT          *phy_
     pre_coder_dl(phy_struct->bch_x,
                  M_layer_symb,
                  N_ant,
+                 N_ant,
+                 0,
                  LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY,
                  phy_struct->bch_y[0],
                  240,
@@ -7241,6 +8481,8 @@ LIBLTE_ERROR_ENUM liblte_phy_bch_channel_decode(LIBLTE_PHY_STRUCT          *phy_
                         240,
                         240,
                         p,
+                        p,
+                        0,
                         LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY,
                         phy_struct->bch_x,
                         &M_layer_symb);
@@ -7299,10 +8541,22 @@ void dci_encode_and_map(LIBLTE_PHY_STRUCT            *phy_struct,
                         LIBLTE_PHY_CHAN_TYPE_ENUM     chan_type,
                         LIBLTE_PHY_ALLOCATION_STRUCT *alloc)
 {
-    // Encode the DCI
+    // Encode the DCI, allocations that are not contiguous need
+    // resource allocation type 0 and therefore format 1
     uint32 dci_size;
-    if(LIBLTE_PHY_CHAN_TYPE_DLSCH == chan_type)
+    bool   contiguous = true;
+    for(uint32 i=1; i<alloc->N_prb; i++)
+        if(alloc->prb[0][i] != alloc->prb[0][i-1] + 1)
+            contiguous = false;
+    if(LIBLTE_PHY_CHAN_TYPE_DLSCH == chan_type && !contiguous)
     {
+        dci_1_pack(alloc,
+                   LIBLTE_PHY_DCI_CA_NOT_PRESENT,
+                   phy_struct->N_rb_dl,
+                   N_ant,
+                   phy_struct->pdcch_dci,
+                   &dci_size);
+    }else if(LIBLTE_PHY_CHAN_TYPE_DLSCH == chan_type){
         dci_1a_pack(alloc,
                     LIBLTE_PHY_DCI_CA_NOT_PRESENT,
                     phy_struct->N_rb_dl,
@@ -7361,6 +8615,8 @@ void dci_encode_and_map(LIBLTE_PHY_STRUCT            *phy_struct,
                 pre_coder_dl(phy_struct->pdcch_x,
                              M_layer_symb,
                              N_ant,
+                             N_ant,
+                             0,
                              LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY,
                              phy_struct->pdcch_y[0],
                              576,
@@ -7890,6 +9146,8 @@ LIBLTE_ERROR_ENUM liblte_phy_pdcch_channel_decode(LIBLTE_PHY_STRUCT
                         576,
                         idx,
                         N_ant,
+                        N_ant,
+                        0,
                         LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY,
                         phy_struct->pdcch_x,
                         &M_layer_symb);
@@ -8018,6 +9276,8 @@ LIBLTE_ERROR_ENUM liblte_phy_pdcch_channel_decode(LIBLTE_PHY_STRUCT
                         576,
                         idx,
                         N_ant,
+                        N_ant,
+                        0,
                         LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY,
                         phy_struct->pdcch_x,
                         &M_layer_symb);
@@ -8158,40 +9418,11 @@ LIBLTE_ERROR_ENUM liblte_phy_map_crs(LIBLTE_PHY_STRUCT          *phy_struct,
         crs[11] = &phy_struct->crs[11][0];
     }
 
-    for(uint32 p=0; p<N_ant; p++)
-    {
-        uint32 *v;
-        uint32 *sym;
-        uint32  v_p0_2[4]   = {0, 3, 0, 3};
-        uint32  v_p1[4]     = {3, 0, 3, 0};
-        uint32  v_p3[2]     = {3, 6};
-        uint32  sym_p0_1[4] = {0, 4, 7, 11};
-        uint32  sym_p2_3[2] = {1, 8};
-        uint32  N_sym;
-        if(p == 0)
-        {
-            v     = v_p0_2;
-            sym   = sym_p0_1;
-            N_sym = 4;
-        }else if(p == 1){
-            v     = v_p1;
-            sym   = sym_p0_1;
-            N_sym = 4;
-        }else if(p == 2){
-            v     = v_p0_2;
-            sym   = sym_p2_3;
-            N_sym = 2;
-        }else{ // p == 3
-            v     = v_p3;
-            sym   = sym_p2_3;
-            N_sym = 2;
-        }
-        uint32 v_shift = N_id_cell % 6;
-        for(uint32 i=0; i<N_sym; i++)
-            for(uint32 j=0; j<2*phy_struct->N_rb_dl; j++)
-                subframe->tx_symb[p][sym[i]][6*j + (v[i] + v_shift)%6] =
-                    crs[sym[i]][j + LIBLTE_PHY_N_RB_DL_MAX - phy_struct->N_rb_dl];
-    }
+    dl_kernels[phy_struct->dl_kernels_idx].map_crs(phy_struct,
+                                                   crs,
+                                                   N_id_cell,
+                                                   N_ant,
+                                                   subframe);
 
     return LIBLTE_SUCCESS;
 }
@@ -8230,6 +9461,12 @@ LIBLTE_ERROR_ENUM liblte_phy_map_pss(LIBLTE_PHY_STRUCT          *phy_struct,
                  determines fine timing.
 
     Document Reference: 3GPP TS 36.211 v10.1.0 section 6.11.1
+
+    Notes: Only the central 64 subcarriers are correlated, all three
+           N_id_2 values and +/- one subcarrier offsets are tested in
+           the same pass.  Fine timing is found from a single FFT by
+           evaluating the correlation at each timing lag as a linear
+           phase across the PSS subcarriers.
 *********************************************************************/
 LIBLTE_ERROR_ENUM liblte_phy_find_pss_and_fine_timing(LIBLTE_PHY_STRUCT *phy_struct,
                                                       complex           *samps,
@@ -8243,23 +9480,14 @@ LIBLTE_ERROR_ENUM liblte_phy_find_pss_and_fine_timing(LIBLTE_PHY_STRUCT *phy_str
        pss_symb == NULL || pss_thresh == NULL || freq_offset == NULL)
         return LIBLTE_ERROR_INVALID_INPUTS;
 
+    uint32 N_sc_half = (phy_struct->N_rb_dl*phy_struct->N_sc_rb_dl)/2;
+
     // Generate PSS
     for(uint32 i=0; i<3; i++)
-    {
-        for(uint32 j=0; j<phy_struct->N_rb_dl*phy_struct->N_sc_rb_dl; j++)
-            phy_struct->pss_mod[i][j] = complex(0, 0);
-        complex pss[63];
-        generate_pss(i, pss);
-        for(uint32 j=0; j<62; j++)
-        {
-            uint32 k                       = j - 31 + (phy_struct->N_rb_dl*phy_struct->N_sc_rb_dl)/2;
-            phy_struct->pss_mod_n1[i][k-1] = pss[j];
-            phy_struct->pss_mod[i][k]      = pss[j];
-            phy_struct->pss_mod_p1[i][k+1] = pss[j];
-        }
-    }
+        generate_pss(i, phy_struct->pss_mod[i]);
 
-    // Demod symbols and correlate with PSS
+    // Demod symbols and correlate the central subcarriers with PSS,
+    // pss_bins[j+1+offset] holds PSS element j shifted by offset
     float corr_max = 0;
     int32 idx      = 0;
     for(uint32 i=0; i<12; i++)
@@ -8272,17 +9500,19 @@ LIBLTE_ERROR_ENUM liblte_phy_find_pss_and_fine_timing(LIBLTE_PHY_STRUCT *phy_str
                                   0,
                                   0,
                                   phy_struct->rx_symb);
+            for(uint32 z=0; z<64; z++)
+                phy_struct->pss_bins[z] = std::conj(phy_struct->rx_symb[N_sc_half-32+z]);
 
             for(uint32 k=0; k<3; k++)
             {
                 complex corr_n1 = complex(0, 0);
                 complex corr    = complex(0, 0);
                 complex corr_p1 = complex(0, 0);
-                for(uint32 z=0; z<phy_struct->N_rb_dl*phy_struct->N_sc_rb_dl; z++)
+                for(uint32 z=0; z<62; z++)
                 {
-                    corr_n1 += phy_struct->pss_mod_n1[k][z] * std::conj(phy_struct->rx_symb[z]);
-                    corr    += phy_struct->pss_mod[k][z] * std::conj(phy_struct->rx_symb[z]);
-                    corr_p1 += phy_struct->pss_mod_p1[k][z] * std::conj(phy_struct->rx_symb[z]);
+                    corr_n1 += phy_struct->pss_mod[k][z] * phy_struct->pss_bins[z];
+                    corr    += phy_struct->pss_mod[k][z] * phy_struct->pss_bins[z+1];
+                    corr_p1 += phy_struct->pss_mod[k][z] * phy_struct->pss_bins[z+2];
                 }
                 float abs_corr_n1 = std::abs(corr_n1);
                 float abs_corr    = std::abs(corr);
@@ -8311,46 +9541,50 @@ LIBLTE_ERROR_ENUM liblte_phy_find_pss_and_fine_timing(LIBLTE_PHY_STRUCT *phy_str
             }
         }
     }
-    complex *pss_mod;
     if(-1 == idx)
     {
-        pss_mod      = &phy_struct->pss_mod_n1[*N_id_2][0];
         *freq_offset = -(phy_struct->fs / phy_struct->FFT_size);
     }else if(0 == idx){
-        pss_mod      = &phy_struct->pss_mod[*N_id_2][0];
         *freq_offset = 0;
     }else{
-        pss_mod      = &phy_struct->pss_mod_p1[*N_id_2][0];
         *freq_offset = phy_struct->fs / phy_struct->FFT_size;
     }
 
-    // Find optimal timing
-    uint32 N_s    = (*pss_symb)/7;
-    uint32 N_symb = (*pss_symb)%7;
-    int8   timing = 0;
-    corr_max      = 0;
-    for(int32 i=-40; i<40; i++)
+    // Find optimal timing, delaying the FFT window by i samples rotates
+    // subcarrier f by 2*pi*f*i/N_fft
+    uint32 N_s      = (*pss_symb)/7;
+    uint32 N_symb   = (*pss_symb)%7;
+    uint32 base_idx = symb_starts[N_symb] + (phy_struct->N_samps_per_slot*N_s);
+    int32  first_i  = -40;
+    int8   timing   = 0;
+    if(base_idx < 40)
+        first_i = -(int32)base_idx;
+    samples_to_symbols_dl(phy_struct,
+                          samps,
+                          base_idx,
+                          0,
+                          0,
+                          phy_struct->rx_symb);
+    for(int32 i=first_i; i<40; i++)
+        phy_struct->pss_corr[i+40] = complex(0, 0);
+    for(uint32 j=0; j<62; j++)
     {
-        int32 idx = symb_starts[N_symb] + (phy_struct->N_samps_per_slot*N_s);
-        if(i < 0)
+        uint32  z    = j - 31 + N_sc_half + idx;
+        int32   f    = (z >= N_sc_half) ? (int32)(z - N_sc_half) + 1 : (int32)z - (int32)N_sc_half;
+        float   w    = -2*M_PI*f/phy_struct->N_samps_per_symb;
+        complex step = complex_polar(1, w);
+        complex rot  = complex_polar(1, w*first_i);
+        complex corr = phy_struct->pss_mod[*N_id_2][j] * std::conj(phy_struct->rx_symb[z]);
+        for(int32 i=first_i; i<40; i++)
         {
-            if(idx >= -i)
-                idx += i;
-        }else{
-            idx += i;
+            phy_struct->pss_corr[i+40] += corr * rot;
+            rot                        *= step;
         }
-
-        samples_to_symbols_dl(phy_struct,
-                              samps,
-                              idx,
-                              0,
-                              0,
-                              phy_struct->rx_symb);
-
-        complex corr = complex(0, 0);
-        for(uint32 j=0; j<phy_struct->N_rb_dl*phy_struct->N_sc_rb_dl; j++)
-            corr += pss_mod[j] * std::conj(phy_struct->rx_symb[j]);
-        float abs_corr = std::abs(corr);
+    }
+    corr_max = 0;
+    for(int32 i=first_i; i<40; i++)
+    {
+        float abs_corr = std::abs(phy_struct->pss_corr[i+40]);
         if(abs_corr > corr_max)
         {
             corr_max = abs_corr;
@@ -8360,7 +9594,7 @@ LIBLTE_ERROR_ENUM liblte_phy_find_pss_and_fine_timing(LIBLTE_PHY_STRUCT *phy_str
     *pss_thresh = corr_max;
 
     // Construct fine symbol start locations
-    uint32 pss_timing_idx = symb_starts[N_symb]+(phy_struct->N_samps_per_slot*N_s)+timing;
+    uint32 pss_timing_idx = base_idx+timing;
     while((pss_timing_idx + phy_struct->N_samps_per_symb + phy_struct->N_samps_cp_l_else) < phy_struct->N_samps_per_slot)
         pss_timing_idx += phy_struct->N_samps_per_frame;
     symb_starts[0] = pss_timing_idx + (phy_struct->N_samps_per_symb+phy_struct->N_samps_cp_l_else)*1 - phy_struct->N_samps_per_slot;
@@ -8393,22 +9627,22 @@ LIBLTE_ERROR_ENUM liblte_phy_map_sss(LIBLTE_PHY_STRUCT          *phy_struct,
     generate_sss(phy_struct,
                  N_id_1,
                  N_id_2,
-                 &phy_struct->sss_mod_0[0][0],
-                 &phy_struct->sss_mod_5[0][0]);
+                 phy_struct->sss_0,
+                 phy_struct->sss_5);
 
     if(subframe->num == 0)
     {
         for(uint32 p=0; p<N_ant; p++)
             for(uint32 i=0; i<62; i++)
                 subframe->tx_symb[p][5][i - 31 + (phy_struct->N_rb_dl*phy_struct->N_sc_rb_dl)/2] =
-                    phy_struct->sss_mod_0[0][i];
+                    phy_struct->sss_0[i];
         return LIBLTE_SUCCESS;
     }
 
     for(uint32 p=0; p<N_ant; p++)
         for(uint32 i=0; i<62; i++)
             subframe->tx_symb[p][5][i - 31 + (phy_struct->N_rb_dl*phy_struct->N_sc_rb_dl)/2] =
-                phy_struct->sss_mod_5[0][i];
+                phy_struct->sss_5[i];
     return LIBLTE_SUCCESS;
 }
 
@@ -8418,6 +9652,12 @@ LIBLTE_ERROR_ENUM liblte_phy_map_sss(LIBLTE_PHY_STRUCT          *phy_struct,
     Description: Searches for the Secondary Synchronization Signal.
 
     Document Reference: 3GPP TS 36.211 v10.1.0 section 6.11.2
+
+    Notes: The even subcarriers carry s_tilda shifted by m0 (subframe
+           0) or m1 (subframe 5) scrambled by c0, the odd subcarriers
+           carry the other shift scrambled by c1 and z1.  Each half is
+           descrambled and correlated against the 31 shifts of s_tilda
+           and the (m0, m1) pair is mapped back to N_id_1.
 *********************************************************************/
 LIBLTE_ERROR_ENUM liblte_phy_find_sss(LIBLTE_PHY_STRUCT *phy_struct,
                                       complex           *samps,
@@ -8431,65 +9671,96 @@ LIBLTE_ERROR_ENUM liblte_phy_find_sss(LIBLTE_PHY_STRUCT *phy_struct,
        frame_start_idx == NULL)
         return LIBLTE_ERROR_INVALID_INPUTS;
 
-    // Generate secondary synchronization signals
-    for(uint32 i=0; i<168; i++)
-        for(uint32 j=0; j<LIBLTE_PHY_N_RB_DL_20MHZ*LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP; j++)
-        {
-            phy_struct->sss_mod_0[i][j] = complex(0, 0);
-            phy_struct->sss_mod_5[i][j] = complex(0, 0);
-        }
+    uint32  N_sc_half = (phy_struct->N_rb_dl*phy_struct->N_sc_rb_dl)/2;
+    complex even[31];
+    complex odd[31];
+    float   corr_max;
+    uint32  m_even = 0;
+    uint32  m_odd  = 0;
+
+    // Generate s_tilda, c0, c1 and z_tilda and the (m0, m1) to N_id_1 map
+    generate_sss(phy_struct,
+                 0,
+                 N_id_2,
+                 phy_struct->sss_0,
+                 phy_struct->sss_5);
+    for(uint32 i=0; i<31; i++)
+        for(uint32 j=0; j<31; j++)
+            phy_struct->sss_n_id_1[i][j] = -1;
     for(uint32 i=0; i<168; i++)
     {
-        generate_sss(phy_struct,
-                     i,
-                     N_id_2,
-                     phy_struct->sss_0,
-                     phy_struct->sss_5);
-        for(uint32 j=0; j<62; j++)
-        {
-            uint32 k                    = j - 31 + (phy_struct->N_rb_dl*phy_struct->N_sc_rb_dl)/2;
-            phy_struct->sss_mod_0[i][k] = phy_struct->sss_0[j];
-            phy_struct->sss_mod_5[i][k] = phy_struct->sss_5[j];
-        }
+        uint32 q_prime = i/30;
+        uint32 q       = (i + (q_prime*(q_prime+1)/2))/30;
+        uint32 m_prime = i + (q*(q+1)/2);
+        uint32 m0      = m_prime % 31;
+        uint32 m1      = (m0 + (m_prime/31) + 1) % 31;
+        phy_struct->sss_n_id_1[m0][m1] = i;
     }
     float sss_thresh = pss_thresh * 0.9;
 
-    // Demod symbol and search for secondary synchronization signals
+    // Demod symbol and descramble the even subcarriers
     samples_to_symbols_dl(phy_struct,
                           samps,
                           symb_starts[5],
                           0,
                           0,
                           phy_struct->rx_symb);
-    for(uint32 i=0; i<168; i++)
+    for(uint32 i=0; i<31; i++)
+    {
+        even[i] = std::conj(phy_struct->rx_symb[N_sc_half - 31 + 2*i]) * (float)phy_struct->sss_c0[i];
+        odd[i]  = std::conj(phy_struct->rx_symb[N_sc_half - 31 + 2*i + 1]) * (float)phy_struct->sss_c1[i];
+    }
+
+    // Find the even shift, then the odd shift once z1 is known
+    corr_max = 0;
+    for(uint32 m=0; m<31; m++)
     {
         complex corr = complex(0, 0);
-        for(uint32 j=0; j<(phy_struct->N_rb_dl*phy_struct->N_sc_rb_dl); j++)
-            corr += phy_struct->sss_mod_0[i][j] * std::conj(phy_struct->rx_symb[j]);
-        float abs_corr = std::abs(corr);
-        if(abs_corr > sss_thresh)
-        {
-            while(symb_starts[5] < ((phy_struct->N_samps_per_symb + phy_struct->N_samps_cp_l_else)*4 + phy_struct->N_samps_per_symb + phy_struct->N_samps_cp_l_0))
-                symb_starts[5] += phy_struct->N_samps_per_frame;
-            *N_id_1          = i;
-            *frame_start_idx = symb_starts[5] - ((phy_struct->N_samps_per_symb + phy_struct->N_samps_cp_l_else)*4 + phy_struct->N_samps_per_symb + phy_struct->N_samps_cp_l_0);
-            return LIBLTE_SUCCESS;
+        for(uint32 i=0; i<31; i++)
+            corr += even[i] * (float)phy_struct->sss_s_tilda[(i + m) % 31];
+        if(std::abs(corr) > corr_max)
+        {
+            corr_max = std::abs(corr);
+            m_even   = m;
         }
-
-        corr = complex(0, 0);
-        for(uint32 j=0; j<(phy_struct->N_rb_dl*phy_struct->N_sc_rb_dl); j++)
-            corr += phy_struct->sss_mod_5[i][j] * std::conj(phy_struct->rx_symb[j]);
-        abs_corr = std::abs(corr);
-        if(abs_corr > sss_thresh)
+    }
+    for(uint32 i=0; i<31; i++)
+        odd[i] *= (float)phy_struct->sss_z_tilda[(i + (m_even % 8)) % 31];
+    corr_max = 0;
+    for(uint32 m=0; m<31; m++)
+    {
+        complex corr = complex(0, 0);
+        for(uint32 i=0; i<31; i++)
+            corr += odd[i] * (float)phy_struct->sss_s_tilda[(i + m) % 31];
+        if(std::abs(corr) > corr_max)
         {
-            while(symb_starts[5] < (((phy_struct->N_samps_per_symb + phy_struct->N_samps_cp_l_else)*4 + phy_struct->N_samps_per_symb + phy_struct->N_samps_cp_l_0) + phy_struct->N_samps_per_slot*10))
-                symb_starts[5] += phy_struct->N_samps_per_frame;
-            *N_id_1          = i;
-            *frame_start_idx = symb_starts[5] - ((phy_struct->N_samps_per_symb + phy_struct->N_samps_cp_l_else)*4 + phy_struct->N_samps_per_symb + phy_struct->N_samps_cp_l_0) - phy_struct->N_samps_per_slot*10;
-            return LIBLTE_SUCCESS;
+            corr_max = std::abs(corr);
+            m_odd    = m;
         }
     }
 
+    // Subframe 0 carries m0 on the even subcarriers, subframe 5 carries m1
+    uint32 sss_offset = (phy_struct->N_samps_per_symb + phy_struct->N_samps_cp_l_else)*4 + phy_struct->N_samps_per_symb + phy_struct->N_samps_cp_l_0;
+    int16  n_id_1     = phy_struct->sss_n_id_1[m_even][m_odd];
+    if(-1 == n_id_1)
+    {
+        n_id_1      = phy_struct->sss_n_id_1[m_odd][m_even];
+        sss_offset += phy_struct->N_samps_per_slot*10;
+    }
+    complex corr = complex(0, 0);
+    for(uint32 i=0; i<31; i++)
+        corr += (even[i] * (float)phy_struct->sss_s_tilda[(i + m_even) % 31] +
+                 odd[i] * (float)phy_struct->sss_s_tilda[(i + m_odd) % 31]);
+    if(-1 != n_id_1 &&
+       std::abs(corr) > sss_thresh)
+    {
+        while(symb_starts[5] < sss_offset)
+            symb_starts[5] += phy_struct->N_samps_per_frame;
+        *N_id_1          = n_id_1;
+        *frame_start_idx = symb_starts[5] - sss_offset;
+        return LIBLTE_SUCCESS;
+    }
+
     return LIBLTE_ERROR_INVALID_INPUTS;
 }
 
@@ -8661,6 +9932,13 @@ LIBLTE_ERROR_ENUM liblte_phy_create_dl_subframe(LIBLTE_PHY_STRUCT          *phy_
                  particular downlink subframe
 
     Document Reference: 3GPP TS 36.211 v10.1.0
+
+    Notes: subframe caches which generation of samples it was
+           resolved from, which OFDM symbols have been demodulated,
+           and which regions the channel estimates cover, so repeated
+           calls for the same subframe only do the work that is
+           missing.  The first version always starts from an empty
+           cache.
 *********************************************************************/
 LIBLTE_ERROR_ENUM liblte_phy_get_dl_subframe_and_ce(LIBLTE_PHY_STRUCT          *phy_struct,
                                                     complex                    *samps,
@@ -8669,229 +9947,141 @@ LIBLTE_ERROR_ENUM liblte_phy_get_dl_subframe_and_ce(LIBLTE_PHY_STRUCT          *
                                                     uint32                      N_id_cell,
                                                     uint8                       N_ant,
                                                     LIBLTE_PHY_SUBFRAME_STRUCT *subframe)
+{
+    if(phy_struct == NULL || subframe == NULL)
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    // Callers don't track sample generations, never trust the cache
+    subframe->rx_valid = false;
+
+    return liblte_phy_get_dl_subframe_and_ce(phy_struct,
+                                             samps,
+                                             0,
+                                             frame_start_idx,
+                                             subfr_num,
+                                             N_id_cell,
+                                             N_ant,
+                                             0,
+                                             phy_struct->N_rb_dl,
+                                             0,
+                                             14,
+                                             subframe);
+}
+LIBLTE_ERROR_ENUM liblte_phy_get_dl_subframe_and_ce(LIBLTE_PHY_STRUCT          *phy_struct,
+                                                    complex                    *samps,
+                                                    uint32                      samps_gen,
+                                                    uint32                      frame_start_idx,
+                                                    uint8                       subfr_num,
+                                                    uint32                      N_id_cell,
+                                                    uint8                       N_ant,
+                                                    uint32                      first_prb,
+                                                    uint32                      N_prb,
+                                                    uint32                      first_symb,
+                                                    uint32                      N_symbs,
+                                                    LIBLTE_PHY_SUBFRAME_STRUCT *subframe)
 {
     if(phy_struct == NULL || samps == NULL || subframe == NULL)
         return LIBLTE_ERROR_INVALID_INPUTS;
     if(N_ant != 1 && N_ant != 2 && N_ant != 4)
         return LIBLTE_ERROR_INVALID_INPUTS;
+    if(N_prb == 0 || (first_prb + N_prb) > phy_struct->N_rb_dl ||
+       N_symbs == 0 || (first_symb + N_symbs) > 14)
+        return LIBLTE_ERROR_INVALID_INPUTS;
 
-    subframe->num = subfr_num;
     uint32 subfr_start_idx = frame_start_idx + subfr_num*phy_struct->N_samps_per_subfr;
-    // Demodulate symbols
-    for(uint32 i=0; i<16; i++)
-        samples_to_symbols_dl(phy_struct,
-                              samps,
-                              subfr_start_idx + (i/7)*phy_struct->N_samps_per_slot,
-                              i%7,
-                              0,
-                              &subframe->rx_symb[i][0]);
-
-    // Generate cell specific reference signals
-    generate_crs((subfr_num*2+0)%20, 0, N_id_cell, phy_struct->N_sc_rb_dl, phy_struct->dl_ce_crs[0]);
-    generate_crs((subfr_num*2+0)%20, 1, N_id_cell, phy_struct->N_sc_rb_dl, phy_struct->dl_ce_crs[1]);
-    generate_crs((subfr_num*2+0)%20, 4, N_id_cell, phy_struct->N_sc_rb_dl, phy_struct->dl_ce_crs[4]);
-    generate_crs((subfr_num*2+1)%20, 0, N_id_cell, phy_struct->N_sc_rb_dl, phy_struct->dl_ce_crs[7]);
-    generate_crs((subfr_num*2+1)%20, 1, N_id_cell, phy_struct->N_sc_rb_dl, phy_struct->dl_ce_crs[8]);
-    generate_crs((subfr_num*2+1)%20, 4, N_id_cell, phy_struct->N_sc_rb_dl, phy_struct->dl_ce_crs[11]);
-    generate_crs((subfr_num*2+2)%20, 0, N_id_cell, phy_struct->N_sc_rb_dl, phy_struct->dl_ce_crs[14]);
-    generate_crs((subfr_num*2+2)%20, 1, N_id_cell, phy_struct->N_sc_rb_dl, phy_struct->dl_ce_crs[15]);
-
-    // Determine channel estimates
-    for(uint32 p=0; p<N_ant; p++)
-    {
-        // Define v, sym, and N_sym
-        uint32 *v;
-        uint32 *sym;
-        uint32  N_sym;
-        uint32  v_p0[5]      = {0, 3, 0, 3, 0};
-        uint32  v_p1[5]      = {3, 0, 3, 0, 3};
-        uint32  v_p2[3]      = {0, 3, 0};
-        uint32  v_p3[3]      = {3, 6, 3};
-        uint32  sym_p0_p1[5] = {0, 4, 7, 11, 14};
-        uint32  sym_p2_p3[3] = {1, 8, 15};
-        if(p == 0)
-        {
-            v     = v_p0;
-            sym   = sym_p0_p1;
-            N_sym = 5;
-        }else if(p == 1){
-            v     = v_p1;
-            sym   = sym_p0_p1;
-            N_sym = 5;
-        }else if(p == 2){
-            v     = v_p2;
-            sym   = sym_p2_p3;
-            N_sym = 3;
-        }else{ // p == 3
-            v     = v_p3;
-            sym   = sym_p2_p3;
-            N_sym = 3;
-        }
-
-        float  frac_mag = 0;
-        float  frac_ang = 0;
-        uint32 v_shift  = N_id_cell % 6;
-        for(uint32 i=0; i<N_sym; i++)
-        {
-            complex *sym_c = &subframe->rx_symb[sym[i]][0];
-            complex *rs    = &phy_struct->dl_ce_crs[sym[i]][0];
-            uint32   k     = 0;
-
-            for(uint32 j=0; j<2*phy_struct->N_rb_dl; j++)
-            {
-                k                           = 6*j + (v[i] + v_shift)%6;
-                uint32  m_prime             = j + LIBLTE_PHY_N_RB_DL_MAX - phy_struct->N_rb_dl;
-                complex tmp                 = sym_c[k] / rs[m_prime];
-                phy_struct->dl_ce_mag[i][k] = std::abs(tmp);
-                phy_struct->dl_ce_ang[i][k] = std::arg(tmp);
-
-                // Unwrap phase
-                if(j > 0)
-                {
-                    wrap_phase(&phy_struct->dl_ce_ang[i][k], phy_struct->dl_ce_ang[i][k-6]);
-
-                    // Linearly interpolate between CRSs
-                    frac_mag = (phy_struct->dl_ce_mag[i][k] - phy_struct->dl_ce_mag[i][k-6])/6;
-                    frac_ang = (phy_struct->dl_ce_ang[i][k] - phy_struct->dl_ce_ang[i][k-6])/6;
-                    for(uint32 z=1; z<6; z++)
-                    {
-                        phy_struct->dl_ce_mag[i][k-z] = phy_struct->dl_ce_mag[i][k-(z-1)] - frac_mag;
-                        phy_struct->dl_ce_ang[i][k-z] = phy_struct->dl_ce_ang[i][k-(z-1)] - frac_ang;
-                    }
-                }
-
-                // Linearly interpolate before 1st CRS
-                if(j == 1)
-                {
-                    for(uint32 z=1; z<((v[i] + v_shift)%6)+1; z++)
-                    {
-                        phy_struct->dl_ce_mag[i][k-6-z] = phy_struct->dl_ce_mag[i][k-6-(z-1)] - frac_mag;
-                        phy_struct->dl_ce_ang[i][k-6-z] = phy_struct->dl_ce_ang[i][k-6-(z-1)] - frac_ang;
-                    }
-                }
-            }
-
-            // Linearly interpolate after last CRS
-            for(uint32 z=1; z<(5-(v[i] + v_shift)%6)+1; z++)
+    uint32 last_symb       = first_symb + N_symbs - 1;
+
+    // Check if subframe was already resolved from this generation of samples
+    if(!subframe->rx_valid                           ||
+       subframe->num          != subfr_num           ||
+       subframe->rx_samps_gen != samps_gen           ||
+       subframe->rx_start_idx != subfr_start_idx     ||
+       subframe->rx_N_id_cell != N_id_cell           ||
+       subframe->rx_N_rb_dl   != phy_struct->N_rb_dl)
+    {
+        subframe->num           = subfr_num;
+        subframe->rx_samps_gen  = samps_gen;
+        subframe->rx_start_idx  = subfr_start_idx;
+        subframe->rx_N_id_cell  = N_id_cell;
+        subframe->rx_N_rb_dl    = phy_struct->N_rb_dl;
+        subframe->rx_symb_mask     = 0;
+        subframe->rx_N_ce_regions  = 0;
+        subframe->rx_ce_region_idx = 0;
+        subframe->rx_valid         = true;
+    }else{
+        // Estimating a region only writes its own PRBs, so every
+        // remembered region still holds a valid estimate
+        for(uint32 i=0; i<subframe->rx_N_ce_regions; i++)
+        {
+            LIBLTE_PHY_CE_REGION_STRUCT *region = &subframe->rx_ce_region[i];
+            if(region->N_ant >= N_ant                                        &&
+               region->first_prb <= first_prb                                &&
+               (region->first_prb + region->N_prb) >= (first_prb + N_prb)    &&
+               region->first_symb <= first_symb                              &&
+               (region->first_symb + region->N_symbs) >= (first_symb + N_symbs))
             {
-                phy_struct->dl_ce_mag[i][k+z] = phy_struct->dl_ce_mag[i][k+(z-1)] + frac_mag;
-                phy_struct->dl_ce_ang[i][k+z] = phy_struct->dl_ce_ang[i][k+(z-1)] + frac_ang;
+                // Already resolved
+                return LIBLTE_SUCCESS;
             }
         }
+    }
 
-        // Linearly interpolate between symbols to construct all channel estimates
-        float ce_mag;
-        float ce_ang;
-        if(N_sym == 3)
-        {
-            for(uint32 j=0; j<phy_struct->N_rb_dl*phy_struct->N_sc_rb_dl; j++)
-            {
-                // Construct symbol 1 and 8 channel estimates directly
-                subframe->rx_ce[p][1][j] = complex_polar(phy_struct->dl_ce_mag[0][j], phy_struct->dl_ce_ang[0][j]);
-                subframe->rx_ce[p][8][j] = complex_polar(phy_struct->dl_ce_mag[1][j], phy_struct->dl_ce_ang[1][j]);
-
-                // Interpolate for symbol 2, 3, 4, 5, 6, and 7 channel estimates
-                frac_mag = (phy_struct->dl_ce_mag[1][j] - phy_struct->dl_ce_mag[0][j])/7;
-                wrap_phase(&phy_struct->dl_ce_ang[1][j], phy_struct->dl_ce_ang[0][j]);
-                frac_ang = (phy_struct->dl_ce_ang[1][j] - phy_struct->dl_ce_ang[0][j]);
-                wrap_phase(&frac_ang, 0);
-                frac_ang /= 7;
-                ce_mag    = phy_struct->dl_ce_mag[1][j];
-                ce_ang    = phy_struct->dl_ce_ang[1][j];
-                for(uint32 z=7; z>1; z--)
-                {
-                    ce_mag                   -= frac_mag;
-                    ce_ang                   -= frac_ang;
-                    subframe->rx_ce[p][z][j]  = complex_polar(ce_mag, ce_ang);
-                }
-
-                // Interpolate for symbol 0 channel estimate
-                // FIXME: Use previous slot to do this correctly
-                ce_mag                   = phy_struct->dl_ce_mag[0][j] - frac_mag;
-                ce_ang                   = phy_struct->dl_ce_ang[0][j] - frac_ang;
-                subframe->rx_ce[p][0][j] = complex_polar(ce_mag, ce_ang);
-
-                // Interpolate for symbol 9, 10, 11, 12, and 13 channel estimates
-                frac_mag = (phy_struct->dl_ce_mag[2][j] - phy_struct->dl_ce_mag[1][j])/7;
-                wrap_phase(&phy_struct->dl_ce_ang[2][j], phy_struct->dl_ce_ang[1][j]);
-                frac_ang = (phy_struct->dl_ce_ang[2][j] - phy_struct->dl_ce_ang[1][j]);
-                wrap_phase(&frac_ang, 0);
-                frac_ang /= 7;
-                ce_mag    = phy_struct->dl_ce_mag[2][j] - frac_mag;
-                ce_ang    = phy_struct->dl_ce_ang[2][j] - frac_ang;
-                for(uint32 z=13; z>8; z--)
-                {
-                    ce_mag                   -= frac_mag;
-                    ce_ang                   -= frac_ang;
-                    subframe->rx_ce[p][z][j]  = complex_polar(ce_mag, ce_ang);
-                }
-            }
-        }else{
-            for(uint32 j=0; j<phy_struct->N_rb_dl*phy_struct->N_sc_rb_dl; j++)
-            {
-                // Construct symbol 0, 4, 7, and 11 channel estimates directly
-                subframe->rx_ce[p][0][j]  = complex_polar(phy_struct->dl_ce_mag[0][j], phy_struct->dl_ce_ang[0][j]);
-                subframe->rx_ce[p][4][j]  = complex_polar(phy_struct->dl_ce_mag[1][j], phy_struct->dl_ce_ang[1][j]);
-                subframe->rx_ce[p][7][j]  = complex_polar(phy_struct->dl_ce_mag[2][j], phy_struct->dl_ce_ang[2][j]);
-                subframe->rx_ce[p][11][j] = complex_polar(phy_struct->dl_ce_mag[3][j], phy_struct->dl_ce_ang[3][j]);
-
-                // Interpolate for symbol 1, 2, and 3 channel estimates
-                frac_mag = (phy_struct->dl_ce_mag[1][j] - phy_struct->dl_ce_mag[0][j])/4;
-                wrap_phase(&phy_struct->dl_ce_ang[1][j], phy_struct->dl_ce_ang[0][j]);
-                frac_ang = (phy_struct->dl_ce_ang[1][j] - phy_struct->dl_ce_ang[0][j]);
-                wrap_phase(&frac_ang, 0);
-                frac_ang /= 4;
-                ce_mag    = phy_struct->dl_ce_mag[1][j];
-                ce_ang    = phy_struct->dl_ce_ang[1][j];
-                for(uint32 z=3; z>0; z--)
-                {
-                    ce_mag                   -= frac_mag;
-                    ce_ang                   -= frac_ang;
-                    subframe->rx_ce[p][z][j]  = complex_polar(ce_mag, ce_ang);
-                }
+    // Determine which OFDM symbols are needed
+    uint32 crs_symb[LIBLTE_PHY_N_ANT_MAX][5] = {{0, 4, 7, 11, 14},
+                                                {0, 4, 7, 11, 14},
+                                                {1, 8, 15,  0,  0},
+                                                {1, 8, 15,  0,  0}};
+    uint32 crs_symb_mask = 0;
+    uint32 symb_mask     = 0;
+    for(uint32 p=0; p<N_ant; p++)
+    {
+        uint32 crs_mask = get_dl_ce_crs_mask(p, first_symb, last_symb);
+        for(uint32 i=0; i<5; i++)
+            if((crs_mask & (1 << i)) != 0)
+                crs_symb_mask |= 1 << crs_symb[p][i];
+    }
+    for(uint32 i=first_symb; i<=last_symb; i++)
+        symb_mask |= 1 << i;
+    symb_mask |= crs_symb_mask;
 
-                // Interpolate for symbol 5 and 6 channel estimates
-                frac_mag = (phy_struct->dl_ce_mag[2][j] - phy_struct->dl_ce_mag[1][j])/3;
-                wrap_phase(&phy_struct->dl_ce_ang[2][j], phy_struct->dl_ce_ang[1][j]);
-                frac_ang = (phy_struct->dl_ce_ang[2][j] - phy_struct->dl_ce_ang[1][j]);
-                wrap_phase(&frac_ang, 0);
-                frac_ang /= 3;
-                ce_mag    = phy_struct->dl_ce_mag[2][j];
-                ce_ang    = phy_struct->dl_ce_ang[2][j];
-                for(uint32 z=6; z>4; z--)
-                {
-                    ce_mag                   -= frac_mag;
-                    ce_ang                   -= frac_ang;
-                    subframe->rx_ce[p][z][j]  = complex_polar(ce_mag, ce_ang);
-                }
+    // Demodulate symbols
+    for(uint32 i=0; i<16; i++)
+    {
+        if((symb_mask & ~subframe->rx_symb_mask & (1 << i)) != 0)
+            samples_to_symbols_dl(phy_struct,
+                                  samps,
+                                  subfr_start_idx + (i/7)*phy_struct->N_samps_per_slot,
+                                  i%7,
+                                  0,
+                                  &subframe->rx_symb[i][0]);
+    }
+    subframe->rx_symb_mask |= symb_mask;
 
-                // Interpolate for symbol 8, 9, and 10 channel estimates
-                frac_mag = (phy_struct->dl_ce_mag[3][j] - phy_struct->dl_ce_mag[2][j])/4;
-                wrap_phase(&phy_struct->dl_ce_ang[3][j], phy_struct->dl_ce_ang[2][j]);
-                frac_ang = (phy_struct->dl_ce_ang[3][j] - phy_struct->dl_ce_ang[2][j]);
-                wrap_phase(&frac_ang, 0);
-                frac_ang /= 4;
-                ce_mag    = phy_struct->dl_ce_mag[3][j];
-                ce_ang    = phy_struct->dl_ce_ang[3][j];
-                for(uint32 z=10; z>7; z--)
-                {
-                    ce_mag                   -= frac_mag;
-                    ce_ang                   -= frac_ang;
-                    subframe->rx_ce[p][z][j]  = complex_polar(ce_mag, ce_ang);
-                }
+    // Generate cell specific reference signals
+    for(uint32 i=0; i<16; i++)
+        if((crs_symb_mask & (1 << i)) != 0)
+            generate_crs((subfr_num*2+(i/7))%20, i%7, N_id_cell, phy_struct->N_sc_rb_dl, phy_struct->dl_ce_crs[i]);
 
-                // Linearly interpolate for symbol 12 and 13 channel estimates
-                ce_mag = phy_struct->dl_ce_mag[3][j];
-                ce_ang = phy_struct->dl_ce_ang[3][j];
-                for(uint32 z=12; z<14; z++)
-                {
-                    ce_mag                   += frac_mag;
-                    ce_ang                   += frac_ang;
-                    subframe->rx_ce[p][z][j]  = complex_polar(ce_mag, ce_ang);
-                }
-            }
-        }
-    }
+    // Determine channel estimates
+    dl_kernels[phy_struct->dl_kernels_idx].dl_ce(phy_struct,
+                                                 N_id_cell,
+                                                 N_ant,
+                                                 first_prb,
+                                                 N_prb,
+                                                 first_symb,
+                                                 N_symbs,
+                                                 subframe);
+
+    // Remember the region, replacing the oldest one when full
+    LIBLTE_PHY_CE_REGION_STRUCT *region = &subframe->rx_ce_region[subframe->rx_ce_region_idx];
+    region->first_prb          = first_prb;
+    region->N_prb              = N_prb;
+    region->first_symb         = first_symb;
+    region->N_symbs            = N_symbs;
+    region->N_ant              = N_ant;
+    subframe->rx_ce_region_idx = (subframe->rx_ce_region_idx + 1) % LIBLTE_PHY_N_RX_CE_REGIONS;
+    if(subframe->rx_N_ce_regions < LIBLTE_PHY_N_RX_CE_REGIONS)
+        subframe->rx_N_ce_regions++;
 
     return LIBLTE_SUCCESS;
 }
@@ -9044,7 +10234,8 @@ LIBLTE_ERROR_ENUM liblte_phy_get_tbs_mcs_and_n_prb_for_dl(uint32  N_bits,
     Description: Determines the transport block size and the number of
                  PRBs needed to send the specified number of DL bits
                  according to the specified modulation and coding
-                 scheme
+                 scheme, or the largest transport block that fits in
+                 N_rb_dl PRBs if the bits do not fit
 
     Document Reference: 3GPP TS 36.213 v10.3.0 section 7.1.7
 
@@ -9056,7 +10247,7 @@ LIBLTE_ERROR_ENUM liblte_phy_get_tbs_and_n_prb_for_dl(uint32  N_bits,
                                                       uint32 *tbs,
                                                       uint32 *N_prb)
 {
-    if(tbs == NULL || N_prb == NULL || mcs > 28)
+    if(tbs == NULL || N_prb == NULL || mcs > 28 || N_rb_dl == 0 || N_rb_dl > 110)
         return LIBLTE_ERROR_INVALID_INPUTS;
 
     // Determine I_tbs
@@ -9068,8 +10259,10 @@ LIBLTE_ERROR_ENUM liblte_phy_get_tbs_and_n_prb_for_dl(uint32  N_bits,
         {
             *tbs   = TBS_71721[I_tbs][i];
             *N_prb = i + 1;
-            break;
+            return LIBLTE_SUCCESS;
         }
+    *tbs   = TBS_71721[I_tbs][N_rb_dl-1];
+    *N_prb = N_rb_dl;
 
     return LIBLTE_SUCCESS;
 }
@@ -9133,10 +10326,17 @@ LIBLTE_ERROR_ENUM liblte_phy_get_tbs_mcs_and_n_prb_for_ul(uint32  N_bits,
     Description: Determines the transport block size and the number of
                  PRBs needed to send the specified number of UL bits
                  according to the specified modulation and coding
-                 scheme
+                 scheme, or the largest allocation within N_rb_ul
+                 PRBs if the bits do not fit
 
-    Document Reference: 3GPP TS 36.213 v10.3.0 section 7.1.7
+    Document Reference: 3GPP TS 36.213 v10.3.0 sections 7.1.7 and 8.6
+                        3GPP TS 36.211 v10.1.0 section 5.3.3
 *********************************************************************/
+// Defines
+#define ULSCH_MAX_TBS 30576 // Largest TBS that fits in the 5 code blocks of LIBLTE_PHY_STRUCT
+// Enums
+// Structs
+// Functions
 LIBLTE_ERROR_ENUM liblte_phy_get_tbs_and_n_prb_for_ul(uint32  N_bits,
                                                       uint32  N_rb_ul,
                                                       uint8   mcs,
@@ -9146,21 +10346,35 @@ LIBLTE_ERROR_ENUM liblte_phy_get_tbs_and_n_prb_for_ul(uint32  N_bits,
     if(tbs == NULL || N_prb == NULL)
         return LIBLTE_ERROR_INVALID_INPUTS;
 
+    if(mcs > 28 || N_rb_ul == 0 || N_rb_ul > LIBLTE_PHY_N_RB_UL_MAX)
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
     // Determine I_tbs
-    uint32 I_tbs = get_I_tbs_from_mcs(mcs);
+    uint32 I_tbs = get_I_tbs_from_ul_mcs(mcs);
 
-    // Determine N_prb
+    // Determine N_prb, which must be 2^a * 3^b * 5^c for the transform precoder
     for(uint32 i=0; i<N_rb_ul; i++)
+    {
+        if(TBS_71721[I_tbs][i] > ULSCH_MAX_TBS)
+            break;
+
+        uint32 n = i + 1;
+        while((n % 2) == 0)
+            n /= 2;
+        while((n % 3) == 0)
+            n /= 3;
+        while((n % 5) == 0)
+            n /= 5;
+        if(1 != n)
+            continue;
+
+        *tbs   = TBS_71721[I_tbs][i];
+        *N_prb = i + 1;
         if(N_bits <= TBS_71721[I_tbs][i])
-            if(((i + 1) % 2) == 0 ||
-               ((i + 1) % 3) == 0 ||
-               ((i + 1) % 5) == 0)
-            {
-                *tbs   = TBS_71721[I_tbs][i];
-                *N_prb = i + 1;
-                return LIBLTE_SUCCESS;
-            }
-    return LIBLTE_ERROR_INVALID_INPUTS;
+            break;
+    }
+
+    return LIBLTE_SUCCESS;
 }
 
 /*********************************************************************
@@ -9192,6 +10406,19 @@ LIBLTE_ERROR_ENUM liblte_phy_get_n_cce(LIBLTE_PHY_STRUCT *phy_struct,
     return LIBLTE_SUCCESS;
 }
 
+/*********************************************************************
+    Name: liblte_phy_get_rbg_size
+
+    Description: Determines the resource block group size used by
+                 downlink resource allocation type 0
+
+    Document Reference: 3GPP TS 36.213 v10.3.0 section 7.1.6.1
+*********************************************************************/
+uint32 liblte_phy_get_rbg_size(uint32 N_rb_dl)
+{
+    return get_rbg_size(N_rb_dl);
+}
+
 /*********************************************************************
     Name: liblte_phy_add_to_tti
 
@@ -9260,6 +10487,210 @@ bool liblte_phy_is_tti_in_past(uint32 tti_to_check,
     return false;
 }
 
+/*********************************************************************
+    Name: liblte_phy_fc32_to_sc16
+
+    Description: Converts complex float samples to interleaved int16
+                 I/Q, scaling, rounding and saturating each component.
+                 Uses SSE2/AVX2 when the CPU supports them.
+
+    Document Reference: N/A
+*********************************************************************/
+// Saturation limits, applied in float since out of range conversions
+// all return INT32_MIN
+#define SC16_MAX 32767.0f
+#define SC16_MIN -32768.0f
+#if LIBLTE_PHY_HAVE_SIMD
+__attribute__((target("avx2")))
+static uint32 fc32_to_sc16_avx2(const float *in,
+                                float        scale,
+                                uint32       N_floats,
+                                int16       *out)
+{
+    __m256 s   = _mm256_set1_ps(scale);
+    __m256 max = _mm256_set1_ps(SC16_MAX);
+    __m256 min = _mm256_set1_ps(SC16_MIN);
+    uint32 i;
+
+    for(i=0; i+16<=N_floats; i+=16)
+    {
+        __m256  a = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(&in[i]), s), min), max);
+        __m256  b = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(&in[i+8]), s), min), max);
+        __m256i p = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+        // packs works per 128 bit lane, put the quadwords back in order
+        _mm256_storeu_si256((__m256i *)&out[i], _mm256_permute4x64_epi64(p, 0xD8));
+    }
+    return i;
+}
+static uint32 fc32_to_sc16_sse2(const float *in,
+                                float        scale,
+                                uint32       N_floats,
+                                int16       *out)
+{
+    __m128 s   = _mm_set1_ps(scale);
+    __m128 max = _mm_set1_ps(SC16_MAX);
+    __m128 min = _mm_set1_ps(SC16_MIN);
+    uint32 i;
+
+    for(i=0; i+8<=N_floats; i+=8)
+    {
+        __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&in[i]), s), min), max);
+        __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&in[i+4]), s), min), max);
+        _mm_storeu_si128((__m128i *)&out[i], _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+    }
+    return i;
+}
+#endif
+void liblte_phy_fc32_to_sc16(const complex *in,
+                             float          scale,
+                             uint32         N_samps,
+                             int16         *out)
+{
+    const float *in_f     = (const float *)in;
+    uint32       N_floats = N_samps*2;
+    uint32       i        = 0;
+
+#if LIBLTE_PHY_HAVE_SIMD
+    if(avx2_supported())
+        i = fc32_to_sc16_avx2(in_f, scale, N_floats, out);
+    else
+        i = fc32_to_sc16_sse2(in_f, scale, N_floats, out);
+#endif
+    for(; i<N_floats; i++)
+    {
+        float x = in_f[i]*scale;
+        if(x > SC16_MAX)
+            x = SC16_MAX;
+        if(x < SC16_MIN)
+            x = SC16_MIN;
+        out[i] = (int16)lrintf(x);
+    }
+}
+
+/*********************************************************************
+    Name: liblte_phy_sc16_to_fc32
+
+    Description: Converts interleaved int16 I/Q samples to complex
+                 float, scaling each component.  Uses SSE2/AVX2 when
+                 the CPU supports them.
+
+    Document Reference: N/A
+*********************************************************************/
+#if LIBLTE_PHY_HAVE_SIMD
+__attribute__((target("avx2")))
+static uint32 sc16_to_fc32_avx2(const int16 *in,
+                                float        scale,
+                                uint32       N_floats,
+                                float       *out)
+{
+    __m256 s = _mm256_set1_ps(scale);
+    uint32 i;
+
+    for(i=0; i+16<=N_floats; i+=16)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)&in[i]);
+        __m256  a = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(x)));
+        __m256  b = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(x, 1)));
+        _mm256_storeu_ps(&out[i],   _mm256_mul_ps(a, s));
+        _mm256_storeu_ps(&out[i+8], _mm256_mul_ps(b, s));
+    }
+    return i;
+}
+static uint32 sc16_to_fc32_sse2(const int16 *in,
+                                float        scale,
+                                uint32       N_floats,
+                                float       *out)
+{
+    __m128 s = _mm_set1_ps(scale);
+    uint32 i;
+
+    for(i=0; i+8<=N_floats; i+=8)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)&in[i]);
+        // Sign extend by unpacking into the high halves and shifting down
+        __m128  a = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+        __m128  b = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16));
+        _mm_storeu_ps(&out[i],   _mm_mul_ps(a, s));
+        _mm_storeu_ps(&out[i+4], _mm_mul_ps(b, s));
+    }
+    return i;
+}
+#endif
+void liblte_phy_sc16_to_fc32(const int16 *in,
+                             float        scale,
+                             uint32       N_samps,
+                             complex     *out)
+{
+    float  *out_f    = (float *)out;
+    uint32  N_floats = N_samps*2;
+    uint32  i        = 0;
+
+#if LIBLTE_PHY_HAVE_SIMD
+    if(avx2_supported())
+        i = sc16_to_fc32_avx2(in, scale, N_floats, out_f);
+    else
+        i = sc16_to_fc32_sse2(in, scale, N_floats, out_f);
+#endif
+    for(; i<N_floats; i++)
+        out_f[i] = in[i]*scale;
+}
+
+/*********************************************************************
+    Name: liblte_phy_scale_fc32
+
+    Description: Scales complex float samples by a real factor.  Uses
+                 SSE2/AVX2 when the CPU supports them, in and out may
+                 be the same buffer.
+
+    Document Reference: N/A
+*********************************************************************/
+#if LIBLTE_PHY_HAVE_SIMD
+__attribute__((target("avx2")))
+static uint32 scale_fc32_avx2(const float *in,
+                              float        scale,
+                              uint32       N_floats,
+                              float       *out)
+{
+    __m256 s = _mm256_set1_ps(scale);
+    uint32 i;
+
+    for(i=0; i+8<=N_floats; i+=8)
+        _mm256_storeu_ps(&out[i], _mm256_mul_ps(_mm256_loadu_ps(&in[i]), s));
+    return i;
+}
+static uint32 scale_fc32_sse2(const float *in,
+                              float        scale,
+                              uint32       N_floats,
+                              float       *out)
+{
+    __m128 s = _mm_set1_ps(scale);
+    uint32 i;
+
+    for(i=0; i+4<=N_floats; i+=4)
+        _mm_storeu_ps(&out[i], _mm_mul_ps(_mm_loadu_ps(&in[i]), s));
+    return i;
+}
+#endif
+void liblte_phy_scale_fc32(const complex *in,
+                           float          scale,
+                           uint32         N_samps,
+                           complex       *out)
+{
+    const float *in_f     = (const float *)in;
+    float       *out_f    = (float *)out;
+    uint32       N_floats = N_samps*2;
+    uint32       i        = 0;
+
+#if LIBLTE_PHY_HAVE_SIMD
+    if(avx2_supported())
+        i = scale_fc32_avx2(in_f, scale, N_floats, out_f);
+    else
+        i = scale_fc32_sse2(in_f, scale, N_floats, out_f);
+#endif
+    for(; i<N_floats; i++)
+        out_f[i] = in_f[i]*scale;
+}
+
 /*********************************************************************
     Name: liblte_phy_rate_match_turbo
 
@@ -62,6 +62,15 @@
 *******************************************************************************/
 
 
+/*******************************************************************************
+                              LOCAL FUNCTION PROTOTYPES
+*******************************************************************************/
+
+LIBLTE_ERROR_ENUM rlc_pack_li_fields(uint16  *li,
+                                     uint32   N_data,
+                                     uint8  **pdu_ptr);
+
+
 /*******************************************************************************
                               PDU FUNCTIONS
 *******************************************************************************/
@@ -80,44 +89,17 @@ LIBLTE_ERROR_ENUM liblte_rlc_pack_umd_pdu(LIBLTE_RLC_UMD_PDU_STRUCT *umd,
     if(1 == umd->N_data)
         return liblte_rlc_pack_umd_pdu(umd, &umd->data[0], pdu);
 
+    if(LIBLTE_RLC_UMD_MAX_N_DATA < umd->N_data)
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
     // Header
-    uint8 *pdu_ptr = pdu->msg;
-    if(LIBLTE_RLC_UMD_SN_SIZE_5_BITS == umd->hdr.sn_size)
-    {
-        *pdu_ptr  = (umd->hdr.fi & 0x03) << 6;
-        *pdu_ptr |= (LIBLTE_RLC_E_FIELD_HEADER_EXTENDED & 0x01) << 5;
-        *pdu_ptr |= umd->hdr.sn & 0x1F;
-        pdu_ptr++;
-    }else{
-        *pdu_ptr  = (umd->hdr.fi & 0x03) << 3;
-        *pdu_ptr |= (LIBLTE_RLC_E_FIELD_HEADER_EXTENDED & 0x01) << 2;
-        *pdu_ptr |= (umd->hdr.sn & 0x300) >> 8;
-        pdu_ptr++;
-        *pdu_ptr = umd->hdr.sn & 0xFF;
-        pdu_ptr++;
-    }
-    for(uint32 i=0; i<umd->N_data-1; i++)
-    {
-        if((i % 2) == 0)
-        {
-            *pdu_ptr = (LIBLTE_RLC_E_FIELD_HEADER_NOT_EXTENDED & 0x01) << 7;
-            if(i != umd->N_data-2)
-                *pdu_ptr = (LIBLTE_RLC_E_FIELD_HEADER_EXTENDED & 0x01) << 7;
-            *pdu_ptr |= (umd->data[i].N_bytes & 0x7F0) >> 4;
-            pdu_ptr++;
-            *pdu_ptr = (umd->data[i].N_bytes & 0x00F) << 4;
-        }else{
-            *pdu_ptr |= (LIBLTE_RLC_E_FIELD_HEADER_NOT_EXTENDED & 0x01) << 3;
-            if(i != umd->N_data-2)
-                *pdu_ptr |= (LIBLTE_RLC_E_FIELD_HEADER_EXTENDED & 0x01) << 3;
-            *pdu_ptr |= (umd->data[i].N_bytes & 0x700) >> 8;
-            pdu_ptr++;
-            *pdu_ptr = umd->data[i].N_bytes & 0x0FF;
-            pdu_ptr++;
-        }
-    }
-    if((umd->N_data % 2) == 0)
-        pdu_ptr++;
+    uint16 li[LIBLTE_RLC_UMD_MAX_N_DATA];
+    for(uint32 i=0; i<umd->N_data; i++)
+        li[i] = umd->data[i].N_bytes;
+    LIBLTE_ERROR_ENUM err = liblte_rlc_pack_umd_pdu_header(&umd->hdr, li, umd->N_data, pdu);
+    if(LIBLTE_SUCCESS != err)
+        return err;
+    uint8 *pdu_ptr = &pdu->msg[pdu->N_bytes];
 
     // Data
     for(uint32 i=0; i<umd->N_data; i++)
@@ -233,6 +215,61 @@ LIBLTE_ERROR_ENUM liblte_rlc_unpack_umd_pdu(LIBLTE_BYTE_MSG_STRUCT    *pdu,
     return LIBLTE_SUCCESS;
 }
 
+uint32 liblte_rlc_get_umd_pdu_header_size(LIBLTE_RLC_UMD_SN_SIZE_ENUM sn_size,
+                                          uint32                      N_data)
+{
+    uint32 N_bytes = 2;
+
+    if(LIBLTE_RLC_UMD_SN_SIZE_5_BITS == sn_size)
+        N_bytes = 1;
+
+    // One 12 bit E/LI pair per data field except the last, octet aligned
+    if(1 < N_data)
+        N_bytes += (3*(N_data-1) + 1)/2;
+
+    return N_bytes;
+}
+LIBLTE_ERROR_ENUM liblte_rlc_pack_umd_pdu_header(LIBLTE_RLC_UMD_PDU_HEADER_STRUCT *hdr,
+                                                 uint16                           *li,
+                                                 uint32                            N_data,
+                                                 LIBLTE_BYTE_MSG_STRUCT           *pdu)
+{
+    if(hdr    == NULL ||
+       pdu    == NULL ||
+       N_data == 0    ||
+       (N_data > 1 && li == NULL))
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    LIBLTE_RLC_E_FIELD_ENUM e = LIBLTE_RLC_E_FIELD_HEADER_NOT_EXTENDED;
+    if(1 < N_data)
+        e = LIBLTE_RLC_E_FIELD_HEADER_EXTENDED;
+
+    // Fixed part
+    uint8 *pdu_ptr = pdu->msg;
+    if(LIBLTE_RLC_UMD_SN_SIZE_5_BITS == hdr->sn_size)
+    {
+        *pdu_ptr  = (hdr->fi & 0x03) << 6;
+        *pdu_ptr |= (e & 0x01) << 5;
+        *pdu_ptr |= hdr->sn & 0x1F;
+        pdu_ptr++;
+    }else{
+        *pdu_ptr  = (hdr->fi & 0x03) << 3;
+        *pdu_ptr |= (e & 0x01) << 2;
+        *pdu_ptr |= (hdr->sn & 0x300) >> 8;
+        pdu_ptr++;
+        *pdu_ptr = hdr->sn & 0xFF;
+        pdu_ptr++;
+    }
+
+    // Extension part
+    LIBLTE_ERROR_ENUM err = rlc_pack_li_fields(li, N_data, &pdu_ptr);
+
+    // Fill in the number of bytes used
+    pdu->N_bytes = pdu_ptr - pdu->msg;
+
+    return err;
+}
+
 /*********************************************************************
     PDU Type: Acknowledged Mode Data PDU
 
@@ -247,39 +284,17 @@ LIBLTE_ERROR_ENUM liblte_rlc_pack_amd_pdu(LIBLTE_RLC_AMD_PDUS_STRUCT *amd,
     if(1 == amd->N_pdu)
         return liblte_rlc_pack_amd_pdu(&amd->pdu[0], &amd->pdu[0].data, pdu);
 
+    if(LIBLTE_RLC_AMD_MAX_N_PDU < amd->N_pdu)
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
     // Header
-    uint8 *pdu_ptr = pdu->msg;
-    *pdu_ptr  = (amd->pdu[0].hdr.dc & 0x01) << 7;
-    *pdu_ptr |= (amd->pdu[0].hdr.rf & 0x01) << 6;
-    *pdu_ptr |= (amd->pdu[0].hdr.p & 0x01) << 5;
-    *pdu_ptr |= (amd->pdu[0].hdr.fi & 0x03) << 3;
-    *pdu_ptr |= (LIBLTE_RLC_E_FIELD_HEADER_EXTENDED & 0x01) << 2;
-    *pdu_ptr |= (amd->pdu[0].hdr.sn & 0x300) >> 8;
-    pdu_ptr++;
-    *pdu_ptr = amd->pdu[0].hdr.sn & 0xFF;
-    pdu_ptr++;
-    for(uint32 i=0; i<amd->N_pdu-1; i++)
-    {
-        if((i % 2) == 0)
-        {
-            *pdu_ptr = (LIBLTE_RLC_E_FIELD_HEADER_NOT_EXTENDED & 0x01) << 7;
-            if(i != amd->N_pdu-2)
-                *pdu_ptr = (LIBLTE_RLC_E_FIELD_HEADER_EXTENDED & 0x01) << 7;
-            *pdu_ptr |= (amd->pdu[i].data.N_bytes & 0x7F0) >> 4;
-            pdu_ptr++;
-            *pdu_ptr = (amd->pdu[i].data.N_bytes & 0x00F) << 4;
-        }else{
-            *pdu_ptr |= (LIBLTE_RLC_E_FIELD_HEADER_NOT_EXTENDED & 0x01) << 3;
-            if(i != amd->N_pdu-2)
-                *pdu_ptr |= (LIBLTE_RLC_E_FIELD_HEADER_EXTENDED & 0x01) << 3;
-            *pdu_ptr |= (amd->pdu[i].data.N_bytes & 0x700) >> 8;
-            pdu_ptr++;
-            *pdu_ptr = amd->pdu[i].data.N_bytes & 0x0FF;
-            pdu_ptr++;
-        }
-    }
-    if((amd->N_pdu % 2) == 0)
-        pdu_ptr++;
+    uint16 li[LIBLTE_RLC_AMD_MAX_N_PDU];
+    for(uint32 i=0; i<amd->N_pdu; i++)
+        li[i] = amd->pdu[i].data.N_bytes;
+    LIBLTE_ERROR_ENUM err = liblte_rlc_pack_amd_pdu_header(&amd->pdu[0].hdr, li, amd->N_pdu, pdu);
+    if(LIBLTE_SUCCESS != err)
+        return err;
+    uint8 *pdu_ptr = &pdu->msg[pdu->N_bytes];
 
     // Data
     for(uint32 i=0; i<amd->N_pdu; i++)
@@ -434,6 +449,71 @@ LIBLTE_ERROR_ENUM liblte_rlc_unpack_amd_pdu(LIBLTE_BYTE_MSG_STRUCT     *pdu,
     return LIBLTE_SUCCESS;
 }
 
+uint32 liblte_rlc_get_amd_pdu_header_size(LIBLTE_RLC_RF_FIELD_ENUM rf,
+                                          uint32                   N_data)
+{
+    uint32 N_bytes = 2;
+
+    if(LIBLTE_RLC_RF_FIELD_AMD_PDU_SEGMENT == rf)
+        N_bytes = 4;
+
+    // One 12 bit E/LI pair per data field except the last, octet aligned
+    if(1 < N_data)
+        N_bytes += (3*(N_data-1) + 1)/2;
+
+    return N_bytes;
+}
+bool liblte_rlc_am_sn_in_tx_window(uint16 sn,
+                                   uint16 vt_a)
+{
+    // Sequence numbers are compared relative to VT(A), modulo 1024
+    // (36.322 section 7.1)
+    return(((sn - vt_a) & (LIBLTE_RLC_AM_SN_MOD - 1)) < LIBLTE_RLC_AM_WINDOW_SIZE);
+}
+LIBLTE_ERROR_ENUM liblte_rlc_pack_amd_pdu_header(LIBLTE_RLC_AMD_PDU_HEADER_STRUCT *hdr,
+                                                 uint16                           *li,
+                                                 uint32                            N_data,
+                                                 LIBLTE_BYTE_MSG_STRUCT           *pdu)
+{
+    if(hdr    == NULL ||
+       pdu    == NULL ||
+       N_data == 0    ||
+       (N_data > 1 && li == NULL))
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    LIBLTE_RLC_E_FIELD_ENUM e = LIBLTE_RLC_E_FIELD_HEADER_NOT_EXTENDED;
+    if(1 < N_data)
+        e = LIBLTE_RLC_E_FIELD_HEADER_EXTENDED;
+
+    // Fixed part
+    uint8 *pdu_ptr = pdu->msg;
+    *pdu_ptr  = (hdr->dc & 0x01) << 7;
+    *pdu_ptr |= (hdr->rf & 0x01) << 6;
+    *pdu_ptr |= (hdr->p & 0x01) << 5;
+    *pdu_ptr |= (hdr->fi & 0x03) << 3;
+    *pdu_ptr |= (e & 0x01) << 2;
+    *pdu_ptr |= (hdr->sn & 0x300) >> 8;
+    pdu_ptr++;
+    *pdu_ptr = hdr->sn & 0xFF;
+    pdu_ptr++;
+    if(LIBLTE_RLC_RF_FIELD_AMD_PDU_SEGMENT == hdr->rf)
+    {
+        *pdu_ptr  = (hdr->lsf & 0x01) << 7;
+        *pdu_ptr |= (hdr->so & 0x7F00) >> 8;
+        pdu_ptr++;
+        *pdu_ptr = hdr->so & 0xFF;
+        pdu_ptr++;
+    }
+
+    // Extension part
+    LIBLTE_ERROR_ENUM err = rlc_pack_li_fields(li, N_data, &pdu_ptr);
+
+    // Fill in the number of bytes used
+    pdu->N_bytes = pdu_ptr - pdu->msg;
+
+    return err;
+}
+
 /*********************************************************************
     PDU Type: Status PDU
 
@@ -539,3 +619,53 @@ LIBLTE_ERROR_ENUM liblte_rlc_unpack_status_pdu(LIBLTE_BYTE_MSG_STRUCT       *pdu
 
     return LIBLTE_SUCCESS;
 }
+
+/*******************************************************************************
+                              LOCAL FUNCTIONS
+*******************************************************************************/
+
+/*********************************************************************
+    Name: rlc_pack_li_fields
+
+    Description: Packs the E and LI fields for all but the last of
+                 N_data data field elements.  Two E/LI pairs share
+                 three octets, an odd pair is padded with four bits.
+
+    Document Reference: 36.322 v10.0.0 Section 6.2.1.3
+*********************************************************************/
+LIBLTE_ERROR_ENUM rlc_pack_li_fields(uint16  *li,
+                                     uint32   N_data,
+                                     uint8  **pdu_ptr)
+{
+    uint8 *ptr = *pdu_ptr;
+
+    for(uint32 i=0; i<N_data-1; i++)
+    {
+        if(li[i] > 0x7FF)
+            return LIBLTE_ERROR_INVALID_INPUTS;
+
+        LIBLTE_RLC_E_FIELD_ENUM e = LIBLTE_RLC_E_FIELD_HEADER_NOT_EXTENDED;
+        if(i != N_data-2)
+            e = LIBLTE_RLC_E_FIELD_HEADER_EXTENDED;
+
+        if((i % 2) == 0)
+        {
+            *ptr  = (e & 0x01) << 7;
+            *ptr |= (li[i] & 0x7F0) >> 4;
+            ptr++;
+            *ptr = (li[i] & 0x00F) << 4;
+        }else{
+            *ptr |= (e & 0x01) << 3;
+            *ptr |= (li[i] & 0x700) >> 8;
+            ptr++;
+            *ptr = li[i] & 0x0FF;
+            ptr++;
+        }
+    }
+    if(N_data > 1 && (N_data % 2) == 0)
+        ptr++;
+
+    *pdu_ptr = ptr;
+
+    return LIBLTE_SUCCESS;
+}
@@ -38,25 +38,63 @@
 
 #include "liblte_security.h"
 #include "polarssl/compat-1.2.h"
-#include "polarssl/aes.h"
 #include "math.h"
+#include "string.h"
+#include <mutex>
 
 /*******************************************************************************
                               DEFINES
 *******************************************************************************/
 
+// Build with -DLIBLTE_SECURITY_HAVE_AES_NI=0 to force the software path
+#ifndef LIBLTE_SECURITY_HAVE_AES_NI
+#if defined(__x86_64__) || defined(__i386__)
+#define LIBLTE_SECURITY_HAVE_AES_NI 1
+#else
+#define LIBLTE_SECURITY_HAVE_AES_NI 0
+#endif
+#endif
+#if LIBLTE_SECURITY_HAVE_AES_NI
+#include <wmmintrin.h>
+#endif
+
+// Replicates a byte value into every lane of a packed uint64
+#define AES_CT_LSB_MASK 0x0101010101010101ULL
+
+// Blocks encrypted together by the bitsliced AES, one bit of each of
+// their 64 bytes per uint64
+#define AES_BS_N_BLOCKS 4
+
+// Replicates a 16 bit pattern into every block lane of a slice
+#define AES_BS_LANE_MASK 0x0001000100010001ULL
+
+// Keystream words generated per pass by the stream ciphers
+#define STREAM_CIPHER_CHUNK_WORDS 64
 
 /*******************************************************************************
                               TYPEDEFS
 *******************************************************************************/
 
 typedef struct{
-    uint8 rk[11][4][4];
-}ROUND_KEY_STRUCT;
+    uint32 s1[4][256];
+    uint32 s2[4][256];
+    uint32 mul_alpha[256];
+    uint32 div_alpha[256];
+}SNOW3G_TABLES_STRUCT;
 
 typedef struct{
-    uint8 state[4][4];
-}STATE_STRUCT;
+    const SNOW3G_TABLES_STRUCT *tables;
+    uint32                      s[16];
+    uint32                      r1;
+    uint32                      r2;
+    uint32                      r3;
+}SNOW3G_STATE_STRUCT;
+
+typedef struct{
+    uint32 s[16];
+    uint32 r1;
+    uint32 r2;
+}ZUC_STATE_STRUCT;
 
 /*******************************************************************************
                               GLOBAL VARIABLES
@@ -65,107 +103,425 @@ typedef struct{
 static const uint8 OP[16] = {0x63,0xBF,0xA5,0x0E,0xE6,0x52,0x33,0x65,
                              0xFF,0x14,0xC1,0xF4,0x5F,0x88,0x73,0x7D};
 
-static const uint8 S[256] = { 99,124,119,123,242,107,111,197, 48,  1,103, 43,254,215,171,118,
-                             202,130,201,125,250, 89, 71,240,173,212,162,175,156,164,114,192,
-                             183,253,147, 38, 54, 63,247,204, 52,165,229,241,113,216, 49, 21,
-                               4,199, 35,195, 24,150,  5,154,  7, 18,128,226,235, 39,178,117,
-                               9,131, 44, 26, 27,110, 90,160, 82, 59,214,179, 41,227, 47,132,
-                              83,209,  0,237, 32,252,177, 91,106,203,190, 57, 74, 76, 88,207,
-                             208,239,170,251, 67, 77, 51,133, 69,249,  2,127, 80, 60,159,168,
-                              81,163, 64,143,146,157, 56,245,188,182,218, 33, 16,255,243,210,
-                             205, 12, 19,236, 95,151, 68, 23,196,167,126, 61,100, 93, 25,115,
-                              96,129, 79,220, 34, 42,144,136, 70,238,184, 20,222, 94, 11,219,
-                             224, 50, 58, 10, 73,  6, 36, 92,194,211,172, 98,145,149,228,121,
-                             231,200, 55,109,141,213, 78,169,108, 86,244,234,101,122,174,  8,
-                             186,120, 37, 46, 28,166,180,198,232,221,116, 31, 75,189,139,138,
-                             112, 62,181,102, 72,  3,246, 14, 97, 53, 87,185,134,193, 29,158,
-                             225,248,152, 17,105,217,142,148,155, 30,135,233,206, 85, 40,223,
-                             140,161,137, 13,191,230, 66,104, 65,153, 45, 15,176, 84,187, 22};
-
-static const uint8 X_TIME[256] = {  0,  2,  4,  6,  8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30,
-                                   32, 34, 36, 38, 40, 42, 44, 46, 48, 50, 52, 54, 56, 58, 60, 62,
-                                   64, 66, 68, 70, 72, 74, 76, 78, 80, 82, 84, 86, 88, 90, 92, 94,
-                                   96, 98,100,102,104,106,108,110,112,114,116,118,120,122,124,126,
-                                  128,130,132,134,136,138,140,142,144,146,148,150,152,154,156,158,
-                                  160,162,164,166,168,170,172,174,176,178,180,182,184,186,188,190,
-                                  192,194,196,198,200,202,204,206,208,210,212,214,216,218,220,222,
-                                  224,226,228,230,232,234,236,238,240,242,244,246,248,250,252,254,
-                                   27, 25, 31, 29, 19, 17, 23, 21, 11,  9, 15, 13,  3,  1,  7,  5,
-                                   59, 57, 63, 61, 51, 49, 55, 53, 43, 41, 47, 45, 35, 33, 39, 37,
-                                   91, 89, 95, 93, 83, 81, 87, 85, 75, 73, 79, 77, 67, 65, 71, 69,
-                                  123,121,127,125,115,113,119,117,107,105,111,109, 99, 97,103,101,
-                                  155,153,159,157,147,145,151,149,139,137,143,141,131,129,135,133,
-                                  187,185,191,189,179,177,183,181,171,169,175,173,163,161,167,165,
-                                  219,217,223,221,211,209,215,213,203,201,207,205,195,193,199,197,
-                                  251,249,255,253,243,241,247,245,235,233,239,237,227,225,231,229};
+static const uint8 RCON[10] = {0x01,0x02,0x04,0x08,0x10,0x20,0x40,0x80,0x1B,0x36};
+
+static const uint8 ZUC_S0[256] = {0x3e,0x72,0x5b,0x47,0xca,0xe0,0x00,0x33,0x04,0xd1,0x54,0x98,0x09,0xb9,0x6d,0xcb,
+                                  0x7b,0x1b,0xf9,0x32,0xaf,0x9d,0x6a,0xa5,0xb8,0x2d,0xfc,0x1d,0x08,0x53,0x03,0x90,
+                                  0x4d,0x4e,0x84,0x99,0xe4,0xce,0xd9,0x91,0xdd,0xb6,0x85,0x48,0x8b,0x29,0x6e,0xac,
+                                  0xcd,0xc1,0xf8,0x1e,0x73,0x43,0x69,0xc6,0xb5,0xbd,0xfd,0x39,0x63,0x20,0xd4,0x38,
+                                  0x76,0x7d,0xb2,0xa7,0xcf,0xed,0x57,0xc5,0xf3,0x2c,0xbb,0x14,0x21,0x06,0x55,0x9b,
+                                  0xe3,0xef,0x5e,0x31,0x4f,0x7f,0x5a,0xa4,0x0d,0x82,0x51,0x49,0x5f,0xba,0x58,0x1c,
+                                  0x4a,0x16,0xd5,0x17,0xa8,0x92,0x24,0x1f,0x8c,0xff,0xd8,0xae,0x2e,0x01,0xd3,0xad,
+                                  0x3b,0x4b,0xda,0x46,0xeb,0xc9,0xde,0x9a,0x8f,0x87,0xd7,0x3a,0x80,0x6f,0x2f,0xc8,
+                                  0xb1,0xb4,0x37,0xf7,0x0a,0x22,0x13,0x28,0x7c,0xcc,0x3c,0x89,0xc7,0xc3,0x96,0x56,
+                                  0x07,0xbf,0x7e,0xf0,0x0b,0x2b,0x97,0x52,0x35,0x41,0x79,0x61,0xa6,0x4c,0x10,0xfe,
+                                  0xbc,0x26,0x95,0x88,0x8a,0xb0,0xa3,0xfb,0xc0,0x18,0x94,0xf2,0xe1,0xe5,0xe9,0x5d,
+                                  0xd0,0xdc,0x11,0x66,0x64,0x5c,0xec,0x59,0x42,0x75,0x12,0xf5,0x74,0x9c,0xaa,0x23,
+                                  0x0e,0x86,0xab,0xbe,0x2a,0x02,0xe7,0x67,0xe6,0x44,0xa2,0x6c,0xc2,0x93,0x9f,0xf1,
+                                  0xf6,0xfa,0x36,0xd2,0x50,0x68,0x9e,0x62,0x71,0x15,0x3d,0xd6,0x40,0xc4,0xe2,0x0f,
+                                  0x8e,0x83,0x77,0x6b,0x25,0x05,0x3f,0x0c,0x30,0xea,0x70,0xb7,0xa1,0xe8,0xa9,0x65,
+                                  0x8d,0x27,0x1a,0xdb,0x81,0xb3,0xa0,0xf4,0x45,0x7a,0x19,0xdf,0xee,0x78,0x34,0x60};
+
+static const uint8 ZUC_S1[256] = {0x55,0xc2,0x63,0x71,0x3b,0xc8,0x47,0x86,0x9f,0x3c,0xda,0x5b,0x29,0xaa,0xfd,0x77,
+                                  0x8c,0xc5,0x94,0x0c,0xa6,0x1a,0x13,0x00,0xe3,0xa8,0x16,0x72,0x40,0xf9,0xf8,0x42,
+                                  0x44,0x26,0x68,0x96,0x81,0xd9,0x45,0x3e,0x10,0x76,0xc6,0xa7,0x8b,0x39,0x43,0xe1,
+                                  0x3a,0xb5,0x56,0x2a,0xc0,0x6d,0xb3,0x05,0x22,0x66,0xbf,0xdc,0x0b,0xfa,0x62,0x48,
+                                  0xdd,0x20,0x11,0x06,0x36,0xc9,0xc1,0xcf,0xf6,0x27,0x52,0xbb,0x69,0xf5,0xd4,0x87,
+                                  0x7f,0x84,0x4c,0xd2,0x9c,0x57,0xa4,0xbc,0x4f,0x9a,0xdf,0xfe,0xd6,0x8d,0x7a,0xeb,
+                                  0x2b,0x53,0xd8,0x5c,0xa1,0x14,0x17,0xfb,0x23,0xd5,0x7d,0x30,0x67,0x73,0x08,0x09,
+                                  0xee,0xb7,0x70,0x3f,0x61,0xb2,0x19,0x8e,0x4e,0xe5,0x4b,0x93,0x8f,0x5d,0xdb,0xa9,
+                                  0xad,0xf1,0xae,0x2e,0xcb,0x0d,0xfc,0xf4,0x2d,0x46,0x6e,0x1d,0x97,0xe8,0xd1,0xe9,
+                                  0x4d,0x37,0xa5,0x75,0x5e,0x83,0x9e,0xab,0x82,0x9d,0xb9,0x1c,0xe0,0xcd,0x49,0x89,
+                                  0x01,0xb6,0xbd,0x58,0x24,0xa2,0x5f,0x38,0x78,0x99,0x15,0x90,0x50,0xb8,0x95,0xe4,
+                                  0xd0,0x91,0xc7,0xce,0xed,0x0f,0xb4,0x6f,0xa0,0xcc,0xf0,0x02,0x4a,0x79,0xc3,0xde,
+                                  0xa3,0xef,0xea,0x51,0xe6,0x6b,0x18,0xec,0x1b,0x2c,0x80,0xf7,0x74,0xe7,0xff,0x21,
+                                  0x5a,0x6a,0x54,0x1e,0x41,0x31,0x92,0x35,0xc4,0x33,0x07,0x0a,0xba,0x7e,0x0e,0x34,
+                                  0x88,0xb1,0x98,0x7c,0xf3,0x3d,0x60,0x6c,0x7b,0xca,0xd3,0x1f,0x32,0x65,0x04,0x28,
+                                  0x64,0xbe,0x85,0x9b,0x2f,0x59,0x8a,0xd7,0xb0,0x25,0xac,0xaf,0x12,0x03,0xe2,0xf2};
+
+static const uint16 ZUC_D[16] = {0x44D7,0x26BC,0x626B,0x135E,0x5789,0x35E2,0x7135,0x09AF,
+                                 0x4D78,0x2F13,0x6BC4,0x1AF1,0x5E26,0x3C4D,0x789A,0x47AC};
 
 /*******************************************************************************
                               LOCAL FUNCTION PROTOTYPES
 *******************************************************************************/
 
 /*********************************************************************
-    Name: compute_OPc
+    Name: aes_ni_supported
 
-    Description: Computes OPc from OP and K.
+    Description: Checks whether the CPU supports the AES-NI
+                 instructions.
 
-    Document Reference: 35.206 v10.0.0 Annex 3
+    Document Reference: N/A
 *********************************************************************/
 // Defines
 // Enums
 // Structs
 // Functions
-void compute_OPc(ROUND_KEY_STRUCT *rk,
-                 uint8            *op,
-                 uint8            *op_c);
+bool aes_ni_supported(void);
 
 /*********************************************************************
-    Name: rijndael_key_schedule
+    Name: aes_ni_key_schedule
 
-    Description: Computes all Rijndael's internal subkeys from key.
+    Description: Computes all AES round keys from key using AES-NI.
 
-    Document Reference: 35.206 v10.0.0 Annex 3
+    Document Reference: FIPS 197
 *********************************************************************/
 // Defines
 // Enums
 // Structs
 // Functions
-void rijndael_key_schedule(uint8            *key,
-                           ROUND_KEY_STRUCT *rk);
+void aes_ni_key_schedule(uint8                                   *key,
+                         LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT *ks);
 
 /*********************************************************************
-    Name: rijndael_encrypt
+    Name: aes_ni_encrypt
 
-    Description: Computes output using input and round keys.
+    Description: Computes output using input and round keys using
+                 AES-NI.
 
-    Document Reference: 35.206 v10.0.0 Annex 3
+    Document Reference: FIPS 197
 *********************************************************************/
 // Defines
 // Enums
 // Structs
 // Functions
-void rijndael_encrypt(uint8            *input,
-                      ROUND_KEY_STRUCT *rk,
-                      uint8            *output);
+void aes_ni_encrypt(LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT *ks,
+                    uint8                                   *input,
+                    uint8                                   *output);
 
 /*********************************************************************
-    Name: key_add
+    Name: aes_ni_encrypt_blocks
 
-    Description: Round key addition function.
+    Description: Computes N_blocks independent output blocks using
+                 AES-NI, keeping four blocks in flight to hide the
+                 AESENC latency.
 
-    Document Reference: 35.206 v10.0.0 Annex 3
+    Document Reference: FIPS 197
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+void aes_ni_encrypt_blocks(LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT *ks,
+                           uint8                                   *input,
+                           uint8                                   *output,
+                           uint32                                   N_blocks);
+
+/*********************************************************************
+    Name: aes_ct_sub_bytes
+
+    Description: Byte substitution of 8 packed bytes without table
+                 lookups, so the timing does not depend on the data.
+                 The inverse is computed as x^254 in GF(2^8) followed
+                 by the affine transformation.
+
+    Document Reference: FIPS 197 Section 5.1.1
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+uint64 aes_ct_sub_bytes(uint64 x);
+
+/*********************************************************************
+    Name: aes_ct_key_schedule
+
+    Description: Computes all AES round keys from key in constant
+                 time.
+
+    Document Reference: FIPS 197 Section 5.2
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+void aes_ct_key_schedule(uint8                                   *key,
+                         LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT *ks);
+
+/*********************************************************************
+    Name: aes_ct_encrypt
+
+    Description: Computes output using input and round keys in
+                 constant time.
+
+    Document Reference: FIPS 197 Section 5.1
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+void aes_ct_encrypt(LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT *ks,
+                    uint8                                   *input,
+                    uint8                                   *output);
+
+/*********************************************************************
+    Name: aes_bs_encrypt_blocks
+
+    Description: Computes N_blocks independent output blocks with a
+                 bitsliced AES, AES_BS_N_BLOCKS at a time.  No table
+                 lookups or branches depend on the data, so it is
+                 constant time like aes_ct_encrypt, but much faster.
+
+    Document Reference: FIPS 197 Section 5.1
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+void aes_bs_encrypt_blocks(LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT *ks,
+                           uint8                                   *input,
+                           uint8                                   *output,
+                           uint32                                   N_blocks);
+
+/*********************************************************************
+    Name: aes_encrypt_blocks
+
+    Description: Computes N_blocks independent output blocks with the
+                 fastest available AES implementation.
+
+    Document Reference: FIPS 197
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+void aes_encrypt_blocks(LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT *ks,
+                        uint8                                   *input,
+                        uint8                                   *output,
+                        uint32                                   N_blocks);
+
+/*********************************************************************
+    Name: eea2_counter_block
+
+    Description: Builds counter block T_(block+1) for 128-EEA2.
+
+    Document Reference: 33.401 v10.0.0 Annex B.1.3
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+void eea2_counter_block(LIBLTE_SECURITY_CIPHER_JOB_STRUCT *job,
+                        uint32                             block,
+                        uint8                             *ctr);
+
+/*********************************************************************
+    Name: pack_bits
+
+    Description: Packs a one bit per byte message into bytes, MSB
+                 first.
+
+    Document Reference: N/A
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+void pack_bits(LIBLTE_BIT_MSG_STRUCT *msg,
+               uint8                 *packed);
+
+/*********************************************************************
+    Name: snow3g_tables
+
+    Description: Returns the SNOW 3G S1/S2 and alpha multiplication
+                 tables, building them on first use.
+
+    Document Reference: ETSI/SAGE SNOW 3G Specification v1.1
+                        Sections 3.1 - 3.4
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+const SNOW3G_TABLES_STRUCT* snow3g_tables(void);
+
+/*********************************************************************
+    Name: snow3g_init
+
+    Description: Loads key and IV and runs the 32 initialization
+                 clocks of SNOW 3G.
+
+    Document Reference: ETSI/SAGE SNOW 3G Specification v1.1
+                        Section 4.1
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+void snow3g_init(SNOW3G_STATE_STRUCT *state,
+                 uint32              *k,
+                 uint32              *iv);
+
+/*********************************************************************
+    Name: snow3g_generate_keystream
+
+    Description: Generates N_words 32-bit keystream words.
+
+    Document Reference: ETSI/SAGE SNOW 3G Specification v1.1
+                        Section 4.2
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+void snow3g_generate_keystream(SNOW3G_STATE_STRUCT *state,
+                               uint32              *ks,
+                               uint32               N_words);
+
+/*********************************************************************
+    Name: snow3g_cipher
+
+    Description: XORs msg_len bytes of msg with the SNOW 3G keystream.
+
+    Document Reference: 35.215 v10.0.0 Section 3.4
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+void snow3g_cipher(SNOW3G_STATE_STRUCT *state,
+                   uint8               *msg,
+                   uint32               msg_len,
+                   uint8               *out);
+
+/*********************************************************************
+    Name: snow3g_f9
+
+    Description: Computes the SNOW 3G based MAC over msg_len_bits
+                 bits of msg.
+
+    Document Reference: 35.215 v10.0.0 Section 4.4
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+void snow3g_f9(uint8  *key,
+               uint32  count,
+               uint8   bearer,
+               uint8   direction,
+               uint8  *msg,
+               uint32  msg_len_bits,
+               uint8  *mac);
+
+/*********************************************************************
+    Name: zuc_init
+
+    Description: Loads key and IV and runs the 32 initialization
+                 clocks of ZUC.
+
+    Document Reference: ETSI/SAGE ZUC Specification v1.6 Section 3.6.1
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+void zuc_init(ZUC_STATE_STRUCT *state,
+              uint8            *k,
+              uint8            *iv);
+
+/*********************************************************************
+    Name: zuc_generate_keystream
+
+    Description: Generates N_words 32-bit keystream words.
+
+    Document Reference: ETSI/SAGE ZUC Specification v1.6 Section 3.6.2
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+void zuc_generate_keystream(ZUC_STATE_STRUCT *state,
+                            uint32           *ks,
+                            uint32            N_words);
+
+/*********************************************************************
+    Name: zuc_cipher
+
+    Description: XORs msg_len bytes of msg with the ZUC keystream.
+
+    Document Reference: ETSI/SAGE 128-EEA3 & 128-EIA3 Specification
+                        v1.6 Section 3.4
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+void zuc_cipher(ZUC_STATE_STRUCT *state,
+                uint8            *msg,
+                uint32            msg_len,
+                uint8            *out);
+
+/*********************************************************************
+    Name: zuc_eia3
+
+    Description: Computes the ZUC based MAC over msg_len_bits bits of
+                 msg.
+
+    Document Reference: ETSI/SAGE 128-EEA3 & 128-EIA3 Specification
+                        v1.6 Section 4.4
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+void zuc_eia3(uint8  *key,
+              uint32  count,
+              uint8   bearer,
+              uint8   direction,
+              uint8  *msg,
+              uint32  msg_len_bits,
+              uint8  *mac);
+
+/*********************************************************************
+    Name: load_be32
+
+    Description: Reads a big endian 32-bit word.
+
+    Document Reference: N/A
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+uint32 load_be32(uint8 *bytes);
+
+/*********************************************************************
+    Name: store_be32
+
+    Description: Writes a big endian 32-bit word.
+
+    Document Reference: N/A
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+void store_be32(uint32  word,
+                uint8  *bytes);
+
+/*********************************************************************
+    Name: xor_keystream
+
+    Description: XORs up to 4*STREAM_CIPHER_CHUNK_WORDS bytes of msg
+                 with big endian keystream words.
+
+    Document Reference: N/A
 *********************************************************************/
 // Defines
 // Enums
 // Structs
 // Functions
-void key_add(STATE_STRUCT     *state,
-             ROUND_KEY_STRUCT *rk,
-             uint32            round);
+void xor_keystream(uint32 *ks,
+                   uint8  *msg,
+                   uint8  *out,
+                   uint32  msg_len);
 
 /*********************************************************************
-    Name: byte_sub
+    Name: milenage_temp
 
-    Description: Byte substitution transformation.
+    Description: Computes TEMP = E[RAND ^ OPc]K.
 
     Document Reference: 35.206 v10.0.0 Annex 3
 *********************************************************************/
@@ -173,12 +529,14 @@ void key_add(STATE_STRUCT     *state,
 // Enums
 // Structs
 // Functions
-void byte_sub(STATE_STRUCT *state);
+void milenage_temp(LIBLTE_SECURITY_MILENAGE_KEY_STRUCT *key,
+                   uint8                               *rand,
+                   uint8                               *temp);
 
 /*********************************************************************
-    Name: shift_row
+    Name: milenage_out1
 
-    Description: Row shift transformation.
+    Description: Computes OUT1, used by F1 and F1*.
 
     Document Reference: 35.206 v10.0.0 Annex 3
 *********************************************************************/
@@ -186,12 +544,17 @@ void byte_sub(STATE_STRUCT *state);
 // Enums
 // Structs
 // Functions
-void shift_row(STATE_STRUCT *state);
+void milenage_out1(LIBLTE_SECURITY_MILENAGE_KEY_STRUCT *key,
+                   uint8                               *rand,
+                   uint8                               *sqn,
+                   uint8                               *amf,
+                   uint8                               *out1);
 
 /*********************************************************************
-    Name: mix_column
+    Name: milenage_out
 
-    Description: Mix column transformation.
+    Description: Computes OUT2 through OUT5 from TEMP, the rotation in
+                 bytes and the constant c.
 
     Document Reference: 35.206 v10.0.0 Annex 3
 *********************************************************************/
@@ -199,7 +562,11 @@ void shift_row(STATE_STRUCT *state);
 // Enums
 // Structs
 // Functions
-void mix_column(STATE_STRUCT *state);
+void milenage_out(LIBLTE_SECURITY_MILENAGE_KEY_STRUCT *key,
+                  uint8                               *temp,
+                  uint32                               rot,
+                  uint8                                c,
+                  uint8                               *out);
 
 /*******************************************************************************
                               FUNCTIONS
@@ -440,11 +807,11 @@ LIBLTE_ERROR_ENUM liblte_security_128_eia2(uint8  *key,
         return LIBLTE_ERROR_INVALID_INPUTS;
 
     // Subkey L generation
-    aes_context ctx;
-    aes_setkey_enc(&ctx, key, 128);
+    LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT ks;
+    liblte_security_aes_key_schedule(key, &ks);
     uint8 const_zero[16] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
     uint8 L[16];
-    aes_crypt_ecb(&ctx, AES_ENCRYPT, const_zero, L);
+    liblte_security_aes_encrypt(&ks, const_zero, L);
 
     // Subkey K1 generation
     uint8 K1[16];
@@ -483,20 +850,20 @@ LIBLTE_ERROR_ENUM liblte_security_128_eia2(uint8  *key,
     {
         for(uint32 j=0; j<16; j++)
             tmp[j] = T[j] ^ M[i*16 + j];
-        aes_crypt_ecb(&ctx, AES_ENCRYPT, tmp, T);
+        liblte_security_aes_encrypt(&ks, tmp, T);
     }
     uint32 pad_bits = ((msg_len*8) + 64) % 128;
     if(pad_bits == 0)
     {
         for(uint32 j=0; j<16; j++)
             tmp[j] = T[j] ^ K1[j] ^ M[(n-1)*16 + j];
-        aes_crypt_ecb(&ctx, AES_ENCRYPT, tmp, T);
+        liblte_security_aes_encrypt(&ks, tmp, T);
     }else{
         pad_bits                           = (128 - pad_bits) - 1;
         M[(n-1)*16 + (15 - (pad_bits/8))] |= 0x1 << (pad_bits % 8);
         for(uint32 j=0; j<16; j++)
             tmp[j] = T[j] ^ K2[j] ^ M[(n-1)*16 + j];
-        aes_crypt_ecb(&ctx, AES_ENCRYPT, tmp, T);
+        liblte_security_aes_encrypt(&ks, tmp, T);
     }
 
     for(uint32 i=0; i<4; i++)
@@ -515,11 +882,11 @@ LIBLTE_ERROR_ENUM liblte_security_128_eia2(uint8                 *key,
         return LIBLTE_ERROR_INVALID_INPUTS;
 
     // Subkey L generation
-    aes_context ctx;
-    aes_setkey_enc(&ctx, key, 128);
+    LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT ks;
+    liblte_security_aes_key_schedule(key, &ks);
     uint8 const_zero[16] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
     uint8 L[16];
-    aes_crypt_ecb(&ctx, AES_ENCRYPT, const_zero, L);
+    liblte_security_aes_encrypt(&ks, const_zero, L);
 
     // Subkey K1 generation
     uint8 K1[16];
@@ -568,20 +935,20 @@ LIBLTE_ERROR_ENUM liblte_security_128_eia2(uint8                 *key,
     {
         for(uint32 j=0; j<16; j++)
             tmp[j] = T[j] ^ M[i*16 + j];
-        aes_crypt_ecb(&ctx, AES_ENCRYPT, tmp, T);
+        liblte_security_aes_encrypt(&ks, tmp, T);
     }
     uint32 pad_bits = (msg->N_bits + 64) % 128;
     if(pad_bits == 0)
     {
         for(uint32 j=0; j<16; j++)
             tmp[j] = T[j] ^ K1[j] ^ M[(n-1)*16 + j];
-        aes_crypt_ecb(&ctx, AES_ENCRYPT, tmp, T);
+        liblte_security_aes_encrypt(&ks, tmp, T);
     }else{
         pad_bits                           = (128 - pad_bits) - 1;
         M[(n-1)*16 + (15 - (pad_bits/8))] |= 0x1 << (pad_bits % 8);
         for(uint32 j=0; j<16; j++)
             tmp[j] = T[j] ^ K2[j] ^ M[(n-1)*16 + j];
-        aes_crypt_ecb(&ctx, AES_ENCRYPT, tmp, T);
+        liblte_security_aes_encrypt(&ks, tmp, T);
     }
 
     for(uint32 i=0; i<4; i++)
@@ -591,125 +958,475 @@ LIBLTE_ERROR_ENUM liblte_security_128_eia2(uint8                 *key,
 }
 
 /*********************************************************************
-    Name: liblte_security_milenage_f1
+    Name: liblte_security_128_eia1
 
-    Description: Milenage security function F1.  Computes network
-                 authentication code MAC-A from key K, random
-                 challenge RAND, sequence number SQN, and
-                 authentication management field AMF.
+    Description: 128-bit integrity algorithm EIA1 (SNOW 3G based).
 
-    Document Reference: 35.206 v10.0.0 Annex 3
+    Document Reference: 33.401 v10.0.0 Annex B.2.2
+                        35.215 v10.0.0 Section 4
 *********************************************************************/
-LIBLTE_ERROR_ENUM liblte_security_milenage_f1(uint8 *k,
-                                              uint8 *rand,
-                                              uint8 *sqn,
-                                              uint8 *amf,
-                                              uint8 *mac_a)
+LIBLTE_ERROR_ENUM liblte_security_128_eia1(uint8  *key,
+                                           uint32  count,
+                                           uint8   bearer,
+                                           uint8   direction,
+                                           uint8  *msg,
+                                           uint32  msg_len,
+                                           uint8  *mac)
 {
-    if(k == NULL || rand == NULL || sqn == NULL || amf == NULL || mac_a == NULL)
+    if(key == NULL || msg == NULL || mac == NULL)
         return LIBLTE_ERROR_INVALID_INPUTS;
 
-    // Initialize the round keys
-    ROUND_KEY_STRUCT round_keys;
-    rijndael_key_schedule(k, &round_keys);
-
-    // Compute OPc
-    uint8 op_c[16];
-    compute_OPc(&round_keys, (uint8 *)OP, op_c);
-
-    // Compute temp
-    uint8 rijndael_input[16];
-    for(uint32 i=0; i<16; i++)
-        rijndael_input[i] = rand[i] ^ op_c[i];
-    uint8 temp[16];
-    rijndael_encrypt(rijndael_input, &round_keys, temp);
+    snow3g_f9(key, count, bearer, direction, msg, msg_len*8, mac);
 
-    // Construct in1
-    uint8 in1[16];
-    for(uint32 i=0; i<6; i++)
-    {
-        in1[i]   = sqn[i];
-        in1[i+8] = sqn[i];
-    }
-    for(uint32 i=0; i<2; i++)
-    {
-        in1[i+6]  = amf[i];
-        in1[i+14] = amf[i];
-    }
+    return LIBLTE_SUCCESS;
+}
+LIBLTE_ERROR_ENUM liblte_security_128_eia1(uint8                 *key,
+                                           uint32                 count,
+                                           uint8                  bearer,
+                                           uint8                  direction,
+                                           LIBLTE_BIT_MSG_STRUCT *msg,
+                                           uint8                 *mac)
+{
+    uint8 packed[LIBLTE_MAX_MSG_SIZE];
 
-    // Compute out1
-    uint8 out1[16];
-    for(uint32 i=0; i<16; i++)
-        rijndael_input[(i+8) % 16] = in1[i] ^ op_c[i];
-    for(uint32 i=0; i<16; i++)
-        rijndael_input[i] ^= temp[i];
-    rijndael_encrypt(rijndael_input, &round_keys, out1);
-    for(uint32 i=0; i<16; i++)
-        out1[i] ^= op_c[i];
+    if(key == NULL || msg == NULL || mac == NULL)
+        return LIBLTE_ERROR_INVALID_INPUTS;
 
-    // Return MAC-A
-    for(uint32 i=0; i<8; i++)
-        mac_a[i] = out1[i];
+    pack_bits(msg, packed);
+    snow3g_f9(key, count, bearer, direction, packed, msg->N_bits, mac);
 
     return LIBLTE_SUCCESS;
 }
 
 /*********************************************************************
-    Name: liblte_security_milenage_f1_star
+    Name: liblte_security_128_eia3
 
-    Description: Milenage security function F1*.  Computes resynch
-                 authentication code MAC-S from key K, random
-                 challenge RAND, sequence number SQN, and
-                 authentication management field AMF.
+    Description: 128-bit integrity algorithm EIA3 (ZUC based).
 
-    Document Reference: 35.206 v10.0.0 Annex 3
+    Document Reference: 33.401 v11.5.0 Annex B.2.4
+                        ETSI/SAGE 128-EEA3 & 128-EIA3 Specification
+                        v1.6 Section 4
 *********************************************************************/
-LIBLTE_ERROR_ENUM liblte_security_milenage_f1_star(uint8 *k,
-                                                   uint8 *rand,
-                                                   uint8 *sqn,
-                                                   uint8 *amf,
-                                                   uint8 *mac_s)
+LIBLTE_ERROR_ENUM liblte_security_128_eia3(uint8  *key,
+                                           uint32  count,
+                                           uint8   bearer,
+                                           uint8   direction,
+                                           uint8  *msg,
+                                           uint32  msg_len,
+                                           uint8  *mac)
 {
-    if(k == NULL || rand == NULL || sqn == NULL || amf == NULL || mac_s == NULL)
+    if(key == NULL || msg == NULL || mac == NULL)
         return LIBLTE_ERROR_INVALID_INPUTS;
 
-    // Initialize the round keys
-    ROUND_KEY_STRUCT round_keys;
-    rijndael_key_schedule(k, &round_keys);
+    zuc_eia3(key, count, bearer, direction, msg, msg_len*8, mac);
 
-    // Compute OPc
-    uint8 op_c[16];
-    compute_OPc(&round_keys, (uint8 *)OP, op_c);
+    return LIBLTE_SUCCESS;
+}
+LIBLTE_ERROR_ENUM liblte_security_128_eia3(uint8                 *key,
+                                           uint32                 count,
+                                           uint8                  bearer,
+                                           uint8                  direction,
+                                           LIBLTE_BIT_MSG_STRUCT *msg,
+                                           uint8                 *mac)
+{
+    uint8 packed[LIBLTE_MAX_MSG_SIZE];
 
-    // Compute temp
-    uint8 rijndael_input[16];
-    for(uint32 i=0; i<16; i++)
-        rijndael_input[i] = rand[i] ^ op_c[i];
-    uint8 temp[16];
-    rijndael_encrypt(rijndael_input, &round_keys, temp);
+    if(key == NULL || msg == NULL || mac == NULL)
+        return LIBLTE_ERROR_INVALID_INPUTS;
 
-    // Construct in1
-    uint8 in1[16];
-    for(uint32 i=0; i<6; i++)
+    pack_bits(msg, packed);
+    zuc_eia3(key, count, bearer, direction, packed, msg->N_bits, mac);
+
+    return LIBLTE_SUCCESS;
+}
+
+/*********************************************************************
+    Name: liblte_security_encryption_eea1
+
+    Description: 128-bit encryption algorithm EEA1 (SNOW 3G based).
+                 msg_len is in bytes.  Deciphering is the same
+                 operation.
+
+    Document Reference: 33.401 v10.0.0 Annex B.1.2
+                        35.215 v10.0.0 Section 3
+*********************************************************************/
+LIBLTE_ERROR_ENUM liblte_security_encryption_eea1(uint8  *key,
+                                                  uint32  count,
+                                                  uint8   bearer,
+                                                  uint8   direction,
+                                                  uint8  *msg,
+                                                  uint32  msg_len,
+                                                  uint8  *out)
+{
+    SNOW3G_STATE_STRUCT state;
+    uint32              k[4];
+    uint32              iv[4];
+
+    if(key == NULL || msg == NULL || out == NULL)
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    // 35.215 v10.0.0 Section 3.4
+    for(uint32 i=0; i<4; i++)
+        k[3-i] = load_be32(&key[i*4]);
+    iv[3] = count;
+    iv[2] = ((uint32)(bearer & 0x1F) << 27) | ((uint32)(direction & 0x01) << 26);
+    iv[1] = count;
+    iv[0] = iv[2];
+    snow3g_init(&state, k, iv);
+    snow3g_cipher(&state, msg, msg_len, out);
+
+    return LIBLTE_SUCCESS;
+}
+
+/*********************************************************************
+    Name: liblte_security_encryption_eea2
+
+    Description: 128-bit encryption algorithm EEA2 (AES-CTR based).
+                 msg_len is in bytes.  Deciphering is the same
+                 operation.
+
+    Document Reference: 33.401 v10.0.0 Annex B.1.3
+*********************************************************************/
+LIBLTE_ERROR_ENUM liblte_security_encryption_eea2(uint8  *key,
+                                                  uint32  count,
+                                                  uint8   bearer,
+                                                  uint8   direction,
+                                                  uint8  *msg,
+                                                  uint32  msg_len,
+                                                  uint8  *out)
+{
+    LIBLTE_SECURITY_CIPHER_JOB_STRUCT job;
+
+    job.msg       = msg;
+    job.out       = out;
+    job.msg_len   = msg_len;
+    job.count     = count;
+    job.bearer    = bearer;
+    job.direction = direction;
+
+    return liblte_security_encryption_batch(LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA2, key, &job, 1);
+}
+
+/*********************************************************************
+    Name: liblte_security_encryption_eea3
+
+    Description: 128-bit encryption algorithm EEA3 (ZUC based).
+                 msg_len is in bytes.  Deciphering is the same
+                 operation.
+
+    Document Reference: 33.401 v11.5.0 Annex B.1.4
+                        ETSI/SAGE 128-EEA3 & 128-EIA3 Specification
+                        v1.6 Section 3
+*********************************************************************/
+LIBLTE_ERROR_ENUM liblte_security_encryption_eea3(uint8  *key,
+                                                  uint32  count,
+                                                  uint8   bearer,
+                                                  uint8   direction,
+                                                  uint8  *msg,
+                                                  uint32  msg_len,
+                                                  uint8  *out)
+{
+    ZUC_STATE_STRUCT state;
+    uint8            iv[16];
+
+    if(key == NULL || msg == NULL || out == NULL)
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    // EEA3 specification v1.6 Section 3.3
+    store_be32(count, &iv[0]);
+    iv[4] = ((bearer & 0x1F) << 3) | ((direction & 0x01) << 2);
+    iv[5] = 0;
+    iv[6] = 0;
+    iv[7] = 0;
+    memcpy(&iv[8], &iv[0], 8);
+    zuc_init(&state, key, iv);
+    zuc_cipher(&state, msg, msg_len, out);
+
+    return LIBLTE_SUCCESS;
+}
+
+/*********************************************************************
+    Name: liblte_security_encryption_batch
+
+    Description: Ciphers or deciphers a batch of messages that share
+                 a key, e.g. every PDCP PDU of a radio bearer queued in
+                 one TTI.  The key schedule is computed once and, for
+                 EEA2, the counter blocks of all messages are run
+                 through AES together.  out may equal msg.
+
+    Document Reference: 33.401 v10.0.0 Annex B.1
+*********************************************************************/
+LIBLTE_ERROR_ENUM liblte_security_encryption_batch(LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_ENUM  alg,
+                                                   uint8                                       *key,
+                                                   LIBLTE_SECURITY_CIPHER_JOB_STRUCT           *jobs,
+                                                   uint32                                       N_jobs)
+{
+    LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT ks;
+    uint8                                   ctr[LIBLTE_SECURITY_BATCH_AES_BLOCKS][16];
+    uint8                                   ks_blocks[LIBLTE_SECURITY_BATCH_AES_BLOCKS][16];
+    uint32                                  first_job;
+    uint32                                  first_offset;
+    uint32                                  job;
+    uint32                                  offset;
+    uint32                                  N_blocks;
+
+    if(key == NULL || (jobs == NULL && N_jobs != 0))
+        return LIBLTE_ERROR_INVALID_INPUTS;
+    for(uint32 i=0; i<N_jobs; i++)
+        if(jobs[i].msg == NULL || jobs[i].out == NULL)
+            return LIBLTE_ERROR_INVALID_INPUTS;
+
+    switch(alg)
     {
-        in1[i]   = sqn[i];
-        in1[i+8] = sqn[i];
+    case LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_EEA0:
+        for(uint32 i=0; i<N_jobs; i++)
+            if(jobs[i].out != jobs[i].msg)
+                memmove(jobs[i].out, jobs[i].msg, jobs[i].msg_len);
+        break;
+    case LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA1:
+        for(uint32 i=0; i<N_jobs; i++)
+            liblte_security_encryption_eea1(key,
+                                            jobs[i].count,
+                                            jobs[i].bearer,
+                                            jobs[i].direction,
+                                            jobs[i].msg,
+                                            jobs[i].msg_len,
+                                            jobs[i].out);
+        break;
+    case LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA2:
+        liblte_security_aes_key_schedule(key, &ks);
+
+        // Fill the counter blocks of as many messages as fit, encrypt
+        // them together, then apply the keystream message by message
+        job    = 0;
+        offset = 0;
+        while(job < N_jobs)
+        {
+            first_job    = job;
+            first_offset = offset;
+            N_blocks     = 0;
+            while(job < N_jobs && N_blocks < LIBLTE_SECURITY_BATCH_AES_BLOCKS)
+            {
+                if(offset >= jobs[job].msg_len)
+                {
+                    job++;
+                    offset = 0;
+                    continue;
+                }
+                eea2_counter_block(&jobs[job], offset/16, ctr[N_blocks]);
+                N_blocks++;
+                offset += 16;
+            }
+            if(0 == N_blocks)
+                break;
+            aes_encrypt_blocks(&ks, ctr[0], ks_blocks[0], N_blocks);
+
+            job    = first_job;
+            offset = first_offset;
+            for(uint32 i=0; i<N_blocks; i++)
+            {
+                while(offset >= jobs[job].msg_len)
+                {
+                    job++;
+                    offset = 0;
+                }
+                for(uint32 j=0; j<16 && offset+j<jobs[job].msg_len; j++)
+                    jobs[job].out[offset+j] = jobs[job].msg[offset+j] ^ ks_blocks[i][j];
+                offset += 16;
+            }
+        }
+        break;
+    case LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA3:
+        for(uint32 i=0; i<N_jobs; i++)
+            liblte_security_encryption_eea3(key,
+                                            jobs[i].count,
+                                            jobs[i].bearer,
+                                            jobs[i].direction,
+                                            jobs[i].msg,
+                                            jobs[i].msg_len,
+                                            jobs[i].out);
+        break;
+    default:
+        return LIBLTE_ERROR_INVALID_INPUTS;
     }
-    for(uint32 i=0; i<2; i++)
+
+    return LIBLTE_SUCCESS;
+}
+
+/*********************************************************************
+    Name: liblte_security_aes_key_schedule
+
+    Description: Expands a 128-bit AES key into its round keys.  Uses
+                 AES-NI when the CPU supports it, otherwise a constant
+                 time software implementation.
+
+    Document Reference: FIPS 197
+*********************************************************************/
+LIBLTE_ERROR_ENUM liblte_security_aes_key_schedule(uint8                                   *key,
+                                                   LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT *ks)
+{
+    if(key == NULL || ks == NULL)
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    if(aes_ni_supported())
     {
-        in1[i+6]  = amf[i];
-        in1[i+14] = amf[i];
+        aes_ni_key_schedule(key, ks);
+    }else{
+        aes_ct_key_schedule(key, ks);
     }
 
-    // Compute out1
-    uint8 out1[16];
-    for(uint32 i=0; i<16; i++)
-        rijndael_input[(i+8) % 16] = in1[i] ^ op_c[i];
-    for(uint32 i=0; i<16; i++)
-        rijndael_input[i] ^= temp[i];
-    rijndael_encrypt(rijndael_input, &round_keys, out1);
+    return LIBLTE_SUCCESS;
+}
+
+/*********************************************************************
+    Name: liblte_security_aes_encrypt
+
+    Description: Encrypts a single 128-bit block with an expanded AES
+                 key.
+
+    Document Reference: FIPS 197
+*********************************************************************/
+LIBLTE_ERROR_ENUM liblte_security_aes_encrypt(LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT *ks,
+                                              uint8                                   *input,
+                                              uint8                                   *output)
+{
+    if(ks == NULL || input == NULL || output == NULL)
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    if(aes_ni_supported())
+    {
+        aes_ni_encrypt(ks, input, output);
+    }else{
+        aes_ct_encrypt(ks, input, output);
+    }
+
+    return LIBLTE_SUCCESS;
+}
+
+/*********************************************************************
+    Name: liblte_security_aes_hw_accelerated
+
+    Description: Reports whether the AES engine runs on AES-NI, so
+                 callers can prefer 128-EEA2 only when it is fast.
+
+    Document Reference: N/A
+*********************************************************************/
+bool liblte_security_aes_hw_accelerated(void)
+{
+    return aes_ni_supported();
+}
+
+/*********************************************************************
+    Name: liblte_security_milenage_key_init
+
+    Description: Precomputes the Rijndael round keys and OPc for a
+                 subscriber key K, so repeated Milenage calls for the
+                 same subscriber skip both.  A NULL OP selects the
+                 operator variant built into openLTE.
+
+    Document Reference: 35.206 v10.0.0 Annex 3
+*********************************************************************/
+LIBLTE_ERROR_ENUM liblte_security_milenage_key_init(uint8                               *k,
+                                                    uint8                               *op,
+                                                    LIBLTE_SECURITY_MILENAGE_KEY_STRUCT *key)
+{
+    if(k == NULL || key == NULL)
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    if(op == NULL)
+        op = (uint8 *)OP;
+
+    // Initialize the round keys
+    liblte_security_aes_key_schedule(k, &key->ks);
+
+    // Compute OPc
+    liblte_security_aes_encrypt(&key->ks, op, key->op_c);
     for(uint32 i=0; i<16; i++)
-        out1[i] ^= op_c[i];
+        key->op_c[i] ^= op[i];
+
+    return LIBLTE_SUCCESS;
+}
+
+/*********************************************************************
+    Name: liblte_security_milenage_f1
+
+    Description: Milenage security function F1.  Computes network
+                 authentication code MAC-A from key K, random
+                 challenge RAND, sequence number SQN, and
+                 authentication management field AMF.
+
+    Document Reference: 35.206 v10.0.0 Annex 3
+*********************************************************************/
+LIBLTE_ERROR_ENUM liblte_security_milenage_f1(uint8 *k,
+                                              uint8 *rand,
+                                              uint8 *sqn,
+                                              uint8 *amf,
+                                              uint8 *mac_a)
+{
+    LIBLTE_SECURITY_MILENAGE_KEY_STRUCT key;
+
+    if(k == NULL)
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    liblte_security_milenage_key_init(k, NULL, &key);
+    return liblte_security_milenage_f1(&key, rand, sqn, amf, mac_a);
+}
+LIBLTE_ERROR_ENUM liblte_security_milenage_f1(LIBLTE_SECURITY_MILENAGE_KEY_STRUCT *key,
+                                              uint8                               *rand,
+                                              uint8                               *sqn,
+                                              uint8                               *amf,
+                                              uint8                               *mac_a)
+{
+    uint8 out1[16];
+
+    if(key == NULL || rand == NULL || sqn == NULL || amf == NULL || mac_a == NULL)
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    milenage_out1(key, rand, sqn, amf, out1);
+
+    // Return MAC-A
+    for(uint32 i=0; i<8; i++)
+        mac_a[i] = out1[i];
+
+    return LIBLTE_SUCCESS;
+}
+
+/*********************************************************************
+    Name: liblte_security_milenage_f1_star
+
+    Description: Milenage security function F1*.  Computes resynch
+                 authentication code MAC-S from key K, random
+                 challenge RAND, sequence number SQN, and
+                 authentication management field AMF.
+
+    Document Reference: 35.206 v10.0.0 Annex 3
+*********************************************************************/
+LIBLTE_ERROR_ENUM liblte_security_milenage_f1_star(uint8 *k,
+                                                   uint8 *rand,
+                                                   uint8 *sqn,
+                                                   uint8 *amf,
+                                                   uint8 *mac_s)
+{
+    LIBLTE_SECURITY_MILENAGE_KEY_STRUCT key;
+
+    if(k == NULL)
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    liblte_security_milenage_key_init(k, NULL, &key);
+    return liblte_security_milenage_f1_star(&key, rand, sqn, amf, mac_s);
+}
+LIBLTE_ERROR_ENUM liblte_security_milenage_f1_star(LIBLTE_SECURITY_MILENAGE_KEY_STRUCT *key,
+                                                   uint8                               *rand,
+                                                   uint8                               *sqn,
+                                                   uint8                               *amf,
+                                                   uint8                               *mac_s)
+{
+    uint8 out1[16];
+
+    if(key == NULL || rand == NULL || sqn == NULL || amf == NULL || mac_s == NULL)
+        return LIBLTE_ERROR_INVALID_INPUTS;
+
+    milenage_out1(key, rand, sqn, amf, out1);
 
     // Return MAC-S
     for(uint32 i=0; i<8; i++)
@@ -735,32 +1452,31 @@ LIBLTE_ERROR_ENUM liblte_security_milenage_f2345(uint8 *k,
                                                  uint8 *ik,
                                                  uint8 *ak)
 {
-    if(k == NULL || rand == NULL || res == NULL || ck == NULL || ik == NULL || ak == NULL)
+    LIBLTE_SECURITY_MILENAGE_KEY_STRUCT key;
+
+    if(k == NULL)
         return LIBLTE_ERROR_INVALID_INPUTS;
 
-    // Initialize the round keys
-    ROUND_KEY_STRUCT round_keys;
-    rijndael_key_schedule(k, &round_keys);
+    liblte_security_milenage_key_init(k, NULL, &key);
+    return liblte_security_milenage_f2345(&key, rand, res, ck, ik, ak);
+}
+LIBLTE_ERROR_ENUM liblte_security_milenage_f2345(LIBLTE_SECURITY_MILENAGE_KEY_STRUCT *key,
+                                                 uint8                               *rand,
+                                                 uint8                               *res,
+                                                 uint8                               *ck,
+                                                 uint8                               *ik,
+                                                 uint8                               *ak)
+{
+    uint8 temp[16];
+    uint8 out[16];
 
-    // Compute OPc
-    uint8 op_c[16];
-    compute_OPc(&round_keys, (uint8 *)OP, op_c);
+    if(key == NULL || rand == NULL || res == NULL || ck == NULL || ik == NULL || ak == NULL)
+        return LIBLTE_ERROR_INVALID_INPUTS;
 
-    // Compute temp
-    uint8 rijndael_input[16];
-    for(uint32 i=0; i<16; i++)
-        rijndael_input[i] = rand[i] ^ op_c[i];
-    uint8 temp[16];
-    rijndael_encrypt(rijndael_input, &round_keys, temp);
+    milenage_temp(key, rand, temp);
 
     // Compute out for RES and AK
-    uint8 out[16];
-    for(uint32 i=0; i<16; i++)
-        rijndael_input[i] = temp[i] ^ op_c[i];
-    rijndael_input[15] ^= 1;
-    rijndael_encrypt(rijndael_input, &round_keys, out);
-    for(uint32 i=0; i<16; i++)
-        out[i] ^= op_c[i];
+    milenage_out(key, temp, 0, 1, out);
 
     // Return RES
     for(uint32 i=0; i<8; i++)
@@ -770,29 +1486,11 @@ LIBLTE_ERROR_ENUM liblte_security_milenage_f2345(uint8 *k,
     for(uint32 i=0; i<6; i++)
         ak[i] = out[i];
 
-    // Compute out for CK
-    for(uint32 i=0; i<16; i++)
-        rijndael_input[(i+12) % 16] = temp[i] ^ op_c[i];
-    rijndael_input[15] ^= 2;
-    rijndael_encrypt(rijndael_input, &round_keys, out);
-    for(uint32 i=0; i<16; i++)
-        out[i] ^= op_c[i];
-
-    // Return CK
-    for(uint32 i=0; i<16; i++)
-        ck[i] = out[i];
-
-    // Compute out for IK
-    for(uint32 i=0; i<16; i++)
-        rijndael_input[(i+8) % 16] = temp[i] ^ op_c[i];
-    rijndael_input[15] ^= 4;
-    rijndael_encrypt(rijndael_input, &round_keys, out);
-    for(uint32 i=0; i<16; i++)
-        out[i] ^= op_c[i];
+    // Compute out for CK and return CK
+    milenage_out(key, temp, 12, 2, ck);
 
-    // Return IK
-    for(uint32 i=0; i<16; i++)
-        ik[i] = out[i];
+    // Compute out for IK and return IK
+    milenage_out(key, temp, 8, 4, ik);
 
     return LIBLTE_SUCCESS;
 }
@@ -810,32 +1508,28 @@ LIBLTE_ERROR_ENUM liblte_security_milenage_f5_star(uint8 *k,
                                                    uint8 *rand,
                                                    uint8 *ak)
 {
-    if(k == NULL || rand == NULL || ak == NULL)
+    LIBLTE_SECURITY_MILENAGE_KEY_STRUCT key;
+
+    if(k == NULL)
         return LIBLTE_ERROR_INVALID_INPUTS;
 
-    // Initialize the round keys
-    ROUND_KEY_STRUCT round_keys;
-    rijndael_key_schedule(k, &round_keys);
+    liblte_security_milenage_key_init(k, NULL, &key);
+    return liblte_security_milenage_f5_star(&key, rand, ak);
+}
+LIBLTE_ERROR_ENUM liblte_security_milenage_f5_star(LIBLTE_SECURITY_MILENAGE_KEY_STRUCT *key,
+                                                   uint8                               *rand,
+                                                   uint8                               *ak)
+{
+    uint8 temp[16];
+    uint8 out[16];
 
-    // Compute OPc
-    uint8 op_c[16];
-    compute_OPc(&round_keys, (uint8 *)OP, op_c);
+    if(key == NULL || rand == NULL || ak == NULL)
+        return LIBLTE_ERROR_INVALID_INPUTS;
 
-    // Compute temp
-    uint8 rijndael_input[16];
-    for(uint32 i=0; i<16; i++)
-        rijndael_input[i] = rand[i] ^ op_c[i];
-    uint8 temp[16];
-    rijndael_encrypt(rijndael_input, &round_keys, temp);
+    milenage_temp(key, rand, temp);
 
     // Compute out
-    uint8 out[16];
-    for(uint32 i=0; i<16; i++)
-        rijndael_input[(i+4) % 16] = temp[i] ^ op_c[i];
-    rijndael_input[15] ^= 8;
-    rijndael_encrypt(rijndael_input, &round_keys, out);
-    for(uint32 i=0; i<16; i++)
-        out[i] ^= op_c[i];
+    milenage_out(key, temp, 4, 8, out);
 
     // Return AK
     for(uint32 i=0; i<6; i++)
@@ -848,200 +1542,1272 @@ LIBLTE_ERROR_ENUM liblte_security_milenage_f5_star(uint8 *k,
                               LOCAL FUNCTIONS
 *******************************************************************************/
 
+#if LIBLTE_SECURITY_HAVE_AES_NI
 /*********************************************************************
-    Name: compute_OPc
+    Name: aes_ni_supported
 
-    Description: Computes OPc from OP and K.
+    Description: Checks whether the CPU supports the AES-NI
+                 instructions.
 
-    Document Reference: 35.206 v10.0.0 Annex 3
+    Document Reference: N/A
 *********************************************************************/
-void compute_OPc(ROUND_KEY_STRUCT *rk,
-                 uint8            *op,
-                 uint8            *op_c)
+bool aes_ni_supported(void)
 {
-    if(rk == NULL || op == NULL || op_c == NULL)
-        return;
+    static const bool supported = __builtin_cpu_supports("aes");
 
-    rijndael_encrypt(op, rk, op_c);
-    for(uint32 i=0; i<16; i++)
-        op_c[i] ^= op[i];
+    return supported;
 }
 
 /*********************************************************************
-    Name: rijndael_key_schedule
+    Name: aes_ni_key_schedule
 
-    Description: Computes all Rijndael's internal subkeys from key.
+    Description: Computes all AES round keys from key using AES-NI.
 
-    Document Reference: 35.206 v10.0.0 Annex 3
+    Document Reference: FIPS 197
 *********************************************************************/
-void rijndael_key_schedule(uint8            *key,
-                           ROUND_KEY_STRUCT *rk)
+__attribute__((target("aes,sse2")))
+static inline __m128i aes_ni_expand_key(__m128i key,
+                                        __m128i assist)
 {
-    if(key == NULL || rk == NULL)
-        return;
-
-    // Set first round key to key
-    for(uint32 i=0; i<16; i++)
-        rk->rk[0][i & 0x03][i >> 2] = key[i];
+    assist = _mm_shuffle_epi32(assist, 0xFF);
+    key    = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key    = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key    = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, assist);
+}
+#define AES_NI_EXPAND_ROUND(r, rcon)                                          \
+    rk = aes_ni_expand_key(rk, _mm_aeskeygenassist_si128(rk, rcon));          \
+    _mm_storeu_si128((__m128i *)ks->rk[r], rk)
+__attribute__((target("aes,sse2")))
+void aes_ni_key_schedule(uint8                                   *key,
+                         LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT *ks)
+{
+    __m128i rk = _mm_loadu_si128((const __m128i *)key);
+
+    _mm_storeu_si128((__m128i *)ks->rk[0], rk);
+    AES_NI_EXPAND_ROUND(1,  0x01);
+    AES_NI_EXPAND_ROUND(2,  0x02);
+    AES_NI_EXPAND_ROUND(3,  0x04);
+    AES_NI_EXPAND_ROUND(4,  0x08);
+    AES_NI_EXPAND_ROUND(5,  0x10);
+    AES_NI_EXPAND_ROUND(6,  0x20);
+    AES_NI_EXPAND_ROUND(7,  0x40);
+    AES_NI_EXPAND_ROUND(8,  0x80);
+    AES_NI_EXPAND_ROUND(9,  0x1B);
+    AES_NI_EXPAND_ROUND(10, 0x36);
+}
+#undef AES_NI_EXPAND_ROUND
 
-    uint8 round_const = 1;
+/*********************************************************************
+    Name: aes_ni_encrypt
 
-    // Compute the remaining round keys
-    for(uint32 i=1; i<11; i++)
-    {
-        rk->rk[i][0][0] = S[rk->rk[i-1][1][3]] ^ rk->rk[i-1][0][0] ^ round_const;
-        rk->rk[i][1][0] = S[rk->rk[i-1][2][3]] ^ rk->rk[i-1][1][0];
-        rk->rk[i][2][0] = S[rk->rk[i-1][3][3]] ^ rk->rk[i-1][2][0];
-        rk->rk[i][3][0] = S[rk->rk[i-1][0][3]] ^ rk->rk[i-1][3][0];
+    Description: Computes output using input and round keys using
+                 AES-NI.
 
-        for(uint32 j=0; j<4; j++)
-        {
-            rk->rk[i][j][1] = rk->rk[i-1][j][1] ^ rk->rk[i][j][0];
-            rk->rk[i][j][2] = rk->rk[i-1][j][2] ^ rk->rk[i][j][1];
-            rk->rk[i][j][3] = rk->rk[i-1][j][3] ^ rk->rk[i][j][2];
-        }
+    Document Reference: FIPS 197
+*********************************************************************/
+__attribute__((target("aes,sse2")))
+void aes_ni_encrypt(LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT *ks,
+                    uint8                                   *input,
+                    uint8                                   *output)
+{
+    __m128i state = _mm_loadu_si128((const __m128i *)input);
 
-        round_const = X_TIME[round_const];
-    }
+    state = _mm_xor_si128(state, _mm_loadu_si128((const __m128i *)ks->rk[0]));
+    for(uint32 r=1; r<10; r++)
+        state = _mm_aesenc_si128(state, _mm_loadu_si128((const __m128i *)ks->rk[r]));
+    state = _mm_aesenclast_si128(state, _mm_loadu_si128((const __m128i *)ks->rk[10]));
+    _mm_storeu_si128((__m128i *)output, state);
 }
 
 /*********************************************************************
-    Name: rijndael_encrypt
+    Name: aes_ni_encrypt_blocks
 
-    Description: Computes output using input and round keys.
+    Description: Computes N_blocks independent output blocks using
+                 AES-NI, keeping four blocks in flight to hide the
+                 AESENC latency.
 
-    Document Reference: 35.206 v10.0.0 Annex 3
+    Document Reference: FIPS 197
 *********************************************************************/
-void rijndael_encrypt(uint8            *input,
-                      ROUND_KEY_STRUCT *rk,
-                      uint8            *output)
+__attribute__((target("aes,sse2")))
+void aes_ni_encrypt_blocks(LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT *ks,
+                           uint8                                   *input,
+                           uint8                                   *output,
+                           uint32                                   N_blocks)
 {
-    if(input == NULL || rk == NULL || output == NULL)
-        return;
+    __m128i rk[11];
+    __m128i s0;
+    __m128i s1;
+    __m128i s2;
+    __m128i s3;
+    uint32  i = 0;
 
-    // Initialize and perform round 0
-    STATE_STRUCT state;
-    for(uint32 i=0; i<16; i++)
-        state.state[i & 0x03][i >> 2] = input[i];
-    key_add(&state, rk, 0);
+    for(uint32 r=0; r<11; r++)
+        rk[r] = _mm_loadu_si128((const __m128i *)ks->rk[r]);
 
-    // Perform rounds 1 through 9
-    for(uint32 r=1; r<=9; r++)
+    for(; i+4<=N_blocks; i+=4)
     {
-        byte_sub(&state);
-        shift_row(&state);
-        mix_column(&state);
-        key_add(&state, rk, r);
+        s0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)&input[(i+0)*16]), rk[0]);
+        s1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)&input[(i+1)*16]), rk[0]);
+        s2 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)&input[(i+2)*16]), rk[0]);
+        s3 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)&input[(i+3)*16]), rk[0]);
+        for(uint32 r=1; r<10; r++)
+        {
+            s0 = _mm_aesenc_si128(s0, rk[r]);
+            s1 = _mm_aesenc_si128(s1, rk[r]);
+            s2 = _mm_aesenc_si128(s2, rk[r]);
+            s3 = _mm_aesenc_si128(s3, rk[r]);
+        }
+        _mm_storeu_si128((__m128i *)&output[(i+0)*16], _mm_aesenclast_si128(s0, rk[10]));
+        _mm_storeu_si128((__m128i *)&output[(i+1)*16], _mm_aesenclast_si128(s1, rk[10]));
+        _mm_storeu_si128((__m128i *)&output[(i+2)*16], _mm_aesenclast_si128(s2, rk[10]));
+        _mm_storeu_si128((__m128i *)&output[(i+3)*16], _mm_aesenclast_si128(s3, rk[10]));
     }
-
-    // Perform round 10
-    byte_sub(&state);
-    shift_row(&state);
-    key_add(&state, rk, 10);
-
-    // Return output
-    for(uint32 i=0; i<16; i++)
-        output[i] = state.state[i & 0x03][i >> 2];
+    for(; i<N_blocks; i++)
+        aes_ni_encrypt(ks, &input[i*16], &output[i*16]);
+}
+#else
+bool aes_ni_supported(void)
+{
+    return false;
+}
+void aes_ni_key_schedule(uint8                                   *key,
+                         LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT *ks)
+{
+}
+void aes_ni_encrypt(LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT *ks,
+                    uint8                                   *input,
+                    uint8                                   *output)
+{
+}
+void aes_ni_encrypt_blocks(LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT *ks,
+                           uint8                                   *input,
+                           uint8                                   *output,
+                           uint32                                   N_blocks)
+{
 }
+#endif /* LIBLTE_SECURITY_HAVE_AES_NI */
 
 /*********************************************************************
-    Name: key_add
+    Name: aes_ct_sub_bytes
 
-    Description: Round key addition function.
+    Description: Byte substitution of 8 packed bytes without table
+                 lookups, so the timing does not depend on the data.
+                 The inverse is computed as x^254 in GF(2^8) followed
+                 by the affine transformation.
 
-    Document Reference: 35.206 v10.0.0 Annex 3
+    Document Reference: FIPS 197 Section 5.1.1
 *********************************************************************/
-void key_add(STATE_STRUCT     *state,
-             ROUND_KEY_STRUCT *rk,
-             uint32            round)
+static inline uint64 aes_ct_xtime(uint64 x)
 {
-    if(state == NULL || rk == NULL)
-        return;
-
-    for(uint32 i=0; i<4; i++)
-        for(uint32 j=0; j<4; j++)
-            state->state[i][j] ^= rk->rk[round][i][j];
+    return(((x & 0x7F7F7F7F7F7F7F7FULL) << 1) ^
+           (((x >> 7) & AES_CT_LSB_MASK) * 0x1B));
 }
+static inline uint64 aes_ct_gf_mult(uint64 a,
+                                    uint64 b)
+{
+    uint64 p = 0;
 
-/*********************************************************************
-    Name: byte_sub
+    for(uint32 i=0; i<8; i++)
+    {
+        p ^= a & (((b >> i) & AES_CT_LSB_MASK) * 0xFF);
+        a  = aes_ct_xtime(a);
+    }
 
-    Description: Byte substitution transformation.
+    return p;
+}
+static inline uint64 aes_ct_rotl(uint64 x,
+                                 uint32 n)
+{
+    return(((x << n)     & (((0xFF << n) & 0xFF) * AES_CT_LSB_MASK)) |
+           ((x >> (8-n)) & (((1 << n) - 1)       * AES_CT_LSB_MASK)));
+}
+uint64 aes_ct_sub_bytes(uint64 x)
+{
+    // Multiplicative inverse, x^254 = x^240 * x^12 * x^2
+    uint64 x2   = aes_ct_gf_mult(x, x);
+    uint64 x3   = aes_ct_gf_mult(x2, x);
+    uint64 x12  = aes_ct_gf_mult(x3, x3);
+    x12         = aes_ct_gf_mult(x12, x12);
+    uint64 x15  = aes_ct_gf_mult(x12, x3);
+    uint64 x240 = aes_ct_gf_mult(x15, x15);
+    x240        = aes_ct_gf_mult(x240, x240);
+    x240        = aes_ct_gf_mult(x240, x240);
+    x240        = aes_ct_gf_mult(x240, x240);
+    uint64 inv  = aes_ct_gf_mult(aes_ct_gf_mult(x240, x12), x2);
+
+    // Affine transformation
+    return(inv                ^
+           aes_ct_rotl(inv, 1) ^
+           aes_ct_rotl(inv, 2) ^
+           aes_ct_rotl(inv, 3) ^
+           aes_ct_rotl(inv, 4) ^
+           (0x63 * AES_CT_LSB_MASK));
+}
 
-    Document Reference: 35.206 v10.0.0 Annex 3
+/*********************************************************************
+    Name: aes_ct_key_schedule
+
+    Description: Computes all AES round keys from key in constant
+                 time.
+
+    Document Reference: FIPS 197 Section 5.2
 *********************************************************************/
-void byte_sub(STATE_STRUCT *state)
+void aes_ct_key_schedule(uint8                                   *key,
+                         LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT *ks)
 {
-    if(state == NULL)
-        return;
+    uint64 word;
 
-    for(uint32 i=0; i<4; i++)
-        for(uint32 j=0; j<4; j++)
-            state->state[i][j] = S[state->state[i][j]];
+    memcpy(ks->rk[0], key, 16);
+    for(uint32 r=1; r<11; r++)
+    {
+        // SubWord(RotWord(w[i-1])) ^ Rcon
+        word = ((uint64)ks->rk[r-1][13]      ) |
+               ((uint64)ks->rk[r-1][14] <<  8) |
+               ((uint64)ks->rk[r-1][15] << 16) |
+               ((uint64)ks->rk[r-1][12] << 24);
+        word = aes_ct_sub_bytes(word);
+        ks->rk[r][0] = ks->rk[r-1][0] ^ (word & 0xFF) ^ RCON[r-1];
+        ks->rk[r][1] = ks->rk[r-1][1] ^ ((word >> 8) & 0xFF);
+        ks->rk[r][2] = ks->rk[r-1][2] ^ ((word >> 16) & 0xFF);
+        ks->rk[r][3] = ks->rk[r-1][3] ^ ((word >> 24) & 0xFF);
+        for(uint32 i=4; i<16; i++)
+            ks->rk[r][i] = ks->rk[r-1][i] ^ ks->rk[r][i-4];
+    }
 }
 
 /*********************************************************************
-    Name: shift_row
+    Name: aes_ct_encrypt
 
-    Description: Row shift transformation.
+    Description: Computes output using input and round keys in
+                 constant time.
 
-    Document Reference: 35.206 v10.0.0 Annex 3
+    Document Reference: FIPS 197 Section 5.1
 *********************************************************************/
-void shift_row(STATE_STRUCT *state)
+void aes_ct_encrypt(LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT *ks,
+                    uint8                                   *input,
+                    uint8                                   *output)
 {
-    if(state == NULL)
-        return;
+    uint64 packed[2];
+    uint32 col;
+    uint32 rot1;
+    uint32 rot2;
+    uint32 rot3;
+    uint8  state[16];
+    uint8  tmp[16];
 
-    // Left rotate row 1 by 1
-    uint8 temp         = state->state[1][0];
-    state->state[1][0] = state->state[1][1];
-    state->state[1][1] = state->state[1][2];
-    state->state[1][2] = state->state[1][3];
-    state->state[1][3] = temp;
+    for(uint32 i=0; i<16; i++)
+        state[i] = input[i] ^ ks->rk[0][i];
 
-    // Left rotate row 2 by 2
-    temp               = state->state[2][0];
-    state->state[2][0] = state->state[2][2];
-    state->state[2][2] = temp;
-    temp               = state->state[2][1];
-    state->state[2][1] = state->state[2][3];
-    state->state[2][3] = temp;
+    for(uint32 r=1; r<11; r++)
+    {
+        // SubBytes
+        memcpy(packed, state, 16);
+        packed[0] = aes_ct_sub_bytes(packed[0]);
+        packed[1] = aes_ct_sub_bytes(packed[1]);
+        memcpy(tmp, packed, 16);
+
+        // ShiftRows, row j of column c comes from column c+j
+        for(uint32 c=0; c<4; c++)
+            for(uint32 j=0; j<4; j++)
+                state[c*4 + j] = tmp[((c+j) % 4)*4 + j];
+
+        // MixColumns, 2*b[i] ^ 3*b[i+1] ^ b[i+2] ^ b[i+3]
+        if(r != 10)
+        {
+            for(uint32 c=0; c<4; c++)
+            {
+                col  = ((uint32)state[c*4+0]      ) |
+                       ((uint32)state[c*4+1] <<  8) |
+                       ((uint32)state[c*4+2] << 16) |
+                       ((uint32)state[c*4+3] << 24);
+                rot1 = (col >>  8) | (col << 24);
+                rot2 = (col >> 16) | (col << 16);
+                rot3 = (col >> 24) | (col <<  8);
+                col  = (uint32)aes_ct_xtime(col ^ rot1) ^ rot1 ^ rot2 ^ rot3;
+                state[c*4+0] = col & 0xFF;
+                state[c*4+1] = (col >> 8) & 0xFF;
+                state[c*4+2] = (col >> 16) & 0xFF;
+                state[c*4+3] = (col >> 24) & 0xFF;
+            }
+        }
 
-    // Left rotate row 3 by 3
-    temp               = state->state[3][0];
-    state->state[3][0] = state->state[3][3];
-    state->state[3][3] = state->state[3][2];
-    state->state[3][2] = state->state[3][1];
-    state->state[3][1] = temp;
+        // AddRoundKey
+        for(uint32 i=0; i<16; i++)
+            state[i] ^= ks->rk[r][i];
+    }
+
+    memcpy(output, state, 16);
 }
 
 /*********************************************************************
-    Name: mix_column
+    Name: aes_bs_encrypt_blocks
 
-    Description: Mix column transformation.
+    Description: Computes N_blocks independent output blocks with a
+                 bitsliced AES, AES_BS_N_BLOCKS at a time.  No table
+                 lookups or branches depend on the data, so it is
+                 constant time like aes_ct_encrypt, but much faster.
 
-    Document Reference: 35.206 v10.0.0 Annex 3
+    Document Reference: FIPS 197 Section 5.1
 *********************************************************************/
-void mix_column(STATE_STRUCT *state)
+// Slice q[k] holds bit k of the 64 bytes, byte i of the chunk in bit
+// i, so each block is a 16 bit lane with state row r of column c in
+// bit 4*c + r.  Transposing each 8 byte group as an 8x8 bit matrix
+// converts both ways.
+static inline uint64 aes_bs_transpose8(uint64 x)
+{
+    uint64 t;
+
+    t = (x ^ (x >>  7)) & 0x00AA00AA00AA00AAULL;
+    x = x ^ t ^ (t <<  7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+    x = x ^ t ^ (t << 28);
+
+    return x;
+}
+static void aes_bs_load(uint8  *in,
+                        uint64 *q)
 {
-    if(state == NULL)
-        return;
+    uint64 x;
+
+    for(uint32 k=0; k<8; k++)
+        q[k] = 0;
+    for(uint32 g=0; g<8; g++)
+    {
+        memcpy(&x, &in[g*8], 8);
+        x = aes_bs_transpose8(x);
+        for(uint32 k=0; k<8; k++)
+            q[k] |= ((x >> (k*8)) & 0xFF) << (g*8);
+    }
+}
+static void aes_bs_store(uint64 *q,
+                         uint8  *out)
+{
+    uint64 x;
+
+    for(uint32 g=0; g<8; g++)
+    {
+        x = 0;
+        for(uint32 k=0; k<8; k++)
+            x |= ((q[k] >> (g*8)) & 0xFF) << (k*8);
+        x = aes_bs_transpose8(x);
+        memcpy(&out[g*8], &x, 8);
+    }
+}
+// Boyar-Peralta S-box circuit, 113 gates, on all 64 bytes at once
+static void aes_bs_sub_bytes(uint64 *q)
+{
+    uint64 x0, x1, x2, x3, x4, x5, x6, x7;
+    uint64 y1, y2, y3, y4, y5, y6, y7, y8, y9, y10, y11;
+    uint64 y12, y13, y14, y15, y16, y17, y18, y19, y20, y21;
+    uint64 z0, z1, z2, z3, z4, z5, z6, z7, z8, z9, z10, z11;
+    uint64 z12, z13, z14, z15, z16, z17;
+    uint64 t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11;
+    uint64 t12, t13, t14, t15, t16, t17, t18, t19, t20, t21;
+    uint64 t22, t23, t24, t25, t26, t27, t28, t29, t30, t31;
+    uint64 t32, t33, t34, t35, t36, t37, t38, t39, t40, t41;
+    uint64 t42, t43, t44, t45, t46, t47, t48, t49, t50, t51;
+    uint64 t52, t53, t54, t55, t56, t57, t58, t59, t60, t61;
+    uint64 t62, t63, t64, t65, t66, t67;
+    uint64 s0, s1, s2, s3, s4, s5, s6, s7;
+
+    // The circuit numbers bits from the most significant
+    x0 = q[7];
+    x1 = q[6];
+    x2 = q[5];
+    x3 = q[4];
+    x4 = q[3];
+    x5 = q[2];
+    x6 = q[1];
+    x7 = q[0];
+
+    // Top linear transformation
+    y14 = x3 ^ x5;
+    y13 = x0 ^ x6;
+    y9  = x0 ^ x3;
+    y8  = x0 ^ x5;
+    t0  = x1 ^ x2;
+    y1  = t0 ^ x7;
+    y4  = y1 ^ x3;
+    y12 = y13 ^ y14;
+    y2  = y1 ^ x0;
+    y5  = y1 ^ x6;
+    y3  = y5 ^ y8;
+    t1  = x4 ^ y12;
+    y15 = t1 ^ x5;
+    y20 = t1 ^ x1;
+    y6  = y15 ^ x7;
+    y10 = y15 ^ t0;
+    y11 = y20 ^ y9;
+    y7  = x7 ^ y11;
+    y17 = y10 ^ y11;
+    y19 = y10 ^ y8;
+    y16 = t0 ^ y11;
+    y21 = y13 ^ y16;
+    y18 = x0 ^ y16;
+
+    // Inversion in GF(2^8)
+    t2  = y12 & y15;
+    t3  = y3 & y6;
+    t4  = t3 ^ t2;
+    t5  = y4 & x7;
+    t6  = t5 ^ t2;
+    t7  = y13 & y16;
+    t8  = y5 & y1;
+    t9  = t8 ^ t7;
+    t10 = y2 & y7;
+    t11 = t10 ^ t7;
+    t12 = y9 & y11;
+    t13 = y14 & y17;
+    t14 = t13 ^ t12;
+    t15 = y8 & y10;
+    t16 = t15 ^ t12;
+    t17 = t4 ^ t14;
+    t18 = t6 ^ t16;
+    t19 = t9 ^ t14;
+    t20 = t11 ^ t16;
+    t21 = t17 ^ y20;
+    t22 = t18 ^ y19;
+    t23 = t19 ^ y21;
+    t24 = t20 ^ y18;
+
+    t25 = t21 ^ t22;
+    t26 = t21 & t23;
+    t27 = t24 ^ t26;
+    t28 = t25 & t27;
+    t29 = t28 ^ t22;
+    t30 = t23 ^ t24;
+    t31 = t22 ^ t26;
+    t32 = t31 & t30;
+    t33 = t32 ^ t24;
+    t34 = t23 ^ t33;
+    t35 = t27 ^ t33;
+    t36 = t24 & t35;
+    t37 = t36 ^ t34;
+    t38 = t27 ^ t36;
+    t39 = t29 & t38;
+    t40 = t25 ^ t39;
+
+    t41 = t40 ^ t37;
+    t42 = t29 ^ t33;
+    t43 = t29 ^ t40;
+    t44 = t33 ^ t37;
+    t45 = t42 ^ t41;
+    z0  = t44 & y15;
+    z1  = t37 & y6;
+    z2  = t33 & x7;
+    z3  = t43 & y16;
+    z4  = t40 & y1;
+    z5  = t29 & y7;
+    z6  = t42 & y11;
+    z7  = t45 & y17;
+    z8  = t41 & y10;
+    z9  = t44 & y12;
+    z10 = t37 & y3;
+    z11 = t33 & y4;
+    z12 = t43 & y13;
+    z13 = t40 & y5;
+    z14 = t29 & y2;
+    z15 = t42 & y9;
+    z16 = t45 & y14;
+    z17 = t41 & y8;
+
+    // Bottom linear transformation, including the affine constant
+    t46 = z15 ^ z16;
+    t47 = z10 ^ z11;
+    t48 = z5 ^ z13;
+    t49 = z9 ^ z10;
+    t50 = z2 ^ z12;
+    t51 = z2 ^ z5;
+    t52 = z7 ^ z8;
+    t53 = z0 ^ z3;
+    t54 = z6 ^ z7;
+    t55 = z16 ^ z17;
+    t56 = z12 ^ t48;
+    t57 = t50 ^ t53;
+    t58 = z4 ^ t46;
+    t59 = z3 ^ t54;
+    t60 = t46 ^ t57;
+    t61 = z14 ^ t57;
+    t62 = t52 ^ t58;
+    t63 = t49 ^ t58;
+    t64 = z4 ^ t59;
+    t65 = t61 ^ t62;
+    t66 = z1 ^ t63;
+    s0  = t59 ^ t63;
+    s6  = t56 ^ ~t62;
+    s7  = t48 ^ ~t60;
+    t67 = t64 ^ t65;
+    s3  = t53 ^ t66;
+    s4  = t51 ^ t66;
+    s5  = t47 ^ t65;
+    s1  = t64 ^ ~s3;
+    s2  = t55 ^ ~t67;
+
+    q[7] = s0;
+    q[6] = s1;
+    q[5] = s2;
+    q[4] = s3;
+    q[3] = s4;
+    q[2] = s5;
+    q[1] = s6;
+    q[0] = s7;
+}
+// Row r of column c comes from column c+r
+static void aes_bs_shift_rows(uint64 *q)
+{
+    uint64 x;
+
+    for(uint32 k=0; k<8; k++)
+    {
+        x    = q[k];
+        q[k] = ( x        & (0x1111 * AES_BS_LANE_MASK)) |
+               ((x >>  4) & (0x0222 * AES_BS_LANE_MASK)) |
+               ((x << 12) & (0x2000 * AES_BS_LANE_MASK)) |
+               ((x >>  8) & (0x0044 * AES_BS_LANE_MASK)) |
+               ((x <<  8) & (0x4400 * AES_BS_LANE_MASK)) |
+               ((x >> 12) & (0x0008 * AES_BS_LANE_MASK)) |
+               ((x <<  4) & (0x8880 * AES_BS_LANE_MASK));
+    }
+}
+// Moves row r+n of every column to row r
+static inline uint64 aes_bs_rotate_rows(uint64 x,
+                                        uint32 n)
+{
+    return(((x >> n)     & (((0xF >> n) * 0x1111)         * AES_BS_LANE_MASK)) |
+           ((x << (4-n)) & ((((0xF << (4-n)) & 0xF) * 0x1111) * AES_BS_LANE_MASK)));
+}
+// 2*a[r] ^ 3*a[r+1] ^ a[r+2] ^ a[r+3], the multiply by 2 moves each
+// slice up one bit and folds bit 7 back in with 0x1B
+static void aes_bs_mix_columns(uint64 *q)
+{
+    uint64 a1[8];
+    uint64 t[8];
+    uint64 rest;
+
+    for(uint32 k=0; k<8; k++)
+    {
+        a1[k] = aes_bs_rotate_rows(q[k], 1);
+        t[k]  = q[k] ^ a1[k];
+    }
+    for(uint32 k=0; k<8; k++)
+    {
+        rest = a1[k] ^ aes_bs_rotate_rows(q[k], 2) ^ aes_bs_rotate_rows(q[k], 3);
+        q[k] = rest ^ ((0 == k) ? t[7] : t[k-1]);
+    }
+    q[1] ^= t[7];
+    q[3] ^= t[7];
+    q[4] ^= t[7];
+}
+void aes_bs_encrypt_blocks(LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT *ks,
+                           uint8                                   *input,
+                           uint8                                   *output,
+                           uint32                                   N_blocks)
+{
+    uint64 rk[11][8];
+    uint64 q[8];
+    uint8  chunk[AES_BS_N_BLOCKS*16];
+    uint32 N;
+
+    // Every block lane uses the same round keys
+    for(uint32 r=0; r<11; r++)
+    {
+        for(uint32 i=0; i<AES_BS_N_BLOCKS; i++)
+            memcpy(&chunk[i*16], ks->rk[r], 16);
+        aes_bs_load(chunk, rk[r]);
+    }
+
+    for(uint32 b=0; b<N_blocks; b+=AES_BS_N_BLOCKS)
+    {
+        N = N_blocks - b;
+        if(N > AES_BS_N_BLOCKS)
+            N = AES_BS_N_BLOCKS;
+        memset(chunk, 0, sizeof(chunk));
+        memcpy(chunk, &input[b*16], N*16);
+        aes_bs_load(chunk, q);
+
+        for(uint32 k=0; k<8; k++)
+            q[k] ^= rk[0][k];
+        for(uint32 r=1; r<11; r++)
+        {
+            aes_bs_sub_bytes(q);
+            aes_bs_shift_rows(q);
+            if(r != 10)
+                aes_bs_mix_columns(q);
+            for(uint32 k=0; k<8; k++)
+                q[k] ^= rk[r][k];
+        }
+
+        aes_bs_store(q, chunk);
+        memcpy(&output[b*16], chunk, N*16);
+    }
+}
+
+/*********************************************************************
+    Name: aes_encrypt_blocks
+
+    Description: Computes N_blocks independent output blocks with the
+                 fastest available AES implementation.
+
+    Document Reference: FIPS 197
+*********************************************************************/
+void aes_encrypt_blocks(LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT *ks,
+                        uint8                                   *input,
+                        uint8                                   *output,
+                        uint32                                   N_blocks)
+{
+    if(aes_ni_supported())
+    {
+        aes_ni_encrypt_blocks(ks, input, output, N_blocks);
+    }else{
+        aes_bs_encrypt_blocks(ks, input, output, N_blocks);
+    }
+}
+
+/*********************************************************************
+    Name: eea2_counter_block
+
+    Description: Builds counter block T_(block+1) for 128-EEA2.
+
+    Document Reference: 33.401 v10.0.0 Annex B.1.3
+*********************************************************************/
+void eea2_counter_block(LIBLTE_SECURITY_CIPHER_JOB_STRUCT *job,
+                        uint32                             block,
+                        uint8                             *ctr)
+{
+    // T1 = COUNT || BEARER || DIRECTION || 0^26 || 0^64, the low 64
+    // bits then count blocks
+    store_be32(job->count, &ctr[0]);
+    ctr[4] = ((job->bearer & 0x1F) << 3) | ((job->direction & 0x01) << 2);
+    ctr[5] = 0;
+    ctr[6] = 0;
+    ctr[7] = 0;
+    store_be32(0,     &ctr[8]);
+    store_be32(block, &ctr[12]);
+}
+
+/*********************************************************************
+    Name: pack_bits
+
+    Description: Packs a one bit per byte message into bytes, MSB
+                 first.
+
+    Document Reference: N/A
+*********************************************************************/
+void pack_bits(LIBLTE_BIT_MSG_STRUCT *msg,
+               uint8                 *packed)
+{
+    uint8 *msg_ptr = msg->msg;
+
+    for(uint32 i=0; i<msg->N_bits/8; i++)
+        packed[i] = liblte_bits_2_value(&msg_ptr, 8);
+    if((msg->N_bits % 8) != 0)
+        packed[msg->N_bits/8] = liblte_bits_2_value(&msg_ptr, msg->N_bits % 8) << (8 - (msg->N_bits % 8));
+}
+
+/*********************************************************************
+    Name: snow3g_tables
+
+    Description: Returns the SNOW 3G S1/S2 and alpha multiplication
+                 tables, building them on first use.
+
+    Document Reference: ETSI/SAGE SNOW 3G Specification v1.1
+                        Sections 3.1 - 3.4
+*********************************************************************/
+static inline uint8 snow3g_mul_x(uint8 v,
+                                 uint8 c)
+{
+    return (v & 0x80) ? ((v << 1) ^ c) : (v << 1);
+}
+static inline uint8 snow3g_mul_x_pow(uint8  v,
+                                     uint32 i,
+                                     uint8  c)
+{
+    while(i-- > 0)
+        v = snow3g_mul_x(v, c);
+    return v;
+}
+static void snow3g_build_tables(SNOW3G_TABLES_STRUCT *t)
+{
+    static const uint32 g49_exps[9] = {1, 9, 13, 15, 33, 41, 45, 47, 49};
+    uint8               pow_x[50];
+    uint8               sr;
+    uint8               sq;
+    uint8               sr2;
+    uint8               sq2;
+
+    for(uint32 x=0; x<256; x++)
+    {
+        // SR is the Rijndael S-box
+        sr = aes_ct_sub_bytes(x) & 0xFF;
+
+        // SQ is the Dickson polynomial g49 over GF(2^8) mod 0x169
+        pow_x[0] = 1;
+        for(uint32 i=1; i<50; i++)
+        {
+            pow_x[i] = 0;
+            for(uint32 b=0; b<8; b++)
+                if((x >> b) & 1)
+                    pow_x[i] ^= snow3g_mul_x_pow(pow_x[i-1], b, 0x69);
+        }
+        sq = 0x25;
+        for(uint32 i=0; i<9; i++)
+            sq ^= pow_x[g49_exps[i]];
+
+        // Fold the MixColumn step into one table per input byte
+        sr2 = snow3g_mul_x(sr, 0x1B);
+        sq2 = snow3g_mul_x(sq, 0x69);
+        t->s1[0][x] = ((uint32)sr2 << 24)        | ((uint32)(sr2 ^ sr) << 16) | ((uint32)sr << 8)         | sr;
+        t->s1[1][x] = ((uint32)sr << 24)         | ((uint32)sr2 << 16)        | ((uint32)(sr2 ^ sr) << 8) | sr;
+        t->s1[2][x] = ((uint32)sr << 24)         | ((uint32)sr << 16)         | ((uint32)sr2 << 8)        | (sr2 ^ sr);
+        t->s1[3][x] = ((uint32)(sr2 ^ sr) << 24) | ((uint32)sr << 16)         | ((uint32)sr << 8)         | sr2;
+        t->s2[0][x] = ((uint32)sq2 << 24)        | ((uint32)(sq2 ^ sq) << 16) | ((uint32)sq << 8)         | sq;
+        t->s2[1][x] = ((uint32)sq << 24)         | ((uint32)sq2 << 16)        | ((uint32)(sq2 ^ sq) << 8) | sq;
+        t->s2[2][x] = ((uint32)sq << 24)         | ((uint32)sq << 16)         | ((uint32)sq2 << 8)        | (sq2 ^ sq);
+        t->s2[3][x] = ((uint32)(sq2 ^ sq) << 24) | ((uint32)sq << 16)         | ((uint32)sq << 8)         | sq2;
+
+        t->mul_alpha[x] = ((uint32)snow3g_mul_x_pow(x, 23,  0xA9) << 24) |
+                          ((uint32)snow3g_mul_x_pow(x, 245, 0xA9) << 16) |
+                          ((uint32)snow3g_mul_x_pow(x, 48,  0xA9) << 8)  |
+                          snow3g_mul_x_pow(x, 239, 0xA9);
+        t->div_alpha[x] = ((uint32)snow3g_mul_x_pow(x, 16,  0xA9) << 24) |
+                          ((uint32)snow3g_mul_x_pow(x, 39,  0xA9) << 16) |
+                          ((uint32)snow3g_mul_x_pow(x, 6,   0xA9) << 8)  |
+                          snow3g_mul_x_pow(x, 64, 0xA9);
+    }
+}
+const SNOW3G_TABLES_STRUCT* snow3g_tables(void)
+{
+    static SNOW3G_TABLES_STRUCT tables;
+    static std::once_flag       built;
+
+    std::call_once(built, snow3g_build_tables, &tables);
+
+    return &tables;
+}
+
+/*********************************************************************
+    Name: snow3g_init
+
+    Description: Loads key and IV and runs the 32 initialization
+                 clocks of SNOW 3G.
+
+    Document Reference: ETSI/SAGE SNOW 3G Specification v1.1
+                        Section 4.1
+*********************************************************************/
+static inline uint32 snow3g_s(const uint32 t[4][256],
+                              uint32       w)
+{
+    return t[0][w >> 24] ^ t[1][(w >> 16) & 0xFF] ^ t[2][(w >> 8) & 0xFF] ^ t[3][w & 0xFF];
+}
+static inline uint32 snow3g_clock_fsm(SNOW3G_STATE_STRUCT *state)
+{
+    uint32 f = (state->s[15] + state->r1) ^ state->r2;
+    uint32 r = state->r2 + (state->r3 ^ state->s[5]);
+
+    state->r3 = snow3g_s(state->tables->s2, state->r2);
+    state->r2 = snow3g_s(state->tables->s1, state->r1);
+    state->r1 = r;
+
+    return f;
+}
+static inline void snow3g_clock_lfsr(SNOW3G_STATE_STRUCT *state,
+                                     uint32               f)
+{
+    uint32 v = (state->s[0] << 8)                       ^
+               state->tables->mul_alpha[state->s[0] >> 24] ^
+               state->s[2]                              ^
+               (state->s[11] >> 8)                      ^
+               state->tables->div_alpha[state->s[11] & 0xFF] ^
+               f;
+
+    memmove(&state->s[0], &state->s[1], 15*sizeof(uint32));
+    state->s[15] = v;
+}
+void snow3g_init(SNOW3G_STATE_STRUCT *state,
+                 uint32              *k,
+                 uint32              *iv)
+{
+    state->tables = snow3g_tables();
+    state->s[15]  = k[3] ^ iv[0];
+    state->s[14]  = k[2];
+    state->s[13]  = k[1];
+    state->s[12]  = k[0] ^ iv[1];
+    state->s[11]  = ~k[3];
+    state->s[10]  = ~k[2] ^ iv[2];
+    state->s[9]   = ~k[1] ^ iv[3];
+    state->s[8]   = ~k[0];
+    state->s[7]   = k[3];
+    state->s[6]   = k[2];
+    state->s[5]   = k[1];
+    state->s[4]   = k[0];
+    state->s[3]   = ~k[3];
+    state->s[2]   = ~k[2];
+    state->s[1]   = ~k[1];
+    state->s[0]   = ~k[0];
+    state->r1     = 0;
+    state->r2     = 0;
+    state->r3     = 0;
+    for(uint32 i=0; i<32; i++)
+        snow3g_clock_lfsr(state, snow3g_clock_fsm(state));
+
+    // The first output word is discarded
+    snow3g_clock_fsm(state);
+    snow3g_clock_lfsr(state, 0);
+}
+
+/*********************************************************************
+    Name: snow3g_generate_keystream
+
+    Description: Generates N_words 32-bit keystream words.
+
+    Document Reference: ETSI/SAGE SNOW 3G Specification v1.1
+                        Section 4.2
+*********************************************************************/
+void snow3g_generate_keystream(SNOW3G_STATE_STRUCT *state,
+                               uint32              *ks,
+                               uint32               N_words)
+{
+    for(uint32 i=0; i<N_words; i++)
+    {
+        ks[i] = snow3g_clock_fsm(state) ^ state->s[0];
+        snow3g_clock_lfsr(state, 0);
+    }
+}
+
+/*********************************************************************
+    Name: snow3g_cipher
+
+    Description: XORs msg_len bytes of msg with the SNOW 3G keystream.
+
+    Document Reference: 35.215 v10.0.0 Section 3.4
+*********************************************************************/
+void snow3g_cipher(SNOW3G_STATE_STRUCT *state,
+                   uint8               *msg,
+                   uint32               msg_len,
+                   uint8               *out)
+{
+    uint32 ks[STREAM_CIPHER_CHUNK_WORDS];
+    uint32 N_words;
+
+    for(uint32 offset=0; offset<msg_len; offset+=STREAM_CIPHER_CHUNK_WORDS*4)
+    {
+        N_words = (msg_len - offset + 3) / 4;
+        if(N_words > STREAM_CIPHER_CHUNK_WORDS)
+            N_words = STREAM_CIPHER_CHUNK_WORDS;
+        snow3g_generate_keystream(state, ks, N_words);
+        xor_keystream(ks, &msg[offset], &out[offset], msg_len - offset);
+    }
+}
 
+/*********************************************************************
+    Name: snow3g_f9
+
+    Description: Computes the SNOW 3G based MAC over msg_len_bits
+                 bits of msg.
+
+    Document Reference: 35.215 v10.0.0 Section 4.4
+*********************************************************************/
+static inline uint64 snow3g_mul64(uint64 v,
+                                  uint64 p)
+{
+    uint64 result = 0;
+
+    for(uint32 i=0; i<64; i++)
+    {
+        result ^= v & (0 - ((p >> i) & 1));
+        v       = (v << 1) ^ (0x1B & (0 - (v >> 63)));
+    }
+
+    return result;
+}
+void snow3g_f9(uint8  *key,
+               uint32  count,
+               uint8   bearer,
+               uint8   direction,
+               uint8  *msg,
+               uint32  msg_len_bits,
+               uint8  *mac)
+{
+    SNOW3G_STATE_STRUCT state;
+    uint64              p;
+    uint64              q;
+    uint64              eval;
+    uint64              m;
+    uint32              k[4];
+    uint32              iv[4];
+    uint32              z[5];
+    uint32              fresh;
+    uint32              N_bits;
+
+    // 35.215 v10.0.0 Section 4.4 with FRESH = BEARER || 0^27
     for(uint32 i=0; i<4; i++)
+        k[3-i] = load_be32(&key[i*4]);
+    fresh = (uint32)(bearer & 0x1F) << 27;
+    iv[3] = count;
+    iv[2] = fresh;
+    iv[1] = count ^ ((uint32)(direction & 0x01) << 31);
+    iv[0] = fresh ^ ((uint32)(direction & 0x01) << 15);
+    snow3g_init(&state, k, iv);
+    snow3g_generate_keystream(&state, z, 5);
+    p = ((uint64)z[0] << 32) | z[1];
+    q = ((uint64)z[2] << 32) | z[3];
+
+    eval = 0;
+    for(uint32 bit=0; bit<msg_len_bits; bit+=64)
+    {
+        N_bits = msg_len_bits - bit;
+        if(N_bits > 64)
+            N_bits = 64;
+        m = 0;
+        for(uint32 i=0; i<(N_bits+7)/8; i++)
+            m |= (uint64)msg[bit/8 + i] << (56 - i*8);
+        if(N_bits < 64)
+            m &= ~0ULL << (64 - N_bits);
+        eval = snow3g_mul64(eval ^ m, p);
+    }
+    eval ^= msg_len_bits;
+    eval  = snow3g_mul64(eval, q);
+
+    store_be32((uint32)(eval >> 32) ^ z[4], mac);
+}
+
+/*********************************************************************
+    Name: zuc_init
+
+    Description: Loads key and IV and runs the 32 initialization
+                 clocks of ZUC.
+
+    Document Reference: ETSI/SAGE ZUC Specification v1.6 Section 3.6.1
+*********************************************************************/
+static inline uint32 zuc_add31(uint32 a,
+                               uint32 b)
+{
+    uint32 c = a + b;
+
+    return (c & 0x7FFFFFFF) + (c >> 31);
+}
+static inline uint32 zuc_rot31(uint32 a,
+                               uint32 k)
+{
+    return ((a << k) | (a >> (31 - k))) & 0x7FFFFFFF;
+}
+static inline uint32 zuc_rotl(uint32 a,
+                              uint32 k)
+{
+    return (a << k) | (a >> (32 - k));
+}
+static inline uint32 zuc_l1(uint32 x)
+{
+    return x ^ zuc_rotl(x, 2) ^ zuc_rotl(x, 10) ^ zuc_rotl(x, 18) ^ zuc_rotl(x, 24);
+}
+static inline uint32 zuc_l2(uint32 x)
+{
+    return x ^ zuc_rotl(x, 8) ^ zuc_rotl(x, 14) ^ zuc_rotl(x, 22) ^ zuc_rotl(x, 30);
+}
+static inline uint32 zuc_s(uint32 x)
+{
+    return ((uint32)ZUC_S0[x >> 24] << 24)         |
+           ((uint32)ZUC_S1[(x >> 16) & 0xFF] << 16) |
+           ((uint32)ZUC_S0[(x >> 8) & 0xFF] << 8)   |
+           ZUC_S1[x & 0xFF];
+}
+static inline void zuc_clock_lfsr(ZUC_STATE_STRUCT *state,
+                                  uint32            u)
+{
+    uint32 f = state->s[0];
+
+    f = zuc_add31(f, zuc_rot31(state->s[0],  8));
+    f = zuc_add31(f, zuc_rot31(state->s[4],  20));
+    f = zuc_add31(f, zuc_rot31(state->s[10], 21));
+    f = zuc_add31(f, zuc_rot31(state->s[13], 17));
+    f = zuc_add31(f, zuc_rot31(state->s[15], 15));
+    f = zuc_add31(f, u);
+    if(0 == f)
+        f = 0x7FFFFFFF;
+
+    memmove(&state->s[0], &state->s[1], 15*sizeof(uint32));
+    state->s[15] = f;
+}
+static inline uint32 zuc_clock_f(ZUC_STATE_STRUCT *state,
+                                 uint32           *x3)
+{
+    // Bit reorganization
+    uint32 x0 = ((state->s[15] & 0x7FFF8000) << 1) | (state->s[14] & 0xFFFF);
+    uint32 x1 = ((state->s[11] & 0xFFFF) << 16)    | (state->s[9] >> 15);
+    uint32 x2 = ((state->s[7] & 0xFFFF) << 16)     | (state->s[5] >> 15);
+    *x3       = ((state->s[2] & 0xFFFF) << 16)     | (state->s[0] >> 15);
+
+    // Nonlinear function F
+    uint32 w  = (x0 ^ state->r1) + state->r2;
+    uint32 w1 = state->r1 + x1;
+    uint32 w2 = state->r2 ^ x2;
+    state->r1 = zuc_s(zuc_l1((w1 << 16) | (w2 >> 16)));
+    state->r2 = zuc_s(zuc_l2((w2 << 16) | (w1 >> 16)));
+
+    return w;
+}
+void zuc_init(ZUC_STATE_STRUCT *state,
+              uint8            *k,
+              uint8            *iv)
+{
+    uint32 x3;
+
+    for(uint32 i=0; i<16; i++)
+        state->s[i] = ((uint32)k[i] << 23) | ((uint32)ZUC_D[i] << 8) | iv[i];
+    state->r1 = 0;
+    state->r2 = 0;
+    for(uint32 i=0; i<32; i++)
+        zuc_clock_lfsr(state, zuc_clock_f(state, &x3) >> 1);
+
+    // The first output word is discarded
+    zuc_clock_f(state, &x3);
+    zuc_clock_lfsr(state, 0);
+}
+
+/*********************************************************************
+    Name: zuc_generate_keystream
+
+    Description: Generates N_words 32-bit keystream words.
+
+    Document Reference: ETSI/SAGE ZUC Specification v1.6 Section 3.6.2
+*********************************************************************/
+void zuc_generate_keystream(ZUC_STATE_STRUCT *state,
+                            uint32           *ks,
+                            uint32            N_words)
+{
+    uint32 x3;
+
+    for(uint32 i=0; i<N_words; i++)
+    {
+        ks[i] = zuc_clock_f(state, &x3) ^ x3;
+        zuc_clock_lfsr(state, 0);
+    }
+}
+
+/*********************************************************************
+    Name: zuc_cipher
+
+    Description: XORs msg_len bytes of msg with the ZUC keystream.
+
+    Document Reference: ETSI/SAGE 128-EEA3 & 128-EIA3 Specification
+                        v1.6 Section 3.4
+*********************************************************************/
+void zuc_cipher(ZUC_STATE_STRUCT *state,
+                uint8            *msg,
+                uint32            msg_len,
+                uint8            *out)
+{
+    uint32 ks[STREAM_CIPHER_CHUNK_WORDS];
+    uint32 N_words;
+
+    for(uint32 offset=0; offset<msg_len; offset+=STREAM_CIPHER_CHUNK_WORDS*4)
+    {
+        N_words = (msg_len - offset + 3) / 4;
+        if(N_words > STREAM_CIPHER_CHUNK_WORDS)
+            N_words = STREAM_CIPHER_CHUNK_WORDS;
+        zuc_generate_keystream(state, ks, N_words);
+        xor_keystream(ks, &msg[offset], &out[offset], msg_len - offset);
+    }
+}
+
+/*********************************************************************
+    Name: zuc_eia3
+
+    Description: Computes the ZUC based MAC over msg_len_bits bits of
+                 msg.
+
+    Document Reference: ETSI/SAGE 128-EEA3 & 128-EIA3 Specification
+                        v1.6 Section 4.4
+*********************************************************************/
+void zuc_eia3(uint8  *key,
+              uint32  count,
+              uint8   bearer,
+              uint8   direction,
+              uint8  *msg,
+              uint32  msg_len_bits,
+              uint8  *mac)
+{
+    ZUC_STATE_STRUCT state;
+    uint8            iv[16];
+    uint32           z_cur;
+    uint32           z_next;
+    uint32           t;
+    uint32           j;
+
+    // EIA3 specification v1.6 Section 4.3
+    store_be32(count, &iv[0]);
+    iv[4]  = (bearer & 0x1F) << 3;
+    iv[5]  = 0;
+    iv[6]  = 0;
+    iv[7]  = 0;
+    memcpy(&iv[8], &iv[0], 8);
+    iv[8]  ^= (direction & 0x01) << 7;
+    iv[14] ^= (direction & 0x01) << 7;
+    zuc_init(&state, key, iv);
+
+    // Slide a 64-bit window over the keystream rather than storing
+    // all L = ceil(LENGTH/32) + 2 words
+    zuc_generate_keystream(&state, &z_cur, 1);
+    zuc_generate_keystream(&state, &z_next, 1);
+    t = 0;
+    for(uint32 i=0; i<msg_len_bits; i++)
+    {
+        j = i % 32;
+        if(0 == j && 0 != i)
+        {
+            z_cur = z_next;
+            zuc_generate_keystream(&state, &z_next, 1);
+        }
+        if((msg[i/8] >> (7 - (i % 8))) & 1)
+            t ^= (0 == j) ? z_cur : ((z_cur << j) | (z_next >> (32 - j)));
+    }
+
+    // XOR in GET_WORD(z, LENGTH) and then z_(L-1)
+    j = msg_len_bits % 32;
+    if(0 == j && 0 != msg_len_bits)
     {
-        uint8 temp = state->state[0][i] ^ state->state[1][i] ^ state->state[2][i] ^ state->state[3][i];
-        uint8 tmp0 = state->state[0][i];
+        z_cur = z_next;
+        zuc_generate_keystream(&state, &z_next, 1);
+    }
+    t ^= (0 == j) ? z_cur : ((z_cur << j) | (z_next >> (32 - j)));
+    if(0 != j)
+        zuc_generate_keystream(&state, &z_next, 1);
+    t ^= z_next;
+
+    store_be32(t, mac);
+}
+
+/*********************************************************************
+    Name: load_be32
+
+    Description: Reads a big endian 32-bit word.
+
+    Document Reference: N/A
+*********************************************************************/
+uint32 load_be32(uint8 *bytes)
+{
+    return ((uint32)bytes[0] << 24) | ((uint32)bytes[1] << 16) | ((uint32)bytes[2] << 8) | bytes[3];
+}
+
+/*********************************************************************
+    Name: store_be32
+
+    Description: Writes a big endian 32-bit word.
+
+    Document Reference: N/A
+*********************************************************************/
+void store_be32(uint32  word,
+                uint8  *bytes)
+{
+    bytes[0] = (word >> 24) & 0xFF;
+    bytes[1] = (word >> 16) & 0xFF;
+    bytes[2] = (word >> 8) & 0xFF;
+    bytes[3] = word & 0xFF;
+}
+
+/*********************************************************************
+    Name: xor_keystream
+
+    Description: XORs up to 4*STREAM_CIPHER_CHUNK_WORDS bytes of msg
+                 with big endian keystream words.
+
+    Document Reference: N/A
+*********************************************************************/
+void xor_keystream(uint32 *ks,
+                   uint8  *msg,
+                   uint8  *out,
+                   uint32  msg_len)
+{
+    uint32 N_bytes = msg_len;
+
+    if(N_bytes > STREAM_CIPHER_CHUNK_WORDS*4)
+        N_bytes = STREAM_CIPHER_CHUNK_WORDS*4;
+    for(uint32 i=0; i<N_bytes; i++)
+        out[i] = msg[i] ^ ((ks[i/4] >> (24 - (i % 4)*8)) & 0xFF);
+}
+
+/*********************************************************************
+    Name: milenage_temp
+
+    Description: Computes TEMP = E[RAND ^ OPc]K.
+
+    Document Reference: 35.206 v10.0.0 Annex 3
+*********************************************************************/
+void milenage_temp(LIBLTE_SECURITY_MILENAGE_KEY_STRUCT *key,
+                   uint8                               *rand,
+                   uint8                               *temp)
+{
+    uint8 rijndael_input[16];
+
+    for(uint32 i=0; i<16; i++)
+        rijndael_input[i] = rand[i] ^ key->op_c[i];
+    liblte_security_aes_encrypt(&key->ks, rijndael_input, temp);
+}
 
-        uint8 tmp           = X_TIME[state->state[0][i] ^ state->state[1][i]];
-        state->state[0][i] ^= temp ^ tmp;
+/*********************************************************************
+    Name: milenage_out1
 
-        tmp                 = X_TIME[state->state[1][i] ^ state->state[2][i]];
-        state->state[1][i] ^= temp ^ tmp;
+    Description: Computes OUT1, used by F1 and F1*.
 
-        tmp                 = X_TIME[state->state[2][i] ^ state->state[3][i]];
-        state->state[2][i] ^= temp ^ tmp;
+    Document Reference: 35.206 v10.0.0 Annex 3
+*********************************************************************/
+void milenage_out1(LIBLTE_SECURITY_MILENAGE_KEY_STRUCT *key,
+                   uint8                               *rand,
+                   uint8                               *sqn,
+                   uint8                               *amf,
+                   uint8                               *out1)
+{
+    uint8 temp[16];
+    uint8 in1[16];
+    uint8 rijndael_input[16];
 
-        tmp                 = X_TIME[state->state[3][i] ^ tmp0];
-        state->state[3][i] ^= temp ^ tmp;
+    milenage_temp(key, rand, temp);
+
+    // Construct in1
+    for(uint32 i=0; i<6; i++)
+    {
+        in1[i]   = sqn[i];
+        in1[i+8] = sqn[i];
+    }
+    for(uint32 i=0; i<2; i++)
+    {
+        in1[i+6]  = amf[i];
+        in1[i+14] = amf[i];
     }
+
+    // Compute out1
+    for(uint32 i=0; i<16; i++)
+        rijndael_input[(i+8) % 16] = in1[i] ^ key->op_c[i];
+    for(uint32 i=0; i<16; i++)
+        rijndael_input[i] ^= temp[i];
+    liblte_security_aes_encrypt(&key->ks, rijndael_input, out1);
+    for(uint32 i=0; i<16; i++)
+        out1[i] ^= key->op_c[i];
+}
+
+/*********************************************************************
+    Name: milenage_out
+
+    Description: Computes OUT2 through OUT5 from TEMP, the rotation in
+                 bytes and the constant c.
+
+    Document Reference: 35.206 v10.0.0 Annex 3
+*********************************************************************/
+void milenage_out(LIBLTE_SECURITY_MILENAGE_KEY_STRUCT *key,
+                  uint8                               *temp,
+                  uint32                               rot,
+                  uint8                                c,
+                  uint8                               *out)
+{
+    uint8 rijndael_input[16];
+
+    for(uint32 i=0; i<16; i++)
+        rijndael_input[(i+rot) % 16] = temp[i] ^ key->op_c[i];
+    rijndael_input[15] ^= c;
+    liblte_security_aes_encrypt(&key->ks, rijndael_input, out);
+    for(uint32 i=0; i<16; i++)
+        out[i] ^= key->op_c[i];
 }
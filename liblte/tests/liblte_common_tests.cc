@@ -86,6 +86,25 @@ int v2b_b2v_random_test()
     return 0;
 }
 
+int bytes_2_bits_test()
+{
+    uint8 bytes[16];
+    uint8 bits[16*8];
+
+    for(uint32 i=0; i<16; i++)
+        bytes[i] = rand();
+    uint8 *bits_ptr = &bits[0];
+    liblte_bytes_2_bits(bytes, 16, &bits_ptr);
+    if(bits_ptr != &bits[16*8])
+        return -1;
+    bits_ptr = &bits[0];
+    for(uint32 i=0; i<16; i++)
+        if(bytes[i] != liblte_bits_2_value(&bits_ptr, 8))
+            return -1;
+
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
     printf("v2b_single_bit_test: ");
@@ -96,5 +115,9 @@ int main(int argc, char *argv[])
     if(0 != v2b_b2v_random_test())
         exit(-1);
     printf("pass\n");
+    printf("bytes_2_bits_test: ");
+    if(0 != bytes_2_bits_test())
+        exit(-1);
+    printf("pass\n");
     exit(0);
 }
@@ -37,6 +37,14 @@
                               DEFINES
 *******************************************************************************/
 
+// Synthetic downlink load
+#define DL_SCHED_TEST_N_UE           8
+#define DL_SCHED_TEST_N_RB           50
+#define DL_SCHED_TEST_RBG_SIZE       3
+#define DL_SCHED_TEST_MAX_UE_PER_TTI 4
+#define DL_SCHED_TEST_N_TTIS         10000
+#define DL_SCHED_TEST_ARRIVAL_BITS   1500
+#define DL_SCHED_TEST_MAX_BUFFER     100000
 
 /*******************************************************************************
                               TYPEDEFS
@@ -528,10 +536,82 @@ int mac_pdu_ulsch_test(void)
     return 0;
 }
 
+int mac_pdu_dlsch_tb_test(void)
+{
+    LIBLTE_MAC_PDU_STRUCT pdu;
+    pdu.N_subheaders = 4;
+    pdu.chan_type = LIBLTE_MAC_CHAN_TYPE_DLSCH;
+    pdu.subheader[0].lcid = LIBLTE_MAC_DLSCH_UE_CONTENTION_RESOLUTION_ID_LCID;
+    pdu.subheader[0].payload.ue_con_res_id.id = 0x123456789ABC;
+    pdu.subheader[1].lcid = LIBLTE_MAC_DLSCH_TA_COMMAND_LCID;
+    pdu.subheader[1].payload.ta_command.ta = 0x26;
+    pdu.subheader[2].lcid = LIBLTE_MAC_DLSCH_DCCH_LCID_BEGIN;
+    pdu.subheader[2].payload.sdu.N_bytes = 3;
+    pdu.subheader[3].lcid = LIBLTE_MAC_DLSCH_DCCH_LCID_BEGIN+2;
+    pdu.subheader[3].payload.sdu.N_bytes = 200;
+    for(uint32 i=0; i<pdu.subheader[2].payload.sdu.N_bytes; i++)
+        pdu.subheader[2].payload.sdu.msg[i] = 0xA0 + i;
+    for(uint32 i=0; i<pdu.subheader[3].payload.sdu.N_bytes; i++)
+        pdu.subheader[3].payload.sdu.msg[i] = i;
+    if(4 + 1 + 6 + 1 + 3 + 200 != liblte_mac_get_dlsch_mac_pdu_size(&pdu))
+        return -1;
+
+    // Exact fit must match the bit packer
+    LIBLTE_BYTE_MSG_STRUCT bytes;
+    LIBLTE_BIT_MSG_STRUCT  msg;
+    LIBLTE_BIT_MSG_STRUCT  ref;
+    uint32                 size = liblte_mac_get_dlsch_mac_pdu_size(&pdu);
+    if(LIBLTE_SUCCESS != liblte_mac_pack_dlsch_mac_pdu(&pdu, size, &bytes) ||
+       LIBLTE_SUCCESS != liblte_mac_pack_mac_pdu(&pdu, &ref)              ||
+       ref.N_bits != bytes.N_bytes*8)
+        return -1;
+    uint8 *ref_ptr = ref.msg;
+    for(uint32 i=0; i<bytes.N_bytes; i++)
+        if(bytes.msg[i] != liblte_bits_2_value(&ref_ptr, 8))
+            return -1;
+    if(LIBLTE_SUCCESS == liblte_mac_pack_dlsch_mac_pdu(&pdu, size-1, &bytes))
+        return -1;
+
+    // Leading and trailing padding must unpack to the same PDU
+    uint32 N_pad[5] = {1, 2, 3, 4, 100};
+    for(uint32 i=0; i<5; i++)
+    {
+        if(LIBLTE_SUCCESS != liblte_mac_pack_dlsch_mac_pdu(&pdu, size+N_pad[i], &bytes) ||
+           bytes.N_bytes != size+N_pad[i])
+            return -1;
+        uint8 *msg_ptr = msg.msg;
+        liblte_bytes_2_bits(bytes.msg, bytes.N_bytes, &msg_ptr);
+        msg.N_bits = msg_ptr - msg.msg;
+        LIBLTE_MAC_PDU_STRUCT out;
+        out.chan_type = LIBLTE_MAC_CHAN_TYPE_DLSCH;
+        if(LIBLTE_SUCCESS != liblte_mac_unpack_mac_pdu(&msg, false, &out) ||
+           out.N_subheaders != 4 + ((N_pad[i] <= 2) ? N_pad[i] : 1))
+            return -1;
+        uint32 first = (N_pad[i] <= 2) ? N_pad[i] : 0;
+        for(uint32 j=0; j<first; j++)
+            if(out.subheader[j].lcid != LIBLTE_MAC_DLSCH_PADDING_LCID)
+                return -1;
+        if(N_pad[i] > 2 &&
+           out.subheader[4].lcid != LIBLTE_MAC_DLSCH_PADDING_LCID)
+            return -1;
+        if(out.subheader[first].payload.ue_con_res_id.id != 0x123456789ABC ||
+           out.subheader[first+1].payload.ta_command.ta != 0x26             ||
+           out.subheader[first+2].payload.sdu.N_bytes != 3                  ||
+           out.subheader[first+3].payload.sdu.N_bytes != 200)
+            return -1;
+        if(0 != memcmp(out.subheader[first+2].payload.sdu.msg, pdu.subheader[2].payload.sdu.msg, 3) ||
+           0 != memcmp(out.subheader[first+3].payload.sdu.msg, pdu.subheader[3].payload.sdu.msg, 200))
+            return -1;
+    }
+    return 0;
+}
+
 int mac_pdu_test(void)
 {
     if(0 != mac_pdu_dlsch_test())
         return -1;
+    if(0 != mac_pdu_dlsch_tb_test())
+        return -1;
     if(0 != mac_pdu_ulsch_test())
         return -1;
     return 0;
@@ -602,6 +682,209 @@ int random_access_response_test(void)
     return 0;
 }
 
+int dl_sched_alloc_test(void)
+{
+    bool   prb_used[25];
+    uint32 prb[25];
+    uint32 N_prb;
+
+    // Type 2 takes the first free run that fits
+    memset(prb_used, 0, sizeof(prb_used));
+    prb_used[3] = prb_used[4] = prb_used[5] = true;
+    if(LIBLTE_SUCCESS != liblte_mac_dl_sched_alloc_prbs(LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_2, 2, 25, 4, prb_used, prb, &N_prb) ||
+       4 != N_prb || 6 != prb[0] || 9 != prb[3])
+        return -1;
+
+    // Type 0 takes whole free RBGs, the last RBG has one PRB
+    memset(prb_used, 0, sizeof(prb_used));
+    prb_used[6] = true;
+    if(LIBLTE_SUCCESS != liblte_mac_dl_sched_alloc_prbs(LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_0, 2, 25, 5, prb_used, prb, &N_prb) ||
+       6 != N_prb || 0 != prb[0] || 5 != prb[5])
+        return -1;
+    if(LIBLTE_SUCCESS != liblte_mac_dl_sched_alloc_prbs(LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_0, 2, 25, 3, prb_used, prb, &N_prb) ||
+       4 != N_prb || 8 != prb[0] || 11 != prb[3])
+        return -1;
+    for(uint32 i=0; i<24; i++)
+        prb_used[i] = true;
+    if(LIBLTE_SUCCESS != liblte_mac_dl_sched_alloc_prbs(LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_0, 2, 25, 2, prb_used, prb, &N_prb) ||
+       1 != N_prb || 24 != prb[0])
+        return -1;
+    if(LIBLTE_SUCCESS != liblte_mac_dl_sched_alloc_prbs(LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_2, 2, 25, 2, prb_used, prb, &N_prb) ||
+       0 != N_prb)
+        return -1;
+    return 0;
+}
+
+int dl_sched_order_test(void)
+{
+    LIBLTE_MAC_DL_SCHED_UE_STRUCT ue[3];
+    uint32                        order[3];
+
+    ue[0].avg_thruput = 1000; ue[0].inst_rate = 4000; ue[0].last_tti = 10237;
+    ue[1].avg_thruput = 100;  ue[1].inst_rate = 1000; ue[1].last_tti = 5;
+    ue[2].avg_thruput = 2000; ue[2].inst_rate = 6000; ue[2].last_tti = 7;
+    if(LIBLTE_SUCCESS != liblte_mac_dl_sched_order(LIBLTE_MAC_DL_SCHED_POLICY_ROUND_ROBIN, ue, 3, 8, order) ||
+       0 != order[0] || 1 != order[1] || 2 != order[2])
+        return -1;
+    if(LIBLTE_SUCCESS != liblte_mac_dl_sched_order(LIBLTE_MAC_DL_SCHED_POLICY_MAX_CI, ue, 3, 8, order) ||
+       2 != order[0] || 0 != order[1] || 1 != order[2])
+        return -1;
+    if(LIBLTE_SUCCESS != liblte_mac_dl_sched_order(LIBLTE_MAC_DL_SCHED_POLICY_PROPORTIONAL_FAIR, ue, 3, 8, order) ||
+       1 != order[0] || 0 != order[1] || 2 != order[2])
+        return -1;
+    if(LIBLTE_SUCCESS == liblte_mac_dl_sched_order(LIBLTE_MAC_DL_SCHED_POLICY_MAX_CI, ue, LIBLTE_MAC_DL_SCHED_MAX_N_UE+1, 8, order))
+        return -1;
+    return 0;
+}
+
+// Runs a synthetic overloaded cell with UEs at different average
+// channel qualities and reports cell throughput and Jain fairness
+void dl_sched_load(LIBLTE_MAC_DL_SCHED_POLICY_ENUM  policy,
+                   float                           *thruput,
+                   float                           *fairness)
+{
+    LIBLTE_MAC_DL_SCHED_UE_STRUCT sched_ue[DL_SCHED_TEST_N_UE];
+    LIBLTE_MAC_DL_SCHED_UE_STRUCT ue[DL_SCHED_TEST_N_UE];
+    uint32                        order[DL_SCHED_TEST_N_UE];
+    uint32                        idx[DL_SCHED_TEST_N_UE];
+    uint32                        buffer[DL_SCHED_TEST_N_UE];
+    uint32                        bits_per_prb[DL_SCHED_TEST_N_UE];
+    uint64                        delivered[DL_SCHED_TEST_N_UE];
+    bool                          prb_used[DL_SCHED_TEST_N_RB];
+    uint32                        prb[DL_SCHED_TEST_N_RB];
+    uint32                        N_prb;
+    uint32                        seed = 12345;
+
+    for(uint32 i=0; i<DL_SCHED_TEST_N_UE; i++)
+    {
+        ue[i].avg_thruput = 0;
+        ue[i].last_tti    = 0;
+        ue[i].rnti        = i;
+        buffer[i]         = 0;
+        delivered[i]      = 0;
+    }
+
+    for(uint32 tti=0; tti<DL_SCHED_TEST_N_TTIS; tti++)
+    {
+        // Traffic arrivals and fast fading around each UE's mean
+        uint32 N_ue = 0;
+        for(uint32 i=0; i<DL_SCHED_TEST_N_UE; i++)
+        {
+            buffer[i] += DL_SCHED_TEST_ARRIVAL_BITS;
+            if(buffer[i] > DL_SCHED_TEST_MAX_BUFFER)
+                buffer[i] = DL_SCHED_TEST_MAX_BUFFER;
+            seed            = seed*1103515245 + 12345;
+            bits_per_prb[i] = (40 + 40*i)*(25 + ((seed >> 16) % 151))/100;
+            ue[i].inst_rate = bits_per_prb[i]*DL_SCHED_TEST_N_RB;
+            idx[N_ue]       = i;
+            sched_ue[N_ue]  = ue[i];
+            N_ue++;
+        }
+
+        // Schedule the best UEs until the PRBs or DCIs run out
+        liblte_mac_dl_sched_order(policy, sched_ue, N_ue, tti % LIBLTE_MAC_DL_SCHED_N_TTIS, order);
+        memset(prb_used, 0, sizeof(prb_used));
+        for(uint32 k=0; k<N_ue; k++)
+        {
+            uint32 i      = idx[order[k]];
+            uint32 N_bits = 0;
+            if(k < DL_SCHED_TEST_MAX_UE_PER_TTI)
+            {
+                uint32 N_prb_req = (buffer[i] + bits_per_prb[i] - 1)/bits_per_prb[i];
+                liblte_mac_dl_sched_alloc_prbs(LIBLTE_MAC_RESOURCE_ALLOCATION_TYPE_0,
+                                               DL_SCHED_TEST_RBG_SIZE,
+                                               DL_SCHED_TEST_N_RB,
+                                               N_prb_req,
+                                               prb_used,
+                                               prb,
+                                               &N_prb);
+                N_bits = N_prb*bits_per_prb[i];
+                if(N_bits > buffer[i])
+                    N_bits = buffer[i];
+            }
+            buffer[i]    -= N_bits;
+            delivered[i] += N_bits;
+            liblte_mac_dl_sched_update(&ue[i], tti % LIBLTE_MAC_DL_SCHED_N_TTIS, N_bits);
+        }
+    }
+
+    // Cell throughput in Mbps and Jain's fairness index
+    float sum    = 0;
+    float sum_sq = 0;
+    for(uint32 i=0; i<DL_SCHED_TEST_N_UE; i++)
+    {
+        float x  = (float)delivered[i]/DL_SCHED_TEST_N_TTIS;
+        sum     += x;
+        sum_sq  += x*x;
+    }
+    *thruput  = sum/1000;
+    *fairness = (sum*sum)/(DL_SCHED_TEST_N_UE*sum_sq);
+}
+
+int dl_sched_load_test(void)
+{
+    float thruput[LIBLTE_MAC_DL_SCHED_POLICY_N_ITEMS];
+    float fairness[LIBLTE_MAC_DL_SCHED_POLICY_N_ITEMS];
+
+    for(uint32 i=0; i<LIBLTE_MAC_DL_SCHED_POLICY_N_ITEMS; i++)
+    {
+        dl_sched_load((LIBLTE_MAC_DL_SCHED_POLICY_ENUM)i, &thruput[i], &fairness[i]);
+        printf("%s %.2f Mbps fairness %.3f, ",
+               liblte_mac_dl_sched_policy_text[i],
+               thruput[i],
+               fairness[i]);
+    }
+
+    // Max C/I starves the cell edge, proportional fair exploits the
+    // fading to beat round robin on both counts
+    if(fairness[LIBLTE_MAC_DL_SCHED_POLICY_MAX_CI]            >= fairness[LIBLTE_MAC_DL_SCHED_POLICY_PROPORTIONAL_FAIR] ||
+       fairness[LIBLTE_MAC_DL_SCHED_POLICY_MAX_CI]            >= fairness[LIBLTE_MAC_DL_SCHED_POLICY_ROUND_ROBIN]       ||
+       thruput[LIBLTE_MAC_DL_SCHED_POLICY_PROPORTIONAL_FAIR]  <  thruput[LIBLTE_MAC_DL_SCHED_POLICY_ROUND_ROBIN]        ||
+       fairness[LIBLTE_MAC_DL_SCHED_POLICY_PROPORTIONAL_FAIR] <  fairness[LIBLTE_MAC_DL_SCHED_POLICY_ROUND_ROBIN])
+        return -1;
+    return 0;
+}
+
+int dl_sched_test(void)
+{
+    if(0 != dl_sched_alloc_test())
+        return -1;
+    if(0 != dl_sched_order_test())
+        return -1;
+    if(0 != dl_sched_load_test())
+        return -1;
+    return 0;
+}
+
+int ul_link_adaptation_test(void)
+{
+    uint8 mcs;
+    uint8 last_mcs = 0;
+
+    // MCS never decreases with SINR
+    for(int32 i=-100; i<=300; i++)
+    {
+        if(LIBLTE_SUCCESS != liblte_mac_ul_sched_get_mcs(i/10.0, LIBLTE_MAC_UL_SCHED_MAX_MCS, &mcs))
+            return -1;
+        if(mcs < last_mcs)
+            return -1;
+        last_mcs = mcs;
+    }
+    if(last_mcs != LIBLTE_MAC_UL_SCHED_MAX_MCS)
+        return -1;
+
+    // Low SINR falls back to MCS 0 and the cap is respected
+    if(LIBLTE_SUCCESS != liblte_mac_ul_sched_get_mcs(-20, LIBLTE_MAC_UL_SCHED_MAX_MCS, &mcs) ||
+       mcs != 0)
+        return -1;
+    if(LIBLTE_SUCCESS != liblte_mac_ul_sched_get_mcs(30, 20, &mcs) ||
+       mcs != 20)
+        return -1;
+    if(LIBLTE_SUCCESS == liblte_mac_ul_sched_get_mcs(30, LIBLTE_MAC_UL_SCHED_MAX_MCS+1, &mcs))
+        return -1;
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
     printf("truncated_bsr_test: ");
@@ -652,5 +935,13 @@ int main(int argc, char *argv[])
     if(0 != random_access_response_test())
         exit(-1);
     printf("pass\n");
+    printf("dl_sched_test: ");
+    if(0 != dl_sched_test())
+        exit(-1);
+    printf("pass\n");
+    printf("ul_link_adaptation_test: ");
+    if(0 != ul_link_adaptation_test())
+        exit(-1);
+    printf("pass\n");
     exit(0);
 }
@@ -165,6 +165,63 @@ int cpdu_format_4_test(void)
     return 0;
 }
 
+int cpdu_format_5_test(void)
+{
+    LIBLTE_PDCP_CONTROL_PDU_STRUCT     contents;
+    LIBLTE_PDCP_SECURITY_CONFIG_STRUCT sec;
+    LIBLTE_BIT_MSG_STRUCT              data;
+    LIBLTE_BYTE_MSG_STRUCT             pdu;
+    uint8                              k_int[32];
+    uint8                              k_enc[32];
+    for(uint32 i=0; i<32; i++)
+    {
+        k_int[i] = i;
+        k_enc[i] = 0xFF - i;
+    }
+    sec.k_int = k_int;
+    sec.k_enc = k_enc;
+    for(uint32 eea=0; eea<LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_N_ITEMS; eea++)
+    {
+        for(uint32 eia=1; eia<LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_N_ITEMS; eia++)
+        {
+            sec.eea        = (LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_ENUM)eea;
+            sec.eia        = (LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_ENUM)eia;
+            contents.count = 0x135;
+            data.N_bits    = 16;
+            for(uint32 i=0; i<16; i++)
+                data.msg[i] = i%2;
+            if(LIBLTE_SUCCESS != liblte_pdcp_pack_control_pdu(&contents, &data, &sec,
+                                                              LIBLTE_SECURITY_DIRECTION_DOWNLINK,
+                                                              2, &pdu))
+                return -1;
+            if(7 != pdu.N_bytes || 0x15 != pdu.msg[0])
+                return -1;
+            if(LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_EEA0 != eea &&
+               0x55 == pdu.msg[1] && 0x55 == pdu.msg[2])
+                return -1;
+            if(LIBLTE_SUCCESS != liblte_pdcp_unpack_control_pdu(&pdu, &sec, 0x135,
+                                                                LIBLTE_SECURITY_DIRECTION_DOWNLINK,
+                                                                2, &contents))
+                return -1;
+            if(contents.count != 0x135 || contents.data.N_bits != 16)
+                return -1;
+            for(uint32 i=0; i<16; i++)
+                if(contents.data.msg[i] != i%2)
+                    return -1;
+
+            // A different COUNT must fail integrity verification
+            liblte_pdcp_pack_control_pdu(&contents, &data, &sec,
+                                         LIBLTE_SECURITY_DIRECTION_DOWNLINK,
+                                         2, &pdu);
+            if(LIBLTE_ERROR_INVALID_CRC != liblte_pdcp_unpack_control_pdu(&pdu, &sec, 0x115,
+                                                                          LIBLTE_SECURITY_DIRECTION_DOWNLINK,
+                                                                          2, &contents))
+                return -1;
+        }
+    }
+    return 0;
+}
+
 int control_pdu_test(void)
 {
     if(0 != cpdu_format_1_test())
@@ -175,6 +232,8 @@ int control_pdu_test(void)
         return -1;
     if(0 != cpdu_format_4_test())
         return -1;
+    if(0 != cpdu_format_5_test())
+        return -1;
     return 0;
 }
 
@@ -223,12 +282,52 @@ int dpls_format_2_test(void)
     return 0;
 }
 
+int dpls_format_3_test(void)
+{
+    LIBLTE_PDCP_DATA_PDU_WITH_LONG_SN_STRUCT contents;
+    LIBLTE_PDCP_SECURITY_CONFIG_STRUCT       sec;
+    LIBLTE_BYTE_MSG_STRUCT                   data;
+    LIBLTE_BYTE_MSG_STRUCT                   pdu;
+    uint8                                    k_enc[32];
+    for(uint32 i=0; i<32; i++)
+        k_enc[i] = i;
+    sec.k_int = NULL;
+    sec.k_enc = k_enc;
+    sec.eia   = LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_EIA0;
+    for(uint32 eea=1; eea<LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_N_ITEMS; eea++)
+    {
+        sec.eea        = (LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_ENUM)eea;
+        contents.count = 0x12ABC;
+        data.N_bytes   = 100;
+        for(uint32 i=0; i<data.N_bytes; i++)
+            data.msg[i] = i;
+        if(LIBLTE_SUCCESS != liblte_pdcp_pack_data_pdu_with_long_sn(&contents, &data, &sec,
+                                                                    LIBLTE_SECURITY_DIRECTION_DOWNLINK,
+                                                                    0, &pdu))
+            return -1;
+        if(102 != pdu.N_bytes || 0x8A != pdu.msg[0] || 0xBC != pdu.msg[1])
+            return -1;
+        if(0 == memcmp(&pdu.msg[2], data.msg, data.N_bytes))
+            return -1;
+        if(LIBLTE_SUCCESS != liblte_pdcp_unpack_data_pdu_with_long_sn(&pdu, &sec, 0x12ABC,
+                                                                      LIBLTE_SECURITY_DIRECTION_DOWNLINK,
+                                                                      0, &contents))
+            return -1;
+        if(contents.count != 0x12ABC || contents.data.N_bytes != 100 ||
+           0 != memcmp(contents.data.msg, data.msg, data.N_bytes))
+            return -1;
+    }
+    return 0;
+}
+
 int data_pdu_with_long_sn_test(void)
 {
     if(0 != dpls_format_1_test())
         return -1;
     if(0 != dpls_format_2_test())
         return -1;
+    if(0 != dpls_format_3_test())
+        return -1;
     return 0;
 }
 
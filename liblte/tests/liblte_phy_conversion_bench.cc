@@ -0,0 +1,109 @@
+/*******************************************************************************
+
+    Copyright 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************
+
+    File: liblte_phy_conversion_bench.cc
+
+    Description: Measures the radio sample conversions of the LTE PHY
+                 library for one 30.72 Msps subframe.  Built twice, with
+                 and without the SIMD kernels.
+
+    Revision History
+    ----------    -------------    --------------------------------------------
+    10/18/2026    agent            Created file.
+
+*******************************************************************************/
+
+/*******************************************************************************
+                              INCLUDES
+*******************************************************************************/
+
+#include "liblte_phy.h"
+#include <chrono>
+#include <stdio.h>
+
+/*******************************************************************************
+                              DEFINES
+*******************************************************************************/
+
+#define N_SAMPS      30720
+#define N_ITERATIONS 2000
+
+/*******************************************************************************
+                              TYPEDEFS
+*******************************************************************************/
+
+
+/*******************************************************************************
+                              GLOBAL VARIABLES
+*******************************************************************************/
+
+static complex fc32[N_SAMPS];
+static complex fc32_out[N_SAMPS];
+static int16   sc16[N_SAMPS*2];
+
+/*******************************************************************************
+                              FUNCTIONS
+*******************************************************************************/
+
+double us_per_subframe(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count()/N_ITERATIONS;
+}
+
+int main(int argc, char *argv[])
+{
+    float sum = 0;
+
+    for(uint32 i=0; i<N_SAMPS; i++)
+        fc32[i] = complex((int32)(i % 2001) - 1000, (int32)(i*7 % 2001) - 1000);
+
+#if defined(LIBLTE_PHY_HAVE_SIMD) && 0 == LIBLTE_PHY_HAVE_SIMD
+    printf("SIMD: no\n");
+#else
+    printf("SIMD: %s\n", __builtin_cpu_supports("avx2") ? "AVX2" : "SSE2");
+#endif
+    printf("%u samples per subframe\n", N_SAMPS);
+
+    auto start = std::chrono::steady_clock::now();
+    for(uint32 i=0; i<N_ITERATIONS; i++)
+    {
+        liblte_phy_fc32_to_sc16(fc32, 40, N_SAMPS, sc16);
+        sum += sc16[i % (N_SAMPS*2)];
+    }
+    printf("fc32 to sc16: %7.2f us\n", us_per_subframe(start));
+
+    start = std::chrono::steady_clock::now();
+    for(uint32 i=0; i<N_ITERATIONS; i++)
+    {
+        liblte_phy_sc16_to_fc32(sc16, 1.0/40, N_SAMPS, fc32_out);
+        sum += fc32_out[i % N_SAMPS].real();
+    }
+    printf("sc16 to fc32: %7.2f us\n", us_per_subframe(start));
+
+    start = std::chrono::steady_clock::now();
+    for(uint32 i=0; i<N_ITERATIONS; i++)
+    {
+        liblte_phy_scale_fc32(fc32, 1.0/50, N_SAMPS, fc32_out);
+        sum += fc32_out[i % N_SAMPS].real();
+    }
+    printf("scale fc32:   %7.2f us\n", us_per_subframe(start));
+
+    // Keeps the conversions from being optimized away
+    printf("checksum: %.1f\n", sum);
+}
@@ -1132,7 +1132,7 @@ int pusch_channel_encode_decode_test(LIBLTE_PHY_STRUCT *phy_struct)
         return -1;
     LIBLTE_BIT_MSG_STRUCT msg;
     if(LIBLTE_SUCCESS != liblte_phy_pusch_channel_decode(phy_struct, subframe, &alloc,
-                                                         N_ID_CELL, N_UL_ANT, 1,
+                                                         N_ID_CELL, N_UL_ANT, 1, NULL,
                                                          msg.msg, &msg.N_bits))
         return -1;
     for(uint32 i=0; i<alloc.msg[0].N_bits; i++)
@@ -1142,6 +1142,103 @@ int pusch_channel_encode_decode_test(LIBLTE_PHY_STRUCT *phy_struct)
     return 0;
 }
 
+int pusch_soft_combining_tx_rx(LIBLTE_PHY_STRUCT            *phy_struct,
+                               LIBLTE_PHY_SUBFRAME_STRUCT   *subframe,
+                               LIBLTE_PHY_ALLOCATION_STRUCT *alloc,
+                               uint32                        rv_idx,
+                               uint32                        first_faded_symb)
+{
+    alloc->rv_idx = rv_idx;
+    if(LIBLTE_SUCCESS != liblte_phy_pusch_channel_encode(phy_struct, alloc,
+                                                         N_ID_CELL, N_UL_ANT,
+                                                         subframe))
+        return -1;
+    // Pass the resource grid straight through, except for a deep fade
+    // over three data symbols
+    for(uint32 L=0; L<14; L++)
+    {
+        for(uint32 i=0; i<phy_struct->N_rb_ul*phy_struct->N_sc_rb_ul; i++)
+        {
+            if(L < first_faded_symb || L >= first_faded_symb+3)
+                subframe->rx_symb[L][i] = subframe->tx_symb[0][L][i];
+            else
+                subframe->rx_symb[L][i] = 0;
+        }
+    }
+    return 0;
+}
+
+int pusch_soft_combining(LIBLTE_PHY_STRUCT             *phy_struct,
+                         LIBLTE_PHY_SUBFRAME_STRUCT    *subframe,
+                         LIBLTE_PHY_SOFT_BUFFER_STRUCT *soft_buffer)
+{
+    LIBLTE_PHY_ALLOCATION_STRUCT alloc;
+    alloc.msg[0].N_bits = 208;
+    for(uint32 i=0; i<alloc.msg[0].N_bits; i++)
+        alloc.msg[0].msg[i] = (i*7)%3 == 0;
+    alloc.pre_coder_type = LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY;
+    alloc.mod_type = LIBLTE_PHY_MODULATION_TYPE_QPSK;
+    alloc.chan_type = LIBLTE_PHY_CHAN_TYPE_ULSCH;
+    alloc.tbs = 208;
+    alloc.N_prb = 8;
+    for(uint32 i=0; i<8; i++)
+    {
+        alloc.prb[0][i] = i;
+        alloc.prb[1][i] = i;
+    }
+    alloc.N_codewords = 1;
+    alloc.N_layers = 1;
+    alloc.tx_mode = 1;
+    alloc.harq_retx_count = 0;
+    alloc.rnti = 61;
+    alloc.mcs = 0;
+    alloc.tpc = 0;
+    alloc.harq_process = 0;
+    alloc.ndi = true;
+    alloc.dl_alloc = false;
+    memset((void*)subframe, 0, sizeof(LIBLTE_PHY_SUBFRAME_STRUCT));
+    subframe->num = 1;
+
+    // Each transmission loses a different part of the subframe, so
+    // neither decodes on its own
+    LIBLTE_BIT_MSG_STRUCT msg;
+    soft_buffer->N_combined = 0;
+    if(0 != pusch_soft_combining_tx_rx(phy_struct, subframe, &alloc, 0, 0))
+        return -1;
+    if(LIBLTE_SUCCESS == liblte_phy_pusch_channel_decode(phy_struct, subframe, &alloc,
+                                                         N_ID_CELL, N_UL_ANT, 4, soft_buffer,
+                                                         msg.msg, &msg.N_bits))
+        return -1;
+    if(0 != pusch_soft_combining_tx_rx(phy_struct, subframe, &alloc, 2, 7))
+        return -1;
+    if(LIBLTE_SUCCESS == liblte_phy_pusch_channel_decode(phy_struct, subframe, &alloc,
+                                                         N_ID_CELL, N_UL_ANT, 4, NULL,
+                                                         msg.msg, &msg.N_bits))
+        return -1;
+
+    // Combined with the first one the second does
+    if(LIBLTE_SUCCESS != liblte_phy_pusch_channel_decode(phy_struct, subframe, &alloc,
+                                                         N_ID_CELL, N_UL_ANT, 4, soft_buffer,
+                                                         msg.msg, &msg.N_bits))
+        return -1;
+    if(2 != soft_buffer->N_combined)
+        return -1;
+    for(uint32 i=0; i<alloc.msg[0].N_bits; i++)
+        if(msg.msg[i] != alloc.msg[0].msg[i])
+            return -1;
+    return 0;
+}
+
+int pusch_soft_combining_test(LIBLTE_PHY_STRUCT *phy_struct)
+{
+    LIBLTE_PHY_SUBFRAME_STRUCT    *subframe    = (LIBLTE_PHY_SUBFRAME_STRUCT *)malloc(sizeof(LIBLTE_PHY_SUBFRAME_STRUCT));
+    LIBLTE_PHY_SOFT_BUFFER_STRUCT *soft_buffer = (LIBLTE_PHY_SOFT_BUFFER_STRUCT *)malloc(sizeof(LIBLTE_PHY_SOFT_BUFFER_STRUCT));
+    int                            ret         = pusch_soft_combining(phy_struct, subframe, soft_buffer);
+    free(soft_buffer);
+    free(subframe);
+    return ret;
+}
+
 int pucch1_ed_test(LIBLTE_PHY_STRUCT *phy_struct)
 {
     LIBLTE_PHY_SUBFRAME_STRUCT *subframe = (LIBLTE_PHY_SUBFRAME_STRUCT *)malloc(sizeof(LIBLTE_PHY_SUBFRAME_STRUCT));
@@ -1289,6 +1386,299 @@ int pdsch_channel_encode_decode_test(LIBLTE_PHY_STRUCT *phy_struct)
     return 0;
 }
 
+int pdsch_multi_ant_ed(LIBLTE_PHY_STRUCT              *phy_struct,
+                       LIBLTE_PHY_SUBFRAME_STRUCT     *subframe,
+                       uint8                           N_ant,
+                       LIBLTE_PHY_PRE_CODER_TYPE_ENUM  pre_coder_type,
+                       uint32                          N_layers,
+                       uint32                          codebook_idx,
+                       complex                        *h,
+                       LIBLTE_ERROR_ENUM               encode_err,
+                       LIBLTE_ERROR_ENUM               decode_err)
+{
+    LIBLTE_PHY_PDCCH_STRUCT pdcch;
+    pdcch.N_symbs = 2;
+    pdcch.N_dl_alloc = 1;
+    pdcch.N_ul_alloc = 0;
+    pdcch.dl_alloc[0].msg[0].N_bits = 200;
+    for(uint32 i=0; i<pdcch.dl_alloc[0].msg[0].N_bits; i++)
+        pdcch.dl_alloc[0].msg[0].msg[i] = (i*7)%3 == 0;
+    pdcch.dl_alloc[0].pre_coder_type = pre_coder_type;
+    pdcch.dl_alloc[0].mod_type = LIBLTE_PHY_MODULATION_TYPE_QPSK;
+    pdcch.dl_alloc[0].chan_type = LIBLTE_PHY_CHAN_TYPE_DLSCH;
+    pdcch.dl_alloc[0].tbs = 208;
+    pdcch.dl_alloc[0].rv_idx = 0;
+    pdcch.dl_alloc[0].N_prb = 8;
+    for(uint32 i=0; i<8; i++)
+    {
+        pdcch.dl_alloc[0].prb[0][i] = i;
+        pdcch.dl_alloc[0].prb[1][i] = i;
+    }
+    pdcch.dl_alloc[0].N_codewords = 1;
+    pdcch.dl_alloc[0].N_layers = N_layers;
+    pdcch.dl_alloc[0].tx_mode = 2;
+    if(LIBLTE_PHY_PRE_CODER_TYPE_SPATIAL_MULTIPLEXING == pre_coder_type)
+        pdcch.dl_alloc[0].tx_mode = 4;
+    pdcch.dl_alloc[0].codebook_idx = codebook_idx;
+    pdcch.dl_alloc[0].harq_retx_count = 0;
+    pdcch.dl_alloc[0].rnti = 61;
+    pdcch.dl_alloc[0].mcs = 0;
+    pdcch.dl_alloc[0].tpc = 0;
+    pdcch.dl_alloc[0].harq_process = 0;
+    pdcch.dl_alloc[0].ndi = true;
+    pdcch.dl_alloc[0].dl_alloc = false;
+    memset((void*)subframe, 0, sizeof(LIBLTE_PHY_SUBFRAME_STRUCT));
+    subframe->num = 0;
+    if(LIBLTE_SUCCESS != liblte_phy_map_crs(phy_struct, subframe, N_ID_CELL, N_ant))
+        return -1;
+    if(encode_err != liblte_phy_pdsch_channel_encode(phy_struct, &pdcch,
+                                                     N_ID_CELL, N_ant,
+                                                     subframe))
+        return -1;
+    if(LIBLTE_SUCCESS != encode_err)
+        return 0;
+    // Combine all antenna ports into a single receive antenna through
+    // a different flat channel per antenna port
+    for(uint32 i=0; i<phy_struct->N_samps_per_subfr; i++)
+        samp_buf[i] = complex(0, 0);
+    for(uint32 p=0; p<N_ant; p++)
+    {
+        if(LIBLTE_SUCCESS != liblte_phy_create_dl_subframe(phy_struct, subframe, p, samp_buf2))
+            return -1;
+        for(uint32 i=0; i<phy_struct->N_samps_per_subfr; i++)
+            samp_buf[i] += h[p]*samp_buf2[i];
+    }
+    if(LIBLTE_SUCCESS != liblte_phy_get_dl_subframe_and_ce(phy_struct, samp_buf, 0,
+                                                           subframe->num, N_ID_CELL,
+                                                           N_ant, subframe))
+        return -1;
+    LIBLTE_BIT_MSG_STRUCT msg;
+    if(decode_err != liblte_phy_pdsch_channel_decode(phy_struct, subframe, &pdcch.dl_alloc[0],
+                                                     pdcch.N_symbs, N_ID_CELL, N_ant, 1,
+                                                     msg.msg, &msg.N_bits))
+        return -1;
+    if(LIBLTE_SUCCESS != decode_err)
+        return 0;
+    for(uint32 i=0; i<pdcch.dl_alloc[0].msg[0].N_bits; i++)
+        if(msg.msg[i] != pdcch.dl_alloc[0].msg[0].msg[i])
+            return -1;
+    return 0;
+}
+
+int pdsch_multi_ant_ed_test(LIBLTE_PHY_STRUCT              *phy_struct,
+                            uint8                           N_ant,
+                            LIBLTE_PHY_PRE_CODER_TYPE_ENUM  pre_coder_type,
+                            uint32                          N_layers,
+                            uint32                          codebook_idx,
+                            complex                        *h,
+                            LIBLTE_ERROR_ENUM               encode_err = LIBLTE_SUCCESS,
+                            LIBLTE_ERROR_ENUM               decode_err = LIBLTE_SUCCESS)
+{
+    LIBLTE_PHY_SUBFRAME_STRUCT *subframe = (LIBLTE_PHY_SUBFRAME_STRUCT *)malloc(sizeof(LIBLTE_PHY_SUBFRAME_STRUCT));
+    int                         ret      = pdsch_multi_ant_ed(phy_struct, subframe, N_ant, pre_coder_type,
+                                                              N_layers, codebook_idx, h,
+                                                              encode_err, decode_err);
+    free(subframe);
+    return ret;
+}
+
+int pdsch_multi_ant_encode_decode_test(LIBLTE_PHY_STRUCT *phy_struct)
+{
+    complex h[4] = {complex(1, 0), complex_polar(0.8, 1.0), complex_polar(0.6, -2.0), complex_polar(0.9, 2.5)};
+    if(0 != pdsch_multi_ant_ed_test(phy_struct, 2, LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY, 1, 0, h))
+        return -1;
+    if(0 != pdsch_multi_ant_ed_test(phy_struct, 4, LIBLTE_PHY_PRE_CODER_TYPE_TX_DIVERSITY, 1, 0, h))
+        return -1;
+    for(uint32 i=0; i<4; i++)
+        if(0 != pdsch_multi_ant_ed_test(phy_struct, 2, LIBLTE_PHY_PRE_CODER_TYPE_SPATIAL_MULTIPLEXING, 1, i, h))
+            return -1;
+    // Two layers are sent but can't be separated by one receive antenna
+    if(0 != pdsch_multi_ant_ed_test(phy_struct, 2, LIBLTE_PHY_PRE_CODER_TYPE_SPATIAL_MULTIPLEXING, 2, 1, h,
+                                    LIBLTE_SUCCESS, LIBLTE_ERROR_INVALID_INPUTS))
+        return -1;
+    // Codebook indices past the end of the table
+    if(0 != pdsch_multi_ant_ed_test(phy_struct, 2, LIBLTE_PHY_PRE_CODER_TYPE_SPATIAL_MULTIPLEXING, 1, 4, h,
+                                    LIBLTE_ERROR_INVALID_INPUTS) ||
+       0 != pdsch_multi_ant_ed_test(phy_struct, 2, LIBLTE_PHY_PRE_CODER_TYPE_SPATIAL_MULTIPLEXING, 2, 3, h,
+                                    LIBLTE_ERROR_INVALID_INPUTS))
+        return -1;
+    // Spatial multiplexing is not supported on 4 antenna ports
+    if(0 != pdsch_multi_ant_ed_test(phy_struct, 4, LIBLTE_PHY_PRE_CODER_TYPE_SPATIAL_MULTIPLEXING, 2, 0, h,
+                                    LIBLTE_ERROR_INVALID_INPUTS))
+        return -1;
+    return 0;
+}
+
+int dl_kernels_ed_test(LIBLTE_PHY_STRUCT *phy_struct,
+                       uint32             N_rb_dl)
+{
+    if(LIBLTE_SUCCESS != liblte_phy_update_n_rb_dl(phy_struct, N_rb_dl))
+        return -1;
+    if(phy_struct->dl_kernels_idx == 0)
+        return -1;
+    LIBLTE_PHY_SUBFRAME_STRUCT *subframe     = (LIBLTE_PHY_SUBFRAME_STRUCT *)malloc(sizeof(LIBLTE_PHY_SUBFRAME_STRUCT));
+    LIBLTE_PHY_SUBFRAME_STRUCT *ref_subframe = (LIBLTE_PHY_SUBFRAME_STRUCT *)malloc(sizeof(LIBLTE_PHY_SUBFRAME_STRUCT));
+    memset((void*)subframe, 0, sizeof(LIBLTE_PHY_SUBFRAME_STRUCT));
+    memset((void*)ref_subframe, 0, sizeof(LIBLTE_PHY_SUBFRAME_STRUCT));
+    subframe->num = 5;
+    if(LIBLTE_SUCCESS != liblte_phy_map_crs(phy_struct, subframe, N_ID_CELL, 2))
+        return -1;
+    for(uint32 i=0; i<N_rb_dl*LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP; i++)
+        subframe->tx_symb[0][3][i] = complex((i%3)-1.0, (i%5)-2.0);
+    for(uint32 p=0; p<2; p++)
+    {
+        if(LIBLTE_SUCCESS != liblte_phy_create_dl_subframe(phy_struct, subframe, p, &samp_buf2[0]))
+            return -1;
+        for(uint32 i=0; i<phy_struct->N_samps_per_subfr; i++)
+        {
+            if(p == 0)
+                samp_buf[5*phy_struct->N_samps_per_subfr+i] = samp_buf2[i];
+            else
+                samp_buf[5*phy_struct->N_samps_per_subfr+i] += samp_buf2[i]*complex(0, 0.5);
+        }
+    }
+
+    for(uint32 i=0; i<phy_struct->N_samps_per_subfr; i++)
+        samp_buf[6*phy_struct->N_samps_per_subfr+i] = 0;
+
+    // Run the same subframe through the specialized and generic kernels
+    if(LIBLTE_SUCCESS != liblte_phy_get_dl_subframe_and_ce(phy_struct, samp_buf, 0, 5, N_ID_CELL, 2, subframe))
+        return -1;
+    uint32 kernels_idx         = phy_struct->dl_kernels_idx;
+    phy_struct->dl_kernels_idx = 0;
+    if(LIBLTE_SUCCESS != liblte_phy_get_dl_subframe_and_ce(phy_struct, samp_buf, 0, 5, N_ID_CELL, 2, ref_subframe))
+        return -1;
+    phy_struct->dl_kernels_idx = kernels_idx;
+    for(uint32 L=0; L<14; L++)
+    {
+        for(uint32 i=0; i<N_rb_dl*LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP; i++)
+        {
+            if(std::abs(subframe->rx_symb[L][i] - ref_subframe->rx_symb[L][i]) > 0.0001 ||
+               std::abs(subframe->rx_ce[0][L][i] - ref_subframe->rx_ce[0][L][i]) > 0.0001 ||
+               std::abs(subframe->rx_ce[1][L][i] - ref_subframe->rx_ce[1][L][i]) > 0.0001)
+                return -1;
+        }
+    }
+    for(uint32 i=0; i<N_rb_dl*LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP; i++)
+    {
+        if(std::abs(subframe->rx_symb[3][i]/subframe->rx_ce[0][3][i] - subframe->tx_symb[0][3][i]) > 0.05 ||
+           std::abs(subframe->rx_ce[1][3][i]/subframe->rx_ce[0][3][i] - complex(0, 0.5)) > 0.05)
+            return -1;
+    }
+    free(subframe);
+    free(ref_subframe);
+    return 0;
+}
+
+int dl_kernels_test(LIBLTE_PHY_STRUCT *phy_struct)
+{
+    if(0 != dl_kernels_ed_test(phy_struct, LIBLTE_PHY_N_RB_DL_1_4MHZ))
+        return -1;
+    if(0 != dl_kernels_ed_test(phy_struct, LIBLTE_PHY_N_RB_DL_3MHZ))
+        return -1;
+    if(0 != dl_kernels_ed_test(phy_struct, LIBLTE_PHY_N_RB_DL_5MHZ))
+        return -1;
+    return 0;
+}
+
+int dl_subframe_cache_test(LIBLTE_PHY_STRUCT *phy_struct)
+{
+    LIBLTE_PHY_SUBFRAME_STRUCT *subframe     = (LIBLTE_PHY_SUBFRAME_STRUCT *)malloc(sizeof(LIBLTE_PHY_SUBFRAME_STRUCT));
+    LIBLTE_PHY_SUBFRAME_STRUCT *ref_subframe = (LIBLTE_PHY_SUBFRAME_STRUCT *)malloc(sizeof(LIBLTE_PHY_SUBFRAME_STRUCT));
+    memset((void*)subframe, 0, sizeof(LIBLTE_PHY_SUBFRAME_STRUCT));
+    memset((void*)ref_subframe, 0, sizeof(LIBLTE_PHY_SUBFRAME_STRUCT));
+    // Three consecutive subframes so the next slot CRS used by ports 2 and 3 is present
+    for(uint32 n=0; n<3; n++)
+    {
+        complex *samps = &samp_buf[n*phy_struct->N_samps_per_subfr];
+        memset((void*)subframe, 0, sizeof(LIBLTE_PHY_SUBFRAME_STRUCT));
+        subframe->num = n;
+        if(LIBLTE_SUCCESS != liblte_phy_map_crs(phy_struct, subframe, N_ID_CELL, 4))
+            return -1;
+        for(uint32 p=0; p<4; p++)
+        {
+            if(LIBLTE_SUCCESS != liblte_phy_create_dl_subframe(phy_struct, subframe, p, &samp_buf2[0]))
+                return -1;
+            for(uint32 i=0; i<phy_struct->N_samps_per_subfr; i++)
+            {
+                if(p == 0)
+                    samps[i] = samp_buf2[i];
+                else
+                    samps[i] += samp_buf2[i]*complex_polar(1.0/(p+1), p);
+            }
+        }
+    }
+    if(LIBLTE_SUCCESS != liblte_phy_get_dl_subframe_and_ce(phy_struct, samp_buf, 0, 0, N_ID_CELL, 4, ref_subframe))
+        return -1;
+
+    // Control region, then the central PRBs of the PBCH symbols
+    uint32 N_sc      = LIBLTE_PHY_N_SC_RB_DL_NORMAL_CP;
+    uint32 first_prb = (phy_struct->N_rb_dl - 6)/2;
+    uint32 N_prb     = 6 + (phy_struct->N_rb_dl % 2);
+    subframe->rx_valid = false;
+    if(LIBLTE_SUCCESS != liblte_phy_get_dl_subframe_and_ce(phy_struct, samp_buf, 0, 0, 0, N_ID_CELL, 4,
+                                                           0, phy_struct->N_rb_dl, 0, 3, subframe))
+        return -1;
+    if(subframe->rx_symb_mask != 0x117)
+        return -1;
+    for(uint32 p=0; p<4; p++)
+        for(uint32 L=0; L<3; L++)
+            for(uint32 i=0; i<phy_struct->N_rb_dl*N_sc; i++)
+                if(std::abs(subframe->rx_ce[p][L][i] - ref_subframe->rx_ce[p][L][i]) > 0.001*std::abs(ref_subframe->rx_ce[p][L][i]))
+                    return -1;
+    if(LIBLTE_SUCCESS != liblte_phy_get_dl_subframe_and_ce(phy_struct, samp_buf, 0, 0, 0, N_ID_CELL, 4,
+                                                           first_prb, N_prb, 7, 4, subframe))
+        return -1;
+    for(uint32 p=0; p<4; p++)
+        for(uint32 L=7; L<11; L++)
+            for(uint32 i=first_prb*N_sc; i<(first_prb+N_prb)*N_sc; i++)
+                if(std::abs(subframe->rx_symb[L][i] - ref_subframe->rx_symb[L][i]) > 0.001*std::abs(ref_subframe->rx_symb[L][i]) ||
+                   std::abs(subframe->rx_ce[p][L][i] - ref_subframe->rx_ce[p][L][i]) > 0.001*std::abs(ref_subframe->rx_ce[p][L][i]))
+                    return -1;
+
+    // Asking for a covered region again must not redo the work, new samples must
+    subframe->rx_ce[0][8][first_prb*N_sc] = 0;
+    if(LIBLTE_SUCCESS != liblte_phy_get_dl_subframe_and_ce(phy_struct, samp_buf, 0, 0, 0, N_ID_CELL, 2,
+                                                           first_prb+1, 2, 8, 2, subframe))
+        return -1;
+    if(subframe->rx_ce[0][8][first_prb*N_sc] != complex(0, 0))
+        return -1;
+
+    // The control region is still remembered after the PBCH region
+    subframe->rx_ce[3][1][0] = 0;
+    if(LIBLTE_SUCCESS != liblte_phy_get_dl_subframe_and_ce(phy_struct, samp_buf, 0, 0, 0, N_ID_CELL, 4,
+                                                           0, phy_struct->N_rb_dl, 1, 2, subframe))
+        return -1;
+    if(subframe->rx_ce[3][1][0] != complex(0, 0))
+        return -1;
+    if(LIBLTE_SUCCESS != liblte_phy_get_dl_subframe_and_ce(phy_struct, samp_buf, 1, 0, 0, N_ID_CELL, 2,
+                                                           first_prb+1, 2, 8, 2, subframe))
+        return -1;
+    if((subframe->rx_symb_mask & 0x7) != 0)
+        return -1;
+    if(LIBLTE_SUCCESS != liblte_phy_get_dl_subframe_and_ce(phy_struct, samp_buf, 1, 0, 0, N_ID_CELL, 4,
+                                                           first_prb, N_prb, 7, 4, subframe))
+        return -1;
+    if(std::abs(subframe->rx_ce[0][8][first_prb*N_sc] - ref_subframe->rx_ce[0][8][first_prb*N_sc]) > 0.001*std::abs(ref_subframe->rx_ce[0][8][first_prb*N_sc]))
+        return -1;
+    if(LIBLTE_SUCCESS != liblte_phy_get_dl_subframe_and_ce(phy_struct, samp_buf, phy_struct->N_samps_per_subfr,
+                                                           1, N_ID_CELL, 4, subframe))
+        return -1;
+    memset((void*)ref_subframe, 0, sizeof(LIBLTE_PHY_SUBFRAME_STRUCT));
+    if(LIBLTE_SUCCESS != liblte_phy_get_dl_subframe_and_ce(phy_struct, samp_buf, phy_struct->N_samps_per_subfr,
+                                                           1, N_ID_CELL, 4, ref_subframe))
+        return -1;
+    for(uint32 p=0; p<4; p++)
+        for(uint32 L=0; L<14; L++)
+            for(uint32 i=0; i<phy_struct->N_rb_dl*N_sc; i++)
+                if(subframe->rx_ce[p][L][i] != ref_subframe->rx_ce[p][L][i])
+                    return -1;
+    memset((void*)samp_buf, 0, sizeof(complex)*3*phy_struct->N_samps_per_subfr);
+    free(subframe);
+    free(ref_subframe);
+    return 0;
+}
+
 int mod_test(LIBLTE_PHY_STRUCT *phy_struct, uint32 tbs, uint8 N_prb, LIBLTE_PHY_MODULATION_TYPE_ENUM mod_type)
 {
 //    LIBLTE_PHY_PDCCH_STRUCT pdcch;
@@ -1829,6 +2219,17 @@ int pss_sss_test(LIBLTE_PHY_STRUCT *phy_struct)
         return -1;
     if(N_id_2 != N_ID_CELL%3 || pss_symb != 6)
         return -1;
+    uint32 fine_start = timing_struct.symb_starts[0][6];
+    timing_struct.symb_starts[0][0] = 0;
+    for(uint32 i=1; i<7; i++)
+        timing_struct.symb_starts[0][i] = (512*i)+40+(36*(i-1)) - 2;
+    if(LIBLTE_SUCCESS != liblte_phy_find_pss_and_fine_timing(phy_struct, samp_buf,
+                                                             timing_struct.symb_starts[0],
+                                                             &N_id_2, &pss_symb, &pss_thresh,
+                                                             &freq_offset))
+        return -1;
+    if(N_id_2 != N_ID_CELL%3 || timing_struct.symb_starts[0][6] != fine_start)
+        return -1;
     uint32 N_id_1;
     uint32 fr_start_idx;
     timing_struct.symb_starts[0][0] = 0;
@@ -1844,6 +2245,21 @@ int pss_sss_test(LIBLTE_PHY_STRUCT *phy_struct)
         return -1;
     if(N_id_1 != (N_ID_CELL - (N_ID_CELL%3))/3 || fr_start_idx != 0)
         return -1;
+    subframe->num = 5;
+    for(uint32 i=0; i<168; i+=23)
+    {
+        if(LIBLTE_SUCCESS != liblte_phy_map_sss(phy_struct, subframe, i, N_ID_CELL%3, N_DL_ANT))
+            return -1;
+        if(LIBLTE_SUCCESS != liblte_phy_create_dl_subframe(phy_struct, subframe, 0, samp_buf))
+            return -1;
+        timing_struct.symb_starts[0][5] = (512*5)+40+(36*4);
+        if(LIBLTE_SUCCESS != liblte_phy_find_sss(phy_struct, samp_buf, N_id_2,
+                                                 timing_struct.symb_starts[0], pss_thresh/2,
+                                                 &N_id_1, &fr_start_idx))
+            return -1;
+        if(N_id_1 != i || fr_start_idx != phy_struct->N_samps_per_frame/2)
+            return -1;
+    }
     free(subframe);
     return 0;
 }
@@ -1953,11 +2369,73 @@ int gets_test(LIBLTE_PHY_STRUCT *phy_struct)
         return -1;
     if(tbs != 1544 || N_prb != 6)
         return -1;
+    if(LIBLTE_SUCCESS != liblte_phy_get_tbs_and_n_prb_for_ul(100000, LIBLTE_PHY_N_RB_UL_5MHZ,
+                                                             20, &tbs, &N_prb))
+        return -1;
+    if(tbs != 10680 || N_prb != 25)
+        return -1;
+    if(LIBLTE_SUCCESS != liblte_phy_get_tbs_and_n_prb_for_ul(100000, 7, 0, &tbs, &N_prb))
+        return -1;
+    if(tbs != 152 || N_prb != 6)
+        return -1;
     uint32 N_cce;
     if(LIBLTE_SUCCESS != liblte_phy_get_n_cce(phy_struct, 1.0, 2, N_DL_ANT, &N_cce))
         return -1;
     if(N_cce != 12)
         return -1;
+    if(1 != liblte_phy_get_rbg_size(LIBLTE_PHY_N_RB_DL_1_4MHZ) ||
+       2 != liblte_phy_get_rbg_size(LIBLTE_PHY_N_RB_DL_5MHZ)   ||
+       3 != liblte_phy_get_rbg_size(LIBLTE_PHY_N_RB_DL_10MHZ)  ||
+       4 != liblte_phy_get_rbg_size(LIBLTE_PHY_N_RB_DL_20MHZ))
+        return -1;
+    return 0;
+}
+
+int sample_conversion_test(void)
+{
+    static complex fc32[1000];
+    static complex fc32_out[1000];
+    static int16   sc16[2001];
+    uint32         N_samps[4] = {1, 7, 17, 1000};
+    uint32         i;
+    uint32         j;
+
+    // Include rounding ties and values needing saturation
+    for(i=0; i<1000; i++)
+        fc32[i] = complex(((int32)(i*7919 % 2001) - 1000)*1.37f, ((int32)(i*104729 % 2001) - 1000)*0.25f);
+    fc32[3] = complex(1000, -1000);
+    fc32[5] = complex(0.5/40, -2.5/40);
+
+    for(j=0; j<4; j++)
+    {
+        memset(sc16, 0x55, sizeof(sc16));
+        liblte_phy_fc32_to_sc16(fc32, 40, N_samps[j], sc16);
+        for(i=0; i<N_samps[j]*2; i++)
+        {
+            float x = ((float *)fc32)[i]*40;
+            if(x > 32767)
+                x = 32767;
+            if(x < -32768)
+                x = -32768;
+            if(sc16[i] != (int16)lrintf(x))
+                return -1;
+        }
+        if(sc16[N_samps[j]*2] != 0x5555)
+            return -1;
+
+        liblte_phy_sc16_to_fc32(sc16, 1.0/40, N_samps[j], fc32_out);
+        for(i=0; i<N_samps[j]; i++)
+            if(fc32_out[i] != complex(sc16[i*2]*(float)(1.0/40), sc16[i*2+1]*(float)(1.0/40)))
+                return -1;
+
+        liblte_phy_scale_fc32(fc32, 1.0/50, N_samps[j], fc32_out);
+        for(i=0; i<N_samps[j]; i++)
+            if(fc32_out[i] != complex(fc32[i].real()*(float)(1.0/50), fc32[i].imag()*(float)(1.0/50)))
+                return -1;
+    }
+    if(sc16[6] != 32767 || sc16[7] != -32768 || sc16[10] != 0 || sc16[11] != -2)
+        return -1;
+
     return 0;
 }
 
@@ -2008,6 +2486,10 @@ int main(int argc, char *argv[])
     if(0 != pusch_channel_encode_decode_test(phy_struct))
         exit(-1);
     printf("pass\n");
+    printf("pusch_soft_combining_test: ");
+    if(0 != pusch_soft_combining_test(phy_struct))
+        exit(-1);
+    printf("pass\n");
     printf("pucch_channel_encode_decode_test: ");
     if(0 != pucch_channel_encode_decode_test(phy_struct))
         exit(-1);
@@ -2024,6 +2506,18 @@ int main(int argc, char *argv[])
     if(0 != pdsch_channel_encode_decode_test(phy_struct))
         exit(-1);
     printf("pass\n");
+    printf("pdsch_multi_ant_encode_decode_test: ");
+    if(0 != pdsch_multi_ant_encode_decode_test(phy_struct))
+        exit(-1);
+    printf("pass\n");
+    printf("dl_kernels_test: ");
+    if(0 != dl_kernels_test(phy_struct))
+        exit(-1);
+    printf("pass\n");
+    printf("dl_subframe_cache_test: ");
+    if(0 != dl_subframe_cache_test(phy_struct))
+        exit(-1);
+    printf("pass\n");
     printf("modulation_test: ");
     if(0 != modulation_test(phy_struct))
         exit(-1);
@@ -2044,6 +2538,10 @@ int main(int argc, char *argv[])
     if(0 != dl_find_coarse_timing_and_freq_offset_test(phy_struct))
         exit(-1);
     printf("pass\n");
+    printf("sample_conversion_test: ");
+    if(0 != sample_conversion_test())
+        exit(-1);
+    printf("pass\n");
     printf("gets_test: ");
     if(0 != gets_test(phy_struct))
         exit(-1);
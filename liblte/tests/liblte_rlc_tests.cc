@@ -234,6 +234,126 @@ int status_pdu_test(void)
     return 0;
 }
 
+int pdu_header_test(void)
+{
+    if(liblte_rlc_get_umd_pdu_header_size(LIBLTE_RLC_UMD_SN_SIZE_5_BITS, 1) != 1 ||
+       liblte_rlc_get_umd_pdu_header_size(LIBLTE_RLC_UMD_SN_SIZE_10_BITS, 1) != 2 ||
+       liblte_rlc_get_umd_pdu_header_size(LIBLTE_RLC_UMD_SN_SIZE_10_BITS, 2) != 4 ||
+       liblte_rlc_get_umd_pdu_header_size(LIBLTE_RLC_UMD_SN_SIZE_10_BITS, 3) != 5 ||
+       liblte_rlc_get_amd_pdu_header_size(LIBLTE_RLC_RF_FIELD_AMD_PDU, 1) != 2 ||
+       liblte_rlc_get_amd_pdu_header_size(LIBLTE_RLC_RF_FIELD_AMD_PDU, 4) != 7 ||
+       liblte_rlc_get_amd_pdu_header_size(LIBLTE_RLC_RF_FIELD_AMD_PDU_SEGMENT, 1) != 4)
+        return -1;
+    LIBLTE_RLC_UMD_PDU_HEADER_STRUCT umd_hdr;
+    umd_hdr.fi = LIBLTE_RLC_FI_FIELD_MIDDLE_SDU_SEGMENT;
+    umd_hdr.sn_size = LIBLTE_RLC_UMD_SN_SIZE_10_BITS;
+    umd_hdr.sn = 0x2A5;
+    uint16 li[3] = {3, 2, 4};
+    LIBLTE_BYTE_MSG_STRUCT pdu;
+    if(LIBLTE_SUCCESS != liblte_rlc_pack_umd_pdu_header(&umd_hdr, li, 3, &pdu))
+        return -1;
+    if(pdu.N_bytes != 5)
+        return -1;
+    for(uint32 i=0; i<9; i++)
+        pdu.msg[pdu.N_bytes++] = i;
+    LIBLTE_RLC_UMD_PDU_STRUCT umd;
+    umd.hdr.sn_size = LIBLTE_RLC_UMD_SN_SIZE_10_BITS;
+    if(LIBLTE_SUCCESS != liblte_rlc_unpack_umd_pdu(&pdu, &umd))
+        return -1;
+    if(umd.hdr.fi != LIBLTE_RLC_FI_FIELD_MIDDLE_SDU_SEGMENT || umd.hdr.sn != 0x2A5 ||
+       umd.N_data != 3 || umd.data[0].N_bytes != 3 || umd.data[1].N_bytes != 2 ||
+       umd.data[2].N_bytes != 4 || umd.data[0].msg[0] != 0 || umd.data[1].msg[0] != 3 ||
+       umd.data[2].msg[3] != 8)
+        return -1;
+    LIBLTE_RLC_AMD_PDU_HEADER_STRUCT amd_hdr;
+    amd_hdr.dc = LIBLTE_RLC_DC_FIELD_DATA_PDU;
+    amd_hdr.rf = LIBLTE_RLC_RF_FIELD_AMD_PDU;
+    amd_hdr.p = LIBLTE_RLC_P_FIELD_STATUS_REPORT_NOT_REQUESTED;
+    amd_hdr.fi = LIBLTE_RLC_FI_FIELD_FIRST_SDU_SEGMENT;
+    amd_hdr.sn = 7;
+    if(LIBLTE_SUCCESS != liblte_rlc_pack_amd_pdu_header(&amd_hdr, li, 3, &pdu))
+        return -1;
+    if(pdu.N_bytes != 5)
+        return -1;
+    for(uint32 i=0; i<9; i++)
+        pdu.msg[pdu.N_bytes++] = i;
+    LIBLTE_RLC_AMD_PDUS_STRUCT amd;
+    if(LIBLTE_SUCCESS != liblte_rlc_unpack_amd_pdu(&pdu, &amd))
+        return -1;
+    if(amd.N_pdu != 3 || amd.pdu[0].hdr.sn != 7 ||
+       amd.pdu[0].hdr.fi != LIBLTE_RLC_FI_FIELD_FULL_SDU ||
+       amd.pdu[2].hdr.fi != LIBLTE_RLC_FI_FIELD_FIRST_SDU_SEGMENT ||
+       amd.pdu[0].data.N_bytes != 3 || amd.pdu[1].data.N_bytes != 2 ||
+       amd.pdu[2].data.N_bytes != 4 || amd.pdu[2].data.msg[0] != 5)
+        return -1;
+    li[0] = 0x800;
+    if(LIBLTE_ERROR_INVALID_INPUTS != liblte_rlc_pack_amd_pdu_header(&amd_hdr, li, 2, &pdu))
+        return -1;
+    return 0;
+}
+
+int am_sn_wrap_test(void)
+{
+    if(!liblte_rlc_am_sn_in_tx_window(0, 0) ||
+       !liblte_rlc_am_sn_in_tx_window(511, 0) ||
+       liblte_rlc_am_sn_in_tx_window(512, 0) ||
+       !liblte_rlc_am_sn_in_tx_window(1023, 1000) ||
+       !liblte_rlc_am_sn_in_tx_window(487, 1000) ||
+       liblte_rlc_am_sn_in_tx_window(488, 1000) ||
+       liblte_rlc_am_sn_in_tx_window(999, 1000))
+        return -1;
+
+    // Send well past several SN wraps, acknowledging every 100 PDUs
+    // the way the eNodeB walks its transmission buffer from VT(A)
+    LIBLTE_RLC_AMD_PDU_HEADER_STRUCT amd_hdr;
+    LIBLTE_RLC_AMD_PDUS_STRUCT       amd;
+    LIBLTE_RLC_STATUS_PDU_STRUCT     status;
+    LIBLTE_BYTE_MSG_STRUCT           pdu;
+    bool                             tx_buffer[LIBLTE_RLC_AM_SN_MOD] = {false};
+    uint32                           N_buffered = 0;
+    uint16                           vt_a       = 0;
+    uint16                           vt_s       = 0;
+    amd_hdr.dc = LIBLTE_RLC_DC_FIELD_DATA_PDU;
+    amd_hdr.rf = LIBLTE_RLC_RF_FIELD_AMD_PDU;
+    amd_hdr.p  = LIBLTE_RLC_P_FIELD_STATUS_REPORT_REQUESTED;
+    amd_hdr.fi = LIBLTE_RLC_FI_FIELD_FULL_SDU;
+    for(uint32 i=0; i<3*LIBLTE_RLC_AM_SN_MOD; i++)
+    {
+        if(!liblte_rlc_am_sn_in_tx_window(vt_s, vt_a))
+            return -1;
+        amd_hdr.sn = vt_s;
+        if(LIBLTE_SUCCESS != liblte_rlc_pack_amd_pdu_header(&amd_hdr, NULL, 1, &pdu))
+            return -1;
+        pdu.msg[pdu.N_bytes++] = i;
+        if(LIBLTE_SUCCESS != liblte_rlc_unpack_amd_pdu(&pdu, &amd) ||
+           amd.pdu[0].hdr.sn != vt_s || tx_buffer[vt_s])
+            return -1;
+        tx_buffer[vt_s] = true;
+        N_buffered++;
+        vt_s = (vt_s + 1) % LIBLTE_RLC_AM_SN_MOD;
+
+        if(99 == i % 100)
+        {
+            status.ack_sn = vt_s;
+            status.N_nack = 0;
+            if(LIBLTE_SUCCESS != liblte_rlc_pack_status_pdu(&status, &pdu) ||
+               LIBLTE_SUCCESS != liblte_rlc_unpack_status_pdu(&pdu, &status))
+                return -1;
+            while(vt_a != status.ack_sn)
+            {
+                if(!tx_buffer[vt_a])
+                    return -1;
+                tx_buffer[vt_a] = false;
+                N_buffered--;
+                vt_a = (vt_a + 1) % LIBLTE_RLC_AM_SN_MOD;
+            }
+            if(0 != N_buffered)
+                return -1;
+        }
+    }
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
     printf("umd_pdu_test: ");
@@ -244,9 +364,17 @@ int main(int argc, char *argv[])
     if(0 != amd_pdu_test())
         exit(-1);
     printf("pass\n");
+    printf("pdu_header_test: ");
+    if(0 != pdu_header_test())
+        exit(-1);
+    printf("pass\n");
     printf("status_pdu_test: ");
     if(0 != status_pdu_test())
         exit(-1);
     printf("pass\n");
+    printf("am_sn_wrap_test: ");
+    if(0 != am_sn_wrap_test())
+        exit(-1);
+    printf("pass\n");
     exit(0);
 }
@@ -0,0 +1,118 @@
+/*******************************************************************************
+
+    Copyright 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************
+
+    File: liblte_security_bench.cc
+
+    Description: Measures ciphering throughput of the LTE security
+                 library for PDCP sized PDUs.  Built twice, with and
+                 without AES-NI.
+
+    Revision History
+    ----------    -------------    --------------------------------------------
+    10/18/2026    agent            Created file.
+
+*******************************************************************************/
+
+/*******************************************************************************
+                              INCLUDES
+*******************************************************************************/
+
+#include "liblte_security.h"
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+/*******************************************************************************
+                              DEFINES
+*******************************************************************************/
+
+#define N_PDUS       64
+#define PDU_SIZE     1500
+#define N_ITERATIONS 200
+
+/*******************************************************************************
+                              TYPEDEFS
+*******************************************************************************/
+
+
+/*******************************************************************************
+                              GLOBAL VARIABLES
+*******************************************************************************/
+
+static uint8 msg[N_PDUS][PDU_SIZE];
+static uint8 out[N_PDUS][PDU_SIZE];
+
+/*******************************************************************************
+                              FUNCTIONS
+*******************************************************************************/
+
+double mbytes_per_s(std::chrono::steady_clock::time_point start)
+{
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return (double)N_ITERATIONS*N_PDUS*PDU_SIZE/s/1e6;
+}
+
+int main(int argc, char *argv[])
+{
+    LIBLTE_SECURITY_CIPHER_JOB_STRUCT            jobs[N_PDUS];
+    LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_ENUM  alg[3]  = {LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA1,
+                                                            LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA2,
+                                                            LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA3};
+    const char                                  *name[3] = {"EEA1", "EEA2", "EEA3"};
+    uint8                                        key[16] = {0x2B, 0xD6, 0x45, 0x9F, 0x82, 0xC5, 0xB3, 0x00,
+                                                            0x95, 0x2C, 0x49, 0x10, 0x48, 0x81, 0xFF, 0x48};
+
+    for(uint32 i=0; i<N_PDUS; i++)
+    {
+        memset(msg[i], i, PDU_SIZE);
+        jobs[i].msg       = msg[i];
+        jobs[i].out       = out[i];
+        jobs[i].msg_len   = PDU_SIZE;
+        jobs[i].count     = i;
+        jobs[i].bearer    = 1;
+        jobs[i].direction = 1;
+    }
+
+    printf("AES-NI: %s\n", liblte_security_aes_hw_accelerated() ? "yes" : "no");
+    printf("%u PDUs of %u bytes per batch\n", N_PDUS, PDU_SIZE);
+    for(uint32 a=0; a<3; a++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for(uint32 i=0; i<N_ITERATIONS; i++)
+            liblte_security_encryption_batch(alg[a], key, jobs, N_PDUS);
+        double batch = mbytes_per_s(start);
+
+        start = std::chrono::steady_clock::now();
+        for(uint32 i=0; i<N_ITERATIONS; i++)
+        {
+            for(uint32 j=0; j<N_PDUS; j++)
+            {
+                if(LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA1 == alg[a])
+                    liblte_security_encryption_eea1(key, j, 1, 1, msg[j], PDU_SIZE, out[j]);
+                else if(LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA2 == alg[a])
+                    liblte_security_encryption_eea2(key, j, 1, 1, msg[j], PDU_SIZE, out[j]);
+                else
+                    liblte_security_encryption_eea3(key, j, 1, 1, msg[j], PDU_SIZE, out[j]);
+            }
+        }
+        double single = mbytes_per_s(start);
+
+        printf("%s: batch %7.1f MB/s, single %7.1f MB/s\n", name[a], batch, single);
+    }
+}
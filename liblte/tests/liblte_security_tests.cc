@@ -32,6 +32,7 @@
 *******************************************************************************/
 
 #include "liblte_security.h"
+#include <string.h>
 
 /*******************************************************************************
                               DEFINES
@@ -320,6 +321,201 @@ int milenage_f5_star_test(void)
     return 0;
 }
 
+int aes_encrypt_test(void)
+{
+    // FIPS 197 Appendix C.1
+    uint8 key[16] = {0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0A,0x0B,0x0C,0x0D,0x0E,0x0F};
+    uint8 pt[16]  = {0x00,0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x88,0x99,0xAA,0xBB,0xCC,0xDD,0xEE,0xFF};
+    uint8 ct[16]  = {0x69,0xC4,0xE0,0xD8,0x6A,0x7B,0x04,0x30,0xD8,0xCD,0xB7,0x80,0x70,0xB4,0xC5,0x5A};
+    uint8 out[16];
+    LIBLTE_SECURITY_AES_KEY_SCHEDULE_STRUCT ks;
+    if(LIBLTE_SUCCESS != liblte_security_aes_key_schedule(key, &ks))
+        return -1;
+    if(LIBLTE_SUCCESS != liblte_security_aes_encrypt(&ks, pt, out))
+        return -1;
+    for(int i=0; i<16; i++)
+        if(out[i] != ct[i])
+            return -1;
+    return 0;
+}
+
+int milenage_test_set_1_test(void)
+{
+    // 35.208 v10.0.0 Test Set 1
+    uint8 k[16]      = {0x46,0x5B,0x5C,0xE8,0xB1,0x99,0xB4,0x9F,0xAA,0x5F,0x0A,0x2E,0xE2,0x38,0xA6,0xBC};
+    uint8 rand[16]   = {0x23,0x55,0x3C,0xBE,0x96,0x37,0xA8,0x9D,0x21,0x8A,0xE6,0x4D,0xAE,0x47,0xBF,0x35};
+    uint8 sqn[6]     = {0xFF,0x9B,0xB4,0xD0,0xB6,0x07};
+    uint8 amf[2]     = {0xB9,0xB9};
+    uint8 op[16]     = {0xCD,0xC2,0x02,0xD5,0x12,0x3E,0x20,0xF6,0x2B,0x6D,0x67,0x6A,0xC7,0x2C,0xB3,0x18};
+    uint8 op_c[16]   = {0xCD,0x63,0xCB,0x71,0x95,0x4A,0x9F,0x4E,0x48,0xA5,0x99,0x4E,0x37,0xA0,0x2B,0xAF};
+    uint8 f1[8]      = {0x4A,0x9F,0xFA,0xC3,0x54,0xDF,0xAF,0xB3};
+    uint8 f1_star[8] = {0x01,0xCF,0xAF,0x9E,0xC4,0xE8,0x71,0xE9};
+    uint8 f2[8]      = {0xA5,0x42,0x11,0xD5,0xE3,0xBA,0x50,0xBF};
+    uint8 f3[16]     = {0xB4,0x0B,0xA9,0xA3,0xC5,0x8B,0x2A,0x05,0xBB,0xF0,0xD9,0x87,0xB2,0x1B,0xF8,0xCB};
+    uint8 f4[16]     = {0xF7,0x69,0xBC,0xD7,0x51,0x04,0x46,0x04,0x12,0x76,0x72,0x71,0x1C,0x6D,0x34,0x41};
+    uint8 f5[6]      = {0xAA,0x68,0x9C,0x64,0x83,0x70};
+    uint8 f5_star[6] = {0x45,0x1E,0x8B,0xEC,0xA4,0x3B};
+    uint8 mac_a[8];
+    uint8 mac_s[8];
+    uint8 res[8];
+    uint8 ck[16];
+    uint8 ik[16];
+    uint8 ak[6];
+    uint8 ak_star[6];
+    LIBLTE_SECURITY_MILENAGE_KEY_STRUCT key;
+    if(LIBLTE_SUCCESS != liblte_security_milenage_key_init(k, op, &key))
+        return -1;
+    if(LIBLTE_SUCCESS != liblte_security_milenage_f1(&key, rand, sqn, amf, mac_a)        ||
+       LIBLTE_SUCCESS != liblte_security_milenage_f1_star(&key, rand, sqn, amf, mac_s)   ||
+       LIBLTE_SUCCESS != liblte_security_milenage_f2345(&key, rand, res, ck, ik, ak)     ||
+       LIBLTE_SUCCESS != liblte_security_milenage_f5_star(&key, rand, ak_star))
+        return -1;
+    if(memcmp(key.op_c, op_c, 16)  ||
+       memcmp(mac_a, f1, 8)        ||
+       memcmp(mac_s, f1_star, 8)   ||
+       memcmp(res, f2, 8)          ||
+       memcmp(ck, f3, 16)          ||
+       memcmp(ik, f4, 16)          ||
+       memcmp(ak, f5, 6)           ||
+       memcmp(ak_star, f5_star, 6))
+        return -1;
+    return 0;
+}
+
+int eea1_test(void)
+{
+    // 33.401 v10.0.0 Annex C.1 Test Set 1, LENGTH = 253 bits
+    uint8 key[16] = {0xD3,0xC5,0xD5,0x92,0x32,0x7F,0xB1,0x1C,0x40,0x35,0xC6,0x68,0x0A,0xF8,0xC6,0xD1};
+    uint8 pt[32]  = {0x98,0x1B,0xA6,0x82,0x4C,0x1B,0xFB,0x1A,0xB4,0x85,0x47,0x20,0x29,0xB7,0x1D,0x80,
+                     0x8C,0xE3,0x3E,0x2C,0xC3,0xC0,0xB5,0xFC,0x1F,0x3D,0xE8,0xA6,0xDC,0x66,0xB1,0xF0};
+    uint8 ct[32]  = {0x5D,0x5B,0xFE,0x75,0xEB,0x04,0xF6,0x8C,0xE0,0xA1,0x23,0x77,0xEA,0x00,0xB3,0x7D,
+                     0x47,0xC6,0xA0,0xBA,0x06,0x30,0x91,0x55,0x08,0x6A,0x85,0x9C,0x43,0x41,0xB3,0x78};
+    uint8 out[32];
+    if(LIBLTE_SUCCESS != liblte_security_encryption_eea1(key, 0x398A59B4, 0x15, 1, pt, 32, out))
+        return -1;
+    if(memcmp(out, ct, 31) || (out[31] & 0xF8) != ct[31])
+        return -1;
+    return 0;
+}
+
+int eea2_test(void)
+{
+    // 33.401 v10.0.0 Annex C.1 Test Set 1, LENGTH = 253 bits
+    uint8 key[16] = {0xD3,0xC5,0xD5,0x92,0x32,0x7F,0xB1,0x1C,0x40,0x35,0xC6,0x68,0x0A,0xF8,0xC6,0xD1};
+    uint8 pt[32]  = {0x98,0x1B,0xA6,0x82,0x4C,0x1B,0xFB,0x1A,0xB4,0x85,0x47,0x20,0x29,0xB7,0x1D,0x80,
+                     0x8C,0xE3,0x3E,0x2C,0xC3,0xC0,0xB5,0xFC,0x1F,0x3D,0xE8,0xA6,0xDC,0x66,0xB1,0xF0};
+    uint8 ct[32]  = {0xE9,0xFE,0xD8,0xA6,0x3D,0x15,0x53,0x04,0xD7,0x1D,0xF2,0x0B,0xF3,0xE8,0x22,0x14,
+                     0xB2,0x0E,0xD7,0xDA,0xD2,0xF2,0x33,0xDC,0x3C,0x22,0xD7,0xBD,0xEE,0xED,0x8E,0x78};
+    uint8 out[32];
+    if(LIBLTE_SUCCESS != liblte_security_encryption_eea2(key, 0x398A59B4, 0x15, 1, pt, 32, out))
+        return -1;
+    if(memcmp(out, ct, 31) || (out[31] & 0xF8) != ct[31])
+        return -1;
+    return 0;
+}
+
+int eea3_test(void)
+{
+    // 128-EEA3 & 128-EIA3 Implementors' Test Data Test Set 1,
+    // LENGTH = 193 bits
+    uint8 key[16] = {0x17,0x3D,0x14,0xBA,0x50,0x03,0x73,0x1D,0x7A,0x60,0x04,0x94,0x70,0xF0,0x0A,0x29};
+    uint8 pt[25]  = {0x6C,0xF6,0x53,0x40,0x73,0x55,0x52,0xAB,0x0C,0x97,0x52,0xFA,0x6F,0x90,0x25,0xFE,
+                     0x0B,0xD6,0x75,0xD9,0x00,0x58,0x75,0xB2,0x00};
+    uint8 ct[25]  = {0xA6,0xC8,0x5F,0xC6,0x6A,0xFB,0x85,0x33,0xAA,0xFC,0x25,0x18,0xDF,0xE7,0x84,0x94,
+                     0x0E,0xE1,0xE4,0xB0,0x30,0x23,0x8C,0xC8,0x00};
+    uint8 out[25];
+    if(LIBLTE_SUCCESS != liblte_security_encryption_eea3(key, 0x66035492, 0x0F, 0, pt, 25, out))
+        return -1;
+    if(memcmp(out, ct, 24) || (out[24] & 0x80) != ct[24])
+        return -1;
+    return 0;
+}
+
+int eia1_test(void)
+{
+    // 33.401 v10.0.0 Annex C.3 Test Set 1
+    uint8 key[16] = {0x2B,0xD6,0x45,0x9F,0x82,0xC5,0xB3,0x00,0x95,0x2C,0x49,0x10,0x48,0x81,0xFF,0x48};
+    uint8 msg[11] = {0x33,0x32,0x34,0x62,0x63,0x39,0x38,0x61,0x37,0x34,0x79};
+    uint8 mac[4];
+    if(LIBLTE_SUCCESS != liblte_security_128_eia1(key, 0x38A6F056, 0x1F, 0, msg, 11, mac))
+        return -1;
+    if(mac[0] != 0x73 || mac[1] != 0x1F || mac[2] != 0x11 || mac[3] != 0x65)
+        return -1;
+    return 0;
+}
+
+int eia3_test(void)
+{
+    // 128-EEA3 & 128-EIA3 Implementors' Test Data Test Sets 1 and 2
+    uint8 key_1[16] = {0};
+    uint8 key_2[16] = {0x47,0x05,0x41,0x25,0x56,0x1E,0xB2,0xDD,0xA9,0x40,0x59,0xDA,0x05,0x09,0x78,0x50};
+    LIBLTE_BIT_MSG_STRUCT msg;
+    uint8 mac[4];
+    msg.N_bits = 1;
+    msg.msg[0] = 0;
+    if(LIBLTE_SUCCESS != liblte_security_128_eia3(key_1, 0, 0, 0, &msg, mac))
+        return -1;
+    if(mac[0] != 0xC8 || mac[1] != 0xA9 || mac[2] != 0x59 || mac[3] != 0x5E)
+        return -1;
+    msg.N_bits = 90;
+    memset(msg.msg, 0, msg.N_bits);
+    if(LIBLTE_SUCCESS != liblte_security_128_eia3(key_2, 0x561EB2DD, 0x14, 0, &msg, mac))
+        return -1;
+    if(mac[0] != 0x67 || mac[1] != 0x19 || mac[2] != 0xA0 || mac[3] != 0x88)
+        return -1;
+    return 0;
+}
+
+int encryption_batch_test(void)
+{
+    uint8 key[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+    uint32 lens[6] = {0, 1, 15, 16, 40, 1500};
+    uint8 msg[6][1500];
+    uint8 out[6][1500];
+    uint8 ref[1500];
+    LIBLTE_SECURITY_CIPHER_JOB_STRUCT jobs[6];
+    for(uint32 alg=LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_EEA0; alg<LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_N_ITEMS; alg++)
+    {
+        for(uint32 i=0; i<6; i++)
+        {
+            for(uint32 j=0; j<lens[i]; j++)
+                msg[i][j] = i + j;
+            jobs[i].msg       = msg[i];
+            jobs[i].out       = out[i];
+            jobs[i].msg_len   = lens[i];
+            jobs[i].count     = 1000 + i;
+            jobs[i].bearer    = i;
+            jobs[i].direction = i % 2;
+        }
+        if(LIBLTE_SUCCESS != liblte_security_encryption_batch((LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_ENUM)alg, key, jobs, 6))
+            return -1;
+        for(uint32 i=0; i<6; i++)
+        {
+            // Each message must match its own single-shot result
+            if(LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_EEA0 == alg)
+                memcpy(ref, msg[i], lens[i]);
+            else if(LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA1 == alg)
+                liblte_security_encryption_eea1(key, 1000 + i, i, i % 2, msg[i], lens[i], ref);
+            else if(LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA2 == alg)
+                liblte_security_encryption_eea2(key, 1000 + i, i, i % 2, msg[i], lens[i], ref);
+            else
+                liblte_security_encryption_eea3(key, 1000 + i, i, i % 2, msg[i], lens[i], ref);
+            if(memcmp(out[i], ref, lens[i]))
+                return -1;
+        }
+
+        // Deciphering in place restores the plaintext
+        for(uint32 i=0; i<6; i++)
+            jobs[i].msg = out[i];
+        if(LIBLTE_SUCCESS != liblte_security_encryption_batch((LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_ENUM)alg, key, jobs, 6))
+            return -1;
+        for(uint32 i=0; i<6; i++)
+            if(memcmp(out[i], msg[i], lens[i]))
+                return -1;
+    }
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
     printf("generate_k_asme_test: ");
@@ -366,5 +562,37 @@ int main(int argc, char *argv[])
     if(0 != milenage_f5_star_test())
         exit(-1);
     printf("pass\n");
+    printf("aes_encrypt_test: ");
+    if(0 != aes_encrypt_test())
+        exit(-1);
+    printf("pass\n");
+    printf("milenage_test_set_1_test: ");
+    if(0 != milenage_test_set_1_test())
+        exit(-1);
+    printf("pass\n");
+    printf("eea1_test: ");
+    if(0 != eea1_test())
+        exit(-1);
+    printf("pass\n");
+    printf("eea2_test: ");
+    if(0 != eea2_test())
+        exit(-1);
+    printf("pass\n");
+    printf("eea3_test: ");
+    if(0 != eea3_test())
+        exit(-1);
+    printf("pass\n");
+    printf("eia1_test: ");
+    if(0 != eia1_test())
+        exit(-1);
+    printf("pass\n");
+    printf("eia3_test: ");
+    if(0 != eia3_test())
+        exit(-1);
+    printf("pass\n");
+    printf("encryption_batch_test: ");
+    if(0 != encryption_batch_test())
+        exit(-1);
+    printf("pass\n");
     exit(0);
 }
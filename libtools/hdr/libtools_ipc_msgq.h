@@ -38,6 +38,10 @@
 
 #include "typedefs.h"
 #include "liblte_phy.h"
+#include <boost/interprocess/ipc/message_queue.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <atomic>
+#include <mutex>
 #include <string>
 #include <thread>
 
@@ -45,6 +49,14 @@
                               DEFINES
 *******************************************************************************/
 
+#define LIBTOOLS_IPC_MSGQ_MAX_N_MSGS 100
+
+// Receive timeout, bounds how long the destructor waits for the
+// receive thread
+#define LIBTOOLS_IPC_MSGQ_RX_TIMEOUT_MS 100
+
+// Sample blocks in the shared memory ring
+#define LIBTOOLS_IPC_MSGQ_N_SAMPS_SLOTS 4
 
 /*******************************************************************************
                               FORWARD DECLARATIONS
@@ -99,11 +111,20 @@ typedef struct{
     uint8   N_ant;
 }LIBTOOLS_IPC_MSGQ_PHY_SAMPS_MSG_STRUCT;
 
+// Descriptor sent in place of the samples, which stay in the shared
+// memory ring.  samps is filled in by the receiver and is only valid
+// during the callback.
+typedef struct{
+    LIBTOOLS_IPC_MSGQ_PHY_SAMPS_MSG_STRUCT *samps;
+    uint32                                  slot;
+}LIBTOOLS_IPC_MSGQ_PHY_SAMPS_DESC_MSG_STRUCT;
+
 typedef union{
-    LIBTOOLS_IPC_MSGQ_RACH_MSG_STRUCT      rach;
-    LIBTOOLS_IPC_MSGQ_MAC_PDU_MSG_STRUCT   mac_pdu_msg;
-    LIBTOOLS_IPC_MSGQ_RAR_PDU_MSG_STRUCT   rar_pdu_msg;
-    LIBTOOLS_IPC_MSGQ_UL_ALLOC_MSG_STRUCT  ul_alloc_msg;
+    LIBTOOLS_IPC_MSGQ_RACH_MSG_STRUCT           rach;
+    LIBTOOLS_IPC_MSGQ_MAC_PDU_MSG_STRUCT        mac_pdu_msg;
+    LIBTOOLS_IPC_MSGQ_RAR_PDU_MSG_STRUCT        rar_pdu_msg;
+    LIBTOOLS_IPC_MSGQ_UL_ALLOC_MSG_STRUCT       ul_alloc_msg;
+    LIBTOOLS_IPC_MSGQ_PHY_SAMPS_DESC_MSG_STRUCT phy_samps_desc_msg;
 }LIBTOOLS_IPC_MSGQ_MESSAGE_UNION;
 
 typedef struct{
@@ -111,6 +132,16 @@ typedef struct{
     LIBTOOLS_IPC_MSGQ_MESSAGE_UNION     msg;
 }LIBTOOLS_IPC_MSGQ_MESSAGE_STRUCT;
 
+// Single producer single consumer ring of sample blocks in shared
+// memory, indexes only increase
+typedef struct{
+    std::atomic<uint32>                    write_idx;
+    uint8                                  producer_pad[60];
+    std::atomic<uint32>                    read_idx;
+    uint8                                  consumer_pad[60];
+    LIBTOOLS_IPC_MSGQ_PHY_SAMPS_MSG_STRUCT slot[LIBTOOLS_IPC_MSGQ_N_SAMPS_SLOTS];
+}LIBTOOLS_IPC_MSGQ_SAMPS_RING_STRUCT;
+
 /*******************************************************************************
                               CLASS DECLARATIONS
 *******************************************************************************/
@@ -143,14 +174,23 @@ public:
 
     // Send/Receive
     void send(LIBTOOLS_IPC_MSGQ_MESSAGE_TYPE_ENUM type, LIBTOOLS_IPC_MSGQ_MESSAGE_UNION *msg_content, uint32 msg_content_size);
+    bool send_samps(LIBTOOLS_IPC_MSGQ_PHY_SAMPS_MSG_STRUCT *samps);
 private:
     // Send/Receive
     static void receive_thread(libtools_ipc_msgq *msgq);
 
+    // Samples
+    LIBTOOLS_IPC_MSGQ_SAMPS_RING_STRUCT* get_samps_ring();
+    std::once_flag                         samps_once;
+    boost::interprocess::mapped_region    *samps_region;
+    LIBTOOLS_IPC_MSGQ_SAMPS_RING_STRUCT   *samps_ring;
+
     // Variables
-    libtools_ipc_msgq_cb *callback;
-    std::string           msgq_name;
-    std::thread          *rx_thread;
+    boost::interprocess::message_queue *mq;
+    libtools_ipc_msgq_cb               *callback;
+    std::string                         msgq_name;
+    std::thread                        *rx_thread;
+    std::atomic<bool>                   rx_run;
 };
 
 #endif /* __LIBTOOLS_IPC_MSGQ_H__ */
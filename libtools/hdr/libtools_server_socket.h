@@ -37,14 +37,21 @@
 *******************************************************************************/
 
 #include "typedefs.h"
+#include <atomic>
 #include <mutex>
 #include <thread>
 #include <map>
+#include <string>
+#include <string_view>
 
 /*******************************************************************************
                               DEFINES
 *******************************************************************************/
 
+#define LIBTOOLS_SERVER_SOCKET_LISTEN_BACKLOG           8
+#define LIBTOOLS_SERVER_SOCKET_MAX_EVENTS               32
+#define LIBTOOLS_SERVER_SOCKET_RX_BUF_SIZE              4096
+#define LIBTOOLS_SERVER_SOCKET_DEFAULT_HIGH_WATER_MARK  (1024*1024)
 
 /*******************************************************************************
                               FORWARD DECLARATIONS
@@ -61,13 +68,38 @@ typedef enum{
     LIBTOOLS_SERVER_SOCKET_ERROR_SOCKET,
     LIBTOOLS_SERVER_SOCKET_ERROR_PTHREAD,
     LIBTOOLS_SERVER_SOCKET_ERROR_WRITE_FAIL,
+    LIBTOOLS_SERVER_SOCKET_ERROR_OVERFLOW,
     LIBTOOLS_SERVER_SOCKET_ERROR_N_ITEMS,
 }LIBTOOLS_SERVER_SOCKET_ERROR_ENUM;
 static const char libtools_server_socket_error_text[LIBTOOLS_SERVER_SOCKET_ERROR_N_ITEMS][20] = {"None",
                                                                                                  "Invalid Inputs",
                                                                                                  "Socket",
                                                                                                  "PThread",
-                                                                                                 "Write Fail"};
+                                                                                                 "Write Fail",
+                                                                                                 "Overflow"};
+
+// What send does with a client whose pending output would pass the
+// high water mark
+typedef enum{
+    LIBTOOLS_SERVER_SOCKET_SLOW_CLIENT_DROP = 0,
+    LIBTOOLS_SERVER_SOCKET_SLOW_CLIENT_DISCONNECT,
+    LIBTOOLS_SERVER_SOCKET_SLOW_CLIENT_N_ITEMS,
+}LIBTOOLS_SERVER_SOCKET_SLOW_CLIENT_ENUM;
+static const char libtools_server_socket_slow_client_text[LIBTOOLS_SERVER_SOCKET_SLOW_CLIENT_N_ITEMS][20] = {"drop",
+                                                                                                             "disconnect"};
+
+// Output is written straight to the socket while nothing is pending,
+// anything the socket won't take is queued in out_buf and flushed by
+// the receive thread in one write per wakeup
+typedef struct{
+    std::string out_buf;
+    size_t      out_offset;
+    uint64      N_dropped;
+    char        in_buf[LIBTOOLS_SERVER_SOCKET_RX_BUF_SIZE];
+    uint32      in_len;
+    bool        closing;
+}LIBTOOLS_SERVER_SOCKET_CLIENT_STRUCT;
+
 /*******************************************************************************
                               CLASS DECLARATIONS
 *******************************************************************************/
@@ -75,11 +107,11 @@ static const char libtools_server_socket_error_text[LIBTOOLS_SERVER_SOCKET_ERROR
 class libtools_server_socket_receive_callback
 {
 public:
-    template<class C, void (C::*Func)(const std::string, const int32)>
-        static void wrapper(void *o, const std::string msg, const int32 sock_fd) {return (static_cast<C*>(o)->*Func)(msg, sock_fd);}
-    typedef void (*FuncType)(void*, const std::string, const int32);
+    template<class C, void (C::*Func)(std::string_view, const int32)>
+        static void wrapper(void *o, std::string_view msg, const int32 sock_fd) {return (static_cast<C*>(o)->*Func)(msg, sock_fd);}
+    typedef void (*FuncType)(void*, std::string_view, const int32);
     libtools_server_socket_receive_callback(FuncType f, void *o) : func{f}, obj{o} {};
-    void operator()(const std::string msg, const int32 sock_fd) { return (*func)(obj, msg, sock_fd); };
+    void operator()(std::string_view msg, const int32 sock_fd) { return (*func)(obj, msg, sock_fd); };
 private:
     FuncType  func;
     void     *obj;
@@ -111,6 +143,9 @@ private:
     void     *obj;
 };
 
+// Messages are newline terminated lines, the receive callback gets a
+// view into the client's receive buffer that is only valid for the
+// duration of the call
 class libtools_server_socket
 {
 public:
@@ -123,21 +158,35 @@ public:
     ~libtools_server_socket();
 
     // Send
-    LIBTOOLS_SERVER_SOCKET_ERROR_ENUM send(const std::string msg, const int32 sock_fd);
+    LIBTOOLS_SERVER_SOCKET_ERROR_ENUM send(std::string_view msg, const int32 sock_fd);
+    void send_all(std::string_view msg);
+    void set_slow_client_policy(const uint32 high_water_mark, const LIBTOOLS_SERVER_SOCKET_SLOW_CLIENT_ENUM policy);
 private:
+    // Send
+    LIBTOOLS_SERVER_SOCKET_ERROR_ENUM queue_msg(LIBTOOLS_SERVER_SOCKET_CLIENT_STRUCT *client, const int32 sock_fd, std::string_view msg);
+    void flush(const int32 sock_fd);
+
     // Receive
     static void rx_thread(libtools_server_socket *server_socket);
+    void accept_clients();
+    void receive(const int32 sock_fd);
+    void disconnect(const int32 sock_fd);
 
     // Variables
-    libtools_server_socket_receive_callback             receive_cb;
-    libtools_server_socket_connect_disconnect_callback  connect_cb;
-    libtools_server_socket_connect_disconnect_callback  disconnect_cb;
-    libtools_server_socket_error_callback               error_cb;
-    std::thread                                        *socket_thread;
-    std::mutex                                          socket_mutex;
-    std::map<int32, std::mutex*>                        client_mutex;
-    int32                                               sock;
-    uint16                                              port;
+    libtools_server_socket_receive_callback                receive_cb;
+    libtools_server_socket_connect_disconnect_callback     connect_cb;
+    libtools_server_socket_connect_disconnect_callback     disconnect_cb;
+    libtools_server_socket_error_callback                  error_cb;
+    std::thread                                           *socket_thread;
+    std::atomic<bool>                                      thread_run;
+    std::mutex                                             client_mutex;
+    std::map<int32, LIBTOOLS_SERVER_SOCKET_CLIENT_STRUCT*> clients;
+    LIBTOOLS_SERVER_SOCKET_SLOW_CLIENT_ENUM                slow_client_policy;
+    uint32                                                 high_water_mark;
+    int32                                                  sock;
+    int32                                                  epoll_fd;
+    int32                                                  wake_fd;
+    uint16                                                 port;
 };
 
 #endif /* __LIBTOOLS_SERVER_SOCKET_H__ */
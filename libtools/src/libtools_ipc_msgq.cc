@@ -34,7 +34,8 @@
 *******************************************************************************/
 
 #include "libtools_ipc_msgq.h"
-#include <boost/interprocess/ipc/message_queue.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 
 /*******************************************************************************
                               DEFINES
@@ -76,22 +77,46 @@ void libtools_ipc_msgq_cb::operator()(LIBTOOLS_IPC_MSGQ_MESSAGE_STRUCT *msg)
 /********************************/
 libtools_ipc_msgq::libtools_ipc_msgq(std::string          _msgq_name,
                                      libtools_ipc_msgq_cb cb) :
-    callback{new libtools_ipc_msgq_cb(cb)}, msgq_name{_msgq_name}
+    samps_region{NULL}, samps_ring{NULL}, callback{new libtools_ipc_msgq_cb(cb)},
+    msgq_name{_msgq_name}, rx_run{true}
 {
+    mq        = new boost::interprocess::message_queue(boost::interprocess::open_or_create,
+                                                       msgq_name.c_str(),
+                                                       LIBTOOLS_IPC_MSGQ_MAX_N_MSGS,
+                                                       sizeof(LIBTOOLS_IPC_MSGQ_MESSAGE_STRUCT));
+
+    // The receiver owns the sample ring, drop any left by a previous run
+    boost::interprocess::shared_memory_object::remove((msgq_name + "_samps").c_str());
     rx_thread = new std::thread(receive_thread, this);
 }
 libtools_ipc_msgq::libtools_ipc_msgq(std::string _msgq_name) :
-    callback{NULL}, msgq_name{_msgq_name}
+    samps_region{NULL}, samps_ring{NULL}, callback{NULL}, msgq_name{_msgq_name},
+    rx_thread{NULL}, rx_run{false}
 {
-    rx_thread = new std::thread(receive_thread, this);
+    mq = new boost::interprocess::message_queue(boost::interprocess::open_or_create,
+                                                msgq_name.c_str(),
+                                                LIBTOOLS_IPC_MSGQ_MAX_N_MSGS,
+                                                sizeof(LIBTOOLS_IPC_MSGQ_MESSAGE_STRUCT));
 }
 libtools_ipc_msgq::~libtools_ipc_msgq()
 {
-    send(LIBTOOLS_IPC_MSGQ_MESSAGE_TYPE_KILL, NULL, 0);
+    if(NULL == rx_thread)
+    {
+        // Send only, tell the peer
+        send(LIBTOOLS_IPC_MSGQ_MESSAGE_TYPE_KILL, NULL, 0);
+    }else{
+        // Cleanup thread
+        rx_run = false;
+        rx_thread->join();
+        delete rx_thread;
+
+        // Existing mappings stay valid until unmapped
+        boost::interprocess::shared_memory_object::remove((msgq_name + "_samps").c_str());
+    }
 
-    // Cleanup thread
-    rx_thread->join();
-    delete rx_thread;
+    delete samps_region;
+    delete mq;
+    delete callback;
 }
 
 /**********************/
@@ -101,51 +126,118 @@ void libtools_ipc_msgq::send(LIBTOOLS_IPC_MSGQ_MESSAGE_TYPE_ENUM  type,
                              LIBTOOLS_IPC_MSGQ_MESSAGE_UNION     *msg_content,
                              uint32                               msg_content_size)
 {
-    LIBTOOLS_IPC_MSGQ_MESSAGE_STRUCT   msg;
-    boost::interprocess::message_queue mq(boost::interprocess::open_only,
-                                          msgq_name.c_str());
+    LIBTOOLS_IPC_MSGQ_MESSAGE_STRUCT msg;
 
     msg.type = type;
     if(msg_content != NULL)
-        memcpy(&msg.msg, msg_content, msg_content_size);
+        memcpy(&msg.msg, msg_content, std::min(msg_content_size, (uint32)sizeof(msg.msg)));
+
+    mq->try_send(&msg, sizeof(LIBTOOLS_IPC_MSGQ_MESSAGE_STRUCT), 0);
+}
+bool libtools_ipc_msgq::send_samps(LIBTOOLS_IPC_MSGQ_PHY_SAMPS_MSG_STRUCT *samps)
+{
+    LIBTOOLS_IPC_MSGQ_SAMPS_RING_STRUCT *ring = get_samps_ring();
+    LIBTOOLS_IPC_MSGQ_MESSAGE_STRUCT     msg;
+    uint32                               idx;
+
+    // Drop the block if the receiver is behind
+    idx = ring->write_idx.load(std::memory_order_relaxed);
+    if(idx - ring->read_idx.load(std::memory_order_acquire) >= LIBTOOLS_IPC_MSGQ_N_SAMPS_SLOTS)
+        return false;
+
+    // Copy only the samples in use
+    LIBTOOLS_IPC_MSGQ_PHY_SAMPS_MSG_STRUCT *slot = &ring->slot[idx % LIBTOOLS_IPC_MSGQ_N_SAMPS_SLOTS];
+    for(uint32 i=0; i<samps->N_ant; i++)
+        memcpy(slot->samps[i], samps->samps[i], samps->N_samps_per_ant*sizeof(complex));
+    slot->N_samps_per_ant = samps->N_samps_per_ant;
+    slot->current_tti     = samps->current_tti;
+    slot->N_ant           = samps->N_ant;
+    ring->write_idx.store(idx + 1, std::memory_order_release);
+
+    // Send the descriptor, giving the slot back if the queue is full
+    msg.type                             = LIBTOOLS_IPC_MSGQ_MESSAGE_TYPE_PHY_SAMPS;
+    msg.msg.phy_samps_desc_msg.samps     = NULL;
+    msg.msg.phy_samps_desc_msg.slot      = idx % LIBTOOLS_IPC_MSGQ_N_SAMPS_SLOTS;
+    if(!mq->try_send(&msg, sizeof(LIBTOOLS_IPC_MSGQ_MESSAGE_STRUCT), 0))
+    {
+        ring->write_idx.store(idx, std::memory_order_relaxed);
+        return false;
+    }
 
-    mq.try_send(&msg, sizeof(LIBTOOLS_IPC_MSGQ_MESSAGE_STRUCT), 0);
+    return true;
 }
 void libtools_ipc_msgq::receive_thread(libtools_ipc_msgq *msgq)
 {
     LIBTOOLS_IPC_MSGQ_MESSAGE_STRUCT msg;
     std::size_t                      rx_size;
     uint32                           prio;
-    bool                             not_done = true;
-
-    // Open the message_queue
-    boost::interprocess::message_queue mq(boost::interprocess::open_or_create,
-                                          msgq->msgq_name.c_str(),
-                                          100,
-                                          sizeof(LIBTOOLS_IPC_MSGQ_MESSAGE_STRUCT));
-
-    if(msgq->callback == NULL)
-        return;
 
-    while(not_done)
+    while(msgq->rx_run)
     {
-        // FIXME: SET A TIMEOUT
-
         // Wait for a message
-        mq.receive(&msg, sizeof(msg), rx_size, prio);
+        if(!msgq->mq->timed_receive(&msg,
+                                    sizeof(msg),
+                                    rx_size,
+                                    prio,
+                                    boost::posix_time::microsec_clock::universal_time() +
+                                    boost::posix_time::milliseconds(LIBTOOLS_IPC_MSGQ_RX_TIMEOUT_MS)))
+            continue;
 
         // Process message
         if(sizeof(msg) == rx_size)
         {
-            (*msgq->callback)(&msg);
+            if(LIBTOOLS_IPC_MSGQ_MESSAGE_TYPE_PHY_SAMPS == msg.type)
+            {
+                // Point at the samples and free the slot once handled
+                LIBTOOLS_IPC_MSGQ_SAMPS_RING_STRUCT *ring = msgq->get_samps_ring();
+                msg.msg.phy_samps_desc_msg.samps = &ring->slot[msg.msg.phy_samps_desc_msg.slot % LIBTOOLS_IPC_MSGQ_N_SAMPS_SLOTS];
+                (*msgq->callback)(&msg);
+                ring->read_idx.store(ring->read_idx.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            }else{
+                (*msgq->callback)(&msg);
+            }
 
             if(LIBTOOLS_IPC_MSGQ_MESSAGE_TYPE_KILL == msg.type)
-                not_done = false;
-        }else{
-            // FIXME
-            printf("ERROR %s Invalid message size received: %u\n",
-                   msgq->msgq_name.c_str(),
-                   (uint32)rx_size);
+                break;
         }
     }
 }
+
+/*****************/
+/*    Samples    */
+/*****************/
+LIBTOOLS_IPC_MSGQ_SAMPS_RING_STRUCT* libtools_ipc_msgq::get_samps_ring()
+{
+    // Mapped on first use, most queues never carry samples
+    std::call_once(samps_once, [this](){
+        boost::interprocess::shared_memory_object shm;
+        bool                                      created = true;
+
+        try
+        {
+            boost::interprocess::shared_memory_object tmp(boost::interprocess::create_only,
+                                                          (msgq_name + "_samps").c_str(),
+                                                          boost::interprocess::read_write);
+            tmp.truncate(sizeof(LIBTOOLS_IPC_MSGQ_SAMPS_RING_STRUCT));
+            shm.swap(tmp);
+        }catch(boost::interprocess::interprocess_exception &){
+            boost::interprocess::shared_memory_object tmp(boost::interprocess::open_only,
+                                                          (msgq_name + "_samps").c_str(),
+                                                          boost::interprocess::read_write);
+            tmp.truncate(sizeof(LIBTOOLS_IPC_MSGQ_SAMPS_RING_STRUCT));
+            shm.swap(tmp);
+            created = false;
+        }
+        samps_region = new boost::interprocess::mapped_region(shm, boost::interprocess::read_write);
+        samps_ring   = (LIBTOOLS_IPC_MSGQ_SAMPS_RING_STRUCT *)samps_region->get_address();
+
+        // Only the creator starts the indexes, the peer may already be using them
+        if(created)
+        {
+            samps_ring->write_idx.store(0, std::memory_order_relaxed);
+            samps_ring->read_idx.store(0, std::memory_order_release);
+        }
+    });
+
+    return samps_ring;
+}
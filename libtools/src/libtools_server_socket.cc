@@ -35,9 +35,13 @@
 
 #include "libtools_server_socket.h"
 #include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <algorithm>
 #include <unistd.h>
 #include <string.h>
-#include <limits.h>
+#include <stdio.h>
+#include <errno.h>
 
 /*******************************************************************************
                               DEFINES
@@ -66,11 +70,12 @@ libtools_server_socket::libtools_server_socket(const uint16
                                                const libtools_server_socket_error_callback              &_error_cb,
                                                LIBTOOLS_SERVER_SOCKET_ERROR_ENUM                        &error) :
     receive_cb{_receive_cb}, connect_cb{_connect_cb}, disconnect_cb{_disconnect_cb},
-    error_cb{_error_cb}, port{_port}
+    error_cb{_error_cb}, socket_thread{NULL}, thread_run{true},
+    slow_client_policy{LIBTOOLS_SERVER_SOCKET_SLOW_CLIENT_DISCONNECT},
+    high_water_mark{LIBTOOLS_SERVER_SOCKET_DEFAULT_HIGH_WATER_MARK}, sock{-1}, epoll_fd{-1},
+    wake_fd{-1}, port{_port}
 {
-    std::lock_guard<std::mutex> lock(socket_mutex);
-
-    sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    sock = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, IPPROTO_TCP);
     if(sock < 0)
     {
         error = LIBTOOLS_SERVER_SOCKET_ERROR_SOCKET;
@@ -91,7 +96,32 @@ libtools_server_socket::libtools_server_socket(const uint16
     s_addr.sin_family      = AF_INET;
     s_addr.sin_addr.s_addr = INADDR_ANY;
     s_addr.sin_port        = htons(port);
-    if(0 != bind(sock, (struct sockaddr *)&s_addr, sizeof(s_addr)))
+    if(0 != bind(sock, (struct sockaddr *)&s_addr, sizeof(s_addr)) ||
+       0 != listen(sock, LIBTOOLS_SERVER_SOCKET_LISTEN_BACKLOG))
+    {
+        error = LIBTOOLS_SERVER_SOCKET_ERROR_SOCKET;
+        return;
+    }
+
+    // The wake fd only exists to break the receive thread out of
+    // epoll_wait on shutdown
+    struct epoll_event event;
+    epoll_fd = epoll_create1(0);
+    wake_fd  = eventfd(0, EFD_NONBLOCK);
+    if(epoll_fd < 0 || wake_fd < 0)
+    {
+        error = LIBTOOLS_SERVER_SOCKET_ERROR_SOCKET;
+        return;
+    }
+    event.events  = EPOLLIN;
+    event.data.fd = sock;
+    if(0 != epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sock, &event))
+    {
+        error = LIBTOOLS_SERVER_SOCKET_ERROR_SOCKET;
+        return;
+    }
+    event.data.fd = wake_fd;
+    if(0 != epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event))
     {
         error = LIBTOOLS_SERVER_SOCKET_ERROR_SOCKET;
         return;
@@ -103,99 +133,268 @@ libtools_server_socket::libtools_server_socket(const uint16
 }
 libtools_server_socket::~libtools_server_socket()
 {
-    std::lock_guard<std::mutex> lock(socket_mutex);
-    close(sock);
-    sleep(1);
-    socket_thread->join();
-    delete socket_thread;
+    uint64 wake = 1;
+
+    if(NULL != socket_thread)
+    {
+        thread_run = false;
+        if(sizeof(wake) != write(wake_fd, &wake, sizeof(wake)))
+            perror("libtools_server_socket wake");
+        socket_thread->join();
+        delete socket_thread;
+    }
+
+    std::lock_guard<std::mutex> lock(client_mutex);
+    for(auto client : clients)
+    {
+        close(client.first);
+        delete client.second;
+    }
+    clients.clear();
+    if(0 <= wake_fd)
+        close(wake_fd);
+    if(0 <= epoll_fd)
+        close(epoll_fd);
+    if(0 <= sock)
+        close(sock);
 }
-LIBTOOLS_SERVER_SOCKET_ERROR_ENUM libtools_server_socket::send(const std::string msg,
-                                                               const int32       sock_fd)
+
+// Send
+LIBTOOLS_SERVER_SOCKET_ERROR_ENUM libtools_server_socket::send(std::string_view msg,
+                                                               const int32      sock_fd)
 {
-    std::lock_guard<std::mutex> lock(*client_mutex[sock_fd]);
-    if((ssize_t)msg.size() != write(sock_fd, msg.c_str(), msg.size()))
+    std::lock_guard<std::mutex> lock(client_mutex);
+    auto                        client = clients.find(sock_fd);
+
+    if(clients.end() == client)
         return LIBTOOLS_SERVER_SOCKET_ERROR_WRITE_FAIL;
+    return queue_msg(client->second, sock_fd, msg);
+}
+void libtools_server_socket::send_all(std::string_view msg)
+{
+    std::lock_guard<std::mutex> lock(client_mutex);
+
+    for(auto client : clients)
+        queue_msg(client.second, client.first, msg);
+}
+void libtools_server_socket::set_slow_client_policy(const uint32                                  _high_water_mark,
+                                                    const LIBTOOLS_SERVER_SOCKET_SLOW_CLIENT_ENUM policy)
+{
+    std::lock_guard<std::mutex> lock(client_mutex);
+
+    high_water_mark    = _high_water_mark;
+    slow_client_policy = policy;
+}
+LIBTOOLS_SERVER_SOCKET_ERROR_ENUM libtools_server_socket::queue_msg(LIBTOOLS_SERVER_SOCKET_CLIENT_STRUCT *client,
+                                                                    const int32                           sock_fd,
+                                                                    std::string_view                      msg)
+{
+    struct epoll_event event;
+    ssize_t            N_bytes;
+
+    if(client->closing)
+        return LIBTOOLS_SERVER_SOCKET_ERROR_WRITE_FAIL;
+
+    if(client->out_offset == client->out_buf.size())
+    {
+        // Nothing pending, so the message can go straight out and
+        // whatever doesn't fit is queued even past the high water mark
+        // to keep the stream line aligned
+        N_bytes = ::send(sock_fd, msg.data(), msg.size(), MSG_NOSIGNAL);
+        if(N_bytes < 0)
+        {
+            if(EAGAIN != errno && EWOULDBLOCK != errno)
+                return LIBTOOLS_SERVER_SOCKET_ERROR_WRITE_FAIL;
+            N_bytes = 0;
+        }
+        if((size_t)N_bytes == msg.size())
+            return LIBTOOLS_SERVER_SOCKET_ERROR_NONE;
+        msg.remove_prefix(N_bytes);
+        client->out_buf.assign(msg);
+        client->out_offset = 0;
+        event.events       = EPOLLIN | EPOLLOUT;
+        event.data.fd      = sock_fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, sock_fd, &event);
+        return LIBTOOLS_SERVER_SOCKET_ERROR_NONE;
+    }
+
+    if(client->out_buf.size() - client->out_offset + msg.size() > high_water_mark)
+    {
+        if(LIBTOOLS_SERVER_SOCKET_SLOW_CLIENT_DISCONNECT == slow_client_policy)
+        {
+            // The receive thread sees the hangup and cleans up
+            client->closing = true;
+            shutdown(sock_fd, SHUT_RDWR);
+        }else{
+            client->N_dropped++;
+        }
+        return LIBTOOLS_SERVER_SOCKET_ERROR_OVERFLOW;
+    }
+    client->out_buf.append(msg);
     return LIBTOOLS_SERVER_SOCKET_ERROR_NONE;
 }
-void libtools_server_socket::rx_thread(libtools_server_socket *server_socket)
+void libtools_server_socket::flush(const int32 sock_fd)
 {
-    server_socket->socket_mutex.lock();
-    if(0 != listen(server_socket->sock, 1))
+    std::lock_guard<std::mutex>           lock(client_mutex);
+    auto                                  iter = clients.find(sock_fd);
+    LIBTOOLS_SERVER_SOCKET_CLIENT_STRUCT *client;
+    struct epoll_event                    event;
+    ssize_t                               N_bytes;
+
+    if(clients.end() == iter)
+        return;
+    client = iter->second;
+
+    N_bytes = ::send(sock_fd,
+                     client->out_buf.data() + client->out_offset,
+                     client->out_buf.size() - client->out_offset,
+                     MSG_NOSIGNAL);
+    if(N_bytes < 0)
     {
-        server_socket->error_cb(LIBTOOLS_SERVER_SOCKET_ERROR_SOCKET);
-        server_socket->socket_mutex.unlock();
+        if(EAGAIN != errno && EWOULDBLOCK != errno)
+        {
+            client->closing = true;
+            shutdown(sock_fd, SHUT_RDWR);
+        }
         return;
     }
-    server_socket->socket_mutex.unlock();
+    client->out_offset += N_bytes;
 
-    fd_set fds;
-    FD_ZERO(&fds);
-    FD_SET(server_socket->sock, &fds);
-    int32 fd_max = server_socket->sock;
+    if(client->out_offset == client->out_buf.size())
+    {
+        client->out_buf.clear();
+        client->out_offset = 0;
+        event.events       = EPOLLIN;
+        event.data.fd      = sock_fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, sock_fd, &event);
+    }else if(client->out_offset > client->out_buf.size()/2){
+        client->out_buf.erase(0, client->out_offset);
+        client->out_offset = 0;
+    }
+}
 
-    while(1)
+// Receive
+void libtools_server_socket::rx_thread(libtools_server_socket *server_socket)
+{
+    struct epoll_event events[LIBTOOLS_SERVER_SOCKET_MAX_EVENTS];
+    uint64             wake;
+    int32              N_events;
+
+    while(server_socket->thread_run)
     {
-        struct timeval select_timeout;
-        select_timeout.tv_sec  = 0;
-        select_timeout.tv_usec = 500000;
-        fd_set tmp_fds         = fds;
-        if(select(fd_max+1, &tmp_fds, NULL, NULL, &select_timeout) == -1)
+        N_events = epoll_wait(server_socket->epoll_fd, events, LIBTOOLS_SERVER_SOCKET_MAX_EVENTS, -1);
+        if(N_events < 0)
             continue;
 
-        for(int32 i=0; i<=fd_max; i++)
+        for(int32 i=0; i<N_events; i++)
         {
-            if(FD_ISSET(i, &tmp_fds))
+            if(server_socket->wake_fd == events[i].data.fd)
             {
-                if(i == server_socket->sock)
-                {
-                    std::lock_guard<std::mutex> lock(server_socket->socket_mutex);
-                    struct sockaddr_in c_addr;
-                    socklen_t c_addr_len = sizeof(c_addr);
-                    int32 sock_fd = accept(server_socket->sock, (struct sockaddr *)&c_addr,
-                                           &c_addr_len);
-                    if(sock_fd < 0)
-                    {
-                        server_socket->error_cb(LIBTOOLS_SERVER_SOCKET_ERROR_SOCKET);
-                        break;
-                    }
-                    FD_SET(sock_fd, &fds);
-                    if(sock_fd > fd_max)
-                        fd_max = sock_fd;
-                    server_socket->client_mutex.insert(std::make_pair(sock_fd, new std::mutex));
-                    server_socket->connect_cb(sock_fd);
-                }else{
-                    int32 sock_fd = i;
-                    server_socket->client_mutex[sock_fd]->lock();
-                    char read_buf[LINE_MAX];
-                    memset(read_buf, 0, LINE_MAX);
-                    int32 n_bytes = read(sock_fd, read_buf, LINE_MAX);
-                    server_socket->client_mutex[sock_fd]->unlock();
-
-                    if(n_bytes == -1 || n_bytes == 0)
-                    {
-                        server_socket->disconnect_cb(sock_fd);
-                        server_socket->client_mutex[sock_fd]->lock();
-                        close(sock_fd);
-                        server_socket->client_mutex[sock_fd]->unlock();
-                        delete server_socket->client_mutex[sock_fd];
-                        server_socket->client_mutex.erase(sock_fd);
-                        FD_CLR(sock_fd, &fds);
-                        break;
-                    }
-
-                    std::string msg = read_buf;
-                    while(std::string::npos != msg.find('\r'))
-                        msg.erase(msg.find('\r'), 1);
-                    while(std::string::npos != msg.find('\n'))
-                    {
-                        server_socket->receive_cb(msg.substr(0, msg.find('\n')), sock_fd);
-                        msg = msg.substr(msg.find('\n')+1, std::string::npos);
-                    }
-                }
+                if(sizeof(wake) != read(server_socket->wake_fd, &wake, sizeof(wake)))
+                    continue;
+            }else if(server_socket->sock == events[i].data.fd){
+                server_socket->accept_clients();
+            }else{
+                if(events[i].events & EPOLLOUT)
+                    server_socket->flush(events[i].data.fd);
+                if(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                    server_socket->receive(events[i].data.fd);
             }
         }
     }
-    std::lock_guard<std::mutex> lock(server_socket->socket_mutex);
-    close(server_socket->sock);
-    return;
+}
+void libtools_server_socket::accept_clients()
+{
+    struct epoll_event event;
+    int32              sock_fd;
+
+    while(1)
+    {
+        sock_fd = accept4(sock, NULL, NULL, SOCK_NONBLOCK);
+        if(sock_fd < 0)
+        {
+            if(EAGAIN != errno && EWOULDBLOCK != errno && EINTR != errno && ECONNABORTED != errno)
+                error_cb(LIBTOOLS_SERVER_SOCKET_ERROR_SOCKET);
+            return;
+        }
+
+        event.events  = EPOLLIN;
+        event.data.fd = sock_fd;
+        if(0 != epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sock_fd, &event))
+        {
+            close(sock_fd);
+            error_cb(LIBTOOLS_SERVER_SOCKET_ERROR_SOCKET);
+            return;
+        }
+
+        LIBTOOLS_SERVER_SOCKET_CLIENT_STRUCT *client = new LIBTOOLS_SERVER_SOCKET_CLIENT_STRUCT;
+        client->out_offset = 0;
+        client->N_dropped  = 0;
+        client->in_len     = 0;
+        client->closing    = false;
+        client_mutex.lock();
+        clients[sock_fd] = client;
+        client_mutex.unlock();
+        connect_cb(sock_fd);
+    }
+}
+void libtools_server_socket::receive(const int32 sock_fd)
+{
+    LIBTOOLS_SERVER_SOCKET_CLIENT_STRUCT *client;
+    char                                 *line;
+    char                                 *end;
+    char                                 *nl;
+    ssize_t                               N_bytes;
+
+    // Only this thread adds or removes clients and touches in_buf, so
+    // the lock is only needed for the lookup
+    client_mutex.lock();
+    auto iter = clients.find(sock_fd);
+    client    = (clients.end() == iter) ? NULL : iter->second;
+    client_mutex.unlock();
+    if(NULL == client)
+        return;
+
+    N_bytes = read(sock_fd,
+                   &client->in_buf[client->in_len],
+                   LIBTOOLS_SERVER_SOCKET_RX_BUF_SIZE - client->in_len);
+    if(N_bytes < 0 && (EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno))
+        return;
+    if(N_bytes <= 0)
+        return disconnect(sock_fd);
+
+    // Drop carriage returns in place and hand out each complete line
+    line = client->in_buf;
+    end  = std::remove(&client->in_buf[client->in_len], &client->in_buf[client->in_len + N_bytes], '\r');
+    while(NULL != (nl = (char *)memchr(line, '\n', end - line)))
+    {
+        receive_cb(std::string_view(line, nl - line), sock_fd);
+        line = nl + 1;
+    }
+
+    // A full buffer without a newline is passed on as one line
+    if(line == client->in_buf && end == &client->in_buf[LIBTOOLS_SERVER_SOCKET_RX_BUF_SIZE])
+    {
+        receive_cb(std::string_view(line, end - line), sock_fd);
+        line = end;
+    }
+    client->in_len = end - line;
+    memmove(client->in_buf, line, client->in_len);
+}
+void libtools_server_socket::disconnect(const int32 sock_fd)
+{
+    LIBTOOLS_SERVER_SOCKET_CLIENT_STRUCT *client = NULL;
+
+    disconnect_cb(sock_fd);
+
+    std::lock_guard<std::mutex> lock(client_mutex);
+    auto                        iter = clients.find(sock_fd);
+    if(clients.end() != iter)
+    {
+        client = iter->second;
+        clients.erase(iter);
+    }
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, sock_fd, NULL);
+    close(sock_fd);
+    delete client;
 }
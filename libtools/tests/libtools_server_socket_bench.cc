@@ -0,0 +1,186 @@
+/*******************************************************************************
+
+    Copyright 2026 agent
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************
+
+    File: libtools_server_socket_bench.cc
+
+    Description: Measures the server socket over loopback: send_all to
+                 reading clients plus one that never reads, and line
+                 reassembly on receive.
+
+    Revision History
+    ----------    -------------    --------------------------------------------
+    10/18/2026    agent            Created file.
+
+*******************************************************************************/
+
+/*******************************************************************************
+                              INCLUDES
+*******************************************************************************/
+
+#include "libtools_server_socket.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+
+/*******************************************************************************
+                              DEFINES
+*******************************************************************************/
+
+#define BENCH_PORT          31234
+#define N_READING_CLIENTS   2
+#define N_SEND_ALL          200000
+#define N_RX_LINES          200000
+#define LINE_SIZE           100
+#define SLOW_HIGH_WATER     (64*1024)
+
+/*******************************************************************************
+                              CLASS DECLARATIONS
+*******************************************************************************/
+
+class bench_server
+{
+public:
+    bench_server() : N_connected{0}, N_lines{0} {};
+    void handle_rx(std::string_view msg, const int32 sock_fd) {N_lines++;}
+    void handle_connect(const int32 sock_fd) {N_connected++;}
+    void handle_disconnect(const int32 sock_fd) {}
+    void handle_error(const LIBTOOLS_SERVER_SOCKET_ERROR_ENUM err) {printf("Server socket error %s\n", libtools_server_socket_error_text[err]);}
+
+    std::atomic<uint32> N_connected;
+    std::atomic<uint64> N_lines;
+};
+
+/*******************************************************************************
+                              FUNCTIONS
+*******************************************************************************/
+
+int32 connect_client()
+{
+    struct sockaddr_in addr;
+    int32              fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(BENCH_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(0 != connect(fd, (struct sockaddr *)&addr, sizeof(addr)))
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Reads until the server closes the connection
+void read_thread(int32 fd, uint64 *N_bytes)
+{
+    char  buf[65536];
+    int32 N;
+
+    *N_bytes = 0;
+    while(0 < (N = read(fd, buf, sizeof(buf))))
+        *N_bytes += N;
+}
+
+void wait_for(std::atomic<uint32> &val, uint32 target)
+{
+    while(val < target)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+int main(int argc, char *argv[])
+{
+    bench_server                                        server;
+    libtools_server_socket_receive_callback             rx_cb(&libtools_server_socket_receive_callback::wrapper<bench_server, &bench_server::handle_rx>, &server);
+    libtools_server_socket_connect_disconnect_callback  connect_cb(&libtools_server_socket_connect_disconnect_callback::wrapper<bench_server, &bench_server::handle_connect>, &server);
+    libtools_server_socket_connect_disconnect_callback  disconnect_cb(&libtools_server_socket_connect_disconnect_callback::wrapper<bench_server, &bench_server::handle_disconnect>, &server);
+    libtools_server_socket_error_callback               error_cb(&libtools_server_socket_error_callback::wrapper<bench_server, &bench_server::handle_error>, &server);
+    LIBTOOLS_SERVER_SOCKET_ERROR_ENUM                   err;
+    std::vector<std::thread>                            readers;
+    uint64                                              N_bytes[N_READING_CLIENTS];
+    int32                                               fd[N_READING_CLIENTS + 1];
+    std::string                                         line(LINE_SIZE, 'x');
+
+    libtools_server_socket *sock = new libtools_server_socket(BENCH_PORT, rx_cb, connect_cb, disconnect_cb, error_cb, err);
+    if(LIBTOOLS_SERVER_SOCKET_ERROR_NONE != err)
+    {
+        printf("Can't start the server socket: %s\n", libtools_server_socket_error_text[err]);
+        delete sock;
+        return -1;
+    }
+    sock->set_slow_client_policy(SLOW_HIGH_WATER, LIBTOOLS_SERVER_SOCKET_SLOW_CLIENT_DROP);
+
+    // Reading clients plus one that never reads
+    for(uint32 i=0; i<N_READING_CLIENTS + 1; i++)
+    {
+        fd[i] = connect_client();
+        if(0 > fd[i])
+        {
+            printf("Can't connect to the server socket\n");
+            delete sock;
+            return -1;
+        }
+    }
+    wait_for(server.N_connected, N_READING_CLIENTS + 1);
+    for(uint32 i=0; i<N_READING_CLIENTS; i++)
+        readers.emplace_back(read_thread, fd[i], &N_bytes[i]);
+
+    // Broadcast
+    line += "\n";
+    auto start = std::chrono::steady_clock::now();
+    for(uint32 i=0; i<N_SEND_ALL; i++)
+        sock->send_all(line);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("send_all to %u clients: %6.1f ns/call\n", N_READING_CLIENTS + 1, ns/N_SEND_ALL);
+
+    // Receive, lines written in large chunks so most reads hold
+    // several lines and some are split
+    std::string rx_chunk;
+    for(uint32 i=0; i<1000; i++)
+        rx_chunk += line;
+    start = std::chrono::steady_clock::now();
+    for(uint32 i=0; i<N_RX_LINES/1000; i++)
+        if((int32)rx_chunk.size() != write(fd[N_READING_CLIENTS], rx_chunk.data(), rx_chunk.size()))
+            printf("Short write\n");
+    while(server.N_lines < N_RX_LINES)
+        std::this_thread::yield();
+    ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("receive:                %6.1f ns/line\n", ns/N_RX_LINES);
+
+    // Closing the server ends the readers
+    delete sock;
+    for(uint32 i=0; i<N_READING_CLIENTS; i++)
+    {
+        readers[i].join();
+        printf("client %u received %llu of %llu bytes\n",
+               i,
+               (unsigned long long)N_bytes[i],
+               (unsigned long long)N_SEND_ALL*line.size());
+    }
+    for(uint32 i=0; i<N_READING_CLIENTS + 1; i++)
+        close(fd[i]);
+}